@@ -21,6 +21,7 @@
 */
 
 #include "clientsettings.h"
+#include "archivetiering.h"
 #include "opportunityfiltersettings.h"
 
 #include <algorithm>
@@ -239,6 +240,30 @@ OpportunityFilterSettings ClientSettings::filterSettings() const
     return settings;
 }
 
+void ClientSettings::setArchiveTiering(const ArchiveTiering &tiering)
+{
+    m_settings->setValue(QStringLiteral("archiveTieringEnabled"), tiering.isEnabled());
+    m_settings->setValue(QStringLiteral("archiveCutoffMonths"), tiering.cutoffMonths());
+}
+
+ArchiveTiering ClientSettings::archiveTiering() const
+{
+    ArchiveTiering tiering;
+    tiering.setEnabled(m_settings->value(QStringLiteral("archiveTieringEnabled"), false).toBool());
+    tiering.setCutoffMonths(m_settings->value(QStringLiteral("archiveCutoffMonths"), 24).toInt());
+    return tiering;
+}
+
+void ClientSettings::setHistoryMemoryBudget(qint64 bytes)
+{
+    m_settings->setValue(QStringLiteral("historyMemoryBudgetMB"), bytes / (1024 * 1024));
+}
+
+qint64 ClientSettings::historyMemoryBudget() const
+{
+    return m_settings->value(QStringLiteral("historyMemoryBudgetMB"), 0).toLongLong() * 1024 * 1024;
+}
+
 void ClientSettings::saveSearch(const OpportunityFilterSettings &settings, QString prefix)
 {
     const QVector<QString> savedSearches = self()->savedSearches();
@@ -32,6 +32,7 @@
 
 class QSettings;
 class OpportunityFilterSettings;
+class ArchiveTiering;
 
 /**
  * Settings for the FatCRM client application.
@@ -63,6 +64,14 @@ public:
     void setFilterSettings(const OpportunityFilterSettings &settings);
     OpportunityFilterSettings filterSettings() const;
 
+    // Which opportunities, notes and emails are left out of the startup load
+    void setArchiveTiering(const ArchiveTiering &tiering);
+    ArchiveTiering archiveTiering() const;
+
+    // Memory budget for the note and email bodies, in bytes (0: no limit)
+    void setHistoryMemoryBudget(qint64 bytes);
+    qint64 historyMemoryBudget() const;
+
     void saveSearch(const OpportunityFilterSettings &settings, QString searchName);
     void loadSavedSearch(OpportunityFilterSettings &settings, const QString &prefix);
 
@@ -0,0 +1,235 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config-fatcrm-version.h>
+#include "clientsettings.h"
+#include "itemexporter.h"
+#include "itemstreemodel.h"
+#include "opportunityfiltersettings.h"
+#include "kdcrmtrace.h"
+
+#include <KAboutData>
+#include <KLocalizedString>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDate>
+#include <QFile>
+#include <QTextStream>
+
+#include <stdio.h> // for stdout
+
+static const char description[] = I18N_NOOP("Export FatCRM data from the Akonadi cache, without starting the GUI");
+static const char version[] = FATCRM_EXTENDED_VERSION;
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    KLocalizedString::setApplicationDomain("fatcrm");
+
+    KAboutData aboutData(QStringLiteral("fatcrm-export"), i18n("FatCRM Export"),
+                     version, i18n(description),
+                     KAboutLicense::GPL_V2, i18n("(C) 2021 KDAB"),
+                     QString(), QStringLiteral("info@kdab.com"));
+    KAboutData::setApplicationData(aboutData);
+
+    QCommandLineParser parser;
+    QCommandLineOption resourceOption("resource", i18n("Akonadi resource to export from (default: the one last used in FatCRM)"), "identifier");
+    parser.addOption(resourceOption);
+    QCommandLineOption typeOption("type", i18n("Type of items, either 'Accounts', 'Opportunities', 'Contacts', 'Leads' or 'Campaigns'"), "type", "Opportunities");
+    parser.addOption(typeOption);
+    QCommandLineOption formatOption("format", i18n("Output format, either 'csv' or 'json'"), "format", "csv");
+    parser.addOption(formatOption);
+    QCommandLineOption outputOption("output", i18n("Write to <fileName> instead of stdout"), "fileName");
+    parser.addOption(outputOption);
+    QCommandLineOption columnsOption("columns", i18n("Comma-separated list of columns, e.g. OpportunityName,SalesStage (default: the initially visible columns, except the NumberOf... ones, which cannot be exported)"), "columns");
+    parser.addOption(columnsOption);
+    // Opportunity filters, same as in the opportunities page
+    QCommandLineOption savedSearchOption("saved-search", i18n("Filter opportunities like the saved search <name>; the options below override it"), "name");
+    parser.addOption(savedSearchOption);
+    QCommandLineOption assigneeOption("assignee", i18n("Only opportunities assigned to <name> (can be repeated)"), "name");
+    parser.addOption(assigneeOption);
+    QCommandLineOption countryOption("country", i18n("Only opportunities with an account in <country> (can be repeated)"), "country");
+    parser.addOption(countryOption);
+    QCommandLineOption statusOption("status", i18n("Comma-separated list of 'open', 'won' and 'lost' (default: open)"), "status");
+    parser.addOption(statusOption);
+    QCommandLineOption maxNextStepDateOption("max-next-step-date", i18n("Only opportunities with a next step date until <date> (YYYY-MM-DD)"), "date");
+    parser.addOption(maxNextStepDateOption);
+    QCommandLineOption modifiedAfterOption("modified-after", i18n("Only opportunities modified after <date> (YYYY-MM-DD)"), "date");
+    parser.addOption(modifiedAfterOption);
+    QCommandLineOption modifiedBeforeOption("modified-before", i18n("Only opportunities modified before <date> (YYYY-MM-DD)"), "date");
+    parser.addOption(modifiedBeforeOption);
+    QCommandLineOption priorityOption("priority", i18n("Only opportunities with priority 'A', 'B', 'C' or 'Not set'"), "priority");
+    parser.addOption(priorityOption);
+    QCommandLineOption searchOption("search", i18n("Only opportunities containing <text>, like the search field"), "text");
+    parser.addOption(searchOption);
+    QCommandLineOption traceOption("trace", i18n("Write a Chrome/Perfetto trace of the export to <fileName>"), "fileName");
+    parser.addOption(traceOption);
+    aboutData.setupCommandLine(&parser);
+    parser.process(app);
+    aboutData.processCommandLine(&parser);
+
+    QTextStream qerr(stderr);
+
+    // Sets date to the value of a date option, or to an invalid date if not set. Returns false on errors.
+    auto readDate = [&parser, &qerr](const QCommandLineOption &option, QDate &date) {
+        date = QDate();
+        if (!parser.isSet(option))
+            return true;
+        date = QDate::fromString(parser.value(option), Qt::ISODate);
+        if (!date.isValid()) {
+            qerr << "Error: Invalid date: " << parser.value(option) << endl;
+            return false;
+        }
+        return true;
+    };
+
+    if (parser.isSet(traceOption)) {
+        if (!KDCRMTrace::setOutputFile(parser.value(traceOption))) {
+            return 1;
+        }
+    }
+
+    const QString typeStr = parser.value(typeOption);
+    const DetailsType type = stringToType(typeStr);
+    if (typeToString(type) != typeStr) {
+        qerr << "Error: Unknown type: " << typeStr << endl;
+        return 1;
+    }
+
+    const QByteArray resource = parser.isSet(resourceOption) ? parser.value(resourceOption).toLatin1()
+                                                             : ClientSettings::self()->defaultResourceId().toLatin1();
+    if (resource.isEmpty()) {
+        qerr << "Error: No resource specified, and none used in FatCRM yet" << endl;
+        return 1;
+    }
+
+    ItemExporter exporter;
+    exporter.setResource(resource);
+    exporter.setType(type);
+
+    const QString format = parser.value(formatOption);
+    if (format == QLatin1String("json")) {
+        exporter.setFormat(ItemExporter::Json);
+    } else if (format != QLatin1String("csv")) {
+        qerr << "Error: Unknown format: " << format << endl;
+        return 1;
+    }
+
+    if (parser.isSet(columnsOption)) {
+        const ItemsTreeModel::ColumnTypes available = ItemsTreeModel::columnTypes(type);
+        ItemsTreeModel::ColumnTypes columns;
+        const QStringList names = parser.value(columnsOption).split(',', QString::SkipEmptyParts);
+        for (const QString &name : names) {
+            const auto column = ItemsTreeModel::columnTypeFromName(name.trimmed());
+            if (!available.contains(column)) {
+                qerr << "Error: No column " << name << " for " << typeStr << endl;
+                return 1;
+            }
+            if (!ItemExporter::isExportable(column)) {
+                qerr << "Error: Column " << name << " cannot be exported, it needs the linked documents, notes and emails" << endl;
+                return 1;
+            }
+            columns.append(column);
+        }
+        exporter.setColumns(columns);
+    }
+
+    OpportunityFilterSettings filter;
+    if (parser.isSet(savedSearchOption)) {
+        const QString searchName = parser.value(savedSearchOption);
+        const QString prefix = ClientSettings::self()->searchPrefixFromName(searchName);
+        if (prefix.isEmpty()) {
+            qerr << "Error: No saved search named " << searchName << endl;
+            return 1;
+        }
+        ClientSettings::self()->loadSavedSearch(filter, prefix);
+        // the GUI computes the date from the combobox, relative to today
+        filter.setMaxDate(OpportunityFilterSettings::maxDateForIndex(filter.maxDateIndex(), filter.customMaxDate()), filter.maxDateIndex());
+    }
+    if (filter.shownPriority().isEmpty()) {
+        filter.setShownPriority(QStringLiteral("-")); // the "any" entry of the priority combobox
+    }
+    if (parser.isSet(assigneeOption)) {
+        filter.setAssignees(parser.values(assigneeOption), QString());
+    }
+    if (parser.isSet(countryOption)) {
+        filter.setCountries(parser.values(countryOption), QString());
+    }
+    if (parser.isSet(statusOption)) {
+        const QStringList statuses = parser.value(statusOption).split(',', QString::SkipEmptyParts);
+        for (const QString &status : statuses) {
+            if (status != QLatin1String("open") && status != QLatin1String("won") && status != QLatin1String("lost")) {
+                qerr << "Error: Unknown status: " << status << endl;
+                return 1;
+            }
+        }
+        filter.setShowOpenClosed(statuses.contains(QStringLiteral("open")), statuses.contains(QStringLiteral("won")), statuses.contains(QStringLiteral("lost")));
+    }
+    QDate date;
+    if (!readDate(modifiedAfterOption, date))
+        return 1;
+    if (date.isValid())
+        filter.setModifiedAfter(date);
+    if (!readDate(modifiedBeforeOption, date))
+        return 1;
+    if (date.isValid())
+        filter.setModifiedBefore(date);
+    if (!readDate(maxNextStepDateOption, date))
+        return 1;
+    if (date.isValid()) {
+        filter.setCustomMaxDate(date);
+        filter.setMaxDate(date, CustomDate);
+    }
+    if (parser.isSet(priorityOption)) {
+        filter.setShownPriority(parser.value(priorityOption));
+    }
+    if (parser.isSet(searchOption)) {
+        filter.setSearchText(parser.value(searchOption));
+    }
+    exporter.setOpportunityFilter(filter);
+
+    QFile output;
+    bool opened;
+    if (parser.isSet(outputOption)) {
+        output.setFileName(parser.value(outputOption));
+        opened = output.open(QIODevice::WriteOnly);
+    } else {
+        opened = output.open(stdout, QIODevice::WriteOnly);
+    }
+    if (!opened) {
+        qerr << "Error: Cannot open " << parser.value(outputOption) << " for writing: " << output.errorString() << endl;
+        return 1;
+    }
+    exporter.setDevice(&output);
+
+    QObject::connect(&exporter, &ItemExporter::finished, &app, [&](bool success, const QString &errorMessage) {
+        output.flush();
+        if (!success) {
+            qerr << "Error: " << errorMessage << endl;
+            app.exit(1);
+            return;
+        }
+        qerr << "Exported " << exporter.exportedCount() << " " << typeToTranslatedString(type) << endl;
+        app.exit(0);
+    });
+    exporter.start();
+
+    return app.exec();
+}
@@ -24,6 +24,7 @@
 #include <config-fatcrm-version.h>
 #include "clientsettings.h"
 #include "kdcrmutils.h"
+#include "kdcrmtrace.h"
 
 #include <KAboutData>
 #include <KDBusService>
@@ -67,10 +68,18 @@ int main(int argc, char **argv)
     parser.addOption(configKeyOption);
     QCommandLineOption configValueOption("set-config-value", i18n("Internal feature: Set the value for setting specified by 'config-key' parameter"), "value");
     parser.addOption(configValueOption);
+    QCommandLineOption traceOption("trace", i18n("Write a Chrome/Perfetto trace of the loading and processing to <fileName>"), "fileName");
+    parser.addOption(traceOption);
     aboutData.setupCommandLine(&parser);
     parser.process(app);
     aboutData.processCommandLine(&parser);
 
+    if (parser.isSet(traceOption)) {
+        if (!KDCRMTrace::setOutputFile(parser.value(traceOption))) {
+            return 1;
+        }
+    }
+
     if (parser.isSet(configKeyOption)) {
         QTextStream qout(stdout);
         QTextStream qerr(stderr);
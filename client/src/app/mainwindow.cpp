@@ -29,6 +29,7 @@
 
 #include "aboutdialog.h"
 #include "accountrepository.h"
+#include "archivetiering.h"
 #include "clientsettings.h"
 #include "collectionmanager.h"
 #include "configurationdialog.h"
@@ -38,16 +39,22 @@
 #include "dbuswinidprovider.h"
 #include "enums.h"
 #include "loadingoverlay.h"
+#include "memoryreport.h"
+#include "modelrepository.h"
 #include "config-fatcrm-version.h"
 #include "linkeditemsrepository.h"
+#include "quickopendialog.h"
+#include "quickopenindex.h"
 #include "referenceddata.h"
 #include "reportpage.h"
 #include "resourceconfigdialog.h"
+#include "savedsearchindex.h"
 #include "fatcrm_client_debug.h"
 #include "searchesdialog.h"
 #include "itemstreemodel.h"
 
 #include "kdcrmdata/enumdefinitionattribute.h"
+#include "kdcrmdata/syncbaseattribute.h"
 
 #include <KDReportsReport.h>
 #include <KDReportsPreviewDialog.h>
@@ -74,6 +81,7 @@ using namespace Akonadi;
 #include <QInputDialog>
 #include <QMessageBox>
 #include <QProgressBar>
+#include <QStandardPaths>
 #include <QTimer>
 #include <QToolBar>
 
@@ -83,6 +91,7 @@ MainWindow::MainWindow(bool displayOverlay, bool showGDPR)
       mProgressBarHideTimer(nullptr),
       mCollectionManager(new CollectionManager(this)),
       mLinkedItemsRepository(new LinkedItemsRepository(mCollectionManager, this)),
+      mQuickOpenIndex(new QuickOpenIndex(this)),
       mContactsModel(nullptr),
       mInitialLoadingDone(false),
       mDisplayOverlay(displayOverlay)
@@ -101,6 +110,8 @@ MainWindow::MainWindow(bool displayOverlay, bool showGDPR)
 
     auto *iface = new DBusInvokerInterface(this);
     connect(iface, &DBusInvokerInterface::importCsvFileRequested, this, &MainWindow::slotTryImportCsvFile);
+    iface->setMemoryReportProvider([this]() { return memoryReport(); });
+    iface->setHistorySearchProvider([this](const QString &query, int maxHits) { return searchHistory(query, maxHits); });
 
     ClientSettings::self()->restoreWindowSize(QStringLiteral("main"), this);
 
@@ -166,6 +177,7 @@ void MainWindow::slotDelayedInit()
             this, &MainWindow::slotResourceProgress);
 
     Akonadi::AttributeFactory::registerAttribute<EnumDefinitionAttribute>();
+    Akonadi::AttributeFactory::registerAttribute<SyncBaseAttribute>();
 }
 
 void MainWindow::slotAboutKDAB()
@@ -208,6 +220,7 @@ void MainWindow::slotAboutApp()
                       "<li><a href=\"https://github.com/KDAB/FatCRM/issues\">Issue Tracker</a></li>"
                       "<li><a href=\"https://github.com/KDAB/FatCRM/graphs/contributors\">Contributors</a></li>"
                       "</ul><p>Patches welcome!</p></qt>").arg(FATCRM_EXTENDED_VERSION));
+    dialog.setDetails(memoryReport());
     dialog.setLogo(QStringLiteral(":/images/fatcrmlogo.png"));
     dialog.setWindowIcon(QIcon::fromTheme(QStringLiteral("fatcrm")));
     dialog.adjustSize();
@@ -215,6 +228,34 @@ void MainWindow::slotAboutApp()
 }
 
 
+QString MainWindow::memoryReport() const
+{
+    MemoryReport report;
+    for (int type = 0; type <= MaxType; ++type) {
+        if (ItemsTreeModel *model = ModelRepository::instance()->model(DetailsType(type))) {
+            model->addToMemoryReport(report);
+        }
+    }
+    mLinkedItemsRepository->addToMemoryReport(report);
+    AccountRepository::instance()->addToMemoryReport(report);
+    ReferencedData::addAllToMemoryReport(report);
+    return report.toString();
+}
+
+// "<module>\t<id>\t<parent module>\t<parent id>\t<score>", best hits first
+QStringList MainWindow::searchHistory(const QString &query, int maxHits) const
+{
+    static const char *const s_kindModules[] = { "Notes", "Emails", "Documents" };
+    const QVector<FullTextIndex::Hit> hits = mLinkedItemsRepository->search(query, maxHits);
+    QStringList lines;
+    lines.reserve(hits.count());
+    for (const FullTextIndex::Hit &hit : hits) {
+        lines.append(QStringLiteral("%1\t%2\t%3\t%4\t%5").arg(QString::fromLatin1(s_kindModules[hit.kind]), hit.id,
+                                                             hit.parentType, hit.parentId, QString::number(hit.score)));
+    }
+    return lines;
+}
+
 void MainWindow::initialize(bool displayOverlay, bool showGDPR)
 {
     Q_INIT_RESOURCE(resources);
@@ -286,6 +327,7 @@ void MainWindow::createActions()
     populateSavedSearchesMenu();
     connect(ClientSettings::self(), &ClientSettings::recentSearchesUpdated, this, &MainWindow::populateSavedSearchesMenu);
     connect(mSavedSearchesMenu, &QMenu::triggered, this, &MainWindow::slotLoadSearchFromRecent);
+    connect(mSavedSearchesMenu, &QMenu::aboutToShow, this, &MainWindow::slotUpdateSavedSearchCounts);
 
     mMainToolBar = addToolBar(i18n("Main ToolBar"));
     mResourceSelector = new QComboBox(this);
@@ -326,6 +368,11 @@ void MainWindow::setupActions()
     connect(activatePreviousTabAction, &QAction::triggered, this, &MainWindow::slotActivatePreviousTab);
     addAction(activatePreviousTabAction);
 
+    auto *quickOpenAction = new QAction(i18n("Quick Open..."), this);
+    quickOpenAction->setShortcut(Qt::CTRL + Qt::Key_K);
+    connect(quickOpenAction, &QAction::triggered, this, &MainWindow::slotQuickOpen);
+    addAction(quickOpenAction);
+
     Q_FOREACH (const Page *page, mPages) {
         connect(page, &Page::statusMessage,
                 this, &MainWindow::slotShowMessage);
@@ -339,6 +386,13 @@ void MainWindow::setupActions()
     }
 }
 
+// Stored next to Akonadi's own data, one file per resource
+static QString fullTextIndexFile(const QByteArray &resourceIdentifier)
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation)
+            + QLatin1String("/fatcrm/fulltextindex-") + QString::fromLatin1(resourceIdentifier);
+}
+
 void MainWindow::slotResourceSelectionChanged(int index)
 {
     if (mDisplayOverlay) {
@@ -359,6 +413,9 @@ void MainWindow::slotResourceSelectionChanged(int index)
         ReferencedData::clearAll();
         AccountRepository::instance()->clear();
         mLinkedItemsRepository->clear();
+        mLinkedItemsRepository->setFullTextIndexFile(fullTextIndexFile(identifier));
+        mLinkedItemsRepository->setArchiveTiering(ClientSettings::self()->archiveTiering());
+        mLinkedItemsRepository->setHistoryMemoryBudget(ClientSettings::self()->historyMemoryBudget());
         mCollectionManager->setResource(identifier);
         slotShowMessage(i18n("(0/6) Listing folders..."));
     } else {
@@ -506,6 +563,9 @@ void MainWindow::addPage(Page *page)
 {
     page->setCollectionManager(mCollectionManager);
     page->setLinkedItemsRepository(mLinkedItemsRepository);
+    connect(page, &Page::modelCreated, this, [this, page](ItemsTreeModel *model) {
+        mQuickOpenIndex->addModel(page->detailsType(), model);
+    });
     mPages << page;
 }
 
@@ -669,7 +729,9 @@ void MainWindow::slotImportContacts()
 void MainWindow::slotConfigure()
 {
     ConfigurationDialog dlg;
-    dlg.exec();
+    if (dlg.exec() == QDialog::Accepted && mLinkedItemsRepository) {
+        mLinkedItemsRepository->setHistoryMemoryBudget(ClientSettings::self()->historyMemoryBudget());
+    }
 }
 
 void MainWindow::slotPrintReport()
@@ -780,9 +842,23 @@ void MainWindow::slotImportCsvFile(const QString &filePath)
     }
 }
 
+void MainWindow::slotQuickOpen()
+{
+    QuickOpenDialog dlg(mQuickOpenIndex, this);
+    if (dlg.exec() == QDialog::Rejected) {
+        return;
+    }
+
+    Page *page = pageForType(dlg.selectedType());
+    if (page) {
+        mUi->tabWidget->setCurrentWidget(page);
+    }
+    slotOpenObject(dlg.selectedType(), dlg.selectedId());
+}
+
 void MainWindow::slotOpenSearchesDialog()
 {
-    SearchesDialog dlg;
+    SearchesDialog dlg(mOpportunitiesPage->savedSearchIndex());
     dlg.setWindowTitle(i18n("Load Saved Search"));
     if (dlg.exec() == QDialog::Rejected) {
         return;
@@ -908,6 +984,7 @@ void MainWindow::populateSavedSearchesMenu()
     for (int x = 0; x < count; ++x) {
         const QString &searchName = recentSearches.at(x);
         auto *searchAlternative = new QAction(searchName, this);
+        searchAlternative->setData(searchName); // the text also shows the number of matches
         mSavedSearchesMenu->addAction(searchAlternative);
     }
 
@@ -931,10 +1008,28 @@ void MainWindow::populateSavedSearchesMenu()
     connect(manageSearches, &QAction::triggered, this, &MainWindow::slotOpenSearchesDialog);
 }
 
+void MainWindow::slotUpdateSavedSearchCounts()
+{
+    const SavedSearchIndex *savedSearchIndex = mOpportunitiesPage ? mOpportunitiesPage->savedSearchIndex() : nullptr;
+    const QList<QAction *> actions = mSavedSearchesMenu->actions();
+    for (QAction *action : actions) {
+        const QString searchName = action->data().toString();
+        if (searchName.isEmpty()) {
+            continue;
+        }
+        const int count = savedSearchIndex ? savedSearchIndex->count(searchName) : -1;
+        if (count < 0) {
+            action->setText(searchName);
+        } else {
+            action->setText(i18nc("saved search name (number of matching opportunities)", "%1 (%2)", searchName, count));
+        }
+    }
+}
+
 void MainWindow::slotLoadSearchFromRecent(QAction *searchAction)
 {
     const QStringList recentSearches = ClientSettings::self()->recentlyUsedSearches();
-    const QString selectedSearchName = searchAction->iconText();
+    const QString selectedSearchName = searchAction->data().toString();
     auto it = std::find(recentSearches.begin(),
                         recentSearches.end(),
                         selectedSearchName);
@@ -40,6 +40,7 @@ class QToolBar;
 class ResourceConfigDialog;
 class CollectionManager;
 class LinkedItemsRepository;
+class QuickOpenIndex;
 class Page;
 class ReportPage;
 class LoadingOverlay;
@@ -112,11 +113,13 @@ private Q_SLOTS:
     void slotHideOverlay();
     void slotOpenSearchesDialog();
     void populateSavedSearchesMenu();
+    void slotUpdateSavedSearchCounts();
     void slotLoadSearchFromRecent(QAction *searchAction);
     void slotSaveSearch();
     void slotSaveSearchAs();
     void slotActivateNextTab();
     void slotActivatePreviousTab();
+    void slotQuickOpen();
 
 private:
     void initialize(bool displayOverlay, bool showGDPR);
@@ -134,6 +137,8 @@ private:
     void showResourceDialog();
     int resourceIndexFor(const QString &id) const;
     void raiseMainWindowAndDialog(QWidget *dialog);
+    QString memoryReport() const;
+    QStringList searchHistory(const QString &query, int maxHits) const;
 
     Ui_MainWindow *mUi = nullptr;
 
@@ -152,6 +157,7 @@ private:
     ResourceConfigDialog *mResourceDialog = nullptr;
     CollectionManager *mCollectionManager = nullptr;
     LinkedItemsRepository *mLinkedItemsRepository = nullptr;
+    QuickOpenIndex *mQuickOpenIndex = nullptr;
 
     AccountsPage *mAccountPage = nullptr;
     ContactsPage *mContactsPage = nullptr;
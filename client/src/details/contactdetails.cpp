@@ -23,6 +23,7 @@
 #include "contactdetails.h"
 
 #include "accountrepository.h"
+#include "completionvocabulary.h"
 #include "contactdataextractor.h"
 #include "editcalendarbutton.h"
 #include "itemstreemodel.h"
@@ -496,20 +497,11 @@ void ContactDetails::slotOtherAddressCountryEditingFinished()
 
 void ContactDetails::setItemsTreeModel(ItemsTreeModel *model)
 {
-    QStringList titleList;
-    titleList.reserve(2500);
-    for (int row = 0; row < model->rowCount(); ++row) {
-        const QModelIndex index = model->index(row, 0);
-        const Akonadi::Item item = index.data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>();
-        const KContacts::Addressee addressee = item.payload<KContacts::Addressee>();
-        const QString addresseeTitle = addressee.title();
-        if (!addresseeTitle.isEmpty() && !titleList.contains(addresseeTitle))
-            titleList.append(addresseeTitle);
-    }
-
-    QCompleter *titlesCompleter = new QCompleter(titleList, this);
-    titlesCompleter->setCaseSensitivity(Qt::CaseInsensitive);
-    mUi->title->setCompleter(titlesCompleter);
+    // Shared between all contact details widgets, and kept up to date by the model's signals
+    CompletionVocabulary *titles = CompletionVocabulary::forModel(model, QStringLiteral("title"), [](const Akonadi::Item &item) {
+        return item.hasPayload<KContacts::Addressee>() ? item.payload<KContacts::Addressee>().title() : QString();
+    });
+    mUi->title->setCompleter(titles->createCompleter(this));
     Details::setItemsTreeModel(model);
 }
 
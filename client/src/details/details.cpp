@@ -203,7 +203,7 @@ void Details::setResourceIdentifier(const QByteArray &ident, const QString &base
     mResourceBaseUrl = baseUrl;
 }
 
-void Details::setSupportedFields(const QStringList &fields)
+void Details::setSupportedFields(const SupportedFields &fields)
 {
     mKeys = fields;
     Q_ASSERT(mKeys.contains("id"));
@@ -217,9 +217,15 @@ void Details::setEnumDefinitions(const EnumDefinitions &enums)
 void Details::setCollectionManager(CollectionManager *collectionManager)
 {
     Akonadi::Collection::Id coll = collectionManager->collectionIdForType(mType);
-    qCDebug(FATCRM_CLIENT_LOG) << typeToString(mType) << coll << collectionManager->supportedFields(coll);
+    qCDebug(FATCRM_CLIENT_LOG) << typeToString(mType) << coll << collectionManager->supportedFields(coll).toStringList();
     setSupportedFields(collectionManager->supportedFields(coll));
     setEnumDefinitions(collectionManager->enumDefinitions(coll));
+    // e.g. after the resource was updated and synchronized again
+    connect(collectionManager, &CollectionManager::supportedFieldsChanged, this, [this, collectionManager, coll](Akonadi::Collection::Id changedColl) {
+        if (changedColl == coll) {
+            setSupportedFields(collectionManager->supportedFields(coll));
+        }
+    });
 }
 
 /*
@@ -239,7 +245,7 @@ void Details::setData(const QMap<QString, QString> &data,
     setProperty("name", data.value(QStringLiteral("name"))); // displayed in lineedit, but useful for subclasses (e.g. NotesDialog title)
 
     if (mKeys.isEmpty()) {
-        mKeys = data.keys(); // remember what are the expected keys, so getData can skip internal widgets
+        mKeys = SupportedFields(data.keys()); // remember what are the expected keys, so getData can skip internal widgets
         Q_ASSERT(mKeys.contains("id"));
     }
 
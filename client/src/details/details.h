@@ -24,6 +24,8 @@
 #define DETAILS_H
 
 #include "enums.h"
+#include "fatcrmprivate_export.h"
+#include "supportedfields.h"
 
 #include "kdcrmdata/enumdefinitions.h"
 
@@ -39,7 +41,7 @@ class LinkedItemsRepository;
 class ItemDataExtractor;
 class ItemsTreeModel;
 
-class Details : public QWidget
+class FATCRMPRIVATE_EXPORT Details : public QWidget
 {
     Q_OBJECT
 
@@ -56,7 +58,7 @@ public:
     void clear();
 
     void setResourceIdentifier(const QByteArray &ident, const QString &baseUrl);
-    void setSupportedFields(const QStringList &fields);
+    void setSupportedFields(const SupportedFields &fields);
     void setEnumDefinitions(const EnumDefinitions &enums);
     void setCollectionManager(CollectionManager *collectionManager);
     virtual void setLinkedItemsRepository(LinkedItemsRepository *repo) { Q_UNUSED(repo); }
@@ -99,7 +101,7 @@ private:
     const DetailsType mType;
     QByteArray mResourceIdentifier;
     QString mResourceBaseUrl;
-    QStringList mKeys;
+    SupportedFields mKeys;
     EnumDefinitions mEnumDefinitions;
 };
 
@@ -24,6 +24,7 @@
 
 #include "ui_opportunitydetails.h"
 #include "clientsettings.h"
+#include "completionvocabulary.h"
 #include "documentswindow.h"
 #include "enums.h"
 #include "itemstreemodel.h"
@@ -324,20 +325,11 @@ void OpportunityDetails::slotAccountSelected(const QString &accountId)
 
 void OpportunityDetails::setItemsTreeModel(ItemsTreeModel *model)
 {
-    QStringList nextStepList;
-    nextStepList.reserve(2500);
-    for (int row = 0; row < model->rowCount(); ++row) {
-        const QModelIndex index = model->index(row, 0);
-        const Akonadi::Item item = index.data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>();
-        const SugarOpportunity opportunity = item.payload<SugarOpportunity>();
-        const QString nextStep = opportunity.nextStep();
-        if (!nextStep.isEmpty() && !nextStepList.contains(nextStep))
-            nextStepList.append(nextStep);
-    }
-
-    QCompleter *nextStepCompleter = new QCompleter(nextStepList, this);
-    nextStepCompleter->setCaseSensitivity(Qt::CaseInsensitive);
-    mUi->next_step->setCompleter(nextStepCompleter);
+    // Shared between all opportunity details widgets, and kept up to date by the model's signals
+    CompletionVocabulary *nextSteps = CompletionVocabulary::forModel(model, QStringLiteral("next_step"), [](const Akonadi::Item &item) {
+        return item.hasPayload<SugarOpportunity>() ? item.payload<SugarOpportunity>().nextStep() : QString();
+    });
+    mUi->next_step->setCompleter(nextSteps->createCompleter(this));
     Details::setItemsTreeModel(model);
 }
 
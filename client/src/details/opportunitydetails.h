@@ -35,7 +35,7 @@ class OpportunityDetails;
 class LinkedItemsRepository;
 class OpportunityDataExtractor;
 
-class OpportunityDetails : public Details
+class FATCRMPRIVATE_EXPORT OpportunityDetails : public Details
 {
     Q_OBJECT
 public:
@@ -23,11 +23,15 @@
 #include "aboutdialog.h"
 #include "ui_aboutdialog.h"
 
+#include <QFontDatabase>
+
 AboutDialog::AboutDialog(QWidget* parent)
     : QDialog(parent)
     , ui(new Ui::AboutDialog)
 {
     ui->setupUi(this);
+    ui->detailsEdit->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    ui->detailsEdit->hide();
 }
 
 AboutDialog::~AboutDialog() {}
@@ -42,6 +46,12 @@ void AboutDialog::setText(const QString& text)
     ui->textLabel->setText(text);
 }
 
+void AboutDialog::setDetails(const QString& details)
+{
+    ui->detailsEdit->setPlainText(details);
+    ui->detailsEdit->setVisible(!details.isEmpty());
+}
+
 void AboutDialog::setLogo(const QString& iconFileName)
 {
     QPixmap pixmap(iconFileName);
@@ -37,6 +37,8 @@ public:
 
     void setTitle(const QString& title);
     void setText(const QString& text);
+    // Plain text shown below, e.g. the memory report
+    void setDetails(const QString& details);
     void setLogo(const QString& iconFileName);
 
 private:
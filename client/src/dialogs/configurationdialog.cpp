@@ -21,6 +21,7 @@
 */
 
 #include "configurationdialog.h"
+#include "archivetiering.h"
 #include "editlistdialog.h"
 #include "clientsettings.h"
 #include "ui_configurationdialog.h"
@@ -75,6 +76,12 @@ ConfigurationDialog::ConfigurationDialog(QWidget *parent) :
         addCountryItem(groupName);
     }
     ui->cbShowToolTips->setChecked(settings->showToolTips());
+    const ArchiveTiering tiering = settings->archiveTiering();
+    ui->cbArchiveTiering->setChecked(tiering.isEnabled());
+    ui->sbArchiveCutoffMonths->setValue(tiering.cutoffMonths());
+    ui->sbArchiveCutoffMonths->setEnabled(tiering.isEnabled());
+    connect(ui->cbArchiveTiering, &QAbstractButton::toggled, ui->sbArchiveCutoffMonths, &QWidget::setEnabled);
+    ui->sbHistoryMemoryBudget->setValue(int(settings->historyMemoryBudget() / (1024 * 1024)));
 
     ClientSettings::self()->restoreWindowSize("configurationdialog", this);
 }
@@ -119,6 +126,11 @@ void ConfigurationDialog::accept()
     settings->setAssigneeFilters(assigneeFilters());
     settings->setCountryFilters(countryFilters());
     settings->setShowToolTips(ui->cbShowToolTips->isChecked());
+    ArchiveTiering tiering;
+    tiering.setEnabled(ui->cbArchiveTiering->isChecked());
+    tiering.setCutoffMonths(ui->sbArchiveCutoffMonths->value());
+    settings->setArchiveTiering(tiering);
+    settings->setHistoryMemoryBudget(qint64(ui->sbHistoryMemoryBudget->value()) * 1024 * 1024);
     settings->sync();
     QDialog::accept();
 }
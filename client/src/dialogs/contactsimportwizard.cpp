@@ -22,6 +22,7 @@
 
 #include "accountimportpage.h"
 #include "contactsimportpage.h"
+#include "kdcrmutils.h"
 #include "kjobprogresstracker.h"
 
 #include <AkonadiCore/ItemCreateJob>
@@ -109,7 +110,10 @@ void ContactsImportWizard::importItems(const QVector<Akonadi::Item> &items)
             const QString errorMessage = i18n("Unable to update contact %1:", contact.realName());
             tracker->addJob(job, errorMessage);
         } else {
-            auto *job = new Akonadi::ItemCreateJob(item, mContactsCollection, this);
+            // Lets the resource create the imported contacts on the server in batches
+            Akonadi::Item newItem(item);
+            newItem.setFlag(KDCRMUtils::importFlag());
+            auto *job = new Akonadi::ItemCreateJob(newItem, mContactsCollection, this);
 
             const QString errorMessage = i18n("Unable to create contact %1:", contact.realName());
             if (mContactsImportPage->openContactsAfterImport()) {
@@ -27,6 +27,8 @@
 #include "kdcrmutils.h"
 #include "linkeditemsrepository.h"
 #include "sugarresourceitemtransfer.h"
+#include "timelinedelegate.h"
+#include "timelinemodel.h"
 #include "fatcrm_client_debug.h"
 
 #include <AkonadiCore/ItemDeleteJob>
@@ -38,11 +40,11 @@
 
 #include <QComboBox>
 #include <QFileDialog>
+#include <QItemSelectionModel>
 #include <QLabel>
 #include <QMimeType>
 #include <QMessageBox>
 #include <QPlainTextEdit>
-#include <QScrollBar>
 
 DocumentWidget::DocumentWidget(EnumDefinitions *definitions, QWidget *parent)
     : QWidget(parent),
@@ -56,15 +58,6 @@ DocumentWidget::DocumentWidget(EnumDefinitions *definitions, QWidget *parent)
 
     mNameLabel->setOpenExternalLinks(false);
 
-    const int enumIndex = mEnumDefinitions->indexOf("status_id");
-    if (enumIndex != -1) {
-        const EnumDefinitions::Enum &def = mEnumDefinitions->at(enumIndex);
-        for (auto it = def.mEnumValues.constBegin();
-             it != def.mEnumValues.constEnd(); ++it) {
-            mStatusBox->addItem(it->value, it->key);
-        }
-    }
-
     mDeleteButton->setIcon(QIcon::fromTheme(QStringLiteral("list-remove")));
     mDeleteButton->setText(i18n("Delete"));
     horizontalLine->setFrameShape(QFrame::HLine);
@@ -89,6 +82,18 @@ void DocumentWidget::setDocument(const SugarDocument &document)
 {
     mDocument = document;
 
+    // The widget is created before the window gets the enum definitions
+    if (mStatusBox->count() == 0) {
+        const int enumIndex = mEnumDefinitions->indexOf("status_id");
+        if (enumIndex != -1) {
+            const EnumDefinitions::Enum &def = mEnumDefinitions->at(enumIndex);
+            for (auto it = def.mEnumValues.constBegin();
+                 it != def.mEnumValues.constEnd(); ++it) {
+                mStatusBox->addItem(it->value, it->key);
+            }
+        }
+    }
+
     mNameLabel->setText(QString::fromLatin1("<a href=\"document:///%1\">%2</a> (date modified: %3)").arg(
         mDocument.documentRevisionId(),
         mDocument.documentName().toHtmlEscaped(),
@@ -139,11 +144,23 @@ bool DocumentWidget::isModified() const
 
 DocumentsWindow::DocumentsWindow(QWidget *parent)
     : QWidget(parent),
+      mTimelineModel(new TimelineModel(this)),
       ui(new Ui::DocumentsWindow)
 {
     ui->setupUi(this);
     ClientSettings::self()->restoreWindowSize("DocumentsWindow", this);
 
+    ui->documentsView->setModel(mTimelineModel);
+    ui->documentsView->setItemDelegate(new TimelineDelegate(ui->documentsView));
+    connect(ui->documentsView->selectionModel(), &QItemSelectionModel::currentChanged, this, &DocumentsWindow::slotCurrentChanged);
+    connect(ui->documentsView, &QAbstractItemView::doubleClicked, this, &DocumentsWindow::slotDoubleClicked);
+
+    mEditor = new DocumentWidget(&mEnumDefinitions, this);
+    mEditor->hide();
+    ui->verticalLayout->insertWidget(ui->verticalLayout->indexOf(ui->documentsView) + 1, mEditor);
+    connect(mEditor, &DocumentWidget::urlClicked, this, &DocumentsWindow::urlClicked);
+    connect(mEditor, &DocumentWidget::deleteDocument, this, &DocumentsWindow::deleteDocument);
+
     setAcceptDrops(true);
 
     connect(ui->attachButton, SIGNAL(clicked()), SLOT(attachDocument()));
@@ -167,7 +184,7 @@ void DocumentsWindow::setLinkedItemsRepository(LinkedItemsRepository *repository
     const auto collection = mLinkedItemsRepository->documentsCollection();
     auto *enumsAttr = collection.attribute<EnumDefinitionAttribute>();
     if (enumsAttr)
-        mEnumDefinitions = EnumDefinitions::fromString(enumsAttr->value());
+        mEnumDefinitions = enumsAttr->enumDefinitions();
 }
 
 void DocumentsWindow::loadDocumentsFor(const QString &id, LinkedItemType itemType)
@@ -187,9 +204,15 @@ void DocumentsWindow::loadDocumentsFor(const QString &id, LinkedItemType itemTyp
         break;
     }
 
-    foreach (const SugarDocument &document, documents) {
-        addDocument(document);
+    QVector<TimelineEntry> entries;
+    entries.reserve(documents.count());
+    for (const SugarDocument &document : qAsConst(documents)) {
+        mDocuments.insert(document.id(), document);
+        mCurrentDocuments.insert(document.id(), document);
+        entries.append(entryForDocument(document));
     }
+    mTimelineModel->setEntries(entries);
+    ui->documentsView->setCurrentIndex(mTimelineModel->index(0, 0));
 }
 
 void DocumentsWindow::closeEvent(QCloseEvent *event)
@@ -240,19 +263,22 @@ void DocumentsWindow::urlClicked(const QString &url)
 
 void DocumentsWindow::deleteDocument()
 {
-    auto *widget = qobject_cast<DocumentWidget*>(sender());
-    if (!widget)
+    const QString id = mEditedDocumentId;
+    if (id.isEmpty())
         return;
 
-    const int answer = QMessageBox::question(this, i18n("Delete Document?"), i18n("Do you really want to delete the document %1?", widget->document().documentName()),
+    const int answer = QMessageBox::question(this, i18n("Delete Document?"), i18n("Do you really want to delete the document %1?", currentDocument(id).documentName()),
                                              QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
     if (answer == QMessageBox::No)
         return;
 
-    // Remove the document from the view (mDocumentWidgets). Keep in mDocuments so that saveChanges() sees it and triggers deletion.
-    mDocumentWidgets.remove(mDocumentWidgets.indexOf(widget));
-
-    widget->deleteLater();
+    // Remove the document from the view (mCurrentDocuments). Keep in mDocuments so that saveChanges() sees it and triggers deletion.
+    mEditedDocumentId.clear();
+    mCurrentDocuments.remove(id);
+    mNewDocumentFilePaths.remove(id);
+    mTimelineModel->removeEntry(mTimelineModel->rowForId(id));
+    if (mTimelineModel->rowCount() == 0)
+        mEditor->hide();
 }
 
 void DocumentsWindow::attachDocument()
@@ -280,9 +306,35 @@ void DocumentsWindow::attachDocument(const QString &filePath)
     SugarDocument document;
     document.setId(QString::fromLatin1("__temp%1").arg(tempDocumentCounter));
     document.setDocumentName(fileInfo.fileName());
+    document.setDateModified(QDateTime::currentDateTime()); // at the top of the list
+
+    mDocuments.insert(document.id(), document);
+    mCurrentDocuments.insert(document.id(), document);
+    mNewDocumentFilePaths.insert(document.id(), filePath);
+    const int row = mTimelineModel->insertEntry(entryForDocument(document));
+    ui->documentsView->setCurrentIndex(mTimelineModel->index(row, 0));
+}
 
-    DocumentWidget *widget = addDocument(document);
-    widget->setNewDocumentFilePath(filePath);
+void DocumentsWindow::slotCurrentChanged(const QModelIndex &current)
+{
+    commitEditor();
+    if (!current.isValid()) {
+        mEditedDocumentId.clear();
+        mEditor->hide();
+        return;
+    }
+    const QString id = current.data(TimelineModel::IdRole).toString();
+    mEditor->setDocument(mCurrentDocuments.value(id));
+    mEditor->setNewDocumentFilePath(mNewDocumentFilePaths.value(id));
+    mEditedDocumentId = id;
+    mEditor->show();
+}
+
+void DocumentsWindow::slotDoubleClicked(const QModelIndex &index)
+{
+    const SugarDocument document = currentDocument(index.data(TimelineModel::IdRole).toString());
+    if (!document.documentRevisionId().isEmpty())
+        ExternalOpen::openSugarDocument(document.documentRevisionId(), mResourceIdentifier, this);
 }
 
 void DocumentsWindow::slotJobResult(KJob *job)
@@ -298,24 +350,56 @@ void DocumentsWindow::slotJobResult(KJob *job)
     }
 }
 
-DocumentWidget *DocumentsWindow::addDocument(const SugarDocument &document)
+TimelineEntry DocumentsWindow::entryForDocument(const SugarDocument &document) const
 {
-    mDocuments.append(document);
-
-    auto *widget = new DocumentWidget(&mEnumDefinitions);
-    widget->setDocument(document);
-    mDocumentWidgets.append(widget);
+    QString status = document.statusId();
+    const int enumIndex = mEnumDefinitions.indexOf("status_id");
+    if (enumIndex != -1) {
+        const QString value = mEnumDefinitions.at(enumIndex).value(status);
+        if (!value.isEmpty())
+            status = value;
+    }
+    TimelineEntry entry;
+    entry.id = document.id();
+    entry.date = document.dateModified();
+    entry.htmlHeader = QString::fromLatin1("<h3>%1</h3>\n<p>%2 (date modified: %3)</p>\n").arg(
+        document.documentName().toHtmlEscaped(),
+        status.toHtmlEscaped(),
+        KDCRMUtils::formatDateTime(document.dateModified()));
+    entry.text = document.description();
+    return entry;
+}
 
-    connect(widget, &DocumentWidget::urlClicked, this, &DocumentsWindow::urlClicked);
-    connect(widget, &DocumentWidget::deleteDocument, this, &DocumentsWindow::deleteDocument);
+// Stores the changes made in the editor, and shows them in the list
+void DocumentsWindow::commitEditor()
+{
+    if (mEditedDocumentId.isEmpty())
+        return;
+    const SugarDocument document = mEditor->modifiedDocument();
+    const SugarDocument committed = mCurrentDocuments.value(mEditedDocumentId);
+    if (document.statusId() == committed.statusId() && document.description() == committed.description())
+        return;
+    mCurrentDocuments.insert(mEditedDocumentId, document);
+    const int row = mTimelineModel->rowForId(mEditedDocumentId);
+    if (row != -1)
+        mTimelineModel->updateEntry(row, entryForDocument(document));
+}
 
-    if (ui->scrollAreaLayout->count() > 1) // remove the stretch item at the end
-        ui->scrollAreaLayout->removeItem(ui->scrollAreaLayout->itemAt(ui->scrollAreaLayout->count() - 1));
+// Includes the uncommitted changes made in the editor
+SugarDocument DocumentsWindow::currentDocument(const QString &id) const
+{
+    if (!id.isEmpty() && id == mEditedDocumentId)
+        return mEditor->modifiedDocument();
+    return mCurrentDocuments.value(id);
+}
 
-    ui->scrollAreaLayout->addWidget(widget);
-    ui->scrollAreaLayout->addStretch();
+bool DocumentsWindow::isModified(const SugarDocument &document) const
+{
+    if (document.id().startsWith(QLatin1String("__temp")))
+        return true;
 
-    return widget;
+    const SugarDocument original = mDocuments.value(document.id());
+    return document.statusId() != original.statusId() || document.description() != original.description();
 }
 
 bool DocumentsWindow::isModified() const
@@ -323,11 +407,11 @@ bool DocumentsWindow::isModified() const
     if (mIsNotModifiedOverride)
         return false;
 
-    if (mDocuments.count() != mDocumentWidgets.count())
+    if (mDocuments.count() != mCurrentDocuments.count())
         return true;
 
-    foreach (DocumentWidget *widget, mDocumentWidgets) {
-        if (widget->isModified())
+    for (auto it = mCurrentDocuments.constBegin(); it != mCurrentDocuments.constEnd(); ++it) {
+        if (isModified(currentDocument(it.key())))
             return true;
     }
 
@@ -337,11 +421,10 @@ bool DocumentsWindow::isModified() const
 void DocumentsWindow::saveChanges()
 {
     int errors = 0;
-    foreach (const SugarDocument &oldDocument, mDocuments) {
-        const QString id = oldDocument.id();
+    for (auto docIt = mDocuments.constBegin(); docIt != mDocuments.constEnd(); ++docIt) {
+        const QString id = docIt.key();
 
-        auto it = std::find_if(mDocumentWidgets.constBegin(), mDocumentWidgets.constEnd(), [&id](DocumentWidget *widget) { return widget->document().id() == id; });
-        if (it == mDocumentWidgets.constEnd()) {
+        if (!mCurrentDocuments.contains(id)) {
             const Akonadi::Item item = mLinkedItemsRepository->documentItem(id);
             if (item.isValid()) {
                 auto *job = new Akonadi::ItemDeleteJob(item, this);
@@ -355,16 +438,17 @@ void DocumentsWindow::saveChanges()
     const auto service = Akonadi::ServerManager::agentServiceName(Akonadi::ServerManager::Resource,
                                                                   mResourceIdentifier);
     bool docsCreated = false;
-    foreach (DocumentWidget *widget, mDocumentWidgets) {
-        if (widget->isModified()) {
-            const SugarDocument document = widget->document();
-            const SugarDocument modifiedDocument = widget->modifiedDocument();
+    const QStringList currentIds = mCurrentDocuments.keys();
+    for (const QString &id : currentIds) {
+        const SugarDocument modifiedDocument = currentDocument(id);
+        if (isModified(modifiedDocument)) {
+            const SugarDocument document = mDocuments.value(id);
             if (document.id().startsWith(QLatin1String("__temp"))) {
                 ComKdabSugarCRMItemTransferInterface transferInterface(service, QLatin1String("/ItemTransfer"), QDBusConnection::sessionBus());
 
                 // create new document instance
                 QDBusPendingReply<QString> uploadReply = transferInterface.uploadDocument(modifiedDocument.documentName(), modifiedDocument.statusId(),
-                                                                                          modifiedDocument.description(), widget->newDocumentFilePath());
+                                                                                          modifiedDocument.description(), mNewDocumentFilePaths.value(id));
                 uploadReply.waitForFinished();
 
                 const QString documentId = uploadReply.value();
@@ -24,6 +24,7 @@
 #include "kdcrmdata/enumdefinitions.h"
 #include "kdcrmdata/sugardocument.h"
 
+#include <QHash>
 #include <QWidget>
 
 namespace Ui {
@@ -34,10 +35,14 @@ class KJob;
 class LinkedItemsRepository;
 class QComboBox;
 class QLabel;
+class QModelIndex;
 class QPlainTextEdit;
 class QPushButton;
 class QUrl;
+class TimelineModel;
+struct TimelineEntry;
 
+// Edits the document selected in the DocumentsWindow
 class DocumentWidget : public QWidget
 {
     Q_OBJECT
@@ -107,17 +112,28 @@ private slots:
     void attachDocument();
     void attachDocument(const QString &filePath);
 
+    void slotCurrentChanged(const QModelIndex &current);
+    void slotDoubleClicked(const QModelIndex &index);
     void slotJobResult(KJob *job);
 
 private:
-    DocumentWidget* addDocument(const SugarDocument &document);
+    TimelineEntry entryForDocument(const SugarDocument &document) const;
+    void commitEditor();
+    SugarDocument currentDocument(const QString &id) const;
+    bool isModified(const SugarDocument &document) const;
 
     bool isModified() const;
     void saveChanges();
 
 private:
-    QVector<SugarDocument> mDocuments;
-    QVector<DocumentWidget*> mDocumentWidgets;
+    QHash<QString, SugarDocument> mDocuments; // by id, as loaded or attached
+    QHash<QString, SugarDocument> mCurrentDocuments; // by id, with the committed changes, without the deleted documents
+    QHash<QString, QString> mNewDocumentFilePaths; // by id, for the attached documents
+
+    // Only the selected document gets a widget, the others are painted by a TimelineDelegate
+    TimelineModel *mTimelineModel;
+    DocumentWidget *mEditor;
+    QString mEditedDocumentId;
 
     Ui::DocumentsWindow *ui;
     QString mResourceIdentifier;
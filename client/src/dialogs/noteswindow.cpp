@@ -23,6 +23,7 @@
 #include "kdcrmutils.h"
 #include "clientsettings.h"
 #include "linkeditemsrepository.h"
+#include "timelinedelegate.h"
 
 #include "kdcrmdata/sugarnote.h"
 #include "kdcrmdata/sugaremail.h"
@@ -32,19 +33,39 @@
 
 #include <KLocalizedString>
 
+#include <QAction>
+#include <QClipboard>
 #include <QCloseEvent>
+#include <QGuiApplication>
+#include <QItemSelectionModel>
 #include <QMessageBox>
 #include <QPushButton>
 #include <QScrollBar>
+#include <QSortFilterProxyModel>
 
 NotesWindow::NotesWindow(QWidget *parent) :
     QWidget(parent),
+    mTimelineModel(new TimelineModel(this)),
+    mFilterModel(new QSortFilterProxyModel(this)),
     ui(new Ui::NotesWindow)
 {
     ui->setupUi(this);
-    ui->textEdit->enableFindReplace(true);
-    ui->textEdit->setAcceptRichText(true);
-    ui->textEdit->setReadOnly(true);
+
+    // Only the visible notes and emails are laid out, which matters for accounts with a long history
+    mFilterModel->setSourceModel(mTimelineModel);
+    mFilterModel->setFilterCaseSensitivity(Qt::CaseInsensitive);
+    connect(ui->searchLineEdit, &QLineEdit::textChanged, mFilterModel, &QSortFilterProxyModel::setFilterFixedString);
+    ui->timelineView->setModel(mFilterModel);
+    ui->timelineView->setItemDelegate(new TimelineDelegate(ui->timelineView));
+
+    // Scrolling to the end of the history loads the archived notes and emails of the item, if any
+    connect(ui->timelineView->verticalScrollBar(), &QScrollBar::valueChanged, this, &NotesWindow::slotCheckHistoryEnd);
+
+    auto *copyAction = new QAction(i18n("Copy"), this);
+    copyAction->setShortcut(QKeySequence::Copy);
+    copyAction->setShortcutContext(Qt::WidgetShortcut);
+    connect(copyAction, &QAction::triggered, this, &NotesWindow::slotCopy);
+    ui->timelineView->addAction(copyAction);
 
     ui->buttonBox->button(QDialogButtonBox::Save)->setShortcut(Qt::CTRL | Qt::Key_Return);
 
@@ -53,6 +74,9 @@ NotesWindow::NotesWindow(QWidget *parent) :
 
 NotesWindow::~NotesWindow()
 {
+    if (mLinkedItemsRepository && !mLinkedItemId.isEmpty()) {
+        mLinkedItemsRepository->unpinHistory(mLinkedItemId);
+    }
     ClientSettings::self()->saveWindowSize(QStringLiteral("NotesWindow"), this);
     delete ui;
 }
@@ -60,12 +84,22 @@ NotesWindow::~NotesWindow()
 void NotesWindow::setLinkedItemsRepository(LinkedItemsRepository *repository)
 {
     mLinkedItemsRepository = repository;
+    connect(repository, &LinkedItemsRepository::archiveLoaded, this, &NotesWindow::slotArchiveLoaded);
+    connect(repository, &LinkedItemsRepository::historyBodiesLoaded, this, &NotesWindow::slotHistoryBodiesLoaded);
 }
 
 void NotesWindow::setLinkedTo(const QString &id, DetailsType itemType)
 {
+    if (mLinkedItemsRepository && !mLinkedItemId.isEmpty()) {
+        mLinkedItemsRepository->unpinHistory(mLinkedItemId);
+    }
     mLinkedItemId = id;
     mLinkedItemType = itemType;
+    if (mLinkedItemsRepository && !id.isEmpty()) {
+        // The bodies dropped by the memory budget are shown once fetched again, see slotHistoryBodiesLoaded
+        mLinkedItemsRepository->pinHistory(id);
+        mLinkedItemsRepository->loadHistoryBodies(id);
+    }
 }
 
 void NotesWindow::addNote(const SugarNote &note)
@@ -75,11 +109,17 @@ void NotesWindow::addNote(const SugarNote &note)
     htmlHeader += QStringLiteral("<html><h1>Note by %1, last modified %2:</h1>\n").arg(note.createdByName(), KDCRMUtils::formatDateTime(modified));
     htmlHeader += "<h2>" + note.name() + "</h2>\n"; // called "Subject" in the web gui
     QString text;
-    if (!note.description().isEmpty()) {
+    if (isBodyEvicted(note.id())) {
+        text += i18n("(loading...)") + '\n';
+    } else if (!note.description().isEmpty()) {
         text += note.description() + '\n';
     }
     text += '\n';
-    m_notes.append(NoteText(modified, htmlHeader, text));
+    TimelineEntry entry;
+    entry.date = modified;
+    entry.htmlHeader = htmlHeader;
+    entry.text = text;
+    m_notes.append(entry);
 }
 
 void NotesWindow::addEmail(const SugarEmail &email)
@@ -91,33 +131,33 @@ void NotesWindow::addEmail(const SugarEmail &email)
     htmlHeader += QStringLiteral("<h2>Subject: %1</h2>\n").arg(email.name());
     htmlHeader += QStringLiteral("<p>To: %1</p>\n").arg(toList);
 
-    const bool useHtml = email.description().isEmpty();
-    const QString text = (useHtml ? email.descriptionHtml() : email.description()) + '\n';
-    m_notes.append(NoteText(dateSent, htmlHeader, text, useHtml));
+    TimelineEntry entry;
+    entry.date = dateSent;
+    entry.htmlHeader = htmlHeader;
+    if (isBodyEvicted(email.id())) {
+        entry.text = i18n("(loading...)") + '\n';
+    } else {
+        const bool useHtml = email.description().isEmpty();
+        entry.text = (useHtml ? email.descriptionHtml() : email.description()) + '\n';
+        entry.isHtml = useHtml;
+    }
+    m_notes.append(entry);
+}
+
+// Dropped by the memory budget, and being fetched again, see setLinkedTo
+bool NotesWindow::isBodyEvicted(const QString &id) const
+{
+    return mLinkedItemsRepository && mLinkedItemsRepository->isHistoryBodyEvicted(id);
 }
 
 void NotesWindow::setVisible(bool visible)
 {
-    if (ui->textEdit->document()->isEmpty()) {
-        std::sort(m_notes.begin(), m_notes.end());
-        QTextCursor cursor = ui->textEdit->textCursor();
-        foreach (const NoteText &note, m_notes) {
-            //cursor.insertText(s_separator);
-            cursor.insertHtml(QStringLiteral("<hr>"));
-            cursor.insertBlock();
-            cursor.setBlockFormat(QTextBlockFormat());
-            cursor.insertHtml(note.htmlHeader());
-            cursor.setBlockFormat(QTextBlockFormat());
-            cursor.insertBlock();
-            cursor.insertBlock();
-            if (note.isHtml())
-                cursor.insertHtml(note.text());
-            else
-                cursor.insertText(note.text());
-        }
+    if (!m_notes.isEmpty()) {
+        mTimelineModel->setEntries(m_notes); // sorts them, most recent first
+        m_notes.clear();
     }
     QWidget::setVisible(visible);
-    ui->textEdit->verticalScrollBar()->setValue(0);
+    ui->timelineView->scrollToTop();
 }
 
 void NotesWindow::closeEvent(QCloseEvent *event)
@@ -197,3 +237,88 @@ void NotesWindow::slotJobResult(KJob *job)
     mIsNotModifiedOverride = true;
     QWidget::close();
 }
+
+void NotesWindow::slotCopy()
+{
+    QModelIndexList indexes = ui->timelineView->selectionModel()->selectedIndexes();
+    std::sort(indexes.begin(), indexes.end());
+    auto *delegate = static_cast<TimelineDelegate *>(ui->timelineView->itemDelegate());
+    QStringList texts;
+    texts.reserve(indexes.count());
+    for (const QModelIndex &index : qAsConst(indexes)) {
+        texts.append(delegate->plainText(index));
+    }
+    QGuiApplication::clipboard()->setText(texts.join(QLatin1Char('\n')));
+}
+
+void NotesWindow::slotCheckHistoryEnd(int value)
+{
+    if (!isVisible() || !mLinkedItemsRepository || mLinkedItemId.isEmpty()) {
+        return;
+    }
+    // Not when the whole history fits in the window, value() and maximum() are both 0 then
+    const QScrollBar *scrollBar = ui->timelineView->verticalScrollBar();
+    if (scrollBar->maximum() > 0 && value == scrollBar->maximum()
+            && mLinkedItemsRepository->hasArchivedHistory(mLinkedItemId)) {
+        mLinkedItemsRepository->loadArchive(mLinkedItemId);
+    }
+}
+
+void NotesWindow::slotArchiveLoaded()
+{
+    reloadEntries();
+}
+
+void NotesWindow::slotHistoryBodiesLoaded(const QString &parentId)
+{
+    if (parentId == mLinkedItemId) {
+        reloadEntries();
+    }
+}
+
+void NotesWindow::reloadEntries()
+{
+    if (mLinkedItemId.isEmpty()) {
+        return;
+    }
+    QVector<SugarNote> notes;
+    QVector<SugarEmail> emails;
+    switch (mLinkedItemType) {
+    case DetailsType::Account:
+        notes = mLinkedItemsRepository->notesForAccount(mLinkedItemId);
+        emails = mLinkedItemsRepository->emailsForAccount(mLinkedItemId);
+        break;
+    case DetailsType::Contact:
+        notes = mLinkedItemsRepository->notesForContact(mLinkedItemId);
+        emails = mLinkedItemsRepository->emailsForContact(mLinkedItemId);
+        break;
+    case DetailsType::Opportunity:
+        notes = mLinkedItemsRepository->notesForOpportunity(mLinkedItemId);
+        emails = mLinkedItemsRepository->emailsForOpportunity(mLinkedItemId);
+        break;
+    default:
+        return;
+    }
+    m_notes.clear();
+    for (const SugarNote &note : qAsConst(notes)) {
+        addNote(note);
+    }
+    for (const SugarEmail &email : qAsConst(emails)) {
+        addEmail(email);
+    }
+    // Keep the topmost visible entry at the top, wherever the new entries end up
+    const QModelIndex anchor = ui->timelineView->indexAt(QPoint(0, 0));
+    const QString anchorId = anchor.data(TimelineModel::IdRole).toString();
+    const int anchorOffset = anchor.isValid() ? ui->timelineView->visualRect(anchor).top() : 0;
+    mTimelineModel->setEntries(m_notes);
+    m_notes.clear();
+    const int row = anchorId.isEmpty() ? -1 : mTimelineModel->rowForId(anchorId);
+    if (row != -1) {
+        const QModelIndex index = mFilterModel->mapFromSource(mTimelineModel->index(row, 0));
+        ui->timelineView->scrollTo(index, QAbstractItemView::PositionAtTop);
+        if (ui->timelineView->verticalScrollMode() == QAbstractItemView::ScrollPerPixel) {
+            QScrollBar *scrollBar = ui->timelineView->verticalScrollBar();
+            scrollBar->setValue(scrollBar->value() - anchorOffset);
+        }
+    }
+}
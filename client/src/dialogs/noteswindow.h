@@ -22,8 +22,9 @@
 #define NOTESWINDOW_H
 
 #include <QWidget>
-#include <QDateTime>
 #include "enums.h"
+#include "fatcrmprivate_export.h"
+#include "timelinemodel.h"
 
 namespace Ui {
 class NotesWindow;
@@ -32,31 +33,9 @@ class SugarEmail;
 class SugarNote;
 class KJob;
 class LinkedItemsRepository;
+class QSortFilterProxyModel;
 
-// internal. Generic representation for notes and emails, to sort them by date.
-struct NoteText
-{
-    NoteText() {}
-    NoteText(const QDateTime &dt, const QString &htmlHeader, const QString &text, bool isHtml = false)
-        : m_date(dt), m_htmlHeader(htmlHeader), m_text(text), m_isHtml(isHtml) {}
-
-    bool operator<(const NoteText &other) const {
-        // Most recent at the top
-        return m_date > other.m_date;
-    }
-
-    QString text() const { return m_text; }
-    QString htmlHeader() const { return m_htmlHeader; }
-    bool isHtml() const { return m_isHtml; }
-
-private:
-    QDateTime m_date;
-    QString m_htmlHeader;
-    QString m_text;
-    bool m_isHtml = false;
-};
-
-class NotesWindow : public QWidget
+class FATCRMPRIVATE_EXPORT NotesWindow : public QWidget
 {
     Q_OBJECT
 
@@ -83,12 +62,20 @@ private slots:
     void on_buttonBox_accepted();
 
     void slotJobResult(KJob *job);
+    void slotCopy();
+    void slotCheckHistoryEnd(int value);
+    void slotArchiveLoaded();
+    void slotHistoryBodiesLoaded(const QString &parentId);
 
 private:
     bool isModified() const;
+    void reloadEntries();
+    bool isBodyEvicted(const QString &id) const;
     void saveChanges();
 
-    QVector<NoteText> m_notes;
+    QVector<TimelineEntry> m_notes; // until the window is shown
+    TimelineModel *mTimelineModel;
+    QSortFilterProxyModel *mFilterModel;
     Ui::NotesWindow *ui;
     QString mResourceIdentifier;
     LinkedItemsRepository *mLinkedItemsRepository = nullptr;
@@ -0,0 +1,130 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "quickopendialog.h"
+#include "clientsettings.h"
+#include "quickopenindex.h"
+
+#include "kdcrmdata/kdcrmutils.h"
+
+#include <KLocalizedString>
+
+#include <QCoreApplication>
+#include <QKeyEvent>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QVBoxLayout>
+
+static const int s_maxResults = 50;
+
+static QString typeLabel(DetailsType type)
+{
+    switch (type) {
+    case DetailsType::Account:
+        return i18nc("quick open result type", "Account");
+    case DetailsType::Opportunity:
+        return i18nc("quick open result type", "Opportunity");
+    case DetailsType::Lead:
+        return i18nc("quick open result type", "Lead");
+    case DetailsType::Contact:
+        return i18nc("quick open result type", "Contact");
+    case DetailsType::Campaign:
+        return i18nc("quick open result type", "Campaign");
+    }
+    return QString();
+}
+
+enum {
+    TypeRole = Qt::UserRole,
+    IdRole
+};
+
+QuickOpenDialog::QuickOpenDialog(const QuickOpenIndex *index, QWidget *parent) :
+    QDialog(parent),
+    mIndex(index)
+{
+    setWindowTitle(i18n("Quick Open"));
+    auto *layout = new QVBoxLayout(this);
+    mLineEdit = new QLineEdit(this);
+    mLineEdit->setPlaceholderText(i18n("Name of an account, contact, opportunity..."));
+    mLineEdit->setClearButtonEnabled(true);
+    mLineEdit->installEventFilter(this);
+    layout->addWidget(mLineEdit);
+    mResults = new QListWidget(this);
+    mResults->setUniformItemSizes(true);
+    layout->addWidget(mResults);
+
+    connect(mLineEdit, &QLineEdit::textChanged, this, &QuickOpenDialog::updateResults);
+    connect(mLineEdit, &QLineEdit::returnPressed, this, &QuickOpenDialog::activateCurrent);
+    connect(mResults, &QListWidget::itemActivated, this, &QuickOpenDialog::activateCurrent);
+
+    ClientSettings::self()->restoreWindowSize("quickopendialog", this);
+}
+
+QuickOpenDialog::~QuickOpenDialog()
+{
+    ClientSettings::self()->saveWindowSize("quickopendialog", this);
+}
+
+bool QuickOpenDialog::eventFilter(QObject *object, QEvent *event)
+{
+    // Navigate in the results without leaving the line edit
+    if (object == mLineEdit && event->type() == QEvent::KeyPress) {
+        auto *keyEvent = static_cast<QKeyEvent *>(event);
+        switch (keyEvent->key()) {
+        case Qt::Key_Up:
+        case Qt::Key_Down:
+        case Qt::Key_PageUp:
+        case Qt::Key_PageDown:
+            QCoreApplication::sendEvent(mResults, event);
+            return true;
+        default:
+            break;
+        }
+    }
+    return QDialog::eventFilter(object, event);
+}
+
+void QuickOpenDialog::updateResults(const QString &text)
+{
+    mResults->clear();
+    const QVector<QuickOpenIndex::Match> matches = mIndex->search(text, s_maxResults);
+    for (const QuickOpenIndex::Match &match : matches) {
+        const QString label = match.lastModified.isValid()
+                ? i18nc("quick open result: name (type), modification date", "%1 (%2), modified %3",
+                        match.name, typeLabel(match.type), KDCRMUtils::formatDate(match.lastModified.date()))
+                : i18nc("quick open result: name (type)", "%1 (%2)", match.name, typeLabel(match.type));
+        auto *item = new QListWidgetItem(label, mResults);
+        item->setData(TypeRole, int(match.type));
+        item->setData(IdRole, match.id);
+    }
+    mResults->setCurrentRow(0);
+}
+
+void QuickOpenDialog::activateCurrent()
+{
+    const QListWidgetItem *item = mResults->currentItem();
+    if (!item) {
+        return;
+    }
+    mSelectedType = DetailsType(item->data(TypeRole).toInt());
+    mSelectedId = item->data(IdRole).toString();
+    accept();
+}
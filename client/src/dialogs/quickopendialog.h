@@ -0,0 +1,59 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef QUICKOPENDIALOG_H
+#define QUICKOPENDIALOG_H
+
+#include "enums.h"
+
+#include <QDialog>
+
+class QLineEdit;
+class QListWidget;
+class QuickOpenIndex;
+
+/**
+ * The Ctrl+K palette: type part of the name of an account, contact, opportunity,
+ * lead or campaign, and open it with Enter.
+ */
+class QuickOpenDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit QuickOpenDialog(const QuickOpenIndex *index, QWidget *parent = nullptr);
+    ~QuickOpenDialog() override;
+
+    DetailsType selectedType() const { return mSelectedType; }
+    QString selectedId() const { return mSelectedId; }
+
+    bool eventFilter(QObject *object, QEvent *event) override;
+
+private:
+    void updateResults(const QString &text);
+    void activateCurrent();
+
+    const QuickOpenIndex *mIndex;
+    QLineEdit *mLineEdit;
+    QListWidget *mResults;
+    DetailsType mSelectedType = DetailsType::Account;
+    QString mSelectedId;
+};
+
+#endif // QUICKOPENDIALOG_H
@@ -23,12 +23,14 @@
 
 #include "clientsettings.h"
 #include "opportunityfiltersettings.h"
+#include "savedsearchindex.h"
 
 #include <KLocalizedString>
 
-SearchesDialog::SearchesDialog(QWidget *parent) :
+SearchesDialog::SearchesDialog(const SavedSearchIndex *savedSearchIndex, QWidget *parent) :
     QDialog(parent),
-    ui(new Ui::SearchesDialog)
+    ui(new Ui::SearchesDialog),
+    mSavedSearchIndex(savedSearchIndex)
 {
     ui->setupUi(this);
     initialize();
@@ -98,7 +100,10 @@ void SearchesDialog::populateListView()
     QVector<QString> savedSearches = ClientSettings::self()->savedSearches();
     std::sort(savedSearches.begin(), savedSearches.end(), [](const QString &s1, const QString &s2){ return s1.toLower() < s2.toLower(); });
     for (const QString &search : savedSearches) {
-        ui->searchesList->addItem(search);
+        const int count = mSavedSearchIndex ? mSavedSearchIndex->count(search) : -1;
+        const QString text = count < 0 ? search : i18nc("saved search name (number of matching opportunities)", "%1 (%2)", search, count);
+        auto *item = new QListWidgetItem(text, ui->searchesList);
+        item->setData(Qt::UserRole, search);
     }
 }
 
@@ -107,7 +112,7 @@ void SearchesDialog::slotItemChanged()
     if (ui->searchesList->selectedItems().isEmpty()) {
         mSelectedItemName = "";
     } else {
-        mSelectedItemName = ui->searchesList->currentItem()->text();
+        mSelectedItemName = ui->searchesList->currentItem()->data(Qt::UserRole).toString();
     }
 
     updateButtons();
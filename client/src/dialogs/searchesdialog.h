@@ -29,6 +29,7 @@
 namespace Ui {
 class SearchesDialog;
 }
+class SavedSearchIndex;
 
 class SearchesDialog : public QDialog
 {
@@ -40,7 +41,8 @@ public slots:
     void on_removeSearch_clicked();
 
 public:
-    explicit SearchesDialog(QWidget *parent = nullptr);
+    // The index provides the number of matches shown next to each search, it can be null
+    explicit SearchesDialog(const SavedSearchIndex *savedSearchIndex, QWidget *parent = nullptr);
     ~SearchesDialog();
 
     QString selectedItemName() const { return mSelectedItemName; }
@@ -57,6 +59,7 @@ private:
     void openAddSearchDialog();
 
     QString mSelectedItemName;
+    const SavedSearchIndex *mSavedSearchIndex;
 
     AddSearchDialog *mDialog;
 };
@@ -30,6 +30,7 @@
 
 #include "kdcrmdata/kdcrmutils.h"
 #include "kdcrmdata/kdcrmfields.h"
+#include "kdcrmdata/syncbaseattribute.h"
 
 #include <AkonadiCore/Collection>
 #include <AkonadiCore/Item>
@@ -157,6 +158,7 @@ void SimpleItemEditWidget::Private::saveClicked()
     }
 
     Item item = mItem;
+    SyncBaseAttribute::storeBase(item);
     mDetails->updateItem(item, data());
 
     Job *job = nullptr;
@@ -0,0 +1,177 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "completionvocabulary.h"
+
+#include <AkonadiCore/EntityTreeModel>
+
+#include <QCompleter>
+#include <QStringListModel>
+
+#include <algorithm>
+
+// Consistent with QCompleter::CaseInsensitivelySortedModel, with a case-sensitive tie-break
+// so that e.g. "CEO" and "Ceo" have a well-defined order
+static bool vocabularyLessThan(const QString &left, const QString &right)
+{
+    const int cmp = left.compare(right, Qt::CaseInsensitive);
+    return cmp != 0 ? cmp < 0 : left < right;
+}
+
+CompletionVocabulary::CompletionVocabulary(QAbstractItemModel *model, const ValueExtractor &extractor, QObject *parent)
+    : QObject(parent),
+      mModel(model),
+      mExtractor(extractor),
+      mStringListModel(new QStringListModel(this))
+{
+    connect(mModel, &QAbstractItemModel::rowsInserted, this, &CompletionVocabulary::addRows);
+    connect(mModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, &CompletionVocabulary::removeRows);
+    connect(mModel, &QAbstractItemModel::dataChanged, this, &CompletionVocabulary::updateRows);
+    connect(mModel, &QAbstractItemModel::modelReset, this, &CompletionVocabulary::rebuild);
+    rebuild();
+}
+
+CompletionVocabulary::~CompletionVocabulary()
+{
+}
+
+CompletionVocabulary *CompletionVocabulary::forModel(QAbstractItemModel *model, const QString &name, const ValueExtractor &extractor)
+{
+    auto *vocabulary = model->findChild<CompletionVocabulary *>(name, Qt::FindDirectChildrenOnly);
+    if (!vocabulary) {
+        vocabulary = new CompletionVocabulary(model, extractor, model);
+        vocabulary->setObjectName(name);
+    }
+    return vocabulary;
+}
+
+QCompleter *CompletionVocabulary::createCompleter(QObject *parent) const
+{
+    auto *completer = new QCompleter(mStringListModel, parent);
+    completer->setCaseSensitivity(Qt::CaseInsensitive);
+    completer->setModelSorting(QCompleter::CaseInsensitivelySortedModel);
+    return completer;
+}
+
+void CompletionVocabulary::rebuild()
+{
+    mRefCounts.clear();
+    mItemValues.clear();
+    const int count = mModel->rowCount();
+    for (int row = 0; row < count; ++row) {
+        const Akonadi::Item item = itemAt(QModelIndex(), row);
+        const QString value = mExtractor(item);
+        if (!value.isEmpty()) {
+            mItemValues.insert(item.id(), value);
+            ++mRefCounts[value];
+        }
+    }
+    mValues = mRefCounts.keys();
+    std::sort(mValues.begin(), mValues.end(), vocabularyLessThan);
+    mStringListModel->setStringList(mValues);
+}
+
+void CompletionVocabulary::addRows(const QModelIndex &parent, int first, int last)
+{
+    // The items are top-level rows, see rebuild()
+    if (parent.isValid()) {
+        return;
+    }
+    for (int row = first; row <= last; ++row) {
+        const Akonadi::Item item = itemAt(parent, row);
+        const QString value = mExtractor(item);
+        if (!value.isEmpty()) {
+            mItemValues.insert(item.id(), value);
+            addValue(value);
+        }
+    }
+}
+
+void CompletionVocabulary::removeRows(const QModelIndex &parent, int first, int last)
+{
+    // The items are top-level rows, see rebuild()
+    if (parent.isValid()) {
+        return;
+    }
+    for (int row = first; row <= last; ++row) {
+        const Akonadi::Item item = itemAt(parent, row);
+        const auto it = mItemValues.find(item.id());
+        if (it != mItemValues.end()) {
+            removeValue(*it);
+            mItemValues.erase(it);
+        }
+    }
+}
+
+void CompletionVocabulary::updateRows(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    if (topLeft.parent().isValid()) {
+        return;
+    }
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        const Akonadi::Item item = itemAt(topLeft.parent(), row);
+        const QString value = mExtractor(item);
+        const QString oldValue = mItemValues.value(item.id());
+        if (value == oldValue) {
+            continue;
+        }
+        if (!oldValue.isEmpty()) {
+            removeValue(oldValue);
+        }
+        if (value.isEmpty()) {
+            mItemValues.remove(item.id());
+        } else {
+            mItemValues.insert(item.id(), value);
+            addValue(value);
+        }
+    }
+}
+
+void CompletionVocabulary::addValue(const QString &value)
+{
+    int &refCount = mRefCounts[value];
+    if (++refCount > 1) {
+        return;
+    }
+    const int pos = std::lower_bound(mValues.constBegin(), mValues.constEnd(), value, vocabularyLessThan) - mValues.constBegin();
+    mValues.insert(pos, value);
+    mStringListModel->insertRows(pos, 1);
+    mStringListModel->setData(mStringListModel->index(pos), value);
+}
+
+void CompletionVocabulary::removeValue(const QString &value)
+{
+    const auto it = mRefCounts.find(value);
+    if (it == mRefCounts.end() || --(*it) > 0) {
+        return;
+    }
+    mRefCounts.erase(it);
+    const auto valueIt = std::lower_bound(mValues.constBegin(), mValues.constEnd(), value, vocabularyLessThan);
+    if (valueIt != mValues.constEnd() && *valueIt == value) {
+        const int pos = valueIt - mValues.constBegin();
+        mValues.removeAt(pos);
+        mStringListModel->removeRows(pos, 1);
+    }
+}
+
+Akonadi::Item CompletionVocabulary::itemAt(const QModelIndex &parent, int row) const
+{
+    return mModel->index(row, 0, parent).data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>();
+}
@@ -0,0 +1,83 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef COMPLETIONVOCABULARY_H
+#define COMPLETIONVOCABULARY_H
+
+#include "fatcrmprivate_export.h"
+
+#include <AkonadiCore/Item>
+
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+
+#include <functional>
+
+class QAbstractItemModel;
+class QCompleter;
+class QStringListModel;
+
+/**
+ * The distinct values of one field over all the items of a model (e.g. the titles of all contacts),
+ * sorted case-insensitively, for use in completers.
+ *
+ * Each value is reference-counted by the number of items using it, and the vocabulary is updated
+ * from the model's change signals, so it only scans the model once.
+ * Use forModel() to share one vocabulary per model and field between all the details widgets.
+ */
+class FATCRMPRIVATE_EXPORT CompletionVocabulary : public QObject
+{
+    Q_OBJECT
+public:
+    using ValueExtractor = std::function<QString(const Akonadi::Item &)>;
+
+    CompletionVocabulary(QAbstractItemModel *model, const ValueExtractor &extractor, QObject *parent = nullptr);
+    ~CompletionVocabulary() override;
+
+    // Returns the vocabulary called @p name for this model, creating it (as a child of the model) if needed
+    static CompletionVocabulary *forModel(QAbstractItemModel *model, const QString &name, const ValueExtractor &extractor);
+
+    QStringListModel *stringListModel() const { return mStringListModel; }
+    QStringList values() const { return mValues; }
+    int refCount(const QString &value) const { return mRefCounts.value(value); }
+
+    // Returns a case-insensitive completer on top of stringListModel()
+    QCompleter *createCompleter(QObject *parent) const;
+
+private:
+    void rebuild();
+    void addRows(const QModelIndex &parent, int first, int last);
+    void removeRows(const QModelIndex &parent, int first, int last);
+    void updateRows(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void addValue(const QString &value);
+    void removeValue(const QString &value);
+    Akonadi::Item itemAt(const QModelIndex &parent, int row) const;
+
+    QAbstractItemModel *mModel;
+    ValueExtractor mExtractor;
+    QStringListModel *mStringListModel;
+    // Same as the model's list, to search it without copying it out of the model on every change
+    QStringList mValues;
+    QHash<QString, int> mRefCounts;
+    QHash<Akonadi::Item::Id, QString> mItemValues; // to know the old value on changes and removals
+};
+
+#endif // COMPLETIONVOCABULARY_H
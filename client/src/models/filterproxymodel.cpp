@@ -29,6 +29,7 @@
 #include "kdcrmdata/sugarcampaign.h"
 #include "kdcrmdata/sugarlead.h"
 #include "kdcrmutils.h"
+#include "kdcrmtrace.h"
 
 #include <KContacts/Addressee>
 #include <KContacts/PhoneNumber>
@@ -101,6 +102,7 @@ void FilterProxyModel::setLinkedItemsRepository(LinkedItemsRepository *repo)
 void FilterProxyModel::setGDPRFilter(Action action)
 {
     d->mGDPRFilterAction = action;
+    FATCRM_TRACE_SCOPE("client", "FilterProxyModel::setGDPRFilter");
     invalidateFilter();
 }
 
@@ -123,10 +125,27 @@ QString FilterProxyModel::filterDescription() const
 
 void FilterProxyModel::setFilterString(const QString &filter)
 {
+    if (d->mFilter == filter) {
+        return;
+    }
     d->mFilter = filter;
+    FATCRM_TRACE_SCOPE("client", "FilterProxyModel::setFilterString");
+    FATCRM_TRACE_SET_COUNT(sourceModel() ? sourceModel()->rowCount() : 0);
     invalidateFilter();
 }
 
+void FilterProxyModel::setFilterStringWithoutInvalidating(const QString &filter)
+{
+    d->mFilter = filter;
+}
+
+void FilterProxyModel::sort(int column, Qt::SortOrder order)
+{
+    FATCRM_TRACE_SCOPE("client", "FilterProxyModel::sort");
+    FATCRM_TRACE_SET_COUNT(rowCount());
+    QSortFilterProxyModel::sort(column, order);
+}
+
 static int numRecentOpportunities(const QVector<SugarOpportunity> &opps)
 {
     static QDate today = QDate::currentDate();
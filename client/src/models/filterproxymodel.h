@@ -25,6 +25,7 @@
 
 #include <QSortFilterProxyModel>
 #include "enums.h"
+#include "fatcrmprivate_export.h"
 
 class LinkedItemsRepository;
 
@@ -37,7 +38,7 @@ class LinkedItemsRepository;
  * listed.
  *
  */
-class FilterProxyModel : public QSortFilterProxyModel
+class FATCRMPRIVATE_EXPORT FilterProxyModel : public QSortFilterProxyModel
 {
     Q_OBJECT
 
@@ -78,6 +79,8 @@ public:
 
     bool hasGDPRProtectedEmails() const;
 
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
 public Q_SLOTS:
     /**
      * Sets the filter that is used to filter for matching items
@@ -87,6 +90,11 @@ public Q_SLOTS:
 protected:
     bool filterAcceptsRow(int row, const QModelIndex &parent) const override;
 
+    /**
+     * For subclasses which change more of the filter and invalidate once afterwards
+     */
+    void setFilterStringWithoutInvalidating(const QString &filter);
+
 private:
     class Private;
     Private *const d;
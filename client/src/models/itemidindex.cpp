@@ -0,0 +1,122 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "itemidindex.h"
+#include "itemdataextractor.h"
+
+#include <AkonadiCore/EntityTreeModel>
+
+ItemIdIndex::ItemIdIndex(std::unique_ptr<ItemDataExtractor> dataExtractor, QObject *parent)
+    : QObject(parent),
+      mDataExtractor(std::move(dataExtractor))
+{
+}
+
+ItemIdIndex::~ItemIdIndex()
+{
+}
+
+void ItemIdIndex::setModel(QAbstractItemModel *model)
+{
+    if (mModel) {
+        disconnect(mModel, nullptr, this, nullptr);
+    }
+    mModel = model;
+    if (mModel) {
+        connect(mModel, &QAbstractItemModel::rowsInserted, this, &ItemIdIndex::addRows);
+        connect(mModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, &ItemIdIndex::removeRows);
+        connect(mModel, &QAbstractItemModel::dataChanged, this, &ItemIdIndex::updateRows);
+        connect(mModel, &QAbstractItemModel::modelReset, this, &ItemIdIndex::rebuild);
+    }
+    rebuild();
+}
+
+QModelIndex ItemIdIndex::index(const QString &id) const
+{
+    if (id.isEmpty()) {
+        return QModelIndex();
+    }
+    const QPersistentModelIndex index = mIndexes.value(id);
+    // The row might have been removed or changed without us being notified of a new id
+    // (e.g. dataChanged for another column range), so double-check before trusting it.
+    if (index.isValid() && idForIndex(index) == id) {
+        return index;
+    }
+    return QModelIndex();
+}
+
+void ItemIdIndex::rebuild()
+{
+    mIndexes.clear();
+    if (mModel && mDataExtractor) {
+        const int count = mModel->rowCount();
+        mIndexes.reserve(count);
+        if (count > 0) {
+            addRows(QModelIndex(), 0, count - 1);
+        }
+    }
+}
+
+void ItemIdIndex::addRows(const QModelIndex &parent, int first, int last)
+{
+    if (!mDataExtractor) {
+        return;
+    }
+    for (int row = first; row <= last; ++row) {
+        const QModelIndex index = mModel->index(row, 0, parent);
+        const QString id = idForIndex(index);
+        if (id.isEmpty()) {
+            continue;
+        }
+        auto it = mIndexes.find(id);
+        if (it == mIndexes.end()) {
+            mIndexes.insert(id, index);
+        } else if (*it != index) {
+            *it = index;
+        }
+    }
+}
+
+void ItemIdIndex::removeRows(const QModelIndex &parent, int first, int last)
+{
+    if (!mDataExtractor) {
+        return;
+    }
+    for (int row = first; row <= last; ++row) {
+        const QModelIndex index = mModel->index(row, 0, parent);
+        const auto it = mIndexes.find(idForIndex(index));
+        if (it != mIndexes.end() && *it == index) {
+            mIndexes.erase(it);
+        }
+    }
+}
+
+void ItemIdIndex::updateRows(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    // The id can change, e.g. when a newly created item comes back from the server.
+    // The old entry is left behind, index() notices that it doesn't match anymore.
+    addRows(topLeft.parent(), topLeft.row(), bottomRight.row());
+}
+
+QString ItemIdIndex::idForIndex(const QModelIndex &index) const
+{
+    const Akonadi::Item item = index.data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>();
+    return mDataExtractor->idForItem(item);
+}
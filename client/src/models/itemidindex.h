@@ -0,0 +1,68 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ITEMIDINDEX_H
+#define ITEMIDINDEX_H
+
+#include "fatcrmprivate_export.h"
+
+#include <QHash>
+#include <QObject>
+#include <QPersistentModelIndex>
+
+#include <memory>
+
+class ItemDataExtractor;
+class QAbstractItemModel;
+
+/**
+ * Maps the SugarCRM id of the items in a model (as returned by ItemDataExtractor::idForItem)
+ * to their index, so that opening an object by id doesn't need to walk all rows.
+ *
+ * The map is kept up to date from rowsInserted, rowsAboutToBeRemoved, dataChanged and modelReset;
+ * moves and layout changes are handled by the persistent indexes themselves.
+ */
+class FATCRMPRIVATE_EXPORT ItemIdIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ItemIdIndex(std::unique_ptr<ItemDataExtractor> dataExtractor, QObject *parent = nullptr);
+    ~ItemIdIndex() override;
+
+    void setModel(QAbstractItemModel *model);
+
+    // Returns the index (column 0) of the item with this id, or an invalid index
+    QModelIndex index(const QString &id) const;
+
+    int count() const { return mIndexes.count(); }
+
+private:
+    void rebuild();
+    void addRows(const QModelIndex &parent, int first, int last);
+    void removeRows(const QModelIndex &parent, int first, int last);
+    void updateRows(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    QString idForIndex(const QModelIndex &index) const;
+
+    std::unique_ptr<ItemDataExtractor> mDataExtractor;
+    QAbstractItemModel *mModel = nullptr;
+    QHash<QString, QPersistentModelIndex> mIndexes;
+};
+
+#endif // ITEMIDINDEX_H
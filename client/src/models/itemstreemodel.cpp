@@ -21,10 +21,13 @@
 */
 
 #include "itemstreemodel.h"
+#include "itemdataextractor.h"
+#include "itemidindex.h"
 #include "referenceddata.h"
 #include "clientsettings.h"
 #include "linkeditemsrepository.h"
 #include "collectionmanager.h"
+#include "memoryreport.h"
 #include "fatcrm_client_debug.h"
 
 #include "kdcrmdata/sugaraccount.h"
@@ -137,12 +140,15 @@ public:
     QHash<Item::Id, BackgroundColors> mIdToBackgroundColorsMap;
     bool mCurrentlyUpdatingBackgrounds = false;
     const int mIconSize;
+    ItemIdIndex *mIdIndex = nullptr;
 };
 
 ItemsTreeModel::ItemsTreeModel(DetailsType type, ChangeRecorder *monitor, QObject *parent)
     : EntityTreeModel(monitor, parent), d(new Private), mType(type)
 {
     d->mColumns = columnTypes(mType);
+    d->mIdIndex = new ItemIdIndex(ItemDataExtractor::createDataExtractor(mType), this);
+    d->mIdIndex->setModel(this);
 
     if (mType == DetailsType::Opportunity) {
         // Update accountName and country columns once all accounts are loaded
@@ -172,6 +178,42 @@ ItemsTreeModel::~ItemsTreeModel()
     delete d;
 }
 
+QModelIndex ItemsTreeModel::indexForId(const QString &id) const
+{
+    return d->mIdIndex->index(id);
+}
+
+void ItemsTreeModel::addToMemoryReport(MemoryReport &report) const
+{
+    // Only the payloads: the rest of the EntityTreeModel nodes isn't accessible from here
+    qint64 size = 0;
+    const int rows = rowCount();
+    for (int row = 0; row < rows; ++row) {
+        const Akonadi::Item item = index(row, 0).data(EntityTreeModel::ItemRole).value<Akonadi::Item>();
+        if (!item.hasPayload()) {
+            continue;
+        }
+        switch (mType) {
+        case DetailsType::Account:
+            size += item.payload<SugarAccount>().estimatedMemoryUsage();
+            break;
+        case DetailsType::Opportunity:
+            size += item.payload<SugarOpportunity>().estimatedMemoryUsage();
+            break;
+        case DetailsType::Lead:
+            size += item.payload<SugarLead>().estimatedMemoryUsage();
+            break;
+        case DetailsType::Contact:
+            size += SugarContactWrapper::estimatedMemoryUsage(item.payload<KContacts::Addressee>());
+            break;
+        case DetailsType::Campaign:
+            size += item.payload<SugarCampaign>().estimatedMemoryUsage();
+            break;
+        }
+    }
+    report.add(QStringLiteral("%1 model").arg(typeToString(mType)), rows, size);
+}
+
 /**
  * Returns the columns that the model currently shows.
  */
@@ -298,19 +340,7 @@ QVariant ItemsTreeModel::entityData(const Item &item, int column, int role) cons
 
     case Qt::DisplayRole:
     case Qt::EditRole:
-        switch (mType) {
-        case DetailsType::Account:
-            return accountData(item, column, role);
-        case DetailsType::Campaign:
-            return campaignData(item, column, role);
-        case DetailsType::Contact:
-            return contactData(item, column, role);
-        case DetailsType::Lead:
-            return leadData(item, column, role);
-        case DetailsType::Opportunity:
-            return opportunityData(item, column, role);
-        }
-        break;
+        return itemData(mType, item, columnTypes().at(column), role, mCollectionManager, mLinkedItemsRepository);
 
     case Qt::BackgroundRole:
         switch (columnTypes().at(column)) {
@@ -342,10 +372,8 @@ QVariant ItemsTreeModel::entityData(const Item &item, int column, int role) cons
         return QVariant();
 
     case Qt::FontRole:
-        if (mType == DetailsType::Opportunity) {
-            return opportunityData(item, column, role);
-        } else if (mType == DetailsType::Contact) {
-            return contactData(item, column, role);
+        if (mType == DetailsType::Opportunity || mType == DetailsType::Contact) {
+            return itemData(mType, item, columnTypes().at(column), role, mCollectionManager, mLinkedItemsRepository);
         }
         break;
 
@@ -526,10 +554,28 @@ QVariant ItemsTreeModel::entityHeaderData(int section, Qt::Orientation orientati
     return EntityTreeModel::entityHeaderData(section, orientation, role, headerGroup);
 }
 
+QVariant ItemsTreeModel::itemData(DetailsType type, const Item &item, ColumnType column, int role,
+                                  const CollectionManager *collectionManager, const LinkedItemsRepository *linkedItemsRepository)
+{
+    switch (type) {
+    case DetailsType::Account:
+        return accountData(item, column, role, linkedItemsRepository);
+    case DetailsType::Campaign:
+        return campaignData(item, column, role);
+    case DetailsType::Contact:
+        return contactData(item, column, role, linkedItemsRepository);
+    case DetailsType::Lead:
+        return leadData(item, column, role);
+    case DetailsType::Opportunity:
+        return opportunityData(item, column, role, collectionManager);
+    }
+    return QVariant();
+}
+
 /**
  * Return the data. SugarAccount type
  */
-QVariant ItemsTreeModel::accountData(const Item &item, int column, int role) const
+QVariant ItemsTreeModel::accountData(const Item &item, ColumnType column, int role, const LinkedItemsRepository *linkedItemsRepository)
 {
     if (!item.hasPayload<SugarAccount>()) {
         // Pass modeltest
@@ -542,7 +588,7 @@ QVariant ItemsTreeModel::accountData(const Item &item, int column, int role) con
     const SugarAccount account = item.payload<SugarAccount>();
 
     if ((role == Qt::DisplayRole) || (role == Qt::EditRole)) {
-        switch (columnTypes().at(column)) {
+        switch (column) {
         case Name:
             return account.name();
         case City:
@@ -560,15 +606,21 @@ QVariant ItemsTreeModel::accountData(const Item &item, int column, int role) con
         case PostalCode:
             return account.postalCodeForGui();
         case NumberOfOpportunities:
-            return mLinkedItemsRepository->opportunitiesForAccount(account.id()).count();
+            if (!linkedItemsRepository)
+                return QVariant();
+            return linkedItemsRepository->opportunitiesForAccount(account.id()).count();
         case NumberOfContacts:
-            return mLinkedItemsRepository->contactsForAccount(account.id()).count();
+            if (!linkedItemsRepository)
+                return QVariant();
+            return linkedItemsRepository->contactsForAccount(account.id()).count();
         case NumberOfDocumentsNotesEmails:
+            if (!linkedItemsRepository)
+                return QVariant();
             // The goal is to find those with 0 of each (for GDPR cleanup purposes)
             // so I'm not doing 3 different columns, for now.
-            return mLinkedItemsRepository->documentsForAccount(account.id()).count() +
-                    mLinkedItemsRepository->notesForAccount(account.id()).count() +
-                    mLinkedItemsRepository->emailsForAccount(account.id()).count();
+            return linkedItemsRepository->documentsForAccount(account.id()).count() +
+                    linkedItemsRepository->notesForAccount(account.id()).count() +
+                    linkedItemsRepository->emailsForAccount(account.id()).count();
         default:
             return QVariant();
         }
@@ -580,7 +632,7 @@ QVariant ItemsTreeModel::accountData(const Item &item, int column, int role) con
 /**
  * Return the data. SugarCampaign type
  */
-QVariant ItemsTreeModel::campaignData(const Item &item, int column, int role) const
+QVariant ItemsTreeModel::campaignData(const Item &item, ColumnType column, int role)
 {
     if (!item.hasPayload<SugarCampaign>()) {
 
@@ -595,7 +647,7 @@ QVariant ItemsTreeModel::campaignData(const Item &item, int column, int role) co
     const SugarCampaign campaign = item.payload<SugarCampaign>();
 
     if ((role == Qt::DisplayRole) || (role == Qt::EditRole)) {
-        switch (columnTypes().at(column)) {
+        switch (column) {
         case CampaignName:
             return campaign.name();
         case Status:
@@ -617,7 +669,7 @@ QVariant ItemsTreeModel::campaignData(const Item &item, int column, int role) co
  * Return the data. KContacts::Addressee type - ref: Contacts
  * Only called for DisplayRole, EditRole and FontRole
  */
-QVariant ItemsTreeModel::contactData(const Item &item, int column, int role) const
+QVariant ItemsTreeModel::contactData(const Item &item, ColumnType column, int role, const LinkedItemsRepository *linkedItemsRepository)
 {
     if (!item.hasPayload<KContacts::Addressee>()) {
 
@@ -633,7 +685,7 @@ QVariant ItemsTreeModel::contactData(const Item &item, int column, int role) con
     const SugarContactWrapper contactWrapper(addressee);
 
     if ((role == Qt::DisplayRole) || (role == Qt::EditRole)) {
-        switch (columnTypes().at(column)) {
+        switch (column) {
         case FullName:
             return addressee.assembledName();
         case Title:
@@ -664,16 +716,20 @@ QVariant ItemsTreeModel::contactData(const Item &item, int column, int role) con
         }
         case NumberOfOpportunities:
         {
-            return mLinkedItemsRepository->opportunitiesForAccount(contactWrapper.accountId()).count();
+            if (!linkedItemsRepository)
+                return QVariant();
+            return linkedItemsRepository->opportunitiesForAccount(contactWrapper.accountId()).count();
         }
         case NumberOfDocumentsNotesEmails:
         {
+            if (!linkedItemsRepository)
+                return QVariant();
             const QString accountId = contactWrapper.accountId();
             // The goal is to find those with 0 of each (for GDPR cleanup purposes)
             // so I'm not doing 3 different columns, for now.
-            return mLinkedItemsRepository->documentsForAccount(accountId).count() +
-                    mLinkedItemsRepository->notesForAccount(accountId).count() +
-                    mLinkedItemsRepository->emailsForAccount(accountId).count();
+            return linkedItemsRepository->documentsForAccount(accountId).count() +
+                    linkedItemsRepository->notesForAccount(accountId).count() +
+                    linkedItemsRepository->emailsForAccount(accountId).count();
         }
         case LeadSource:
             return contactWrapper.leadSource();
@@ -685,7 +741,7 @@ QVariant ItemsTreeModel::contactData(const Item &item, int column, int role) con
     }
 
     if (role == Qt::FontRole) {
-        switch (columnTypes().at(column)) {
+        switch (column) {
         case PreferredEmail:
             if (contactWrapper.invalidEmail() == QLatin1String("1")) {
                 QFont f;
@@ -704,7 +760,7 @@ QVariant ItemsTreeModel::contactData(const Item &item, int column, int role) con
 /**
  * Return the data. SugarLead type
  */
-QVariant ItemsTreeModel::leadData(const Item &item, int column, int role) const
+QVariant ItemsTreeModel::leadData(const Item &item, ColumnType column, int role)
 {
     if (!item.hasPayload<SugarLead>()) {
 
@@ -719,7 +775,7 @@ QVariant ItemsTreeModel::leadData(const Item &item, int column, int role) const
     const SugarLead lead = item.payload<SugarLead>();
 
     if ((role == Qt::DisplayRole) || (role == Qt::EditRole)) {
-        switch (columnTypes().at(column)) {
+        switch (column) {
         case LeadName:
             return lead.lastName();
         case LeadStatus:
@@ -741,7 +797,7 @@ QVariant ItemsTreeModel::leadData(const Item &item, int column, int role) const
  * Return the data. SugarOpportunity type
  * Only called for DisplayRole, EditRole and FontRole
  */
-QVariant ItemsTreeModel::opportunityData(const Item &item, int column, int role) const
+QVariant ItemsTreeModel::opportunityData(const Item &item, ColumnType column, int role, const CollectionManager *collectionManager)
 {
     if (!item.hasPayload<SugarOpportunity>()) {
 
@@ -756,7 +812,7 @@ QVariant ItemsTreeModel::opportunityData(const Item &item, int column, int role)
     const SugarOpportunity opportunity = item.payload<SugarOpportunity>();
 
     if ((role == Qt::DisplayRole) || (role == Qt::EditRole)) {
-        switch (columnTypes().at(column)) {
+        switch (column) {
         case OpportunityName:
             return opportunity.name();
         case OpportunityAccountName: {
@@ -777,10 +833,10 @@ QVariant ItemsTreeModel::opportunityData(const Item &item, int column, int role)
         }
         case Amount: {
             const double amount = QLocale::c().toDouble(opportunity.amount());
-            if (role == Qt::DisplayRole) {
+            if (role == Qt::DisplayRole && collectionManager) {
                 // We can't use opportunity.currencySymbol(), it's only set for euros.
                 // So we have to look up currencyId() in the (fake) enum definition set by the resource.
-                const auto &enums = mCollectionManager->enumDefinitions(item.parentCollection().id());
+                const auto &enums = collectionManager->enumDefinitions(item.parentCollection().id());
                 const int pos = enums.indexOf(KDCRMFields::currencyId());
                 if (pos > -1) {
                     const auto &enumDef = enums.at(pos);
@@ -1117,8 +1173,13 @@ ItemsTreeModel::ColumnType ItemsTreeModel::columnTypeFromName(const QString &nam
 
 ItemsTreeModel::ColumnTypes ItemsTreeModel::defaultVisibleColumns() const
 {
-    ItemsTreeModel::ColumnTypes columns = columnTypes();
-    switch (mType) {
+    return defaultVisibleColumns(mType);
+}
+
+ItemsTreeModel::ColumnTypes ItemsTreeModel::defaultVisibleColumns(DetailsType type)
+{
+    ItemsTreeModel::ColumnTypes columns = columnTypes(type);
+    switch (type) {
     case DetailsType::Account:
         columns.removeAll(ItemsTreeModel::Street);
         columns.removeAll(ItemsTreeModel::CreatedBy);
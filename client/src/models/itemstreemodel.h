@@ -32,6 +32,7 @@
 
 class LinkedItemsRepository;
 class CollectionManager;
+class MemoryReport;
 
 namespace KContacts { class Addressee; }
 namespace Akonadi { class ChangeRecorder; }
@@ -119,6 +120,7 @@ public:
 
     ColumnTypes columnTypes() const; // all available column types
     ColumnTypes defaultVisibleColumns() const; // the column types that should be initially visible
+    static ColumnTypes defaultVisibleColumns(DetailsType type);
     QString columnName(int column) const;
 
     static QString columnNameFromType(ColumnType col);
@@ -137,6 +139,17 @@ public:
 
     static QString countryForContact(const KContacts::Addressee &addressee);
 
+    // The data of one cell, for DisplayRole, EditRole and FontRole, without needing a model (used by fatcrm-export).
+    // The collection manager provides currency symbols, the repository the "number of" columns; both can be null.
+    static QVariant itemData(DetailsType type, const Akonadi::Item &item, ColumnType column, int role,
+                             const CollectionManager *collectionManager, const LinkedItemsRepository *linkedItemsRepository);
+
+    // Returns the index of the item with this SugarCRM id, or an invalid index
+    QModelIndex indexForId(const QString &id) const;
+
+    // Adds the estimated size of the payloads held by the model
+    void addToMemoryReport(MemoryReport &report) const;
+
 private Q_SLOTS:
     void slotAccountModified(const QString &accountId, const QVector<AccountRepository::Field> &changedFields);
     void slotAccountRemoved(const QString &accountId);
@@ -145,11 +158,11 @@ private Q_SLOTS:
     void updateBackgrounds(int first, int last);
 
 private:
-    QVariant accountData(const Akonadi::Item &item, int column, int role) const;
-    QVariant campaignData(const Akonadi::Item &item, int column, int role) const;
-    QVariant contactData(const Akonadi::Item &item, int column, int role) const;
-    QVariant leadData(const Akonadi::Item &item, int column, int role) const;
-    QVariant opportunityData(const Akonadi::Item &item, int column, int role) const;
+    static QVariant accountData(const Akonadi::Item &item, ColumnType column, int role, const LinkedItemsRepository *linkedItemsRepository);
+    static QVariant campaignData(const Akonadi::Item &item, ColumnType column, int role);
+    static QVariant contactData(const Akonadi::Item &item, ColumnType column, int role, const LinkedItemsRepository *linkedItemsRepository);
+    static QVariant leadData(const Akonadi::Item &item, ColumnType column, int role);
+    static QVariant opportunityData(const Akonadi::Item &item, ColumnType column, int role, const CollectionManager *collectionManager);
     QVariant accountToolTip(const Akonadi::Item &item) const;
     QVariant opportunityToolTip(const Akonadi::Item &item) const;
     QString columnToolTip(ColumnType col) const;
@@ -21,13 +21,12 @@
 */
 
 #include "opportunityfilterproxymodel.h"
-#include "accountrepository.h"
-#include "clientsettings.h"
 #include "itemstreemodel.h"
 #include "opportunitiespage.h"
 #include "opportunityfiltersettings.h"
-#include "referenceddata.h"
+#include "savedsearchindex.h"
 
+#include "kdcrmdata/kdcrmtrace.h"
 #include "kdcrmdata/sugaropportunity.h"
 
 #include <AkonadiCore/EntityTreeModel>
@@ -47,13 +46,34 @@ public:
     Private()
     {}
 
+    const QSet<Akonadi::Item::Id> *matchingItems(const QString &filterString);
+
     OpportunityFilterSettings settings;
+    SavedSearchIndex *savedSearchIndex = nullptr;
 
+    // The result set of the saved search matching settings + mResolvedFilterString, if any
+    const QSet<Akonadi::Item::Id> *mMatchingItems = nullptr;
+    QString mResolvedFilterString;
+    bool mResolved = false;
 };
 
+const QSet<Akonadi::Item::Id> *OpportunityFilterProxyModel::Private::matchingItems(const QString &filterString)
+{
+    if (!mResolved || mResolvedFilterString != filterString) {
+        mMatchingItems = savedSearchIndex->matchingItems(settings, filterString);
+        mResolvedFilterString = filterString;
+        mResolved = true;
+    }
+    return mMatchingItems;
+}
+
 OpportunityFilterProxyModel::OpportunityFilterProxyModel(QObject *parent)
     : FilterProxyModel(DetailsType::Opportunity, parent), d(new Private())
 {
+    d->savedSearchIndex = new SavedSearchIndex(this);
+    connect(d->savedSearchIndex, &SavedSearchIndex::searchesChanged, this, [this]() {
+        d->mResolved = false;
+    });
 }
 
 OpportunityFilterProxyModel::~OpportunityFilterProxyModel()
@@ -64,9 +84,30 @@ OpportunityFilterProxyModel::~OpportunityFilterProxyModel()
 void OpportunityFilterProxyModel::setFilter(const OpportunityFilterSettings &settings)
 {
     d->settings = settings;
+    d->mResolved = false;
+    FATCRM_TRACE_SCOPE("client", "OpportunityFilterProxyModel::setFilter");
     invalidate();
 }
 
+void OpportunityFilterProxyModel::setFilter(const OpportunityFilterSettings &settings, const QString &filterString)
+{
+    setFilterStringWithoutInvalidating(filterString);
+    setFilter(settings);
+}
+
+SavedSearchIndex *OpportunityFilterProxyModel::savedSearchIndex() const
+{
+    return d->savedSearchIndex;
+}
+
+void OpportunityFilterProxyModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    // Connect the index to the source model first, so that its result sets are already
+    // up to date when we filter inserted or changed rows
+    d->savedSearchIndex->setModel(sourceModel);
+    FilterProxyModel::setSourceModel(sourceModel);
+}
+
 QString OpportunityFilterProxyModel::filterDescription() const
 {
     QString txt = d->settings.filterDescription();
@@ -78,34 +119,6 @@ QString OpportunityFilterProxyModel::filterDescription() const
     return txt;
 }
 
-static bool opportunityMatchesFilter(const SugarOpportunity &opportunity, const QString &filter)
-{
-    if (opportunity.name().contains(filter, Qt::CaseInsensitive)) {
-        return true;
-    }
-    const QString accountName = ReferencedData::instance(AccountRef)->referencedData(opportunity.accountId());
-    if (accountName.contains(filter, Qt::CaseInsensitive)) {
-        return true;
-    }
-    if (opportunity.salesStage().contains(filter, Qt::CaseInsensitive)) {
-        return true;
-    }
-    if (opportunity.amount().contains(filter, Qt::CaseInsensitive)) {
-        return true;
-    }
-    if (opportunity.dateClosed().contains(filter, Qt::CaseInsensitive)) {
-        return true;
-    }
-    if (opportunity.assignedUserName().contains(filter, Qt::CaseInsensitive)) {
-        return true;
-    }
-    if (opportunity.opportunitySize().contains(filter, Qt::CaseInsensitive)) {
-        return true;
-    }
-
-    return false;
-}
-
 Q_NORETURN void OpportunityFilterProxyModel::showFatalError(const QString &fatalError)
 {
     QMessageBox::warning(nullptr, i18n("Corrupt Database"), fatalError);
@@ -136,59 +149,22 @@ bool OpportunityFilterProxyModel::filterAcceptsRow(int row, const QModelIndex &p
             return false;
         }
     }
-    const SugarOpportunity opportunity = item.payload<SugarOpportunity>();
-
-    const QStringList assignees = d->settings.assignees();
-    if (!assignees.isEmpty() && !assignees.contains(opportunity.assignedUserName()))
-        return false;
 
-    const QStringList countries = d->settings.countries();
-    if (!countries.isEmpty()) {
-        const QString country = AccountRepository::instance()->accountById(opportunity.accountId()).countryForGui();
-        if (countries.contains(OpportunityFilterSettings::otherCountriesSpecialValue())) {
-            // Special case: filtering for a country not in any of the defined groups
-            QVector<ClientSettings::GroupFilters::Group> groups = ClientSettings::self()->countryFilters().groups();
-            const auto it = std::find_if(groups.constBegin(), groups.constEnd(),
-                                         [&country](const ClientSettings::GroupFilters::Group &group){
-                return group.entries.contains(country, Qt::CaseInsensitive); });
-            if (it != groups.constEnd())
-                return false;
-        } else {
-            // Standard filtering using a country group
-            if (!countries.contains(country, Qt::CaseInsensitive))
-                return false;
-        }
+    const QString filterStr = filterString();
+    if (const QSet<Akonadi::Item::Id> *matchingItems = d->matchingItems(filterStr)) {
+        return matchingItems->contains(item.id());
     }
 
-    const auto salesStage = opportunity.salesStage();
-    const bool isClosedWon = salesStage.contains(QLatin1String("Closed Won"));
-    const bool isClosedLost = salesStage.contains(QLatin1String("Closed Lost"));
-    if (!d->settings.showClosedWon() && isClosedWon)
-        return false;
-    if (!d->settings.showClosedLost() && isClosedLost)
-        return false;
-    if (!d->settings.showOpen() && !isClosedWon && !isClosedLost)
-        return false;
-    if (d->settings.maxDate().isValid() && (!opportunity.nextCallDate().isValid()
-                                 || opportunity.nextCallDate() > d->settings.maxDate()))
-        return false;
-    if (d->settings.modifiedAfter().isValid() && opportunity.dateModified().date() < d->settings.modifiedAfter())
-        return false;
-    if (d->settings.modifiedBefore().isValid() && opportunity.dateModified().date() > d->settings.modifiedBefore())
-        return false;
+    const SugarOpportunity opportunity = item.payload<SugarOpportunity>();
 
-    QString shownPriority = d->settings.shownPriority();
-    if (shownPriority == "Not set") // "Not set" is much clearer to me than just a blank space (like the WebUI has)
-        shownPriority = "";
-    if (shownPriority != "-" && opportunity.opportunityPriority().toUpper() != shownPriority)
+    if (!d->settings.matches(opportunity))
         return false;
 
-    const QString filterStr = filterString();
     if (filterStr.isEmpty()) {
         return true;
     }
 
-    return opportunityMatchesFilter(opportunity, filterStr);
+    return OpportunityFilterSettings::matchesSearchText(opportunity, filterStr);
 }
 
 bool OpportunityFilterProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
@@ -25,6 +25,7 @@
 
 #include "filterproxymodel.h"
 class OpportunityFilterSettings;
+class SavedSearchIndex;
 
 /**
  * A proxy model for sugar tree models.
@@ -35,7 +36,7 @@ class OpportunityFilterSettings;
  * listed.
  *
  */
-class OpportunityFilterProxyModel : public FilterProxyModel
+class FATCRMPRIVATE_EXPORT OpportunityFilterProxyModel : public FilterProxyModel
 {
     Q_OBJECT
 
@@ -54,6 +55,20 @@ public:
 
     void setFilter(const OpportunityFilterSettings &settings);
 
+    /**
+     * Sets the filter settings and the filter string at once, filtering only once.
+     */
+    void setFilter(const OpportunityFilterSettings &settings, const QString &filterString);
+
+    /**
+     * The result sets of the saved searches, kept up to date with the source model.
+     * When the filter is the same as one of the saved searches, filtering only looks up
+     * the opportunities in its result set.
+     */
+    SavedSearchIndex *savedSearchIndex() const;
+
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
+
     QString filterDescription() const override;
 
 protected:
@@ -0,0 +1,469 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "quickopenindex.h"
+#include "itemdataextractor.h"
+
+#include "kdcrmdata/kdcrmutils.h"
+#include "kdcrmdata/sugaraccount.h"
+#include "kdcrmdata/sugarcampaign.h"
+#include "kdcrmdata/sugarlead.h"
+#include "kdcrmdata/sugaropportunity.h"
+
+#include <KContacts/Addressee>
+#include <AkonadiCore/EntityTreeModel>
+
+#include <sugarcontactwrapper.h>
+
+#include <QSet>
+
+#include <algorithm>
+
+static const int s_trigramLength = 3;
+
+// Trigram keys use the lower 48 bits, prefix keys also have their length in the upper bits
+static quint64 trigramKey(const QChar *chars)
+{
+    return (quint64(chars[0].unicode()) << 32) | (quint64(chars[1].unicode()) << 16) | chars[2].unicode();
+}
+
+static quint64 prefixKey(const QChar *chars, int length)
+{
+    Q_ASSERT(length == 1 || length == 2);
+    return length == 1 ? (quint64(1) << 48) | chars[0].unicode()
+                       : (quint64(2) << 48) | (quint64(chars[0].unicode()) << 16) | chars[1].unicode();
+}
+
+// Keys for one word of an indexed name: its one- and two-letter prefixes, and all its trigrams
+static void addIndexKeys(const QChar *word, int length, QVector<quint64> &keys)
+{
+    keys.append(prefixKey(word, 1));
+    if (length >= 2) {
+        keys.append(prefixKey(word, 2));
+    }
+    for (int i = 0; i + s_trigramLength <= length; ++i) {
+        keys.append(trigramKey(word + i));
+    }
+}
+
+// Keys that any name matching this query word must have
+static QVector<quint64> queryKeys(const QString &word)
+{
+    QVector<quint64> keys;
+    if (word.size() < s_trigramLength) {
+        keys.append(prefixKey(word.constData(), word.size()));
+    } else {
+        for (int i = 0; i + s_trigramLength <= word.size(); ++i) {
+            keys.append(trigramKey(word.constData() + i));
+        }
+    }
+    return keys;
+}
+
+// Case-folded words separated by single spaces, so that "ACME  (Berlin)" and "acme berlin" compare equal
+static QString normalize(const QString &text)
+{
+    const QString folded = text.toCaseFolded();
+    QString result;
+    result.reserve(folded.size());
+    bool pendingSpace = false;
+    for (const QChar c : folded) {
+        if (c.isLetterOrNumber()) {
+            if (pendingSpace && !result.isEmpty()) {
+                result += QLatin1Char(' ');
+            }
+            pendingSpace = false;
+            result += c;
+        } else {
+            pendingSpace = true;
+        }
+    }
+    return result;
+}
+
+// 0: exact name, 1: name prefix, 2: all words at word starts, 3: other matches, -1: no match
+static int matchTier(const QString &name, const QString &query, const QStringList &words, const QStringList &wordStarts)
+{
+    if (name == query) {
+        return 0;
+    }
+    if (name.startsWith(query)) {
+        return 1;
+    }
+    bool allAtWordStart = true;
+    for (int i = 0; i < words.count(); ++i) {
+        const QString &word = words.at(i);
+        if (name.startsWith(word) || name.contains(wordStarts.at(i))) {
+            continue;
+        }
+        if (word.size() < s_trigramLength || !name.contains(word)) {
+            return -1;
+        }
+        allAtWordStart = false;
+    }
+    return allAtWordStart ? 2 : 3;
+}
+
+static int typeRank(DetailsType type)
+{
+    switch (type) {
+    case DetailsType::Account:
+        return 0;
+    case DetailsType::Contact:
+        return 1;
+    case DetailsType::Opportunity:
+        return 2;
+    case DetailsType::Lead:
+        return 3;
+    case DetailsType::Campaign:
+        return 4;
+    }
+    return MaxType + 1;
+}
+
+static Akonadi::Item itemAt(QAbstractItemModel *model, const QModelIndex &parent, int row)
+{
+    return model->index(row, 0, parent).data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>();
+}
+
+QuickOpenIndex::QuickOpenIndex(QObject *parent)
+    : QObject(parent)
+{
+    for (int type = 0; type <= MaxType; ++type) {
+        mIdExtractors.push_back(ItemDataExtractor::createDataExtractor(DetailsType(type)));
+    }
+}
+
+QuickOpenIndex::~QuickOpenIndex()
+{
+}
+
+void QuickOpenIndex::addModel(DetailsType type, QAbstractItemModel *model)
+{
+    if (mModels.contains(model)) {
+        return;
+    }
+    mModels.insert(model, type);
+    connect(model, &QAbstractItemModel::rowsInserted, this, [this, type, model](const QModelIndex &parent, int first, int last) {
+        addRows(type, model, parent, first, last);
+    });
+    connect(model, &QAbstractItemModel::rowsAboutToBeRemoved, this, [this, model](const QModelIndex &parent, int first, int last) {
+        removeRows(model, parent, first, last);
+    });
+    connect(model, &QAbstractItemModel::dataChanged, this, [this, type, model](const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+        updateRows(type, model, topLeft, bottomRight);
+    });
+    connect(model, &QAbstractItemModel::modelReset, this, [this, type, model]() {
+        rebuild(type, model);
+    });
+    connect(model, &QObject::destroyed, this, [this, type, model]() {
+        mModels.remove(model);
+        removeType(type);
+    });
+    rebuild(type, model);
+}
+
+void QuickOpenIndex::removeModel(QAbstractItemModel *model)
+{
+    const auto it = mModels.find(model);
+    if (it == mModels.end()) {
+        return;
+    }
+    disconnect(model, nullptr, this, nullptr);
+    removeType(*it);
+    mModels.erase(it);
+}
+
+QVector<QuickOpenIndex::Match> QuickOpenIndex::search(const QString &query, int maxResults) const
+{
+    QVector<Match> result;
+    const QString normalizedQuery = normalize(query);
+    if (normalizedQuery.isEmpty() || maxResults <= 0) {
+        return result;
+    }
+    const QStringList words = normalizedQuery.split(QLatin1Char(' '));
+
+    // Every match is in the posting list of every query key, so only walk the shortest one
+    const QVector<int> *candidates = nullptr;
+    QStringList wordStarts;
+    for (const QString &word : words) {
+        wordStarts.append(QLatin1Char(' ') + word);
+        for (quint64 key : queryKeys(word)) {
+            const auto it = mPostings.constFind(key);
+            if (it == mPostings.constEnd()) {
+                return result;
+            }
+            if (!candidates || it->size() < candidates->size()) {
+                candidates = &it.value();
+            }
+        }
+    }
+
+    struct Candidate
+    {
+        int tier;
+        int slot;
+    };
+    QVector<Candidate> matches;
+    for (int slot : *candidates) {
+        const int tier = matchTier(mRecords.at(slot).normalizedName, normalizedQuery, words, wordStarts);
+        if (tier >= 0) {
+            matches.append({ tier, slot });
+        }
+    }
+
+    auto better = [this](const Candidate &left, const Candidate &right) {
+        if (left.tier != right.tier) {
+            return left.tier < right.tier;
+        }
+        const Record &l = mRecords.at(left.slot);
+        const Record &r = mRecords.at(right.slot);
+        if (l.type != r.type) {
+            return typeRank(l.type) < typeRank(r.type);
+        }
+        if (l.modified != r.modified) {
+            return l.modified > r.modified;
+        }
+        const int cmp = l.name.compare(r.name, Qt::CaseInsensitive);
+        return cmp != 0 ? cmp < 0 : left.slot < right.slot;
+    };
+    if (matches.count() > maxResults) {
+        std::partial_sort(matches.begin(), matches.begin() + maxResults, matches.end(), better);
+        matches.resize(maxResults);
+    } else {
+        std::sort(matches.begin(), matches.end(), better);
+    }
+
+    result.reserve(matches.count());
+    for (const Candidate &candidate : qAsConst(matches)) {
+        const Record &record = mRecords.at(candidate.slot);
+        const QDateTime modified = record.modified ? QDateTime::fromMSecsSinceEpoch(record.modified) : QDateTime();
+        result.append({ record.type, record.id, record.name, modified });
+    }
+    return result;
+}
+
+int QuickOpenIndex::count() const
+{
+    return mSlots.count();
+}
+
+QString QuickOpenIndex::displayName(DetailsType type, const Akonadi::Item &item)
+{
+    switch (type) {
+    case DetailsType::Account:
+        return item.hasPayload<SugarAccount>() ? item.payload<SugarAccount>().name() : QString();
+    case DetailsType::Opportunity:
+        return item.hasPayload<SugarOpportunity>() ? item.payload<SugarOpportunity>().name() : QString();
+    case DetailsType::Contact:
+        return item.hasPayload<KContacts::Addressee>() ? item.payload<KContacts::Addressee>().assembledName() : QString();
+    case DetailsType::Lead:
+        if (item.hasPayload<SugarLead>()) {
+            const SugarLead lead = item.payload<SugarLead>();
+            return (lead.firstName() + QLatin1Char(' ') + lead.lastName()).trimmed();
+        }
+        return QString();
+    case DetailsType::Campaign:
+        return item.hasPayload<SugarCampaign>() ? item.payload<SugarCampaign>().name() : QString();
+    }
+    return QString();
+}
+
+QDateTime QuickOpenIndex::lastModified(DetailsType type, const Akonadi::Item &item)
+{
+    switch (type) {
+    case DetailsType::Account:
+        return item.hasPayload<SugarAccount>() ? item.payload<SugarAccount>().dateModified() : QDateTime();
+    case DetailsType::Opportunity:
+        return item.hasPayload<SugarOpportunity>() ? item.payload<SugarOpportunity>().dateModified() : QDateTime();
+    case DetailsType::Contact:
+        if (item.hasPayload<KContacts::Addressee>()) {
+            return KDCRMUtils::dateTimeFromString(SugarContactWrapper(item.payload<KContacts::Addressee>()).dateModified());
+        }
+        return QDateTime();
+    case DetailsType::Lead:
+        return item.hasPayload<SugarLead>() ? KDCRMUtils::dateTimeFromString(item.payload<SugarLead>().dateModified()) : QDateTime();
+    case DetailsType::Campaign:
+        return item.hasPayload<SugarCampaign>() ? KDCRMUtils::dateTimeFromString(item.payload<SugarCampaign>().dateModified()) : QDateTime();
+    }
+    return QDateTime();
+}
+
+void QuickOpenIndex::addRows(DetailsType type, QAbstractItemModel *model, const QModelIndex &parent, int first, int last)
+{
+    for (int row = first; row <= last; ++row) {
+        insertItem(type, itemAt(model, parent, row));
+    }
+}
+
+void QuickOpenIndex::removeRows(QAbstractItemModel *model, const QModelIndex &parent, int first, int last)
+{
+    QVector<int> removedSlots;
+    for (int row = first; row <= last; ++row) {
+        const auto it = mSlots.constFind(itemAt(model, parent, row).id());
+        if (it != mSlots.constEnd()) {
+            removedSlots.append(*it);
+        }
+    }
+    removeRecords(removedSlots);
+}
+
+void QuickOpenIndex::updateRows(DetailsType type, QAbstractItemModel *model, const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    // insertItem() replaces the record if the name, id or modification date changed
+    addRows(type, model, topLeft.parent(), topLeft.row(), bottomRight.row());
+}
+
+void QuickOpenIndex::rebuild(DetailsType type, QAbstractItemModel *model)
+{
+    removeType(type);
+    const int count = model->rowCount();
+    if (count > 0) {
+        addRows(type, model, QModelIndex(), 0, count - 1);
+    }
+}
+
+void QuickOpenIndex::removeType(DetailsType type)
+{
+    QVector<int> removedSlots;
+    for (int slot = 0; slot < mRecords.count(); ++slot) {
+        const Record &record = mRecords.at(slot);
+        if (record.itemId >= 0 && record.type == type) {
+            removedSlots.append(slot);
+        }
+    }
+    removeRecords(removedSlots);
+}
+
+void QuickOpenIndex::insertItem(DetailsType type, const Akonadi::Item &item)
+{
+    if (!item.isValid()) {
+        return;
+    }
+    Record record;
+    record.type = type;
+    record.itemId = item.id();
+    record.id = mIdExtractors.at(int(type))->idForItem(item);
+    record.name = displayName(type, item);
+    const QDateTime modified = lastModified(type, item);
+    record.modified = modified.isValid() ? modified.toMSecsSinceEpoch() : 0;
+
+    const auto it = mSlots.constFind(item.id());
+    if (it != mSlots.constEnd()) {
+        const Record &existing = mRecords.at(*it);
+        if (existing.id == record.id && existing.name == record.name && existing.modified == record.modified) {
+            return;
+        }
+        removeRecord(*it);
+    }
+    // Items created locally can only be opened once they have an id from the server
+    if (record.id.isEmpty()) {
+        return;
+    }
+    record.normalizedName = normalize(record.name);
+    if (!record.normalizedName.isEmpty()) {
+        insertRecord(std::move(record));
+    }
+}
+
+void QuickOpenIndex::insertRecord(Record record)
+{
+    const QString &name = record.normalizedName;
+    int wordStart = 0;
+    for (int i = 0; i <= name.size(); ++i) {
+        if (i == name.size() || name.at(i) == QLatin1Char(' ')) {
+            addIndexKeys(name.constData() + wordStart, i - wordStart, record.keys);
+            wordStart = i + 1;
+        }
+    }
+    std::sort(record.keys.begin(), record.keys.end());
+    record.keys.erase(std::unique(record.keys.begin(), record.keys.end()), record.keys.end());
+
+    int slot;
+    if (mFreeSlots.isEmpty()) {
+        slot = mRecords.count();
+        mRecords.append(Record());
+    } else {
+        slot = mFreeSlots.takeLast();
+    }
+    for (quint64 key : qAsConst(record.keys)) {
+        mPostings[key].append(slot);
+    }
+    mSlots.insert(record.itemId, slot);
+    mRecords[slot] = std::move(record);
+}
+
+void QuickOpenIndex::removeRecord(int slot)
+{
+    Record &record = mRecords[slot];
+    for (quint64 key : qAsConst(record.keys)) {
+        const auto it = mPostings.find(key);
+        Q_ASSERT(it != mPostings.end());
+        QVector<int> &postings = *it;
+        const int pos = postings.indexOf(slot);
+        Q_ASSERT(pos >= 0);
+        postings[pos] = postings.last();
+        postings.removeLast();
+        if (postings.isEmpty()) {
+            mPostings.erase(it);
+        }
+    }
+    mSlots.remove(record.itemId);
+    record = Record();
+    record.itemId = -1;
+    mFreeSlots.append(slot);
+}
+
+// Same as removeRecord() for each slot, but each posting list involved is filtered once,
+// instead of being searched once per record
+void QuickOpenIndex::removeRecords(const QVector<int> &removedSlots)
+{
+    if (removedSlots.count() <= 1) {
+        for (int slot : removedSlots) {
+            removeRecord(slot);
+        }
+        return;
+    }
+    std::vector<bool> removed(mRecords.count(), false);
+    QSet<quint64> keys;
+    for (int slot : removedSlots) {
+        removed[slot] = true;
+        for (quint64 key : qAsConst(mRecords.at(slot).keys)) {
+            keys.insert(key);
+        }
+    }
+    for (quint64 key : qAsConst(keys)) {
+        const auto it = mPostings.find(key);
+        Q_ASSERT(it != mPostings.end());
+        QVector<int> &postings = *it;
+        postings.erase(std::remove_if(postings.begin(), postings.end(), [&removed](int slot) { return removed[slot]; }),
+                       postings.end());
+        if (postings.isEmpty()) {
+            mPostings.erase(it);
+        }
+    }
+    for (int slot : removedSlots) {
+        Record &record = mRecords[slot];
+        mSlots.remove(record.itemId);
+        record = Record();
+        record.itemId = -1;
+        mFreeSlots.append(slot);
+    }
+}
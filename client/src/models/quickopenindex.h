@@ -0,0 +1,116 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef QUICKOPENINDEX_H
+#define QUICKOPENINDEX_H
+
+#include "enums.h"
+#include "fatcrmprivate_export.h"
+
+#include <AkonadiCore/Item>
+
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+#include <QVector>
+
+#include <memory>
+#include <vector>
+
+class ItemDataExtractor;
+class QAbstractItemModel;
+class QModelIndex;
+
+/**
+ * Index over the display names of the accounts, contacts, opportunities, leads and campaigns
+ * of all the page models, for the quick-open palette.
+ *
+ * Every word of every name is indexed by its one- and two-letter prefixes and by its trigrams,
+ * in one table shared by all types. A query word shorter than three letters must match the start
+ * of a word, a longer one can match anywhere in a word: the candidates come from the shortest
+ * posting list among the query's keys, and are then checked against the whole query.
+ *
+ * The index is kept up to date from rowsInserted, rowsAboutToBeRemoved, dataChanged and
+ * modelReset, like ItemIdIndex.
+ */
+class FATCRMPRIVATE_EXPORT QuickOpenIndex : public QObject
+{
+    Q_OBJECT
+public:
+    struct Match
+    {
+        DetailsType type;
+        QString id;
+        QString name;
+        QDateTime lastModified;
+    };
+
+    explicit QuickOpenIndex(QObject *parent = nullptr);
+    ~QuickOpenIndex() override;
+
+    // Indexes the items of @p model (one model per type) and follows its changes
+    void addModel(DetailsType type, QAbstractItemModel *model);
+    void removeModel(QAbstractItemModel *model);
+
+    /**
+     * Returns the best matches for @p query: exact names first, then names starting with the query,
+     * then matches at word starts, then the other matches.
+     * Within each group, accounts come first, then contacts, opportunities, leads and campaigns,
+     * and within a type the most recently modified items come first.
+     */
+    QVector<Match> search(const QString &query, int maxResults = 20) const;
+
+    int count() const;
+
+    static QString displayName(DetailsType type, const Akonadi::Item &item);
+    static QDateTime lastModified(DetailsType type, const Akonadi::Item &item);
+
+private:
+    struct Record
+    {
+        DetailsType type;
+        Akonadi::Item::Id itemId;
+        QString id;
+        QString name;
+        QString normalizedName; // case-folded words separated by single spaces
+        qint64 modified; // msecs since epoch, 0 if unknown
+        QVector<quint64> keys;
+    };
+
+    void addRows(DetailsType type, QAbstractItemModel *model, const QModelIndex &parent, int first, int last);
+    void removeRows(QAbstractItemModel *model, const QModelIndex &parent, int first, int last);
+    void updateRows(DetailsType type, QAbstractItemModel *model, const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void rebuild(DetailsType type, QAbstractItemModel *model);
+    void removeType(DetailsType type);
+
+    void insertItem(DetailsType type, const Akonadi::Item &item);
+    void insertRecord(Record record);
+    void removeRecord(int slot);
+    void removeRecords(const QVector<int> &removedSlots);
+
+    std::vector<std::unique_ptr<ItemDataExtractor>> mIdExtractors; // by type
+    QHash<QAbstractItemModel *, DetailsType> mModels;
+    QVector<Record> mRecords; // removed records leave a free slot
+    QVector<int> mFreeSlots;
+    QHash<Akonadi::Item::Id, int> mSlots; // Akonadi item id -> slot in mRecords
+    QHash<quint64, QVector<int>> mPostings; // prefix or trigram key -> slots
+};
+
+#endif // QUICKOPENINDEX_H
@@ -0,0 +1,245 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "savedsearchindex.h"
+#include "clientsettings.h"
+
+#include "kdcrmdata/sugaropportunity.h"
+
+#include <AkonadiCore/EntityTreeModel>
+
+#include <KLocalizedString>
+
+#include <QAbstractItemModel>
+
+#include <algorithm>
+
+static bool matchesSearch(const OpportunityFilterSettings &settings, const SugarOpportunity &opportunity)
+{
+    if (!settings.matches(opportunity)) {
+        return false;
+    }
+    return settings.searchText().isEmpty() || OpportunityFilterSettings::matchesSearchText(opportunity, settings.searchText());
+}
+
+SavedSearchIndex::SavedSearchIndex(QObject *parent)
+    : QObject(parent)
+{
+}
+
+SavedSearchIndex::~SavedSearchIndex()
+{
+}
+
+void SavedSearchIndex::setModel(QAbstractItemModel *model)
+{
+    if (mModel) {
+        disconnect(mModel, nullptr, this, nullptr);
+    }
+    mModel = model;
+    if (mModel) {
+        connect(mModel, &QAbstractItemModel::rowsInserted, this, &SavedSearchIndex::addRows);
+        connect(mModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, &SavedSearchIndex::removeRows);
+        connect(mModel, &QAbstractItemModel::dataChanged, this, &SavedSearchIndex::updateRows);
+        connect(mModel, &QAbstractItemModel::modelReset, this, &SavedSearchIndex::rebuild);
+    }
+    rebuild();
+}
+
+void SavedSearchIndex::setSearches(const QVector<OpportunityFilterSettings> &searches)
+{
+    // Loading a saved search only changes the recently used list, don't recompute everything then
+    const bool unchanged = searches.count() == mSearches.count()
+            && std::equal(searches.constBegin(), searches.constEnd(), mSearches.constBegin(),
+                          [](const OpportunityFilterSettings &settings, const Search &search) {
+        return settings.searchName() == search.settings.searchName()
+                && settings.searchText() == search.settings.searchText()
+                && settings.hasSameFilter(search.settings);
+    });
+    if (unchanged) {
+        return;
+    }
+
+    mSearches.clear();
+    mSearches.reserve(searches.count());
+    for (const OpportunityFilterSettings &settings : searches) {
+        mSearches.append({settings, QSet<Akonadi::Item::Id>()});
+    }
+    rebuild();
+    emit searchesChanged();
+}
+
+void SavedSearchIndex::loadSavedSearches()
+{
+    ClientSettings *clientSettings = ClientSettings::self();
+    QVector<OpportunityFilterSettings> searches;
+    const QVector<QString> names = clientSettings->savedSearches();
+    searches.reserve(names.count());
+    for (const QString &name : names) {
+        OpportunityFilterSettings settings;
+        clientSettings->loadSavedSearch(settings, clientSettings->searchPrefixFromName(name));
+        searches.append(effectiveSettings(settings));
+    }
+    setSearches(searches);
+}
+
+QStringList SavedSearchIndex::searchNames() const
+{
+    QStringList names;
+    names.reserve(mSearches.count());
+    for (const Search &search : mSearches) {
+        names.append(search.settings.searchName());
+    }
+    return names;
+}
+
+int SavedSearchIndex::count(const QString &searchName) const
+{
+    for (const Search &search : mSearches) {
+        if (search.settings.searchName() == searchName) {
+            return search.items.count();
+        }
+    }
+    return -1;
+}
+
+const QSet<Akonadi::Item::Id> *SavedSearchIndex::matchingItems(const OpportunityFilterSettings &settings, const QString &filterString) const
+{
+    for (const Search &search : mSearches) {
+        if (search.settings.searchText() == filterString && search.settings.hasSameFilter(settings)) {
+            return &search.items;
+        }
+    }
+    return nullptr;
+}
+
+OpportunityFilterSettings SavedSearchIndex::effectiveSettings(const OpportunityFilterSettings &savedSearch)
+{
+    OpportunityFilterSettings settings = savedSearch;
+    ClientSettings *clientSettings = ClientSettings::self();
+
+    // Same radio button logic as OpportunityFilterWidget::setupFromConfig: country wins over assignee
+    QStringList assignees;
+    QStringList countries;
+    if (!savedSearch.countries().isEmpty()) {
+        const QVector<ClientSettings::GroupFilters::Group> groups = clientSettings->countryFilters().groups();
+        const auto it = std::find_if(groups.constBegin(), groups.constEnd(),
+                                     [&savedSearch](const ClientSettings::GroupFilters::Group &group) {
+            return group.group == savedSearch.countryGroup(); });
+        if (it != groups.constEnd()) {
+            countries = it->entries;
+        } else if (groups.isEmpty() || savedSearch.countryGroup() == i18n("Other")) {
+            countries << OpportunityFilterSettings::otherCountriesSpecialValue();
+        } else {
+            countries = groups.first().entries; // the combobox falls back to the first group
+        }
+    } else if (!savedSearch.assignees().isEmpty()) {
+        const QVector<ClientSettings::GroupFilters::Group> groups = clientSettings->assigneeFilters().groups();
+        const auto it = std::find_if(groups.constBegin(), groups.constEnd(),
+                                     [&savedSearch](const ClientSettings::GroupFilters::Group &group) {
+            return group.group == savedSearch.assigneeGroup(); });
+        if (it != groups.constEnd() && savedSearch.assigneeGroup() != i18n("Me")) {
+            assignees = it->entries;
+        } else {
+            assignees << clientSettings->fullUserName();
+        }
+    }
+    settings.setAssignees(assignees, savedSearch.assigneeGroup());
+    settings.setCountries(countries, savedSearch.countryGroup());
+
+    settings.setMaxDate(OpportunityFilterSettings::maxDateForIndex(MaxNextStepDate(savedSearch.maxDateIndex()), savedSearch.customMaxDate()),
+                        savedSearch.maxDateIndex());
+    if (savedSearch.shownPriority().isEmpty()) {
+        settings.setShownPriority(QStringLiteral("-"));
+    }
+    return settings;
+}
+
+void SavedSearchIndex::rebuild()
+{
+    for (Search &search : mSearches) {
+        search.items.clear();
+    }
+    if (mModel && !mSearches.isEmpty()) {
+        const int count = mModel->rowCount();
+        if (count > 0) {
+            addRows(QModelIndex(), 0, count - 1);
+        }
+    }
+}
+
+void SavedSearchIndex::addRows(const QModelIndex &parent, int first, int last)
+{
+    if (mSearches.isEmpty()) {
+        return;
+    }
+    for (int row = first; row <= last; ++row) {
+        const Akonadi::Item item = itemAt(parent, row);
+        if (!item.hasPayload<SugarOpportunity>()) {
+            continue;
+        }
+        const SugarOpportunity opportunity = item.payload<SugarOpportunity>();
+        for (Search &search : mSearches) {
+            if (matchesSearch(search.settings, opportunity)) {
+                search.items.insert(item.id());
+            }
+        }
+    }
+}
+
+void SavedSearchIndex::removeRows(const QModelIndex &parent, int first, int last)
+{
+    if (mSearches.isEmpty()) {
+        return;
+    }
+    for (int row = first; row <= last; ++row) {
+        const Akonadi::Item::Id id = itemAt(parent, row).id();
+        for (Search &search : mSearches) {
+            search.items.remove(id);
+        }
+    }
+}
+
+void SavedSearchIndex::updateRows(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    if (mSearches.isEmpty()) {
+        return;
+    }
+    const QModelIndex parent = topLeft.parent();
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        const Akonadi::Item item = itemAt(parent, row);
+        if (!item.hasPayload<SugarOpportunity>()) {
+            continue;
+        }
+        const SugarOpportunity opportunity = item.payload<SugarOpportunity>();
+        for (Search &search : mSearches) {
+            if (matchesSearch(search.settings, opportunity)) {
+                search.items.insert(item.id());
+            } else {
+                search.items.remove(item.id());
+            }
+        }
+    }
+}
+
+Akonadi::Item SavedSearchIndex::itemAt(const QModelIndex &parent, int row) const
+{
+    return mModel->index(row, 0, parent).data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>();
+}
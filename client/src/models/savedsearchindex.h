@@ -0,0 +1,96 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SAVEDSEARCHINDEX_H
+#define SAVEDSEARCHINDEX_H
+
+#include "fatcrmprivate_export.h"
+#include "opportunityfiltersettings.h"
+
+#include <AkonadiCore/Item>
+
+#include <QObject>
+#include <QSet>
+#include <QVector>
+
+class QAbstractItemModel;
+class QModelIndex;
+
+/**
+ * Keeps the result set of every saved search (the opportunities it matches, by Akonadi id),
+ * so that the number of matches can be shown without filtering, and switching to a saved search
+ * doesn't need to run the filter on all opportunities again (see OpportunityFilterProxyModel).
+ *
+ * The sets are kept up to date from rowsInserted, rowsAboutToBeRemoved, dataChanged and modelReset.
+ * Changes to accounts (name, country) are covered too, since ItemsTreeModel emits dataChanged
+ * for the opportunities of a modified account.
+ */
+class FATCRMPRIVATE_EXPORT SavedSearchIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SavedSearchIndex(QObject *parent = nullptr);
+    ~SavedSearchIndex() override;
+
+    void setModel(QAbstractItemModel *model);
+
+    /// Sets the saved searches to materialize. The filters must be effective ones (see effectiveSettings),
+    /// the search text and the name are taken from the settings as well.
+    void setSearches(const QVector<OpportunityFilterSettings> &searches);
+
+    QStringList searchNames() const;
+
+    /// Returns the number of opportunities matching the saved search @p searchName, or -1 if unknown
+    int count(const QString &searchName) const;
+
+    /// Returns the result set of the saved search which filters exactly like @p settings
+    /// with @p filterString as search text, or nullptr if there's none
+    const QSet<Akonadi::Item::Id> *matchingItems(const OpportunityFilterSettings &settings, const QString &filterString) const;
+
+    /// Resolves the assignee and country groups and the max next step date of a saved search
+    /// the way OpportunityFilterWidget does when loading it
+    static OpportunityFilterSettings effectiveSettings(const OpportunityFilterSettings &savedSearch);
+
+public Q_SLOTS:
+    /// (Re)loads the saved searches from ClientSettings
+    void loadSavedSearches();
+
+Q_SIGNALS:
+    /// Emitted when the list of saved searches changed (not for changes in their result sets)
+    void searchesChanged();
+
+private:
+    struct Search
+    {
+        OpportunityFilterSettings settings;
+        QSet<Akonadi::Item::Id> items;
+    };
+
+    void rebuild();
+    void addRows(const QModelIndex &parent, int first, int last);
+    void removeRows(const QModelIndex &parent, int first, int last);
+    void updateRows(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    Akonadi::Item itemAt(const QModelIndex &parent, int row) const;
+
+    QAbstractItemModel *mModel = nullptr;
+    QVector<Search> mSearches;
+};
+
+#endif // SAVEDSEARCHINDEX_H
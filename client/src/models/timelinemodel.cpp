@@ -0,0 +1,130 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "timelinemodel.h"
+
+#include <QTextDocumentFragment>
+
+#include <algorithm>
+
+// Most recent at the top
+static bool isMoreRecent(const TimelineEntry &left, const TimelineEntry &right)
+{
+    return left.date > right.date;
+}
+
+TimelineModel::TimelineModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+TimelineModel::~TimelineModel()
+{
+}
+
+void TimelineModel::setEntries(const QVector<TimelineEntry> &entries)
+{
+    QVector<TimelineEntry> sorted = entries;
+    std::stable_sort(sorted.begin(), sorted.end(), isMoreRecent);
+
+    beginResetModel();
+    mRows.clear();
+    mRows.reserve(sorted.count());
+    for (const TimelineEntry &entry : qAsConst(sorted)) {
+        mRows.append(Row{entry, mNextLayoutKey++, QString()});
+    }
+    endResetModel();
+}
+
+int TimelineModel::insertEntry(const TimelineEntry &entry)
+{
+    const auto it = std::upper_bound(mRows.constBegin(), mRows.constEnd(), entry, [](const TimelineEntry &value, const Row &row) {
+        return isMoreRecent(value, row.entry);
+    });
+    const int row = it - mRows.constBegin();
+    beginInsertRows(QModelIndex(), row, row);
+    mRows.insert(row, Row{entry, mNextLayoutKey++, QString()});
+    endInsertRows();
+    return row;
+}
+
+void TimelineModel::updateEntry(int row, const TimelineEntry &entry)
+{
+    Q_ASSERT(row >= 0 && row < mRows.count());
+    mRows[row] = Row{entry, mNextLayoutKey++, QString()};
+    const QModelIndex idx = index(row, 0);
+    emit dataChanged(idx, idx);
+}
+
+void TimelineModel::removeEntry(int row)
+{
+    Q_ASSERT(row >= 0 && row < mRows.count());
+    beginRemoveRows(QModelIndex(), row, row);
+    mRows.remove(row);
+    endRemoveRows();
+}
+
+TimelineEntry TimelineModel::entry(int row) const
+{
+    return mRows.value(row).entry;
+}
+
+int TimelineModel::rowForId(const QString &id) const
+{
+    for (int row = 0; row < mRows.count(); ++row) {
+        if (mRows.at(row).entry.id == id)
+            return row;
+    }
+    return -1;
+}
+
+int TimelineModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : mRows.count();
+}
+
+QVariant TimelineModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= mRows.count())
+        return QVariant();
+    const Row &row = mRows.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole: // what filtering proxies search into
+        if (row.plainText.isNull()) {
+            // Converted on the first search only, opening the window must not parse all the HTML
+            const QString text = row.entry.isHtml ? QTextDocumentFragment::fromHtml(row.entry.text).toPlainText() : row.entry.text;
+            row.plainText = QTextDocumentFragment::fromHtml(row.entry.htmlHeader).toPlainText() + QLatin1Char('\n') + text;
+        }
+        return row.plainText;
+    case HtmlHeaderRole:
+        return row.entry.htmlHeader;
+    case TextRole:
+        return row.entry.text;
+    case IsHtmlRole:
+        return row.entry.isHtml;
+    case DateRole:
+        return row.entry.date;
+    case IdRole:
+        return row.entry.id;
+    case LayoutKeyRole:
+        return row.layoutKey;
+    }
+    return QVariant();
+}
@@ -0,0 +1,87 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef TIMELINEMODEL_H
+#define TIMELINEMODEL_H
+
+#include "fatcrmprivate_export.h"
+
+#include <QAbstractListModel>
+#include <QDateTime>
+#include <QVector>
+
+// One entry of a timeline: a note, an email, a document...
+struct TimelineEntry
+{
+    QString id; // identifies the entry for the window using the model, e.g. a document id
+    QDateTime date;
+    QString htmlHeader;
+    QString text;
+    bool isHtml = false; // whether text is HTML or plain text
+};
+
+/**
+ * A list of timeline entries, most recent first, to be shown by a TimelineDelegate.
+ *
+ * The model only stores the strings: laying them out is left to the delegate,
+ * which only does it for the visible rows.
+ * Qt::DisplayRole is the header and text as plain text, for filtering proxies.
+ */
+class FATCRMPRIVATE_EXPORT TimelineModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum Roles {
+        HtmlHeaderRole = Qt::UserRole + 1,
+        TextRole,
+        IsHtmlRole,
+        DateRole,
+        IdRole,
+        LayoutKeyRole // changes whenever the entry changes, for caching the layouts of entries
+    };
+    Q_ENUM(Roles)
+
+    explicit TimelineModel(QObject *parent = nullptr);
+    ~TimelineModel() override;
+
+    void setEntries(const QVector<TimelineEntry> &entries);
+    // Inserts the entry at its position by date, and returns its row
+    int insertEntry(const TimelineEntry &entry);
+    void updateEntry(int row, const TimelineEntry &entry);
+    void removeEntry(int row);
+
+    TimelineEntry entry(int row) const;
+    int rowForId(const QString &id) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+
+private:
+    struct Row
+    {
+        TimelineEntry entry;
+        quint64 layoutKey;
+        mutable QString plainText; // header and text without markup, for searching
+    };
+    QVector<Row> mRows;
+    quint64 mNextLayoutKey = 1;
+};
+
+#endif // TIMELINEMODEL_H
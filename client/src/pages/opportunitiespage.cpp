@@ -28,10 +28,12 @@
 #include "opportunityfilterwidget.h"
 #include "opportunityfilterproxymodel.h"
 #include "referenceddata.h"
+#include "savedsearchindex.h"
 #include "fatcrm_client_debug.h"
 #include "clientsettings.h"
 
 #include "kdcrmdata/kdcrmfields.h"
+#include "kdcrmdata/kdcrmtrace.h"
 #include "kdcrmdata/kdcrmutils.h"
 #include "kdcrmdata/sugaropportunity.h"
 
@@ -103,6 +105,19 @@ OpportunitiesPage::OpportunitiesPage(QWidget *parent)
     insertFilterWidget(mFilterUiWidget);
 
     connect(mFilterUiWidget, &OpportunityFilterWidget::filterUpdated, this, &OpportunitiesPage::slotDefaultOppFilterUpdated);
+
+    // Keep the result sets of the saved searches, for their counts and to switch between them quickly
+    SavedSearchIndex *savedSearchIndex = mOppFilterProxyModel->savedSearchIndex();
+    savedSearchIndex->loadSavedSearches();
+    connect(ClientSettings::self(), &ClientSettings::recentSearchesUpdated, savedSearchIndex, &SavedSearchIndex::loadSavedSearches);
+    connect(ClientSettings::self(), &ClientSettings::assigneeFiltersChanged, savedSearchIndex, &SavedSearchIndex::loadSavedSearches);
+    connect(ClientSettings::self(), &ClientSettings::countryFiltersChanged, savedSearchIndex, &SavedSearchIndex::loadSavedSearches);
+
+    // Cold (old, closed) opportunities are only indexed once the filter shows closed opportunities
+    mArchiveTiering = ClientSettings::self()->archiveTiering();
+    const OpportunityFilterSettings filterSettings = ClientSettings::self()->filterSettings();
+    mColdOpportunitiesIndexed = !mArchiveTiering.isEnabled() ||
+            filterSettings.showClosedWon() || filterSettings.showClosedLost();
 }
 
 OpportunitiesPage::~OpportunitiesPage()
@@ -141,6 +156,9 @@ void OpportunitiesPage::handleNewRows(int start, int end, bool emitChanges)
         const Item item = treeModel->data(index, EntityTreeModel::ItemRole).value<Item>();
         if (item.hasPayload<SugarOpportunity>()) {
             const SugarOpportunity opportunity = item.payload<SugarOpportunity>();
+            if (!mColdOpportunitiesIndexed && mArchiveTiering.isCold(opportunity)) {
+                continue; // see indexColdOpportunities()
+            }
             assignedToRefMap.insert(opportunity.assignedUserId(), opportunity.assignedUserName());
             linkedItemsRepository()->addOpportunity(opportunity);
         }
@@ -148,6 +166,31 @@ void OpportunitiesPage::handleNewRows(int start, int end, bool emitChanges)
     ReferencedData::instance(AssignedToRef)->addMap(assignedToRefMap, emitChanges);
 }
 
+void OpportunitiesPage::indexColdOpportunities()
+{
+    FATCRM_TRACE_SCOPE("client", "OpportunitiesPage::indexColdOpportunities");
+    mColdOpportunitiesIndexed = true;
+    ItemsTreeModel *treeModel = itemsTreeModel();
+    if (!treeModel) {
+        return;
+    }
+    QMap<QString, QString> assignedToRefMap;
+    const int rowCount = treeModel->rowCount();
+    for (int row = 0; row < rowCount; ++row) {
+        const QModelIndex index = treeModel->index(row, 0);
+        const Item item = treeModel->data(index, EntityTreeModel::ItemRole).value<Item>();
+        if (item.hasPayload<SugarOpportunity>()) {
+            const SugarOpportunity opportunity = item.payload<SugarOpportunity>();
+            if (mArchiveTiering.isCold(opportunity)) {
+                assignedToRefMap.insert(opportunity.assignedUserId(), opportunity.assignedUserName());
+                linkedItemsRepository()->addOpportunity(opportunity);
+            }
+        }
+    }
+    qCDebug(FATCRM_CLIENT_LOG) << "Indexed the archived opportunities, from" << rowCount << "rows";
+    ReferencedData::instance(AssignedToRef)->addMap(assignedToRefMap, true);
+}
+
 void OpportunitiesPage::handleRemovedRows(int start, int end, bool initialLoadingDone)
 {
     Q_UNUSED(initialLoadingDone);
@@ -201,6 +244,11 @@ void OpportunitiesPage::loadSearch(const QString &searchPrefix)
     mFilterUiWidget->loadSearch(searchPrefix);
 }
 
+SavedSearchIndex *OpportunitiesPage::savedSearchIndex() const
+{
+    return mOppFilterProxyModel->savedSearchIndex();
+}
+
 ItemDataExtractor *OpportunitiesPage::itemDataExtractor() const
 {
     return mDataExtractor.get();
@@ -209,6 +257,9 @@ ItemDataExtractor *OpportunitiesPage::itemDataExtractor() const
 void OpportunitiesPage::slotDefaultOppFilterUpdated(const OpportunityFilterSettings &settings)
 {
     ClientSettings::self()->setFilterSettings(settings);
+    if (!mColdOpportunitiesIndexed && (settings.showClosedWon() || settings.showClosedLost())) {
+        indexColdOpportunities();
+    }
 }
 
 #include "opportunitiespage.moc"
@@ -24,11 +24,13 @@
 #define OPPORTUNITIESPAGE_H
 
 #include "page.h"
+#include "archivetiering.h"
 
 class OpportunityFilterWidget;
 class OpportunityFilterProxyModel;
 class OpportunityFilterSettings;
 class OpportunityDataExtractor;
+class SavedSearchIndex;
 
 class OpportunitiesPage : public Page
 {
@@ -45,6 +47,8 @@ public:
     void saveSearch();
     void loadSearch(const QString &searchPrefix);
 
+    SavedSearchIndex *savedSearchIndex() const;
+
 public slots:
     void createOpportunity(const QString &accountId);
 
@@ -57,9 +61,13 @@ protected:
     void handleItemChanged(const Akonadi::Item &item) override;
 
 private:
+    void indexColdOpportunities();
+
     OpportunityFilterWidget *mFilterUiWidget;
     OpportunityFilterProxyModel *mOppFilterProxyModel;
     std::unique_ptr<OpportunityDataExtractor> mDataExtractor;
+    ArchiveTiering mArchiveTiering;
+    bool mColdOpportunitiesIndexed;
 
 private slots:
     void slotDefaultOppFilterUpdated(const OpportunityFilterSettings &settings);
@@ -31,6 +31,7 @@
 
 #include <QCalendarWidget>
 #include <QDate>
+#include <QScopedValueRollback>
 
 OpportunityFilterWidget::OpportunityFilterWidget(OpportunityFilterProxyModel *oppFilterProxyModel,
                                                  QWidget *parent) :
@@ -77,33 +78,37 @@ OpportunityFilterWidget::~OpportunityFilterWidget()
 
 void OpportunityFilterWidget::setupFromConfig(const OpportunityFilterSettings &settings)
 {
-    ui->cbAssignee->clear();
-    ui->cbAssignee->addItem(i18n("Me"));
-    ui->cbAssignee->insertSeparator(1);
-    ui->cbAssignee->addItems(ClientSettings::self()->assigneeFilters().groupNames());
-    ui->cbCountry->clear();
-    ui->cbCountry->addItems(ClientSettings::self()->countryFilters().groupNames());
-    ui->cbCountry->addItem(i18n("Other"));
-    if (settings.assigneeGroup().isEmpty()) {
-        ui->cbAssignee->setCurrentIndex(0); // "Me"
-    } else {
-        ui->cbAssignee->setCurrentIndex(qMax(0, ui->cbAssignee->findText(settings.assigneeGroup())));
-    }
-    ui->cbCountry->setCurrentIndex(qMax(0, ui->cbCountry->findText(settings.countryGroup())));
-    ui->cbOpen->setChecked(settings.showOpen());
-    ui->cbClosedWon->setChecked(settings.showClosedWon());
-    ui->cbClosedLost->setChecked(settings.showClosedLost());
-    if (settings.customMaxDate().isValid()) {
-        ui->cbMaxNextStepDate->insertItem(CustomDate, settings.customMaxDate().toString(QStringLiteral("MM/d/yyyy")));
-        mCustomMaxNextStepDate = settings.customMaxDate();
+    {
+        // Filter once at the end, rather than for each of the widget changes below
+        const QScopedValueRollback<bool> blocker(mBlockFilterChanges, true);
+        ui->cbAssignee->clear();
+        ui->cbAssignee->addItem(i18n("Me"));
+        ui->cbAssignee->insertSeparator(1);
+        ui->cbAssignee->addItems(ClientSettings::self()->assigneeFilters().groupNames());
+        ui->cbCountry->clear();
+        ui->cbCountry->addItems(ClientSettings::self()->countryFilters().groupNames());
+        ui->cbCountry->addItem(i18n("Other"));
+        if (settings.assigneeGroup().isEmpty()) {
+            ui->cbAssignee->setCurrentIndex(0); // "Me"
+        } else {
+            ui->cbAssignee->setCurrentIndex(qMax(0, ui->cbAssignee->findText(settings.assigneeGroup())));
+        }
+        ui->cbCountry->setCurrentIndex(qMax(0, ui->cbCountry->findText(settings.countryGroup())));
+        ui->cbOpen->setChecked(settings.showOpen());
+        ui->cbClosedWon->setChecked(settings.showClosedWon());
+        ui->cbClosedLost->setChecked(settings.showClosedLost());
+        if (settings.customMaxDate().isValid()) {
+            ui->cbMaxNextStepDate->insertItem(CustomDate, settings.customMaxDate().toString(QStringLiteral("MM/d/yyyy")));
+            mCustomMaxNextStepDate = settings.customMaxDate();
+        }
+        ui->cbMaxNextStepDate->setCurrentIndex(settings.maxDateIndex());
+        ui->modifiedBefore->setDate(settings.modifiedBefore());
+        ui->modifiedAfter->setDate(settings.modifiedAfter());
+        ui->rbAll->setChecked(true); // unless one of the two below gets checked
+        ui->rbAssignedTo->setChecked(!settings.assignees().isEmpty());
+        ui->rbCountry->setChecked(!settings.countries().isEmpty());
+        ui->cbPriority->setCurrentIndex(qMax(0, ui->cbPriority->findText(settings.shownPriority())));
     }
-    ui->cbMaxNextStepDate->setCurrentIndex(settings.maxDateIndex());
-    ui->modifiedBefore->setDate(settings.modifiedBefore());
-    ui->modifiedAfter->setDate(settings.modifiedAfter());
-    ui->rbAll->setChecked(true); // unless one of the two below gets checked
-    ui->rbAssignedTo->setChecked(!settings.assignees().isEmpty());
-    ui->rbCountry->setChecked(!settings.countries().isEmpty());
-    ui->cbPriority->setCurrentIndex(qMax(0, ui->cbPriority->findText(settings.shownPriority())));
 
     filterChanged();
 }
@@ -120,34 +125,10 @@ void OpportunityFilterWidget::slotCountrySelected()
 
 QDate OpportunityFilterWidget::maxNextStepDate() const
 {
-    QDate date = QDate::currentDate();
-    switch (ui->cbMaxNextStepDate->currentIndex()) {
-    case NoDate: // Any
-        date = QDate();
-        break;
-    case OneMonthAgo:
-        date = date.addDays(-31);
-        break;
-    case Today:
-        break;
-    case EndOfThisWeek: // i.e. next Sunday
-        // Ex: dayOfWeek = 3 (Wednesday), must add 4 days.
-        date = date.addDays(7 - date.dayOfWeek());
-        break;
-    case EndOfThisMonth:
-        date = QDate(date.year(), date.month(), date.daysInMonth());
-        break;
-    case OneMonthFromNow:
-        date = date.addDays(31);
-        break;
-    case EndOfThisYear:
-        date = QDate(date.year(), 12, 31);
-        break;
-    case CustomDate: // User selection
-        date = QDate::fromString(ui->cbMaxNextStepDate->currentText(), QStringLiteral("MM/d/yyyy"));
-        break;
-    }
-    return date;
+    const int index = ui->cbMaxNextStepDate->currentIndex();
+    if (index > CustomDate) // "Other...", the calendar is being shown
+        return QDate::currentDate();
+    return OpportunityFilterSettings::maxDateForIndex(MaxNextStepDate(index), mCustomMaxNextStepDate);
 }
 
 int OpportunityFilterWidget::indexForOther() const
@@ -162,6 +143,13 @@ void OpportunityFilterWidget::setFilterSettings(const OpportunityFilterSettings
 
 
 void OpportunityFilterWidget::filterChanged()
+{
+    if (mBlockFilterChanges)
+        return;
+    applyFilter(m_oppFilterProxyModel->filterString());
+}
+
+void OpportunityFilterWidget::applyFilter(const QString &filterString)
 {
     OpportunityFilterSettings filterSettings;
     QStringList assignees;
@@ -204,7 +192,7 @@ void OpportunityFilterWidget::filterChanged()
         connect(calendar, &QObject::destroyed, this, &OpportunityFilterWidget::slotResetMaxNextStepDateIndex);
     }
     filterSettings.setMaxDate(maxNextStepDate(), ui->cbMaxNextStepDate->currentIndex());
-    m_oppFilterProxyModel->setFilter(filterSettings);
+    m_oppFilterProxyModel->setFilter(filterSettings, filterString);
 
     emit filterUpdated(filterSettings);
     setFilterSettings(filterSettings);
@@ -261,7 +249,12 @@ void OpportunityFilterWidget::loadSearch(const QString &searchPrefix)
 {
     OpportunityFilterSettings settings;
     ClientSettings::self()->loadSavedSearch(settings, searchPrefix);
-    setupFromConfig(settings);
+    {
+        const QScopedValueRollback<bool> blocker(mBlockFilterChanges, true);
+        setupFromConfig(settings);
+    }
+    // Filter with the search text right away: a single pass, which can use the result set of the saved search
+    applyFilter(settings.searchText());
 
     setSearchName(settings.searchName());
     setSearchText(settings.searchText());
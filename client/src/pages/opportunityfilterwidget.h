@@ -66,6 +66,7 @@ private Q_SLOTS:
     void slotResetMaxNextStepDateIndex();
 
 private:
+    void applyFilter(const QString &filterString);
     QDate maxNextStepDate() const;
     int indexForOther() const;
     void setFilterSettings(const OpportunityFilterSettings &filterSettings);
@@ -78,6 +79,7 @@ private:
     QString mSearchPrefix;
     QString mSearchName;
     QString mSearchText;
+    bool mBlockFilterChanges = false;
 };
 
 #endif // OPPORTUNITYFILTERWIDGET_H
@@ -29,6 +29,8 @@
 #include "fatcrminputdialog.h"
 #include "itemdataextractor.h"
 #include "itemeditwidgetbase.h"
+#include "itemexporter.h"
+#include "itemfetchscopes.h"
 #include "kjobprogresstracker.h"
 #include "modelrepository.h"
 #include "openedwidgetsrepository.h"
@@ -42,11 +44,13 @@
 #include "createlinksproxymodel.h"
 #include "fatcrm_client_debug.h"
 
+#include "kdcrmdata/kdcrmtrace.h"
 #include "kdcrmdata/kdcrmutils.h"
 #include "kdcrmdata/sugaraccount.h"
 #include "kdcrmdata/sugaropportunity.h"
 #include "kdcrmdata/sugarcampaign.h"
 #include "kdcrmdata/sugarlead.h"
+#include "kdcrmdata/syncbaseattribute.h"
 
 #include <KDReportsReport.h>
 
@@ -165,20 +169,13 @@ Page::~Page()
 
 void Page::openWidget(const QString &id)
 {
-    ItemDataExtractor *dataExtractor = itemDataExtractor();
-    if (!dataExtractor) {
-        return;
-    }
-    const int count = mItemsTreeModel->rowCount();
-    for (int i = 0; i < count; ++i) {
-        const QModelIndex index = mItemsTreeModel->index(i, 0);
+    const QModelIndex index = mItemsTreeModel->indexForId(id);
+    if (index.isValid()) {
         const Item item = mItemsTreeModel->data(index, EntityTreeModel::ItemRole).value<Item>();
-        if (dataExtractor->idForItem(item) == id) {
-            openWidgetForItem(item, mType);
-            return;
-        }
+        openWidgetForItem(item, mType);
+        return;
     }
-    qCWarning(FATCRM_CLIENT_LOG) << this << "(" << typeToString(mType) << ") Object not found:" << id << "among" << count << "rows";
+    qCWarning(FATCRM_CLIENT_LOG) << this << "(" << typeToString(mType) << ") Object not found:" << id << "among" << mItemsTreeModel->rowCount() << "rows";
 }
 
 void Page::openWidgetForItem(const Item &item, DetailsType itemType)
@@ -265,10 +262,8 @@ void Page::setCollection(const Collection &collection)
 
         mChangeRecorder = new ChangeRecorder(this);
         mChangeRecorder->setCollectionMonitored(mCollection, true);
-        // automatically get the full data when items change
-        mChangeRecorder->itemFetchScope().fetchFullPayload(true);
-        // don't get remote id/rev, to avoid errors in the FATCRM-75 case
-        mChangeRecorder->itemFetchScope().setFetchRemoteIdentification(false);
+        // automatically get the full data when items change, but nothing we don't use
+        ItemFetchScopes::configure(mChangeRecorder->itemFetchScope(), ItemFetchScopes::PageModel);
         mChangeRecorder->setMimeTypeMonitored(mMimeType);
         connect(mChangeRecorder, SIGNAL(collectionChanged(Akonadi::Collection,QSet<QByteArray>)),
                 this, SLOT(slotCollectionChanged(Akonadi::Collection,QSet<QByteArray>)));
@@ -362,6 +357,7 @@ void Page::slotAnonymizeItems()
 
     for (Item &item : items) {
         Q_ASSERT(item.hasPayload<KContacts::Addressee>());
+        SyncBaseAttribute::storeBase(item);
         KContacts::Addressee contact = item.payload<KContacts::Addressee>();
 
         contact.setGivenName("Anonymized");
@@ -446,7 +442,13 @@ void Page::slotRowsInserted(const QModelIndex &, int start, int end)
 {
     const bool emitChanges = mInitialLoadingDone;
 
-    handleNewRows(start, end, emitChanges);
+    ItemFetchScopes::audit(typeToString(mType), mItemsTreeModel, start, end);
+    {
+        FATCRM_TRACE_SCOPE("client", "Page::handleNewRows");
+        FATCRM_TRACE_SET_COUNT(end - start + 1);
+        FATCRM_TRACE_SET_DETAIL(typeToString(mType));
+        handleNewRows(start, end, emitChanges);
+    }
 
     if (!mInitialLoadingDone)
         slotCheckCollectionPopulated(mCollection.id());
@@ -467,6 +469,7 @@ void Page::slotCheckCollectionPopulated(Akonadi::Collection::Id id)
             mUi->treeView->setCurrentIndex(mUi->treeView->model()->index(0, 0));
         }
         mInitialLoadingDone = true;
+        FATCRM_TRACE_ASYNC_END("akonadi", "Page collection fetch", mCollection.id());
         // Move to the next model
         //emit modelLoaded(mType, i18n("%1 %2 loaded", mItemsTreeModel->rowCount(), typeToString(mType)));
         emit modelLoaded(mType);
@@ -618,6 +621,7 @@ void Page::setupModel()
     mItemsTreeModel->setLinkedItemsRepository(mLinkedItemsRepository);
     mItemsTreeModel->setCollectionManager(mCollectionManager); // for enum definitions
 
+    FATCRM_TRACE_ASYNC_BEGIN("akonadi", "Page collection fetch", mCollection.id());
     connect(mItemsTreeModel, &QAbstractItemModel::rowsInserted, this, &Page::slotRowsInserted);
     connect(mItemsTreeModel, &EntityTreeModel::collectionPopulated, this, &Page::slotCheckCollectionPopulated);
     connect(mItemsTreeModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, &Page::slotRowsAboutToBeRemoved);
@@ -759,16 +763,12 @@ void Page::exportToCSV(const QString &fileName) const
     const int rows = rearrangeColumnsProxy.rowCount();
     const int columns = rearrangeColumnsProxy.columnCount();
     for (int row = 0 ; row < rows ; ++row) {
-        QString line;
+        QStringList cells;
+        cells.reserve(columns);
         for (int column = 0 ; column < columns ; ++column) {
-            QString str = rearrangeColumnsProxy.index(row, column).data().toString();
-            if (str.contains(',')) {
-                str = '"' + str + '"';
-            }
-            line += str + ",";
+            cells.append(rearrangeColumnsProxy.index(row, column).data().toString());
         }
-        line += '\n';
-        file.write(line.toUtf8());
+        file.write(ItemExporter::csvLine(cells).toUtf8());
     }
 }
 
@@ -906,6 +906,7 @@ void Page::slotChangeFields()
 
     Q_FOREACH (const QModelIndex &index, selectedIndexes) {
         Item item = index.data(EntityTreeModel::ItemRole).value<Item>();
+        SyncBaseAttribute::storeBase(item);
 
         if (mType == DetailsType::Account) {
             Q_ASSERT(item.hasPayload<SugarAccount>());
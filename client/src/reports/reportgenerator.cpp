@@ -22,6 +22,8 @@
 
 #include "reportgenerator.h"
 
+#include "kdcrmdata/kdcrmtrace.h"
+
 #include <KDReportsReport.h>
 #include <KDReportsHeader.h>
 #include <KDReportsTextElement.h>
@@ -79,6 +81,8 @@ void ReportGenerator::addHeader(KDReports::Report &report)
 std::unique_ptr<KDReports::Report> ReportGenerator::generateListReport(QAbstractItemModel *model, const QString &title,
                                          const QString &subTitle)
 {
+    FATCRM_TRACE_SCOPE("client", "ReportGenerator::generateListReport");
+    FATCRM_TRACE_SET_COUNT(model->rowCount());
     auto report = std::unique_ptr<KDReports::Report>(new KDReports::Report);
 
     setupReport(*report);
@@ -21,6 +21,8 @@
 */
 
 #include "accountrepository.h"
+#include "memoryreport.h"
+#include "kdcrmdata/kdcrmutils.h"
 
 #include "fatcrm_client_debug.h"
 
@@ -157,6 +159,23 @@ void AccountRepository::emitInitialLoadingDone()
     emit initialLoadingDone();
 }
 
+void AccountRepository::addToMemoryReport(MemoryReport &report) const
+{
+    // The three maps share the accounts, only their nodes and keys are counted three times
+    const qint64 nodeSize = 3 * qint64(sizeof(void *)) + qint64(sizeof(QString)) + qint64(sizeof(SugarAccount));
+    qint64 size = 0;
+    for (auto it = mIdMap.cbegin(); it != mIdMap.cend(); ++it) {
+        size += it.value().estimatedMemoryUsage();
+    }
+    for (const Map *map : { &mIdMap, &mKeyMap, &mNameMap }) {
+        size += map->count() * nodeSize;
+        for (auto it = map->cbegin(); it != map->cend(); ++it) {
+            size += KDCRMUtils::memoryUsage(it.key());
+        }
+    }
+    report.add(QStringLiteral("Account repository"), mIdMap.count(), size);
+}
+
 AccountRepository::AccountRepository()
 {
 }
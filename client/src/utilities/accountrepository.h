@@ -31,6 +31,8 @@
 
 #include <AkonadiCore/item.h>
 
+class MemoryReport;
+
 class FATCRMPRIVATE_EXPORT AccountRepository : public QObject
 {
     Q_OBJECT
@@ -62,6 +64,8 @@ public:
 
     void emitInitialLoadingDone();
 
+    void addToMemoryReport(MemoryReport &report) const;
+
 signals:
     void initialLoadingDone();
 
@@ -0,0 +1,85 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "archivetiering.h"
+
+#include "kdcrmdata/kdcrmutils.h"
+#include "kdcrmdata/sugaropportunity.h"
+
+#include <algorithm>
+
+ArchiveTiering::ArchiveTiering()
+    : mReferenceDate(QDate::currentDate())
+{
+    updateCutoff();
+}
+
+void ArchiveTiering::setEnabled(bool enabled)
+{
+    mEnabled = enabled;
+}
+
+void ArchiveTiering::setCutoffMonths(int months)
+{
+    mCutoffMonths = qMax(1, months);
+    updateCutoff();
+}
+
+void ArchiveTiering::setReferenceDate(const QDate &date)
+{
+    mReferenceDate = date;
+    updateCutoff();
+}
+
+bool ArchiveTiering::isColdRevision(const QString &remoteRevision) const
+{
+    // Items without a revision (e.g. just created locally) are always hot
+    return mEnabled && !remoteRevision.isEmpty() && remoteRevision < mCutoffRevision;
+}
+
+bool ArchiveTiering::isCold(const SugarOpportunity &opportunity) const
+{
+    if (!mEnabled || !opportunity.salesStage().contains(QLatin1String("Closed"))) {
+        return false;
+    }
+    const QDateTime modified = opportunity.dateModified();
+    return modified.isValid() && modified < mCutoff;
+}
+
+Akonadi::Item::List ArchiveTiering::takeColdItems(Akonadi::Item::List &items) const
+{
+    Akonadi::Item::List cold;
+    if (!mEnabled) {
+        return cold;
+    }
+    auto firstCold = std::stable_partition(items.begin(), items.end(), [this](const Akonadi::Item &item) {
+        return !isColdRevision(item.remoteRevision());
+    });
+    const int hotCount = static_cast<int>(std::distance(items.begin(), firstCold));
+    cold = items.mid(hotCount);
+    items.erase(firstCold, items.end());
+    return cold;
+}
+
+void ArchiveTiering::updateCutoff()
+{
+    mCutoff = QDateTime(mReferenceDate.addMonths(-mCutoffMonths), QTime(0, 0), Qt::UTC);
+    mCutoffRevision = KDCRMUtils::dateTimeToString(mCutoff);
+}
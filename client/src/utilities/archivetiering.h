@@ -0,0 +1,77 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ARCHIVETIERING_H
+#define ARCHIVETIERING_H
+
+#include "fatcrmprivate_export.h"
+
+#include <AkonadiCore/Item>
+
+#include <QDate>
+#include <QDateTime>
+#include <QString>
+
+class SugarOpportunity;
+
+/**
+ * Splits opportunities, notes and emails into a "hot" tier, loaded at startup,
+ * and a "cold" tier (closed opportunities and history older than the cutoff),
+ * which stays in the Akonadi cache and is only loaded when asked for.
+ *
+ * Disabled by default, see ClientSettings::archiveTiering().
+ */
+class FATCRMPRIVATE_EXPORT ArchiveTiering
+{
+public:
+    ArchiveTiering();
+
+    bool isEnabled() const { return mEnabled; }
+    void setEnabled(bool enabled);
+
+    int cutoffMonths() const { return mCutoffMonths; }
+    void setCutoffMonths(int months);
+
+    // The cutoff is computed from today's date, unless another one is set (for tests)
+    void setReferenceDate(const QDate &date);
+    QDateTime cutoff() const { return mCutoff; }
+
+    // For notes and emails, whose remote revision is their modification date
+    bool isColdRevision(const QString &remoteRevision) const;
+    // Only closed (won or lost) opportunities can be cold
+    bool isCold(const SugarOpportunity &opportunity) const;
+
+    /**
+     * Removes the cold items from @p items and returns them.
+     * The items only need their remote revision, so this works on items fetched without payload.
+     */
+    Akonadi::Item::List takeColdItems(Akonadi::Item::List &items) const;
+
+private:
+    void updateCutoff();
+
+    bool mEnabled = false;
+    int mCutoffMonths = 24;
+    QDate mReferenceDate;
+    QDateTime mCutoff;
+    QString mCutoffRevision; // mCutoff in the remote revision format, which sorts like the dates
+};
+
+#endif // ARCHIVETIERING_H
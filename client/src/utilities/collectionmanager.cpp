@@ -25,6 +25,7 @@
 #include "fatcrm_client_debug.h"
 
 #include "kdcrmdata/enumdefinitionattribute.h"
+#include "kdcrmdata/kdcrmtrace.h"
 #include "sugaraccount.h"
 #include "sugarcampaign.h"
 #include "sugarlead.h"
@@ -44,6 +45,12 @@
 
 using namespace Akonadi;
 
+// No message boxes in command line tools like fatcrm-export, the warnings are logged anyway
+static bool canShowMessageBoxes()
+{
+    return qobject_cast<QApplication *>(QCoreApplication::instance()) != nullptr;
+}
+
 CollectionManager::CollectionManager(QObject *parent) :
     QObject(parent)
 {
@@ -57,6 +64,7 @@ void CollectionManager::setResource(const QByteArray &identifier)
      * of the currently selected resource, filtering by MIME type.
      * include statistics to get the number of items in each collection
      */
+    FATCRM_TRACE_ASYNC_BEGIN("akonadi", "CollectionManager collection fetch", 0);
     CollectionFetchJob *job = new CollectionFetchJob(Collection::root(), CollectionFetchJob::Recursive);
     job->fetchScope().setResource(identifier);
     job->fetchScope().setIncludeStatistics(true);
@@ -69,9 +77,16 @@ Akonadi::Collection::Id CollectionManager::collectionIdForType(DetailsType detai
     return mMainCollectionIds.at(int(detailsType));
 }
 
-QStringList CollectionManager::supportedFields(Akonadi::Collection::Id collectionId) const
+SupportedFields CollectionManager::supportedFields(Akonadi::Collection::Id collectionId) const
+{
+    const auto it = mCollectionData.constFind(collectionId);
+    return it == mCollectionData.constEnd() ? SupportedFields() : it->supportedFields;
+}
+
+bool CollectionManager::hasField(Akonadi::Collection::Id collectionId, const QString &field) const
 {
-    return mCollectionData.value(collectionId).supportedFields;
+    const auto it = mCollectionData.constFind(collectionId);
+    return it != mCollectionData.constEnd() && it->supportedFields.contains(field);
 }
 
 EnumDefinitions CollectionManager::enumDefinitions(Akonadi::Collection::Id collectionId) const
@@ -82,8 +97,8 @@ EnumDefinitions CollectionManager::enumDefinitions(Akonadi::Collection::Id colle
 // Called by Page -- note that this means it's never called for Documents, Notes, Emails. If needed one day, then add ChangeRecorders somewhere.
 void CollectionManager::slotCollectionChanged(const Akonadi::Collection &collection, const QSet<QByteArray> &attributeNames)
 {
-    if (attributeNames.contains("entityannotations")) {
-        readSupportedFields(collection);
+    if (attributeNames.contains("entityannotations") && readSupportedFields(collection)) {
+        emit supportedFieldsChanged(collection.id());
     }
     if (attributeNames.contains("CRM-enumdefinitions")) { // EnumDefinitionAttribute::type()
         readEnumDefinitionsAttributes(collection);
@@ -132,6 +147,8 @@ static bool collectionLessThan(const Collection &c1, const Collection &c2)
 
 void CollectionManager::slotCollectionFetchResult(KJob *job)
 {
+    FATCRM_TRACE_ASYNC_END("akonadi", "CollectionManager collection fetch", 0);
+    FATCRM_TRACE_SCOPE("client", "CollectionManager::slotCollectionFetchResult");
     auto *fetchJob = qobject_cast<CollectionFetchJob *>(job);
 
     QStringList collectionsWithoutEnumDefinitions;
@@ -185,35 +202,43 @@ void CollectionManager::slotCollectionFetchResult(KJob *job)
         //qCDebug(FATCRM_CLIENT_LOG) << collection.contentMimeTypes() << "name" << collection.name();
         emit collectionResult(collection.contentMimeTypes().at(0), collection);
     }
+    emit collectionsListed();
 }
 
 static const char s_supportedFieldsKey[] = "supportedFields"; // duplicated in listentriesjob.cpp
 
-void CollectionManager::readSupportedFields(const Collection &collection)
+// Returns true if the supported fields changed
+bool CollectionManager::readSupportedFields(const Collection &collection)
 {
     if (!mMainCollectionIds.contains(collection.id())) {
-        return;
+        return false;
     }
     auto *annotationsAttribute =
             collection.attribute<Akonadi::EntityAnnotationsAttribute>();
     const QStringList fields = annotationsAttribute ? annotationsAttribute->value(s_supportedFieldsKey).split(',', QString::SkipEmptyParts) : QStringList();
     if (!fields.isEmpty()) {
-        mCollectionData[collection.id()].supportedFields = fields;
+        const SupportedFields supportedFields(fields);
+        SupportedFields &currentFields = mCollectionData[collection.id()].supportedFields;
+        if (currentFields != supportedFields) {
+            currentFields = supportedFields;
+            return true;
+        }
     } else {
         qCWarning(FATCRM_CLIENT_LOG) << "No supported fields for" << collection;
         static bool errorShown = false;
-        if (!errorShown) {
+        if (!errorShown && canShowMessageBoxes()) {
             errorShown = true;
             QMessageBox::warning(qApp->activeWindow(), i18n("Internal error"), i18n("The list of fields for '%1' is not available. Creating new items will not work. Try restarting the CRM resource and synchronizing again (then restart FatCRM).", collection.name()));
         }
     }
+    return false;
 }
 
 bool CollectionManager::readEnumDefinitionsAttributes(const Collection &collection)
 {
     auto *enumsAttr = collection.attribute<EnumDefinitionAttribute>();
     if (enumsAttr) {
-        mCollectionData[collection.id()].enumDefinitions = EnumDefinitions::fromString(enumsAttr->value());
+        mCollectionData[collection.id()].enumDefinitions = enumsAttr->enumDefinitions();
         return true;
     }
     return false;
@@ -240,5 +265,7 @@ QList<KJob *> CollectionManager::clearTimestamps()
 
 void CollectionManager::showEnumDefinitionWarnings(const QStringList &warnings)
 {
+    if (!canShowMessageBoxes())
+        return;
     QMessageBox::warning(qApp->activeWindow(), i18n("Internal error"), i18n("The list of enumeration values for '%1' is not available. Comboboxes will be empty. Try restarting the CRM resource and synchronizing again, making sure at least one update is fetched (then restart FatCRM).", warnings.join(QStringLiteral(", "))));
 }
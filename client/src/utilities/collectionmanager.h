@@ -30,6 +30,7 @@
 #include "enums.h"
 #include "enumdefinitions.h"
 #include "fatcrmprivate_export.h"
+#include "supportedfields.h"
 #include <AkonadiCore/Collection>
 
 class KJob;
@@ -51,7 +52,9 @@ public:
     /// but you can use LinkedItemsRepository to get those.
     Akonadi::Collection::Id collectionIdForType(DetailsType detailsType) const;
 
-    QStringList supportedFields(Akonadi::Collection::Id collectionId) const;
+    SupportedFields supportedFields(Akonadi::Collection::Id collectionId) const;
+    /// Same as supportedFields(collectionId).contains(field), without copying anything
+    bool hasField(Akonadi::Collection::Id collectionId, const QString &field) const;
     EnumDefinitions enumDefinitions(Akonadi::Collection::Id collectionId) const;
 
     QList<KJob *> clearTimestamps();
@@ -62,18 +65,22 @@ public slots:
 
 signals:
     void collectionResult(const QString &mimeType, const Akonadi::Collection &collection);
+    /// Emitted after the last collectionResult, also when listing failed
+    void collectionsListed();
+    /// Emitted when the supported fields of a main collection changed after the initial listing
+    void supportedFieldsChanged(Akonadi::Collection::Id collectionId);
 
 private slots:
     void slotCollectionFetchResult(KJob *job);
 
 private:
-    void readSupportedFields(const Akonadi::Collection &collection);
+    bool readSupportedFields(const Akonadi::Collection &collection);
     bool readEnumDefinitionsAttributes(const Akonadi::Collection &collection);
     void showEnumDefinitionWarnings(const QStringList &warnings);
 
     struct CollectionData
     {
-        QStringList supportedFields;
+        SupportedFields supportedFields;
         EnumDefinitions enumDefinitions;
         Akonadi::Collection mCollection; // to keep a copy of the current attributes
     };
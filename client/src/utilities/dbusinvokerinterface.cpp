@@ -35,7 +35,27 @@ DBusInvokerInterface::DBusInvokerInterface(QObject *parent)
     }
 }
 
+void DBusInvokerInterface::setMemoryReportProvider(const std::function<QString()> &provider)
+{
+    mMemoryReportProvider = provider;
+}
+
 void DBusInvokerInterface::importCsvFile(const QString &filePath)
 {
     emit importCsvFileRequested(filePath);
 }
+
+QString DBusInvokerInterface::memoryReport()
+{
+    return mMemoryReportProvider ? mMemoryReportProvider() : QString();
+}
+
+void DBusInvokerInterface::setHistorySearchProvider(const std::function<QStringList(const QString &, int)> &provider)
+{
+    mHistorySearchProvider = provider;
+}
+
+QStringList DBusInvokerInterface::searchHistory(const QString &query, int maxHits)
+{
+    return mHistorySearchProvider ? mHistorySearchProvider(query, maxHits) : QStringList();
+}
@@ -22,6 +22,9 @@
 #define DBUSINVOKERINTERFACE_H
 
 #include <QObject>
+#include <QStringList>
+
+#include <functional>
 
 class DBusInvokerInterface : public QObject
 {
@@ -31,11 +34,21 @@ class DBusInvokerInterface : public QObject
 public:
     explicit DBusInvokerInterface(QObject *parent = nullptr);
 
+    void setMemoryReportProvider(const std::function<QString()> &provider);
+    void setHistorySearchProvider(const std::function<QStringList(const QString &, int)> &provider);
+
 public Q_SLOTS:
     Q_SCRIPTABLE void importCsvFile(const QString &filePath);
+    Q_SCRIPTABLE QString memoryReport();
+    // One line per hit of the full-text search over notes, emails and documents
+    Q_SCRIPTABLE QStringList searchHistory(const QString &query, int maxHits);
 
 signals:
     void importCsvFileRequested(const QString &filePath);
+
+private:
+    std::function<QString()> mMemoryReportProvider;
+    std::function<QStringList(const QString &, int)> mHistorySearchProvider;
 };
 
 #endif
@@ -0,0 +1,471 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "fulltextindex.h"
+
+#include "fatcrm_client_debug.h"
+#include "kdcrmdata/kdcrmutils.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cmath>
+
+static const int s_minTokenLength = 2;
+// Usual BM25 parameters: term frequency saturation and document length normalization
+static const double s_k1 = 1.2;
+static const double s_b = 0.75;
+// Postings of removed documents are dropped once they are more than a quarter of the index
+static const int s_minDeadForCompaction = 1024;
+
+static const quint32 s_fileMagic = 0x46435849; // "FCXI"
+static const quint32 s_fileVersion = 1;
+
+FullTextIndex::FullTextIndex()
+    : mAliveCount(0),
+      mDeadCount(0),
+      mTotalLength(0)
+{
+}
+
+void FullTextIndex::clear()
+{
+    mTermIds.clear();
+    mTerms.clear();
+    mPostings.clear();
+    mDocumentFrequencies.clear();
+    mDocuments.clear();
+    for (QHash<QString, int> &indexes : mDocumentIndexes) {
+        indexes.clear();
+    }
+    mAliveCount = 0;
+    mDeadCount = 0;
+    mTotalLength = 0;
+}
+
+bool FullTextIndex::add(Kind kind, const QString &id, const QString &revision, const QString &text,
+                        const QString &parentType, const QString &parentId)
+{
+    const auto it = mDocumentIndexes[kind].constFind(id);
+    if (it != mDocumentIndexes[kind].constEnd()) {
+        IndexedDocument &existing = mDocuments[*it];
+        existing.seen = true;
+        if (!revision.isEmpty() && existing.revision == revision &&
+                existing.parentType == parentType && existing.parentId == parentId) {
+            return false;
+        }
+        removeDocument(*it);
+        compactIfNeeded();
+    }
+
+    IndexedDocument document;
+    document.kind = kind;
+    document.id = id;
+    document.revision = revision;
+    document.parentType = parentType;
+    document.parentId = parentId;
+    document.alive = true;
+    document.seen = true;
+
+    const QStringList tokens = tokenize(text);
+    document.length = tokens.count();
+    QHash<int, int> frequencies;
+    for (const QString &token : tokens) {
+        ++frequencies[termId(token)];
+    }
+    const int index = mDocuments.count();
+    document.terms.reserve(frequencies.count());
+    for (auto freq = frequencies.constBegin(); freq != frequencies.constEnd(); ++freq) {
+        mPostings[freq.key()].append({ index, freq.value() });
+        ++mDocumentFrequencies[freq.key()];
+        document.terms.append(freq.key());
+    }
+    appendDocument(std::move(document));
+    return true;
+}
+
+void FullTextIndex::remove(Kind kind, const QString &id)
+{
+    const auto it = mDocumentIndexes[kind].constFind(id);
+    if (it != mDocumentIndexes[kind].constEnd()) {
+        removeDocument(*it);
+        compactIfNeeded();
+    }
+}
+
+bool FullTextIndex::contains(Kind kind, const QString &id) const
+{
+    return mDocumentIndexes[kind].contains(id);
+}
+
+QString FullTextIndex::parentId(Kind kind, const QString &id) const
+{
+    const auto it = mDocumentIndexes[kind].constFind(id);
+    return it == mDocumentIndexes[kind].constEnd() ? QString() : mDocuments.at(*it).parentId;
+}
+
+QVector<FullTextIndex::Hit> FullTextIndex::search(const QString &query, int maxHits) const
+{
+    QVector<Hit> hits;
+    if (mAliveCount == 0 || maxHits <= 0) {
+        return hits;
+    }
+
+    QStringList queryTerms = tokenize(query);
+    queryTerms.removeDuplicates();
+    const double averageLength = qMax(1.0, double(mTotalLength) / mAliveCount);
+
+    // Score accumulators by document index, only the touched ones are looked at afterwards
+    QVector<double> scores;
+    QVector<int> matched;
+    for (const QString &term : qAsConst(queryTerms)) {
+        const auto termIt = mTermIds.constFind(term);
+        if (termIt == mTermIds.constEnd()) {
+            continue;
+        }
+        const int documentFrequency = mDocumentFrequencies.at(*termIt);
+        if (documentFrequency == 0) {
+            continue;
+        }
+        if (scores.isEmpty()) {
+            scores.fill(0.0, mDocuments.count());
+        }
+        const double idf = std::log(1.0 + (mAliveCount - documentFrequency + 0.5) / (documentFrequency + 0.5));
+        for (const Posting &posting : mPostings.at(*termIt)) {
+            const IndexedDocument &document = mDocuments.at(posting.document);
+            if (!document.alive) {
+                continue;
+            }
+            const double tf = posting.termFrequency;
+            const double norm = s_k1 * (1.0 - s_b + s_b * document.length / averageLength);
+            double &score = scores[posting.document];
+            if (score == 0.0) {
+                matched.append(posting.document);
+            }
+            score += idf * tf * (s_k1 + 1.0) / (tf + norm);
+        }
+    }
+
+    // Best score first, ties in indexing order so that results are stable
+    auto better = [&scores](int a, int b) {
+        return scores.at(a) > scores.at(b) || (scores.at(a) == scores.at(b) && a < b);
+    };
+    if (matched.count() > maxHits) {
+        std::partial_sort(matched.begin(), matched.begin() + maxHits, matched.end(), better);
+        matched.resize(maxHits);
+    } else {
+        std::sort(matched.begin(), matched.end(), better);
+    }
+
+    hits.reserve(matched.count());
+    for (int index : qAsConst(matched)) {
+        const IndexedDocument &document = mDocuments.at(index);
+        hits.append({ document.kind, document.id, document.parentType, document.parentId, scores.at(index) });
+    }
+    return hits;
+}
+
+int FullTextIndex::documentCount() const
+{
+    return mAliveCount;
+}
+
+qint64 FullTextIndex::estimatedMemoryUsage() const
+{
+    // QHash nodes hold a next pointer and the hash besides the key and value
+    const qint64 hashNodeSize = qint64(sizeof(void *)) + qint64(sizeof(uint)) + qint64(sizeof(QString)) + qint64(sizeof(int));
+    qint64 size = mTermIds.capacity() * qint64(sizeof(void *)) + mTermIds.count() * hashNodeSize;
+    size += mTerms.capacity() * qint64(sizeof(QString));
+    for (const QString &term : mTerms) {
+        size += KDCRMUtils::memoryUsage(term); // shared with the mTermIds keys
+    }
+    size += mPostings.capacity() * qint64(sizeof(QVector<Posting>));
+    for (const QVector<Posting> &postings : mPostings) {
+        size += postings.capacity() * qint64(sizeof(Posting));
+    }
+    size += mDocumentFrequencies.capacity() * qint64(sizeof(int));
+    size += mDocuments.capacity() * qint64(sizeof(IndexedDocument));
+    for (const IndexedDocument &document : mDocuments) {
+        size += KDCRMUtils::memoryUsage(document.id) + KDCRMUtils::memoryUsage(document.revision)
+                + KDCRMUtils::memoryUsage(document.parentType) + KDCRMUtils::memoryUsage(document.parentId);
+        size += document.terms.capacity() * qint64(sizeof(int));
+    }
+    for (const QHash<QString, int> &indexes : mDocumentIndexes) {
+        size += indexes.capacity() * qint64(sizeof(void *)) + indexes.count() * hashNodeSize;
+    }
+    return size;
+}
+
+void FullTextIndex::markAllUnseen(Kind kind)
+{
+    for (IndexedDocument &document : mDocuments) {
+        if (document.kind == kind) {
+            document.seen = false;
+        }
+    }
+}
+
+int FullTextIndex::removeUnseen(Kind kind)
+{
+    int removed = 0;
+    for (int index = 0; index < mDocuments.count(); ++index) {
+        const IndexedDocument &document = mDocuments.at(index);
+        if (document.alive && document.kind == kind && !document.seen) {
+            removeDocument(index);
+            ++removed;
+        }
+    }
+    compactIfNeeded();
+    return removed;
+}
+
+bool FullTextIndex::markSeen(Kind kind, const QString &id, const QString &revision)
+{
+    const auto it = mDocumentIndexes[kind].constFind(id);
+    if (it == mDocumentIndexes[kind].constEnd() || revision.isEmpty()) {
+        return false;
+    }
+    IndexedDocument &document = mDocuments[*it];
+    if (document.revision != revision) {
+        return false;
+    }
+    document.seen = true;
+    return true;
+}
+
+bool FullTextIndex::save(const QString &fileName) const
+{
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(FATCRM_CLIENT_LOG) << "Cannot write full-text index" << fileName << file.errorString();
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_9);
+    stream << s_fileMagic << s_fileVersion;
+
+    // Only alive documents are written, renumbered in order
+    QVector<int> newIndexes(mDocuments.count(), -1);
+    stream << qint32(mAliveCount);
+    int newIndex = 0;
+    for (int index = 0; index < mDocuments.count(); ++index) {
+        const IndexedDocument &document = mDocuments.at(index);
+        if (!document.alive) {
+            continue;
+        }
+        newIndexes[index] = newIndex++;
+        stream << qint32(document.kind) << document.id << document.revision
+               << document.parentType << document.parentId << qint32(document.length);
+    }
+
+    qint32 termCount = 0;
+    for (int documentFrequency : mDocumentFrequencies) {
+        if (documentFrequency > 0) {
+            ++termCount;
+        }
+    }
+    stream << termCount;
+    for (int term = 0; term < mTerms.count(); ++term) {
+        if (mDocumentFrequencies.at(term) == 0) {
+            continue;
+        }
+        stream << mTerms.at(term) << qint32(mDocumentFrequencies.at(term));
+        for (const Posting &posting : mPostings.at(term)) {
+            const int document = newIndexes.at(posting.document);
+            if (document >= 0) {
+                stream << qint32(document) << qint32(posting.termFrequency);
+            }
+        }
+    }
+
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        qCWarning(FATCRM_CLIENT_LOG) << "Error writing full-text index" << fileName << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool FullTextIndex::load(const QString &fileName)
+{
+    clear();
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_9);
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if (magic != s_fileMagic || version != s_fileVersion) {
+        qCDebug(FATCRM_CLIENT_LOG) << "Ignoring full-text index with unknown format" << fileName;
+        return false;
+    }
+
+    qint32 documentCount = 0;
+    stream >> documentCount;
+    if (documentCount < 0) {
+        return false;
+    }
+    mDocuments.reserve(documentCount);
+    for (qint32 i = 0; i < documentCount && stream.status() == QDataStream::Ok; ++i) {
+        IndexedDocument document;
+        qint32 kind = 0;
+        qint32 length = 0;
+        stream >> kind >> document.id >> document.revision >> document.parentType >> document.parentId >> length;
+        if (kind < Note || kind > Document) {
+            stream.setStatus(QDataStream::ReadCorruptData);
+            break;
+        }
+        document.kind = static_cast<Kind>(kind);
+        document.length = length;
+        document.alive = true;
+        document.seen = true;
+        appendDocument(std::move(document));
+    }
+
+    qint32 termCount = 0;
+    stream >> termCount;
+    for (qint32 i = 0; i < termCount && stream.status() == QDataStream::Ok; ++i) {
+        QString term;
+        qint32 postingCount = 0;
+        stream >> term >> postingCount;
+        const int id = termId(term);
+        QVector<Posting> &postings = mPostings[id];
+        postings.reserve(postingCount);
+        for (qint32 p = 0; p < postingCount; ++p) {
+            qint32 document = 0;
+            qint32 termFrequency = 0;
+            stream >> document >> termFrequency;
+            if (document < 0 || document >= mDocuments.count()) {
+                stream.setStatus(QDataStream::ReadCorruptData);
+                break;
+            }
+            postings.append({ document, termFrequency });
+            mDocuments[document].terms.append(id);
+        }
+        mDocumentFrequencies[id] = postings.count();
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qCWarning(FATCRM_CLIENT_LOG) << "Corrupt full-text index" << fileName;
+        clear();
+        return false;
+    }
+    return true;
+}
+
+QStringList FullTextIndex::tokenize(const QString &text)
+{
+    QStringList tokens;
+    const int size = text.size();
+    int start = -1;
+    for (int i = 0; i <= size; ++i) {
+        if (i < size && text.at(i).isLetterOrNumber()) {
+            if (start < 0) {
+                start = i;
+            }
+        } else if (start >= 0) {
+            if (i - start >= s_minTokenLength) {
+                tokens.append(text.mid(start, i - start).toLower());
+            }
+            start = -1;
+        }
+    }
+    return tokens;
+}
+
+int FullTextIndex::termId(const QString &term)
+{
+    auto it = mTermIds.constFind(term);
+    if (it != mTermIds.constEnd()) {
+        return *it;
+    }
+    const int id = mTerms.count();
+    mTermIds.insert(term, id);
+    mTerms.append(term);
+    mPostings.append(QVector<Posting>());
+    mDocumentFrequencies.append(0);
+    return id;
+}
+
+int FullTextIndex::appendDocument(IndexedDocument document)
+{
+    const int index = mDocuments.count();
+    mDocumentIndexes[document.kind].insert(document.id, index);
+    mTotalLength += document.length;
+    ++mAliveCount;
+    mDocuments.append(std::move(document));
+    return index;
+}
+
+void FullTextIndex::removeDocument(int index)
+{
+    IndexedDocument &document = mDocuments[index];
+    Q_ASSERT(document.alive);
+    for (int term : qAsConst(document.terms)) {
+        --mDocumentFrequencies[term];
+    }
+    mDocumentIndexes[document.kind].remove(document.id);
+    mTotalLength -= document.length;
+    --mAliveCount;
+    ++mDeadCount;
+    document.alive = false;
+    document.terms = QVector<int>();
+}
+
+void FullTextIndex::compactIfNeeded()
+{
+    if (mDeadCount >= s_minDeadForCompaction && mDeadCount * 4 > mDocuments.count()) {
+        compact();
+    }
+}
+
+void FullTextIndex::compact()
+{
+    QVector<int> newIndexes(mDocuments.count(), -1);
+    QVector<IndexedDocument> documents;
+    documents.reserve(mAliveCount);
+    for (int index = 0; index < mDocuments.count(); ++index) {
+        if (mDocuments.at(index).alive) {
+            newIndexes[index] = documents.count();
+            mDocumentIndexes[mDocuments.at(index).kind].insert(mDocuments.at(index).id, documents.count());
+            documents.append(std::move(mDocuments[index]));
+        }
+    }
+    mDocuments.swap(documents);
+
+    for (QVector<Posting> &postings : mPostings) {
+        auto out = postings.begin();
+        for (const Posting &posting : qAsConst(postings)) {
+            const int document = newIndexes.at(posting.document);
+            if (document >= 0) {
+                *out++ = { document, posting.termFrequency };
+            }
+        }
+        postings.erase(out, postings.end());
+    }
+    mDeadCount = 0;
+}
@@ -0,0 +1,134 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef FULLTEXTINDEX_H
+#define FULLTEXTINDEX_H
+
+#include "fatcrmprivate_export.h"
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * In-memory inverted index over the text of notes, emails and documents, ranked with BM25.
+ *
+ * Items are identified by their kind and SugarCRM id. Adding an item again with the same
+ * remote revision is a no-op, so that reloading the items after a restart only reindexes
+ * what changed on the server since the index was saved.
+ *
+ * Removed items are only marked as dead, their postings are dropped in bulk once enough
+ * of them have accumulated.
+ */
+class FATCRMPRIVATE_EXPORT FullTextIndex
+{
+public:
+    enum Kind {
+        Note = 0,
+        Email,
+        Document
+    };
+
+    struct Hit
+    {
+        Kind kind;
+        QString id;
+        QString parentType;
+        QString parentId;
+        double score;
+    };
+
+    FullTextIndex();
+
+    void clear();
+
+    /**
+     * Indexes @p text for the given item, replacing what was indexed for it before.
+     * @return false if the item was already indexed with the same revision and parent
+     */
+    bool add(Kind kind, const QString &id, const QString &revision, const QString &text,
+             const QString &parentType, const QString &parentId);
+    void remove(Kind kind, const QString &id);
+    bool contains(Kind kind, const QString &id) const;
+    // The parent given to add(), empty if the item isn't indexed
+    QString parentId(Kind kind, const QString &id) const;
+
+    /**
+     * Returns the best @p maxHits items for @p query, any of the query terms matching.
+     */
+    QVector<Hit> search(const QString &query, int maxHits = 50) const;
+
+    int documentCount() const;
+    qint64 estimatedMemoryUsage() const;
+
+    // Used around a full load of one kind of items, to drop the ones deleted in the meantime
+    void markAllUnseen(Kind kind);
+    int removeUnseen(Kind kind);
+    // Keeps an item seen during such a load without its payload (e.g. archived items).
+    // Returns false if it isn't indexed with that revision, in which case it will be removed.
+    bool markSeen(Kind kind, const QString &id, const QString &revision);
+
+    bool save(const QString &fileName) const;
+    bool load(const QString &fileName);
+
+    static QStringList tokenize(const QString &text);
+
+private:
+    struct Posting
+    {
+        int document;
+        int termFrequency;
+    };
+
+    struct IndexedDocument
+    {
+        Kind kind;
+        QString id;
+        QString revision;
+        QString parentType;
+        QString parentId;
+        int length;
+        QVector<int> terms; // distinct term ids, to update the document frequencies on removal
+        bool alive;
+        bool seen;
+    };
+
+    int termId(const QString &term);
+    int appendDocument(IndexedDocument document);
+    void removeDocument(int index);
+    void compactIfNeeded();
+    void compact();
+
+    QHash<QString, int> mTermIds;
+    QVector<QString> mTerms;
+    QVector<QVector<Posting>> mPostings; // by term id, sorted by document index
+    QVector<int> mDocumentFrequencies; // by term id, alive documents only
+
+    QVector<IndexedDocument> mDocuments;
+    QHash<QString, int> mDocumentIndexes[Document + 1]; // by kind: id -> index in mDocuments
+    int mAliveCount;
+    int mDeadCount;
+    qint64 mTotalLength;
+};
+
+Q_DECLARE_TYPEINFO(FullTextIndex::Hit, Q_MOVABLE_TYPE);
+
+#endif // FULLTEXTINDEX_H
@@ -0,0 +1,269 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemexporter.h"
+
+#include "accountrepository.h"
+#include "collectionmanager.h"
+#include "fatcrm_client_debug.h"
+#include "itemfetchscopes.h"
+#include "referenceddata.h"
+
+#include "kdcrmdata/kdcrmtrace.h"
+#include "kdcrmdata/sugaraccount.h"
+#include "kdcrmdata/sugarcampaign.h"
+#include "kdcrmdata/sugarlead.h"
+#include "kdcrmdata/sugaropportunity.h"
+
+#include <AkonadiCore/ItemFetchJob>
+#include <AkonadiCore/ItemFetchScope>
+
+#include <KContacts/Addressee>
+
+#include <KLocalizedString>
+
+#include <QIODevice>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+
+using namespace Akonadi;
+
+ItemExporter::ItemExporter(QObject *parent)
+    : QObject(parent),
+      mCollectionManager(new CollectionManager(this))
+{
+    connect(mCollectionManager, &CollectionManager::collectionsListed,
+            this, &ItemExporter::slotCollectionsListed);
+}
+
+ItemExporter::~ItemExporter()
+{
+}
+
+void ItemExporter::setResource(const QByteArray &identifier)
+{
+    mResourceIdentifier = identifier;
+}
+
+void ItemExporter::setType(DetailsType type)
+{
+    mType = type;
+}
+
+void ItemExporter::setColumns(const ItemsTreeModel::ColumnTypes &columns)
+{
+    mColumns = columns;
+}
+
+void ItemExporter::setFormat(Format format)
+{
+    mFormat = format;
+}
+
+void ItemExporter::setOpportunityFilter(const OpportunityFilterSettings &settings)
+{
+    mOpportunityFilter = settings;
+}
+
+void ItemExporter::setDevice(QIODevice *device)
+{
+    mDevice = device;
+}
+
+void ItemExporter::start()
+{
+    Q_ASSERT(mDevice);
+    if (mColumns.isEmpty())
+        mColumns = defaultColumns(mType);
+    mExportedCount = 0;
+    FATCRM_TRACE_ASYNC_BEGIN("export", "ItemExporter", 0);
+    mCollectionManager->setResource(mResourceIdentifier);
+}
+
+bool ItemExporter::isExportable(ItemsTreeModel::ColumnType column)
+{
+    switch (column) {
+    case ItemsTreeModel::NumberOfOpportunities:
+    case ItemsTreeModel::NumberOfContacts:
+    case ItemsTreeModel::NumberOfDocumentsNotesEmails:
+        return false;
+    default:
+        return true;
+    }
+}
+
+ItemsTreeModel::ColumnTypes ItemExporter::defaultColumns(DetailsType type)
+{
+    ItemsTreeModel::ColumnTypes columns = ItemsTreeModel::defaultVisibleColumns(type);
+    columns.erase(std::remove_if(columns.begin(), columns.end(),
+                                 [](ItemsTreeModel::ColumnType column) { return !isExportable(column); }),
+                  columns.end());
+    return columns;
+}
+
+QString ItemExporter::csvLine(const QStringList &cells)
+{
+    QString line;
+    for (QString str : cells) {
+        if (str.contains(',')) {
+            str = '"' + str + '"';
+        }
+        line += str + ",";
+    }
+    line += '\n';
+    return line;
+}
+
+void ItemExporter::slotCollectionsListed()
+{
+    if (mCollectionManager->collectionIdForType(mType) <= 0) {
+        finish(false, i18n("No folder for %1 in resource %2", typeToTranslatedString(mType), QString::fromLatin1(mResourceIdentifier)));
+        return;
+    }
+
+    // Opportunities and contacts show account names (and countries), which come from the accounts
+    if (mType != DetailsType::Opportunity && mType != DetailsType::Contact) {
+        fetchItems();
+        return;
+    }
+    const Collection::Id accountsCollectionId = mCollectionManager->collectionIdForType(DetailsType::Account);
+    if (accountsCollectionId <= 0) {
+        finish(false, i18n("No folder for %1 in resource %2", typeToTranslatedString(DetailsType::Account), QString::fromLatin1(mResourceIdentifier)));
+        return;
+    }
+    auto *job = new ItemFetchJob(Collection(accountsCollectionId), this);
+    ItemFetchScopes::configure(job->fetchScope(), ItemFetchScopes::Export);
+    job->setDeliveryOption(ItemFetchJob::EmitItemsInBatches);
+    connect(job, &ItemFetchJob::itemsReceived, this, &ItemExporter::slotAccountsReceived);
+    connect(job, &KJob::result, this, &ItemExporter::slotAccountsFetched);
+}
+
+void ItemExporter::slotAccountsReceived(const Item::List &items)
+{
+    QMap<QString, QString> accountRefMap;
+    for (const Item &item : items) {
+        if (!item.hasPayload<SugarAccount>())
+            continue;
+        const SugarAccount account = item.payload<SugarAccount>();
+        if (account.id().isEmpty()) // created locally, not synced yet; AccountsPage skips these too
+            continue;
+        accountRefMap.insert(account.id(), account.name());
+        AccountRepository::instance()->addAccount(account, item.id());
+    }
+    ReferencedData::instance(AccountRef)->addMap(accountRefMap, false);
+}
+
+void ItemExporter::slotAccountsFetched(KJob *job)
+{
+    if (job->error()) {
+        finish(false, job->errorString());
+        return;
+    }
+    fetchItems();
+}
+
+void ItemExporter::fetchItems()
+{
+    auto *job = new ItemFetchJob(Collection(mCollectionManager->collectionIdForType(mType)), this);
+    ItemFetchScopes::configure(job->fetchScope(), ItemFetchScopes::Export);
+    // don't keep all items in the job, we write them out as they arrive
+    job->setDeliveryOption(ItemFetchJob::EmitItemsInBatches);
+    connect(job, &ItemFetchJob::itemsReceived, this, &ItemExporter::writeItems);
+    connect(job, &KJob::result, this, &ItemExporter::slotItemsFetched);
+}
+
+void ItemExporter::writeItems(const Item::List &items)
+{
+    FATCRM_TRACE_SCOPE("export", "ItemExporter::writeItems");
+    FATCRM_TRACE_SET_COUNT(items.count());
+    for (const Item &item : items) {
+        if (accepts(item)) {
+            writeItem(item);
+        }
+    }
+}
+
+void ItemExporter::writeEnd()
+{
+    if (mFormat == Json) {
+        mDevice->write(mExportedCount > 0 ? "\n]\n" : "[]\n");
+    }
+}
+
+void ItemExporter::slotItemsFetched(KJob *job)
+{
+    writeEnd();
+    if (job->error()) {
+        finish(false, job->errorString());
+        return;
+    }
+    finish(true);
+}
+
+bool ItemExporter::accepts(const Item &item) const
+{
+    if (!item.hasPayload()) {
+        // not in the cache, and we don't ask the resource for it
+        qCWarning(FATCRM_CLIENT_LOG) << "Skipping item" << item.id() << "without payload in the Akonadi cache";
+        return false;
+    }
+    if (mType != DetailsType::Opportunity)
+        return true;
+
+    // Same as OpportunityFilterProxyModel::filterAcceptsRow
+    if (!item.hasPayload<SugarOpportunity>())
+        return false;
+    const SugarOpportunity opportunity = item.payload<SugarOpportunity>();
+    if (!mOpportunityFilter.matches(opportunity))
+        return false;
+    const QString searchText = mOpportunityFilter.searchText();
+    return searchText.isEmpty() || OpportunityFilterSettings::matchesSearchText(opportunity, searchText);
+}
+
+void ItemExporter::writeItem(const Item &item)
+{
+    // The currency symbols come from the collection manager; the linked items repository
+    // isn't loaded, see isExportable.
+    Q_ASSERT(std::all_of(mColumns.cbegin(), mColumns.cend(), &ItemExporter::isExportable));
+    QStringList cells;
+    cells.reserve(mColumns.count());
+    for (ItemsTreeModel::ColumnType column : qAsConst(mColumns)) {
+        cells.append(ItemsTreeModel::itemData(mType, item, column, Qt::DisplayRole, mCollectionManager, nullptr).toString());
+    }
+
+    if (mFormat == Csv) {
+        mDevice->write(csvLine(cells).toUtf8());
+    } else {
+        QJsonObject object;
+        for (int i = 0; i < mColumns.count(); ++i) {
+            object.insert(ItemsTreeModel::columnNameFromType(mColumns.at(i)), cells.at(i));
+        }
+        mDevice->write(mExportedCount > 0 ? ",\n" : "[\n");
+        mDevice->write(QJsonDocument(object).toJson(QJsonDocument::Compact));
+    }
+    ++mExportedCount;
+}
+
+void ItemExporter::finish(bool success, const QString &errorMessage)
+{
+    FATCRM_TRACE_ASYNC_END("export", "ItemExporter", 0);
+    emit finished(success, errorMessage);
+}
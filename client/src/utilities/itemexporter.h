@@ -0,0 +1,109 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEMEXPORTER_H
+#define ITEMEXPORTER_H
+
+#include "fatcrmprivate_export.h"
+#include "enums.h"
+#include "itemstreemodel.h"
+#include "opportunityfiltersettings.h"
+
+#include <AkonadiCore/Item>
+
+#include <QObject>
+
+class CollectionManager;
+class KJob;
+class QIODevice;
+
+/**
+ * Writes all items of one type to CSV or JSON, reading them directly from the
+ * Akonadi cache, without any model. The cells are the same as in the views
+ * (see ItemsTreeModel::itemData) and the CSV lines the same as Page::exportToCSV.
+ * Rows are written while the items arrive, in Akonadi order.
+ *
+ * For opportunities and contacts, the accounts are fetched first, for the account
+ * names and countries (ReferencedData and AccountRepository are filled, as AccountsPage does).
+ *
+ * Used by fatcrm-export.
+ */
+class FATCRMPRIVATE_EXPORT ItemExporter : public QObject
+{
+    Q_OBJECT
+public:
+    enum Format {
+        Csv,
+        Json
+    };
+
+    explicit ItemExporter(QObject *parent = nullptr);
+    ~ItemExporter() override;
+
+    void setResource(const QByteArray &identifier);
+    void setType(DetailsType type);
+    /// Default: defaultColumns(type); all columns must be exportable
+    void setColumns(const ItemsTreeModel::ColumnTypes &columns);
+    void setFormat(Format format);
+    /// Only used for opportunities, including the search text
+    void setOpportunityFilter(const OpportunityFilterSettings &settings);
+    /// Where to write the rows, must be open already
+    void setDevice(QIODevice *device);
+
+    void start();
+
+    int exportedCount() const { return mExportedCount; }
+
+    /// Filters and writes one batch of fetched items; public for the benchmarks
+    void writeItems(const Akonadi::Item::List &items);
+    /// Completes the JSON array; called once all items are written
+    void writeEnd();
+
+    /// False for the "number of" columns, which need the linked items (not loaded here)
+    static bool isExportable(ItemsTreeModel::ColumnType column);
+    /// The initially visible columns of the view, without those which aren't exportable
+    static ItemsTreeModel::ColumnTypes defaultColumns(DetailsType type);
+
+    /// One line of CSV, as written by Page::exportToCSV
+    static QString csvLine(const QStringList &cells);
+
+signals:
+    void finished(bool success, const QString &errorMessage);
+
+private:
+    void slotCollectionsListed();
+    void slotAccountsReceived(const Akonadi::Item::List &items);
+    void slotAccountsFetched(KJob *job);
+    void fetchItems();
+    void slotItemsFetched(KJob *job);
+    bool accepts(const Akonadi::Item &item) const;
+    void writeItem(const Akonadi::Item &item);
+    void finish(bool success, const QString &errorMessage = QString());
+
+    CollectionManager *mCollectionManager;
+    QByteArray mResourceIdentifier;
+    DetailsType mType = DetailsType::Opportunity;
+    ItemsTreeModel::ColumnTypes mColumns;
+    Format mFormat = Csv;
+    OpportunityFilterSettings mOpportunityFilter;
+    QIODevice *mDevice = nullptr;
+    int mExportedCount = 0;
+};
+
+#endif // ITEMEXPORTER_H
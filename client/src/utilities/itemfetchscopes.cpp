@@ -0,0 +1,112 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemfetchscopes.h"
+
+#include "fatcrm_client_debug.h"
+#include "kdcrmdata/syncbaseattribute.h"
+
+#include <AkonadiCore/EntityTreeModel>
+#include <AkonadiCore/ItemFetchScope>
+
+#include <QHash>
+
+namespace {
+struct AuditTotals
+{
+    qint64 items = 0;
+    qint64 bytes = 0;
+};
+}
+
+void ItemFetchScopes::configure(Akonadi::ItemFetchScope &scope, Consumer consumer)
+{
+    // Common to all consumers: the payload is all we read
+    scope.fetchFullPayload(true);
+    scope.fetchAllAttributes(false);
+    // Only present on items modified locally and not synced yet, see SyncBaseAttribute::storeBase
+    scope.fetchAttribute<SyncBaseAttribute>();
+    scope.setFetchModificationTime(false);
+    scope.setFetchGid(false);
+    scope.setFetchTags(false);
+    scope.setAncestorRetrieval(Akonadi::ItemFetchScope::None);
+
+    switch (consumer) {
+    case PageModel:
+        // don't get remote id/rev, to avoid errors in the FATCRM-75 case
+        scope.setFetchRemoteIdentification(false);
+        break;
+    case LinkedItems:
+        scope.setFetchRemoteIdentification(true); // remoteId() is used by slotItemRemoved
+        scope.setIgnoreRetrievalErrors(true);
+        break;
+    case LinkedItemHeaders:
+        scope.fetchFullPayload(false);
+        scope.setFetchRemoteIdentification(true); // the remote revision is the modification date
+        scope.setIgnoreRetrievalErrors(true);
+        break;
+    case Export:
+        scope.fetchAttribute<SyncBaseAttribute>(false); // local edits are exported as they are
+        scope.setFetchRemoteIdentification(false);
+        scope.setCacheOnly(true);
+        break;
+    }
+}
+
+bool ItemFetchScopes::auditEnabled()
+{
+    static const bool enabled = qEnvironmentVariableIntValue("FATCRM_FETCH_AUDIT") != 0;
+    return enabled;
+}
+
+void ItemFetchScopes::audit(const QString &scopeName, const Akonadi::Item::List &items)
+{
+    if (!auditEnabled() || items.isEmpty())
+        return;
+
+    static QHash<QString, AuditTotals> s_totals;
+
+    qint64 bytes = 0;
+    for (const Akonadi::Item &item : items) {
+        // size() is what the server reports; fall back to the serialized payload
+        bytes += item.size() > 0 ? qint64(item.size()) : qint64(item.payloadData().size());
+    }
+    AuditTotals &totals = s_totals[scopeName];
+    totals.items += items.count();
+    totals.bytes += bytes;
+    qCInfo(FATCRM_CLIENT_LOG) << "Fetch audit:" << scopeName << "received" << items.count() << "items,"
+                              << bytes << "bytes; total so far" << totals.items << "items,"
+                              << totals.bytes << "bytes";
+}
+
+void ItemFetchScopes::audit(const QString &scopeName, const QAbstractItemModel *model, int first, int last)
+{
+    if (!auditEnabled())
+        return;
+
+    Akonadi::Item::List items;
+    items.reserve(last - first + 1);
+    for (int row = first; row <= last; ++row) {
+        const QModelIndex index = model->index(row, 0);
+        const auto item = index.data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>();
+        if (item.isValid())
+            items.append(item);
+    }
+    audit(scopeName, items);
+}
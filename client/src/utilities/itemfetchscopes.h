@@ -0,0 +1,60 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEMFETCHSCOPES_H
+#define ITEMFETCHSCOPES_H
+
+#include "fatcrmprivate_export.h"
+
+#include <AkonadiCore/Item>
+
+class QAbstractItemModel;
+class QString;
+
+namespace Akonadi { class ItemFetchScope; }
+
+/**
+ * Fetch scopes used by the various consumers of Akonadi items in the client.
+ *
+ * Each consumer only asks for what it actually reads: no item attributes
+ * (none are used by the client), no modification time, GID, tags or ancestors.
+ * Our serializers only provide Item::FullPayload, so there are no payload parts
+ * to select from yet.
+ *
+ * Setting FATCRM_FETCH_AUDIT=1 in the environment enables the audit mode,
+ * which logs how many bytes each scope pulled from the Akonadi server.
+ */
+namespace ItemFetchScopes
+{
+enum Consumer {
+    PageModel, // the ChangeRecorder/ItemsTreeModel of a Page, shows all columns
+    LinkedItems, // notes, emails and documents in LinkedItemsRepository
+    LinkedItemHeaders, // same, without payload: only to sort notes and emails into hot and cold (ArchiveTiering)
+    Export // ItemExporter (fatcrm-export): payloads from the Akonadi cache only, never from the server
+};
+
+FATCRMPRIVATE_EXPORT void configure(Akonadi::ItemFetchScope &scope, Consumer consumer);
+
+FATCRMPRIVATE_EXPORT bool auditEnabled();
+FATCRMPRIVATE_EXPORT void audit(const QString &scopeName, const Akonadi::Item::List &items);
+// audits the items found in rows [first, last] of an EntityTreeModel (or proxy on top of it)
+FATCRMPRIVATE_EXPORT void audit(const QString &scopeName, const QAbstractItemModel *model, int first, int last);
+}
+
+#endif // ITEMFETCHSCOPES_H
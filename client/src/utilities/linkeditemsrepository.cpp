@@ -22,6 +22,9 @@
 
 #include "linkeditemsrepository.h"
 #include "collectionmanager.h"
+#include "itemfetchscopes.h"
+#include "kdcrmtrace.h"
+#include "memoryreport.h"
 #include <AkonadiCore/Collection>
 #include <AkonadiCore/collectionstatistics.h>
 #include <AkonadiCore/ItemFetchJob>
@@ -31,6 +34,8 @@
 #include <QStringList>
 #include <sugarcontactwrapper.h>
 
+#include <algorithm>
+
 #include "fatcrm_client_debug.h"
 
 #define kDebug() qCDebug(FATCRM_CLIENT_LOG)
@@ -46,8 +51,16 @@ LinkedItemsRepository::LinkedItemsRepository(CollectionManager *collectionManage
 {
 }
 
+LinkedItemsRepository::~LinkedItemsRepository()
+{
+    saveFullTextIndex();
+}
+
 void LinkedItemsRepository::clear()
 {
+    saveFullTextIndex();
+    mFullTextIndex.clear();
+    mFullTextIndexFile.clear();
     mNotesLoaded = 0;
     mEmailsLoaded = 0;
     mDocumentsLoaded = 0;
@@ -61,10 +74,43 @@ void LinkedItemsRepository::clear()
     mOpportunityDocumentsHash.clear();
     mAccountOpportunitiesHash.clear();
     mAccountContactsHash.clear();
+    mColdNoteIds.clear();
+    mColdEmailIds.clear();
+    mColdHistoryParents.clear();
+    mHistoryMemoryUsage = 0;
+    mEvictedNoteIds.clear();
+    mEvictedEmailIds.clear();
     delete mMonitor;
     mMonitor = nullptr;
 }
 
+void LinkedItemsRepository::setFullTextIndexFile(const QString &fileName)
+{
+    mFullTextIndexFile = fileName;
+    if (mFullTextIndex.load(fileName)) {
+        qCDebug(FATCRM_CLIENT_LOG) << "Loaded full-text index with" << mFullTextIndex.documentCount() << "items from" << fileName;
+    }
+}
+
+void LinkedItemsRepository::saveFullTextIndex()
+{
+    if (!mFullTextIndexFile.isEmpty()) {
+        FATCRM_TRACE_SCOPE("client", "LinkedItemsRepository::saveFullTextIndex");
+        mFullTextIndex.save(mFullTextIndexFile);
+    }
+}
+
+QVector<FullTextIndex::Hit> LinkedItemsRepository::search(const QString &query, int maxHits) const
+{
+    FATCRM_TRACE_SCOPE("client", "LinkedItemsRepository::search");
+    return mFullTextIndex.search(query, maxHits);
+}
+
+void LinkedItemsRepository::setArchiveTiering(const ArchiveTiering &tiering)
+{
+    mArchiveTiering = tiering;
+}
+
 void LinkedItemsRepository::setNotesCollection(const Akonadi::Collection &collection)
 {
     mNotesCollection = collection;
@@ -75,10 +121,19 @@ void LinkedItemsRepository::loadNotes()
     //qCDebug(FATCRM_CLIENT_LOG) << "Loading" << mNotesCollection.statistics().count() << "notes";
 
     // load notes
+    FATCRM_TRACE_ASYNC_BEGIN("akonadi", "LinkedItemsRepository::loadNotes", mNotesCollection.id());
+    mFullTextIndex.markAllUnseen(FullTextIndex::Note);
     auto *job = new Akonadi::ItemFetchJob(mNotesCollection, this);
-    configureItemFetchScope(job->fetchScope());
-    connect(job, &Akonadi::ItemFetchJob::itemsReceived,
-            this, &LinkedItemsRepository::slotNotesReceived);
+    if (mArchiveTiering.isEnabled()) {
+        // Only fetch the payload of the hot notes, see slotNoteHeadersReceived
+        ItemFetchScopes::configure(job->fetchScope(), ItemFetchScopes::LinkedItemHeaders);
+        connect(job, &Akonadi::ItemFetchJob::itemsReceived,
+                this, &LinkedItemsRepository::slotNoteHeadersReceived);
+    } else {
+        configureItemFetchScope(job->fetchScope());
+        connect(job, &Akonadi::ItemFetchJob::itemsReceived,
+                this, &LinkedItemsRepository::slotNotesReceived);
+    }
 }
 
 QVector<SugarNote> LinkedItemsRepository::notesForAccount(const QString &id) const
@@ -98,13 +153,85 @@ QVector<SugarNote> LinkedItemsRepository::notesForOpportunity(const QString &id)
 
 void LinkedItemsRepository::slotNotesReceived(const Akonadi::Item::List &items)
 {
+    FATCRM_TRACE_SCOPE("client", "LinkedItemsRepository::slotNotesReceived");
+    FATCRM_TRACE_SET_COUNT(items.count());
+    ItemFetchScopes::audit(QStringLiteral("notes"), items);
     mNotesLoaded += items.count();
+    addNotes(items);
+    //qCDebug(FATCRM_CLIENT_LOG) << "loaded" << mNotesLoaded << "notes; now hash has" << mNotesHash.count() << "entries";
+    checkNotesLoaded();
+}
+
+void LinkedItemsRepository::slotNoteHeadersReceived(const Akonadi::Item::List &items)
+{
+    FATCRM_TRACE_SCOPE("client", "LinkedItemsRepository::slotNoteHeadersReceived");
+    FATCRM_TRACE_SET_COUNT(items.count());
+    Akonadi::Item::List hotItems = items;
+    const Akonadi::Item::List coldItems = mArchiveTiering.takeColdItems(hotItems);
+    Akonadi::Item::List unindexedItems;
+    for (const Akonadi::Item &item : coldItems) {
+        mColdNoteIds.append(item.id());
+        if (mFullTextIndex.markSeen(FullTextIndex::Note, item.remoteId(), item.remoteRevision())) {
+            mColdHistoryParents.insert(item.id(), mFullTextIndex.parentId(FullTextIndex::Note, item.remoteId()));
+        } else {
+            unindexedItems.append(item);
+        }
+    }
+    if (!unindexedItems.isEmpty()) {
+        // New or modified since the index was saved: index them, but leave them in Akonadi until loadArchive()
+        auto *job = new Akonadi::ItemFetchJob(unindexedItems, this);
+        configureItemFetchScope(job->fetchScope());
+        connect(job, &Akonadi::ItemFetchJob::itemsReceived,
+                this, &LinkedItemsRepository::slotColdNotesReceived);
+    }
+    if (hotItems.isEmpty()) {
+        checkNotesLoaded();
+        return;
+    }
+    auto *job = new Akonadi::ItemFetchJob(hotItems, this);
+    configureItemFetchScope(job->fetchScope());
+    connect(job, &Akonadi::ItemFetchJob::itemsReceived,
+            this, &LinkedItemsRepository::slotNotesReceived);
+}
+
+void LinkedItemsRepository::slotColdNotesReceived(const Akonadi::Item::List &items)
+{
+    FATCRM_TRACE_SCOPE("client", "LinkedItemsRepository::slotColdNotesReceived");
+    FATCRM_TRACE_SET_COUNT(items.count());
+    for (const Akonadi::Item &item : items) {
+        if (item.hasPayload<SugarNote>()) {
+            const SugarNote note = item.payload<SugarNote>();
+            if (!note.id().isEmpty()) {
+                indexNote(note, item.remoteRevision());
+                mColdHistoryParents.insert(item.id(), note.parentId());
+            }
+        }
+    }
+}
+
+void LinkedItemsRepository::indexNote(const SugarNote &note, const QString &revision)
+{
+    mFullTextIndex.add(FullTextIndex::Note, note.id(), revision,
+                       note.name() + QLatin1Char('\n') + note.description(),
+                       note.parentType(), note.parentId());
+}
+
+void LinkedItemsRepository::addNotes(const Akonadi::Item::List &items)
+{
     foreach(const Akonadi::Item &item, items) {
         storeNote(item, false);
     }
-    //qCDebug(FATCRM_CLIENT_LOG) << "loaded" << mNotesLoaded << "notes; now hash has" << mNotesHash.count() << "entries";
-    if (mNotesLoaded == mNotesCollection.statistics().count())
+    enforceHistoryMemoryBudget();
+}
+
+void LinkedItemsRepository::checkNotesLoaded()
+{
+    // The cold notes are part of the collection, but only loaded by loadArchive()
+    if (mNotesLoaded + mColdNoteIds.count() == mNotesCollection.statistics().count()) {
+        FATCRM_TRACE_ASYNC_END("akonadi", "LinkedItemsRepository::loadNotes", mNotesCollection.id());
+        mFullTextIndex.removeUnseen(FullTextIndex::Note);
         emit notesLoaded(mNotesLoaded);
+    }
 }
 
 void LinkedItemsRepository::storeNote(const Akonadi::Item &item, bool emitSignals)
@@ -118,10 +245,12 @@ void LinkedItemsRepository::storeNote(const Akonadi::Item &item, bool emitSignal
             return;
         }
         removeNote(id); // handle change of parent
+        indexNote(note, item.remoteRevision());
         const QString parentId = note.parentId();
         if (note.parentType() == QLatin1String("Accounts")) {
             if (!parentId.isEmpty()) {
                 mAccountNotesHash[parentId].append(note);
+                mHistoryMemoryUsage += note.estimatedMemoryUsage();
                 mNotesAccountIdHash.insert(id, parentId);
                 if (emitSignals) {
                     emit accountModified(parentId);
@@ -132,6 +261,7 @@ void LinkedItemsRepository::storeNote(const Akonadi::Item &item, bool emitSignal
         } else if (note.parentType() == QLatin1String("Contacts")) {
             if (!parentId.isEmpty()) {
                 mContactNotesHash[parentId].append(note);
+                mHistoryMemoryUsage += note.estimatedMemoryUsage();
                 mNotesContactIdHash.insert(id, parentId);
                 if (emitSignals) {
                     emit contactModified(parentId);
@@ -142,6 +272,7 @@ void LinkedItemsRepository::storeNote(const Akonadi::Item &item, bool emitSignal
         } else if (note.parentType() == QLatin1String("Opportunities")) {
             if (!parentId.isEmpty()) {
                 mOpportunityNotesHash[parentId].append(note);
+                mHistoryMemoryUsage += note.estimatedMemoryUsage();
                 mNotesOpportunityIdHash.insert(id, parentId);
                 if (emitSignals) {
                     emit opportunityModified(parentId);
@@ -161,6 +292,7 @@ void LinkedItemsRepository::storeNote(const Akonadi::Item &item, bool emitSignal
 void LinkedItemsRepository::removeNote(const QString &id)
 {
     Q_ASSERT(!id.isEmpty());
+    mEvictedNoteIds.remove(id);
 
     const QString oldAccountId = mNotesAccountIdHash.value(id);
     if (!oldAccountId.isEmpty()) {
@@ -171,6 +303,7 @@ void LinkedItemsRepository::removeNote(const QString &id)
         if (it != notes.constEnd()) {
             const int idx = std::distance(notes.constBegin(), it);
             kDebug() << "Removing note at" << idx;
+            mHistoryMemoryUsage -= notes.at(idx).estimatedMemoryUsage();
             notes.remove(idx);
             emit accountModified(oldAccountId);
         }
@@ -185,6 +318,7 @@ void LinkedItemsRepository::removeNote(const QString &id)
         if (it != notes.constEnd()) {
             const int idx = std::distance(notes.constBegin(), it);
             kDebug() << "Removing note at" << idx;
+            mHistoryMemoryUsage -= notes.at(idx).estimatedMemoryUsage();
             notes.remove(idx);
             emit contactModified(oldContactId);
         }
@@ -199,6 +333,7 @@ void LinkedItemsRepository::removeNote(const QString &id)
         if (it != notes.constEnd()) {
             const int idx = std::distance(notes.constBegin(), it);
             qCDebug(FATCRM_CLIENT_LOG) << "Removing note at" << idx;
+            mHistoryMemoryUsage -= notes.at(idx).estimatedMemoryUsage();
             notes.remove(idx);
             emit opportunityModified(oldOpportunityId);
         }
@@ -217,10 +352,18 @@ void LinkedItemsRepository::loadEmails()
     qCDebug(FATCRM_CLIENT_LOG) << "Loading" << mEmailsCollection.statistics().count() << "emails";
 
     // load emails
+    FATCRM_TRACE_ASYNC_BEGIN("akonadi", "LinkedItemsRepository::loadEmails", mEmailsCollection.id());
+    mFullTextIndex.markAllUnseen(FullTextIndex::Email);
     auto *job = new Akonadi::ItemFetchJob(mEmailsCollection, this);
-    configureItemFetchScope(job->fetchScope());
-    connect(job, &Akonadi::ItemFetchJob::itemsReceived,
-            this, &LinkedItemsRepository::slotEmailsReceived);
+    if (mArchiveTiering.isEnabled()) {
+        ItemFetchScopes::configure(job->fetchScope(), ItemFetchScopes::LinkedItemHeaders);
+        connect(job, &Akonadi::ItemFetchJob::itemsReceived,
+                this, &LinkedItemsRepository::slotEmailHeadersReceived);
+    } else {
+        configureItemFetchScope(job->fetchScope());
+        connect(job, &Akonadi::ItemFetchJob::itemsReceived,
+                this, &LinkedItemsRepository::slotEmailsReceived);
+    }
 }
 
 void LinkedItemsRepository::monitorChanges()
@@ -258,16 +401,409 @@ QVector<SugarEmail> LinkedItemsRepository::emailsForOpportunity(const QString &i
 
 void LinkedItemsRepository::slotEmailsReceived(const Akonadi::Item::List &items)
 {
+    FATCRM_TRACE_SCOPE("client", "LinkedItemsRepository::slotEmailsReceived");
+    FATCRM_TRACE_SET_COUNT(items.count());
+    ItemFetchScopes::audit(QStringLiteral("emails"), items);
     mEmailsLoaded += items.count();
+    addEmails(items);
+    //qCDebug(FATCRM_CLIENT_LOG) << "loaded" << mEmailsLoaded << "emails";
+    checkEmailsLoaded();
+}
+
+void LinkedItemsRepository::slotEmailHeadersReceived(const Akonadi::Item::List &items)
+{
+    FATCRM_TRACE_SCOPE("client", "LinkedItemsRepository::slotEmailHeadersReceived");
+    FATCRM_TRACE_SET_COUNT(items.count());
+    Akonadi::Item::List hotItems = items;
+    const Akonadi::Item::List coldItems = mArchiveTiering.takeColdItems(hotItems);
+    Akonadi::Item::List unindexedItems;
+    for (const Akonadi::Item &item : coldItems) {
+        mColdEmailIds.append(item.id());
+        if (mFullTextIndex.markSeen(FullTextIndex::Email, item.remoteId(), item.remoteRevision())) {
+            mColdHistoryParents.insert(item.id(), mFullTextIndex.parentId(FullTextIndex::Email, item.remoteId()));
+        } else {
+            unindexedItems.append(item);
+        }
+    }
+    if (!unindexedItems.isEmpty()) {
+        auto *job = new Akonadi::ItemFetchJob(unindexedItems, this);
+        configureItemFetchScope(job->fetchScope());
+        connect(job, &Akonadi::ItemFetchJob::itemsReceived,
+                this, &LinkedItemsRepository::slotColdEmailsReceived);
+    }
+    if (hotItems.isEmpty()) {
+        checkEmailsLoaded();
+        return;
+    }
+    auto *job = new Akonadi::ItemFetchJob(hotItems, this);
+    configureItemFetchScope(job->fetchScope());
+    connect(job, &Akonadi::ItemFetchJob::itemsReceived,
+            this, &LinkedItemsRepository::slotEmailsReceived);
+}
+
+void LinkedItemsRepository::slotColdEmailsReceived(const Akonadi::Item::List &items)
+{
+    FATCRM_TRACE_SCOPE("client", "LinkedItemsRepository::slotColdEmailsReceived");
+    FATCRM_TRACE_SET_COUNT(items.count());
+    for (const Akonadi::Item &item : items) {
+        if (item.hasPayload<SugarEmail>()) {
+            const SugarEmail email = item.payload<SugarEmail>();
+            if (!email.id().isEmpty()) {
+                indexEmail(email, item.remoteRevision());
+                mColdHistoryParents.insert(item.id(), email.parentId());
+            }
+        }
+    }
+}
+
+void LinkedItemsRepository::indexEmail(const SugarEmail &email, const QString &revision)
+{
+    mFullTextIndex.add(FullTextIndex::Email, email.id(), revision,
+                       email.name() + QLatin1Char('\n') + email.description(),
+                       email.parentType(), email.parentId());
+}
+
+void LinkedItemsRepository::addEmails(const Akonadi::Item::List &items)
+{
     foreach(const Akonadi::Item &item, items) {
         storeEmail(item, false);
     }
-    //qCDebug(FATCRM_CLIENT_LOG) << "loaded" << mEmailsLoaded << "emails";
-    if (mEmailsLoaded == mEmailsCollection.statistics().count()) {
+    enforceHistoryMemoryBudget();
+}
+
+void LinkedItemsRepository::checkEmailsLoaded()
+{
+    if (mEmailsLoaded + mColdEmailIds.count() == mEmailsCollection.statistics().count()) {
+        FATCRM_TRACE_ASYNC_END("akonadi", "LinkedItemsRepository::loadEmails", mEmailsCollection.id());
+        mFullTextIndex.removeUnseen(FullTextIndex::Email);
         emit emailsLoaded(mEmailsLoaded);
     }
 }
 
+static Akonadi::Item::List itemsFromIds(const QVector<Akonadi::Item::Id> &ids)
+{
+    Akonadi::Item::List items;
+    items.reserve(ids.count());
+    for (Akonadi::Item::Id id : ids) {
+        items.append(Akonadi::Item(id));
+    }
+    return items;
+}
+
+void LinkedItemsRepository::loadArchive()
+{
+    qCDebug(FATCRM_CLIENT_LOG) << "Loading" << mColdNoteIds.count() << "archived notes and" << mColdEmailIds.count() << "archived emails";
+    fetchArchivedItems(mColdNoteIds, mColdEmailIds);
+    mColdNoteIds.clear();
+    mColdEmailIds.clear();
+    mColdHistoryParents.clear();
+}
+
+// Moves the ids of parentId's items, and of those without a known parent, from coldIds to the result
+static QVector<Akonadi::Item::Id> takeColdIds(QVector<Akonadi::Item::Id> &coldIds, QHash<Akonadi::Item::Id, QString> &parents,
+                                              const QString &parentId)
+{
+    QVector<Akonadi::Item::Id> taken;
+    auto isTaken = [&](Akonadi::Item::Id id) {
+        const auto it = parents.constFind(id);
+        if (it != parents.constEnd() && *it != parentId) {
+            return false;
+        }
+        taken.append(id);
+        if (it != parents.constEnd()) {
+            parents.erase(it);
+        }
+        return true;
+    };
+    coldIds.erase(std::remove_if(coldIds.begin(), coldIds.end(), isTaken), coldIds.end());
+    return taken;
+}
+
+void LinkedItemsRepository::loadArchive(const QString &parentId)
+{
+    const QVector<Akonadi::Item::Id> noteIds = takeColdIds(mColdNoteIds, mColdHistoryParents, parentId);
+    const QVector<Akonadi::Item::Id> emailIds = takeColdIds(mColdEmailIds, mColdHistoryParents, parentId);
+    qCDebug(FATCRM_CLIENT_LOG) << "Loading" << noteIds.count() << "archived notes and" << emailIds.count() << "archived emails for" << parentId;
+    fetchArchivedItems(noteIds, emailIds);
+}
+
+bool LinkedItemsRepository::hasArchivedHistory(const QString &parentId) const
+{
+    for (const QVector<Akonadi::Item::Id> *coldIds : { &mColdNoteIds, &mColdEmailIds }) {
+        for (Akonadi::Item::Id id : *coldIds) {
+            const auto it = mColdHistoryParents.constFind(id);
+            if (it == mColdHistoryParents.constEnd() || *it == parentId) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void LinkedItemsRepository::fetchArchivedItems(const QVector<Akonadi::Item::Id> &noteIds, const QVector<Akonadi::Item::Id> &emailIds)
+{
+    const bool wasLoading = mArchiveJobs > 0;
+    if (!noteIds.isEmpty()) {
+        auto *job = new Akonadi::ItemFetchJob(itemsFromIds(noteIds), this);
+        configureItemFetchScope(job->fetchScope());
+        connect(job, &Akonadi::ItemFetchJob::itemsReceived, this, &LinkedItemsRepository::addNotes);
+        connect(job, &KJob::result, this, &LinkedItemsRepository::slotArchiveJobResult);
+        ++mArchiveJobs;
+        // Keeps checkNotesLoaded() right if the initial load is still running
+        mNotesLoaded += noteIds.count();
+    }
+    if (!emailIds.isEmpty()) {
+        auto *job = new Akonadi::ItemFetchJob(itemsFromIds(emailIds), this);
+        configureItemFetchScope(job->fetchScope());
+        connect(job, &Akonadi::ItemFetchJob::itemsReceived, this, &LinkedItemsRepository::addEmails);
+        connect(job, &KJob::result, this, &LinkedItemsRepository::slotArchiveJobResult);
+        ++mArchiveJobs;
+        mEmailsLoaded += emailIds.count();
+    }
+    if (!wasLoading && mArchiveJobs > 0) {
+        FATCRM_TRACE_ASYNC_BEGIN("akonadi", "LinkedItemsRepository::loadArchive", mNotesCollection.id());
+    }
+}
+
+bool LinkedItemsRepository::isArchiveLoaded() const
+{
+    return mColdNoteIds.isEmpty() && mColdEmailIds.isEmpty() && mArchiveJobs == 0;
+}
+
+int LinkedItemsRepository::archivedCount() const
+{
+    return mColdNoteIds.count() + mColdEmailIds.count();
+}
+
+void LinkedItemsRepository::slotArchiveJobResult(KJob *job)
+{
+    if (job->error()) {
+        qCWarning(FATCRM_CLIENT_LOG) << "Error loading archived items:" << job->errorString();
+    }
+    if (--mArchiveJobs == 0) {
+        FATCRM_TRACE_ASYNC_END("akonadi", "LinkedItemsRepository::loadArchive", mNotesCollection.id());
+        emit archiveLoaded();
+    }
+}
+
+void LinkedItemsRepository::setHistoryMemoryBudget(qint64 bytes)
+{
+    mHistoryMemoryBudget = qMax<qint64>(0, bytes);
+    enforceHistoryMemoryBudget();
+}
+
+int LinkedItemsRepository::evictedHistoryCount() const
+{
+    return mEvictedNoteIds.count() + mEvictedEmailIds.count();
+}
+
+bool LinkedItemsRepository::isHistoryBodyEvicted(const QString &id) const
+{
+    return mEvictedNoteIds.contains(id) || mEvictedEmailIds.contains(id);
+}
+
+void LinkedItemsRepository::pinHistory(const QString &parentId)
+{
+    ++mPinnedHistory[parentId];
+}
+
+void LinkedItemsRepository::unpinHistory(const QString &parentId)
+{
+    auto it = mPinnedHistory.find(parentId);
+    if (it != mPinnedHistory.end() && --it.value() == 0) {
+        mPinnedHistory.erase(it);
+        enforceHistoryMemoryBudget();
+    }
+}
+
+void LinkedItemsRepository::enforceHistoryMemoryBudget()
+{
+    if (mHistoryMemoryBudget == 0 || mHistoryMemoryUsage <= mHistoryMemoryBudget) {
+        return;
+    }
+    FATCRM_TRACE_SCOPE("client", "LinkedItemsRepository::enforceHistoryMemoryBudget");
+    // Go a bit under the budget, so that the next few items don't trigger another pass
+    const qint64 target = mHistoryMemoryBudget - mHistoryMemoryBudget / 10;
+
+    // Oldest first. The pointers stay valid, dropping a body doesn't resize the vectors.
+    struct Candidate
+    {
+        QDateTime date;
+        SugarNote *note;
+        SugarEmail *email;
+    };
+    QVector<Candidate> candidates;
+    for (NotesHash *hash : { &mAccountNotesHash, &mContactNotesHash, &mOpportunityNotesHash }) {
+        for (auto it = hash->begin(); it != hash->end(); ++it) {
+            if (mPinnedHistory.contains(it.key())) {
+                continue;
+            }
+            for (SugarNote &note : it.value()) {
+                if (!note.description().isEmpty()) {
+                    candidates.append({note.dateModified(), &note, nullptr});
+                }
+            }
+        }
+    }
+    for (EmailsHash *hash : { &mAccountEmailsHash, &mContactEmailsHash, &mOpportunityEmailsHash }) {
+        for (auto it = hash->begin(); it != hash->end(); ++it) {
+            if (mPinnedHistory.contains(it.key())) {
+                continue;
+            }
+            for (SugarEmail &email : it.value()) {
+                if (!email.description().isEmpty() || !email.descriptionHtml().isEmpty()) {
+                    candidates.append({email.dateModified(), nullptr, &email});
+                }
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate &lhs, const Candidate &rhs) {
+        return lhs.date < rhs.date;
+    });
+
+    int evicted = 0;
+    for (const Candidate &candidate : qAsConst(candidates)) {
+        if (mHistoryMemoryUsage <= target) {
+            break;
+        }
+        if (candidate.note) {
+            SugarNote &note = *candidate.note;
+            mHistoryMemoryUsage -= note.estimatedMemoryUsage();
+            note.setDescription(QString());
+            mHistoryMemoryUsage += note.estimatedMemoryUsage();
+            mEvictedNoteIds.insert(note.id());
+        } else {
+            SugarEmail &email = *candidate.email;
+            mHistoryMemoryUsage -= email.estimatedMemoryUsage();
+            email.setDescription(QString());
+            email.setDescriptionHtml(QString());
+            mHistoryMemoryUsage += email.estimatedMemoryUsage();
+            mEvictedEmailIds.insert(email.id());
+        }
+        ++evicted;
+    }
+    FATCRM_TRACE_SET_COUNT(evicted);
+    qCDebug(FATCRM_CLIENT_LOG) << "Dropped" << evicted << "note and email bodies, history now uses"
+                               << MemoryReport::formatBytes(mHistoryMemoryUsage);
+}
+
+static Akonadi::Item::List evictedItemsForParent(const QSet<QString> &evictedIds, const QString &parentId,
+                                                 std::initializer_list<const QHash<QString, QString> *> parentIdHashes)
+{
+    Akonadi::Item::List items;
+    for (const QString &id : evictedIds) {
+        for (const QHash<QString, QString> *parentIds : parentIdHashes) {
+            if (parentIds->value(id) == parentId) {
+                // Fetched by remote id, which is the Sugar id
+                Akonadi::Item item;
+                item.setRemoteId(id);
+                items.append(item);
+                break;
+            }
+        }
+    }
+    return items;
+}
+
+bool LinkedItemsRepository::loadHistoryBodies(const QString &parentId)
+{
+    if (parentId.isEmpty() || mHistoryBodiesJobs.contains(parentId)) {
+        return false;
+    }
+    const Akonadi::Item::List notes = evictedItemsForParent(mEvictedNoteIds, parentId,
+            { &mNotesAccountIdHash, &mNotesContactIdHash, &mNotesOpportunityIdHash });
+    const Akonadi::Item::List emails = evictedItemsForParent(mEvictedEmailIds, parentId,
+            { &mEmailsAccountIdHash, &mEmailsContactIdHash, &mEmailsOpportunityIdHash });
+    if (notes.isEmpty() && emails.isEmpty()) {
+        return false;
+    }
+    FATCRM_TRACE_SCOPE("client", "LinkedItemsRepository::loadHistoryBodies");
+    if (!notes.isEmpty()) {
+        auto *job = new Akonadi::ItemFetchJob(notes, this);
+        job->setCollection(mNotesCollection);
+        configureItemFetchScope(job->fetchScope());
+        job->setProperty("parentId", parentId);
+        connect(job, &Akonadi::ItemFetchJob::itemsReceived, this, &LinkedItemsRepository::addNotes);
+        connect(job, &KJob::result, this, &LinkedItemsRepository::slotHistoryBodiesJobResult);
+        ++mHistoryBodiesJobs[parentId];
+    }
+    if (!emails.isEmpty()) {
+        auto *job = new Akonadi::ItemFetchJob(emails, this);
+        job->setCollection(mEmailsCollection);
+        configureItemFetchScope(job->fetchScope());
+        job->setProperty("parentId", parentId);
+        connect(job, &Akonadi::ItemFetchJob::itemsReceived, this, &LinkedItemsRepository::addEmails);
+        connect(job, &KJob::result, this, &LinkedItemsRepository::slotHistoryBodiesJobResult);
+        ++mHistoryBodiesJobs[parentId];
+    }
+    return true;
+}
+
+void LinkedItemsRepository::slotHistoryBodiesJobResult(KJob *job)
+{
+    if (job->error()) {
+        qCWarning(FATCRM_CLIENT_LOG) << "Error loading note and email bodies:" << job->errorString();
+    }
+    const QString parentId = job->property("parentId").toString();
+    auto it = mHistoryBodiesJobs.find(parentId);
+    if (it != mHistoryBodiesJobs.end() && --it.value() == 0) {
+        mHistoryBodiesJobs.erase(it);
+        emit historyBodiesLoaded(parentId);
+    }
+}
+
+template <typename T, typename Estimator>
+static qint64 estimatedMemoryUsage(const QHash<QString, QVector<T>> &hash, int *count, Estimator estimate)
+{
+    qint64 size = 0;
+    for (const QVector<T> &values : hash) {
+        *count += values.count();
+        for (const T &value : values) {
+            size += estimate(value);
+        }
+    }
+    return size;
+}
+
+void LinkedItemsRepository::addToMemoryReport(MemoryReport &report) const
+{
+    int count = 0;
+    qint64 size = 0;
+    const auto noteSize = [](const SugarNote &note) { return note.estimatedMemoryUsage(); };
+    for (const NotesHash *hash : { &mAccountNotesHash, &mContactNotesHash, &mOpportunityNotesHash }) {
+        size += estimatedMemoryUsage(*hash, &count, noteSize);
+    }
+    report.add(QStringLiteral("Notes"), count, size);
+
+    count = 0;
+    size = 0;
+    const auto emailSize = [](const SugarEmail &email) { return email.estimatedMemoryUsage(); };
+    for (const EmailsHash *hash : { &mAccountEmailsHash, &mContactEmailsHash, &mOpportunityEmailsHash }) {
+        size += estimatedMemoryUsage(*hash, &count, emailSize);
+    }
+    report.add(QStringLiteral("Emails"), count, size);
+
+    // Documents linked to several accounts or opportunities are counted for each of them
+    count = 0;
+    size = 0;
+    const auto documentSize = [](const SugarDocument &document) { return document.estimatedMemoryUsage(); };
+    for (const DocumentsHash *hash : { &mAccountDocumentsHash, &mOpportunityDocumentsHash }) {
+        size += estimatedMemoryUsage(*hash, &count, documentSize);
+    }
+    report.add(QStringLiteral("Documents"), count, size);
+
+    count = 0;
+    size = estimatedMemoryUsage(mAccountOpportunitiesHash, &count,
+                                [](const SugarOpportunity &opp) { return opp.estimatedMemoryUsage(); });
+    report.add(QStringLiteral("Opportunities by account"), count, size);
+
+    count = 0;
+    size = estimatedMemoryUsage(mAccountContactsHash, &count, &SugarContactWrapper::estimatedMemoryUsage);
+    report.add(QStringLiteral("Contacts by account"), count, size);
+
+    report.add(QStringLiteral("Full-text index"), mFullTextIndex.documentCount(), mFullTextIndex.estimatedMemoryUsage());
+}
+
 void LinkedItemsRepository::storeEmail(const Akonadi::Item &item, bool emitSignals)
 {
     if (item.hasPayload<SugarEmail>()) {
@@ -275,10 +811,12 @@ void LinkedItemsRepository::storeEmail(const Akonadi::Item &item, bool emitSigna
         const QString id = email.id();
         Q_ASSERT(!id.isEmpty());
         removeEmail(id); // handle change of parent
+        indexEmail(email, item.remoteRevision());
         const QString parentId = email.parentId();
         if (email.parentType() == QLatin1String("Accounts")) {
             if (!parentId.isEmpty()) {
                 mAccountEmailsHash[parentId].append(email);
+                mHistoryMemoryUsage += email.estimatedMemoryUsage();
                 mEmailsAccountIdHash.insert(id, parentId);
                 if (emitSignals) {
                     emit accountModified(parentId);
@@ -289,6 +827,7 @@ void LinkedItemsRepository::storeEmail(const Akonadi::Item &item, bool emitSigna
         } else if (email.parentType() == QLatin1String("Contacts")) {
             if (!parentId.isEmpty()) {
                 mContactEmailsHash[parentId].append(email);
+                mHistoryMemoryUsage += email.estimatedMemoryUsage();
                 mEmailsContactIdHash.insert(id, parentId);
                 if (emitSignals) {
                     emit contactModified(parentId);
@@ -300,6 +839,7 @@ void LinkedItemsRepository::storeEmail(const Akonadi::Item &item, bool emitSigna
         } else if (email.parentType() == QLatin1String("Opportunities")) {
             if (!parentId.isEmpty()) {
                 mOpportunityEmailsHash[parentId].append(email);
+                mHistoryMemoryUsage += email.estimatedMemoryUsage();
                 mEmailsOpportunityIdHash.insert(id, parentId);
                 if (emitSignals) {
                     emit opportunityModified(parentId);
@@ -319,6 +859,7 @@ void LinkedItemsRepository::storeEmail(const Akonadi::Item &item, bool emitSigna
 void LinkedItemsRepository::removeEmail(const QString &id)
 {
     Q_ASSERT(!id.isEmpty());
+    mEvictedEmailIds.remove(id);
 
     const QString oldAccountId = mEmailsAccountIdHash.value(id);
     if (!oldAccountId.isEmpty()) {
@@ -329,6 +870,7 @@ void LinkedItemsRepository::removeEmail(const QString &id)
         if (it != emails.constEnd()) {
             const int idx = std::distance(emails.constBegin(), it);
             kDebug() << "Removing email at" << idx;
+            mHistoryMemoryUsage -= emails.at(idx).estimatedMemoryUsage();
             emails.remove(idx);
             emit accountModified(oldAccountId);
         }
@@ -343,6 +885,7 @@ void LinkedItemsRepository::removeEmail(const QString &id)
         if (it != emails.constEnd()) {
             const int idx = std::distance(emails.constBegin(), it);
             kDebug() << "Removing email at" << idx;
+            mHistoryMemoryUsage -= emails.at(idx).estimatedMemoryUsage();
             emails.remove(idx);
             emit contactModified(oldContactId);
         }
@@ -357,6 +900,7 @@ void LinkedItemsRepository::removeEmail(const QString &id)
         if (it != emails.constEnd()) {
             const int idx = std::distance(emails.constBegin(), it);
             qCDebug(FATCRM_CLIENT_LOG) << "Removing email at" << idx;
+            mHistoryMemoryUsage -= emails.at(idx).estimatedMemoryUsage();
             emails.remove(idx);
             emit opportunityModified(oldOpportunityId);
         }
@@ -380,6 +924,8 @@ void LinkedItemsRepository::loadDocuments()
     //qCDebug(FATCRM_CLIENT_LOG) << "Loading" << mDocumentsCollection.statistics().count() << "documents";
 
     // load documents
+    FATCRM_TRACE_ASYNC_BEGIN("akonadi", "LinkedItemsRepository::loadDocuments", mDocumentsCollection.id());
+    mFullTextIndex.markAllUnseen(FullTextIndex::Document);
     auto *job = new Akonadi::ItemFetchJob(mDocumentsCollection, this);
     configureItemFetchScope(job->fetchScope());
     connect(job, &Akonadi::ItemFetchJob::itemsReceived,
@@ -486,13 +1032,20 @@ QVector<KContacts::Addressee> LinkedItemsRepository::contactsForAccount(const QS
 
 void LinkedItemsRepository::slotDocumentsReceived(const Akonadi::Item::List &items)
 {
+    FATCRM_TRACE_SCOPE("client", "LinkedItemsRepository::slotDocumentsReceived");
+    FATCRM_TRACE_SET_COUNT(items.count());
+    ItemFetchScopes::audit(QStringLiteral("documents"), items);
     mDocumentsLoaded += items.count();
     foreach(const Akonadi::Item &item, items) {
         storeDocument(item, false);
     }
 
-    if (mDocumentsLoaded == mDocumentsCollection.statistics().count())
+    if (mDocumentsLoaded == mDocumentsCollection.statistics().count()) {
+        FATCRM_TRACE_ASYNC_END("akonadi", "LinkedItemsRepository::loadDocuments", mDocumentsCollection.id());
+        mFullTextIndex.removeUnseen(FullTextIndex::Document);
+        saveFullTextIndex();
         emit documentsLoaded(mDocumentsLoaded);
+    }
 }
 
 void LinkedItemsRepository::storeDocument(const Akonadi::Item &item, bool emitSignals)
@@ -504,6 +1057,14 @@ void LinkedItemsRepository::storeDocument(const Akonadi::Item &item, bool emitSi
 
         removeDocument(id); // handle change of opp
 
+        // Search hits lead to the account if there is one, otherwise to the opportunity
+        const QStringList accountIds = document.linkedAccountIds();
+        const bool linkedToAccount = !accountIds.isEmpty();
+        mFullTextIndex.add(FullTextIndex::Document, id, item.remoteRevision(),
+                           document.documentName() + QLatin1Char('\n') + document.description(),
+                           linkedToAccount ? QStringLiteral("Accounts") : QStringLiteral("Opportunities"),
+                           linkedToAccount ? accountIds.first() : document.linkedOpportunityIds().value(0));
+
         mDocumentsAccountIdHash.remove(id);
         mDocumentsOpportunityIdHash.remove(id);
 
@@ -560,17 +1121,17 @@ void LinkedItemsRepository::removeDocument(const QString &id)
 
 void LinkedItemsRepository::configureItemFetchScope(Akonadi::ItemFetchScope &scope)
 {
-    scope.setFetchRemoteIdentification(true); // remoteId() is used by slotItemRemoved
-    scope.setIgnoreRetrievalErrors(true);
-    scope.fetchFullPayload(true);
+    ItemFetchScopes::configure(scope, ItemFetchScopes::LinkedItems);
 }
 
 void LinkedItemsRepository::updateItem(const Akonadi::Item &item, const Akonadi::Collection &collection)
 {
     if (collection == mNotesCollection) {
         storeNote(item, true);
+        enforceHistoryMemoryBudget();
     } else if (collection == mEmailsCollection) {
         storeEmail(item, true);
+        enforceHistoryMemoryBudget();
     } else if (collection == mDocumentsCollection) {
         storeDocument(item, true);
     } else {
@@ -596,10 +1157,17 @@ void LinkedItemsRepository::slotItemRemoved(const Akonadi::Item &item)
     // Don't use the payload to handle removals (no payload anymore on removal)
     if (collection == mNotesCollection) {
         removeNote(item.remoteId());
+        mFullTextIndex.remove(FullTextIndex::Note, item.remoteId());
+        mColdNoteIds.removeOne(item.id());
+        mColdHistoryParents.remove(item.id());
     } else if (collection == mEmailsCollection) {
         removeEmail(item.remoteId());
+        mFullTextIndex.remove(FullTextIndex::Email, item.remoteId());
+        mColdEmailIds.removeOne(item.id());
+        mColdHistoryParents.remove(item.id());
     } else if (collection == mDocumentsCollection) {
         removeDocument(item.remoteId());
+        mFullTextIndex.remove(FullTextIndex::Document, item.remoteId());
     } else {
         qCWarning(FATCRM_CLIENT_LOG) << "Unexpected collection" << collection << ", expected" << mNotesCollection.id() << "," << mEmailsCollection.id() << "or" << mDocumentsCollection.id();
     }
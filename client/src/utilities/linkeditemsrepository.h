@@ -28,6 +28,8 @@
 #include "kdcrmdata/sugarnote.h"
 #include "kdcrmdata/sugaropportunity.h"
 #include "fatcrmprivate_export.h"
+#include "archivetiering.h"
+#include "fulltextindex.h"
 
 #include <AkonadiCore/Item>
 #include <AkonadiCore/Collection>
@@ -37,6 +39,8 @@
 #include <KContacts/Addressee>
 
 class CollectionManager;
+class KJob;
+class MemoryReport;
 
 namespace Akonadi
 {
@@ -55,20 +59,63 @@ class FATCRMPRIVATE_EXPORT LinkedItemsRepository : public QObject
     Q_OBJECT
 public:
     explicit LinkedItemsRepository(CollectionManager *collectionManager, QObject *parent = nullptr);
+    ~LinkedItemsRepository() override;
 
     void clear();
 
+    // Loads the full-text index from @p fileName, and saves it there once all items are loaded
+    void setFullTextIndexFile(const QString &fileName);
+    void saveFullTextIndex();
+    // Searches the names and descriptions of notes, emails and documents
+    QVector<FullTextIndex::Hit> search(const QString &query, int maxHits = 50) const;
+    const FullTextIndex &fullTextIndex() const { return mFullTextIndex; }
+
     void setNotesCollection(const Akonadi::Collection &collection);
     Akonadi::Collection notesCollection() const;
     void setEmailsCollection(const Akonadi::Collection &collection);
     void setDocumentsCollection(const Akonadi::Collection &collection);
     Akonadi::Collection documentsCollection() const;
 
+    // With archive tiering enabled, loadNotes() and loadEmails() skip the cold items
+    void setArchiveTiering(const ArchiveTiering &tiering);
+    const ArchiveTiering &archiveTiering() const { return mArchiveTiering; }
+
     void loadNotes();
     void loadEmails();
     void loadDocuments();
     void monitorChanges();
 
+    // Loads the notes and emails skipped by loadNotes() and loadEmails(), then emits archiveLoaded()
+    void loadArchive();
+    // Same, only for those of one account, contact or opportunity (and those whose parent isn't known yet)
+    void loadArchive(const QString &parentId);
+    bool hasArchivedHistory(const QString &parentId) const;
+    bool isArchiveLoaded() const;
+    int archivedCount() const;
+
+    // Stores notes and emails fetched with their payload, like the initial load does
+    void addNotes(const Akonadi::Item::List &items);
+    void addEmails(const Akonadi::Item::List &items);
+
+    // Caps the memory used by the notes and emails, 0 meaning no limit. Over the budget, the bodies
+    // of the oldest ones are dropped (they stay in Akonadi), except for the pinned parents.
+    void setHistoryMemoryBudget(qint64 bytes);
+    qint64 historyMemoryBudget() const { return mHistoryMemoryBudget; }
+    qint64 historyMemoryUsage() const { return mHistoryMemoryUsage; }
+    int evictedHistoryCount() const;
+    // True if the body of this note or email was dropped: its description is empty in the copies
+    // returned by notesForAccount() and friends until loadHistoryBodies() brings it back
+    bool isHistoryBodyEvicted(const QString &id) const;
+
+    // Keeps the note and email bodies of an account, contact or opportunity while they are shown
+    void pinHistory(const QString &parentId);
+    void unpinHistory(const QString &parentId);
+    // Fetches the bodies dropped for @p parentId, then emits historyBodiesLoaded().
+    // Returns false if there is nothing to fetch.
+    bool loadHistoryBodies(const QString &parentId);
+
+    void addToMemoryReport(MemoryReport &report) const;
+
     QVector<SugarNote> notesForAccount(const QString &id) const;
     QVector<SugarNote> notesForContact(const QString &id) const;
     QVector<SugarNote> notesForOpportunity(const QString &id) const;
@@ -95,6 +142,8 @@ signals:
     void notesLoaded(int count);
     void emailsLoaded(int count);
     void documentsLoaded(int count);
+    void archiveLoaded();
+    void historyBodiesLoaded(const QString &parentId);
 
     // Emitted when notes, emails or documents for this account have been modified.
     void accountModified(const QString &accountId);
@@ -112,15 +161,28 @@ private Q_SLOTS:
     void slotEmailsReceived(const Akonadi::Item::List &items);
     void slotDocumentsReceived(const Akonadi::Item::List &items);
 
+    void slotNoteHeadersReceived(const Akonadi::Item::List &items);
+    void slotEmailHeadersReceived(const Akonadi::Item::List &items);
+    void slotColdNotesReceived(const Akonadi::Item::List &items);
+    void slotColdEmailsReceived(const Akonadi::Item::List &items);
+    void slotArchiveJobResult(KJob *job);
+    void slotHistoryBodiesJobResult(KJob *job);
+
 private:
+    void checkNotesLoaded();
+    void checkEmailsLoaded();
     void storeNote(const Akonadi::Item &item, bool emitSignals);
+    void indexNote(const SugarNote &note, const QString &revision);
+    void indexEmail(const SugarEmail &email, const QString &revision);
     void removeNote(const QString &id);
     void storeEmail(const Akonadi::Item &item, bool emitSignals);
     void removeEmail(const QString &id);
     void storeDocument(const Akonadi::Item &item, bool emitSignals);
     void removeDocument(const QString &id);
     void configureItemFetchScope(Akonadi::ItemFetchScope &scope);
+    void enforceHistoryMemoryBudget();
     void updateItem(const Akonadi::Item &item, const Akonadi::Collection &collection);
+    void fetchArchivedItems(const QVector<Akonadi::Item::Id> &noteIds, const QVector<Akonadi::Item::Id> &emailIds);
 
     Akonadi::Collection mNotesCollection;
     Akonadi::Monitor *mMonitor;
@@ -157,6 +219,22 @@ private:
     OpportunitiesHash mAccountOpportunitiesHash;
     ContactsHash mAccountContactsHash;
 
+    FullTextIndex mFullTextIndex;
+    QString mFullTextIndexFile;
+
+    ArchiveTiering mArchiveTiering;
+    QVector<Akonadi::Item::Id> mColdNoteIds; // not loaded yet, see loadArchive()
+    QVector<Akonadi::Item::Id> mColdEmailIds;
+    QHash<Akonadi::Item::Id, QString> mColdHistoryParents; // when the full-text index knows them
+    int mArchiveJobs = 0;
+
+    qint64 mHistoryMemoryBudget = 0;
+    qint64 mHistoryMemoryUsage = 0; // estimated size of the notes and emails
+    QSet<QString> mEvictedNoteIds; // stored without their description
+    QSet<QString> mEvictedEmailIds;
+    QHash<QString, int> mPinnedHistory; // parent id -> pin count
+    QHash<QString, int> mHistoryBodiesJobs; // parent id -> running fetch jobs
+
     CollectionManager *mCollectionManager;
 };
 
@@ -0,0 +1,67 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "memoryreport.h"
+
+#include <QLocale>
+
+void MemoryReport::add(const QString &name, int count, qint64 bytes)
+{
+    mEntries.append({name, count, bytes});
+}
+
+qint64 MemoryReport::totalBytes() const
+{
+    qint64 total = 0;
+    for (const Entry &entry : mEntries) {
+        total += entry.bytes;
+    }
+    return total;
+}
+
+QString MemoryReport::toString() const
+{
+    int nameWidth = 0;
+    for (const Entry &entry : mEntries) {
+        nameWidth = qMax(nameWidth, entry.name.length());
+    }
+    QString result;
+    for (const Entry &entry : mEntries) {
+        result += QStringLiteral("%1 %2 items %3\n")
+                .arg(entry.name, -nameWidth)
+                .arg(entry.count, 8)
+                .arg(formatBytes(entry.bytes), 10);
+    }
+    result += QStringLiteral("%1 %2\n").arg(QStringLiteral("Total"), -(nameWidth + 15)).arg(formatBytes(totalBytes()), 10);
+    return result;
+}
+
+QString MemoryReport::formatBytes(qint64 bytes)
+{
+    // QLocale::formattedDataSize needs Qt 5.10
+    const QLocale locale = QLocale::c();
+    if (bytes < 1024) {
+        return QStringLiteral("%1 B").arg(bytes);
+    }
+    if (bytes < 1024 * 1024) {
+        return QStringLiteral("%1 KiB").arg(locale.toString(bytes / 1024.0, 'f', 1));
+    }
+    return QStringLiteral("%1 MiB").arg(locale.toString(bytes / (1024.0 * 1024.0), 'f', 1));
+}
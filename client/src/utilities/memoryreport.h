@@ -0,0 +1,60 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef MEMORYREPORT_H
+#define MEMORYREPORT_H
+
+#include "fatcrmprivate_export.h"
+
+#include <QString>
+#include <QVector>
+
+/**
+ * Collects the estimated memory used by the client-side stores
+ * (models, repositories, reference data), for the about dialog and D-Bus.
+ *
+ * The sizes come from the estimatedMemoryUsage() methods of the kdcrmdata
+ * value types, so they are estimates of the heap usage, not exact figures.
+ */
+class FATCRMPRIVATE_EXPORT MemoryReport
+{
+public:
+    struct Entry
+    {
+        QString name;
+        int count;
+        qint64 bytes;
+    };
+
+    void add(const QString &name, int count, qint64 bytes);
+
+    QVector<Entry> entries() const { return mEntries; }
+    qint64 totalBytes() const;
+
+    // One line per entry, then the total
+    QString toString() const;
+
+    static QString formatBytes(qint64 bytes);
+
+private:
+    QVector<Entry> mEntries;
+};
+
+#endif // MEMORYREPORT_H
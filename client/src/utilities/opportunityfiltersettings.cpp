@@ -21,13 +21,20 @@
 */
 
 #include "opportunityfiltersettings.h"
+#include "accountrepository.h"
+#include "clientsettings.h"
+#include "referenceddata.h"
+
 #include "kdcrmdata/kdcrmutils.h"
+#include "kdcrmdata/sugaropportunity.h"
 
 #include <KLocalizedString>
 
 #include <QSettings>
 #include <QDebug>
 
+#include <algorithm>
+
 OpportunityFilterSettings::OpportunityFilterSettings()
 {
 }
@@ -140,6 +147,119 @@ QString OpportunityFilterSettings::filterDescription() const
     return txt;
 }
 
+bool OpportunityFilterSettings::matches(const SugarOpportunity &opportunity) const
+{
+    if (!mAssignees.isEmpty() && !mAssignees.contains(opportunity.assignedUserName()))
+        return false;
+
+    if (!mCountries.isEmpty()) {
+        const QString country = AccountRepository::instance()->accountById(opportunity.accountId()).countryForGui();
+        if (mCountries.contains(otherCountriesSpecialValue())) {
+            // Special case: filtering for a country not in any of the defined groups
+            QVector<ClientSettings::GroupFilters::Group> groups = ClientSettings::self()->countryFilters().groups();
+            const auto it = std::find_if(groups.constBegin(), groups.constEnd(),
+                                         [&country](const ClientSettings::GroupFilters::Group &group){
+                return group.entries.contains(country, Qt::CaseInsensitive); });
+            if (it != groups.constEnd())
+                return false;
+        } else {
+            // Standard filtering using a country group
+            if (!mCountries.contains(country, Qt::CaseInsensitive))
+                return false;
+        }
+    }
+
+    const auto salesStage = opportunity.salesStage();
+    const bool isClosedWon = salesStage.contains(QLatin1String("Closed Won"));
+    const bool isClosedLost = salesStage.contains(QLatin1String("Closed Lost"));
+    if (!mShowClosedWon && isClosedWon)
+        return false;
+    if (!mShowClosedLost && isClosedLost)
+        return false;
+    if (!mShowOpen && !isClosedWon && !isClosedLost)
+        return false;
+    if (mMaxDate.isValid() && (!opportunity.nextCallDate().isValid()
+                               || opportunity.nextCallDate() > mMaxDate))
+        return false;
+    if (mModifiedAfter.isValid() && opportunity.dateModified().date() < mModifiedAfter)
+        return false;
+    if (mModifiedBefore.isValid() && opportunity.dateModified().date() > mModifiedBefore)
+        return false;
+
+    QString shownPriority = mShownPriority;
+    if (shownPriority == "Not set") // "Not set" is much clearer to me than just a blank space (like the WebUI has)
+        shownPriority = "";
+    if (shownPriority != "-" && opportunity.opportunityPriority().toUpper() != shownPriority)
+        return false;
+
+    return true;
+}
+
+bool OpportunityFilterSettings::matchesSearchText(const SugarOpportunity &opportunity, const QString &text)
+{
+    if (opportunity.name().contains(text, Qt::CaseInsensitive)) {
+        return true;
+    }
+    const QString accountName = ReferencedData::instance(AccountRef)->referencedData(opportunity.accountId());
+    if (accountName.contains(text, Qt::CaseInsensitive)) {
+        return true;
+    }
+    if (opportunity.salesStage().contains(text, Qt::CaseInsensitive)) {
+        return true;
+    }
+    if (opportunity.amount().contains(text, Qt::CaseInsensitive)) {
+        return true;
+    }
+    if (opportunity.dateClosed().contains(text, Qt::CaseInsensitive)) {
+        return true;
+    }
+    if (opportunity.assignedUserName().contains(text, Qt::CaseInsensitive)) {
+        return true;
+    }
+    if (opportunity.opportunitySize().contains(text, Qt::CaseInsensitive)) {
+        return true;
+    }
+
+    return false;
+}
+
+bool OpportunityFilterSettings::hasSameFilter(const OpportunityFilterSettings &other) const
+{
+    return mAssignees == other.mAssignees
+            && mCountries == other.mCountries
+            && mShowOpen == other.mShowOpen
+            && mShowClosedWon == other.mShowClosedWon
+            && mShowClosedLost == other.mShowClosedLost
+            && mMaxDate == other.mMaxDate
+            && mModifiedAfter == other.mModifiedAfter
+            && mModifiedBefore == other.mModifiedBefore
+            && mShownPriority == other.mShownPriority;
+}
+
+QDate OpportunityFilterSettings::maxDateForIndex(MaxNextStepDate index, const QDate &customMaxDate, const QDate &today)
+{
+    switch (index) {
+    case NoDate: // Any
+        return QDate();
+    case OneMonthAgo:
+        return today.addDays(-31);
+    case Today:
+        return today;
+    case EndOfThisWeek: // i.e. next Sunday
+        // Ex: dayOfWeek = 3 (Wednesday), must add 4 days.
+        return today.addDays(7 - today.dayOfWeek());
+    case EndOfThisMonth:
+        return QDate(today.year(), today.month(), today.daysInMonth());
+    case OneMonthFromNow:
+        return today.addDays(31);
+    case EndOfThisYear:
+        return QDate(today.year(), 12, 31);
+    case CustomDate: // User selection
+        return customMaxDate;
+    }
+    return QDate();
+}
+
 void OpportunityFilterSettings::save(QSettings &settings, const QString &prefix) const
 {
     // I'm not using settings.beginGroup(prefix) because
@@ -27,6 +27,7 @@
 #include <QDate>
 #include "enums.h"
 class QSettings;
+class SugarOpportunity;
 
 /**
  * Filter opportunities by assignees OR by country.
@@ -34,7 +35,7 @@ class QSettings;
  * And either open, or closed, or both.
  * And a possible range of "modified date".
  */
-class OpportunityFilterSettings
+class FATCRMPRIVATE_EXPORT OpportunityFilterSettings
 {
 public:
     OpportunityFilterSettings();
@@ -68,6 +69,19 @@ public:
 
     QString filterDescription() const;
 
+    /// Returns true if @p opportunity passes this filter, not taking the search text into account
+    /// (see matchesSearchText). The country comes from AccountRepository, so it must be filled already.
+    bool matches(const SugarOpportunity &opportunity) const;
+    /// Returns true if @p text appears in one of the fields searched in the opportunities page
+    static bool matchesSearchText(const SugarOpportunity &opportunity, const QString &text);
+    /// Returns true if this filter lets the same opportunities through as @p other.
+    /// Only the effective values are compared, not the group names, the search name or the search text.
+    bool hasSameFilter(const OpportunityFilterSettings &other) const;
+
+    /// Returns the max next step date selected by @p index, relative to @p today.
+    /// The custom date is only used for CustomDate.
+    static QDate maxDateForIndex(MaxNextStepDate index, const QDate &customMaxDate, const QDate &today = QDate::currentDate());
+
     static QString otherCountriesSpecialValue() { return QLatin1String("_OTHER_"); }
 
     void save(QSettings &settings, const QString &prefix) const;
@@ -21,6 +21,10 @@
 */
 
 #include "referenceddata.h"
+#include "memoryreport.h"
+
+#include "kdcrmdata/kdcrmtrace.h"
+#include "kdcrmdata/kdcrmutils.h"
 
 #include <QVector>
 #include <QMap>
@@ -116,6 +120,8 @@ void ReferencedData::setReferencedDataInternal(const QString &id, const QString
 
 void ReferencedData::addMap(const QMap<QString, QString> &idDataMap, bool emitChanges)
 {
+    FATCRM_TRACE_SCOPE("client", "ReferencedData::addMap");
+    FATCRM_TRACE_SET_COUNT(idDataMap.count());
     auto it = idDataMap.constBegin();
     const auto end = idDataMap.constEnd();
     if (d->mVector.isEmpty()) {
@@ -194,6 +200,28 @@ void ReferencedData::emitInitialLoadingDone()
     emit initialLoadingDone();
 }
 
+void ReferencedData::addToMemoryReport(MemoryReport &report) const
+{
+    qint64 size = d->mVector.capacity() * qint64(sizeof(KeyValue));
+    for (const KeyValue &keyValue : qAsConst(d->mVector)) {
+        size += KDCRMUtils::memoryUsage(keyValue.key) + KDCRMUtils::memoryUsage(keyValue.value);
+    }
+    QString name;
+    switch (d->mType) {
+    case AccountRef: name = QStringLiteral("Account names"); break;
+    case AssignedToRef: name = QStringLiteral("User names"); break;
+    case ContactRef: name = QStringLiteral("Contact names"); break;
+    }
+    report.add(name, d->mVector.count(), size);
+}
+
+void ReferencedData::addAllToMemoryReport(MemoryReport &report)
+{
+    for (const ReferencedData *data : qAsConst(s_instances()->map)) {
+        data->addToMemoryReport(report);
+    }
+}
+
 ReferencedData::ReferencedData(ReferencedDataType type, QObject *parent)
     : QObject(parent), d(new Private(type))
 {
@@ -29,6 +29,7 @@
 #include <QObject>
 
 template <typename K, typename V> class QMap;
+class MemoryReport;
 
 struct KeyValue
 {
@@ -87,6 +88,9 @@ public:
 
     static void emitInitialLoadingDoneForAll();
 
+    void addToMemoryReport(MemoryReport &report) const;
+    static void addAllToMemoryReport(MemoryReport &report);
+
 Q_SIGNALS:
     void dataChanged(int row);
     void rowsAboutToBeInserted(int start, int end);
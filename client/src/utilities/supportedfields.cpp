@@ -0,0 +1,103 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "supportedfields.h"
+
+#include <QHash>
+#include <QVector>
+
+namespace {
+struct FieldNumbers
+{
+    QHash<QString, int> numbers;
+    QStringList names; // index = number
+};
+}
+
+Q_GLOBAL_STATIC(FieldNumbers, s_fieldNumbers)
+
+static int registerField(const QString &field)
+{
+    FieldNumbers *fieldNumbers = s_fieldNumbers();
+    auto it = fieldNumbers->numbers.constFind(field);
+    if (it != fieldNumbers->numbers.constEnd()) {
+        return *it;
+    }
+    const int number = fieldNumbers->names.count();
+    fieldNumbers->numbers.insert(field, number);
+    fieldNumbers->names.append(field);
+    return number;
+}
+
+SupportedFields::SupportedFields(const QStringList &fields)
+{
+    QVector<int> numbers;
+    numbers.reserve(fields.count());
+    for (const QString &field : fields) {
+        numbers.append(registerField(field));
+    }
+    mBits.resize(s_fieldNumbers()->names.count());
+    for (int number : qAsConst(numbers)) {
+        mBits.setBit(number);
+    }
+    mCount = mBits.count(true);
+}
+
+bool SupportedFields::contains(const QString &field) const
+{
+    return contains(fieldNumber(field));
+}
+
+bool SupportedFields::contains(int fieldNumber) const
+{
+    return fieldNumber >= 0 && fieldNumber < mBits.size() && mBits.testBit(fieldNumber);
+}
+
+QStringList SupportedFields::toStringList() const
+{
+    const QStringList &names = s_fieldNumbers()->names;
+    QStringList fields;
+    fields.reserve(mCount);
+    for (int number = 0; number < mBits.size(); ++number) {
+        if (mBits.testBit(number)) {
+            fields.append(names.at(number));
+        }
+    }
+    return fields;
+}
+
+bool SupportedFields::operator==(const SupportedFields &other) const
+{
+    // The bitsets can have different sizes, if more fields were numbered in between
+    if (mCount != other.mCount) {
+        return false;
+    }
+    for (int number = 0; number < mBits.size(); ++number) {
+        if (mBits.testBit(number) && !other.contains(number)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int SupportedFields::fieldNumber(const QString &field)
+{
+    return s_fieldNumbers()->numbers.value(field, -1);
+}
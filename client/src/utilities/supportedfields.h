@@ -0,0 +1,64 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SUPPORTEDFIELDS_H
+#define SUPPORTEDFIELDS_H
+
+#include "fatcrmprivate_export.h"
+
+#include <QBitArray>
+#include <QStringList>
+
+/**
+ * The fields supported by a collection, as listed by the resource in the collection's
+ * EntityAnnotationsAttribute.
+ *
+ * Stored as a bitset over all the field names seen so far (each name gets a number the first
+ * time it's seen), so that contains() is a hash lookup and a bit test, instead of a string
+ * comparison with every supported field. The numbering is shared by all instances,
+ * which must only be used from the GUI thread.
+ */
+class FATCRMPRIVATE_EXPORT SupportedFields
+{
+public:
+    SupportedFields() = default;
+    explicit SupportedFields(const QStringList &fields);
+
+    bool contains(const QString &field) const;
+    bool contains(int fieldNumber) const;
+
+    bool isEmpty() const { return mCount == 0; }
+    int count() const { return mCount; }
+
+    /// Returns the field names, in the order they were first seen
+    QStringList toStringList() const;
+
+    bool operator==(const SupportedFields &other) const;
+    bool operator!=(const SupportedFields &other) const { return !operator==(other); }
+
+    /// Returns the number of @p field in the bitsets, or -1 if no SupportedFields ever contained it
+    static int fieldNumber(const QString &field);
+
+private:
+    QBitArray mBits;
+    int mCount = 0;
+};
+
+#endif // SUPPORTEDFIELDS_H
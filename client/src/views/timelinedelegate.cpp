@@ -0,0 +1,173 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "timelinedelegate.h"
+#include "timelinemodel.h"
+
+#include <QAbstractItemView>
+#include <QAbstractTextDocumentLayout>
+#include <QApplication>
+#include <QPainter>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTimer>
+#include <QtMath>
+
+static const int s_defaultMaximumCachedLayouts = 200;
+static const int s_separatorHeight = 1;
+
+static void fillDocument(QTextDocument *document, const QModelIndex &index)
+{
+    document->setHtml(index.data(TimelineModel::HtmlHeaderRole).toString());
+    QTextCursor cursor(document);
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertBlock(QTextBlockFormat());
+    const QString text = index.data(TimelineModel::TextRole).toString();
+    if (index.data(TimelineModel::IsHtmlRole).toBool())
+        cursor.insertHtml(text);
+    else
+        cursor.insertText(text);
+}
+
+TimelineDelegate::TimelineDelegate(QObject *parent)
+    : QStyledItemDelegate(parent),
+      mLayouts(s_defaultMaximumCachedLayouts)
+{
+}
+
+TimelineDelegate::~TimelineDelegate()
+{
+}
+
+void TimelineDelegate::setMaximumCachedLayouts(int count)
+{
+    mLayouts.setMaxCost(count);
+}
+
+void TimelineDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    QStyleOptionViewItem opt = option;
+    initStyleOption(&opt, index);
+    opt.text.clear();
+    const QWidget *widget = option.widget;
+    const QStyle *style = widget ? widget->style() : QApplication::style();
+    style->drawPrimitive(QStyle::PE_PanelItemViewItem, &opt, painter, widget);
+
+    QTextDocument *document = layout(option, index);
+
+    painter->save();
+    painter->translate(option.rect.topLeft());
+    const QRect clip(QPoint(0, 0), option.rect.size());
+    painter->setClipRect(clip);
+    QAbstractTextDocumentLayout::PaintContext context;
+    context.clip = clip;
+    context.palette = option.palette;
+    if (option.state & QStyle::State_Selected)
+        context.palette.setColor(QPalette::Text, option.palette.color(QPalette::HighlightedText));
+    document->documentLayout()->draw(painter, context);
+    painter->setPen(option.palette.color(QPalette::Mid));
+    painter->drawLine(0, clip.height() - s_separatorHeight, clip.width(), clip.height() - s_separatorHeight);
+    painter->restore();
+
+    // The row was sized using an estimate, let the view use the real height instead.
+    // The view lays out all rows again on sizeHintChanged(), so do it once after painting.
+    const int height = mHeights.value(index.data(TimelineModel::LayoutKeyRole).value<quint64>());
+    if (height != option.rect.height() && !mRelayoutPending) {
+        mRelayoutPending = true;
+        auto *that = const_cast<TimelineDelegate *>(this);
+        const QPersistentModelIndex persistentIndex(index);
+        QTimer::singleShot(0, that, [that, persistentIndex]() {
+            that->mRelayoutPending = false;
+            if (persistentIndex.isValid())
+                emit that->sizeHintChanged(persistentIndex);
+        });
+    }
+}
+
+QSize TimelineDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    const int width = availableWidth(option);
+    checkWidth(width);
+    const quint64 key = index.data(TimelineModel::LayoutKeyRole).value<quint64>();
+    const auto measured = mHeights.constFind(key);
+    if (measured != mHeights.constEnd())
+        return QSize(width, *measured);
+    auto estimated = mEstimatedHeights.constFind(key);
+    if (estimated == mEstimatedHeights.constEnd())
+        estimated = mEstimatedHeights.insert(key, estimatedHeight(option, index));
+    return QSize(width, *estimated);
+}
+
+QString TimelineDelegate::plainText(const QModelIndex &index) const
+{
+    QTextDocument document;
+    fillDocument(&document, index);
+    return document.toPlainText();
+}
+
+QTextDocument *TimelineDelegate::layout(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    const int width = availableWidth(option);
+    checkWidth(width);
+    const quint64 key = index.data(TimelineModel::LayoutKeyRole).value<quint64>();
+    QTextDocument *document = mLayouts.object(key);
+    if (!document) {
+        document = new QTextDocument;
+        document->setDefaultFont(option.font);
+        fillDocument(document, index);
+        document->setTextWidth(width);
+        mLayouts.insert(key, document);
+        mHeights.insert(key, qCeil(document->size().height()) + s_separatorHeight);
+    }
+    return document;
+}
+
+// Cheap approximation of the height of the laid out entry, without laying it out
+int TimelineDelegate::estimatedHeight(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    const QFontMetrics &fontMetrics = option.fontMetrics;
+    const int lineSpacing = fontMetrics.lineSpacing();
+    const int charsPerLine = qMax(1, availableWidth(option) / qMax(1, fontMetrics.averageCharWidth()));
+    const QString text = index.data(TimelineModel::TextRole).toString();
+    // markup does not take room, guess that it is about half of an HTML text
+    const int length = index.data(TimelineModel::IsHtmlRole).toBool() ? text.length() / 2 : text.length();
+    const int textLines = text.count(QLatin1Char('\n')) + length / charsPerLine + 1;
+    const int headerHeight = 5 * lineSpacing; // a large title, a medium subtitle and a line or two
+    return headerHeight + textLines * lineSpacing + s_separatorHeight;
+}
+
+void TimelineDelegate::checkWidth(int width) const
+{
+    // Layouts and heights are only valid for one width: forget them when the view is resized
+    if (width != mWidth) {
+        mLayouts.clear();
+        mHeights.clear();
+        mEstimatedHeights.clear();
+        mWidth = width;
+    }
+}
+
+int TimelineDelegate::availableWidth(const QStyleOptionViewItem &option)
+{
+    // QListView doesn't give a rect to sizeHint(), use the width of the viewport
+    if (const auto *view = qobject_cast<const QAbstractItemView *>(option.widget))
+        return qMax(1, view->viewport()->width());
+    return qMax(1, option.rect.width());
+}
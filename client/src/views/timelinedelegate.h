@@ -0,0 +1,72 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef TIMELINEDELEGATE_H
+#define TIMELINEDELEGATE_H
+
+#include "fatcrmprivate_export.h"
+
+#include <QCache>
+#include <QHash>
+#include <QStyledItemDelegate>
+
+class QTextDocument;
+
+/**
+ * Renders the entries of a TimelineModel (header, then HTML or plain text body) in a list view.
+ *
+ * Rows which were never painted get an estimated height, computed from the text length.
+ * Only painted rows are laid out: their exact height replaces the estimate (through sizeHintChanged()),
+ * and their layout is kept in a cache of bounded size, so that scrolling back does not lay them out again.
+ */
+class FATCRMPRIVATE_EXPORT TimelineDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+public:
+    explicit TimelineDelegate(QObject *parent = nullptr);
+    ~TimelineDelegate() override;
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+    // Maximum number of laid out entries kept in memory
+    void setMaximumCachedLayouts(int count);
+    int cachedLayoutCount() const { return mLayouts.count(); }
+    // Number of entries whose exact height is known, i.e. which were laid out at the current width
+    int measuredCount() const { return mHeights.count(); }
+
+    // The entry as plain text, e.g. for copying it to the clipboard
+    QString plainText(const QModelIndex &index) const;
+
+private:
+    QTextDocument *layout(const QStyleOptionViewItem &option, const QModelIndex &index) const;
+    int estimatedHeight(const QStyleOptionViewItem &option, const QModelIndex &index) const;
+    void checkWidth(int width) const;
+    static int availableWidth(const QStyleOptionViewItem &option);
+
+    // Keyed by TimelineModel::LayoutKeyRole, valid for mWidth
+    mutable QCache<quint64, QTextDocument> mLayouts;
+    mutable QHash<quint64, int> mHeights;
+    mutable QHash<quint64, int> mEstimatedHeights;
+    mutable int mWidth = -1;
+    mutable bool mRelayoutPending = false;
+};
+
+#endif // TIMELINEDELEGATE_H
@@ -80,6 +80,7 @@ cmake . -DCMAKE_INSTALL_PREFIX=/usr -DCMAKE_BUILD_TYPE=Release
 %{_prefix}/share/akonadi/plugins/serializer/akonadi_serializer_*.desktop
 %{_prefix}/share/mime/packages/kdabcrm-mime.xml
 %{_prefix}/bin/fatcrm
+%{_prefix}/bin/fatcrm-export
 %{_prefix}/bin/fatcrminvoker
 %{_prefix}/bin/akonadi_salesforce_resource
 %{_prefix}/bin/akonadi_sugarcrm_resource
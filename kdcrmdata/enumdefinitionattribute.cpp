@@ -30,14 +30,27 @@ EnumDefinitionAttribute::EnumDefinitionAttribute()
 {
 }
 
+void EnumDefinitionAttribute::setEnumDefinitions(const EnumDefinitions &definitions)
+{
+    mData = definitions.toBinary();
+}
+
+EnumDefinitions EnumDefinitionAttribute::enumDefinitions() const
+{
+    if (EnumDefinitions::isBinary(mData)) {
+        return EnumDefinitions::fromBinary(mData);
+    }
+    return EnumDefinitions::fromString(QString::fromUtf8(mData));
+}
+
 void EnumDefinitionAttribute::setValue(const QString &value)
 {
-    mValue = value;
+    setEnumDefinitions(EnumDefinitions::fromString(value));
 }
 
 QString EnumDefinitionAttribute::value() const
 {
-    return mValue;
+    return enumDefinitions().toString();
 }
 
 QByteArray EnumDefinitionAttribute::type() const
@@ -48,17 +61,16 @@ QByteArray EnumDefinitionAttribute::type() const
 Akonadi::Attribute *EnumDefinitionAttribute::clone() const
 {
     auto *attr = new EnumDefinitionAttribute;
-    attr->setValue(mValue);
+    attr->mData = mData;
     return attr;
 }
 
 QByteArray EnumDefinitionAttribute::serialized() const
 {
-    const QByteArray result = mValue.toUtf8();
-    return result;
+    return mData;
 }
 
 void EnumDefinitionAttribute::deserialize(const QByteArray &data)
 {
-    mValue = QString::fromUtf8(data);
+    mData = data;
 }
@@ -23,6 +23,7 @@
 #ifndef ENUMDEFINITIONATTRIBUTE_H
 #define ENUMDEFINITIONATTRIBUTE_H
 #include "kdcrmdata_export.h"
+#include "enumdefinitions.h"
 #include <AkonadiCore/Attribute>
 #include <QMap>
 #include <QString>
@@ -39,6 +40,11 @@ public:
     // to reuse the attribute class, but AttributeFactory::registerAttribute expects
     // a default ctor and a constant type()....
 
+    void setEnumDefinitions(const EnumDefinitions &definitions);
+    // Decodes both the binary format and the text format written by older versions
+    EnumDefinitions enumDefinitions() const;
+
+    // Text format (EnumDefinitions::toString)
     void setValue(const QString &value);
     QString value() const;
 
@@ -48,7 +54,7 @@ public:
     void deserialize(const QByteArray &data) override;
 
 private:
-    QString mValue;
+    QByteArray mData;
 };
 
 #endif
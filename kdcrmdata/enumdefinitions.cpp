@@ -20,8 +20,13 @@
 
 #include "enumdefinitions.h"
 
+#include <QDataStream>
 #include <QStringList>
 
+// Marks the binary format. The text format starts with an enum name, never with a NUL byte.
+static const char s_binaryMagic[] = { '\0', 'E', 'N', 'M' };
+static const quint8 s_binaryVersion = 1;
+
 QString EnumDefinitions::Enum::toString() const
 {
     QString ret = mEnumName;
@@ -36,12 +41,36 @@ QString EnumDefinitions::Enum::toString() const
     return ret;
 }
 
+void EnumDefinitions::Enum::updateKeyIndex() const
+{
+    if (mIndexedCount > mEnumValues.count()) { // values were removed, start over
+        mKeyIndex.clear();
+        mIndexedCount = 0;
+    }
+    if (mKeyIndex.isEmpty()) {
+        mKeyIndex.reserve(mEnumValues.count());
+    }
+    for (int i = mIndexedCount; i < mEnumValues.count(); ++i) {
+        // first one wins, like the linear search used to do
+        if (!mKeyIndex.contains(mEnumValues.at(i).key)) {
+            mKeyIndex.insert(mEnumValues.at(i).key, i);
+        }
+    }
+    mIndexedCount = mEnumValues.count();
+}
+
+int EnumDefinitions::Enum::indexOf(const QString &key) const
+{
+    if (mIndexedCount != mEnumValues.count()) {
+        updateKeyIndex();
+    }
+    return mKeyIndex.value(key, -1);
+}
+
 QString EnumDefinitions::Enum::value(const QString &key) const
 {
-    const auto it = std::find_if(mEnumValues.constBegin(), mEnumValues.constEnd(), [key](const KeyValue &keyVal) {
-        return keyVal.key == key;
-    });
-    return it != mEnumValues.constEnd() ? it->value : QString();
+    const int pos = indexOf(key);
+    return pos > -1 ? mEnumValues.at(pos).value : QString();
 }
 
 EnumDefinitions::Enum EnumDefinitions::Enum::fromString(const QString &str)
@@ -49,6 +78,7 @@ EnumDefinitions::Enum EnumDefinitions::Enum::fromString(const QString &str)
     const int nameSep = str.indexOf('|');
     Q_ASSERT(nameSep > -1);
     Enum ret(str.left(nameSep));
+    ret.mEnumValues.reserve(str.count('|') - 1);
     int pos = nameSep + 1;
     while (pos < str.length()) {
         const int sep = str.indexOf(':', pos);
@@ -70,21 +100,26 @@ EnumDefinitions::EnumDefinitions()
 {
 }
 
-int EnumDefinitions::indexOf(const QString &enumName) const
+void EnumDefinitions::append(const Enum &e)
 {
-    for (size_t i = 0; i < mDefinitions.size(); ++i) {
-        if (mDefinitions.at(i).mEnumName == enumName) {
-            return i;
-        }
+    if (!mNameIndex.contains(e.mEnumName)) {
+        mNameIndex.insert(e.mEnumName, mDefinitions.size());
     }
-    return -1;
+    mDefinitions.append(e);
+    // index now, so that lookups on (shared) copies don't need to modify anything
+    mDefinitions.last().updateKeyIndex();
+}
+
+int EnumDefinitions::indexOf(const QString &enumName) const
+{
+    return mNameIndex.value(enumName, -1);
 }
 
 // E.g. "lead_source|Key1:Value1|Key2:Value2|Key3:Value3|%another_enum|K:V"
 QString EnumDefinitions::toString() const
 {
     QString ret;
-    for (size_t i = 0; i < mDefinitions.size(); ++i) {
+    for (int i = 0; i < mDefinitions.size(); ++i) {
         ret += mDefinitions.at(i).toString();
         if (i + 1 < mDefinitions.size()) {
             ret += '%';
@@ -96,11 +131,78 @@ QString EnumDefinitions::toString() const
 EnumDefinitions EnumDefinitions::fromString(const QString &str)
 {
     EnumDefinitions ret;
-    // a bit slow but I'm lazy
-    foreach (const QString &s, str.split('%', QString::SkipEmptyParts)) {
-        ret.append(EnumDefinitions::Enum::fromString(s));
+    int pos = 0;
+    while (pos < str.length()) {
+        int end = str.indexOf('%', pos);
+        if (end == -1) {
+            end = str.length();
+        }
+        if (end > pos) {
+            ret.append(EnumDefinitions::Enum::fromString(str.mid(pos, end - pos)));
+        }
+        pos = end + 1;
+    }
+
+    return ret;
+}
+
+// Magic, version, then the number of enums and for each enum: name, number of values, key/value pairs.
+// Strings are length-prefixed (QDataStream), so decoding doesn't need to search for separators.
+QByteArray EnumDefinitions::toBinary() const
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream.writeRawData(s_binaryMagic, sizeof(s_binaryMagic));
+    stream << s_binaryVersion << quint32(mDefinitions.size());
+    for (const Enum &e : mDefinitions) {
+        stream << e.mEnumName << quint32(e.mEnumValues.size());
+        for (const KeyValue &keyValue : e.mEnumValues) {
+            stream << keyValue.key << keyValue.value;
+        }
     }
+    return data;
+}
 
+bool EnumDefinitions::isBinary(const QByteArray &data)
+{
+    return data.startsWith(QByteArray::fromRawData(s_binaryMagic, sizeof(s_binaryMagic)));
+}
+
+EnumDefinitions EnumDefinitions::fromBinary(const QByteArray &data)
+{
+    EnumDefinitions ret;
+    if (!isBinary(data)) {
+        return ret;
+    }
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream.skipRawData(sizeof(s_binaryMagic));
+    quint8 version;
+    quint32 enumCount;
+    stream >> version >> enumCount;
+    if (version != s_binaryVersion) {
+        return ret;
+    }
+    // don't trust the counts for allocating, in case the data is corrupted
+    const int maxCount = data.size();
+    ret.mDefinitions.reserve(qMin<quint32>(enumCount, maxCount));
+    ret.mNameIndex.reserve(qMin<quint32>(enumCount, maxCount));
+    for (quint32 i = 0; i < enumCount && stream.status() == QDataStream::Ok; ++i) {
+        Enum e;
+        quint32 valueCount;
+        stream >> e.mEnumName >> valueCount;
+        e.mEnumValues.reserve(qMin<quint32>(valueCount, maxCount));
+        for (quint32 j = 0; j < valueCount && stream.status() == QDataStream::Ok; ++j) {
+            KeyValue keyValue;
+            stream >> keyValue.key >> keyValue.value;
+            e.mEnumValues.append(keyValue);
+        }
+        ret.append(e);
+    }
+    if (stream.status() != QDataStream::Ok) {
+        return EnumDefinitions();
+    }
     return ret;
 }
 
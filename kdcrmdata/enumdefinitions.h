@@ -23,8 +23,8 @@
 
 #include "kdcrmdata_export.h"
 
-#include <vector>
-
+#include <QByteArray>
+#include <QHash>
 #include <QVector>
 #include <QMetaType>
 #include <QString>
@@ -38,6 +38,9 @@
  * Each enum definition contains a list of values (ID and display string).
  * E.g. one of the values in the 'lead source' definition is:
  *   ID="QtDevDays", DisplayString="Qt Developer Days"
+ *
+ * Lookups by enum name and by key are hashed, and the data is implicitly shared,
+ * so copying an EnumDefinitions around (e.g. from CollectionManager) is cheap.
  */
 class KDCRMDATA_EXPORT EnumDefinitions
 {
@@ -52,29 +55,46 @@ public:
 
     struct KDCRMDATA_EXPORT Enum
     {
+        Enum() {}
         Enum(const QString &name) : mEnumName(name) {}
         QString toString() const;
         QString value(const QString &key) const;
+        int indexOf(const QString &key) const;
+        void append(const KeyValue &keyValue) { mEnumValues.append(keyValue); }
         static Enum fromString(const QString &str);
 
         QString mEnumName;
         using Vector = QVector<KeyValue>;
         Vector mEnumValues; // ID, display string
+
+    private:
+        friend class EnumDefinitions;
+        void updateKeyIndex() const;
+        // key -> position in mEnumValues. Built lazily, and extended when
+        // values were appended to mEnumValues since the last lookup.
+        mutable QHash<QString, int> mKeyIndex;
+        mutable int mIndexedCount = 0;
     };
 
-    void append(const Enum &e) { mDefinitions.push_back(e); }
-    EnumDefinitions &operator<<(const Enum &e) { mDefinitions.push_back(e); return *this; }
+    void append(const Enum &e);
+    EnumDefinitions &operator<<(const Enum &e) { append(e); return *this; }
 
-    int count() const { return static_cast<int>(mDefinitions.size()); }
+    int count() const { return mDefinitions.size(); }
     const Enum & at(int i) const { return mDefinitions.at(i); }
     int indexOf(const QString &enumName) const;
 
-    // serialization
+    // serialization, text format (as stored by older versions)
     QString toString() const;
     static EnumDefinitions fromString(const QString &str);
 
+    // serialization, length-prefixed binary format (as stored in EnumDefinitionAttribute)
+    QByteArray toBinary() const;
+    static EnumDefinitions fromBinary(const QByteArray &data);
+    static bool isBinary(const QByteArray &data);
+
 private:
-    std::vector<Enum> mDefinitions;
+    QVector<Enum> mDefinitions;
+    QHash<QString, int> mNameIndex; // enum name -> position in mDefinitions
 };
 
 KDCRMDATA_EXPORT QDebug operator<<(QDebug stream, const EnumDefinitions::Enum &oneEnum);
@@ -0,0 +1,82 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "fieldmerge.h"
+
+FieldMerge::FieldMerge(const QMap<QString, QString> &base, const QMap<QString, QString> &local, const QMap<QString, QString> &remote)
+    : mMerged(remote),
+      mMergedChangeCount(0)
+{
+    // Walk the sorted maps side by side rather than doing a lookup per field
+    auto baseIt = base.constBegin();
+    auto remoteIt = remote.constBegin();
+    for (auto localIt = local.constBegin(); localIt != local.constEnd(); ++localIt) {
+        const QString &field = localIt.key();
+        while (baseIt != base.constEnd() && baseIt.key() < field) {
+            ++baseIt;
+        }
+        const bool inBase = baseIt != base.constEnd() && baseIt.key() == field;
+        const QString &localValue = localIt.value();
+        if (inBase && baseIt.value() == localValue) {
+            continue; // not changed locally, keep the remote value
+        }
+        const QString baseValue = inBase ? baseIt.value() : QString();
+        if (!inBase && localValue.isEmpty()) {
+            continue;
+        }
+        mLocalChanges.append(field);
+
+        while (remoteIt != remote.constEnd() && remoteIt.key() < field) {
+            ++remoteIt;
+        }
+        const bool inRemote = remoteIt != remote.constEnd() && remoteIt.key() == field;
+        const QString remoteValue = inRemote ? remoteIt.value() : baseValue;
+        if (remoteValue == localValue) {
+            continue; // the same change on both sides
+        }
+        if (remoteValue == baseValue) {
+            mMerged.insert(field, localValue);
+            ++mMergedChangeCount;
+        } else {
+            mCollisions.append(field);
+            mLocalCollisionValues.insert(field, localValue);
+        }
+    }
+}
+
+bool FieldMerge::needsRemoteUpdate(Side collisionWinner) const
+{
+    if (mMergedChangeCount > 0) {
+        return true;
+    }
+    return collisionWinner == Local && !mCollisions.isEmpty();
+}
+
+QMap<QString, QString> FieldMerge::merged(Side collisionWinner) const
+{
+    if (collisionWinner == Remote || mCollisions.isEmpty()) {
+        return mMerged;
+    }
+    QMap<QString, QString> result = mMerged;
+    for (auto it = mLocalCollisionValues.constBegin(); it != mLocalCollisionValues.constEnd(); ++it) {
+        result.insert(it.key(), it.value());
+    }
+    return result;
+}
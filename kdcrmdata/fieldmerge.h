@@ -0,0 +1,72 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef FIELDMERGE_H
+#define FIELDMERGE_H
+
+#include "kdcrmdata_export.h"
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+/**
+ * Three-way merge of the field values of an item, as returned by data() on the
+ * kdcrmdata types: the local and the remote versions are compared to the base
+ * (the version last synced), field by field.
+ *
+ * A field changed on one side only takes the changed value. A field changed on both
+ * sides to the same value is no conflict either. Only fields changed on both sides
+ * to different values are collisions, which the user has to resolve.
+ * A field missing from a version counts as unchanged in that version.
+ */
+class KDCRMDATA_EXPORT FieldMerge
+{
+public:
+    enum Side {
+        Local,
+        Remote
+    };
+
+    FieldMerge(const QMap<QString, QString> &base, const QMap<QString, QString> &local, const QMap<QString, QString> &remote);
+
+    // Fields changed on both sides, to different values
+    QStringList collisions() const { return mCollisions; }
+    bool hasCollisions() const { return !mCollisions.isEmpty(); }
+
+    // Fields changed locally, including the collisions
+    QStringList localChanges() const { return mLocalChanges; }
+
+    // True if the merged version differs from the remote one, i.e. has to be sent to the server
+    // (for collisions, the value of the given side is used)
+    bool needsRemoteUpdate(Side collisionWinner) const;
+
+    // The remote version with the local changes applied; for collisions, the value of the given side
+    QMap<QString, QString> merged(Side collisionWinner) const;
+
+private:
+    QMap<QString, QString> mMerged; // collisions have the remote value
+    QMap<QString, QString> mLocalCollisionValues;
+    QStringList mCollisions;
+    QStringList mLocalChanges;
+    int mMergedChangeCount; // local changes not on the server yet, besides the collisions
+};
+
+#endif
@@ -0,0 +1,198 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "kdcrmtrace.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <atomic>
+
+namespace {
+
+class TraceWriter
+{
+public:
+    TraceWriter()
+    {
+        mTimer.start();
+        if (qEnvironmentVariableIsSet("FATCRM_TRACE")) {
+            mPendingDirectory = qEnvironmentVariable("FATCRM_TRACE");
+            mEnabled = true;
+        }
+    }
+
+    ~TraceWriter()
+    {
+        QMutexLocker locker(&mMutex);
+        if (mFile.isOpen()) {
+            mFile.write("\n]\n");
+            mFile.close();
+        }
+    }
+
+    bool isEnabled() const { return mEnabled; }
+
+    bool open(const QString &fileName)
+    {
+        QMutexLocker locker(&mMutex);
+        mPendingDirectory.clear();
+        return openInternal(fileName);
+    }
+
+    qint64 now() const { return mTimer.nsecsElapsed() / 1000; }
+
+    void write(QJsonObject event)
+    {
+        static std::atomic<int> s_lastThreadNumber{0};
+        static thread_local const int s_threadNumber = ++s_lastThreadNumber;
+        event.insert(QStringLiteral("pid"), double(QCoreApplication::applicationPid()));
+        event.insert(QStringLiteral("tid"), s_threadNumber);
+        const QByteArray json = QJsonDocument(event).toJson(QJsonDocument::Compact);
+
+        QMutexLocker locker(&mMutex);
+        if (!mPendingDirectory.isEmpty()) {
+            // Opened lazily, so that the application name is known by now
+            const QString executable = QCoreApplication::instance()
+                    ? QFileInfo(QCoreApplication::applicationFilePath()).fileName() : QStringLiteral("fatcrm");
+            const QString fileName = QStringLiteral("%1/%2-%3.json").arg(mPendingDirectory, executable).arg(QCoreApplication::applicationPid());
+            QDir().mkpath(mPendingDirectory);
+            mPendingDirectory.clear();
+            openInternal(fileName);
+        }
+        if (!mFile.isOpen())
+            return;
+        mFile.write(mFirstEvent ? "\n" : ",\n");
+        mFile.write(json);
+        mFirstEvent = false;
+    }
+
+private:
+    bool openInternal(const QString &fileName)
+    {
+        if (mFile.isOpen()) {
+            mFile.write("\n]\n");
+            mFile.close();
+        }
+        mFile.setFileName(fileName);
+        if (!mFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qWarning() << "Cannot write trace file" << fileName << mFile.errorString();
+            mEnabled = false;
+            return false;
+        }
+        mFile.write("[");
+        mFirstEvent = true;
+        mEnabled = true;
+        return true;
+    }
+
+    QMutex mMutex;
+    QElapsedTimer mTimer;
+    QFile mFile;
+    QString mPendingDirectory;
+    std::atomic<bool> mEnabled{false};
+    bool mFirstEvent = true;
+};
+
+Q_GLOBAL_STATIC(TraceWriter, s_writer)
+
+// nullptr when tracing is disabled (or during application shutdown)
+TraceWriter *enabledWriter()
+{
+    if (s_writer.isDestroyed())
+        return nullptr;
+    TraceWriter *writer = s_writer();
+    return writer->isEnabled() ? writer : nullptr;
+}
+
+QJsonObject makeEvent(const char *phase, const char *category, const char *name, qint64 timestamp)
+{
+    QJsonObject event;
+    event.insert(QStringLiteral("ph"), QLatin1String(phase));
+    event.insert(QStringLiteral("cat"), QLatin1String(category));
+    event.insert(QStringLiteral("name"), QLatin1String(name));
+    event.insert(QStringLiteral("ts"), double(timestamp));
+    return event;
+}
+
+}
+
+bool KDCRMTrace::isEnabled()
+{
+    return enabledWriter() != nullptr;
+}
+
+bool KDCRMTrace::setOutputFile(const QString &fileName)
+{
+    return s_writer()->open(fileName);
+}
+
+void KDCRMTrace::asyncBegin(const char *category, const char *name, qint64 id)
+{
+    TraceWriter *writer = enabledWriter();
+    if (!writer)
+        return;
+    QJsonObject event = makeEvent("b", category, name, writer->now());
+    event.insert(QStringLiteral("id"), QString::number(id));
+    writer->write(event);
+}
+
+void KDCRMTrace::asyncEnd(const char *category, const char *name, qint64 id)
+{
+    TraceWriter *writer = enabledWriter();
+    if (!writer)
+        return;
+    QJsonObject event = makeEvent("e", category, name, writer->now());
+    event.insert(QStringLiteral("id"), QString::number(id));
+    writer->write(event);
+}
+
+KDCRMTrace::Span::Span(const char *category, const char *name)
+    : mCategory(category),
+      mName(name),
+      mStart(enabledWriter() ? s_writer()->now() : -1)
+{
+}
+
+KDCRMTrace::Span::~Span()
+{
+    TraceWriter *writer = mStart >= 0 ? enabledWriter() : nullptr;
+    if (!writer)
+        return;
+    QJsonObject event = makeEvent("X", mCategory, mName, mStart);
+    event.insert(QStringLiteral("dur"), double(writer->now() - mStart));
+    if (mCount >= 0 || !mDetail.isEmpty()) {
+        QJsonObject args;
+        if (mCount >= 0)
+            args.insert(QStringLiteral("count"), double(mCount));
+        if (!mDetail.isEmpty())
+            args.insert(QStringLiteral("detail"), mDetail);
+        event.insert(QStringLiteral("args"), args);
+    }
+    writer->write(event);
+}
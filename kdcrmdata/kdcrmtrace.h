@@ -0,0 +1,91 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef KDCRMTRACE_H
+#define KDCRMTRACE_H
+
+#include "kdcrmdata_export.h"
+
+#include <QString>
+
+/**
+ * Lightweight tracing facility, writing scoped spans in the Chrome/Perfetto
+ * JSON trace event format (load the file in chrome://tracing or ui.perfetto.dev).
+ *
+ * Tracing is compiled in when the FATCRM_TRACING CMake option is ON (the default),
+ * and otherwise all FATCRM_TRACE_* macros expand to nothing.
+ * At runtime it is off until enabled:
+ * - by setting FATCRM_TRACE to a directory: every process (client, resources)
+ *   then writes <directory>/<executable>-<pid>.json
+ * - or by calling setOutputFile(), e.g. from the --trace command-line option of FatCRM.
+ *
+ * See documentation/Tracing.
+ */
+namespace KDCRMTrace
+{
+KDCRMDATA_EXPORT bool isEnabled();
+KDCRMDATA_EXPORT bool setOutputFile(const QString &fileName);
+
+// Begin and end a span which doesn't fit in a C++ scope (e.g. waiting for a job).
+// Spans with the same category, name and id are matched together.
+KDCRMDATA_EXPORT void asyncBegin(const char *category, const char *name, qint64 id);
+KDCRMDATA_EXPORT void asyncEnd(const char *category, const char *name, qint64 id);
+
+/**
+ * Records the time between its construction and its destruction.
+ * Use it through FATCRM_TRACE_SCOPE.
+ */
+class KDCRMDATA_EXPORT Span
+{
+public:
+    Span(const char *category, const char *name);
+    ~Span();
+
+    // Optional arguments, shown in the details of the span
+    void setCount(qint64 count) { mCount = count; }
+    void setDetail(const QString &detail) { mDetail = detail; }
+
+private:
+    Q_DISABLE_COPY(Span)
+    const char *mCategory;
+    const char *mName;
+    qint64 mStart;
+    qint64 mCount = -1;
+    QString mDetail;
+};
+}
+
+#if FATCRM_TRACING
+#define FATCRM_TRACE_SCOPE(category, name) KDCRMTrace::Span fatcrmTraceSpan(category, name)
+// the count and detail expressions are only evaluated when tracing is enabled
+#define FATCRM_TRACE_SET_COUNT(count) \
+    do { if (KDCRMTrace::isEnabled()) fatcrmTraceSpan.setCount(count); } while (false)
+#define FATCRM_TRACE_SET_DETAIL(detail) \
+    do { if (KDCRMTrace::isEnabled()) fatcrmTraceSpan.setDetail(detail); } while (false)
+#define FATCRM_TRACE_ASYNC_BEGIN(category, name, id) KDCRMTrace::asyncBegin(category, name, id)
+#define FATCRM_TRACE_ASYNC_END(category, name, id) KDCRMTrace::asyncEnd(category, name, id)
+#else
+#define FATCRM_TRACE_SCOPE(category, name)
+#define FATCRM_TRACE_SET_COUNT(count) do {} while (false)
+#define FATCRM_TRACE_SET_DETAIL(detail) do {} while (false)
+#define FATCRM_TRACE_ASYNC_BEGIN(category, name, id) do {} while (false)
+#define FATCRM_TRACE_ASYNC_END(category, name, id) do {} while (false)
+#endif
+
+#endif // KDCRMTRACE_H
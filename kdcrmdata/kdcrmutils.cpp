@@ -181,3 +181,44 @@ void KDCRMUtils::setupIconTheme()
     }
 #endif
 }
+
+QByteArray KDCRMUtils::importFlag()
+{
+    return QByteArrayLiteral("$FATCRM_IMPORT");
+}
+
+qint64 KDCRMUtils::memoryUsage(const QString &str)
+{
+    if (str.capacity() <= 0) {
+        return 0;
+    }
+    // QArrayData header, then the characters and the terminating null
+    return qint64(sizeof(QArrayData)) + (str.capacity() + 1) * qint64(sizeof(QChar));
+}
+
+qint64 KDCRMUtils::memoryUsage(const QStringList &list)
+{
+    if (list.isEmpty()) {
+        return 0;
+    }
+    // QListData header, then one pointer-sized slot per string (QString is stored in place)
+    qint64 size = qint64(sizeof(QListData::Data)) + list.count() * qint64(sizeof(void *));
+    for (const QString &str : list) {
+        size += memoryUsage(str);
+    }
+    return size;
+}
+
+qint64 KDCRMUtils::memoryUsage(const QMap<QString, QString> &map)
+{
+    if (map.isEmpty()) {
+        return 0;
+    }
+    // red-black tree node: three pointers (parent+color, left, right), then key and value
+    const qint64 nodeSize = 3 * qint64(sizeof(void *)) + 2 * qint64(sizeof(QString));
+    qint64 size = qint64(sizeof(QMapDataBase)) + map.count() * nodeSize;
+    for (auto it = map.cbegin(); it != map.cend(); ++it) {
+        size += memoryUsage(it.key()) + memoryUsage(it.value());
+    }
+    return size;
+}
@@ -25,6 +25,8 @@
 
 #include "kdcrmdata_export.h"
 #include <QDateTime>
+#include <QMap>
+#include <QStringList>
 
 class QString;
 
@@ -53,6 +55,15 @@ KDCRMDATA_EXPORT QString limitString(const QString &str, int wantedParagraphs);
 KDCRMDATA_EXPORT QString canonicalCountryName(const QString &input);
 
 KDCRMDATA_EXPORT void setupIconTheme();
+
+// Akonadi flag set by the client on the new items of an import,
+// so that the resource creates them on the server in batches
+KDCRMDATA_EXPORT QByteArray importFlag();
+
+// Estimates of the heap memory used by the data of these containers (0 for the shared empty string)
+KDCRMDATA_EXPORT qint64 memoryUsage(const QString &str);
+KDCRMDATA_EXPORT qint64 memoryUsage(const QStringList &list);
+KDCRMDATA_EXPORT qint64 memoryUsage(const QMap<QString, QString> &map);
 }
 
 
@@ -718,6 +718,25 @@ QString SugarAccount::mimeType()
     return QStringLiteral("application/x-vnd.kdab.crm.account");
 }
 
+qint64 SugarAccount::estimatedMemoryUsage() const
+{
+    qint64 size = sizeof(Private);
+    for (const QString *field : {
+        &d->mId, &d->mName, &d->mDateEntered, &d->mDateModified, &d->mModifiedUserId, &d->mModifiedByName,
+        &d->mCreatedBy, &d->mCreatedByName, &d->mDescription, &d->mDeleted, &d->mAssignedUserId,
+        &d->mAssignedUserName, &d->mAccountType, &d->mIndustry, &d->mAnnualRevenue, &d->mPhoneFax,
+        &d->mBillingAddressStreet, &d->mBillingAddressCity, &d->mBillingAddressState,
+        &d->mBillingAddressPostalcode, &d->mBillingAddressCountry, &d->mRating, &d->mPhoneOffice,
+        &d->mPhoneAlternate, &d->mWebsite, &d->mOwnership, &d->mEmployees, &d->mTickerSymbol,
+        &d->mShippingAddressStreet, &d->mShippingAddressCity, &d->mShippingAddressState,
+        &d->mShippingAddressPostalcode, &d->mShippingAddressCountry, &d->mEmail1, &d->mParentId,
+        &d->mParentName, &d->mSicCode, &d->mCampaignId, &d->mCampaignName, &d->mCachedCleanAccountName }) {
+        size += KDCRMUtils::memoryUsage(*field);
+    }
+    size += KDCRMUtils::memoryUsage(d->mCustomFields);
+    return size;
+}
+
 Q_GLOBAL_STATIC(SugarAccount::AccessorHash, s_accessors)
 
 SugarAccount::AccessorHash SugarAccount::accessorHash()
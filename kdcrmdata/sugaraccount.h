@@ -503,6 +503,12 @@ public:
      */
     static QString mimeType();
 
+    /**
+       Estimate of the heap memory used by this object's data.
+       Data shared with other objects is counted for each of them.
+     */
+    qint64 estimatedMemoryUsage() const;
+
     using valueGetter = QString (SugarAccount::*)() const;
     using valueSetter = void (SugarAccount::*)(const QString &);
 
@@ -21,6 +21,7 @@
 */
 
 #include "sugarcampaign.h"
+#include "kdcrmutils.h"
 #include "kdcrmfields.h"
 
 #include <KLocalizedString>
@@ -453,6 +454,20 @@ QString SugarCampaign::mimeType()
     return QStringLiteral("application/x-vnd.kdab.crm.campaign");
 }
 
+qint64 SugarCampaign::estimatedMemoryUsage() const
+{
+    qint64 size = sizeof(Private);
+    for (const QString *field : {
+        &d->mId, &d->mName, &d->mDateEntered, &d->mDateModified, &d->mModifiedUserId, &d->mModifiedByName,
+        &d->mCreatedBy, &d->mCreatedByName, &d->mDeleted, &d->mAssignedUserId, &d->mAssignedUserName,
+        &d->mTrackerKey, &d->mTrackerCount, &d->mReferUrl, &d->mTrackerText, &d->mStartDate, &d->mEndDate,
+        &d->mStatus, &d->mImpressions, &d->mCurrencyId, &d->mBudget, &d->mExpectedCost, &d->mActualCost,
+        &d->mExpectedRevenue, &d->mCampaignType, &d->mObjective, &d->mContent, &d->mFrequency }) {
+        size += KDCRMUtils::memoryUsage(*field);
+    }
+    return size;
+}
+
 Q_GLOBAL_STATIC(SugarCampaign::AccessorHash, s_accessors)
 
 SugarCampaign::AccessorHash SugarCampaign::accessorHash()
@@ -339,6 +339,12 @@ public:
      */
     static QString mimeType();
 
+    /**
+       Estimate of the heap memory used by this object's data.
+       Data shared with other objects is counted for each of them.
+     */
+    qint64 estimatedMemoryUsage() const;
+
     using valueGetter = QString (SugarCampaign::*)() const;
     using valueSetter = void (SugarCampaign::*)(const QString &);
 
@@ -1,5 +1,7 @@
 #include "sugarcontactwrapper.h"
 
+#include "kdcrmutils.h"
+
 SugarContactWrapper::SugarContactWrapper(const KContacts::Addressee &addressee)
     : m_addressee(const_cast<KContacts::Addressee &>(addressee))
 {
@@ -71,3 +73,34 @@ void SugarContactWrapper::setPhoneAssistant(const QString &value)        { m_add
 void SugarContactWrapper::setReportsTo(const QString &value)             { m_addressee.insertCustom(QStringLiteral("FATCRM"), QStringLiteral("X-ReportsToUserName"), value); }
 void SugarContactWrapper::setReportsToId(const QString &value)           { m_addressee.insertCustom(QStringLiteral("FATCRM"), QStringLiteral("X-ReportsToUserId"), value); }
 void SugarContactWrapper::setSalutation(const QString &value)            { m_addressee.insertCustom(QStringLiteral("FATCRM"), QStringLiteral("X-Salutation"), value); }
+
+qint64 SugarContactWrapper::estimatedMemoryUsage(const KContacts::Addressee &addressee)
+{
+    // Addressee keeps its fields in a shared private; count the ones FatCRM fills in.
+    qint64 size = sizeof(KContacts::Addressee);
+    const QString fields[] = {
+        addressee.uid(), addressee.formattedName(), addressee.givenName(), addressee.familyName(),
+        addressee.prefix(), addressee.title(), addressee.role(), addressee.organization(),
+        addressee.department(), addressee.note()
+    };
+    for (const QString &field : fields) {
+        size += KDCRMUtils::memoryUsage(field);
+    }
+    size += KDCRMUtils::memoryUsage(addressee.emails());
+    size += KDCRMUtils::memoryUsage(addressee.customs());
+    const KContacts::PhoneNumber::List phoneNumbers = addressee.phoneNumbers();
+    for (const KContacts::PhoneNumber &phoneNumber : phoneNumbers) {
+        size += sizeof(KContacts::PhoneNumber) + KDCRMUtils::memoryUsage(phoneNumber.number());
+    }
+    const KContacts::Address::List addresses = addressee.addresses();
+    for (const KContacts::Address &address : addresses) {
+        size += sizeof(KContacts::Address);
+        const QString addressFields[] = {
+            address.street(), address.locality(), address.region(), address.postalCode(), address.country()
+        };
+        for (const QString &field : addressFields) {
+            size += KDCRMUtils::memoryUsage(field);
+        }
+    }
+    return size;
+}
@@ -64,6 +64,8 @@ public:
     void setReportsToId(const QString &value);
     void setSalutation(const QString &value);
 
+    static qint64 estimatedMemoryUsage(const KContacts::Addressee &addressee);
+
 private:
     KContacts::Addressee &m_addressee;
 };
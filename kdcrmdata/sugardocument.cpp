@@ -474,6 +474,24 @@ QString SugarDocument::mimeType()
     return QStringLiteral("application/x-vnd.kdab.crm.document");
 }
 
+qint64 SugarDocument::estimatedMemoryUsage() const
+{
+    qint64 size = sizeof(Private);
+    for (const QString *field : {
+        &d->mId, &d->mDateEntered, &d->mModifiedUserId, &d->mModifiedByName, &d->mCreatedBy,
+        &d->mCreatedByName, &d->mDescription, &d->mDeleted, &d->mAssignedUserId, &d->mAssignedUserName,
+        &d->mDocumentName, &d->mDocumentId, &d->mDocumentType, &d->mDocumentUrl, &d->mActiveDate,
+        &d->mExpDate, &d->mCategoryId, &d->mSubcategoryId, &d->mStatusId, &d->mDocumentRevisionId,
+        &d->mRelatedDocumentId, &d->mRelatedDocumentName, &d->mRelatedDocumentRevisionId, &d->mIsTemplate,
+        &d->mTemplateType }) {
+        size += KDCRMUtils::memoryUsage(*field);
+    }
+    size += KDCRMUtils::memoryUsage(d->mLinkedAccountIds);
+    size += KDCRMUtils::memoryUsage(d->mLinkedOpportunityIds);
+    size += KDCRMUtils::memoryUsage(d->mCustomFields);
+    return size;
+}
+
 /* coverity[leaked_storage] */
 Q_GLOBAL_STATIC(SugarDocument::AccessorHash, s_accessors)
 
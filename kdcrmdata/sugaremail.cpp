@@ -367,6 +367,19 @@ QString SugarEmail::mimeType()
     return QStringLiteral("application/x-vnd.kdab.crm.email");
 }
 
+qint64 SugarEmail::estimatedMemoryUsage() const
+{
+    qint64 size = sizeof(Private);
+    for (const QString *field : {
+        &d->mId, &d->mName, &d->mDateEntered, &d->mModifiedUserId, &d->mModifiedByName, &d->mCreatedBy,
+        &d->mCreatedByName, &d->mDeleted, &d->mAssignedUserId, &d->mAssignedUserName, &d->mDateSent,
+        &d->mMessageId, &d->mParentType, &d->mParentId, &d->mFromAddrName, &d->mToAddrNAmes,
+        &d->mCcAddrNames, &d->mDescription, &d->mDescriptionHtml }) {
+        size += KDCRMUtils::memoryUsage(*field);
+    }
+    return size;
+}
+
 Q_GLOBAL_STATIC(SugarEmail::AccessorHash, s_accessors)
 
 SugarEmail::AccessorHash SugarEmail::accessorHash()
@@ -21,6 +21,7 @@
 */
 
 #include "sugarlead.h"
+#include "kdcrmutils.h"
 #include "kdcrmfields.h"
 
 #include <KLocalizedString>
@@ -813,6 +814,27 @@ QString SugarLead::mimeType()
     return QStringLiteral("application/x-vnd.kdab.crm.lead");
 }
 
+qint64 SugarLead::estimatedMemoryUsage() const
+{
+    qint64 size = sizeof(Private);
+    for (const QString *field : {
+        &d->mId, &d->mDateEntered, &d->mDateModified, &d->mModifiedUserId, &d->mModifiedByName,
+        &d->mCreatedBy, &d->mCreatedByName, &d->mDescription, &d->mDeleted, &d->mAssignedUserId,
+        &d->mAssignedUserName, &d->mSalutation, &d->mFirstName, &d->mLastName, &d->mTitle, &d->mDepartment,
+        &d->mDoNotCall, &d->mPhoneHome, &d->mPhoneMobile, &d->mPhoneWork, &d->mPhoneOther, &d->mPhoneFax,
+        &d->mEmail1, &d->mEmail2, &d->mPrimaryAddressStreet, &d->mPrimaryAddressCity,
+        &d->mPrimaryAddressState, &d->mPrimaryAddressPostalcode, &d->mPrimaryAddressCountry,
+        &d->mAltAddressStreet, &d->mAltAddressCity, &d->mAltAddressState, &d->mAltAddressPostalcode,
+        &d->mAltAddressCountry, &d->mAssistant, &d->mAssistantPhone, &d->mConverted, &d->mReferedBy,
+        &d->mLeadSource, &d->mLeadSourceDescription, &d->mStatus, &d->mStatusDescription, &d->mReportsToId,
+        &d->mReportToName, &d->mAccountName, &d->mAccountDescription, &d->mContactId, &d->mAccountId,
+        &d->mOpportunityId, &d->mOpportunityName, &d->mOpportunityAmount, &d->mCampaignId, &d->mCampaignName,
+        &d->mCAcceptStatusFields, &d->mMAcceptStatusFields, &d->mBirthdate, &d->mPortalName, &d->mPortalApp }) {
+        size += KDCRMUtils::memoryUsage(*field);
+    }
+    return size;
+}
+
 Q_GLOBAL_STATIC(SugarLead::AccessorHash, s_accessors)
 
 SugarLead::AccessorHash SugarLead::accessorHash()
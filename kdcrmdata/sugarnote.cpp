@@ -344,6 +344,18 @@ QString SugarNote::mimeType()
     return QStringLiteral("application/x-vnd.kdab.crm.note");
 }
 
+qint64 SugarNote::estimatedMemoryUsage() const
+{
+    qint64 size = sizeof(Private);
+    for (const QString *field : {
+        &d->mId, &d->mName, &d->mDateEntered, &d->mModifiedUserId, &d->mModifiedByName, &d->mCreatedBy,
+        &d->mCreatedByName, &d->mDeleted, &d->mAssignedUserId, &d->mAssignedUserName, &d->mFileMimeType,
+        &d->mFileName, &d->mParentType, &d->mParentId, &d->mContactId, &d->mContactName, &d->mDescription }) {
+        size += KDCRMUtils::memoryUsage(*field);
+    }
+    return size;
+}
+
 Q_GLOBAL_STATIC(SugarNote::AccessorHash, s_accessors)
 
 SugarNote::AccessorHash SugarNote::accessorHash()
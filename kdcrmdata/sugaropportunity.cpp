@@ -506,6 +506,22 @@ QString SugarOpportunity::mimeType()
     return QStringLiteral("application/x-vnd.kdab.crm.opportunity");
 }
 
+qint64 SugarOpportunity::estimatedMemoryUsage() const
+{
+    qint64 size = sizeof(Private);
+    for (const QString *field : {
+        &d->mId, &d->mName, &d->mDateEntered, &d->mModifiedUserId, &d->mModifiedByName, &d->mCreatedBy,
+        &d->mCreatedByName, &d->mDescription, &d->mDeleted, &d->mAssignedUserId, &d->mAssignedUserName,
+        &d->mOpportunityType, &d->mAccountName, &d->mAccountId, &d->mCampaignId, &d->mCampaignName,
+        &d->mLeadSource, &d->mAmount, &d->mAmountUsDollar, &d->mCurrencyId, &d->mCurrencyName,
+        &d->mCurrencySymbol, &d->mDateClosed, &d->mNextStep, &d->mSalesStage, &d->mProbability,
+        &d->mShownPriority }) {
+        size += KDCRMUtils::memoryUsage(*field);
+    }
+    size += KDCRMUtils::memoryUsage(d->mCustomFields);
+    return size;
+}
+
 
 Q_GLOBAL_STATIC(SugarOpportunity::AccessorHash, s_accessors)
 
@@ -0,0 +1,68 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "syncbaseattribute.h"
+
+#include <AkonadiCore/Item>
+
+SyncBaseAttribute::SyncBaseAttribute()
+{
+}
+
+void SyncBaseAttribute::storeBase(Akonadi::Item &item)
+{
+    if (!item.isValid() || !item.hasPayload() || item.hasAttribute<SyncBaseAttribute>()) {
+        return;
+    }
+    auto *attr = item.attribute<SyncBaseAttribute>(Akonadi::Item::AddIfMissing);
+    attr->setPayloadData(item.payloadData());
+}
+
+void SyncBaseAttribute::setPayloadData(const QByteArray &data)
+{
+    mPayloadData = data;
+}
+
+QByteArray SyncBaseAttribute::payloadData() const
+{
+    return mPayloadData;
+}
+
+QByteArray SyncBaseAttribute::type() const
+{
+    return "CRM-syncbase";
+}
+
+Akonadi::Attribute *SyncBaseAttribute::clone() const
+{
+    auto *attr = new SyncBaseAttribute;
+    attr->mPayloadData = mPayloadData;
+    return attr;
+}
+
+QByteArray SyncBaseAttribute::serialized() const
+{
+    return mPayloadData;
+}
+
+void SyncBaseAttribute::deserialize(const QByteArray &data)
+{
+    mPayloadData = data;
+}
@@ -0,0 +1,62 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SYNCBASEATTRIBUTE_H
+#define SYNCBASEATTRIBUTE_H
+
+#include "kdcrmdata_export.h"
+#include <AkonadiCore/Attribute>
+#include <QByteArray>
+
+namespace Akonadi {
+class Item;
+}
+
+/**
+ * An attribute for letting FatCRM remember, on an item modified locally, the payload
+ * the item had when it was last synced. When the entry changed on the server meanwhile,
+ * the resource uses it as the base of a three-way merge (see FieldMerge), so that only
+ * fields changed on both sides need to be resolved by the user.
+ * The resource removes the attribute once the change is on the server.
+ */
+class KDCRMDATA_EXPORT SyncBaseAttribute : public Akonadi::Attribute
+{
+public:
+    SyncBaseAttribute();
+
+    // Call before changing the payload of an existing item: stores the current payload
+    // as the base, unless the item already has one (modified again before being synced,
+    // the base is still the version from the server).
+    static void storeBase(Akonadi::Item &item);
+
+    // The serialized payload, as in Akonadi::Item::payloadData()
+    void setPayloadData(const QByteArray &data);
+    QByteArray payloadData() const;
+
+    QByteArray type() const override;
+    Attribute *clone() const override;
+    QByteArray serialized() const override;
+    void deserialize(const QByteArray &data) override;
+
+private:
+    QByteArray mPayloadData;
+};
+
+#endif
@@ -0,0 +1 @@
+#cmakedefine01 KDSOAP_HAS_NETWORK_ACCESS_MANAGER
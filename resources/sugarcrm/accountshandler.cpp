@@ -114,11 +114,21 @@ KDSoapGenerated::TNS__Name_value_list AccountsHandler::sugarAccountToNameValueLi
 }
 
 int AccountsHandler::setEntry(const Akonadi::Item &item, QString &newId, QString &errorMessage)
+{
+    KDSoapGenerated::TNS__Name_value_list valueList;
+    if (!itemToNameValueList(item, valueList)) {
+        return SugarJob::InvalidContextError;
+    }
+
+    return mSession->protocol()->setEntry(module(), valueList, newId, errorMessage);
+}
+
+bool AccountsHandler::itemToNameValueList(const Akonadi::Item &item, KDSoapGenerated::TNS__Name_value_list &valueList)
 {
     if (!item.hasPayload<SugarAccount>()) {
         qCCritical(FATCRM_SUGARCRMRESOURCE_LOG) << "item (id=" << item.id() << ", remoteId=" << item.remoteId()
                  << ", mime=" << item.mimeType() << ") is missing Account payload";
-        return SugarJob::InvalidContextError;
+        return false;
     }
 
     QList<KDSoapGenerated::TNS__Name_value> itemList;
@@ -135,9 +145,8 @@ int AccountsHandler::setEntry(const Akonadi::Item &item, QString &newId, QString
 
     const SugarAccount account = item.payload<SugarAccount>();
 
-    KDSoapGenerated::TNS__Name_value_list valueList = sugarAccountToNameValueList(account, itemList);
-
-    return mSession->protocol()->setEntry(module(), valueList, newId, errorMessage);
+    valueList = sugarAccountToNameValueList(account, itemList);
+    return true;
 }
 
 int AccountsHandler::expectedContentsVersion() const
@@ -191,6 +200,16 @@ Akonadi::Item AccountsHandler::itemFromEntry(const KDSoapGenerated::TNS__Entry_v
     return item;
 }
 
+QMap<QString, QString> AccountsHandler::itemFieldValues(const Akonadi::Item &item) const
+{
+    return payloadFieldValues<SugarAccount>(item);
+}
+
+bool AccountsHandler::setItemFieldValues(Akonadi::Item &item, const QMap<QString, QString> &values) const
+{
+    return setPayloadFieldValues<SugarAccount>(item, values);
+}
+
 void AccountsHandler::compare(Akonadi::AbstractDifferencesReporter *reporter,
                               const Akonadi::Item &leftItem, const Akonadi::Item &rightItem)
 {
@@ -53,10 +53,16 @@ public:
 
     Akonadi::Item itemFromEntry(const KDSoapGenerated::TNS__Entry_value &entry, const Akonadi::Collection &parentCollection, bool &deleted) override;
 
+    QMap<QString, QString> itemFieldValues(const Akonadi::Item &item) const override;
+    bool setItemFieldValues(Akonadi::Item &item, const QMap<QString, QString> &values) const override;
+
     void compare(Akonadi::AbstractDifferencesReporter *reporter,
                  const Akonadi::Item &leftItem, const Akonadi::Item &rightItem) override;
 
     static SugarAccount nameValueListToSugarAccount(const KDSoapGenerated::TNS__Name_value_list &valueList, const QString &id);
+
+private:
+    static bool itemToNameValueList(const Akonadi::Item &item, KDSoapGenerated::TNS__Name_value_list &valueList);
 };
 
 #endif /* ACCOUNTSHANDLER_H */
@@ -149,6 +149,16 @@ Akonadi::Item CampaignsHandler::itemFromEntry(const KDSoapGenerated::TNS__Entry_
     return item;
 }
 
+QMap<QString, QString> CampaignsHandler::itemFieldValues(const Akonadi::Item &item) const
+{
+    return payloadFieldValues<SugarCampaign>(item);
+}
+
+bool CampaignsHandler::setItemFieldValues(Akonadi::Item &item, const QMap<QString, QString> &values) const
+{
+    return setPayloadFieldValues<SugarCampaign>(item, values);
+}
+
 void CampaignsHandler::compare(Akonadi::AbstractDifferencesReporter *reporter,
                                const Akonadi::Item &leftItem, const Akonadi::Item &rightItem)
 {
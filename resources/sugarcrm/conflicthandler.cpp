@@ -22,7 +22,10 @@
 
 #include "conflicthandler.h"
 #include "conflictresolvedialog.h"
+#include "modulehandler.h"
 #include "sugarcrmresource_debug.h"
+#include "kdcrmdata/fieldmerge.h"
+#include "kdcrmdata/syncbaseattribute.h"
 #include <AkonadiCore/Collection>
 #include <AkonadiCore/Item>
 #include <AkonadiCore/ItemCreateJob>
@@ -34,12 +37,14 @@ using namespace Akonadi;
 #include <KWindowSystem>
 #include <kwindowsystem_version.h>
 
+#include <QScopedPointer>
+
 class ConflictHandler::Private
 {
     ConflictHandler *const q;
 public:
     Private(ConflictHandler *parent, ConflictType type)
-        : q(parent), mType(type), mDiffInterface(nullptr), mWindowId(0),
+        : q(parent), mType(type), mDiffInterface(nullptr), mHandler(nullptr), mWindowId(0),
           mSession(new Session(Session::defaultSession()->sessionId() + "-conflicthandler", parent))
     {
     }
@@ -51,12 +56,18 @@ public:
     Item mRemoteItem;
 
     DifferencesAlgorithmInterface *mDiffInterface;
+    ModuleHandler *mHandler;
+    QScopedPointer<FieldMerge> mMerge; // set if the items could be compared field by field
     WId mWindowId;
     QString mName;
 
     Session *mSession;
 
 public:
+    bool autoMerge();
+    Item mergedItem(const Item &item, FieldMerge::Side collisionWinner) const;
+    void applyMerge(FieldMerge::Side collisionWinner);
+    void useRemoteItem();
     void resolve();
     void createDuplicate(const Item &item);
 
@@ -64,6 +75,70 @@ public: // slots
     void duplicateLocalItemResult(KJob *job);
 };
 
+bool ConflictHandler::Private::autoMerge()
+{
+    mMerge.reset();
+    const auto *baseAttr = mLocalItem.attribute<SyncBaseAttribute>();
+    if (mHandler == nullptr || baseAttr == nullptr) {
+        return false;
+    }
+
+    Item base;
+    base.setMimeType(mLocalItem.mimeType());
+    base.setPayloadFromData(baseAttr->payloadData());
+    const QMap<QString, QString> baseValues = mHandler->itemFieldValues(base);
+    if (baseValues.isEmpty()) {
+        qCWarning(FATCRM_SUGARCRMRESOURCE_LOG) << "Could not read the base version of item" << mLocalItem.id();
+        return false;
+    }
+
+    mMerge.reset(new FieldMerge(baseValues, mHandler->itemFieldValues(mLocalItem), mHandler->itemFieldValues(mRemoteItem)));
+    if (mMerge->hasCollisions()) {
+        qCDebug(FATCRM_SUGARCRMRESOURCE_LOG) << "Item" << mLocalItem.id() << "remoteId=" << mLocalItem.remoteId()
+                                             << "has fields changed on both sides:" << mMerge->collisions();
+        return false;
+    }
+
+    qCDebug(FATCRM_SUGARCRMRESOURCE_LOG) << "Merging local changes of item" << mLocalItem.id() << "remoteId=" << mLocalItem.remoteId()
+                                         << "with the server version:" << mMerge->localChanges();
+    applyMerge(FieldMerge::Local);
+    return true;
+}
+
+Item ConflictHandler::Private::mergedItem(const Item &item, FieldMerge::Side collisionWinner) const
+{
+    Item merged(item);
+    mHandler->setItemFieldValues(merged, mMerge->merged(collisionWinner));
+    return merged;
+}
+
+void ConflictHandler::Private::applyMerge(FieldMerge::Side collisionWinner)
+{
+    if (!mMerge->needsRemoteUpdate(collisionWinner)) {
+        // the server version already has everything
+        useRemoteItem();
+        return;
+    }
+
+    // update the server with the merged version, based on its current revision
+    Item item = mergedItem(mLocalItem, collisionWinner);
+    item.setRemoteRevision(mRemoteItem.remoteRevision());
+    emit q->updateOnBackend(item);
+}
+
+void ConflictHandler::Private::useRemoteItem()
+{
+    // use remote item to acknowledge change
+    mRemoteItem.setId(mLocalItem.id());
+    mRemoteItem.setRevision(mLocalItem.revision());
+    mRemoteItem.removeAttribute<SyncBaseAttribute>();
+    emit q->commitChange(mRemoteItem);
+
+    // commit does not update payload, so we modify as well
+    auto *modifyJob = new ItemModifyJob(mRemoteItem, q);
+    modifyJob->disableRevisionCheck();
+}
+
 void ConflictHandler::Private::resolve()
 {
     ConflictResolveDialog dialog;
@@ -85,7 +160,12 @@ void ConflictHandler::Private::resolve()
         dialog.setWindowTitle(i18nc("@title:window", "%1: Conflict Resolution", mName));
     }
 
-    dialog.setConflictingItems(mLocalItem, mRemoteItem);
+    if (mMerge) {
+        // both sides only differ in the fields changed on both sides
+        dialog.setConflictingItems(mergedItem(mLocalItem, FieldMerge::Local), mergedItem(mRemoteItem, FieldMerge::Remote));
+    } else {
+        dialog.setConflictingItems(mLocalItem, mRemoteItem);
+    }
     dialog.setDifferencesInterface(mDiffInterface);
 
     dialog.exec();
@@ -93,36 +173,30 @@ void ConflictHandler::Private::resolve()
     ConflictHandler::ResolveStrategy solution = dialog.resolveStrategy();
     switch (solution) {
     case ConflictHandler::UseLocalItem:
+        if (mMerge) {
+            applyMerge(FieldMerge::Local);
+            break;
+        }
         // update the local items remote revision and try again
         mLocalItem.setRemoteRevision(mRemoteItem.remoteRevision());
         emit q->updateOnBackend(mLocalItem);
         break;
 
-    case ConflictHandler::UseOtherItem: {
-        // use remote item to acknowledge change
-        mRemoteItem.setId(mLocalItem.id());
-        mRemoteItem.setRevision(mLocalItem.revision());
-        emit q->commitChange(mRemoteItem);
-
-        // commit does not update payload, so we modify as well
-        auto *modifyJob = new ItemModifyJob(mRemoteItem, q);
-        modifyJob->disableRevisionCheck();
+    case ConflictHandler::UseOtherItem:
+        if (mMerge) {
+            // the local changes to other fields are kept
+            applyMerge(FieldMerge::Remote);
+            break;
+        }
+        useRemoteItem();
         break;
-    }
-    case ConflictHandler::UseBothItems: {
-        // use remote item to acknowledge change and duplicate local item
-        mRemoteItem.setId(mLocalItem.id());
-        mRemoteItem.setRevision(mLocalItem.revision());
-        emit q->commitChange(mRemoteItem);
-
-        // commit does not update payload, so we modify as well
-        auto *modifyJob = new ItemModifyJob(mRemoteItem, q);
-        modifyJob->disableRevisionCheck();
 
+    case ConflictHandler::UseBothItems:
+        // use remote item to acknowledge change and duplicate local item
+        useRemoteItem();
         createDuplicate(mLocalItem);
         break;
     }
-    }
 }
 
 void ConflictHandler::Private::createDuplicate(const Item &item)
@@ -132,6 +206,7 @@ void ConflictHandler::Private::createDuplicate(const Item &item)
     duplicate.setId(-1);
     duplicate.setRemoteId(QString());
     duplicate.setRemoteRevision(QString());
+    duplicate.removeAttribute<SyncBaseAttribute>();
 
     ItemCreateJob *job = new ItemCreateJob(duplicate, item.parentCollection(), mSession);
     connect(job, SIGNAL(result(KJob*)), q, SLOT(duplicateLocalItemResult(KJob*)));
@@ -178,6 +253,11 @@ void ConflictHandler::setDifferencesInterface(DifferencesAlgorithmInterface *int
     d->mDiffInterface = interface;
 }
 
+void ConflictHandler::setModuleHandler(ModuleHandler *handler)
+{
+    d->mHandler = handler;
+}
+
 void ConflictHandler::setParentName(const QString &name)
 {
     d->mName = name;
@@ -192,6 +272,9 @@ void ConflictHandler::start()
 {
     Q_ASSERT(d->mType == BackendConflict);
 
+    if (d->autoMerge()) {
+        return;
+    }
     d->resolve();
 }
 #include "moc_conflicthandler.cpp"
@@ -29,6 +29,7 @@
 #include <qwindowdefs.h>
 
 class KJob;
+class ModuleHandler;
 
 namespace Akonadi
 {
@@ -81,6 +82,14 @@ public:
 
     void setDifferencesInterface(Akonadi::DifferencesAlgorithmInterface *interface);
 
+    /**
+     * Sets the handler used to merge the changes field by field, when the changed item
+     * knows the version it was based on (SyncBaseAttribute). Changes to different fields
+     * are then merged without asking the user, who only has to resolve the fields
+     * changed on both sides.
+     */
+    void setModuleHandler(ModuleHandler *handler);
+
     void setParentName(const QString &name);
     void setParentWindowId(WId windowId);
 
@@ -752,11 +752,34 @@ KDSoapGenerated::TNS__Name_value_list ContactsHandler::addresseeToNameValueList(
 
 
 int ContactsHandler::setEntry(const Akonadi::Item &item, QString &newId, QString &errorMessage)
+{
+    KDSoapGenerated::TNS__Name_value_list valueList;
+    if (!itemToNameValueList(item, valueList)) {
+        return SugarJob::InvalidContextError;
+    }
+
+    return mSession->protocol()->setEntry(module(), valueList, newId, errorMessage);
+}
+
+int ContactsHandler::setEntries(const Akonadi::Item::List &items, QStringList &ids, QString &errorMessage)
+{
+    QMap<int, KDSoapGenerated::TNS__Name_value_list> valueLists;
+    for (int i = 0; i < items.count(); ++i) {
+        KDSoapGenerated::TNS__Name_value_list valueList;
+        if (itemToNameValueList(items.at(i), valueList)) {
+            valueLists.insert(i, valueList);
+        }
+    }
+
+    return sendEntries(valueLists, items.count(), ids, errorMessage);
+}
+
+bool ContactsHandler::itemToNameValueList(const Akonadi::Item &item, KDSoapGenerated::TNS__Name_value_list &valueList)
 {
     if (!item.hasPayload<KContacts::Addressee>()) {
         qCCritical(FATCRM_SUGARCRMRESOURCE_LOG) << "item (id=" << item.id() << ", remoteId=" << item.remoteId()
                  << ", mime=" << item.mimeType() << ") is missing Addressee payload";
-        return SugarJob::InvalidContextError;
+        return false;
     }
 
     QList<KDSoapGenerated::TNS__Name_value> itemList;
@@ -774,9 +797,8 @@ int ContactsHandler::setEntry(const Akonadi::Item &item, QString &newId, QString
     // add regular sugar fields
     const KContacts::Addressee addressee = item.payload<KContacts::Addressee>();
 
-    KDSoapGenerated::TNS__Name_value_list valueList = addresseeToNameValueList(addressee, itemList);
-
-    return mSession->protocol()->setEntry(module(), valueList, newId, errorMessage);
+    valueList = addresseeToNameValueList(addressee, itemList);
+    return true;
 }
 
 QString ContactsHandler::orderByForListing() const
@@ -919,6 +941,62 @@ bool ContactsHandler::needBackendChange(const Akonadi::Item &item, const QSet<QB
            modifiedParts.contains(partIdFromPayloadPart(Akonadi::ContactPart::Standard));
 }
 
+QMap<QString, QString> ContactsHandler::itemFieldValues(const Akonadi::Item &item) const
+{
+    QMap<QString, QString> values;
+    if (!item.hasPayload<KContacts::Addressee>()) {
+        return values;
+    }
+    const KContacts::Addressee addressee = item.payload<KContacts::Addressee>();
+
+    const AccessorHash accessors = accessorHash();
+    for (auto it = accessors.constBegin(); it != accessors.constEnd(); ++it) {
+        if ((*it).getter == nullptr) {
+            continue;
+        }
+        values.insert(it.key(), (*it).getter(addressee));
+    }
+
+    // custom sugar fields, stored as in itemFromEntry
+    const static QString customFieldPrefix("FATCRM-X-Custom-");
+    const QStringList customs = addressee.customs();
+    for (const QString &custom : customs) {
+        const int pos = custom.indexOf(':');
+        if (!custom.startsWith(customFieldPrefix) || pos == -1)
+            continue;
+        values.insert(custom.mid(customFieldPrefix.size(), pos - customFieldPrefix.size()), custom.mid(pos + 1));
+    }
+    return values;
+}
+
+bool ContactsHandler::setItemFieldValues(Akonadi::Item &item, const QMap<QString, QString> &values) const
+{
+    if (!item.hasPayload<KContacts::Addressee>()) {
+        return false;
+    }
+    KContacts::Addressee addressee = item.payload<KContacts::Addressee>();
+    KContacts::Address workAddress = addressee.address(KContacts::Address::Work | KContacts::Address::Pref);
+    KContacts::Address homeAddress = addressee.address(KContacts::Address::Home);
+
+    const AccessorHash accessors = accessorHash();
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+        const AccessorHash::const_iterator accessIt = accessors.constFind(it.key());
+        if (accessIt == accessors.constEnd()) {
+            addressee.insertCustom(QStringLiteral("FATCRM"), QStringLiteral("X-Custom-%1").arg(it.key()), it.value());
+        } else if (isAddressValue(it.key())) {
+            KContacts::Address &address =
+                isPrimaryAddressValue(it.key()) ? workAddress : homeAddress;
+            (*accessIt).setter.aSetter(it.value(), address);
+        } else {
+            (*accessIt).setter.vSetter(it.value(), addressee);
+        }
+    }
+    addressee.insertAddress(workAddress);
+    addressee.insertAddress(homeAddress);
+    item.setPayload<KContacts::Addressee>(addressee);
+    return true;
+}
+
 void ContactsHandler::compare(Akonadi::AbstractDifferencesReporter *reporter,
                               const Akonadi::Item &leftItem, const Akonadi::Item &rightItem)
 {
@@ -44,6 +44,7 @@ public:
 
     static KDSoapGenerated::TNS__Name_value_list addresseeToNameValueList(const KContacts::Addressee &addressee, QList<KDSoapGenerated::TNS__Name_value> itemList = {});
     int setEntry(const Akonadi::Item &item, QString &newId, QString &errorMessage) override;
+    int setEntries(const Akonadi::Item::List &items, QStringList &ids, QString &errorMessage) override;
 
     QString orderByForListing() const override;
     QStringList supportedSugarFields() const override;
@@ -55,10 +56,15 @@ public:
 
     bool needBackendChange(const Akonadi::Item &item, const QSet<QByteArray> &modifiedParts) const override;
 
+    QMap<QString, QString> itemFieldValues(const Akonadi::Item &item) const override;
+    bool setItemFieldValues(Akonadi::Item &item, const QMap<QString, QString> &values) const override;
+
     void compare(Akonadi::AbstractDifferencesReporter *reporter,
                  const Akonadi::Item &leftItem, const Akonadi::Item &rightItem) override;
 
 private:
+    static bool itemToNameValueList(const Akonadi::Item &item, KDSoapGenerated::TNS__Name_value_list &valueList);
+
     inline bool isAddressValue(const QString &value) const
     {
         return (isAltAddressValue(value) || isPrimaryAddressValue(value));
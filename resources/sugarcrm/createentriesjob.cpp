@@ -0,0 +1,208 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "createentriesjob.h"
+
+#include "modulehandler.h"
+#include "wsdl_sugar41.h"
+
+#include "sugarcrmresource_debug.h"
+
+#include <KLocalizedString>
+
+#include <QHash>
+
+using namespace Akonadi;
+
+class CreateEntriesJob::Private
+{
+    CreateEntriesJob *const q;
+
+public:
+    explicit Private(CreateEntriesJob *parent, const Item::List &items)
+        : q(parent), mItems(items)
+    {
+    }
+
+    bool readBack();
+    void createDone();
+    void createError(int error, const QString &errorMessage);
+
+public:
+    const Item::List mItems;
+    ModuleHandler *mHandler = nullptr;
+    int mBatchSize = 100;
+    int mNextIndex = 0; // survives a restart after logging in again
+    Item::List mBatchToReadBack; // created on the server, with their remote id
+    Item::List mCreatedItems;
+    Item::List mFailedItems;
+};
+
+// Returns false if the job restarts to log in again
+bool CreateEntriesJob::Private::readBack()
+{
+    QStringList ids;
+    ids.reserve(mBatchToReadBack.count());
+    for (const Item &item : qAsConst(mBatchToReadBack)) {
+        ids.append(item.remoteId());
+    }
+
+    QList<KDSoapGenerated::TNS__Entry_value> entryValues;
+    QString errorMessage;
+    const int result = mHandler->getEntries(ids, entryValues, errorMessage);
+    if (result == SugarJob::CouldNotConnectError && q->shouldTryRelogin()) {
+        // Read the batch back after logging in again
+        q->handleConnectError(result, errorMessage);
+        return false;
+    }
+    if (result != KJob::NoError) {
+        // The entries exist anyway, the next listing will bring their server side fields
+        qCWarning(FATCRM_SUGARCRMRESOURCE_LOG) << "Could not read back" << ids.count() << "created entries:" << result << errorMessage;
+    }
+
+    QHash<QString, KDSoapGenerated::TNS__Entry_value> entriesById;
+    for (const KDSoapGenerated::TNS__Entry_value &entryValue : qAsConst(entryValues)) {
+        entriesById.insert(entryValue.id(), entryValue);
+    }
+
+    Item::List batch;
+    batch.reserve(mBatchToReadBack.count());
+    for (const Item &createdItem : qAsConst(mBatchToReadBack)) {
+        const auto it = entriesById.constFind(createdItem.remoteId());
+        if (it == entriesById.constEnd()) {
+            batch.append(createdItem);
+            continue;
+        }
+        bool deleted = false;
+        Item item = mHandler->itemFromEntry(*it, createdItem.parentCollection(), deleted);
+        item.setId(createdItem.id());
+        item.setRevision(createdItem.revision());
+        mHandler->addLocalWrite(item.remoteId(), item.remoteRevision());
+        batch.append(item);
+    }
+    mBatchToReadBack.clear();
+    mCreatedItems += batch;
+    emit q->batchCreated(batch);
+    return true;
+}
+
+void CreateEntriesJob::Private::createDone()
+{
+    qCDebug(FATCRM_SUGARCRMRESOURCE_LOG) << mCreatedItems.count() << "entries created in module"
+                                         << mHandler->module() << mFailedItems.count() << "failed";
+    if (!mFailedItems.isEmpty()) {
+        q->setError(SugarJob::SoapError);
+        q->setErrorText(i18ncp("@info:status", "%1 entry could not be created in %2", "%1 entries could not be created in %2",
+                               mFailedItems.count(), moduleToName(mHandler->module())));
+    }
+    q->emitResult();
+}
+
+void CreateEntriesJob::Private::createError(int error, const QString &errorMessage)
+{
+    qCWarning(FATCRM_SUGARCRMRESOURCE_LOG) << q << error << errorMessage;
+    if (q->handleConnectError(error, errorMessage)) {
+        return;
+    }
+
+    q->setError(SugarJob::SoapError);
+    q->setErrorText(errorMessage);
+    q->emitResult();
+}
+
+CreateEntriesJob::CreateEntriesJob(const Item::List &items, SugarSession *session, QObject *parent)
+    : SugarJob(session, parent), d(new Private(this, items))
+{
+}
+
+CreateEntriesJob::~CreateEntriesJob()
+{
+    delete d;
+}
+
+void CreateEntriesJob::setModule(ModuleHandler *handler)
+{
+    d->mHandler = handler;
+}
+
+void CreateEntriesJob::setBatchSize(int batchSize)
+{
+    d->mBatchSize = qMax(1, batchSize);
+}
+
+int CreateEntriesJob::batchSize() const
+{
+    return d->mBatchSize;
+}
+
+Item::List CreateEntriesJob::items() const
+{
+    return d->mItems;
+}
+
+Item::List CreateEntriesJob::createdItems() const
+{
+    return d->mCreatedItems;
+}
+
+Item::List CreateEntriesJob::failedItems() const
+{
+    return d->mFailedItems;
+}
+
+void CreateEntriesJob::startSugarTask()
+{
+    Q_ASSERT(d->mHandler != nullptr);
+
+    // Logged in again after creating a batch: only read it back
+    if (!d->mBatchToReadBack.isEmpty() && !d->readBack()) {
+        return;
+    }
+
+    while (d->mNextIndex < d->mItems.count()) {
+        const Item::List batch = d->mItems.mid(d->mNextIndex, d->mBatchSize);
+        QStringList ids;
+        QString errorMessage;
+        const int result = d->mHandler->setEntries(batch, ids, errorMessage);
+        if (result != KJob::NoError) {
+            d->createError(result, errorMessage);
+            return;
+        }
+
+        d->mNextIndex += batch.count();
+        for (int i = 0; i < batch.count(); ++i) {
+            Item item = batch.at(i);
+            const QString id = ids.value(i);
+            if (id.isEmpty()) {
+                qCWarning(FATCRM_SUGARCRMRESOURCE_LOG) << "Item" << item.id() << "could not be created in module" << d->mHandler->module();
+                d->mFailedItems.append(item);
+            } else {
+                item.setRemoteId(id);
+                d->mBatchToReadBack.append(item);
+            }
+        }
+        if (!d->mBatchToReadBack.isEmpty() && !d->readBack()) {
+            return;
+        }
+    }
+    d->createDone();
+}
+
+#include "moc_createentriesjob.cpp"
@@ -0,0 +1,72 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef CREATEENTRIESJOB_H
+#define CREATEENTRIESJOB_H
+
+#include "sugarjob.h"
+
+#include <AkonadiCore/Item>
+
+class ModuleHandler;
+
+/**
+ * Creates many entries of one module, e.g. for an import: for every batchSize() items,
+ * one set_entries request creates the entries and one get_entries request reads them back,
+ * instead of a set_entry and a get_entry request per item (see CreateEntryJob).
+ *
+ * Items the server couldn't create don't stop the others, they are listed in failedItems()
+ * and the job then finishes with a SoapError. When logging in again, the job resumes with
+ * the batch it was working on, without creating its entries twice.
+ */
+class CreateEntriesJob : public SugarJob
+{
+    Q_OBJECT
+
+public:
+    CreateEntriesJob(const Akonadi::Item::List &items, SugarSession *session, QObject *parent = nullptr);
+
+    ~CreateEntriesJob() override;
+
+    void setModule(ModuleHandler *handler);
+
+    // Maximum number of entries per request, 100 by default
+    void setBatchSize(int batchSize);
+    int batchSize() const;
+
+    Akonadi::Item::List items() const;
+    // The created items, with their remote id and the payload read back from the server.
+    // Also set if the job failed in a later batch.
+    Akonadi::Item::List createdItems() const;
+    Akonadi::Item::List failedItems() const;
+
+Q_SIGNALS:
+    // Emitted after each batch, with the items it created
+    void batchCreated(const Akonadi::Item::List &items);
+
+protected:
+    void startSugarTask() override;
+
+private:
+    class Private;
+    Private *const d;
+};
+
+#endif
@@ -104,6 +104,7 @@ void CreateEntryJob::Private::getEntryDone(const TNS__Entry_value &entryValue)
     item.setRevision(mItem.revision());
     mItem = item;
     qCDebug(FATCRM_SUGARCRMRESOURCE_LOG) << "Got entry with revision" << mItem.remoteRevision();
+    mHandler->addLocalWrite(mItem.remoteId(), mItem.remoteRevision());
 
     q->emitResult();
 }
@@ -0,0 +1,202 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "deleteentriesjob.h"
+
+#include "sugarprotocolbase.h"
+#include "sugarsession.h"
+#include "wsdl_sugar41.h"
+
+#include "sugarcrmresource_debug.h"
+
+#include <KLocalizedString>
+
+#include <QHash>
+
+using namespace Akonadi;
+
+class DeleteEntriesJob::Private
+{
+    DeleteEntriesJob *const q;
+
+public:
+    explicit Private(DeleteEntriesJob *parent, const Item::List &items, Module moduleName)
+        : q(parent), mItems(items), mModule(moduleName)
+    {
+    }
+
+    static KDSoapGenerated::TNS__Name_value_list deletionList(const Item &item);
+
+    void entryDeleted(const Item &item);
+    void entryFailed(const Item &item, const QString &errorMessage);
+    void deleteDone();
+    void deleteError(int error, const QString &errorMessage);
+
+public:
+    const Item::List mItems;
+    const Module mModule;
+    int mBatchSize = 100;
+    int mNextIndex = 0; // survives a restart after logging in again
+    Item::List mDeletedItems;
+    Item::List mFailedItems;
+    QHash<QString, QString> mErrorMessages; // remote id -> error
+};
+
+KDSoapGenerated::TNS__Name_value_list DeleteEntriesJob::Private::deletionList(const Item &item)
+{
+    // delete just requires identifier and "deleted" field
+    KDSoapGenerated::TNS__Name_value idField;
+    idField.setName(QStringLiteral("id"));
+    idField.setValue(item.remoteId());
+
+    KDSoapGenerated::TNS__Name_value deletedField;
+    deletedField.setName(QStringLiteral("deleted"));
+    deletedField.setValue(QStringLiteral("1"));
+
+    KDSoapGenerated::TNS__Name_value_list valueList;
+    valueList.setItems(QList<KDSoapGenerated::TNS__Name_value>() << idField << deletedField);
+    return valueList;
+}
+
+void DeleteEntriesJob::Private::entryDeleted(const Item &item)
+{
+    mDeletedItems.append(item);
+}
+
+void DeleteEntriesJob::Private::entryFailed(const Item &item, const QString &errorMessage)
+{
+    qCWarning(FATCRM_SUGARCRMRESOURCE_LOG) << "Entry" << item.remoteId() << "could not be deleted from module"
+                                           << moduleToName(mModule) << errorMessage;
+    mFailedItems.append(item);
+    mErrorMessages.insert(item.remoteId(), errorMessage);
+}
+
+void DeleteEntriesJob::Private::deleteDone()
+{
+    qCDebug(FATCRM_SUGARCRMRESOURCE_LOG) << mDeletedItems.count() << "entries deleted from module"
+                                         << moduleToName(mModule) << mFailedItems.count() << "failed";
+    if (!mFailedItems.isEmpty()) {
+        q->setError(SugarJob::SoapError);
+        q->setErrorText(i18ncp("@info:status", "%1 entry could not be deleted from %2", "%1 entries could not be deleted from %2",
+                               mFailedItems.count(), moduleToName(mModule)));
+    }
+    q->emitResult();
+}
+
+void DeleteEntriesJob::Private::deleteError(int error, const QString &errorMessage)
+{
+    qCWarning(FATCRM_SUGARCRMRESOURCE_LOG) << q << error << errorMessage;
+    if (q->handleConnectError(error, errorMessage)) {
+        return;
+    }
+
+    q->setError(SugarJob::SoapError);
+    q->setErrorText(errorMessage);
+    q->emitResult();
+}
+
+DeleteEntriesJob::DeleteEntriesJob(const Item::List &items, SugarSession *session, Module moduleName, QObject *parent)
+    : SugarJob(session, parent), d(new Private(this, items, moduleName))
+{
+}
+
+DeleteEntriesJob::~DeleteEntriesJob()
+{
+    delete d;
+}
+
+void DeleteEntriesJob::setBatchSize(int batchSize)
+{
+    d->mBatchSize = qMax(1, batchSize);
+}
+
+int DeleteEntriesJob::batchSize() const
+{
+    return d->mBatchSize;
+}
+
+Item::List DeleteEntriesJob::items() const
+{
+    return d->mItems;
+}
+
+Item::List DeleteEntriesJob::deletedItems() const
+{
+    return d->mDeletedItems;
+}
+
+Item::List DeleteEntriesJob::failedItems() const
+{
+    return d->mFailedItems;
+}
+
+QString DeleteEntriesJob::errorMessage(const Item &item) const
+{
+    return d->mErrorMessages.value(item.remoteId());
+}
+
+void DeleteEntriesJob::startSugarTask()
+{
+    SugarProtocolBase *protocol = session()->protocol();
+    while (d->mNextIndex < d->mItems.count()) {
+        const Item::List batch = d->mItems.mid(d->mNextIndex, d->mBatchSize);
+        QList<KDSoapGenerated::TNS__Name_value_list> valueLists;
+        valueLists.reserve(batch.count());
+        for (const Item &item : batch) {
+            valueLists.append(Private::deletionList(item));
+        }
+
+        QStringList ids;
+        QString errorMessage;
+        const int result = protocol->setEntries(d->mModule, valueLists, ids, errorMessage);
+        if (result == KJob::NoError) {
+            for (int i = 0; i < batch.count(); ++i) {
+                if (ids.value(i).isEmpty()) {
+                    d->entryFailed(batch.at(i), i18nc("@info:status", "The server did not delete this entry"));
+                } else {
+                    d->entryDeleted(batch.at(i));
+                }
+            }
+            d->mNextIndex += batch.count();
+        } else if (result == SugarJob::SoapError) {
+            // The whole request was rejected, find out which entries the server doesn't like
+            qCDebug(FATCRM_SUGARCRMRESOURCE_LOG) << "set_entries failed:" << errorMessage << "- deleting" << batch.count() << "entries one by one";
+            for (const Item &item : batch) {
+                QString newId, entryErrorMessage;
+                const int entryResult = protocol->setEntry(d->mModule, Private::deletionList(item), newId, entryErrorMessage);
+                if (entryResult == KJob::NoError) {
+                    d->entryDeleted(item);
+                } else if (entryResult == SugarJob::SoapError) {
+                    d->entryFailed(item, entryErrorMessage);
+                } else {
+                    d->deleteError(entryResult, entryErrorMessage);
+                    return;
+                }
+                ++d->mNextIndex;
+            }
+        } else {
+            d->deleteError(result, errorMessage);
+            return;
+        }
+    }
+    d->deleteDone();
+}
+
+#include "moc_deleteentriesjob.cpp"
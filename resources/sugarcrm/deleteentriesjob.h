@@ -0,0 +1,64 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef DELETEENTRIESJOB_H
+#define DELETEENTRIESJOB_H
+
+#include "sugarjob.h"
+#include "modulename.h"
+
+#include <AkonadiCore/Item>
+
+/**
+ * Deletes many entries of one module, with a single set_entries request (deleted=1)
+ * for every batchSize() entries instead of one set_entry request per entry.
+ *
+ * Entries the server couldn't delete don't stop the others, they are listed in failedItems()
+ * and the job then finishes with a SoapError. If the server rejects a whole request,
+ * the entries of that request are deleted one by one to find out which ones fail.
+ */
+class DeleteEntriesJob : public SugarJob
+{
+    Q_OBJECT
+
+public:
+    DeleteEntriesJob(const Akonadi::Item::List &items, SugarSession *session, Module moduleName, QObject *parent = nullptr);
+
+    ~DeleteEntriesJob() override;
+
+    // Maximum number of entries per request, 100 by default
+    void setBatchSize(int batchSize);
+    int batchSize() const;
+
+    Akonadi::Item::List items() const;
+    Akonadi::Item::List deletedItems() const;
+    Akonadi::Item::List failedItems() const;
+    // Why item couldn't be deleted, for items in failedItems()
+    QString errorMessage(const Akonadi::Item &item) const;
+
+protected:
+    void startSugarTask() override;
+
+private:
+    class Private;
+    Private *const d;
+};
+
+#endif
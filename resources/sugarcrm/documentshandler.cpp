@@ -155,7 +155,7 @@ void DocumentsHandler::getExtraInformation(Akonadi::Item::List &items)
         // https://support.sugarcrm.com/Documentation/Sugar_Developer/Sugar_Developer_Guide_10.0/Integration/Web_Services/Legacy_API/Methods/get_relationships/
         // https://support.sugarcrm.com/Documentation/Sugar_Developer/Sugar_Developer_Guide_10.0/Cookbook/Web_Services/Legacy_API/SOAP/PHP/Retrieving_Related_Records/
         KDSoapGenerated::TNS__Get_entry_result_version2 result =
-                mSession->soap()->get_relationships(sessionId(), moduleToName(Module::Documents), document.id(),
+                mSession->soap()->get_relationships(soapSessionId(), moduleToName(Module::Documents), document.id(),
                                                     moduleToName(Module::Accounts).toLower(), {}, selectedFields,
                                                     {}, 0 /*deleted*/, QString(), 0 /*offset*/, 0 /*limit*/);
 
@@ -170,7 +170,7 @@ void DocumentsHandler::getExtraInformation(Akonadi::Item::List &items)
         }
 
         QStringList linkedOpportunityIds;
-        result = mSession->soap()->get_relationships(sessionId(), moduleToName(Module::Documents), document.id(),
+        result = mSession->soap()->get_relationships(soapSessionId(), moduleToName(Module::Documents), document.id(),
                                                      moduleToName(Module::Opportunities).toLower(), {}, selectedFields,
                                            {}, 0 /*deleted*/, QString(), 0 /*offset*/, 0 /*limit*/);
 
@@ -226,6 +226,16 @@ Akonadi::Item DocumentsHandler::itemFromEntry(const KDSoapGenerated::TNS__Entry_
     return item;
 }
 
+QMap<QString, QString> DocumentsHandler::itemFieldValues(const Akonadi::Item &item) const
+{
+    return payloadFieldValues<SugarDocument>(item);
+}
+
+bool DocumentsHandler::setItemFieldValues(Akonadi::Item &item, const QMap<QString, QString> &values) const
+{
+    return setPayloadFieldValues<SugarDocument>(item, values);
+}
+
 void DocumentsHandler::compare(Akonadi::AbstractDifferencesReporter *reporter,
                                const Akonadi::Item &leftItem, const Akonadi::Item &rightItem)
 {
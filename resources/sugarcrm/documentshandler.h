@@ -49,6 +49,9 @@ public:
     void getExtraInformation(Akonadi::Item::List &items) override;
     Akonadi::Item itemFromEntry(const KDSoapGenerated::TNS__Entry_value &entry, const Akonadi::Collection &parentCollection, bool &deleted) override;
 
+    QMap<QString, QString> itemFieldValues(const Akonadi::Item &item) const override;
+    bool setItemFieldValues(Akonadi::Item &item, const QMap<QString, QString> &values) const override;
+
     void compare(Akonadi::AbstractDifferencesReporter *reporter,
                  const Akonadi::Item &leftItem, const Akonadi::Item &rightItem) override;
 };
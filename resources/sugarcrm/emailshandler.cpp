@@ -115,7 +115,7 @@ void EmailsHandler::getExtraInformation(Akonadi::Item::List &items)
     KDSoapGenerated::TNS__Link_names_to_fields_array link_name_to_fields_array;
     // Blocking call
     const auto result =
-            mSession->soap()->get_entry_list(sessionId(), QStringLiteral("EmailText"), query, QString() /*orderBy*/,
+            mSession->soap()->get_entry_list(soapSessionId(), QStringLiteral("EmailText"), query, QString() /*orderBy*/,
                                    0 /*offset*/, selectedFields, link_name_to_fields_array,
                                    items.count() /*maxResults*/, 0 /*fetchDeleted*/, false /*favorites*/);
 
@@ -230,6 +230,16 @@ Akonadi::Item EmailsHandler::itemFromEntry(const KDSoapGenerated::TNS__Entry_val
     return item;
 }
 
+QMap<QString, QString> EmailsHandler::itemFieldValues(const Akonadi::Item &item) const
+{
+    return payloadFieldValues<SugarEmail>(item);
+}
+
+bool EmailsHandler::setItemFieldValues(Akonadi::Item &item, const QMap<QString, QString> &values) const
+{
+    return setPayloadFieldValues<SugarEmail>(item, values);
+}
+
 void EmailsHandler::compare(Akonadi::AbstractDifferencesReporter *reporter,
                                const Akonadi::Item &leftItem, const Akonadi::Item &rightItem)
 {
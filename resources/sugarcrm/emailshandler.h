@@ -52,6 +52,9 @@ public:
 
     Akonadi::Item itemFromEntry(const KDSoapGenerated::TNS__Entry_value &entry, const Akonadi::Collection &parentCollection, bool &deleted) override;
 
+    QMap<QString, QString> itemFieldValues(const Akonadi::Item &item) const override;
+    bool setItemFieldValues(Akonadi::Item &item, const QMap<QString, QString> &values) const override;
+
     void compare(Akonadi::AbstractDifferencesReporter *reporter,
                  const Akonadi::Item &leftItem, const Akonadi::Item &rightItem) override;
 };
@@ -44,7 +44,7 @@ void ItemTransferInterface::setSession(SugarSession *session)
 QString ItemTransferInterface::downloadDocumentRevision(const QString &documentRevisionId) const
 {
     KDSoapGenerated::Sugarsoap *soap = mSession->soap();
-    const QString sessionId = mSession->sessionId();
+    const QString sessionId = mSession->soapSessionId();
     if (sessionId.isEmpty()) {
         qWarning() << "No session! Need to login first.";
     }
@@ -76,7 +76,7 @@ QString ItemTransferInterface::uploadDocument(const QString &documentName, const
     }
 
     KDSoapGenerated::Sugarsoap *soap = mSession->soap();
-    const QString sessionId = mSession->sessionId();
+    const QString sessionId = mSession->soapSessionId();
     if (sessionId.isEmpty()) {
         qWarning() << "No session! Need to login first.";
     }
@@ -125,7 +125,7 @@ QString ItemTransferInterface::uploadDocument(const QString &documentName, const
 bool ItemTransferInterface::linkItem(const QString &sourceItemId, const QString &sourceModuleName,
                                      const QString &targetItemId, const QString &targetModuleName) const
 {
-    const QString sessionId = mSession->sessionId();
+    const QString sessionId = mSession->soapSessionId();
     if (sessionId.isEmpty()) {
         qWarning() << "No session! Need to login first.";
         return false;
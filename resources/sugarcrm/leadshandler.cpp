@@ -151,6 +151,16 @@ Akonadi::Item LeadsHandler::itemFromEntry(const KDSoapGenerated::TNS__Entry_valu
     return item;
 }
 
+QMap<QString, QString> LeadsHandler::itemFieldValues(const Akonadi::Item &item) const
+{
+    return payloadFieldValues<SugarLead>(item);
+}
+
+bool LeadsHandler::setItemFieldValues(Akonadi::Item &item, const QMap<QString, QString> &values) const
+{
+    return setPayloadFieldValues<SugarLead>(item, values);
+}
+
 void LeadsHandler::compare(Akonadi::AbstractDifferencesReporter *reporter,
                            const Akonadi::Item &leftItem, const Akonadi::Item &rightItem)
 {
@@ -119,8 +119,10 @@ void ListEntriesJob::Private::listNextEntries()
 void ListEntriesJob::Private::listEntriesDone(const EntriesListResult &callResult)
 {
     if (callResult.resultCount > 0) { // result_count is the size of entry_list, e.g. 100.
+        int skippedCount = 0;
         Item::List items =
-            mHandler->itemsFromListEntriesResponse(callResult.entryList, mCollection, mDeletedItems, &mLatestTimestampFromItems);
+            mHandler->itemsFromListEntriesResponse(callResult.entryList, mCollection, mDeletedItems, &mLatestTimestampFromItems,
+                                                   mListScope.isUpdateScope(), &skippedCount);
 
         qCDebug(FATCRM_SUGARCRMRESOURCE_LOG) << "List Entries for" << mHandler->module()
                  << "received" << callResult.entryList.items().size() << "SOAP entries, processed into" << items.count() << "items and" << mDeletedItems.count() << "deleted items.";
@@ -130,7 +132,8 @@ void ListEntriesJob::Private::listEntriesDone(const EntriesListResult &callResul
 
             emit q->itemsReceived(items, mListScope.isUpdateScope());
         }
-        mItemsAlreadyEmitted += items.count();
+        // skipped entries are part of mTotalCount too
+        mItemsAlreadyEmitted += items.count() + skippedCount;
         emit q->progress(mItemsAlreadyEmitted + mDeletedItems.count());
 
         mListScope.setOffset(callResult.nextOffset);
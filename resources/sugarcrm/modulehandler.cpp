@@ -30,8 +30,10 @@
 using namespace KDSoapGenerated;
 
 #include "kdcrmdata/kdcrmfields.h"
+#include "kdcrmdata/kdcrmtrace.h"
 #include "kdcrmdata/kdcrmutils.h"
 #include "kdcrmdata/enumdefinitionattribute.h"
+#include "kdcrmdata/syncbaseattribute.h"
 
 #include "currency.h"
 #include "sugarprotocolbase.h"
@@ -56,6 +58,7 @@ ModuleHandler::ModuleHandler(const Module moduleName, SugarSession *session)
     static bool initDone = false;
     if (!initDone) {
         Akonadi::AttributeFactory::registerAttribute<EnumDefinitionAttribute>();
+        Akonadi::AttributeFactory::registerAttribute<SyncBaseAttribute>();
         initDone = true;
     }
 }
@@ -157,6 +160,44 @@ KDSoapGenerated::TNS__Field_list ModuleHandler::listAvailableFields(SugarSession
     return fields;
 }
 
+int ModuleHandler::setEntries(const Akonadi::Item::List &items, QStringList &ids, QString &errorMessage)
+{
+    ids.clear();
+    ids.reserve(items.count());
+    for (const Akonadi::Item &item : items) {
+        QString id;
+        int result = setEntry(item, id, errorMessage);
+        if (result == KJob::NoError) {
+            result = saveExtraInformation(item, id, errorMessage);
+        }
+        if (result == SugarJob::SoapError || result == SugarJob::InvalidContextError) {
+            // Only this item failed, go on with the others
+            id.clear();
+        } else if (result != KJob::NoError) {
+            return result;
+        }
+        ids.append(id);
+    }
+    return KJob::NoError;
+}
+
+int ModuleHandler::sendEntries(const QMap<int, KDSoapGenerated::TNS__Name_value_list> &valueLists, int itemCount,
+                               QStringList &ids, QString &errorMessage)
+{
+    QStringList sentIds;
+    const int result = mSession->protocol()->setEntries(mModule, valueLists.values(), sentIds, errorMessage);
+    ids.clear();
+    ids.reserve(itemCount);
+    for (int i = 0; i < itemCount; ++i) {
+        ids.append(QString());
+    }
+    int sent = 0;
+    for (auto it = valueLists.constBegin(); it != valueLists.constEnd(); ++it, ++sent) {
+        ids[it.key()] = sentIds.value(sent);
+    }
+    return result;
+}
+
 int ModuleHandler::getEntry(const Akonadi::Item &item, KDSoapGenerated::TNS__Entry_value &entryValue, QString &errorMessage)
 {
     if (item.remoteId().isEmpty()) {
@@ -167,6 +208,11 @@ int ModuleHandler::getEntry(const Akonadi::Item &item, KDSoapGenerated::TNS__Ent
     return mSession->protocol()->getEntry(mModule, item.remoteId(), supportedSugarFields(), entryValue, errorMessage);
 }
 
+int ModuleHandler::getEntries(const QStringList &ids, QList<KDSoapGenerated::TNS__Entry_value> &entryValues, QString &errorMessage)
+{
+    return mSession->protocol()->getEntries(mModule, ids, supportedSugarFields(), entryValues, errorMessage);
+}
+
 
 bool ModuleHandler::hasEnumDefinitions() const
 {
@@ -195,7 +241,7 @@ bool ModuleHandler::parseFieldList(Akonadi::Collection &collection, const TNS__F
                     // In general, name==value except for some like
                     // name="QtonAndroidFreeSessions" value="Qt on Android Free Sessions"
                     //qCDebug(FATCRM_SUGARCRMRESOURCE_LOG) << nameValue.name() << nameValue.value();
-                    definition.mEnumValues.append(EnumDefinitions::KeyValue{nameValue.name(), nameValue.value()});
+                    definition.append(EnumDefinitions::KeyValue{nameValue.name(), nameValue.value()});
                 }
                 mEnumDefinitions.append(definition);
             }
@@ -212,11 +258,11 @@ bool ModuleHandler::parseFieldList(Akonadi::Collection &collection, const TNS__F
             if (result == KJob::NoError) {
                 EnumDefinitions::Enum definition(KDCRMFields::currencyId());
                 // The magic id -99 for EUR is in the SuiteCRM source code...
-                definition.mEnumValues.append(EnumDefinitions::KeyValue{QString("-99"), QString::fromUtf8("€")});
+                definition.append(EnumDefinitions::KeyValue{QString("-99"), QString::fromUtf8("€")});
                 const auto items = entriesListResult.entryList.items();
                 for (const KDSoapGenerated::TNS__Entry_value &entry : items) {
                     const Currency cur(entry);
-                    definition.mEnumValues.append(EnumDefinitions::KeyValue{cur.id(), cur.symbol()});
+                    definition.append(EnumDefinitions::KeyValue{cur.id(), cur.symbol()});
                 }
                 mEnumDefinitions.append(definition);
             }
@@ -229,21 +275,54 @@ bool ModuleHandler::parseFieldList(Akonadi::Collection &collection, const TNS__F
         // Emails: type, status
         // Notes: <none>
         auto *attr = collection.attribute<EnumDefinitionAttribute>(Akonadi::Collection::AddIfMissing);
-        const QString serialized = mEnumDefinitions.toString();
-        if (attr->value() != serialized) {
-            attr->setValue(serialized);
+        const QByteArray serialized = mEnumDefinitions.toBinary();
+        if (attr->serialized() != serialized) {
+            attr->deserialize(serialized);
             return true;
         }
     }
     return false; // no change
 }
 
-Akonadi::Item::List ModuleHandler::itemsFromListEntriesResponse(const KDSoapGenerated::TNS__Entry_list &entryList, const Akonadi::Collection &parentCollection, Akonadi::Item::List &deletedItems, QString *lastTimestamp)
+// Reads date_modified without converting the whole entry
+static QString dateModifiedFromEntry(const KDSoapGenerated::TNS__Entry_value &entry)
 {
+    const QList<KDSoapGenerated::TNS__Name_value> valueList = entry.name_value_list().items();
+    for (const KDSoapGenerated::TNS__Name_value &namedValue : valueList) {
+        if (namedValue.name() == QLatin1String("date_modified")) {
+            return namedValue.value();
+        }
+    }
+    return QString();
+}
+
+Akonadi::Item::List ModuleHandler::itemsFromListEntriesResponse(const KDSoapGenerated::TNS__Entry_list &entryList, const Akonadi::Collection &parentCollection, Akonadi::Item::List &deletedItems, QString *lastTimestamp,
+                                                                bool skipLocalWrites, int *skippedCount)
+{
+    FATCRM_TRACE_SCOPE("conversion", "ModuleHandler::itemsFromListEntriesResponse");
+    FATCRM_TRACE_SET_COUNT(entryList.items().size());
+    FATCRM_TRACE_SET_DETAIL(moduleToName(module()));
     Akonadi::Item::List items;
     items.reserve(entryList.items().size());
 
+    int skippedLocalWrites = 0;
     Q_FOREACH (const KDSoapGenerated::TNS__Entry_value &entry, entryList.items()) {
+        if (!mLocalWrites.isEmpty()) {
+            const auto it = mLocalWrites.find(entry.id());
+            if (it != mLocalWrites.end()) {
+                const QString dateModified = dateModifiedFromEntry(entry);
+                const bool isEcho = (dateModified == *it);
+                mLocalWrites.erase(it); // either way, later listings must not skip it
+                if (isEcho && skipLocalWrites) {
+                    ++skippedLocalWrites;
+                    if (lastTimestamp->isEmpty() || dateModified > *lastTimestamp) {
+                        *lastTimestamp = dateModified;
+                    }
+                    continue;
+                }
+            }
+        }
+
         bool deleted = false;
         const Akonadi::Item item = itemFromEntry(entry, parentCollection, deleted);
         if (!item.remoteId().isEmpty()) {
@@ -258,9 +337,21 @@ Akonadi::Item::List ModuleHandler::itemsFromListEntriesResponse(const KDSoapGene
         }
     }
 
+    if (skippedLocalWrites > 0) {
+        qCDebug(FATCRM_SUGARCRMRESOURCE_LOG) << moduleToName(module()) << ": skipped" << skippedLocalWrites << "entries written by the resource";
+    }
+    *skippedCount = skippedLocalWrites;
+
     return items;
 }
 
+void ModuleHandler::addLocalWrite(const QString &id, const QString &dateModified)
+{
+    if (!id.isEmpty() && !dateModified.isEmpty()) {
+        mLocalWrites.insert(id, dateModified);
+    }
+}
+
 bool ModuleHandler::needBackendChange(const Akonadi::Item &item, const QSet<QByteArray> &modifiedParts) const
 {
     Q_UNUSED(item);
@@ -486,9 +577,9 @@ const QMap<QString, QString>& ModuleHandler::fieldNamesMapping()
     return mapping;
 }
 
-QString ModuleHandler::sessionId() const
+QString ModuleHandler::soapSessionId() const
 {
-    return mSession->sessionId();
+    return mSession->soapSessionId();
 }
 
 void ModuleHandler::slotCollectionModifyResult(KJob *job)
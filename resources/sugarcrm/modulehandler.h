@@ -29,6 +29,8 @@
 #include <AkonadiCore/Item>
 #include <AkonadiCore/Collection>
 
+#include <QHash>
+#include <QMap>
 #include <QStringList>
 #include "sugarprotocolbase.h"
 #include "modulename.h"
@@ -72,7 +74,14 @@ public:
     virtual int setEntry(const Akonadi::Item &item, QString &id, QString &errorMessage) = 0;
     virtual int expectedContentsVersion() const { return 0; }
 
+    // Creates or updates several items with one set_entries request. ids gets one id per item,
+    // empty for the items which couldn't be saved. The default implementation calls setEntry
+    // and saveExtraInformation for each item.
+    virtual int setEntries(const Akonadi::Item::List &items, QStringList &ids, QString &errorMessage);
+
     int getEntry(const Akonadi::Item &item, KDSoapGenerated::TNS__Entry_value &entryValue, QString &errorMessage);
+    // Reads several entries back with one get_entries request, unknown ids are skipped
+    int getEntries(const QStringList &ids, QList<KDSoapGenerated::TNS__Entry_value> &entryValues, QString &errorMessage);
 
     // Return true if the handler wants to fetch extra information on listed items
     // (e.g. email text, linked doucments, linked contacts...)
@@ -104,11 +113,25 @@ public:
 
     bool parseFieldList(Akonadi::Collection &collection, const KDSoapGenerated::TNS__Field_list &fields);
 
+    // skipLocalWrites: only for update listings; a full listing is a full sync, where a skipped entry would be deleted.
+    // skippedCount: the number of entries skipped because of addLocalWrite
     Akonadi::Item::List itemsFromListEntriesResponse(const KDSoapGenerated::TNS__Entry_list &entryList,
-            const Akonadi::Collection &parentCollection, Akonadi::Item::List &deletedItems, QString *lastTimestamp);
+            const Akonadi::Collection &parentCollection, Akonadi::Item::List &deletedItems, QString *lastTimestamp,
+            bool skipLocalWrites, int *skippedCount);
+
+    // Records an entry written by the resource, as read back from the server after the write.
+    // The next update listing skips that entry if it still has this date_modified, since Akonadi already has it.
+    void addLocalWrite(const QString &id, const QString &dateModified);
+    int localWriteCount() const { return mLocalWrites.count(); }
 
     virtual bool needBackendChange(const Akonadi::Item &item, const QSet<QByteArray> &modifiedParts) const;
 
+    // The field values of the item's payload, for the three-way merge of conflicting changes
+    // (see FieldMerge). Empty if the item doesn't have a payload of the module's type.
+    virtual QMap<QString, QString> itemFieldValues(const Akonadi::Item &item) const = 0;
+    // Sets field values, as returned by itemFieldValues(), into the item's payload
+    virtual bool setItemFieldValues(Akonadi::Item &item, const QMap<QString, QString> &values) const = 0;
+
 protected:
     SugarSession *mSession;
     Module mModule;
@@ -128,7 +151,34 @@ protected:
     static QString customSugarFieldFromCrmField(const QString &crmFieldName);
     QStringList sugarFieldsFromCrmFields(const QStringList &crmFieldNames) const;
 
-    QString sessionId() const;
+    // For the calls made directly through SugarSession::soap()
+    QString soapSessionId() const;
+
+    // itemFieldValues() and setItemFieldValues() for the kdcrmdata types, through data() and setData()
+    template <typename T>
+    static QMap<QString, QString> payloadFieldValues(const Akonadi::Item &item)
+    {
+        if (!item.hasPayload<T>()) {
+            return QMap<QString, QString>();
+        }
+        return item.payload<T>().data();
+    }
+    template <typename T>
+    static bool setPayloadFieldValues(Akonadi::Item &item, const QMap<QString, QString> &values)
+    {
+        if (!item.hasPayload<T>()) {
+            return false;
+        }
+        T payload = item.payload<T>();
+        payload.setData(values);
+        item.setPayload<T>(payload);
+        return true;
+    }
+
+    // For setEntries implementations: sends valueLists (item position -> name_value_list) with one
+    // set_entries request, the items without a name_value_list get an empty id
+    int sendEntries(const QMap<int, KDSoapGenerated::TNS__Name_value_list> &valueLists, int itemCount,
+                    QStringList &ids, QString &errorMessage);
 
 private Q_SLOTS:
     void slotCollectionModifyResult(KJob *);
@@ -142,6 +192,8 @@ private:
     EnumDefinitions mEnumDefinitions;
     bool mParsedEnumDefinitions;
     bool mHasEnumDefinitions; // whether present in DB (possibly old, though)
+
+    QHash<QString, QString> mLocalWrites; // id -> date_modified
 };
 
 #endif
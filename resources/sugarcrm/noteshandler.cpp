@@ -160,6 +160,16 @@ Akonadi::Item NotesHandler::itemFromEntry(const KDSoapGenerated::TNS__Entry_valu
     return item;
 }
 
+QMap<QString, QString> NotesHandler::itemFieldValues(const Akonadi::Item &item) const
+{
+    return payloadFieldValues<SugarNote>(item);
+}
+
+bool NotesHandler::setItemFieldValues(Akonadi::Item &item, const QMap<QString, QString> &values) const
+{
+    return setPayloadFieldValues<SugarNote>(item, values);
+}
+
 void NotesHandler::compare(Akonadi::AbstractDifferencesReporter *reporter,
                                const Akonadi::Item &leftItem, const Akonadi::Item &rightItem)
 {
@@ -246,6 +246,16 @@ Akonadi::Item OpportunitiesHandler::itemFromEntry(const KDSoapGenerated::TNS__En
     return item;
 }
 
+QMap<QString, QString> OpportunitiesHandler::itemFieldValues(const Akonadi::Item &item) const
+{
+    return payloadFieldValues<SugarOpportunity>(item);
+}
+
+bool OpportunitiesHandler::setItemFieldValues(Akonadi::Item &item, const QMap<QString, QString> &values) const
+{
+    return setPayloadFieldValues<SugarOpportunity>(item, values);
+}
+
 void OpportunitiesHandler::compare(Akonadi::AbstractDifferencesReporter *reporter,
                                    const Akonadi::Item &leftItem, const Akonadi::Item &rightItem)
 {
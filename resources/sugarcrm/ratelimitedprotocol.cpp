@@ -0,0 +1,178 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "ratelimitedprotocol.h"
+#include "sugarjob.h"
+#include "sugarcrmresource_debug.h"
+
+RateLimitedProtocol::RateLimitedProtocol(SugarProtocolBase *protocol, RateLimiter::Clock *clock)
+    : mProtocol(protocol),
+      mRateLimiter(clock)
+{
+}
+
+RateLimitedProtocol::~RateLimitedProtocol()
+{
+    delete mProtocol;
+}
+
+RateLimiter &RateLimitedProtocol::rateLimiter()
+{
+    return mRateLimiter;
+}
+
+SugarProtocolBase *RateLimitedProtocol::protocol() const
+{
+    return mProtocol;
+}
+
+template<typename Call>
+int RateLimitedProtocol::call(const char *name, CallType type, Call call) const
+{
+    for (int attempt = 0; ; ++attempt) {
+        mRateLimiter.acquire();
+        const int result = call();
+        if (result != SugarJob::ThrottledError && result != SugarJob::ServiceUnavailableError) {
+            mRateLimiter.succeeded();
+            return result;
+        }
+        const int delay = mRateLimiter.throttled(attempt, mProtocol->retryAfter());
+        if (result == SugarJob::ServiceUnavailableError && type == Write) {
+            // The write may have been done before a proxy gave up on it, sending it again could
+            // e.g. create the entry twice. retryAfter() tells the resource how long to wait.
+            qCWarning(FATCRM_SUGARCRMRESOURCE_LOG) << name << "got service unavailable, not retrying a write";
+            return result;
+        }
+        if (attempt >= mRateLimiter.maxRetries()) {
+            // retryAfter() now tells the resource how long to wait
+            qCWarning(FATCRM_SUGARCRMRESOURCE_LOG) << name << "still throttled after" << attempt << "retries, giving up";
+            return result;
+        }
+        // A read, or a write rejected by the server with 429: the same call can be sent again
+        qCDebug(FATCRM_SUGARCRMRESOURCE_LOG) << name << "throttled by the server, retrying in" << delay << "ms";
+    }
+}
+
+int RateLimitedProtocol::login(const QString &user, const QString &password, QString &sessionId, QString &errorMessage)
+{
+    return call("login", Read, [&]() {
+        return mProtocol->login(user, password, sessionId, errorMessage);
+    });
+}
+
+void RateLimitedProtocol::logout()
+{
+    mRateLimiter.acquire();
+    mProtocol->logout();
+}
+
+void RateLimitedProtocol::setSession(SugarSession *session)
+{
+    mProtocol->setSession(session);
+}
+
+int RateLimitedProtocol::getEntriesCount(const ListEntriesScope &scope, Module moduleName, const QString &query, int &entriesCount, QString &errorMessage)
+{
+    return call("getEntriesCount", Read, [&]() {
+        return mProtocol->getEntriesCount(scope, moduleName, query, entriesCount, errorMessage);
+    });
+}
+
+int RateLimitedProtocol::getModuleFields(const QString &moduleName, KDSoapGenerated::TNS__Field_list &fields, QString &errorMessage)
+{
+    return call("getModuleFields", Read, [&]() {
+        return mProtocol->getModuleFields(moduleName, fields, errorMessage);
+    });
+}
+
+int RateLimitedProtocol::listEntries(const ListEntriesScope &scope, Module moduleName, const QString &query,
+                                     const QString &orderBy, const QStringList &selectedFields, EntriesListResult &entriesListResult,
+                                     QString &errorMessage)
+{
+    return call("listEntries", Read, [&]() {
+        return mProtocol->listEntries(scope, moduleName, query, orderBy, selectedFields, entriesListResult, errorMessage);
+    });
+}
+
+int RateLimitedProtocol::setEntry(Module moduleName, const KDSoapGenerated::TNS__Name_value_list &name_value_list, QString &id, QString &errorMessage)
+{
+    return call("setEntry", Write, [&]() {
+        return mProtocol->setEntry(moduleName, name_value_list, id, errorMessage);
+    });
+}
+
+int RateLimitedProtocol::setEntries(Module moduleName, const QList<KDSoapGenerated::TNS__Name_value_list> &nameValueLists, QStringList &ids, QString &errorMessage)
+{
+    return call("setEntries", Write, [&]() {
+        return mProtocol->setEntries(moduleName, nameValueLists, ids, errorMessage);
+    });
+}
+
+SugarProtocolBase::GetRelationShipsResult RateLimitedProtocol::getRelationships(const QString &sourceItemId, Module sourceModule, Module targetModule) const
+{
+    GetRelationShipsResult result;
+    call("getRelationships", Read, [&]() {
+        result = mProtocol->getRelationships(sourceItemId, sourceModule, targetModule);
+        return result.errorCode;
+    });
+    return result;
+}
+
+int RateLimitedProtocol::setRelationship(const QString &sourceItemId, Module sourceModule,
+                                         const QStringList &targetItemIds, Module targetModule, bool shouldDelete, QString &errorMessage) const
+{
+    return call("setRelationship", Write, [&]() {
+        return mProtocol->setRelationship(sourceItemId, sourceModule, targetItemIds, targetModule, shouldDelete, errorMessage);
+    });
+}
+
+int RateLimitedProtocol::getEntry(Module moduleName, const QString &remoteId, const QStringList &selectedFields,
+                                  KDSoapGenerated::TNS__Entry_value &entryValue, QString &errorMessage)
+{
+    return call("getEntry", Read, [&]() {
+        return mProtocol->getEntry(moduleName, remoteId, selectedFields, entryValue, errorMessage);
+    });
+}
+
+int RateLimitedProtocol::getEntries(Module moduleName, const QStringList &remoteIds, const QStringList &selectedFields,
+                                    QList<KDSoapGenerated::TNS__Entry_value> &entryValues, QString &errorMessage)
+{
+    return call("getEntries", Read, [&]() {
+        return mProtocol->getEntries(moduleName, remoteIds, selectedFields, entryValues, errorMessage);
+    });
+}
+
+int RateLimitedProtocol::listModules(QStringList &moduleNames, QString &errorMessage)
+{
+    return call("listModules", Read, [&]() {
+        return mProtocol->listModules(moduleNames, errorMessage);
+    });
+}
+
+int RateLimitedProtocol::retryAfter() const
+{
+    const int delay = mRateLimiter.recommendedDelay();
+    return delay > 0 ? delay : mProtocol->retryAfter();
+}
+
+bool RateLimitedProtocol::hasSoapSession() const
+{
+    return mProtocol->hasSoapSession();
+}
@@ -0,0 +1,79 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef RATELIMITEDPROTOCOL_H
+#define RATELIMITEDPROTOCOL_H
+
+#include "sugarprotocolbase.h"
+#include "ratelimiter.h"
+
+/**
+ * Puts a RateLimiter in front of every call of another protocol: calls wait for a token,
+ * and calls which the server throttled are retried after a backoff, so that a long sync
+ * or import slows down instead of failing.
+ *
+ * Only what is safe to send twice is retried: reads on both SugarJob::ThrottledError (HTTP 429,
+ * the server rejected the request) and ServiceUnavailableError (HTTP 503, which a proxy can send
+ * after the server handled the request), writes only on ThrottledError.
+ *
+ * When the retries are exhausted, the error is returned and retryAfter() tells how long
+ * the resource should wait before trying again.
+ */
+class RateLimitedProtocol : public SugarProtocolBase
+{
+public:
+    // Takes ownership of protocol and clock (nullptr for the real time)
+    explicit RateLimitedProtocol(SugarProtocolBase *protocol, RateLimiter::Clock *clock = nullptr);
+    ~RateLimitedProtocol() override;
+
+    RateLimiter &rateLimiter();
+    SugarProtocolBase *protocol() const;
+
+    int login(const QString &user, const QString &password, QString &sessionId, QString &errorMessage) override;
+    void logout() override;
+    void setSession(SugarSession *session) override;
+    int getEntriesCount(const ListEntriesScope &scope, Module moduleName, const QString &query, int &entriesCount, QString &errorMessage) override;
+    int getModuleFields(const QString &moduleName, KDSoapGenerated::TNS__Field_list &fields, QString &errorMessage) override;
+    int listEntries(const ListEntriesScope &scope, Module moduleName, const QString &query,
+                    const QString &orderBy, const QStringList &selectedFields, EntriesListResult &entriesListResult,
+                    QString &errorMessage) override;
+    int setEntry(Module moduleName, const KDSoapGenerated::TNS__Name_value_list &name_value_list, QString &id, QString &errorMessage) override;
+    int setEntries(Module moduleName, const QList<KDSoapGenerated::TNS__Name_value_list> &nameValueLists, QStringList &ids, QString &errorMessage) override;
+    GetRelationShipsResult getRelationships(const QString &sourceItemId, Module sourceModule, Module targetModule) const override;
+    int setRelationship(const QString &sourceItemId, Module sourceModule,
+                        const QStringList &targetItemIds, Module targetModule, bool shouldDelete, QString &errorMessage) const override;
+    int getEntry(Module moduleName, const QString &remoteId, const QStringList &selectedFields,
+                 KDSoapGenerated::TNS__Entry_value &entryValue, QString &errorMessage) override;
+    int getEntries(Module moduleName, const QStringList &remoteIds, const QStringList &selectedFields,
+                   QList<KDSoapGenerated::TNS__Entry_value> &entryValues, QString &errorMessage) override;
+    int listModules(QStringList &moduleNames, QString &errorMessage) override;
+    int retryAfter() const override;
+    bool hasSoapSession() const override;
+
+private:
+    enum CallType { Read, Write };
+    template<typename Call>
+    int call(const char *name, CallType type, Call call) const;
+
+    SugarProtocolBase *const mProtocol;
+    mutable RateLimiter mRateLimiter;
+};
+
+#endif // RATELIMITEDPROTOCOL_H
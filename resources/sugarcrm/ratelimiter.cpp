@@ -0,0 +1,166 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "ratelimiter.h"
+
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+
+#include <cmath>
+
+namespace {
+
+class RealClock : public RateLimiter::Clock
+{
+public:
+    RealClock()
+    {
+        mTimer.start();
+    }
+
+    qint64 currentMSecs() const override
+    {
+        return mTimer.elapsed();
+    }
+
+    // Like the protocol calls, keep processing events while waiting
+    void sleep(int msecs) override
+    {
+        QEventLoop eventLoop;
+        QTimer::singleShot(msecs, &eventLoop, &QEventLoop::quit);
+        eventLoop.exec(QEventLoop::ExcludeUserInputEvents);
+    }
+
+private:
+    QElapsedTimer mTimer;
+};
+
+}
+
+RateLimiter::Clock::~Clock()
+{
+}
+
+RateLimiter::RateLimiter(Clock *clock)
+    : mClock(clock ? clock : new RealClock),
+      mRandom(std::random_device()())
+{
+}
+
+RateLimiter::~RateLimiter()
+{
+    delete mClock;
+}
+
+void RateLimiter::setRate(double requestsPerSecond, int burstSize)
+{
+    mRate = qMax(0.0, requestsPerSecond);
+    mBurstSize = qMax(1, burstSize);
+    mTokens = mBurstSize;
+    mLastRefill = -1;
+}
+
+double RateLimiter::rate() const
+{
+    return mRate;
+}
+
+void RateLimiter::setBackoff(int initialDelayMSecs, int maxDelayMSecs, int maxRetries)
+{
+    mInitialDelay = qMax(1, initialDelayMSecs);
+    mMaxDelay = qMax(mInitialDelay, maxDelayMSecs);
+    mMaxRetries = qMax(0, maxRetries);
+}
+
+int RateLimiter::maxRetries() const
+{
+    return mMaxRetries;
+}
+
+void RateLimiter::setJitterSeed(quint32 seed)
+{
+    mRandom.seed(seed);
+}
+
+void RateLimiter::wait(qint64 msecs)
+{
+    if (msecs > 0) {
+        mClock->sleep(int(msecs));
+        mTotalWaitTime += msecs;
+    }
+}
+
+void RateLimiter::acquire()
+{
+    wait(mBlockedUntil - mClock->currentMSecs());
+    if (mRate <= 0) {
+        return;
+    }
+
+    const qint64 now = mClock->currentMSecs();
+    if (mLastRefill >= 0) {
+        mTokens = qMin(double(mBurstSize), mTokens + (now - mLastRefill) * mRate / 1000);
+    }
+    mLastRefill = now;
+    if (mTokens < 1) {
+        const qint64 missing = qint64(std::ceil((1 - mTokens) * 1000 / mRate));
+        wait(missing);
+        mLastRefill = mClock->currentMSecs();
+        mTokens = 1;
+    }
+    mTokens -= 1;
+}
+
+int RateLimiter::throttled(int attempt, int serverDelayMSecs)
+{
+    // initialDelay * 2^attempt without overflowing
+    qint64 delay = mInitialDelay;
+    for (int i = 0; i < attempt && delay < mMaxDelay; ++i) {
+        delay *= 2;
+    }
+    delay = qMin<qint64>(delay, mMaxDelay);
+    // "Equal jitter": between half and all of it, so that parallel clients don't retry in sync
+    std::uniform_int_distribution<qint64> jitter(0, delay / 2);
+    delay -= jitter(mRandom);
+    delay = qMax<qint64>(delay, serverDelayMSecs);
+
+    mBlockedUntil = mClock->currentMSecs() + delay;
+    // The bucket is probably too optimistic, start again from empty after the pause
+    mTokens = 0;
+    mLastRefill = mBlockedUntil;
+    mRecommendedDelay = int(delay);
+    return mRecommendedDelay;
+}
+
+void RateLimiter::succeeded()
+{
+    mRecommendedDelay = 0;
+}
+
+int RateLimiter::recommendedDelay() const
+{
+    return mRecommendedDelay;
+}
+
+qint64 RateLimiter::totalWaitTime() const
+{
+    return mTotalWaitTime;
+}
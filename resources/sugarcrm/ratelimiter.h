@@ -0,0 +1,96 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef RATELIMITER_H
+#define RATELIMITER_H
+
+#include <QtGlobal>
+
+#include <random>
+
+/**
+ * Paces the requests sent to the server: a token bucket allowing bursts of a few requests,
+ * refilled at a fixed rate, plus exponential backoff (with jitter) after the server throttled us.
+ *
+ * Waiting is synchronous, like the protocol calls themselves. The clock can be replaced
+ * for tests, so that nothing actually sleeps.
+ */
+class RateLimiter
+{
+public:
+    class Clock
+    {
+    public:
+        virtual ~Clock();
+        // Monotonic time in milliseconds
+        virtual qint64 currentMSecs() const = 0;
+        virtual void sleep(int msecs) = 0;
+    };
+
+    // Takes ownership of clock, nullptr means the real time (sleeping in an event loop)
+    explicit RateLimiter(Clock *clock = nullptr);
+    ~RateLimiter();
+
+    // At most requestsPerSecond on average, after an initial burst of up to burstSize.
+    // A rate of 0 (the default) disables the limit, only the backoff remains.
+    void setRate(double requestsPerSecond, int burstSize);
+    double rate() const;
+
+    // After the n-th throttled attempt (from 0), wait initialDelay * 2^n (at most maxDelay),
+    // minus a random jitter of up to half of that, before retrying. At most maxRetries retries.
+    void setBackoff(int initialDelayMSecs, int maxDelayMSecs, int maxRetries);
+    int maxRetries() const;
+    void setJitterSeed(quint32 seed);
+
+    // Waits until a request may be sent, and consumes a token for it
+    void acquire();
+    // Reports that the server throttled the attempt-th try of a request (from 0).
+    // The next acquire() will wait for the backoff delay, or for serverDelayMSecs
+    // (e.g. from a Retry-After header, -1 if unknown) if that's longer. Returns that delay.
+    int throttled(int attempt, int serverDelayMSecs);
+    // Reports that a request went through, so that the recommended delay is reset
+    void succeeded();
+
+    // The delay to wait before sending requests again, after the last throttling (0 if none),
+    // to be honored by whoever schedules the next jobs
+    int recommendedDelay() const;
+    // Time spent waiting in acquire(), in milliseconds
+    qint64 totalWaitTime() const;
+
+private:
+    void wait(qint64 msecs);
+
+    Clock *mClock;
+    double mRate = 0;
+    int mBurstSize = 1;
+    double mTokens = 1;
+    qint64 mLastRefill = -1;
+    qint64 mBlockedUntil = 0;
+    int mInitialDelay = 1000;
+    int mMaxDelay = 60000;
+    int mMaxRetries = 5;
+    int mRecommendedDelay = 0;
+    qint64 mTotalWaitTime = 0;
+    std::mt19937 mRandom;
+
+    Q_DISABLE_COPY(RateLimiter)
+};
+
+#endif // RATELIMITER_H
@@ -76,7 +76,7 @@ int ResourceDebugInterface::getCount(const QString &module) const
 {
     SugarSession *session = mResource->mSession;
     KDSoapGenerated::Sugarsoap *soap = session->soap();
-    const QString sessionId = session->sessionId();
+    const QString sessionId = session->soapSessionId();
     if (sessionId.isEmpty()) {
         qCWarning(FATCRM_SUGARCRMRESOURCE_LOG) << "No session! Need to login first.";
     }
@@ -133,7 +133,7 @@ void ResourceDebugInterface::getEntry(const QString &module, const QString &id)
 {
     SugarSession *session = mResource->mSession;
     KDSoapGenerated::Sugarsoap *soap = session->soap();
-    const QString sessionId = session->sessionId();
+    const QString sessionId = session->soapSessionId();
     if (sessionId.isEmpty()) {
         qCWarning(FATCRM_SUGARCRMRESOURCE_LOG) << "No session! Need to login first.";
     }
@@ -151,3 +151,9 @@ void ResourceDebugInterface::getEntry(const QString &module, const QString &id)
     }
 }
 
+QString ResourceDebugInterface::trafficStatistics() const
+{
+    const SugarSession::TrafficStatistics statistics = mResource->mSession->trafficStatistics();
+    return QStringLiteral("%1 requests, %2 compressed replies, %3 bytes of request bodies, %4 bytes of decoded replies")
+            .arg(statistics.requests).arg(statistics.compressedReplies).arg(statistics.requestBodyBytes).arg(statistics.decodedReplyBytes);
+}
@@ -45,6 +45,8 @@ public Q_SLOTS:
     Q_SCRIPTABLE QStringList availableFields(const QString &module) const;
     Q_SCRIPTABLE int getCount(const QString &module) const;
     Q_SCRIPTABLE void getEntry(const QString &module, const QString &id) const;
+    // Requests, compressed replies and body sizes through the session's network access manager, see SugarSession::TrafficStatistics
+    Q_SCRIPTABLE QString trafficStatistics() const;
 
 private:
     SugarCRMResource *const mResource;
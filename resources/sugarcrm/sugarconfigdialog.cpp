@@ -26,6 +26,8 @@
 #include "passwordhandler.h"
 #include "settings.h"
 
+#include <KLocalizedString>
+
 SugarConfigDialog::SugarConfigDialog(PasswordHandler *passwordHandler, const QString &accountName, QWidget *parent)
     : QDialog(parent)
     , mUi(new Ui_SugarConfigDialog)
@@ -37,6 +39,16 @@ SugarConfigDialog::SugarConfigDialog(PasswordHandler *passwordHandler, const QSt
     mUi->user->setText(Settings::user());
     mUi->password->setText(passwordHandler->password());
 
+    // Item data is the value of the Protocol setting
+    mUi->protocol->addItem(i18nc("@item:inlistbox", "SOAP (v4.1)"), QStringLiteral("Soap"));
+    mUi->protocol->addItem(i18nc("@item:inlistbox", "REST (v10)"), QStringLiteral("Rest"));
+    int protocolIndex = mUi->protocol->findData(Settings::protocol());
+    if (protocolIndex < 0) { // e.g. the mock protocols used for testing
+        mUi->protocol->addItem(Settings::protocol(), Settings::protocol());
+        protocolIndex = mUi->protocol->count() - 1;
+    }
+    mUi->protocol->setCurrentIndex(protocolIndex);
+
     mUi->checkIntervalSpinbox->setValue(Settings::intervalCheckTime());
 }
 
@@ -65,6 +77,11 @@ QString SugarConfigDialog::password() const
     return mUi->password->text();
 }
 
+QString SugarConfigDialog::protocol() const
+{
+    return mUi->protocol->currentData().toString();
+}
+
 int SugarConfigDialog::intervalCheckTime() const
 {
     const int val = mUi->checkIntervalSpinbox->value();
@@ -40,6 +40,7 @@ public:
     QString host() const;
     QString user() const;
     QString password() const;
+    QString protocol() const;
     int intervalCheckTime() const;
 
 private:
@@ -27,13 +27,16 @@
 #include "campaignshandler.h"
 #include "conflicthandler.h"
 #include "contactshandler.h"
+#include "createentriesjob.h"
 #include "createentryjob.h"
+#include "deleteentriesjob.h"
 #include "deleteentryjob.h"
 #include "documentshandler.h"
 #include "emailshandler.h"
 #include "fetchentryjob.h"
 #include "itemtransferinterface.h"
 #include "kdcrmutils.h"
+#include "syncbaseattribute.h"
 #include "leadshandler.h"
 #include "listentriesjob.h"
 #include "listmodulesjob.h"
@@ -49,6 +52,8 @@
 #include "taskshandler.h"
 #include "updateentryjob.h"
 #include "passwordhandler.h"
+#include "ratelimitedprotocol.h"
+#include "sugarrestprotocol.h"
 #include "sugarsoapprotocol.h"
 #include "tests/sugarmockprotocol.h"
 
@@ -67,10 +72,33 @@
 #include <kwindowsystem_version.h>
 
 #include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <algorithm>
 #include <QtDBus/QDBusConnection>
 
 using namespace Akonadi;
 
+// "Soap" or "Rest", see the Protocol setting
+static SugarProtocolBase *createNetworkProtocol(const QString &name)
+{
+    SugarProtocolBase *protocol;
+    if (name == QLatin1String("Rest")) {
+        protocol = new SugarRestProtocol;
+    } else {
+        if (name != QLatin1String("Soap")) {
+            qWarning() << "protocol name incorrect:" << name << "is an invalid protocol name";
+        }
+        protocol = new SugarSoapProtocol;
+    }
+    auto *rateLimitedProtocol = new RateLimitedProtocol(protocol);
+    rateLimitedProtocol->rateLimiter().setRate(Settings::maxRequestsPerSecond(), Settings::requestBurstSize());
+    rateLimitedProtocol->rateLimiter().setBackoff(Settings::throttleInitialDelay(), Settings::throttleMaxDelay(), Settings::throttleRetries());
+    return rateLimitedProtocol;
+}
+
 SugarCRMResource::SugarCRMResource(const QString &id)
     : ResourceBase(id),
       mPasswordHandler(new PasswordHandler(id, this)),
@@ -80,6 +108,9 @@ SugarCRMResource::SugarCRMResource(const QString &id)
       mModuleHandlers(new ModuleHandlerHash),
       mModuleDebugInterfaces(new ModuleDebugInterfaceHash),
       mConflictHandler(new ConflictHandler(ConflictHandler::BackendConflict, this)),
+      mImportTotal(0),
+      mImportDone(0),
+      mImportScheduled(false),
       mOnline(false)
 {
     KDCRMUtils::setupIconTheme();
@@ -105,6 +136,8 @@ SugarCRMResource::SugarCRMResource(const QString &id)
 
     // make sure itemAdded() and itemChanged() get the full item from Akonadi before being called
     changeRecorder()->itemFetchScope().fetchFullPayload();
+    // the base version of local changes, for merging them on conflicts
+    changeRecorder()->itemFetchScope().fetchAttribute<SyncBaseAttribute>();
 
     // make sure these call have the collection available as well
     changeRecorder()->fetchCollection(true);
@@ -127,10 +160,7 @@ SugarCRMResource::SugarCRMResource(const QString &id)
         mSession->setSessionParameters(Settings::user(), QString() /*password not read yet*/,
                                        Settings::host());
         mSession->createSoapInterface();
-        protocol = new SugarSoapProtocol;
-        if (selectedProtocol != "Soap") {
-            qWarning() << "protocol name incorrect:" << selectedProtocol << "is an invalid protocol name";
-        }
+        protocol = createNetworkProtocol(selectedProtocol);
     }
 
     itemTransferInterface->setSession(mSession);
@@ -144,6 +174,11 @@ SugarCRMResource::SugarCRMResource(const QString &id)
             this, &SugarCRMResource::updateOnBackend);
 
     createModuleHandlers(Settings::availableModules());
+
+    // An import was interrupted, create the rest of its items
+    if (QFile::exists(importJournalPath())) {
+        scheduleCustomTask(this, "resumeImport", QVariant(), ResourceBase::AfterChangeReplay);
+    }
 }
 
 SugarCRMResource::~SugarCRMResource()
@@ -180,8 +215,19 @@ void SugarCRMResource::configure(WId windowId)
     const QString password = dialog.password();
     const QString accountName = dialog.accountName();
     const int intervalCheckTime = dialog.intervalCheckTime();
+    const QString protocol = dialog.protocol();
 
     SugarSession::RequiredAction action = mSession->setSessionParameters(user, password, host);
+    if (protocol != Settings::protocol()) {
+        // switchProtocol logs in with the new protocol, or going online will
+        action = SugarSession::None;
+        if (isOnline()) {
+            // prepended as well, so that it runs before anything else
+            scheduleCustomTask(this, "switchProtocol", protocol, ResourceBase::Prepend);
+        } else {
+            setNetworkProtocol(protocol);
+        }
+    }
     switch (action) {
     case SugarSession::None:
         break;
@@ -200,6 +246,7 @@ void SugarCRMResource::configure(WId windowId)
     Settings::setHost(host);
     Settings::setUser(user);
     Settings::setIntervalCheckTime(intervalCheckTime);
+    Settings::setProtocol(protocol);
     Settings::self()->save();
     mPasswordHandler->setPassword(password);
 
@@ -233,6 +280,9 @@ void SugarCRMResource::doSetOnline(bool online)
             } else {
                 // schedule login as a prepended custom task to hold all other until finished
                 scheduleCustomTask(this, "startExplicitLogin", QVariant(), ResourceBase::Prepend);
+                if (!mPendingImports.isEmpty()) {
+                    scheduleImport();
+                }
             }
         } else {
             // Abort current job, given that the resource scheduler aborted the current task
@@ -240,6 +290,8 @@ void SugarCRMResource::doSetOnline(bool online)
                 mCurrentJob->kill(KJob::Quietly);
                 mCurrentJob = nullptr;
             }
+            mPendingRemovals.clear();
+            mImportScheduled = false;
             if (mLoginJob) {
                 mLoginJob->kill(KJob::Quietly);
                 mLoginJob = nullptr;
@@ -258,7 +310,13 @@ void SugarCRMResource::itemAdded(const Akonadi::Item &item, const Akonadi::Colle
     // find the handler for the module represented by the given collection and let it
     // perform the respective "set entry" operation
     ModuleHandler *handler = mModuleHandlers->value(collection.remoteId());
-    if (handler) {
+    if (handler && item.hasFlag(KDCRMUtils::importFlag())) {
+        // Part of an import, created with the next batch
+        Item importedItem(item);
+        importedItem.setParentCollection(collection);
+        queueImport(importedItem);
+        changeProcessed();
+    } else if (handler) {
         emit status(Running);
 
         auto *job = new CreateEntryJob(item, mSession, this);
@@ -294,7 +352,10 @@ void SugarCRMResource::itemChanged(const Akonadi::Item &item, const QSet<QByteAr
                        << "indicates that backend change for item id=" << item.id()
                        << ", remoteId=" << item.remoteId()
                        << "is not required for given modified parts: " << parts;
-            changeCommitted(item);
+            // Nothing to send, so nothing to merge against later either
+            Item committedItem(item);
+            committedItem.removeAttribute<SyncBaseAttribute>();
+            changeCommitted(committedItem);
             return;
         }
         emit status(Running);
@@ -335,6 +396,188 @@ void SugarCRMResource::itemRemoved(const Akonadi::Item &item)
 #endif
 }
 
+void SugarCRMResource::itemsRemoved(const Akonadi::Item::List &items)
+{
+    // Deleting many items in the client (e.g. a multi-selection) arrives here as one notification.
+    // Delete them with one set_entries request per batch rather than one set_entry request per item.
+    Item::List uploadedItems;
+    uploadedItems.reserve(items.count());
+    for (const Item &item : items) {
+        // not uploaded yet?
+        if (!item.remoteId().isEmpty() && !item.parentCollection().remoteId().isEmpty()) {
+            uploadedItems.append(item);
+        }
+    }
+
+    if (uploadedItems.isEmpty()) {
+        changeProcessed();
+        return;
+    }
+    if (uploadedItems.count() == 1) {
+        itemRemoved(uploadedItems.first());
+        return;
+    }
+
+    emit status(Running);
+    mPendingRemovals = uploadedItems;
+    deleteNextModuleEntries();
+}
+
+void SugarCRMResource::deleteNextModuleEntries()
+{
+    // Consecutive items of the same folder go into the same job
+    const QString collectionRemoteId = mPendingRemovals.first().parentCollection().remoteId();
+    int count = 1;
+    while (count < mPendingRemovals.count() && mPendingRemovals.at(count).parentCollection().remoteId() == collectionRemoteId) {
+        ++count;
+    }
+    const Item::List items = mPendingRemovals.mid(0, count);
+    mPendingRemovals.erase(mPendingRemovals.begin(), mPendingRemovals.begin() + count);
+
+    qCDebug(FATCRM_SUGARCRMRESOURCE_LOG) << "Deleting" << items.count() << "entries from" << collectionRemoteId;
+    SugarJob *job = new DeleteEntriesJob(items, mSession, nameToModule(collectionRemoteId), this);
+    Q_ASSERT(!mCurrentJob);
+    mCurrentJob = job;
+    connect(job, &KJob::result, this, &SugarCRMResource::deleteEntriesResult);
+    job->start();
+}
+
+void SugarCRMResource::queueImport(const Akonadi::Item &item)
+{
+    mPendingImports.append(item);
+    ++mImportTotal;
+    // The item is acked right away, so it must be persisted before that
+    journalImports({item}, true);
+    scheduleImport();
+}
+
+void SugarCRMResource::scheduleImport()
+{
+    if (!mImportScheduled) {
+        mImportScheduled = true;
+        // after the change replay, so that all the items of the import are queued by then
+        scheduleCustomTask(this, "importPendingItems", QVariant(), ResourceBase::AfterChangeReplay);
+    }
+}
+
+QString SugarCRMResource::importJournalPath() const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QLatin1Char('/') + identifier() + QLatin1String("-pendingimports");
+}
+
+// Appends "+id" for the queued items, "-id" for the ones done with, so that
+// queueing an item doesn't rewrite the ids of the whole import
+void SugarCRMResource::journalImports(const Akonadi::Item::List &items, bool pending)
+{
+    if (pending && items.isEmpty()) {
+        return;
+    }
+    if (!pending && mPendingImports.isEmpty()) {
+        QFile::remove(importJournalPath());
+        return;
+    }
+    QDir().mkpath(QFileInfo(importJournalPath()).absolutePath());
+    QFile file(importJournalPath());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qCWarning(FATCRM_SUGARCRMRESOURCE_LOG) << "Cannot write" << file.fileName() << file.errorString();
+        return;
+    }
+    QByteArray lines;
+    for (const Item &item : items) {
+        lines += (pending ? '+' : '-') + QByteArray::number(item.id()) + '\n';
+    }
+    file.write(lines);
+}
+
+void SugarCRMResource::importPendingItems(const QVariant &)
+{
+    mImportScheduled = false;
+    if (mPendingImports.isEmpty()) {
+        taskDone();
+        return;
+    }
+
+    // One batch per task, so that other changes can go in between
+    const QString collectionRemoteId = mPendingImports.first().parentCollection().remoteId();
+    ModuleHandler *handler = mModuleHandlers->value(collectionRemoteId);
+    Item::List items;
+    for (const Item &item : qAsConst(mPendingImports)) {
+        if (item.parentCollection().remoteId() != collectionRemoteId || items.count() == 100) {
+            break;
+        }
+        items.append(item);
+    }
+    if (!handler) {
+        qCWarning(FATCRM_SUGARCRMRESOURCE_LOG) << "Cannot import" << items.count() << "items into folder" << collectionRemoteId;
+        mPendingImports.erase(mPendingImports.begin(), mPendingImports.begin() + items.count());
+        mImportDone += items.count();
+        journalImports(items, false);
+        taskDone();
+        if (!mPendingImports.isEmpty()) {
+            scheduleImport();
+        }
+        return;
+    }
+
+    emit status(Running, i18nc("@info:status", "Importing items into folder %1: %2 of %3 done",
+                               collectionRemoteId, mImportDone, mImportTotal));
+    auto *job = new CreateEntriesJob(items, mSession, this);
+    job->setModule(handler);
+    Q_ASSERT(!mCurrentJob);
+    mCurrentJob = job;
+    connect(job, &KJob::result, this, &SugarCRMResource::importEntriesResult);
+    job->start();
+}
+
+void SugarCRMResource::resumeImport(const QVariant &)
+{
+    QVector<Item::Id> queuedIds;
+    QSet<Item::Id> doneIds;
+    QFile file(importJournalPath());
+    if (file.open(QIODevice::ReadOnly)) {
+        while (!file.atEnd()) {
+            const QByteArray line = file.readLine().trimmed();
+            if (line.startsWith('+')) {
+                queuedIds.append(line.mid(1).toLongLong());
+            } else if (line.startsWith('-')) {
+                doneIds.insert(line.mid(1).toLongLong());
+            }
+        }
+        file.close();
+    }
+    Item::List items;
+    for (Item::Id id : qAsConst(queuedIds)) {
+        if (!doneIds.contains(id)) {
+            items.append(Item(id));
+        }
+    }
+    auto *fetchJob = new ItemFetchJob(items, this);
+    fetchJob->fetchScope().fetchFullPayload();
+    fetchJob->fetchScope().setCacheOnly(true);
+    fetchJob->fetchScope().setAncestorRetrieval(ItemFetchScope::Parent);
+    connect(fetchJob, &KJob::result, this, [this, fetchJob]() {
+        if (fetchJob->error()) {
+            // e.g. the items were deleted meanwhile
+            qCWarning(FATCRM_SUGARCRMRESOURCE_LOG) << "Could not resume the import:" << fetchJob->errorString();
+        }
+        const Item::List fetchedItems = fetchJob->items();
+        for (const Item &item : fetchedItems) {
+            if (item.remoteId().isEmpty() && item.hasFlag(KDCRMUtils::importFlag())) {
+                mPendingImports.append(item);
+                ++mImportTotal;
+            }
+        }
+        qCDebug(FATCRM_SUGARCRMRESOURCE_LOG) << "Resuming the import of" << mPendingImports.count() << "items";
+        // Compact the journal, dropping the done and the vanished items
+        QFile::remove(importJournalPath());
+        journalImports(mPendingImports, true);
+        taskDone();
+        if (!mPendingImports.isEmpty()) {
+            scheduleImport();
+        }
+    });
+}
+
 void SugarCRMResource::retrieveCollections()
 {
     emit status(Running, i18nc("@info:status", "Retrieving folders"));
@@ -422,6 +665,23 @@ void SugarCRMResource::startExplicitLogin()
     mLoginJob->start();
 }
 
+void SugarCRMResource::switchProtocol(const QVariant &protocolName)
+{
+    qCDebug(FATCRM_SUGARCRMRESOURCE_LOG) << protocolName;
+    // No job is running at this point, it's a task
+    mSession->protocol()->logout();
+    setNetworkProtocol(protocolName.toString());
+    startExplicitLogin();
+}
+
+void SugarCRMResource::setNetworkProtocol(const QString &protocolName)
+{
+    SugarProtocolBase *protocol = createNetworkProtocol(protocolName);
+    protocol->setSession(mSession);
+    mSession->setProtocol(protocol);
+    mSession->createSoapInterface();
+}
+
 void SugarCRMResource::explicitLoginResult(KJob *job)
 {
     Q_ASSERT(mLoginJob == job);
@@ -641,11 +901,14 @@ void SugarCRMResource::createEntryResult(KJob *job)
     auto *createJob = qobject_cast<CreateEntryJob *>(job);
     Q_ASSERT(createJob != nullptr);
 
-    changeCommitted(createJob->item());
+    Item item = createJob->item();
+    // modified before being created on the server, the change is there now
+    item.removeAttribute<SyncBaseAttribute>();
+    changeCommitted(item);
     emit status(Idle);
 
     // commit does not update payload, so we modify as well
-    ItemModifyJob *modifyJob = new ItemModifyJob(createJob->item(), this);
+    ItemModifyJob *modifyJob = new ItemModifyJob(item, this);
     // this job will fail if the user has other changes pending
     // (e.g. because he created+modified the item while the resource was offline)
     // For that reason we also do this in updateEntryResult.
@@ -664,6 +927,85 @@ void SugarCRMResource::deleteEntryResult(KJob *job)
     emit status(Idle);
 }
 
+void SugarCRMResource::deleteEntriesResult(KJob *job)
+{
+    Q_ASSERT(mCurrentJob == job);
+    mCurrentJob = nullptr;
+    auto *deleteJob = static_cast<DeleteEntriesJob *>(job);
+    const Item::List failedItems = deleteJob->failedItems();
+    if (job->error() == SugarJob::SoapError && !failedItems.isEmpty()) {
+        // The other entries are deleted, trying again wouldn't help these ones (e.g. already deleted on the server)
+        for (const Item &item : failedItems) {
+            qCWarning(FATCRM_SUGARCRMRESOURCE_LOG) << "Could not delete" << item.remoteId() << ":" << deleteJob->errorMessage(item);
+        }
+        emit warning(job->errorText());
+    } else if (handleError(job, DeferTaskOnError)) {
+        mPendingRemovals.clear();
+        return;
+    }
+
+    if (!mPendingRemovals.isEmpty()) {
+        deleteNextModuleEntries();
+        return;
+    }
+
+    changeProcessed();
+    emit status(Idle);
+}
+
+void SugarCRMResource::importEntriesResult(KJob *job)
+{
+    Q_ASSERT(mCurrentJob == job);
+    mCurrentJob = nullptr;
+    auto *createJob = static_cast<CreateEntriesJob *>(job);
+
+    // Even if a later part failed, store what was created so that it isn't created again
+    QHash<Item::Id, Item> importedItems;
+    const Item::List items = createJob->items();
+    for (const Item &item : items) {
+        importedItems.insert(item.id(), item);
+    }
+    const Item::List createdItems = createJob->createdItems();
+    const Item::List failedItems = createJob->failedItems();
+    for (const Item &createdItem : createdItems) {
+        Item item(createdItem);
+        item.setFlags(importedItems.value(item.id()).flags());
+        item.clearFlag(KDCRMUtils::importFlag());
+        ItemModifyJob *modifyJob = new ItemModifyJob(item, this);
+        modifyJob->disableRevisionCheck();
+    }
+    QSet<Item::Id> doneIds;
+    for (const Item &item : createdItems + failedItems) {
+        doneIds.insert(item.id());
+    }
+    mPendingImports.erase(std::remove_if(mPendingImports.begin(), mPendingImports.end(), [&doneIds](const Item &item) {
+        return doneIds.contains(item.id());
+    }), mPendingImports.end());
+    mImportDone += doneIds.count();
+    journalImports(createdItems + failedItems, false);
+
+    if (job->error() == SugarJob::SoapError && !failedItems.isEmpty()) {
+        // Trying again wouldn't help, the server refused these ones
+        for (const Item &item : failedItems) {
+            qCWarning(FATCRM_SUGARCRMRESOURCE_LOG) << "Could not import item" << item.id();
+        }
+        emit warning(job->errorText());
+    } else if (handleError(job, DeferTaskOnError)) {
+        return;
+    }
+
+    if (mPendingImports.isEmpty()) {
+        qCDebug(FATCRM_SUGARCRMRESOURCE_LOG) << "Import done," << mImportDone << "items";
+        mImportTotal = 0;
+        mImportDone = 0;
+        emit status(Idle);
+    } else {
+        emit percent(mImportTotal > 0 ? 100 * mImportDone / mImportTotal : 0);
+        scheduleImport();
+    }
+    taskDone();
+}
+
 void SugarCRMResource::fetchEntryResult(KJob *job)
 {
     auto *fetchJob = qobject_cast<FetchEntryJob *>(job);
@@ -699,6 +1041,7 @@ void SugarCRMResource::updateEntryResult(KJob *job)
 
         mConflictHandler->setConflictingItems(localItem, remoteItem);
         mConflictHandler->setDifferencesInterface(updateJob->module());
+        mConflictHandler->setModuleHandler(updateJob->module());
         mConflictHandler->setParentWindowId(winIdForDialogs());
         mConflictHandler->setParentName(name());
         mConflictHandler->start();
@@ -709,11 +1052,14 @@ void SugarCRMResource::updateEntryResult(KJob *job)
         return;
     }
 
-    changeCommitted(updateJob->item()); // this clears the dirty flag of the item in the DB
+    Item item = updateJob->item();
+    // the local change is on the server now, the next one will be based on this version
+    item.removeAttribute<SyncBaseAttribute>();
+    changeCommitted(item); // this clears the dirty flag of the item in the DB
     emit status(Idle);
 
     // Save the date_modified change (see also the comment in createEntryResult)
-    ItemModifyJob *modifyJob = new ItemModifyJob(updateJob->item(), this);
+    ItemModifyJob *modifyJob = new ItemModifyJob(item, this);
     modifyJob->disableRevisionCheck();
 }
 
@@ -844,6 +1190,16 @@ bool SugarCRMResource::handleError(KJob *job, ActionOnError action)
         if (action == DeferTaskOnError)
             setTemporaryOffline(300); // this calls doSetOnline(false)
         break;
+    case SugarJob::ThrottledError: // the server still wants us to slow down after a few retries
+    case SugarJob::ServiceUnavailableError: {
+        // Come back when the server said, or after the last backoff delay
+        const int delay = mSession->protocol()->retryAfter();
+        emit status(Idle, i18n("Server is busy."));
+        deferOrCancel(job->errorText());
+        if (action == DeferTaskOnError)
+            setTemporaryOffline(qMax(1, (delay + 999) / 1000)); // this calls doSetOnline(false)
+        break;
+    }
     case SugarJob::SoapError: // this could be transient too, e.g. capturing portal. Or it could be real...
         if (job->errorString() == QLatin1String("You do not have access")) { // that's when the object we're modifying has been deleted on the server meanwhile. Real error, let's move on.
             // No point in trying this one again, it has to be cancelled.
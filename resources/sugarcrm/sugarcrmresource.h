@@ -47,7 +47,7 @@ struct HandleDeletedItemsArg
 };
 
 
-class SugarCRMResource : public Akonadi::ResourceBase, public Akonadi::AgentBase::ObserverV2
+class SugarCRMResource : public Akonadi::ResourceBase, public Akonadi::AgentBase::ObserverV3
 {
     friend class ItemTransferInterface;
     friend class ModuleDebugInterface;
@@ -76,6 +76,11 @@ private:
     ModuleDebugInterfaceHash *mModuleDebugInterfaces;
 
     ConflictHandler *mConflictHandler;
+    Akonadi::Item::List mPendingRemovals; // removed items not deleted on the server yet, see itemsRemoved()
+    Akonadi::Item::List mPendingImports; // imported items not created on the server yet, see importPendingItems()
+    int mImportTotal;
+    int mImportDone;
+    bool mImportScheduled;
     int mTotalItems;
     bool mOnline;
 
@@ -86,6 +91,7 @@ private:
     void itemAdded(const Akonadi::Item &item, const Akonadi::Collection &collection) override;
     void itemChanged(const Akonadi::Item &item, const QSet<QByteArray> &parts) override;
     void itemRemoved(const Akonadi::Item &item) override;
+    void itemsRemoved(const Akonadi::Item::List &items) override;
 
 private Q_SLOTS:
     void retrieveCollections() override;
@@ -93,6 +99,7 @@ private Q_SLOTS:
     bool retrieveItem(const Akonadi::Item &item, const QSet<QByteArray> &parts) override;
 
     void startExplicitLogin();
+    void switchProtocol(const QVariant &protocolName);
     void explicitLoginResult(KJob *job);
 
     void listModulesResult(KJob *job);
@@ -109,6 +116,12 @@ private Q_SLOTS:
 
     void deleteEntryResult(KJob *job);
 
+    void deleteEntriesResult(KJob *job);
+
+    void importPendingItems(const QVariant &);
+    void resumeImport(const QVariant &);
+    void importEntriesResult(KJob *job);
+
     void fetchEntryResult(KJob *job);
 
     void updateEntryResult(KJob *job);
@@ -120,6 +133,12 @@ private Q_SLOTS:
 private:
     void updateItem(const Akonadi::Item &item, ModuleHandler *handler);
     void createModuleHandlers(const QStringList &availableModules);
+    void setNetworkProtocol(const QString &protocolName);
+    void deleteNextModuleEntries();
+    void queueImport(const Akonadi::Item &item);
+    void scheduleImport();
+    QString importJournalPath() const;
+    void journalImports(const Akonadi::Item::List &items, bool pending);
     bool hasInvalidSessionError(KJob *job);
 
     // very similar to imapresource's ActionIfNoSession
@@ -179,12 +179,17 @@ bool SugarJob::doKill()
 
 bool SugarJob::handleConnectError(int error, const QString &errorMessage)
 {
-    Q_UNUSED(errorMessage);
     if (error == SugarJob::CouldNotConnectError) {
         if (d->mTryRelogin) {
             QMetaObject::invokeMethod(this, "startLogin", Qt::QueuedConnection);
             return true;
         }
+    } else if (error == SugarJob::ThrottledError || error == SugarJob::ServiceUnavailableError) {
+        // Already retried by RateLimitedProtocol (if it was safe), let the resource try again later
+        setError(error);
+        setErrorText(errorMessage);
+        emitResult();
+        return true;
     }
     return false;
 }
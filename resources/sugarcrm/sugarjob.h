@@ -43,7 +43,9 @@ public:
         CouldNotConnectError,
         SoapError,
         InvalidContextError,
-        TaskError
+        ThrottledError, // HTTP 429, the server rejected the request to slow us down, see RateLimitedProtocol
+        TaskError,
+        ServiceUnavailableError // HTTP 503, the server (or a proxy) may or may not have handled the request
     };
 
     explicit SugarJob(SugarSession *session, QObject *parent = nullptr);
@@ -59,6 +61,7 @@ protected:
     bool doKill() override;
     virtual void startSugarTask() = 0;
 
+    // Handles errors common to all jobs (logging in again, throttling), returns true if it did
     bool handleConnectError(int error, const QString &errorMessage);
 
     SugarSession *session() const;
@@ -19,7 +19,52 @@
 */
 
 #include "sugarprotocolbase.h"
+#include "sugarjob.h"
 
 SugarProtocolBase::~SugarProtocolBase()
 {
 }
+
+int SugarProtocolBase::retryAfter() const
+{
+    return -1;
+}
+
+bool SugarProtocolBase::hasSoapSession() const
+{
+    return true;
+}
+
+int SugarProtocolBase::setEntries(Module moduleName, const QList<KDSoapGenerated::TNS__Name_value_list> &nameValueLists, QStringList &ids, QString &errorMessage)
+{
+    ids.clear();
+    ids.reserve(nameValueLists.size());
+    for (const KDSoapGenerated::TNS__Name_value_list &nameValueList : nameValueLists) {
+        QString id;
+        const int result = setEntry(moduleName, nameValueList, id, errorMessage);
+        if (result == SugarJob::SoapError) {
+            // Only this entry failed, go on with the others
+            id.clear();
+        } else if (result != KJob::NoError) {
+            return result;
+        }
+        ids.append(id);
+    }
+    return KJob::NoError;
+}
+
+int SugarProtocolBase::getEntries(Module moduleName, const QStringList &remoteIds, const QStringList &selectedFields,
+                                  QList<KDSoapGenerated::TNS__Entry_value> &entryValues, QString &errorMessage)
+{
+    entryValues.clear();
+    for (const QString &remoteId : remoteIds) {
+        KDSoapGenerated::TNS__Entry_value entryValue;
+        const int result = getEntry(moduleName, remoteId, selectedFields, entryValue, errorMessage);
+        if (result == KJob::NoError) {
+            entryValues.append(entryValue);
+        } else if (result != SugarJob::SoapError) {
+            return result;
+        }
+    }
+    return KJob::NoError;
+}
@@ -52,6 +52,9 @@ public:
                             const QString &orderBy, const QStringList &selectedFields, EntriesListResult &entriesListResult,
                             QString &errorMessage) = 0;
     virtual int setEntry(Module module_name, const KDSoapGenerated::TNS__Name_value_list& name_value_list, QString &id, QString &errorMessage) = 0;
+    // Saves several entries of the same module at once. ids gets one id per name_value_list, in the same order,
+    // empty for the entries the server couldn't save. The default implementation calls setEntry for each list.
+    virtual int setEntries(Module moduleName, const QList<KDSoapGenerated::TNS__Name_value_list> &nameValueLists, QStringList &ids, QString &errorMessage);
     struct GetRelationShipsResult {
         int errorCode;
         QString errorMessage;
@@ -63,7 +66,17 @@ public:
                                 const QStringList &targetItemIds, Module targetModule, bool shouldDelete, QString &errorMessage) const = 0;
     virtual int getEntry(Module moduleName, const QString &remoteId, const QStringList &selectedFields,
                          KDSoapGenerated::TNS__Entry_value &entryValue, QString &errorMessage) = 0;
+    // Reads several entries of the same module at once. entryValues gets the entries found, the ids
+    // the server doesn't know are skipped. The default implementation calls getEntry for each id.
+    virtual int getEntries(Module moduleName, const QStringList &remoteIds, const QStringList &selectedFields,
+                           QList<KDSoapGenerated::TNS__Entry_value> &entryValues, QString &errorMessage);
     virtual int listModules(QStringList &moduleNames, QString &errorMessage) = 0;
+    // After a call returned SugarJob::ThrottledError or ServiceUnavailableError: how long the server asked us to wait
+    // before sending more requests, in milliseconds. -1 if it didn't say.
+    virtual int retryAfter() const;
+    // Whether the session id returned by login() is also a session of the SOAP API,
+    // for the few features calling SugarSession::soap() directly. True by default.
+    virtual bool hasSoapSession() const;
 };
 
 
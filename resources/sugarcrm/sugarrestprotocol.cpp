@@ -0,0 +1,739 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "sugarrestprotocol.h"
+#include "sugarcrmresource_debug.h"
+#include "sugarjob.h"
+#include "sugarsession.h"
+#include "listentriesscope.h"
+#include "kdcrmdata/kdcrmtrace.h"
+#include "kdcrmdata/kdcrmutils.h"
+
+#include <KLocalizedString>
+
+#include <QDateTime>
+#include <QEventLoop>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTimer>
+#include <QUrl>
+#include <QUrlQuery>
+
+// SugarCRM's own web client uses "base", a dedicated platform would have to be registered on the server
+static const char s_platform[] = "base";
+static const int s_maxResults = 100; // same page size as SugarSoapProtocol
+
+namespace {
+
+// Parses the "where" clauses of SOAP queries, e.g.
+//   ( notes.parent_type='Accounts' or notes.parent_type='Contacts' ) AND notes.date_modified >= '2021-03-01 10:00:00'
+// into REST filter expressions, e.g.
+//   {"$and": [{"$or": [{"parent_type": {"$equals": "Accounts"}}, ...]}, {"date_modified": {"$gte": "2021-03-01T10:00:00+00:00"}}]}
+class QueryParser
+{
+public:
+    explicit QueryParser(const QString &query)
+        : mQuery(query)
+    {
+    }
+
+    bool parse(QJsonObject &expression)
+    {
+        if (!parseOr(expression)) {
+            return false;
+        }
+        skipSpaces();
+        if (mPos < mQuery.size()) {
+            return fail(QStringLiteral("unexpected \"%1\"").arg(mQuery.mid(mPos)));
+        }
+        return true;
+    }
+
+    QString error() const { return mError; }
+
+private:
+    bool fail(const QString &error)
+    {
+        if (mError.isEmpty()) {
+            mError = error;
+        }
+        return false;
+    }
+
+    void skipSpaces()
+    {
+        while (mPos < mQuery.size() && mQuery.at(mPos).isSpace()) {
+            ++mPos;
+        }
+    }
+
+    static bool isIdentifierChar(QChar c)
+    {
+        return c.isLetterOrNumber() || c == QLatin1Char('_') || c == QLatin1Char('.');
+    }
+
+    bool accept(QChar c)
+    {
+        skipSpaces();
+        if (mPos < mQuery.size() && mQuery.at(mPos) == c) {
+            ++mPos;
+            return true;
+        }
+        return false;
+    }
+
+    bool acceptKeyword(QLatin1String keyword)
+    {
+        skipSpaces();
+        const int end = mPos + keyword.size();
+        if (mQuery.midRef(mPos, keyword.size()).compare(keyword, Qt::CaseInsensitive) != 0
+                || (end < mQuery.size() && isIdentifierChar(mQuery.at(end)))) {
+            return false;
+        }
+        mPos = end;
+        return true;
+    }
+
+    bool parseOr(QJsonObject &expression)
+    {
+        return parseList(QLatin1String("or"), QStringLiteral("$or"), &QueryParser::parseAnd, expression);
+    }
+
+    bool parseAnd(QJsonObject &expression)
+    {
+        return parseList(QLatin1String("and"), QStringLiteral("$and"), &QueryParser::parseTerm, expression);
+    }
+
+    bool parseList(QLatin1String keyword, const QString &restOperator, bool (QueryParser::*parseOperand)(QJsonObject &), QJsonObject &expression)
+    {
+        QJsonArray operands;
+        do {
+            QJsonObject operand;
+            if (!(this->*parseOperand)(operand)) {
+                return false;
+            }
+            operands.append(operand);
+        } while (acceptKeyword(keyword));
+        expression = operands.count() == 1 ? operands.first().toObject() : QJsonObject{{restOperator, operands}};
+        return true;
+    }
+
+    bool parseTerm(QJsonObject &expression)
+    {
+        if (accept(QLatin1Char('('))) {
+            return parseOr(expression) && (accept(QLatin1Char(')')) || fail(QStringLiteral("missing ')'")));
+        }
+        skipSpaces();
+        const int start = mPos;
+        while (mPos < mQuery.size() && isIdentifierChar(mQuery.at(mPos))) {
+            ++mPos;
+        }
+        if (mPos == start) {
+            return fail(QStringLiteral("expected a field name at \"%1\"").arg(mQuery.mid(start)));
+        }
+        // "accounts.date_modified" -> "date_modified"
+        const QString qualifiedName = mQuery.mid(start, mPos - start);
+        const QString field = qualifiedName.mid(qualifiedName.lastIndexOf(QLatin1Char('.')) + 1);
+
+        QString restOperator;
+        if (!parseOperator(restOperator)) {
+            return fail(QStringLiteral("expected a comparison after %1").arg(qualifiedName));
+        }
+        QString value;
+        if (!parseValue(value)) {
+            return fail(QStringLiteral("expected a value after %1").arg(qualifiedName));
+        }
+        expression = QJsonObject{{field, QJsonObject{{restOperator, toRestValue(value)}}}};
+        return true;
+    }
+
+    bool parseOperator(QString &restOperator)
+    {
+        static const struct {
+            const char *sql;
+            const char *rest;
+        } s_operators[] = { // longest first
+            {">=", "$gte"}, {"<=", "$lte"}, {"!=", "$not_equals"}, {"<>", "$not_equals"},
+            {"=", "$equals"}, {">", "$gt"}, {"<", "$lt"}
+        };
+        skipSpaces();
+        for (const auto &op : s_operators) {
+            const QLatin1String sql(op.sql);
+            if (mQuery.midRef(mPos, sql.size()) == sql) {
+                mPos += sql.size();
+                restOperator = QLatin1String(op.rest);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool parseValue(QString &value)
+    {
+        skipSpaces();
+        if (accept(QLatin1Char('\''))) {
+            // '' is an escaped quote
+            while (mPos < mQuery.size()) {
+                const QChar c = mQuery.at(mPos++);
+                if (c != QLatin1Char('\'')) {
+                    value += c;
+                } else if (mPos < mQuery.size() && mQuery.at(mPos) == QLatin1Char('\'')) {
+                    value += c;
+                    ++mPos;
+                } else {
+                    return true;
+                }
+            }
+            return fail(QStringLiteral("unterminated string"));
+        }
+        const int start = mPos;
+        while (mPos < mQuery.size() && (mQuery.at(mPos).isDigit() || mQuery.at(mPos) == QLatin1Char('.') || mQuery.at(mPos) == QLatin1Char('-'))) {
+            ++mPos;
+        }
+        value = mQuery.mid(start, mPos - start);
+        return !value.isEmpty();
+    }
+
+    // "yyyy-MM-dd hh:mm:ss", as in SOAP and kdcrmdata, is UTC
+    static QString toRestValue(const QString &value)
+    {
+        if (value.size() == 19 && value.at(4) == QLatin1Char('-') && value.at(10) == QLatin1Char(' ') && value.at(13) == QLatin1Char(':')) {
+            return value.left(10) + QLatin1Char('T') + value.mid(11) + QLatin1String("+00:00");
+        }
+        return value;
+    }
+
+    const QString mQuery;
+    int mPos = 0;
+    QString mError;
+};
+
+}
+
+// ISO 8601 datetimes -> "yyyy-MM-dd hh:mm:ss" UTC, booleans -> "0"/"1".
+// Returns false for values which have no SOAP equivalent (objects and arrays, e.g. _acl or email).
+static bool valueFromJson(const QJsonValue &value, QString &result)
+{
+    switch (value.type()) {
+    case QJsonValue::String: {
+        const QString str = value.toString();
+        if (str.size() >= 20 && str.at(10) == QLatin1Char('T') && str.at(4) == QLatin1Char('-') && str.at(13) == QLatin1Char(':')) {
+            if (str.endsWith(QLatin1String("+00:00")) || str.endsWith(QLatin1Char('Z'))) {
+                result = str.left(10) + QLatin1Char(' ') + str.mid(11, 8);
+                return true;
+            }
+            const QDateTime dateTime = QDateTime::fromString(str, Qt::ISODate);
+            if (dateTime.isValid()) {
+                result = KDCRMUtils::dateTimeToString(dateTime.toUTC());
+                return true;
+            }
+        }
+        result = str;
+        return true;
+    }
+    case QJsonValue::Bool:
+        result = value.toBool() ? QStringLiteral("1") : QStringLiteral("0");
+        return true;
+    case QJsonValue::Double: {
+        const double number = value.toDouble();
+        result = number == qint64(number) ? QString::number(qint64(number)) : QString::number(number, 'g', 15);
+        return true;
+    }
+    case QJsonValue::Null:
+        result.clear();
+        return true;
+    default:
+        return false;
+    }
+}
+
+SugarRestProtocol::SugarRestProtocol()
+{
+}
+
+SugarRestProtocol::~SugarRestProtocol()
+{
+}
+
+bool SugarRestProtocol::queryToFilter(const QString &query, QJsonArray &filter, QString &errorMessage)
+{
+    filter = QJsonArray();
+    if (query.trimmed().isEmpty()) {
+        return true;
+    }
+    QueryParser parser(query);
+    QJsonObject expression;
+    if (!parser.parse(expression)) {
+        errorMessage = i18nc("@info:status", "Cannot translate the query \"%1\" into a REST filter: %2", query, parser.error());
+        return false;
+    }
+    // The filter is an implicit $and of its elements
+    const QJsonValue andOperands = expression.value(QStringLiteral("$and"));
+    if (expression.count() == 1 && andOperands.isArray()) {
+        filter = andOperands.toArray();
+    } else {
+        filter.append(expression);
+    }
+    return true;
+}
+
+QString SugarRestProtocol::orderByToRest(const QString &orderBy)
+{
+    QString field = orderBy.trimmed();
+    QString direction = QStringLiteral("asc");
+    const int space = field.indexOf(QLatin1Char(' '));
+    if (space > 0) {
+        direction = field.mid(space + 1).trimmed().toLower();
+        field.truncate(space);
+    }
+    if (field.isEmpty()) {
+        return QString();
+    }
+    return field.mid(field.lastIndexOf(QLatin1Char('.')) + 1) + QLatin1Char(':') + direction;
+}
+
+KDSoapGenerated::TNS__Entry_value SugarRestProtocol::recordToEntry(const QJsonObject &record, const QString &moduleName, const QStringList &selectedFields)
+{
+    QList<KDSoapGenerated::TNS__Name_value> items;
+    auto append = [&items](const QString &name, const QJsonValue &jsonValue) {
+        QString value;
+        if (valueFromJson(jsonValue, value)) {
+            KDSoapGenerated::TNS__Name_value nameValue;
+            nameValue.setName(name);
+            nameValue.setValue(value);
+            items.append(nameValue);
+        }
+    };
+    if (selectedFields.isEmpty()) {
+        items.reserve(record.size());
+        for (auto it = record.constBegin(); it != record.constEnd(); ++it) {
+            if (!it.key().startsWith(QLatin1Char('_'))) { // _acl, _module, _hash...
+                append(it.key(), it.value());
+            }
+        }
+    } else {
+        items.reserve(selectedFields.size());
+        for (const QString &field : selectedFields) {
+            const auto it = record.constFind(field);
+            if (it != record.constEnd()) {
+                append(field, it.value());
+            }
+        }
+    }
+    KDSoapGenerated::TNS__Name_value_list nameValueList;
+    nameValueList.setItems(items);
+
+    KDSoapGenerated::TNS__Entry_value entry;
+    entry.setId(record.value(QStringLiteral("id")).toString());
+    entry.setModule_name(record.value(QStringLiteral("_module")).toString(moduleName));
+    entry.setName_value_list(nameValueList);
+    return entry;
+}
+
+int SugarRestProtocol::sendRequest(Verb verb, const QString &path, const QUrlQuery &query, const QJsonObject &body,
+                                   QJsonObject &reply, QString &errorMessage, int *httpStatus) const
+{
+    // Only the reply to this request decides the delay, also when it times out
+    mRetryAfter = -1;
+    QNetworkAccessManager *networkAccessManager = mSession->networkAccessManager();
+    // Like SugarSession::createSoapInterface, ignore the path of the configured URL
+    QUrl url(mSession->host());
+    url.setPath(QLatin1String("/rest/v10/") + path);
+    url.setQuery(query);
+
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, QStringLiteral("application/json"));
+    if (!mSession->sessionId().isEmpty()) {
+        request.setRawHeader("OAuth-Token", mSession->sessionId().toUtf8());
+    }
+
+    const QByteArray data = body.isEmpty() ? QByteArray() : QJsonDocument(body).toJson(QJsonDocument::Compact);
+    QScopedPointer<QNetworkReply> networkReply;
+    switch (verb) {
+    case Get:
+        networkReply.reset(networkAccessManager->get(request));
+        break;
+    case Post:
+        networkReply.reset(networkAccessManager->post(request, data));
+        break;
+    case Put:
+        networkReply.reset(networkAccessManager->put(request, data));
+        break;
+    case Delete:
+        networkReply.reset(networkAccessManager->deleteResource(request));
+        break;
+    }
+
+    QEventLoop eventLoop;
+    QObject::connect(networkReply.data(), &QNetworkReply::finished, &eventLoop, &QEventLoop::quit);
+    bool timedOut = false;
+    QTimer timer;
+    timer.setSingleShot(true);
+    QObject::connect(&timer, &QTimer::timeout, &eventLoop, [&]() {
+        timedOut = true;
+        networkReply->abort(); // emits finished
+    });
+    if (networkReply->isRunning()) {
+        timer.start(mTimeout);
+        eventLoop.exec();
+    }
+    if (timedOut) {
+        errorMessage = i18nc("@info:status", "No reply from the server for %1 after %2 seconds", path, mTimeout / 1000);
+        qCDebug(FATCRM_SUGARCRMRESOURCE_LOG) << path << "timed out";
+        return SugarJob::CouldNotConnectError;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(networkReply->readAll(), &parseError);
+    if (networkReply->error() != QNetworkReply::NoError) {
+        const int status = networkReply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (httpStatus) {
+            *httpStatus = status;
+        }
+        errorMessage = document.object().value(QStringLiteral("error_message")).toString();
+        if (errorMessage.isEmpty()) {
+            errorMessage = networkReply->errorString();
+        }
+        qCDebug(FATCRM_SUGARCRMRESOURCE_LOG) << path << "returned error" << status << errorMessage;
+        // No HTTP reply at all, or an expired token: log in again, like for SOAP's "Invalid Login" fault
+        if (status == 0 || status == 401) {
+            return SugarJob::CouldNotConnectError;
+        }
+        if (status == 429 || status == 503) {
+            // Only the delay-seconds form of Retry-After, SugarCRM doesn't send dates
+            bool ok = false;
+            const int seconds = networkReply->rawHeader("Retry-After").trimmed().toInt(&ok);
+            if (ok && seconds >= 0) {
+                mRetryAfter = seconds * 1000;
+            }
+            return status == 429 ? int(SugarJob::ThrottledError) : int(SugarJob::ServiceUnavailableError);
+        }
+        return SugarJob::SoapError;
+    }
+    if (!document.isObject()) {
+        errorMessage = i18nc("@info:status", "Invalid reply from the server for %1: %2", path, parseError.errorString());
+        return SugarJob::SoapError;
+    }
+    reply = document.object();
+    return KJob::NoError;
+}
+
+int SugarRestProtocol::retryAfter() const
+{
+    return mRetryAfter;
+}
+
+int SugarRestProtocol::login(const QString &user, const QString &password, QString &sessionId, QString &errorMessage)
+{
+    FATCRM_TRACE_SCOPE("rest", "SugarRestProtocol::login");
+    const QJsonObject body = {
+        {QStringLiteral("grant_type"), QStringLiteral("password")},
+        {QStringLiteral("client_id"), QStringLiteral("sugar")},
+        {QStringLiteral("client_secret"), QString()},
+        {QStringLiteral("username"), user},
+        {QStringLiteral("password"), password},
+        {QStringLiteral("platform"), QLatin1String(s_platform)}
+    };
+    QJsonObject reply;
+    QString error;
+    int httpStatus = 0;
+    const int result = sendRequest(Post, QStringLiteral("oauth2/token"), QUrlQuery(), body, reply, error, &httpStatus);
+    if (result != KJob::NoError) {
+        errorMessage = i18nc("@info:status", "Login for user %1 on %2 failed: %3", user, mSession->host(), error);
+        if (result == SugarJob::ThrottledError || result == SugarJob::ServiceUnavailableError) {
+            return result;
+        }
+        // 401 or 400 here means wrong credentials, not an expired token
+        return httpStatus == 0 ? int(SugarJob::CouldNotConnectError) : int(SugarJob::LoginError);
+    }
+    sessionId = reply.value(QStringLiteral("access_token")).toString();
+    return KJob::NoError;
+}
+
+void SugarRestProtocol::logout()
+{
+    FATCRM_TRACE_SCOPE("rest", "SugarRestProtocol::logout");
+    if (!mSession->sessionId().isEmpty()) {
+        QJsonObject reply;
+        QString errorMessage;
+        if (sendRequest(Post, QStringLiteral("oauth2/logout"), QUrlQuery(), QJsonObject(), reply, errorMessage) != KJob::NoError) {
+            qCDebug(FATCRM_SUGARCRMRESOURCE_LOG) << "logout had error" << errorMessage;
+        }
+    }
+    mSession->forgetSession();
+}
+
+int SugarRestProtocol::getEntriesCount(const ListEntriesScope &scope, Module moduleName, const QString &query,
+                                       int &entriesCount, QString &errorMessage)
+{
+    FATCRM_TRACE_SCOPE("rest", "SugarRestProtocol::getEntriesCount");
+    FATCRM_TRACE_SET_DETAIL(moduleToName(moduleName));
+    QJsonArray filter;
+    if (!queryToFilter(query, filter, errorMessage)) {
+        return SugarJob::SoapError;
+    }
+    QJsonObject body;
+    if (!filter.isEmpty()) {
+        body.insert(QStringLiteral("filter"), filter);
+    }
+    if (scope.includeDeleted()) {
+        body.insert(QStringLiteral("deleted"), true);
+    }
+    QJsonObject reply;
+    const int result = sendRequest(Post, moduleToName(moduleName) + QLatin1String("/filter/count"), QUrlQuery(), body, reply, errorMessage);
+    entriesCount = reply.value(QStringLiteral("record_count")).toInt();
+    return result;
+}
+
+int SugarRestProtocol::getModuleFields(const QString &moduleName, KDSoapGenerated::TNS__Field_list &fields, QString &errorMessage)
+{
+    FATCRM_TRACE_SCOPE("rest", "SugarRestProtocol::getModuleFields");
+    FATCRM_TRACE_SET_DETAIL(moduleName);
+    // The options of enum fields are the name of a dropdown list, so get these lists too
+    QUrlQuery query;
+    query.addQueryItem(QStringLiteral("type_filter"), QStringLiteral("modules,app_list_strings"));
+    query.addQueryItem(QStringLiteral("module_filter"), moduleName);
+    QJsonObject reply;
+    const int result = sendRequest(Get, QStringLiteral("metadata"), query, QJsonObject(), reply, errorMessage);
+    if (result != KJob::NoError) {
+        return result;
+    }
+
+    const QJsonObject moduleFields = reply.value(QStringLiteral("modules")).toObject().value(moduleName).toObject().value(QStringLiteral("fields")).toObject();
+    const QJsonObject dropdownLists = reply.value(QStringLiteral("app_list_strings")).toObject();
+    QList<KDSoapGenerated::TNS__Field> items;
+    items.reserve(moduleFields.size());
+    for (auto it = moduleFields.constBegin(); it != moduleFields.constEnd(); ++it) {
+        if (!it.value().isObject()) { // _hash
+            continue;
+        }
+        const QJsonObject definition = it.value().toObject();
+        KDSoapGenerated::TNS__Field field;
+        field.setName(definition.value(QStringLiteral("name")).toString(it.key()));
+        field.setType(definition.value(QStringLiteral("type")).toString());
+        field.setGroup(definition.value(QStringLiteral("group")).toString());
+        field.setLabel(definition.value(QStringLiteral("vname")).toString());
+        field.setRequired(definition.value(QStringLiteral("required")).toBool() ? 1 : 0);
+        QString defaultValue;
+        valueFromJson(definition.value(QStringLiteral("default")), defaultValue);
+        field.setDefault_value(defaultValue);
+
+        const QJsonObject options = dropdownLists.value(definition.value(QStringLiteral("options")).toString()).toObject();
+        if (!options.isEmpty()) {
+            QList<KDSoapGenerated::TNS__Name_value> optionItems;
+            optionItems.reserve(options.size());
+            for (auto option = options.constBegin(); option != options.constEnd(); ++option) {
+                KDSoapGenerated::TNS__Name_value nameValue;
+                nameValue.setName(option.key());
+                nameValue.setValue(option.value().toString());
+                optionItems.append(nameValue);
+            }
+            KDSoapGenerated::TNS__Name_value_list optionList;
+            optionList.setItems(optionItems);
+            field.setOptions(optionList);
+        }
+        items.append(field);
+    }
+    fields.setItems(items);
+    return KJob::NoError;
+}
+
+int SugarRestProtocol::listEntries(const ListEntriesScope &scope, Module moduleName, const QString &query,
+                                   const QString &orderBy, const QStringList &selectedFields, EntriesListResult &entriesListResult,
+                                   QString &errorMessage)
+{
+    FATCRM_TRACE_SCOPE("rest", "SugarRestProtocol::listEntries");
+    FATCRM_TRACE_SET_DETAIL(moduleToName(moduleName));
+    QJsonArray filter;
+    if (!queryToFilter(query, filter, errorMessage)) {
+        return SugarJob::SoapError;
+    }
+    const int offset = scope.offset();
+    QJsonObject body = {
+        {QStringLiteral("offset"), offset},
+        {QStringLiteral("max_num"), s_maxResults}
+    };
+    if (!filter.isEmpty()) {
+        body.insert(QStringLiteral("filter"), filter);
+    }
+    if (!selectedFields.isEmpty()) {
+        body.insert(QStringLiteral("fields"), selectedFields.join(QLatin1Char(',')));
+    }
+    const QString restOrderBy = orderByToRest(orderBy);
+    if (!restOrderBy.isEmpty()) {
+        body.insert(QStringLiteral("order_by"), restOrderBy);
+    }
+    if (scope.includeDeleted()) {
+        body.insert(QStringLiteral("deleted"), true);
+    }
+
+    QJsonObject reply;
+    const int result = sendRequest(Post, moduleToName(moduleName) + QLatin1String("/filter"), QUrlQuery(), body, reply, errorMessage);
+    if (result != KJob::NoError) {
+        qCWarning(FATCRM_SUGARCRMRESOURCE_LOG) << "listing entries in" << moduleName << "returned error" << errorMessage;
+        return result;
+    }
+
+    const QJsonArray records = reply.value(QStringLiteral("records")).toArray();
+    const QString module = moduleToName(moduleName);
+    QList<KDSoapGenerated::TNS__Entry_value> items;
+    items.reserve(records.size());
+    for (const QJsonValue &record : records) {
+        items.append(recordToEntry(record.toObject(), module, selectedFields));
+    }
+    entriesListResult.entryList.setItems(items);
+    entriesListResult.resultCount = items.count();
+    // next_offset is -1 after the last page
+    const int nextOffset = reply.value(QStringLiteral("next_offset")).toInt(-1);
+    entriesListResult.nextOffset = nextOffset < 0 ? offset + items.count() : nextOffset;
+    return KJob::NoError;
+}
+
+int SugarRestProtocol::setEntry(Module moduleName, const KDSoapGenerated::TNS__Name_value_list &name_value_list, QString &id, QString &errorMessage)
+{
+    FATCRM_TRACE_SCOPE("rest", "SugarRestProtocol::setEntry");
+    FATCRM_TRACE_SET_DETAIL(moduleToName(moduleName));
+    QString entryId;
+    bool deleted = false;
+    QJsonObject body;
+    const auto items = name_value_list.items();
+    for (const KDSoapGenerated::TNS__Name_value &nameValue : items) {
+        if (nameValue.name() == QLatin1String("id")) {
+            entryId = nameValue.value();
+        } else if (nameValue.name() == QLatin1String("deleted")) {
+            deleted = nameValue.value() == QLatin1String("1");
+        } else {
+            body.insert(nameValue.name(), nameValue.value());
+        }
+    }
+
+    const QString path = moduleToName(moduleName);
+    QJsonObject reply;
+    int result;
+    if (entryId.isEmpty()) {
+        result = sendRequest(Post, path, QUrlQuery(), body, reply, errorMessage);
+    } else if (deleted) {
+        result = sendRequest(Delete, path + QLatin1Char('/') + entryId, QUrlQuery(), QJsonObject(), reply, errorMessage);
+    } else {
+        result = sendRequest(Put, path + QLatin1Char('/') + entryId, QUrlQuery(), body, reply, errorMessage);
+    }
+    id = reply.value(QStringLiteral("id")).toString(entryId);
+    return result;
+}
+
+SugarProtocolBase::GetRelationShipsResult SugarRestProtocol::getRelationships(const QString &sourceItemId, Module sourceModule, Module targetModule) const
+{
+    FATCRM_TRACE_SCOPE("rest", "SugarRestProtocol::getRelationships");
+    FATCRM_TRACE_SET_DETAIL(moduleToName(sourceModule));
+    GetRelationShipsResult ret;
+    ret.errorCode = KJob::NoError;
+    const QString path = moduleToName(sourceModule) + QLatin1Char('/') + sourceItemId + QLatin1String("/link/") + moduleToName(targetModule).toLower();
+    int offset = 0;
+    while (offset >= 0) {
+        QUrlQuery query;
+        query.addQueryItem(QStringLiteral("fields"), QStringLiteral("id"));
+        query.addQueryItem(QStringLiteral("offset"), QString::number(offset));
+        query.addQueryItem(QStringLiteral("max_num"), QString::number(s_maxResults));
+        QJsonObject reply;
+        ret.errorCode = sendRequest(Get, path, query, QJsonObject(), reply, ret.errorMessage);
+        if (ret.errorCode != KJob::NoError) {
+            break;
+        }
+        const QJsonArray records = reply.value(QStringLiteral("records")).toArray();
+        for (const QJsonValue &record : records) {
+            ret.ids.append(record.toObject().value(QStringLiteral("id")).toString());
+        }
+        offset = records.isEmpty() ? -1 : reply.value(QStringLiteral("next_offset")).toInt(-1);
+    }
+    return ret;
+}
+
+int SugarRestProtocol::setRelationship(const QString &sourceItemId, Module sourceModule, const QStringList &targetItemIds, Module targetModule, bool shouldDelete, QString &errorMessage) const
+{
+    FATCRM_TRACE_SCOPE("rest", "SugarRestProtocol::setRelationship");
+    FATCRM_TRACE_SET_DETAIL(moduleToName(sourceModule));
+    const QString sourceModuleName = moduleToName(sourceModule);
+    const QString targetModuleName = moduleToName(targetModule);
+    const QString linkName = targetModuleName.toLower();
+    const QString path = moduleToName(sourceModule) + QLatin1Char('/') + sourceItemId + QLatin1String("/link");
+
+    QString error;
+    QJsonObject reply;
+    int result = KJob::NoError;
+    if (shouldDelete) {
+        // One request per link, there's no bulk unlink
+        for (const QString &targetItemId : targetItemIds) {
+            result = sendRequest(Delete, path + QLatin1Char('/') + linkName + QLatin1Char('/') + targetItemId, QUrlQuery(), QJsonObject(), reply, error);
+            if (result != KJob::NoError) {
+                break;
+            }
+        }
+    } else {
+        const QJsonObject body = {
+            {QStringLiteral("link_name"), linkName},
+            {QStringLiteral("ids"), QJsonArray::fromStringList(targetItemIds)}
+        };
+        result = sendRequest(Post, path, QUrlQuery(), body, reply, error);
+    }
+    if (result == KJob::NoError) {
+        return KJob::NoError;
+    }
+
+    errorMessage = QStringLiteral("Unable to link %1 %2 to %3 %4: %5").arg(sourceModuleName, sourceItemId, targetModuleName, targetItemIds.join(','), error);
+    qCWarning(FATCRM_SUGARCRMRESOURCE_LOG) << errorMessage;
+    return KJob::UserDefinedError;
+}
+
+int SugarRestProtocol::getEntry(Module moduleName, const QString &remoteId, const QStringList &selectedFields, KDSoapGenerated::TNS__Entry_value &entryValue, QString &errorMessage)
+{
+    FATCRM_TRACE_SCOPE("rest", "SugarRestProtocol::getEntry");
+    FATCRM_TRACE_SET_DETAIL(moduleToName(moduleName));
+    QUrlQuery query;
+    if (!selectedFields.isEmpty()) {
+        query.addQueryItem(QStringLiteral("fields"), selectedFields.join(QLatin1Char(',')));
+    }
+    QJsonObject reply;
+    const int result = sendRequest(Get, moduleToName(moduleName) + QLatin1Char('/') + remoteId, query, QJsonObject(), reply, errorMessage);
+    if (result == KJob::NoError) {
+        entryValue = recordToEntry(reply, moduleToName(moduleName), selectedFields);
+    }
+    return result;
+}
+
+int SugarRestProtocol::listModules(QStringList &moduleNames, QString &errorMessage)
+{
+    FATCRM_TRACE_SCOPE("rest", "SugarRestProtocol::listModules");
+    QUrlQuery query;
+    query.addQueryItem(QStringLiteral("type_filter"), QStringLiteral("module_list"));
+    QJsonObject reply;
+    const int result = sendRequest(Get, QStringLiteral("metadata"), query, QJsonObject(), reply, errorMessage);
+    moduleNames.clear();
+    const QJsonObject moduleList = reply.value(QStringLiteral("module_list")).toObject();
+    moduleNames.reserve(moduleList.size());
+    for (auto it = moduleList.constBegin(); it != moduleList.constEnd(); ++it) {
+        if (!it.key().startsWith(QLatin1Char('_'))) { // _hash
+            moduleNames << it.value().toString();
+        }
+    }
+    return result;
+}
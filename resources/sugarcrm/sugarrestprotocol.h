@@ -0,0 +1,97 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SUGARRESTPROTOCOL_H
+#define SUGARRESTPROTOCOL_H
+
+#include "sugarprotocolbase.h"
+
+#include <QJsonArray>
+#include <QString>
+
+class QJsonObject;
+class QJsonValue;
+class QUrlQuery;
+
+/**
+ * Talks to SugarCRM through its REST v10 JSON API rather than SOAP v4.1
+ * (https://support.sugarcrm.com/Documentation/Sugar_Developer/Sugar_Developer_Guide_10.0/Integration/Web_Services/REST_API/).
+ *
+ * JSON replies are parsed straight into the same entry types as the SOAP replies,
+ * so that the module handlers work unchanged. The SOAP-style queries of the handlers
+ * are translated into filter expressions (see queryToFilter), datetimes are converted
+ * between ISO 8601 (REST) and "yyyy-MM-dd hh:mm:ss" UTC (SOAP, kdcrmdata).
+ *
+ * Calls are synchronous like those of SugarSoapProtocol, the session id is the OAuth2 access token.
+ * Requests go through SugarSession::networkAccessManager(), which also counts them, and fail
+ * with SugarJob::CouldNotConnectError when the server doesn't reply within timeout().
+ * A few features still call SOAP directly through SugarSession::soap() (document downloads,
+ * email texts, the debug interface), they use SugarSession::soapSessionId().
+ */
+class SugarRestProtocol : public SugarProtocolBase
+{
+public:
+    SugarRestProtocol();
+    ~SugarRestProtocol() override;
+    int login(const QString &user, const QString &password, QString &sessionId, QString &errorMessage) override;
+    void logout() override;
+    inline void setSession(SugarSession *session) override { mSession = session; }
+    int getEntriesCount(const ListEntriesScope &scope, Module moduleName, const QString &query, int &entriesCount, QString &errorMessage) override;
+    int getModuleFields(const QString &moduleName, KDSoapGenerated::TNS__Field_list &fields, QString &errorMessage) override;
+    int listEntries(const ListEntriesScope &scope, Module moduleName, const QString &query,
+                    const QString &orderBy, const QStringList &selectedFields, EntriesListResult &entriesListResult,
+                    QString &errorMessage) override;
+    int setEntry(Module moduleName, const KDSoapGenerated::TNS__Name_value_list &name_value_list, QString &id, QString &errorMessage) override;
+    GetRelationShipsResult getRelationships(const QString &sourceItemId, Module sourceModule, Module targetModule) const override;
+    int setRelationship(const QString &sourceItemId, Module sourceModule,
+                        const QStringList &targetItemIds, Module targetModule, bool shouldDelete, QString &errorMessage) const override;
+    int getEntry(Module moduleName, const QString &remoteId, const QStringList &selectedFields,
+                 KDSoapGenerated::TNS__Entry_value &entryValue, QString &errorMessage) override;
+    int listModules(QStringList &moduleNames, QString &errorMessage) override;
+    // From the Retry-After header of the last reply with HTTP status 429 or 503
+    int retryAfter() const override;
+    bool hasSoapSession() const override { return false; }
+
+    // How long to wait for the reply of each request, in milliseconds (default: 5 minutes)
+    void setTimeout(int msecs) { mTimeout = msecs; }
+    int timeout() const { return mTimeout; }
+
+    // Translates a SOAP query, as generated by the module handlers and ListEntriesScope,
+    // into a REST filter. Supports comparisons of fields with quoted values, combined with
+    // "and", "or" and parentheses. Returns false (and sets errorMessage) for anything else.
+    static bool queryToFilter(const QString &query, QJsonArray &filter, QString &errorMessage);
+    // "accounts.name" -> "name:asc", "date_modified desc" -> "date_modified:desc"
+    static QString orderByToRest(const QString &orderBy);
+    // JSON record -> entry, with the fields in the order of selectedFields (all of them if empty)
+    static KDSoapGenerated::TNS__Entry_value recordToEntry(const QJsonObject &record, const QString &moduleName, const QStringList &selectedFields);
+
+private:
+    enum Verb { Get, Post, Put, Delete };
+    // Sends a request to <host>/rest/v10/<path> and waits for the reply.
+    // Returns KJob::NoError or an error code of SugarJob, as the SOAP protocol does.
+    int sendRequest(Verb verb, const QString &path, const QUrlQuery &query, const QJsonObject &body,
+                    QJsonObject &reply, QString &errorMessage, int *httpStatus = nullptr) const;
+
+    SugarSession *mSession = nullptr;
+    mutable int mRetryAfter = -1;
+    int mTimeout = 5 * 60 * 1000;
+};
+
+#endif // SUGARRESTPROTOCOL_H
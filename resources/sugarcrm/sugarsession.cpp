@@ -25,10 +25,66 @@
 #include "wsdl_sugar41.h"
 #include "passwordhandler.h"
 #include "sugarprotocolbase.h"
+#include "sugarsoapprotocol.h"
 #include "sugarcrmresource_debug.h"
 
+#include <KJob>
+
+#include <config-kdsoap.h>
+
+#if KDSOAP_HAS_NETWORK_ACCESS_MANAGER
+#include <KDSoapClient/KDSoapClientInterface.h>
+#endif
+
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
 #include <QUrl>
 
+static const char s_receivedProperty[] = "_fatcrm_received";
+
+// Makes sure requests keep the connection alive and accept compressed replies, and counts them
+class SessionNetworkAccessManager : public QNetworkAccessManager
+{
+public:
+    explicit SessionNetworkAccessManager(QObject *parent)
+        : QNetworkAccessManager(parent)
+    {
+        connect(this, &QNetworkAccessManager::finished, this, [this](QNetworkReply *reply) {
+            mStatistics.decodedReplyBytes += reply->property(s_receivedProperty).toLongLong();
+            if (!reply->rawHeader("Content-Encoding").isEmpty()) {
+                ++mStatistics.compressedReplies;
+            }
+        });
+    }
+
+    SugarSession::TrafficStatistics mStatistics;
+
+protected:
+    QNetworkReply *createRequest(Operation op, const QNetworkRequest &originalRequest, QIODevice *outgoingData) override
+    {
+        QNetworkRequest request(originalRequest);
+        // HTTP/1.1 connections are persistent unless asked otherwise
+        if (request.rawHeader("Connection").toLower() == "close") {
+            request.setRawHeader("Connection", "keep-alive");
+        }
+        // Qt only asks for "gzip, deflate" and decodes the reply itself when no Accept-Encoding
+        // was set, so drop any other value
+        if (request.hasRawHeader("Accept-Encoding")) {
+            request.setRawHeader("Accept-Encoding", QByteArray());
+        }
+
+        ++mStatistics.requests;
+        if (outgoingData) {
+            mStatistics.requestBodyBytes += outgoingData->size();
+        }
+        QNetworkReply *reply = QNetworkAccessManager::createRequest(op, request, outgoingData);
+        connect(reply, &QNetworkReply::downloadProgress, reply, [reply](qint64 bytesReceived) {
+            reply->setProperty(s_receivedProperty, bytesReceived);
+        });
+        return reply;
+    }
+};
+
 class SugarSession::Private
 {
 public:
@@ -44,11 +100,13 @@ public:
 
 public:
     QString mSessionId;
+    QString mSoapSessionId; // only when the protocol doesn't have one
     QString mUserName;
     QString mPassword;
     QString mHost;
     KDSoapGenerated::Sugarsoap *mSoap = nullptr;
     SugarProtocolBase *mProtocol = nullptr;
+    SessionNetworkAccessManager *mNetworkAccessManager = nullptr;
     PasswordHandler *mPasswordHandler;
 };
 
@@ -96,6 +154,10 @@ void SugarSession::createSoapInterface()
     url.setPath("/service/v4_1/soap.php");
     url.setQuery(QString());
     d->mSoap->setEndPoint(url.toString());
+#if KDSOAP_HAS_NETWORK_ACCESS_MANAGER
+    // Same connections, headers and statistics as REST; otherwise KDSoap uses a manager of its own
+    const_cast<KDSoapClientInterface *>(d->mSoap->clientInterface())->setNetworkAccessManager(networkAccessManager());
+#endif
 }
 
 QString SugarSession::sessionId() const
@@ -103,6 +165,22 @@ QString SugarSession::sessionId() const
     return d->mSessionId;
 }
 
+QString SugarSession::soapSessionId()
+{
+    if (!d->mProtocol || d->mProtocol->hasSoapSession()) {
+        return d->mSessionId;
+    }
+    if (d->mSoapSessionId.isEmpty() && d->mSoap) {
+        SugarSoapProtocol soapProtocol;
+        soapProtocol.setSession(this);
+        QString errorMessage;
+        if (soapProtocol.login(d->mUserName, d->mPassword, d->mSoapSessionId, errorMessage) != KJob::NoError) {
+            qCWarning(FATCRM_SUGARCRMRESOURCE_LOG) << errorMessage;
+        }
+    }
+    return d->mSoapSessionId;
+}
+
 QString SugarSession::userName() const
 {
     return d->mUserName;
@@ -131,6 +209,7 @@ bool SugarSession::readPassword()
 void SugarSession::forgetSession()
 {
     d->mSessionId = QString();
+    d->mSoapSessionId = QString();
 }
 
 void SugarSession::setSessionId(const QString &sessionId)
@@ -145,7 +224,10 @@ KDSoapGenerated::Sugarsoap *SugarSession::soap()
 
 void SugarSession::setProtocol(SugarProtocolBase *protocol)
 {
-    d->mProtocol = protocol;
+    if (protocol != d->mProtocol) {
+        delete d->mProtocol;
+        d->mProtocol = protocol;
+    }
 }
 
 SugarProtocolBase *SugarSession::protocol() const
@@ -153,3 +235,22 @@ SugarProtocolBase *SugarSession::protocol() const
     return d->mProtocol;
 }
 
+QNetworkAccessManager *SugarSession::networkAccessManager()
+{
+    if (!d->mNetworkAccessManager) {
+        d->mNetworkAccessManager = new SessionNetworkAccessManager(this);
+    }
+    return d->mNetworkAccessManager;
+}
+
+SugarSession::TrafficStatistics SugarSession::trafficStatistics() const
+{
+    return d->mNetworkAccessManager ? d->mNetworkAccessManager->mStatistics : TrafficStatistics();
+}
+
+void SugarSession::resetTrafficStatistics()
+{
+    if (d->mNetworkAccessManager) {
+        d->mNetworkAccessManager->mStatistics = TrafficStatistics();
+    }
+}
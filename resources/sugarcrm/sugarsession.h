@@ -24,6 +24,7 @@
 #define SUGARSESSION_H
 
 #include <QObject>
+class QNetworkAccessManager;
 class SugarProtocolBase;
 
 namespace KDSoapGenerated
@@ -44,6 +45,17 @@ public:
         NewLogin
     };
 
+    // HTTP traffic going through networkAccessManager(): REST, and SOAP when KDSoap can use it
+    // (KDSOAP_HAS_NETWORK_ACCESS_MANAGER). Qt hides its connections and decodes compressed
+    // replies transparently, so neither the connections nor the bytes on the wire are known:
+    // sizes are those of the request bodies and of the decoded reply bodies, without headers.
+    struct TrafficStatistics {
+        int requests = 0;
+        int compressedReplies = 0; // replies with a Content-Encoding
+        qint64 requestBodyBytes = 0;
+        qint64 decodedReplyBytes = 0;
+    };
+
     explicit SugarSession(PasswordHandler *passwordHandler, QObject *parent = nullptr);
 
     ~SugarSession() override;
@@ -57,6 +69,11 @@ public:
 
     void setSessionId(const QString &sessionId);
     QString sessionId() const;
+    // The session id to pass to the calls made through soap(): sessionId() with the SOAP protocol,
+    // otherwise a SOAP session opened (with userName() and password()) on first use.
+    // Empty if that login failed.
+    QString soapSessionId();
+    // Forgets both sessionId() and soapSessionId()
     void forgetSession();
 
     PasswordHandler *passwordHandler();
@@ -64,11 +81,18 @@ public:
     // read password from wallet (and store it in session), return true on success
     bool readPassword();
 
+    // Takes ownership of protocol, and deletes the previous one
     void setProtocol(SugarProtocolBase *protocol);
     SugarProtocolBase *protocol() const;
 
     KDSoapGenerated::Sugarsoap *soap();
 
+    // Shared by the protocols talking HTTP directly, and kept for the whole session (even when
+    // changing host or protocol), so that one persistent connection serves all calls of a sync.
+    QNetworkAccessManager *networkAccessManager();
+    TrafficStatistics trafficStatistics() const;
+    void resetTrafficStatistics();
+
 private:
     class Private;
     Private *const d;
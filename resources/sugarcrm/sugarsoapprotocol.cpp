@@ -23,6 +23,8 @@
 #include "sugarjob.h"
 #include "sugarsession.h"
 #include "listentriesscope.h"
+#include "kdcrmdata/kdcrmtrace.h"
+#include <KDSoapClient/KDSoapMessage.h>
 #include <QNetworkReply>
 #include <KLocalizedString>
 #include <QEventLoop>
@@ -31,8 +33,23 @@ SugarSoapProtocol::SugarSoapProtocol()
 {
 }
 
+// The server (or a proxy in front of it) asks us to slow down: ThrottledError for HTTP 429, which Qt
+// reports as an unknown content error, ServiceUnavailableError for HTTP 503, 0 otherwise.
+// KDSoap turns network errors into faults with the QNetworkReply error as code.
+static int throttlingError(int faultCode, const QString &fault)
+{
+    if (faultCode == QNetworkReply::ServiceUnavailableError) {
+        return SugarJob::ServiceUnavailableError;
+    }
+    if (faultCode == QNetworkReply::UnknownContentError && fault.contains(QLatin1String("Too Many Requests"))) {
+        return SugarJob::ThrottledError;
+    }
+    return 0;
+}
+
 int SugarSoapProtocol::login(const QString &user, const QString &password, QString &sessionId, QString &errorMessage)
 {
+    FATCRM_TRACE_SCOPE("soap", "SugarSoapProtocol::login");
     auto* soap = mSession->soap();
     Q_ASSERT(soap != nullptr);
 
@@ -58,6 +75,8 @@ int SugarSoapProtocol::login(const QString &user, const QString &password, QStri
         if (faultcode == QNetworkReply::UnknownNetworkError ||
            faultcode == QNetworkReply::HostNotFoundError) {
             return SugarJob::CouldNotConnectError;
+        } else if (const int error = throttlingError(faultcode, soap->lastError())) {
+            return error;
         } else {
             return SugarJob::LoginError;
         }
@@ -66,6 +85,7 @@ int SugarSoapProtocol::login(const QString &user, const QString &password, QStri
 
 void SugarSoapProtocol::logout()
 {
+    FATCRM_TRACE_SCOPE("soap", "SugarSoapProtocol::logout");
     auto *soap = mSession->soap();
     if (mSession->sessionId().isEmpty() && soap != nullptr) {
         soap->logout(mSession->sessionId());
@@ -80,6 +100,10 @@ static int checkError(KDSoapGenerated::Sugarsoap *soap, const char* methodName,
 {
     if (soap->lastErrorCode() == 0) {
         return KJob::NoError;
+    } else if (const int error = throttlingError(soap->lastErrorCode(), soap->lastError())) {
+        errorMessage = soap->lastError();
+        qCDebug(FATCRM_SUGARCRMRESOURCE_LOG) << methodName << "was throttled:" << errorMessage;
+        return error;
     } else if (soap->lastErrorCode() == 10){
         errorMessage = soap->lastError();
         qCDebug(FATCRM_SUGARCRMRESOURCE_LOG) << methodName << "returned error" << errorMessage << " -- interpreting this as CouldNotConnectError";
@@ -94,6 +118,8 @@ static int checkError(KDSoapGenerated::Sugarsoap *soap, const char* methodName,
 int SugarSoapProtocol::getEntriesCount(const ListEntriesScope &scope, Module moduleName, const QString &query,
                                        int &entriesCount, QString &errorMessage)
 {
+    FATCRM_TRACE_SCOPE("soap", "SugarSoapProtocol::getEntriesCount");
+    FATCRM_TRACE_SET_DETAIL(moduleToName(moduleName));
     auto *soap = mSession->soap();
     KDSoapGenerated::TNS__Get_entries_count_result entry_result =
             soap->get_entries_count(mSession->sessionId(), moduleToName(moduleName), query, scope.includeDeleted());
@@ -103,6 +129,8 @@ int SugarSoapProtocol::getEntriesCount(const ListEntriesScope &scope, Module mod
 
 int SugarSoapProtocol::getModuleFields(const QString &moduleName, KDSoapGenerated::TNS__Field_list& fields, QString &errorMessage)
 {
+    FATCRM_TRACE_SCOPE("soap", "SugarSoapProtocol::getModuleFields");
+    FATCRM_TRACE_SET_DETAIL(moduleName);
     // https://support.sugarcrm.com/Documentation/Sugar_Developer/Sugar_Developer_Guide_6.5/Application_Framework/Web_Services/Method_Calls/get_module_fields/
     auto *soap = mSession->soap();
     const KDSoapGenerated::TNS__New_module_fields result = soap->get_module_fields(mSession->sessionId(), moduleName, {});
@@ -114,6 +142,8 @@ int SugarSoapProtocol::listEntries(const ListEntriesScope &scope, Module moduleN
                                    const QString &orderBy, const QStringList &selectedFields, EntriesListResult &entriesListResult,
                                    QString &errorMessage)
 {
+    FATCRM_TRACE_SCOPE("soap", "SugarSoapProtocol::listEntries");
+    FATCRM_TRACE_SET_DETAIL(moduleToName(moduleName));
     auto *soap = mSession->soap();
     const int offset = scope.offset();
     const int maxResults = 100;
@@ -140,6 +170,10 @@ int SugarSoapProtocol::listEntries(const ListEntriesScope &scope, Module moduleN
     if (job->isFault()) {
         qCWarning(FATCRM_SUGARCRMRESOURCE_LOG) << "listing entries in" << moduleName << "returned error" << job->faultAsString();
         errorMessage = job->faultAsString();
+        const int faultCode = job->reply().childValues().child(QStringLiteral("faultcode")).value().toInt();
+        if (const int error = throttlingError(faultCode, errorMessage)) {
+            return error;
+        }
         return SugarJob::SoapError;
     }
 
@@ -156,14 +190,35 @@ int SugarSoapProtocol::listEntries(const ListEntriesScope &scope, Module moduleN
 
 int SugarSoapProtocol::setEntry(Module moduleName, const KDSoapGenerated::TNS__Name_value_list& name_value_list, QString &id, QString &errorMessage)
 {
+    FATCRM_TRACE_SCOPE("soap", "SugarSoapProtocol::setEntry");
+    FATCRM_TRACE_SET_DETAIL(moduleToName(moduleName));
     auto *soap = mSession->soap();
     KDSoapGenerated::TNS__New_set_entry_result result = soap->set_entry(mSession->sessionId(), moduleToName(moduleName), name_value_list);
     id = result.id();
     return checkError(soap, "setEntry", errorMessage);
 }
 
+int SugarSoapProtocol::setEntries(Module moduleName, const QList<KDSoapGenerated::TNS__Name_value_list> &nameValueLists, QStringList &ids, QString &errorMessage)
+{
+    FATCRM_TRACE_SCOPE("soap", "SugarSoapProtocol::setEntries");
+    FATCRM_TRACE_SET_DETAIL(moduleToName(moduleName));
+    FATCRM_TRACE_SET_COUNT(nameValueLists.size());
+    auto *soap = mSession->soap();
+    KDSoapGenerated::TNS__Name_value_lists lists;
+    lists.setItems(nameValueLists);
+    const KDSoapGenerated::TNS__New_set_entries_result result = soap->set_entries(mSession->sessionId(), moduleToName(moduleName), lists);
+    ids = result.ids().items();
+    // Keep ids aligned with nameValueLists, e.g. on a fault the result is empty
+    while (ids.size() < nameValueLists.size()) {
+        ids.append(QString());
+    }
+    return checkError(soap, "setEntries", errorMessage);
+}
+
 SugarProtocolBase::GetRelationShipsResult SugarSoapProtocol::getRelationships(const QString &sourceItemId, Module sourceModule, Module targetModule) const
 {
+    FATCRM_TRACE_SCOPE("soap", "SugarSoapProtocol::getRelationships");
+    FATCRM_TRACE_SET_DETAIL(moduleToName(sourceModule));
     GetRelationShipsResult ret;
     KDSoapGenerated::TNS__Select_fields selectedFields;
     selectedFields.setItems({QStringLiteral("id")});
@@ -187,6 +242,8 @@ SugarProtocolBase::GetRelationShipsResult SugarSoapProtocol::getRelationships(co
 
 int SugarSoapProtocol::setRelationship(const QString &sourceItemId, Module sourceModule, const QStringList &targetItemIds, Module targetModule, bool shouldDelete, QString &errorMessage) const
 {
+    FATCRM_TRACE_SCOPE("soap", "SugarSoapProtocol::setRelationship");
+    FATCRM_TRACE_SET_DETAIL(moduleToName(sourceModule));
      auto *soap = mSession->soap();
 
      KDSoapGenerated::TNS__Select_fields relatedIds;
@@ -202,6 +259,10 @@ int SugarSoapProtocol::setRelationship(const QString &sourceItemId, Module sourc
      }
 
      const QString baseErrorMessage = QStringLiteral("Unable to link %1 %2 to %3 %4").arg(sourceModuleName, sourceItemId, targetModuleName, targetItemIds.join(','));
+     if (const int error = throttlingError(soap->lastErrorCode(), soap->lastError())) {
+         errorMessage = baseErrorMessage + ":" + soap->lastError();
+         return error;
+     }
      if (!soap->lastError().isEmpty()) {
          errorMessage = baseErrorMessage + ":" + soap->lastError();
      } else if (result.failed()) {
@@ -213,6 +274,8 @@ int SugarSoapProtocol::setRelationship(const QString &sourceItemId, Module sourc
 
 int SugarSoapProtocol::getEntry(Module moduleName, const QString &remoteId, const QStringList &selectedFields, KDSoapGenerated::TNS__Entry_value &entryValue, QString &errorMessage)
 {
+    FATCRM_TRACE_SCOPE("soap", "SugarSoapProtocol::getEntry");
+    FATCRM_TRACE_SET_DETAIL(moduleToName(moduleName));
     auto *soap = mSession->soap();
     KDSoapGenerated::TNS__Select_fields fields;
     fields.setItems(selectedFields);
@@ -224,8 +287,25 @@ int SugarSoapProtocol::getEntry(Module moduleName, const QString &remoteId, cons
     return checkError(soap, "getEntry", errorMessage);
 }
 
+int SugarSoapProtocol::getEntries(Module moduleName, const QStringList &remoteIds, const QStringList &selectedFields,
+                                  QList<KDSoapGenerated::TNS__Entry_value> &entryValues, QString &errorMessage)
+{
+    FATCRM_TRACE_SCOPE("soap", "SugarSoapProtocol::getEntries");
+    FATCRM_TRACE_SET_DETAIL(moduleToName(moduleName));
+    FATCRM_TRACE_SET_COUNT(remoteIds.size());
+    auto *soap = mSession->soap();
+    KDSoapGenerated::TNS__Select_fields ids;
+    ids.setItems(remoteIds);
+    KDSoapGenerated::TNS__Select_fields fields;
+    fields.setItems(selectedFields);
+    const KDSoapGenerated::TNS__Get_entry_result_version2 result = soap->get_entries(mSession->sessionId(), moduleToName(moduleName), ids, fields, {} /*link_..._array*/, false /*track_view*/);
+    entryValues = result.entry_list().items();
+    return checkError(soap, "getEntries", errorMessage);
+}
+
 int SugarSoapProtocol::listModules(QStringList &moduleNames, QString &errorMessage)
 {
+    FATCRM_TRACE_SCOPE("soap", "SugarSoapProtocol::listModules");
     auto *soap = mSession->soap();
     const KDSoapGenerated::TNS__Module_list result = soap->get_available_modules(mSession->sessionId(), QString() /*filter*/);
     moduleNames.clear();
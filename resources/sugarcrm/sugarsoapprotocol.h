@@ -39,11 +39,14 @@ public:
                      const QString &orderBy, const QStringList &selectedFields, EntriesListResult &entriesListResult,
                     QString &errorMessage) override;
     int setEntry(Module moduleName, const KDSoapGenerated::TNS__Name_value_list& name_value_list, QString &id, QString &errorMessage) override;
+    int setEntries(Module moduleName, const QList<KDSoapGenerated::TNS__Name_value_list> &nameValueLists, QStringList &ids, QString &errorMessage) override;
     GetRelationShipsResult getRelationships(const QString &sourceItemId, Module sourceModule, Module targetModule) const override;
     int setRelationship(const QString &sourceItemId, Module sourceModule,
                         const QStringList &targetItemIds, Module targetModule, bool shouldDelete, QString &errorMessage) const override;
     int getEntry(Module moduleName, const QString &remoteId, const QStringList &selectedFields,
                  KDSoapGenerated::TNS__Entry_value &entryValue, QString &errorMessage) override;
+    int getEntries(Module moduleName, const QStringList &remoteIds, const QStringList &selectedFields,
+                   QList<KDSoapGenerated::TNS__Entry_value> &entryValues, QString &errorMessage) override;
     int listModules(QStringList &moduleNames, QString &errorMessage) override;
 private:
     SugarSession *mSession = nullptr;
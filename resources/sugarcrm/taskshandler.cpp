@@ -452,6 +452,43 @@ Akonadi::Item TasksHandler::itemFromEntry(const TNS__Entry_value &entry, const A
     return item;
 }
 
+QMap<QString, QString> TasksHandler::itemFieldValues(const Akonadi::Item &item) const
+{
+    QMap<QString, QString> values;
+    if ( !item.hasPayload<KCalCore::Todo::Ptr>() ) {
+        return values;
+    }
+    const KCalCore::Todo::Ptr todo = item.payload<KCalCore::Todo::Ptr>();
+
+    const AccessorHash accessors = accessorHash();
+    for (auto it = accessors.constBegin(); it != accessors.constEnd(); ++it ) {
+        if ( (*it).getter == nullptr ) {
+            continue;
+        }
+        values.insert( it.key(), (*it).getter(*todo) );
+    }
+    return values;
+}
+
+bool TasksHandler::setItemFieldValues(Akonadi::Item &item, const QMap<QString, QString> &values) const
+{
+    if ( !item.hasPayload<KCalCore::Todo::Ptr>() ) {
+        return false;
+    }
+    // the payload is shared with other copies of the item, modify a copy of it
+    KCalCore::Todo::Ptr todo( item.payload<KCalCore::Todo::Ptr>()->clone() );
+
+    const AccessorHash accessors = accessorHash();
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it ) {
+        const AccessorHash::const_iterator accessIt = accessors.constFind(it.key());
+        if ( accessIt != accessors.constEnd() ) {
+            (*accessIt).setter( it.value(), *todo );
+        }
+    }
+    item.setPayload<KCalCore::Todo::Ptr>( todo );
+    return true;
+}
+
 void TasksHandler::compare( Akonadi::AbstractDifferencesReporter *reporter,
                                const Akonadi::Item &leftItem, const Akonadi::Item &rightItem )
 {
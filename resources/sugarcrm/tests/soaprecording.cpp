@@ -0,0 +1,179 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "soaprecording.h"
+
+#include <KDSoapClient/KDSoapValue.h>
+
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSet>
+
+static const char s_itemName[] = "item";
+
+QJsonObject SoapCall::toJson() const
+{
+    QJsonObject object;
+    object.insert(QStringLiteral("method"), method);
+    object.insert(QStringLiteral("request"), request);
+    object.insert(QStringLiteral("response"), response);
+    if (faultCode != 0 || !fault.isEmpty()) {
+        object.insert(QStringLiteral("faultCode"), faultCode);
+        object.insert(QStringLiteral("fault"), fault);
+    }
+    object.insert(QStringLiteral("msecs"), msecs);
+    return object;
+}
+
+SoapCall SoapCall::fromJson(const QJsonObject &object)
+{
+    SoapCall call;
+    call.method = object.value(QStringLiteral("method")).toString();
+    call.request = object.value(QStringLiteral("request")).toObject();
+    call.response = object.value(QStringLiteral("response"));
+    call.faultCode = object.value(QStringLiteral("faultCode")).toInt();
+    call.fault = object.value(QStringLiteral("fault")).toString();
+    call.msecs = qint64(object.value(QStringLiteral("msecs")).toDouble());
+    return call;
+}
+
+SoapRecording::SoapRecording(const QString &fileName)
+    : mFile(fileName)
+{
+    if (!mFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Cannot record SOAP calls into" << fileName << ":" << mFile.errorString();
+    }
+}
+
+SoapRecording::~SoapRecording()
+{
+}
+
+bool SoapRecording::isOpen() const
+{
+    return mFile.isOpen();
+}
+
+QString SoapRecording::fileName() const
+{
+    return mFile.fileName();
+}
+
+void SoapRecording::record(const SoapCall &call)
+{
+    if (!mFile.isOpen()) {
+        return;
+    }
+    mFile.write(QJsonDocument(call.toJson()).toJson(QJsonDocument::Compact));
+    mFile.write("\n");
+    mFile.flush(); // so that the recording survives a crash
+}
+
+QVector<SoapCall> SoapRecording::load(const QString &fileName, QString *errorMessage)
+{
+    QVector<SoapCall> calls;
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorMessage) {
+            *errorMessage = file.errorString();
+        }
+        return calls;
+    }
+    int lineNumber = 0;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty()) {
+            continue;
+        }
+        QJsonParseError parseError;
+        const QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+        if (!document.isObject()) {
+            if (errorMessage) {
+                *errorMessage = QStringLiteral("%1:%2: %3").arg(fileName).arg(lineNumber).arg(parseError.errorString());
+            }
+            return QVector<SoapCall>();
+        }
+        calls.append(SoapCall::fromJson(document.object()));
+    }
+    return calls;
+}
+
+QJsonObject SoapRecording::requestToJson(const KDSoapValueList &arguments)
+{
+    QJsonObject object;
+    for (const KDSoapValue &argument : arguments) {
+        const QString name = argument.name();
+        if (name == QLatin1String("session") || name == QLatin1String("user_auth")) {
+            continue;
+        }
+        object.insert(name, valueToJson(argument));
+    }
+    return object;
+}
+
+QJsonValue SoapRecording::valueToJson(const KDSoapValue &value)
+{
+    const KDSoapValueList &children = value.childValues();
+    if (children.isEmpty()) {
+        return value.value().toString();
+    }
+
+    // Arrays are the values whose children have the same name (usually "item")
+    QSet<QString> names;
+    bool isArray = false;
+    for (const KDSoapValue &child : children) {
+        if (names.contains(child.name())) {
+            isArray = true;
+            break;
+        }
+        names.insert(child.name());
+    }
+    if (isArray) {
+        QJsonArray array;
+        for (const KDSoapValue &child : children) {
+            array.append(valueToJson(child));
+        }
+        return array;
+    }
+    QJsonObject object;
+    for (const KDSoapValue &child : children) {
+        object.insert(child.name(), valueToJson(child));
+    }
+    return object;
+}
+
+KDSoapValue SoapRecording::valueFromJson(const QString &name, const QJsonValue &json)
+{
+    KDSoapValue value(name, json.isString() ? QVariant(json.toString()) : QVariant());
+    if (json.isObject()) {
+        const QJsonObject object = json.toObject();
+        for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+            value.childValues().append(valueFromJson(it.key(), it.value()));
+        }
+    } else if (json.isArray()) {
+        const QJsonArray array = json.toArray();
+        for (const QJsonValue &item : array) {
+            value.childValues().append(valueFromJson(QLatin1String(s_itemName), item));
+        }
+    }
+    return value;
+}
@@ -0,0 +1,79 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SOAPRECORDING_H
+#define SOAPRECORDING_H
+
+#include <QFile>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QString>
+#include <QVector>
+
+class KDSoapValue;
+class KDSoapValueList;
+
+/**
+ * One SOAP call of a recording: the method, its arguments and the response,
+ * converted to JSON (see SoapRecording::valueToJson), and how long it took.
+ * The session id and the credentials are not part of the recorded arguments.
+ */
+struct SoapCall
+{
+    QString method;
+    QJsonObject request;
+    QJsonValue response;
+    int faultCode = 0;
+    QString fault;
+    qint64 msecs = 0;
+
+    QJsonObject toJson() const;
+    static SoapCall fromJson(const QJsonObject &object);
+};
+
+/**
+ * Records SOAP calls into a file, one call per line of JSON, so that they can be
+ * replayed later (see SugarReplayServer) or compared, to see changes in the number
+ * and shape of calls. SugarRecordingProxy records the requests as they come off the wire,
+ * i.e. exactly as KDSoap marshalled them for SugarSoapProtocol.
+ */
+class SoapRecording
+{
+public:
+    // Truncates the file
+    explicit SoapRecording(const QString &fileName);
+    ~SoapRecording();
+
+    bool isOpen() const;
+    QString fileName() const;
+    void record(const SoapCall &call);
+
+    static QVector<SoapCall> load(const QString &fileName, QString *errorMessage = nullptr);
+
+    static QJsonObject requestToJson(const KDSoapValueList &arguments);
+    // Simple values become strings, structures objects, and arrays arrays (or objects, if they have one item)
+    static QJsonValue valueToJson(const KDSoapValue &value);
+    static KDSoapValue valueFromJson(const QString &name, const QJsonValue &json);
+
+private:
+    QFile mFile;
+};
+
+#endif // SOAPRECORDING_H
@@ -241,6 +241,32 @@ int SugarMockProtocol::getEntry(Module moduleName, const QString &remoteId, cons
 {
     Q_UNUSED(selectedFields);
     Q_UNUSED(errorMessage);
+    ++mGetEntryCallCount;
+    return findEntry(moduleName, remoteId, entryValue) ? int(KJob::NoError) : int(SugarJob::SoapError);
+}
+
+int SugarMockProtocol::getEntries(Module moduleName, const QStringList &remoteIds, const QStringList &selectedFields,
+                                  QList<KDSoapGenerated::TNS__Entry_value> &entryValues, QString &errorMessage)
+{
+    Q_UNUSED(selectedFields);
+    ++mGetEntriesCallCount;
+    if (!mNextSoapError.isEmpty()) {
+        errorMessage = mNextSoapError;
+        mNextSoapError.clear();
+        return SugarJob::SoapError;
+    }
+    entryValues.clear();
+    for (const QString &remoteId : remoteIds) {
+        KDSoapGenerated::TNS__Entry_value entryValue;
+        if (findEntry(moduleName, remoteId, entryValue)) {
+            entryValues.append(entryValue);
+        }
+    }
+    return KJob::NoError;
+}
+
+bool SugarMockProtocol::findEntry(Module moduleName, const QString &remoteId, KDSoapGenerated::TNS__Entry_value &entryValue) const
+{
     bool found = false;
     if (moduleName == Module::Accounts) {
         for (int i = 0; i < mAccounts.size() && !found; ++i) {
@@ -261,16 +287,51 @@ int SugarMockProtocol::getEntry(Module moduleName, const QString &remoteId, cons
             }
         }
     }
-    return found ? int(KJob::NoError) : int(SugarJob::SoapError);
+    return found;
 }
 
 int SugarMockProtocol::setEntry(Module moduleName, const KDSoapGenerated::TNS__Name_value_list& nameValueList, QString &newId, QString &errorMessage)
 {
+    ++mSetEntryCallCount;
+    if (!mNextSoapError.isEmpty()) {
+        errorMessage = mNextSoapError;
+        mNextSoapError.clear();
+        return SugarJob::SoapError;
+    }
+    return saveEntry(moduleName, nameValueList, newId);
+}
+
+int SugarMockProtocol::setEntries(Module moduleName, const QList<KDSoapGenerated::TNS__Name_value_list> &nameValueLists, QStringList &ids, QString &errorMessage)
+{
+    ++mSetEntriesCallCount;
     if (!mNextSoapError.isEmpty()) {
+        // The whole request fails, nothing is saved
         errorMessage = mNextSoapError;
         mNextSoapError.clear();
         return SugarJob::SoapError;
     }
+    // Like the server, an entry that can't be saved gets an empty id, the others are saved anyway
+    ids.clear();
+    for (const KDSoapGenerated::TNS__Name_value_list &nameValueList : nameValueLists) {
+        QString id;
+        if (saveEntry(moduleName, nameValueList, id) == KJob::NoError) {
+            if (id.isEmpty()) {
+                const QList<KDSoapGenerated::TNS__Name_value> list = nameValueList.items();
+                auto it = std::find_if(list.begin(), list.end(), [](const KDSoapGenerated::TNS__Name_value &nv){return nv.name() == "id";});
+                if (it != list.end()) {
+                    id = it->value();
+                }
+            }
+        } else {
+            id.clear();
+        }
+        ids.append(id);
+    }
+    return KJob::NoError;
+}
+
+int SugarMockProtocol::saveEntry(Module moduleName, const KDSoapGenerated::TNS__Name_value_list &nameValueList, QString &newId)
+{
     QList<KDSoapGenerated::TNS__Name_value> list = nameValueList.items();
     const bool deleted = std::any_of(list.begin(), list.end(), [](const KDSoapGenerated::TNS__Name_value &nv){return nv.name() == "deleted" && nv.value() == "1";});
     QString id;
@@ -279,8 +340,11 @@ int SugarMockProtocol::setEntry(Module moduleName, const KDSoapGenerated::TNS__N
         id = result->value();
     }
 
+    // Like the server, set date_modified on every write
+    const QString dateModified = KDCRMUtils::dateTimeToString(nextTimeStamp());
     if (moduleName == Module::Accounts) {
         SugarAccount account = AccountsHandler::nameValueListToSugarAccount(nameValueList,id);
+        account.setDateModifiedRaw(dateModified);
         if (!id.isEmpty()) {
             bool found = false;
             for (int i = 0; i < mAccounts.size(); ++i) {
@@ -304,6 +368,7 @@ int SugarMockProtocol::setEntry(Module moduleName, const KDSoapGenerated::TNS__N
         }
     } else if (moduleName == Module::Opportunities) {
         SugarOpportunity opp = OpportunitiesHandler::nameValueListToSugarOpportunity(nameValueList,id);
+        opp.setDateModifiedRaw(dateModified);
         if (!id.isEmpty()) {
             bool found = false;
             for (int i = 0; i < mOpportunities.size() && !found; ++i) {
@@ -55,11 +55,14 @@ public:
                     const QString &orderBy, const QStringList &selectedFields, EntriesListResult &entriesListResult,
                     QString &errorMessage) override;
     int setEntry(Module module_name, const KDSoapGenerated::TNS__Name_value_list& name_value_list, QString &idItemCreate, QString &errorMessage) override;
+    int setEntries(Module moduleName, const QList<KDSoapGenerated::TNS__Name_value_list> &nameValueLists, QStringList &ids, QString &errorMessage) override;
     GetRelationShipsResult getRelationships(const QString &sourceItemId, Module sourceModule, Module targetModule) const override;
     int setRelationship(const QString &sourceItemId, Module sourceModule,
                         const QStringList &targetItemIds, Module targetModule, bool shouldDelete, QString &errorMessage) const override;
     int getEntry(Module moduleName, const QString &remoteId, const QStringList &selectedFields,
                  KDSoapGenerated::TNS__Entry_value &entryValue, QString &errorMessage) override;
+    int getEntries(Module moduleName, const QStringList &remoteIds, const QStringList &selectedFields,
+                   QList<KDSoapGenerated::TNS__Entry_value> &entryValues, QString &errorMessage) override;
     int listModules(QStringList &moduleNames, QString &errorMessage) override;
     int getModuleFields(const QString &moduleName, KDSoapGenerated::TNS__Field_list &fields, QString &errorMessage) override;
 
@@ -78,6 +81,12 @@ public:
     QVector<SugarAccount> accounts() const;
     QVector<SugarOpportunity> opportunities() const;
 
+    // Number of set_entry, set_entries, get_entry and get_entries requests received so far
+    int setEntryCallCount() const { return mSetEntryCallCount; }
+    int setEntriesCallCount() const { return mSetEntriesCallCount; }
+    int getEntryCallCount() const { return mGetEntryCallCount; }
+    int getEntriesCallCount() const { return mGetEntriesCallCount; }
+
 public Q_SLOTS:
     Q_SCRIPTABLE void setNextSoapError(const QString &soapError) { mNextSoapError = soapError; }
     Q_SCRIPTABLE void addAccount(const QString &name, const QString &id);
@@ -103,6 +112,13 @@ private:
     QVector<KContacts::Addressee> mContacts;
     int mNextId = 1000;
     QDateTime mLastTimeStamp;
+    int mSetEntryCallCount = 0;
+    int mSetEntriesCallCount = 0;
+    int mGetEntryCallCount = 0;
+    int mGetEntriesCallCount = 0;
+
+    int saveEntry(Module moduleName, const KDSoapGenerated::TNS__Name_value_list &nameValueList, QString &newId);
+    bool findEntry(Module moduleName, const QString &remoteId, KDSoapGenerated::TNS__Entry_value &entryValue) const;
 
     QList<KDSoapGenerated::TNS__Entry_value> listAccounts(bool includeDeleted, const QDateTime &timestamp) const;
     QList<KDSoapGenerated::TNS__Entry_value> listOpportunities(bool includeDeleted, const QDateTime &timestamp) const;
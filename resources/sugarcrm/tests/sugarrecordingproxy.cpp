@@ -0,0 +1,153 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "sugarrecordingproxy.h"
+#include "soaprecording.h"
+
+#include <KDSoapClient/KDSoapClientInterface.h>
+#include <KDSoapClient/KDSoapMessage.h>
+#include <KDSoapClient/KDSoapValue.h>
+#include <KDSoapServer/KDSoapServerObjectInterface.h>
+#include <KDSoapServer/KDSoapThreadPool.h>
+
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QMutex>
+#include <QScopedPointer>
+#include <QUrl>
+
+static const char s_soapPath[] = "/service/v4_1/soap.php"; // see SugarSession::createSoapInterface
+static const char s_namespace[] = "http://www.sugarcrm.com/sugarcrm";
+
+class SugarRecordingProxy::Private
+{
+public:
+    QString mEndPoint;
+    QMutex mMutex;
+    QScopedPointer<SoapRecording> mRecording;
+    int mRecordedCount = 0;
+    KDSoapThreadPool mThreadPool;
+};
+
+// Created by KDSoapServer for each connection, in the thread handling it
+class SugarRecordingProxyObject : public QObject, public KDSoapServerObjectInterface
+{
+    Q_OBJECT
+    Q_INTERFACES(KDSoapServerObjectInterface)
+
+public:
+    explicit SugarRecordingProxyObject(SugarRecordingProxy::Private *d)
+        : d(d),
+          mClient(d->mEndPoint, QLatin1String(s_namespace))
+    {
+    }
+
+    void processRequest(const KDSoapMessage &request, KDSoapMessage &response, const QByteArray &soapAction) override
+    {
+        const QString method = request.name();
+        KDSoapMessage message;
+        message.childValues() = request.childValues();
+        message.setUse(KDSoapMessage::EncodedUse);
+        message.setNamespaceUri(QLatin1String(s_namespace));
+
+        QElapsedTimer timer;
+        timer.start();
+        const KDSoapMessage reply = mClient.call(method, message, QString::fromLatin1(soapAction));
+
+        SoapCall call;
+        call.method = method;
+        call.request = SoapRecording::requestToJson(request.childValues());
+        call.msecs = timer.elapsed();
+        if (reply.isFault()) {
+            call.faultCode = reply.childValues().child(QStringLiteral("faultcode")).value().toInt();
+            call.fault = reply.faultAsString();
+        } else if (!reply.childValues().isEmpty()) {
+            call.response = SoapRecording::valueToJson(reply.childValues().first());
+        }
+        {
+            QMutexLocker locker(&d->mMutex);
+            if (d->mRecording) {
+                d->mRecording->record(call);
+                ++d->mRecordedCount;
+            }
+        }
+
+        if (reply.isFault()) {
+            setFault(reply.childValues().child(QStringLiteral("faultcode")).value().toString(),
+                     reply.childValues().child(QStringLiteral("faultstring")).value().toString());
+            return;
+        }
+        response = reply;
+        response.setUse(KDSoapMessage::EncodedUse);
+    }
+
+private:
+    SugarRecordingProxy::Private *const d;
+    KDSoapClientInterface mClient;
+};
+
+SugarRecordingProxy::SugarRecordingProxy(const QString &serverUrl, QObject *parent)
+    : KDSoapServer(parent), d(new Private)
+{
+    QUrl url(serverUrl);
+    url.setPath(QLatin1String(s_soapPath));
+    url.setQuery(QString());
+    d->mEndPoint = url.toString();
+    setPath(QLatin1String(s_soapPath));
+    // Each call blocks its connection until the server answers
+    d->mThreadPool.setMaxThreadCount(4);
+    setThreadPool(&d->mThreadPool);
+}
+
+SugarRecordingProxy::~SugarRecordingProxy()
+{
+    close();
+    delete d;
+}
+
+bool SugarRecordingProxy::setRecordingFile(const QString &fileName)
+{
+    QMutexLocker locker(&d->mMutex);
+    d->mRecording.reset(new SoapRecording(fileName));
+    d->mRecordedCount = 0;
+    return d->mRecording->isOpen();
+}
+
+bool SugarRecordingProxy::start()
+{
+    return listen(QHostAddress::LocalHost, 0);
+}
+
+QString SugarRecordingProxy::hostUrl() const
+{
+    return QStringLiteral("http://127.0.0.1:%1").arg(serverPort());
+}
+
+int SugarRecordingProxy::recordedCount() const
+{
+    QMutexLocker locker(&d->mMutex);
+    return d->mRecordedCount;
+}
+
+QObject *SugarRecordingProxy::createServerObject()
+{
+    return new SugarRecordingProxyObject(d);
+}
+
+#include "sugarrecordingproxy.moc"
@@ -0,0 +1,60 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SUGARRECORDINGPROXY_H
+#define SUGARRECORDINGPROXY_H
+
+#include <KDSoapServer/KDSoapServer.h>
+
+/**
+ * Records the SOAP traffic between FatCRM and a SugarCRM server, to be replayed by SugarReplayServer.
+ *
+ * Point the session at hostUrl(): every call is forwarded to the server, and recorded (see SoapRecording)
+ * with the arguments parsed from the incoming request, i.e. exactly as KDSoap marshalled them,
+ * and the response or fault sent back by the server. The server can be a real SugarCRM
+ * or a SugarStandInServer.
+ */
+class SugarRecordingProxy : public KDSoapServer
+{
+    Q_OBJECT
+
+public:
+    // serverUrl: the host of the SugarCRM server, as passed to SugarSession::setSessionParameters
+    explicit SugarRecordingProxy(const QString &serverUrl, QObject *parent = nullptr);
+    ~SugarRecordingProxy() override;
+
+    // Truncates the file; returns false if it cannot be written
+    bool setRecordingFile(const QString &fileName);
+
+    // Starts listening on 127.0.0.1, on a port chosen by the system
+    bool start();
+    // The host to pass to SugarSession::setSessionParameters
+    QString hostUrl() const;
+
+    int recordedCount() const;
+
+    QObject *createServerObject() override;
+
+private:
+    friend class SugarRecordingProxyObject;
+    class Private;
+    Private *const d;
+};
+
+#endif // SUGARRECORDINGPROXY_H
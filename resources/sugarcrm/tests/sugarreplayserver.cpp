@@ -0,0 +1,170 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "sugarreplayserver.h"
+#include "soaprecording.h"
+
+#include <KDSoapClient/KDSoapMessage.h>
+#include <KDSoapClient/KDSoapValue.h>
+#include <KDSoapServer/KDSoapServerObjectInterface.h>
+
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+static const char s_soapPath[] = "/service/v4_1/soap.php"; // see SugarSession::createSoapInterface
+static const char s_namespace[] = "http://www.sugarcrm.com/sugarcrm";
+static const char s_mismatchFault[] = "1001";
+
+static QString toString(const QJsonObject &object)
+{
+    return QString::fromUtf8(QJsonDocument(object).toJson(QJsonDocument::Compact));
+}
+
+// The fields of get_entry_list, get_entry(ies) and get_relationships, in a stable order
+static QJsonObject normalized(QJsonObject arguments)
+{
+    for (const char *name : {"select_fields", "related_fields"}) {
+        const auto it = arguments.find(QLatin1String(name));
+        if (it != arguments.end() && it->isArray()) {
+            QStringList fields;
+            const QJsonArray array = it->toArray();
+            for (const QJsonValue &field : array) {
+                fields.append(field.toString());
+            }
+            fields.sort();
+            *it = QJsonArray::fromStringList(fields);
+        }
+    }
+    return arguments;
+}
+
+class SugarReplayServer::Private
+{
+public:
+    QVector<SoapCall> mCalls;
+    int mNextCall = 0;
+    QStringList mMismatches;
+};
+
+// Created by KDSoapServer for each connection. No thread pool, so everything happens in the main thread.
+class SugarReplayServerObject : public QObject, public KDSoapServerObjectInterface
+{
+    Q_OBJECT
+    Q_INTERFACES(KDSoapServerObjectInterface)
+
+public:
+    explicit SugarReplayServerObject(SugarReplayServer::Private *d)
+        : d(d)
+    {
+    }
+
+    void processRequest(const KDSoapMessage &request, KDSoapMessage &response, const QByteArray &soapAction) override
+    {
+        Q_UNUSED(soapAction);
+        const QString method = request.name();
+        const QJsonObject arguments = SoapRecording::requestToJson(request.childValues());
+        const int index = d->mNextCall;
+        if (index >= d->mCalls.count()) {
+            mismatch(QStringLiteral("call %1: unexpected %2 %3 after the end of the recording").arg(index + 1).arg(method, toString(arguments)));
+            return;
+        }
+        const SoapCall &call = d->mCalls.at(index);
+        ++d->mNextCall;
+
+        // Both sides were parsed from a request sent by KDSoap, so all the arguments are compared
+        if (call.method != method || normalized(call.request) != normalized(arguments)) {
+            mismatch(QStringLiteral("call %1: expected %2 %3, got %4 %5")
+                     .arg(index + 1).arg(call.method, toString(call.request), method, toString(arguments)));
+            return;
+        }
+
+        if (call.faultCode != 0 || !call.fault.isEmpty()) {
+            setFault(QString::number(call.faultCode), call.fault);
+            return;
+        }
+        KDSoapValue wrapper(method + QLatin1String("Response"), QVariant(), QLatin1String(s_namespace));
+        if (!call.response.isNull() && !call.response.isUndefined()) {
+            wrapper.childValues().append(SoapRecording::valueFromJson(QStringLiteral("return"), call.response));
+        }
+        response = wrapper;
+        response.setUse(KDSoapMessage::EncodedUse);
+    }
+
+private:
+    void mismatch(const QString &description)
+    {
+        d->mMismatches.append(description);
+        setFault(QLatin1String(s_mismatchFault), description);
+    }
+
+    SugarReplayServer::Private *const d;
+};
+
+SugarReplayServer::SugarReplayServer(QObject *parent)
+    : KDSoapServer(parent), d(new Private)
+{
+    setPath(QLatin1String(s_soapPath));
+}
+
+SugarReplayServer::~SugarReplayServer()
+{
+    delete d;
+}
+
+bool SugarReplayServer::load(const QString &fileName, QString *errorMessage)
+{
+    d->mCalls = SoapRecording::load(fileName, errorMessage);
+    d->mNextCall = 0;
+    d->mMismatches.clear();
+    return !d->mCalls.isEmpty();
+}
+
+bool SugarReplayServer::start()
+{
+    return listen(QHostAddress::LocalHost, 0);
+}
+
+QString SugarReplayServer::hostUrl() const
+{
+    return QStringLiteral("http://127.0.0.1:%1").arg(serverPort());
+}
+
+int SugarReplayServer::callCount() const
+{
+    return d->mCalls.count();
+}
+
+int SugarReplayServer::replayedCount() const
+{
+    return d->mNextCall;
+}
+
+QStringList SugarReplayServer::mismatches() const
+{
+    return d->mMismatches;
+}
+
+QObject *SugarReplayServer::createServerObject()
+{
+    return new SugarReplayServerObject(d);
+}
+
+#include "sugarreplayserver.moc"
@@ -0,0 +1,65 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SUGARREPLAYSERVER_H
+#define SUGARREPLAYSERVER_H
+
+#include <KDSoapServer/KDSoapServer.h>
+
+#include <QStringList>
+
+/**
+ * Replays a recording made by SugarRecordingProxy (see SoapRecording), without any SugarCRM server.
+ *
+ * The calls must come in the recorded order, with the same method and the same arguments
+ * (apart from the session id and the credentials, and the order of the selected fields,
+ * which some handlers take from a QHash); each of them gets the recorded response
+ * or fault. Anything else is reported in mismatches() and answered with a fault.
+ * Loading a recording rewinds the replay, and forgets the previous mismatches.
+ * Recorded timings are not reproduced, responses are sent immediately.
+ */
+class SugarReplayServer : public KDSoapServer
+{
+    Q_OBJECT
+
+public:
+    explicit SugarReplayServer(QObject *parent = nullptr);
+    ~SugarReplayServer() override;
+
+    bool load(const QString &fileName, QString *errorMessage = nullptr);
+
+    // Starts listening on 127.0.0.1, on a port chosen by the system
+    bool start();
+    // The host to pass to SugarSession::setSessionParameters
+    QString hostUrl() const;
+
+    int callCount() const;
+    int replayedCount() const;
+    QStringList mismatches() const;
+
+    QObject *createServerObject() override;
+
+private:
+    friend class SugarReplayServerObject;
+    class Private;
+    Private *const d;
+};
+
+#endif // SUGARREPLAYSERVER_H
@@ -0,0 +1,573 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "sugarreststandinserver.h"
+#include "sugarstandinserver.h"
+#include "kdcrmdata/kdcrmutils.h"
+
+#include <QDateTime>
+#include <QHash>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTcpSocket>
+#include <QThread>
+#include <QUrl>
+#include <QUrlQuery>
+
+static const char s_restPath[] = "/rest/v10/"; // see SugarRestProtocol::sendRequest
+
+namespace {
+
+struct HttpResponse
+{
+    HttpResponse(int status = 200, const QJsonObject &body = QJsonObject())
+        : status(status), body(body)
+    {
+    }
+    int status;
+    QJsonObject body;
+};
+
+}
+
+static HttpResponse errorResponse(int status, const QString &error, const QString &message)
+{
+    return HttpResponse(status, QJsonObject{{QStringLiteral("error"), error}, {QStringLiteral("error_message"), message}});
+}
+
+static QByteArray reasonPhrase(int status)
+{
+    switch (status) {
+    case 200: return QByteArrayLiteral("OK");
+    case 400: return QByteArrayLiteral("Bad Request");
+    case 401: return QByteArrayLiteral("Unauthorized");
+    case 404: return QByteArrayLiteral("Not Found");
+    default: return QByteArrayLiteral("Error");
+    }
+}
+
+// gzip (RFC 1952) around the deflate stream of qCompress, which is zlib (RFC 1950) behind a 4-byte size
+static QByteArray gzip(const QByteArray &data)
+{
+    static quint32 crcTable[256];
+    if (!crcTable[1]) {
+        for (quint32 n = 0; n < 256; ++n) {
+            quint32 c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xedb88320U ^ (c >> 1) : c >> 1;
+            }
+            crcTable[n] = c;
+        }
+    }
+    quint32 crc = 0xffffffffU;
+    for (const char byte : data) {
+        crc = crcTable[(crc ^ quint8(byte)) & 0xff] ^ (crc >> 8);
+    }
+    crc ^= 0xffffffffU;
+
+    auto appendLittleEndian = [](QByteArray &bytes, quint32 value) {
+        for (int i = 0; i < 4; ++i) {
+            bytes.append(char((value >> (8 * i)) & 0xff));
+        }
+    };
+    const QByteArray zlib = qCompress(data);
+    QByteArray result("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\xff", 10);
+    result += zlib.mid(4 + 2, zlib.size() - 4 - 2 - 4);
+    appendLittleEndian(result, crc);
+    appendLittleEndian(result, quint32(data.size()));
+    return result;
+}
+
+static bool isDateTimeField(const QString &name)
+{
+    return name == QLatin1String("date_modified") || name == QLatin1String("date_entered");
+}
+
+// "yyyy-MM-dd hh:mm:ss" UTC <-> ISO 8601, as sent by SugarCRM
+static QString toIsoDateTime(const QString &dateTime)
+{
+    return dateTime.isEmpty() ? dateTime : dateTime.left(10) + QLatin1Char('T') + dateTime.mid(11) + QLatin1String("+00:00");
+}
+
+static QString fromIsoDateTime(const QString &dateTime)
+{
+    const QDateTime parsed = QDateTime::fromString(dateTime, Qt::ISODate);
+    return parsed.isValid() ? KDCRMUtils::dateTimeToString(parsed.toUTC()) : QString();
+}
+
+static QString jsonToString(const QJsonValue &value)
+{
+    if (value.isBool()) {
+        return value.toBool() ? QStringLiteral("1") : QStringLiteral("0");
+    }
+    return value.toVariant().toString();
+}
+
+static QJsonObject toRecord(const QString &moduleName, const QMap<QString, QString> &fields, const QStringList &selectFields)
+{
+    QJsonObject record;
+    auto insert = [&record](const QString &name, const QString &value) {
+        if (name == QLatin1String("deleted")) {
+            record.insert(name, value == QLatin1String("1"));
+        } else if (isDateTimeField(name)) {
+            record.insert(name, toIsoDateTime(value));
+        } else {
+            record.insert(name, value);
+        }
+    };
+    if (selectFields.isEmpty()) {
+        for (auto it = fields.constBegin(); it != fields.constEnd(); ++it) {
+            insert(it.key(), it.value());
+        }
+    } else {
+        record.insert(QStringLiteral("id"), fields.value(QStringLiteral("id")));
+        for (const QString &field : selectFields) {
+            const auto it = fields.constFind(field);
+            if (it != fields.constEnd()) {
+                insert(it.key(), it.value());
+            }
+        }
+    }
+    record.insert(QStringLiteral("_module"), moduleName);
+    return record;
+}
+
+// The "date_modified": {"$gte": ...} condition added for ListEntriesScope, wherever it is in the filter
+static QString timestampFromFilter(const QJsonValue &filter)
+{
+    if (filter.isArray()) {
+        const QJsonArray array = filter.toArray();
+        for (const QJsonValue &value : array) {
+            const QString timestamp = timestampFromFilter(value);
+            if (!timestamp.isEmpty()) {
+                return timestamp;
+            }
+        }
+    } else if (filter.isObject()) {
+        const QJsonObject object = filter.toObject();
+        for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+            if (it.key() == QLatin1String("date_modified")) {
+                const QString timestamp = it.value().toObject().value(QStringLiteral("$gte")).toString();
+                if (!timestamp.isEmpty()) {
+                    return fromIsoDateTime(timestamp);
+                }
+            }
+            const QString timestamp = timestampFromFilter(it.value());
+            if (!timestamp.isEmpty()) {
+                return timestamp;
+            }
+        }
+    }
+    return QString();
+}
+
+static QStringList fieldList(const QString &fields)
+{
+    return fields.split(QLatin1Char(','), QString::SkipEmptyParts);
+}
+
+class SugarRestStandInServer::Private
+{
+public:
+    explicit Private(SugarStandInServer *dataset)
+        : mDataset(dataset)
+    {
+    }
+
+    void readRequests(QTcpSocket *socket);
+    HttpResponse handleRequest(const QByteArray &verb, const QStringList &path, const QUrlQuery &query,
+                               const QString &token, const QJsonObject &body);
+
+    HttpResponse login(const QJsonObject &body);
+    HttpResponse metadata(const QUrlQuery &query);
+    HttpResponse filter(const QString &moduleName, const QJsonObject &body, bool countOnly);
+    HttpResponse record(const QByteArray &verb, const QString &moduleName, const QString &id, const QUrlQuery &query, const QJsonObject &body);
+    HttpResponse link(const QByteArray &verb, const QStringList &path, const QUrlQuery &query, const QJsonObject &body);
+
+    HttpResponse notFound(const QString &moduleName, const QString &id) const
+    {
+        return errorResponse(404, QStringLiteral("not_found"), QStringLiteral("Could not find record: %1 in module: %2").arg(id, moduleName));
+    }
+
+    SugarStandInServer *const mDataset;
+    QHash<QString, int> mRequestCounts;
+    int mConnectionCount = 0;
+    int mCompressedResponseCount = 0;
+    qint64 mBytesReceived = 0;
+    qint64 mBytesSent = 0;
+    bool mCompressionEnabled = true;
+    QHash<QTcpSocket *, QByteArray> mBuffers;
+};
+
+void SugarRestStandInServer::Private::readRequests(QTcpSocket *socket)
+{
+    QByteArray &buffer = mBuffers[socket];
+    const QByteArray received = socket->readAll();
+    mBytesReceived += received.size();
+    buffer += received;
+    // Several requests can come in a row on a kept-alive connection
+    for (;;) {
+        const int headerEnd = buffer.indexOf("\r\n\r\n");
+        if (headerEnd < 0) {
+            return;
+        }
+        const QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+        const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+        QHash<QByteArray, QByteArray> headers;
+        for (int i = 1; i < lines.count(); ++i) {
+            const int colon = lines.at(i).indexOf(':');
+            if (colon > 0) {
+                headers.insert(lines.at(i).left(colon).trimmed().toLower(), lines.at(i).mid(colon + 1).trimmed());
+            }
+        }
+        const int contentLength = headers.value("content-length").toInt();
+        if (buffer.size() < headerEnd + 4 + contentLength) {
+            return; // wait for the rest of the body
+        }
+        const QByteArray body = buffer.mid(headerEnd + 4, contentLength);
+        buffer.remove(0, headerEnd + 4 + contentLength);
+
+        HttpResponse response;
+        const QUrl url(QString::fromUtf8(requestLine.value(1)));
+        const QString path = url.path();
+        if (requestLine.count() != 3 || !path.startsWith(QLatin1String(s_restPath))) {
+            response = errorResponse(404, QStringLiteral("no_method"), QStringLiteral("Could not find a route for %1").arg(path));
+        } else {
+            response = handleRequest(requestLine.at(0), path.mid(int(qstrlen(s_restPath))).split(QLatin1Char('/'), QString::SkipEmptyParts),
+                                     QUrlQuery(url), QString::fromUtf8(headers.value("oauth-token")),
+                                     QJsonDocument::fromJson(body).object());
+        }
+
+        const int delay = mDataset->responseDelay();
+        if (delay > 0) {
+            QThread::msleep(delay);
+        }
+        QByteArray data = QJsonDocument(response.body).toJson(QJsonDocument::Compact);
+        QByteArray contentEncoding;
+        if (mCompressionEnabled && headers.value("accept-encoding").contains("gzip")) {
+            data = gzip(data);
+            contentEncoding = "Content-Encoding: gzip\r\n";
+            ++mCompressedResponseCount;
+        }
+        mBytesSent += socket->write("HTTP/1.1 " + QByteArray::number(response.status) + ' ' + reasonPhrase(response.status) + "\r\n"
+                                    "Content-Type: application/json\r\n"
+                                    + contentEncoding +
+                                    "Content-Length: " + QByteArray::number(data.size()) + "\r\n"
+                                    "\r\n" + data);
+        if (headers.value("connection").toLower() == "close") {
+            socket->disconnectFromHost();
+            return;
+        }
+    }
+}
+
+HttpResponse SugarRestStandInServer::Private::handleRequest(const QByteArray &verb, const QStringList &path, const QUrlQuery &query,
+                                                            const QString &token, const QJsonObject &body)
+{
+    if (path == QStringList{QStringLiteral("oauth2"), QStringLiteral("token")} && verb == "POST") {
+        ++mRequestCounts[QStringLiteral("token")];
+        return login(body);
+    }
+    if (!mDataset->isValidSession(token)) {
+        return errorResponse(401, QStringLiteral("invalid_grant"), QStringLiteral("The access token provided is invalid."));
+    }
+    if (path == QStringList{QStringLiteral("oauth2"), QStringLiteral("logout")} && verb == "POST") {
+        ++mRequestCounts[QStringLiteral("logout")];
+        mDataset->closeSession(token);
+        return HttpResponse{200, QJsonObject{{QStringLiteral("success"), true}}};
+    }
+    if (path == QStringList{QStringLiteral("metadata")} && verb == "GET") {
+        ++mRequestCounts[QStringLiteral("metadata")];
+        return metadata(query);
+    }
+    if (path.count() >= 2 && path.at(1) == QLatin1String("filter") && verb == "POST") {
+        const bool countOnly = path.count() == 3 && path.at(2) == QLatin1String("count");
+        ++mRequestCounts[countOnly ? QStringLiteral("count") : QStringLiteral("filter")];
+        return filter(path.at(0), body, countOnly);
+    }
+    if (path.count() == 1 && verb == "POST") {
+        return record(verb, path.at(0), QString(), query, body);
+    }
+    if (path.count() == 2) {
+        return record(verb, path.at(0), path.at(1), query, body);
+    }
+    if (path.count() >= 3 && path.at(2) == QLatin1String("link")) {
+        return link(verb, path, query, body);
+    }
+    return errorResponse(404, QStringLiteral("no_method"), QStringLiteral("Could not find a route for %1 %2")
+                         .arg(QString::fromLatin1(verb), path.join(QLatin1Char('/'))));
+}
+
+HttpResponse SugarRestStandInServer::Private::login(const QJsonObject &body)
+{
+    if (body.value(QStringLiteral("grant_type")).toString() != QLatin1String("password")
+            || !mDataset->checkCredentials(body.value(QStringLiteral("username")).toString(), body.value(QStringLiteral("password")).toString())) {
+        return errorResponse(401, QStringLiteral("need_login"), QStringLiteral("You must specify a valid username and password."));
+    }
+    const QString token = mDataset->openSession();
+    return HttpResponse{200, QJsonObject{
+        {QStringLiteral("access_token"), token},
+        {QStringLiteral("expires_in"), 3600},
+        {QStringLiteral("token_type"), QStringLiteral("bearer")},
+        {QStringLiteral("refresh_token"), token + QLatin1String("-refresh")}
+    }};
+}
+
+HttpResponse SugarRestStandInServer::Private::metadata(const QUrlQuery &query)
+{
+    const QStringList types = query.queryItemValue(QStringLiteral("type_filter")).split(QLatin1Char(','));
+    HttpResponse response;
+    if (types.contains(QLatin1String("module_list"))) {
+        QJsonObject moduleList;
+        const QStringList moduleNames = mDataset->moduleNames();
+        for (const QString &moduleName : moduleNames) {
+            moduleList.insert(moduleName, moduleName);
+        }
+        moduleList.insert(QStringLiteral("_hash"), QStringLiteral("standin"));
+        response.body.insert(QStringLiteral("module_list"), moduleList);
+    }
+    if (types.contains(QLatin1String("modules"))) {
+        QJsonObject modules;
+        const QStringList moduleNames = query.queryItemValue(QStringLiteral("module_filter")).split(QLatin1Char(','), QString::SkipEmptyParts);
+        for (const QString &moduleName : moduleNames) {
+            QJsonObject fields;
+            const QStringList fieldNames = mDataset->moduleFieldNames(moduleName);
+            for (const QString &fieldName : fieldNames) {
+                QString type = QStringLiteral("varchar");
+                if (fieldName == QLatin1String("id")) {
+                    type = QStringLiteral("id");
+                } else if (fieldName == QLatin1String("deleted")) {
+                    type = QStringLiteral("bool");
+                } else if (isDateTimeField(fieldName)) {
+                    type = QStringLiteral("datetime");
+                }
+                fields.insert(fieldName, QJsonObject{
+                    {QStringLiteral("name"), fieldName},
+                    {QStringLiteral("type"), type},
+                    {QStringLiteral("vname"), fieldName}
+                });
+            }
+            modules.insert(moduleName, QJsonObject{{QStringLiteral("fields"), fields}});
+        }
+        response.body.insert(QStringLiteral("modules"), modules);
+    }
+    if (types.contains(QLatin1String("app_list_strings"))) {
+        response.body.insert(QStringLiteral("app_list_strings"), QJsonObject()); // the stand-in has no dropdown lists
+    }
+    return response;
+}
+
+HttpResponse SugarRestStandInServer::Private::filter(const QString &moduleName, const QJsonObject &body, bool countOnly)
+{
+    const QString since = timestampFromFilter(body.value(QStringLiteral("filter")));
+    const bool includeDeleted = body.value(QStringLiteral("deleted")).toBool();
+    HttpResponse response;
+    if (countOnly) {
+        int totalCount = 0;
+        mDataset->listEntries(moduleName, since, includeDeleted, 0, 0, &totalCount);
+        response.body.insert(QStringLiteral("record_count"), totalCount);
+        return response;
+    }
+
+    const int offset = qMax(0, body.value(QStringLiteral("offset")).toInt());
+    int maxResults = body.value(QStringLiteral("max_num")).toInt();
+    if (maxResults <= 0) {
+        maxResults = 20; // SugarCRM's default list_max_entries_per_page
+    }
+    const QStringList selectFields = fieldList(body.value(QStringLiteral("fields")).toString());
+    int totalCount = 0;
+    const QVector<QMap<QString, QString>> entries = mDataset->listEntries(moduleName, since, includeDeleted, offset, maxResults, &totalCount);
+    QJsonArray records;
+    for (const QMap<QString, QString> &fields : entries) {
+        records.append(toRecord(moduleName, fields, selectFields));
+    }
+    const int nextOffset = offset + entries.count();
+    response.body.insert(QStringLiteral("next_offset"), nextOffset < totalCount ? nextOffset : -1);
+    response.body.insert(QStringLiteral("records"), records);
+    return response;
+}
+
+HttpResponse SugarRestStandInServer::Private::record(const QByteArray &verb, const QString &moduleName, const QString &id,
+                                                     const QUrlQuery &query, const QJsonObject &body)
+{
+    QMap<QString, QString> fields;
+    for (auto it = body.constBegin(); it != body.constEnd(); ++it) {
+        fields.insert(it.key(), jsonToString(it.value()));
+    }
+    fields.remove(QStringLiteral("deleted")); // only through DELETE
+
+    QString entryId = id;
+    if (verb == "POST") {
+        ++mRequestCounts[QStringLiteral("create")];
+        entryId = mDataset->addEntry(moduleName, fields);
+    } else if (verb == "PUT") {
+        ++mRequestCounts[QStringLiteral("update")];
+        if (mDataset->entry(moduleName, id).value(QStringLiteral("deleted")) == QLatin1String("1")
+                || !mDataset->updateEntry(moduleName, id, fields)) {
+            return notFound(moduleName, id);
+        }
+    } else if (verb == "DELETE") {
+        ++mRequestCounts[QStringLiteral("delete")];
+        if (mDataset->entry(moduleName, id).value(QStringLiteral("deleted")) == QLatin1String("1")
+                || !mDataset->deleteEntry(moduleName, id)) {
+            return notFound(moduleName, id);
+        }
+        return HttpResponse{200, QJsonObject{{QStringLiteral("id"), id}}};
+    } else {
+        ++mRequestCounts[QStringLiteral("get")];
+    }
+
+    const QMap<QString, QString> entry = mDataset->entry(moduleName, entryId);
+    // Deleted records don't exist for the REST API
+    if (entry.isEmpty() || entry.value(QStringLiteral("deleted")) == QLatin1String("1")) {
+        return notFound(moduleName, entryId);
+    }
+    return HttpResponse{200, toRecord(moduleName, entry, fieldList(query.queryItemValue(QStringLiteral("fields"))))};
+}
+
+HttpResponse SugarRestStandInServer::Private::link(const QByteArray &verb, const QStringList &path, const QUrlQuery &query, const QJsonObject &body)
+{
+    // <module>/<id>/link[/<link name>[/<related id>]]
+    const QString moduleName = path.at(0);
+    const QString id = path.at(1);
+    if (mDataset->entry(moduleName, id).isEmpty()) {
+        return notFound(moduleName, id);
+    }
+    const QString linkName = path.count() > 3 ? path.at(3) : body.value(QStringLiteral("link_name")).toString();
+    const QJsonObject record = toRecord(moduleName, mDataset->entry(moduleName, id), {});
+
+    if (verb == "GET" && path.count() == 4) {
+        ++mRequestCounts[QStringLiteral("related")];
+        const QStringList relatedIds = mDataset->relatedIds(moduleName, id, linkName);
+        const int offset = qMax(0, query.queryItemValue(QStringLiteral("offset")).toInt());
+        int maxResults = query.queryItemValue(QStringLiteral("max_num")).toInt();
+        if (maxResults <= 0) {
+            maxResults = 20;
+        }
+        QJsonArray records;
+        for (int i = offset; i < relatedIds.count() && records.count() < maxResults; ++i) {
+            records.append(QJsonObject{{QStringLiteral("id"), relatedIds.at(i)}});
+        }
+        const int nextOffset = offset + records.count();
+        return HttpResponse{200, QJsonObject{
+            {QStringLiteral("next_offset"), nextOffset < relatedIds.count() ? nextOffset : -1},
+            {QStringLiteral("records"), records}
+        }};
+    }
+    if (verb == "POST" && path.count() == 3) {
+        ++mRequestCounts[QStringLiteral("link")];
+        QStringList relatedIds;
+        const QJsonArray ids = body.value(QStringLiteral("ids")).toArray();
+        QJsonArray relatedRecords;
+        for (const QJsonValue &relatedId : ids) {
+            relatedIds.append(relatedId.toString());
+            relatedRecords.append(QJsonObject{{QStringLiteral("id"), relatedId}});
+        }
+        mDataset->setRelated(moduleName, id, linkName, relatedIds, false);
+        return HttpResponse{200, QJsonObject{{QStringLiteral("record"), record}, {QStringLiteral("related_records"), relatedRecords}}};
+    }
+    if (verb == "DELETE" && path.count() == 5) {
+        ++mRequestCounts[QStringLiteral("unlink")];
+        mDataset->setRelated(moduleName, id, linkName, {path.at(4)}, true);
+        return HttpResponse{200, QJsonObject{{QStringLiteral("record"), record}, {QStringLiteral("related_record"), QJsonObject{{QStringLiteral("id"), path.at(4)}}}}};
+    }
+    return errorResponse(404, QStringLiteral("no_method"), QStringLiteral("Could not find a route for %1 %2")
+                         .arg(QString::fromLatin1(verb), path.join(QLatin1Char('/'))));
+}
+
+SugarRestStandInServer::SugarRestStandInServer(SugarStandInServer *dataset, QObject *parent)
+    : QTcpServer(parent), d(new Private(dataset))
+{
+}
+
+SugarRestStandInServer::~SugarRestStandInServer()
+{
+    close();
+    delete d;
+}
+
+bool SugarRestStandInServer::start()
+{
+    return listen(QHostAddress::LocalHost, 0);
+}
+
+QString SugarRestStandInServer::hostUrl() const
+{
+    return QStringLiteral("http://127.0.0.1:%1").arg(serverPort());
+}
+
+int SugarRestStandInServer::requestCount(const QString &endpoint) const
+{
+    return d->mRequestCounts.value(endpoint);
+}
+
+int SugarRestStandInServer::connectionCount() const
+{
+    return d->mConnectionCount;
+}
+
+void SugarRestStandInServer::setCompressionEnabled(bool enabled)
+{
+    d->mCompressionEnabled = enabled;
+}
+
+int SugarRestStandInServer::compressedResponseCount() const
+{
+    return d->mCompressedResponseCount;
+}
+
+qint64 SugarRestStandInServer::bytesReceived() const
+{
+    return d->mBytesReceived;
+}
+
+qint64 SugarRestStandInServer::bytesSent() const
+{
+    return d->mBytesSent;
+}
+
+void SugarRestStandInServer::resetRequestCounts()
+{
+    d->mRequestCounts.clear();
+    d->mConnectionCount = 0;
+    d->mCompressedResponseCount = 0;
+    d->mBytesReceived = 0;
+    d->mBytesSent = 0;
+}
+
+void SugarRestStandInServer::incomingConnection(qintptr socketDescriptor)
+{
+    auto *socket = new QTcpSocket(this);
+    if (!socket->setSocketDescriptor(socketDescriptor)) {
+        delete socket;
+        return;
+    }
+    ++d->mConnectionCount;
+    connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+        d->readRequests(socket);
+    });
+    connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+        d->mBuffers.remove(socket);
+        socket->deleteLater();
+    });
+}
@@ -0,0 +1,76 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#ifndef SUGARRESTSTANDINSERVER_H
+#define SUGARRESTSTANDINSERVER_H
+
+#include <QTcpServer>
+
+class SugarStandInServer;
+
+/**
+ * A local stand-in for the REST v10 API of SugarCRM, for SugarRestProtocol.
+ *
+ * It serves the dataset of a SugarStandInServer (which doesn't need to be listening itself),
+ * so that both protocols can be tested and compared on the same data. Like the SOAP stand-in,
+ * filters are ignored except for a "date_modified" "$gte" condition, and datetimes are sent
+ * in ISO 8601 like SugarCRM does. Sessions (OAuth2 access tokens), credentials and the response
+ * delay are those of the SugarStandInServer.
+ *
+ * A minimal HTTP/1.1 server, with keep-alive and gzip compression (when the client accepts it),
+ * handling requests in the thread of this object.
+ */
+class SugarRestStandInServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    explicit SugarRestStandInServer(SugarStandInServer *dataset, QObject *parent = nullptr);
+    ~SugarRestStandInServer() override;
+
+    // Starts listening on 127.0.0.1, on a port chosen by the system
+    bool start();
+    // The host to pass to SugarSession::setSessionParameters
+    QString hostUrl() const;
+
+    // Number of requests received for a kind of endpoint since the last reset: "token", "logout", "metadata",
+    // "filter", "count", "create", "get", "update", "delete", "related", "link" or "unlink"
+    int requestCount(const QString &endpoint) const;
+    // Number of TCP connections accepted since the last reset
+    int connectionCount() const;
+    // Compresses replies with gzip when the request has "Accept-Encoding: gzip" (the default)
+    void setCompressionEnabled(bool enabled);
+    int compressedResponseCount() const;
+    // Bytes read from and written to the sockets (headers included), since the last reset
+    qint64 bytesReceived() const;
+    qint64 bytesSent() const;
+    // Resets all of the above counters
+    void resetRequestCounts();
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override;
+
+private:
+    class Private;
+    Private *const d;
+};
+
+#endif // SUGARRESTSTANDINSERVER_H
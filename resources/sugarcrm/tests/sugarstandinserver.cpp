@@ -0,0 +1,890 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "sugarstandinserver.h"
+#include "modulename.h"
+#include "kdcrmdata/kdcrmutils.h"
+
+#include <KDSoapClient/KDSoapMessage.h>
+#include <KDSoapClient/KDSoapValue.h>
+#include <KDSoapServer/KDSoapServerObjectInterface.h>
+#include <KDSoapServer/KDSoapThreadPool.h>
+
+#include <QDateTime>
+#include <QHash>
+#include <QHostAddress>
+#include <QMutex>
+#include <QRegularExpression>
+#include <QSet>
+#include <QThread>
+#include <QUuid>
+#include <QVector>
+
+#include <algorithm>
+
+using namespace KDSoapGenerated;
+
+static const char s_soapPath[] = "/service/v4_1/soap.php"; // see SugarSession::createSoapInterface
+static const char s_namespace[] = "http://www.sugarcrm.com/sugarcrm";
+
+// Fault codes as sent by SugarCRM
+static const char s_invalidLoginFault[] = "10";
+static const char s_invalidSessionFault[] = "11";
+static const char s_noRecordsFault[] = "20";
+static const char s_notImplementedFault[] = "1000";
+
+namespace {
+
+struct StandInEntry
+{
+    QString id;
+    QString dateModified;
+    QMap<QString, QString> fields;
+};
+
+struct StandInModule
+{
+    // Both sorted by date_modified, which is unique: every write gets a new timestamp
+    QVector<StandInEntry> liveEntries;
+    QVector<StandInEntry> deletedEntries;
+    QHash<QString, QString> dateModifiedById;
+    QSet<QString> fieldNames;
+};
+
+struct Fault
+{
+    QString code;
+    QString text;
+};
+
+}
+
+static QVector<StandInEntry>::const_iterator lowerBoundByDate(const QVector<StandInEntry> &entries, const QString &timestamp)
+{
+    return std::lower_bound(entries.cbegin(), entries.cend(), timestamp, [](const StandInEntry &entry, const QString &ts) {
+        return entry.dateModified < ts;
+    });
+}
+
+// The "<module>.date_modified >= '<timestamp>'" condition added by ListEntriesScope::query
+static QString timestampFromQuery(const QString &query)
+{
+    static const QRegularExpression s_regexp(QStringLiteral("date_modified\\s*>=\\s*'([^']*)'"));
+    return s_regexp.match(query).captured(1);
+}
+
+static QString relationshipKey(const QString &moduleName, const QString &id, const QString &linkFieldName)
+{
+    return moduleName.toLower() + QLatin1Char('/') + id + QLatin1Char('/') + linkFieldName.toLower();
+}
+
+static QMap<QString, QString> nameValueListToMap(const TNS__Name_value_list &nameValueList)
+{
+    QMap<QString, QString> fields;
+    const auto items = nameValueList.items();
+    for (const TNS__Name_value &nameValue : items) {
+        fields.insert(nameValue.name(), nameValue.value());
+    }
+    return fields;
+}
+
+static TNS__Entry_value toEntryValue(const QString &moduleName, const QString &id, const QMap<QString, QString> &fields, const QStringList &selectFields)
+{
+    QList<TNS__Name_value> items;
+    auto append = [&items](const QString &name, const QString &value) {
+        TNS__Name_value nameValue;
+        nameValue.setName(name);
+        nameValue.setValue(value);
+        items.append(nameValue);
+    };
+    if (selectFields.isEmpty()) {
+        for (auto it = fields.constBegin(); it != fields.constEnd(); ++it) {
+            append(it.key(), it.value());
+        }
+    } else {
+        for (const QString &field : selectFields) {
+            const auto it = fields.constFind(field);
+            if (it != fields.constEnd()) {
+                append(it.key(), it.value());
+            }
+        }
+    }
+    TNS__Name_value_list nameValueList;
+    nameValueList.setItems(items);
+
+    TNS__Entry_value entryValue;
+    entryValue.setId(id);
+    entryValue.setModule_name(moduleName);
+    entryValue.setName_value_list(nameValueList);
+    return entryValue;
+}
+
+static QString stringArgument(const KDSoapValueList &args, const char *name)
+{
+    return args.child(QLatin1String(name)).value().toString();
+}
+
+static int intArgument(const KDSoapValueList &args, const char *name)
+{
+    return args.child(QLatin1String(name)).value().toInt();
+}
+
+template <typename T>
+static T complexArgument(const KDSoapValueList &args, const char *name)
+{
+    T ret;
+    ret.deserialize(args.child(QLatin1String(name)));
+    return ret;
+}
+
+class SugarStandInServer::Private
+{
+public:
+    Private()
+        : mLastTimestamp(QDate(2000, 1, 1), QTime(0, 0, 0), Qt::UTC)
+    {
+    }
+
+    // All of these must be called with mMutex locked
+    QString nextTimestamp();
+    StandInModule *findModule(const QString &moduleName);
+    const StandInEntry *findEntry(const QString &moduleName, const QString &id, bool *deleted);
+    QString store(const QString &moduleName, const QString &id, const QMap<QString, QString> &fields);
+    QString openSession();
+    // Returns the total count, and fills entries with at most maxResults of them from offset
+    int listEntries(const QString &moduleName, const QString &since, bool includeDeleted, int offset, int maxResults,
+                    QVector<const StandInEntry *> *entries);
+    QStringList relatedIds(const QString &moduleName, const QString &id, const QString &linkFieldName);
+    void setRelated(const QString &moduleName, const QString &id, const QString &linkFieldName, const QStringList &relatedIds, bool remove);
+    QStringList moduleNames() const;
+    QStringList moduleFieldNames(const QString &moduleName);
+
+    bool handleRequest(const QString &method, const KDSoapValueList &args, KDSoapValue &result, Fault &fault);
+
+    bool login(const KDSoapValueList &args, KDSoapValue &result, Fault &fault);
+    void getEntriesCount(const KDSoapValueList &args, KDSoapValue &result);
+    void getEntryList(const KDSoapValueList &args, KDSoapValue &result);
+    bool getEntry(const KDSoapValueList &args, KDSoapValue &result, Fault &fault);
+    void getEntries(const KDSoapValueList &args, KDSoapValue &result);
+    bool setEntry(const KDSoapValueList &args, KDSoapValue &result, Fault &fault);
+    void setEntries(const KDSoapValueList &args, KDSoapValue &result);
+    void setRelationship(const KDSoapValueList &args, KDSoapValue &result);
+    void getRelationships(const KDSoapValueList &args, KDSoapValue &result);
+    void getAvailableModules(KDSoapValue &result);
+    void getModuleFields(const KDSoapValueList &args, KDSoapValue &result);
+
+    mutable QMutex mMutex;
+    QString mUserName = QStringLiteral("user");
+    QString mPassword = QStringLiteral("password");
+    int mResponseDelay = 0;
+    QDateTime mLastTimestamp;
+    QString mLastTimestampString;
+    QHash<QString, StandInModule> mModules;
+    QHash<QString, QStringList> mExtraModuleFields;
+    QHash<QString, QSet<QString>> mRelationships; // see relationshipKey
+    QSet<QString> mSessionIds;
+    int mNextSessionId = 1;
+    QHash<QString, int> mRequestCounts;
+    KDSoapThreadPool mThreadPool;
+};
+
+QString SugarStandInServer::Private::nextTimestamp()
+{
+    mLastTimestamp = mLastTimestamp.addSecs(1);
+    mLastTimestampString = KDCRMUtils::dateTimeToString(mLastTimestamp);
+    return mLastTimestampString;
+}
+
+StandInModule *SugarStandInServer::Private::findModule(const QString &moduleName)
+{
+    const auto it = mModules.find(moduleName);
+    if (it != mModules.end()) {
+        return &it.value();
+    }
+    // Relationship link names are lowercase module names
+    for (auto it = mModules.begin(); it != mModules.end(); ++it) {
+        if (it.key().compare(moduleName, Qt::CaseInsensitive) == 0) {
+            return &it.value();
+        }
+    }
+    return nullptr;
+}
+
+const StandInEntry *SugarStandInServer::Private::findEntry(const QString &moduleName, const QString &id, bool *deleted)
+{
+    const StandInModule *module = findModule(moduleName);
+    if (!module) {
+        return nullptr;
+    }
+    const auto dateIt = module->dateModifiedById.constFind(id);
+    if (dateIt == module->dateModifiedById.constEnd()) {
+        return nullptr;
+    }
+    for (const QVector<StandInEntry> *entries : {&module->liveEntries, &module->deletedEntries}) {
+        const auto it = lowerBoundByDate(*entries, dateIt.value());
+        if (it != entries->cend() && it->id == id) {
+            *deleted = (entries == &module->deletedEntries);
+            return &*it;
+        }
+    }
+    return nullptr;
+}
+
+// Creates the entry if id is empty or unknown, otherwise merges the fields into it.
+// Either way the entry gets a new date_modified, so it moves to the end of its list.
+QString SugarStandInServer::Private::store(const QString &moduleName, const QString &id, const QMap<QString, QString> &fields)
+{
+    StandInModule &module = mModules[moduleName];
+    StandInEntry entry;
+    const auto dateIt = module.dateModifiedById.constFind(id);
+    if (!id.isEmpty() && dateIt != module.dateModifiedById.constEnd()) {
+        for (QVector<StandInEntry> *entries : {&module.liveEntries, &module.deletedEntries}) {
+            const auto it = lowerBoundByDate(*entries, dateIt.value());
+            if (it != entries->cend() && it->id == id) {
+                const int pos = int(it - entries->cbegin());
+                entry = *it;
+                entries->remove(pos);
+                break;
+            }
+        }
+    } else {
+        entry.id = id.isEmpty() ? QUuid::createUuid().toString().mid(1, 36) : id;
+        entry.fields.insert(QStringLiteral("deleted"), QStringLiteral("0"));
+    }
+
+    for (auto it = fields.constBegin(); it != fields.constEnd(); ++it) {
+        entry.fields.insert(it.key(), it.value());
+        module.fieldNames.insert(it.key());
+    }
+    entry.dateModified = nextTimestamp();
+    entry.fields.insert(QStringLiteral("id"), entry.id);
+    entry.fields.insert(QStringLiteral("date_modified"), entry.dateModified);
+    if (!entry.fields.contains(QStringLiteral("date_entered"))) {
+        entry.fields.insert(QStringLiteral("date_entered"), entry.dateModified);
+    }
+    module.dateModifiedById.insert(entry.id, entry.dateModified);
+
+    const QString ret = entry.id;
+    if (entry.fields.value(QStringLiteral("deleted")) == QLatin1String("1")) {
+        module.deletedEntries.append(entry);
+    } else {
+        module.liveEntries.append(entry);
+    }
+    return ret;
+}
+
+QString SugarStandInServer::Private::openSession()
+{
+    const QString sessionId = QStringLiteral("standin-session-%1").arg(mNextSessionId++);
+    mSessionIds.insert(sessionId);
+    return sessionId;
+}
+
+int SugarStandInServer::Private::listEntries(const QString &moduleName, const QString &since, bool includeDeleted, int offset, int maxResults,
+                                             QVector<const StandInEntry *> *entries)
+{
+    const StandInModule *module = findModule(moduleName);
+    if (!module) {
+        return 0;
+    }
+    // Live entries first, then the deleted ones if requested, both by date_modified
+    const auto liveBegin = lowerBoundByDate(module->liveEntries, since);
+    const int liveCount = int(module->liveEntries.cend() - liveBegin);
+    const auto deletedBegin = lowerBoundByDate(module->deletedEntries, since);
+    const int deletedCount = includeDeleted ? int(module->deletedEntries.cend() - deletedBegin) : 0;
+    const int totalCount = liveCount + deletedCount;
+    if (entries) {
+        for (int i = qMax(0, offset); i < totalCount && entries->count() < maxResults; ++i) {
+            entries->append(i < liveCount ? &*(liveBegin + i) : &*(deletedBegin + (i - liveCount)));
+        }
+    }
+    return totalCount;
+}
+
+// Deleted related entries are left out, entries not in the dataset are kept (only their id is known)
+QStringList SugarStandInServer::Private::relatedIds(const QString &moduleName, const QString &id, const QString &linkFieldName)
+{
+    const QSet<QString> ids = mRelationships.value(relationshipKey(moduleName, id, linkFieldName));
+    QStringList ret;
+    ret.reserve(ids.size());
+    for (const QString &relatedId : ids) {
+        bool deleted = false;
+        if (!findEntry(linkFieldName, relatedId, &deleted) || !deleted) {
+            ret.append(relatedId);
+        }
+    }
+    return ret;
+}
+
+void SugarStandInServer::Private::setRelated(const QString &moduleName, const QString &id, const QString &linkFieldName, const QStringList &relatedIds, bool remove)
+{
+    // Links go both ways, like e.g. opportunity <-> contact in SugarCRM
+    for (const QString &relatedId : relatedIds) {
+        const QString reverseKey = relationshipKey(linkFieldName, relatedId, moduleName);
+        if (remove) {
+            mRelationships[relationshipKey(moduleName, id, linkFieldName)].remove(relatedId);
+            mRelationships[reverseKey].remove(id);
+        } else {
+            mRelationships[relationshipKey(moduleName, id, linkFieldName)].insert(relatedId);
+            mRelationships[reverseKey].insert(id);
+        }
+    }
+}
+
+QStringList SugarStandInServer::Private::moduleNames() const
+{
+    QStringList moduleNames;
+    for (Module module : {Accounts, Opportunities, Campaigns, Leads, Contacts, Documents, Emails, Notes}) {
+        moduleNames.append(moduleToName(module));
+    }
+    for (auto it = mModules.constBegin(); it != mModules.constEnd(); ++it) {
+        if (!moduleNames.contains(it.key())) {
+            moduleNames.append(it.key());
+        }
+    }
+    return moduleNames;
+}
+
+QStringList SugarStandInServer::Private::moduleFieldNames(const QString &moduleName)
+{
+    QSet<QString> fieldNames = {QStringLiteral("id"), QStringLiteral("date_entered"), QStringLiteral("date_modified"), QStringLiteral("deleted")};
+    if (const StandInModule *module = findModule(moduleName)) {
+        fieldNames.unite(module->fieldNames);
+    }
+    const QStringList extraFields = mExtraModuleFields.value(moduleName);
+    for (const QString &field : extraFields) {
+        fieldNames.insert(field);
+    }
+    QStringList sortedNames = fieldNames.values();
+    sortedNames.sort();
+    return sortedNames;
+}
+
+bool SugarStandInServer::Private::handleRequest(const QString &method, const KDSoapValueList &args, KDSoapValue &result, Fault &fault)
+{
+    if (method == QLatin1String("login")) {
+        return login(args, result, fault);
+    }
+
+    if (!mSessionIds.contains(stringArgument(args, "session"))) {
+        fault = {QLatin1String(s_invalidSessionFault), QStringLiteral("Invalid Session ID")};
+        return false;
+    }
+
+    if (method == QLatin1String("logout")) {
+        mSessionIds.remove(stringArgument(args, "session"));
+    } else if (method == QLatin1String("get_entries_count")) {
+        getEntriesCount(args, result);
+    } else if (method == QLatin1String("get_entry_list")) {
+        getEntryList(args, result);
+    } else if (method == QLatin1String("get_entry")) {
+        return getEntry(args, result, fault);
+    } else if (method == QLatin1String("get_entries")) {
+        getEntries(args, result);
+    } else if (method == QLatin1String("set_entry")) {
+        return setEntry(args, result, fault);
+    } else if (method == QLatin1String("set_entries")) {
+        setEntries(args, result);
+    } else if (method == QLatin1String("set_relationship")) {
+        setRelationship(args, result);
+    } else if (method == QLatin1String("get_relationships")) {
+        getRelationships(args, result);
+    } else if (method == QLatin1String("get_available_modules")) {
+        getAvailableModules(result);
+    } else if (method == QLatin1String("get_module_fields")) {
+        getModuleFields(args, result);
+    } else {
+        fault = {QLatin1String(s_notImplementedFault), QStringLiteral("%1 is not implemented by SugarStandInServer").arg(method)};
+        return false;
+    }
+    return true;
+}
+
+bool SugarStandInServer::Private::login(const KDSoapValueList &args, KDSoapValue &result, Fault &fault)
+{
+    const auto userAuth = complexArgument<TNS__User_auth>(args, "user_auth");
+    if (userAuth.user_name() != mUserName || userAuth.password() != mPassword) {
+        fault = {QLatin1String(s_invalidLoginFault), QStringLiteral("Invalid Login")};
+        return false;
+    }
+    TNS__Entry_value entryValue;
+    entryValue.setId(openSession());
+    entryValue.setModule_name(QStringLiteral("Users"));
+    result = entryValue.serialize(QStringLiteral("return"));
+    return true;
+}
+
+void SugarStandInServer::Private::getEntriesCount(const KDSoapValueList &args, KDSoapValue &result)
+{
+    const int count = listEntries(stringArgument(args, "module_name"), timestampFromQuery(stringArgument(args, "query")),
+                                  intArgument(args, "deleted"), 0, 0, nullptr);
+    TNS__Get_entries_count_result countResult;
+    countResult.setResult_count(count);
+    result = countResult.serialize(QStringLiteral("return"));
+}
+
+void SugarStandInServer::Private::getEntryList(const KDSoapValueList &args, KDSoapValue &result)
+{
+    const QString moduleName = stringArgument(args, "module_name");
+    const int offset = qMax(0, intArgument(args, "offset"));
+    int maxResults = intArgument(args, "max_results");
+    if (maxResults <= 0) {
+        maxResults = 20; // SugarCRM's default list_max_entries_per_page
+    }
+    const QStringList selectFields = complexArgument<TNS__Select_fields>(args, "select_fields").items();
+
+    QVector<const StandInEntry *> entries;
+    const int totalCount = listEntries(moduleName, timestampFromQuery(stringArgument(args, "query")), intArgument(args, "deleted"),
+                                       offset, maxResults, &entries);
+    QList<TNS__Entry_value> items;
+    items.reserve(entries.count());
+    for (const StandInEntry *entry : qAsConst(entries)) {
+        items.append(toEntryValue(moduleName, entry->id, entry->fields, selectFields));
+    }
+
+    TNS__Entry_list entryList;
+    entryList.setItems(items);
+    TNS__Get_entry_list_result_version2 listResult;
+    listResult.setResult_count(items.count());
+    listResult.setTotal_count(totalCount);
+    listResult.setNext_offset(offset + items.count());
+    listResult.setEntry_list(entryList);
+    result = listResult.serialize(QStringLiteral("return"));
+}
+
+bool SugarStandInServer::Private::getEntry(const KDSoapValueList &args, KDSoapValue &result, Fault &fault)
+{
+    const QString moduleName = stringArgument(args, "module_name");
+    const QString id = stringArgument(args, "id");
+    bool deleted = false;
+    const StandInEntry *entry = findEntry(moduleName, id, &deleted);
+    if (!entry) {
+        fault = {QLatin1String(s_noRecordsFault), QStringLiteral("No Records")};
+        return false;
+    }
+
+    TNS__Entry_value entryValue;
+    if (deleted) {
+        // SugarCRM only tells that it's gone
+        QMap<QString, QString> fields;
+        fields.insert(QStringLiteral("id"), id);
+        fields.insert(QStringLiteral("deleted"), QStringLiteral("1"));
+        entryValue = toEntryValue(moduleName, id, fields, {});
+    } else {
+        entryValue = toEntryValue(moduleName, id, entry->fields, complexArgument<TNS__Select_fields>(args, "select_fields").items());
+    }
+    TNS__Entry_list entryList;
+    entryList.setItems({entryValue});
+    TNS__Get_entry_result_version2 entryResult;
+    entryResult.setEntry_list(entryList);
+    result = entryResult.serialize(QStringLiteral("return"));
+    return true;
+}
+
+void SugarStandInServer::Private::getEntries(const KDSoapValueList &args, KDSoapValue &result)
+{
+    const QString moduleName = stringArgument(args, "module_name");
+    const QStringList ids = complexArgument<TNS__Select_fields>(args, "ids").items();
+    const QStringList selectFields = complexArgument<TNS__Select_fields>(args, "select_fields").items();
+    QList<TNS__Entry_value> entryValues;
+    for (const QString &id : ids) {
+        bool deleted = false;
+        const StandInEntry *entry = findEntry(moduleName, id, &deleted);
+        if (!entry) {
+            continue;
+        }
+        if (deleted) {
+            QMap<QString, QString> fields;
+            fields.insert(QStringLiteral("id"), id);
+            fields.insert(QStringLiteral("deleted"), QStringLiteral("1"));
+            entryValues.append(toEntryValue(moduleName, id, fields, {}));
+        } else {
+            entryValues.append(toEntryValue(moduleName, id, entry->fields, selectFields));
+        }
+    }
+
+    TNS__Entry_list entryList;
+    entryList.setItems(entryValues);
+    TNS__Get_entry_result_version2 entryResult;
+    entryResult.setEntry_list(entryList);
+    result = entryResult.serialize(QStringLiteral("return"));
+}
+
+bool SugarStandInServer::Private::setEntry(const KDSoapValueList &args, KDSoapValue &result, Fault &fault)
+{
+    const QString moduleName = stringArgument(args, "module_name");
+    const QMap<QString, QString> fields = nameValueListToMap(complexArgument<TNS__Name_value_list>(args, "name_value_list"));
+    const QString id = fields.value(QStringLiteral("id"));
+    bool deleted = false;
+    if (!id.isEmpty() && !findEntry(moduleName, id, &deleted)) {
+        fault = {QLatin1String(s_noRecordsFault), QStringLiteral("No Records")};
+        return false;
+    }
+
+    TNS__New_set_entry_result setResult;
+    setResult.setId(store(moduleName, id, fields));
+    result = setResult.serialize(QStringLiteral("return"));
+    return true;
+}
+
+void SugarStandInServer::Private::setEntries(const KDSoapValueList &args, KDSoapValue &result)
+{
+    const QString moduleName = stringArgument(args, "module_name");
+    const QList<TNS__Name_value_list> lists = complexArgument<TNS__Name_value_lists>(args, "name_value_lists").items();
+    QStringList ids;
+    ids.reserve(lists.size());
+    for (const TNS__Name_value_list &list : lists) {
+        const QMap<QString, QString> fields = nameValueListToMap(list);
+        const QString id = fields.value(QStringLiteral("id"));
+        bool deleted = false;
+        if (!id.isEmpty() && !findEntry(moduleName, id, &deleted)) {
+            // No fault for a single entry, it just doesn't get an id
+            ids.append(QString());
+        } else {
+            ids.append(store(moduleName, id, fields));
+        }
+    }
+
+    TNS__Select_fields idList;
+    idList.setItems(ids);
+    TNS__New_set_entries_result setResult;
+    setResult.setIds(idList);
+    result = setResult.serialize(QStringLiteral("return"));
+}
+
+void SugarStandInServer::Private::setRelationship(const KDSoapValueList &args, KDSoapValue &result)
+{
+    const QString moduleName = stringArgument(args, "module_name");
+    const QString moduleId = stringArgument(args, "module_id");
+    const QString linkFieldName = stringArgument(args, "link_field_name");
+    const QStringList relatedIds = complexArgument<TNS__Select_fields>(args, "related_ids").items();
+    const bool shouldDelete = intArgument(args, "delete");
+    setRelated(moduleName, moduleId, linkFieldName, relatedIds, shouldDelete);
+
+    TNS__New_set_relationship_list_result relationshipResult;
+    relationshipResult.setCreated(shouldDelete ? 0 : relatedIds.count());
+    relationshipResult.setDeleted(shouldDelete ? relatedIds.count() : 0);
+    relationshipResult.setFailed(0);
+    result = relationshipResult.serialize(QStringLiteral("return"));
+}
+
+void SugarStandInServer::Private::getRelationships(const KDSoapValueList &args, KDSoapValue &result)
+{
+    const QString linkFieldName = stringArgument(args, "link_field_name");
+    const QStringList relatedFields = complexArgument<TNS__Select_fields>(args, "related_fields").items();
+    const QStringList ids = relatedIds(stringArgument(args, "module_name"), stringArgument(args, "module_id"), linkFieldName);
+
+    QList<TNS__Entry_value> items;
+    items.reserve(ids.size());
+    for (const QString &relatedId : ids) {
+        bool deleted = false;
+        const StandInEntry *entry = findEntry(linkFieldName, relatedId, &deleted);
+        QMap<QString, QString> fields;
+        if (entry) {
+            fields = entry->fields;
+        } else {
+            fields.insert(QStringLiteral("id"), relatedId);
+        }
+        items.append(toEntryValue(linkFieldName, relatedId, fields, relatedFields));
+    }
+
+    TNS__Entry_list entryList;
+    entryList.setItems(items);
+    TNS__Get_entry_result_version2 entryResult;
+    entryResult.setEntry_list(entryList);
+    result = entryResult.serialize(QStringLiteral("return"));
+}
+
+void SugarStandInServer::Private::getAvailableModules(KDSoapValue &result)
+{
+    const QStringList moduleNames = this->moduleNames();
+    QList<TNS__Module_list_entry> items;
+    items.reserve(moduleNames.count());
+    for (const QString &moduleName : qAsConst(moduleNames)) {
+        TNS__Module_list_entry entry;
+        entry.setModule_key(moduleName);
+        entry.setModule_label(moduleName);
+        items.append(entry);
+    }
+    TNS__Module_list_array modules;
+    modules.setItems(items);
+    TNS__Module_list moduleList;
+    moduleList.setModules(modules);
+    result = moduleList.serialize(QStringLiteral("return"));
+}
+
+void SugarStandInServer::Private::getModuleFields(const KDSoapValueList &args, KDSoapValue &result)
+{
+    const QString moduleName = stringArgument(args, "module_name");
+    const QStringList sortedNames = moduleFieldNames(moduleName);
+
+    QList<TNS__Field> items;
+    items.reserve(sortedNames.count());
+    for (const QString &fieldName : qAsConst(sortedNames)) {
+        TNS__Field field;
+        field.setName(fieldName);
+        field.setType(fieldName == QLatin1String("id") ? QStringLiteral("id") : QStringLiteral("varchar"));
+        field.setLabel(fieldName);
+        items.append(field);
+    }
+    TNS__Field_list fieldList;
+    fieldList.setItems(items);
+    TNS__New_module_fields moduleFields;
+    moduleFields.setModule_name(moduleName);
+    moduleFields.setTable_name(moduleName.toLower());
+    moduleFields.setModule_fields(fieldList);
+    result = moduleFields.serialize(QStringLiteral("return"));
+}
+
+// Created by KDSoapServer for each connection, in the thread handling it
+class SugarStandInServerObject : public QObject, public KDSoapServerObjectInterface
+{
+    Q_OBJECT
+    Q_INTERFACES(KDSoapServerObjectInterface)
+
+public:
+    explicit SugarStandInServerObject(SugarStandInServer::Private *d)
+        : d(d)
+    {
+    }
+
+    void processRequest(const KDSoapMessage &request, KDSoapMessage &response, const QByteArray &soapAction) override
+    {
+        Q_UNUSED(soapAction);
+        const QString method = request.name();
+        KDSoapValue result;
+        Fault fault;
+        bool ok;
+        int delay;
+        {
+            QMutexLocker locker(&d->mMutex);
+            ++d->mRequestCounts[method];
+            ok = d->handleRequest(method, request.childValues(), result, fault);
+            delay = d->mResponseDelay;
+        }
+        if (delay > 0) {
+            QThread::msleep(delay);
+        }
+
+        if (!ok) {
+            setFault(fault.code, fault.text);
+            return;
+        }
+        KDSoapValue wrapper(method + QLatin1String("Response"), QVariant(), QLatin1String(s_namespace));
+        if (!result.isNull()) {
+            wrapper.childValues().append(result);
+        }
+        response = wrapper;
+        response.setUse(KDSoapMessage::EncodedUse);
+    }
+
+private:
+    SugarStandInServer::Private *const d;
+};
+
+SugarStandInServer::SugarStandInServer(QObject *parent)
+    : KDSoapServer(parent), d(new Private)
+{
+    setPath(QLatin1String(s_soapPath));
+    d->mThreadPool.setMaxThreadCount(4);
+    setThreadPool(&d->mThreadPool);
+}
+
+SugarStandInServer::~SugarStandInServer()
+{
+    close();
+    delete d;
+}
+
+bool SugarStandInServer::start()
+{
+    return listen(QHostAddress::LocalHost, 0);
+}
+
+QString SugarStandInServer::hostUrl() const
+{
+    return QStringLiteral("http://127.0.0.1:%1").arg(serverPort());
+}
+
+void SugarStandInServer::setCredentials(const QString &userName, const QString &password)
+{
+    QMutexLocker locker(&d->mMutex);
+    d->mUserName = userName;
+    d->mPassword = password;
+}
+
+void SugarStandInServer::setResponseDelay(int msecs)
+{
+    QMutexLocker locker(&d->mMutex);
+    d->mResponseDelay = msecs;
+}
+
+int SugarStandInServer::responseDelay() const
+{
+    QMutexLocker locker(&d->mMutex);
+    return d->mResponseDelay;
+}
+
+QString SugarStandInServer::addEntry(const QString &moduleName, const TNS__Name_value_list &nameValueList)
+{
+    return addEntry(moduleName, nameValueListToMap(nameValueList));
+}
+
+QString SugarStandInServer::addEntry(const QString &moduleName, const QMap<QString, QString> &fields)
+{
+    QMutexLocker locker(&d->mMutex);
+    return d->store(moduleName, fields.value(QStringLiteral("id")), fields);
+}
+
+bool SugarStandInServer::updateEntry(const QString &moduleName, const QString &id, const QMap<QString, QString> &fields)
+{
+    QMutexLocker locker(&d->mMutex);
+    bool deleted = false;
+    if (!d->findEntry(moduleName, id, &deleted)) {
+        return false;
+    }
+    d->store(moduleName, id, fields);
+    return true;
+}
+
+bool SugarStandInServer::deleteEntry(const QString &moduleName, const QString &id)
+{
+    QMap<QString, QString> fields;
+    fields.insert(QStringLiteral("deleted"), QStringLiteral("1"));
+    return updateEntry(moduleName, id, fields);
+}
+
+QMap<QString, QString> SugarStandInServer::entry(const QString &moduleName, const QString &id) const
+{
+    QMutexLocker locker(&d->mMutex);
+    bool deleted = false;
+    const StandInEntry *entry = d->findEntry(moduleName, id, &deleted);
+    return entry ? entry->fields : QMap<QString, QString>();
+}
+
+int SugarStandInServer::entryCount(const QString &moduleName) const
+{
+    QMutexLocker locker(&d->mMutex);
+    const StandInModule *module = d->findModule(moduleName);
+    return module ? module->liveEntries.count() : 0;
+}
+
+void SugarStandInServer::clear()
+{
+    QMutexLocker locker(&d->mMutex);
+    d->mModules.clear();
+    d->mRelationships.clear();
+}
+
+void SugarStandInServer::setModuleFields(const QString &moduleName, const QStringList &fields)
+{
+    QMutexLocker locker(&d->mMutex);
+    d->mExtraModuleFields.insert(moduleName, fields);
+}
+
+QString SugarStandInServer::lastTimestamp() const
+{
+    QMutexLocker locker(&d->mMutex);
+    return d->mLastTimestampString;
+}
+
+bool SugarStandInServer::checkCredentials(const QString &userName, const QString &password) const
+{
+    QMutexLocker locker(&d->mMutex);
+    return userName == d->mUserName && password == d->mPassword;
+}
+
+QString SugarStandInServer::openSession()
+{
+    QMutexLocker locker(&d->mMutex);
+    return d->openSession();
+}
+
+void SugarStandInServer::closeSession(const QString &sessionId)
+{
+    QMutexLocker locker(&d->mMutex);
+    d->mSessionIds.remove(sessionId);
+}
+
+bool SugarStandInServer::isValidSession(const QString &sessionId) const
+{
+    QMutexLocker locker(&d->mMutex);
+    return d->mSessionIds.contains(sessionId);
+}
+
+QVector<QMap<QString, QString>> SugarStandInServer::listEntries(const QString &moduleName, const QString &since, bool includeDeleted,
+                                                                int offset, int maxResults, int *totalCount) const
+{
+    QMutexLocker locker(&d->mMutex);
+    QVector<const StandInEntry *> entries;
+    const int count = d->listEntries(moduleName, since, includeDeleted, offset, maxResults, &entries);
+    if (totalCount) {
+        *totalCount = count;
+    }
+    QVector<QMap<QString, QString>> ret;
+    ret.reserve(entries.count());
+    for (const StandInEntry *entry : qAsConst(entries)) {
+        ret.append(entry->fields);
+    }
+    return ret;
+}
+
+QStringList SugarStandInServer::relatedIds(const QString &moduleName, const QString &id, const QString &linkFieldName) const
+{
+    QMutexLocker locker(&d->mMutex);
+    return d->relatedIds(moduleName, id, linkFieldName);
+}
+
+void SugarStandInServer::setRelated(const QString &moduleName, const QString &id, const QString &linkFieldName, const QStringList &relatedIds, bool remove)
+{
+    QMutexLocker locker(&d->mMutex);
+    d->setRelated(moduleName, id, linkFieldName, relatedIds, remove);
+}
+
+QStringList SugarStandInServer::moduleNames() const
+{
+    QMutexLocker locker(&d->mMutex);
+    return d->moduleNames();
+}
+
+QStringList SugarStandInServer::moduleFieldNames(const QString &moduleName) const
+{
+    QMutexLocker locker(&d->mMutex);
+    return d->moduleFieldNames(moduleName);
+}
+
+int SugarStandInServer::requestCount(const QString &method) const
+{
+    QMutexLocker locker(&d->mMutex);
+    return d->mRequestCounts.value(method);
+}
+
+void SugarStandInServer::resetRequestCounts()
+{
+    QMutexLocker locker(&d->mMutex);
+    d->mRequestCounts.clear();
+}
+
+QObject *SugarStandInServer::createServerObject()
+{
+    return new SugarStandInServerObject(d);
+}
+
+#include "sugarstandinserver.moc"
@@ -0,0 +1,112 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SUGARSTANDINSERVER_H
+#define SUGARSTANDINSERVER_H
+
+#include "wsdl_sugar41.h"
+
+#include <KDSoapServer/KDSoapServer.h>
+
+#include <QMap>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * A local stand-in for a SugarCRM server, speaking the sugar41.wsdl SOAP API over HTTP.
+ *
+ * It serves an in-memory dataset, so that tests and benchmarks can run the real
+ * SugarSoapProtocol, SugarSession and jobs without a SugarCRM installation.
+ * Implemented: login, logout, get_entries_count, get_entry_list, get_entry, get_entries,
+ * set_entry, set_entries, set_relationship, get_relationships, get_available_modules and get_module_fields.
+ * Other calls return a fault.
+ *
+ * Like SugarCRM, every write stamps date_modified (here from a clock starting at
+ * 2000-01-01 00:00:00 and advancing by one second per write), and deleting sets
+ * deleted=1 rather than removing the entry. Listings order entries by date_modified,
+ * live entries first, and only understand the "date_modified >= 'timestamp'" part
+ * of the query that ListEntriesScope generates.
+ *
+ * Requests are handled in worker threads, the dataset can be modified at any time.
+ * The calls can be recorded through a SugarRecordingProxy, to be replayed by SugarReplayServer.
+ */
+class SugarStandInServer : public KDSoapServer
+{
+    Q_OBJECT
+
+public:
+    explicit SugarStandInServer(QObject *parent = nullptr);
+    ~SugarStandInServer() override;
+
+    // Starts listening on 127.0.0.1, on a port chosen by the system
+    bool start();
+    // The host to pass to SugarSession::setSessionParameters
+    QString hostUrl() const;
+
+    // Defaults to "user" / "password", like SugarMockProtocol
+    void setCredentials(const QString &userName, const QString &password);
+    // Delay added to every response, to simulate a remote server
+    void setResponseDelay(int msecs);
+    int responseDelay() const;
+
+    // Adds an entry, with a new id unless name_value_list has one, and returns its id
+    QString addEntry(const QString &moduleName, const KDSoapGenerated::TNS__Name_value_list &nameValueList);
+    QString addEntry(const QString &moduleName, const QMap<QString, QString> &fields);
+    // Updates some fields of an entry, returns false if it doesn't exist
+    bool updateEntry(const QString &moduleName, const QString &id, const QMap<QString, QString> &fields);
+    bool deleteEntry(const QString &moduleName, const QString &id);
+    // Returns all the fields of an entry, empty if it doesn't exist
+    QMap<QString, QString> entry(const QString &moduleName, const QString &id) const;
+    // Number of entries in the module, excluding deleted ones
+    int entryCount(const QString &moduleName) const;
+    void clear();
+
+    // Fields returned by get_module_fields, in addition to those of the stored entries
+    void setModuleFields(const QString &moduleName, const QStringList &fields);
+
+    // The date_modified of the latest write
+    QString lastTimestamp() const;
+
+    // For other front-ends on the same dataset, like SugarRestStandInServer. Sessions are shared too.
+    bool checkCredentials(const QString &userName, const QString &password) const;
+    QString openSession();
+    void closeSession(const QString &sessionId);
+    bool isValidSession(const QString &sessionId) const;
+    // The entries modified since the timestamp (all of them if empty), like get_entry_list
+    QVector<QMap<QString, QString>> listEntries(const QString &moduleName, const QString &since, bool includeDeleted,
+                                                int offset, int maxResults, int *totalCount = nullptr) const;
+    QStringList relatedIds(const QString &moduleName, const QString &id, const QString &linkFieldName) const;
+    void setRelated(const QString &moduleName, const QString &id, const QString &linkFieldName, const QStringList &relatedIds, bool remove);
+    QStringList moduleNames() const;
+    QStringList moduleFieldNames(const QString &moduleName) const;
+
+    // Number of requests received for a SOAP method (e.g. "get_entry_list"), since the last reset
+    int requestCount(const QString &method) const;
+    void resetRequestCounts();
+
+    QObject *createServerObject() override;
+
+private:
+    friend class SugarStandInServerObject;
+    class Private;
+    Private *const d;
+};
+
+#endif // SUGARSTANDINSERVER_H
@@ -0,0 +1,346 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "accountshandler.h"
+#include "campaignshandler.h"
+#include "conflicthandler.h"
+#include "contactshandler.h"
+#include "documentshandler.h"
+#include "emailshandler.h"
+#include "leadshandler.h"
+#include "noteshandler.h"
+#include "opportunitieshandler.h"
+#include "sugarsession.h"
+#include "taskshandler.h"
+#include "kdcrmdata/fieldmerge.h"
+#include "kdcrmdata/kdcrmfields.h"
+#include "kdcrmdata/sugaraccount.h"
+#include "kdcrmdata/sugarcampaign.h"
+#include "kdcrmdata/sugardocument.h"
+#include "kdcrmdata/sugaremail.h"
+#include "kdcrmdata/sugarlead.h"
+#include "kdcrmdata/sugarnote.h"
+#include "kdcrmdata/sugaropportunity.h"
+#include "kdcrmdata/syncbaseattribute.h"
+
+#include <AkonadiCore/Item>
+#include <KCalCore/Todo>
+#include <KContacts/Addressee>
+
+#include <QSignalSpy>
+#include <QTest>
+
+// Three-way merges of the field values of every module type, through the handlers,
+// as ConflictHandler does when an item changed on the server and locally.
+// Then ConflictHandler itself, for the merges it resolves without asking the user.
+class TestConflictMerge : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestConflictMerge()
+        : mSession(nullptr)
+    {
+    }
+
+private:
+    SugarSession mSession;
+
+    static Akonadi::Item withField(const ModuleHandler &handler, const Akonadi::Item &item, const QString &field, const QString &value)
+    {
+        QMap<QString, QString> values = handler.itemFieldValues(item);
+        values.insert(field, value);
+        Akonadi::Item result(item);
+        handler.setItemFieldValues(result, values);
+        return result;
+    }
+
+    static Akonadi::Item merged(const ModuleHandler &handler, const Akonadi::Item &local, const FieldMerge &merge, FieldMerge::Side winner)
+    {
+        Akonadi::Item result(local);
+        handler.setItemFieldValues(result, merge.merged(winner));
+        return result;
+    }
+
+    // fieldA and fieldB are two editable fields of the module, with different values in base
+    void verifyMerges(const ModuleHandler &handler, const Akonadi::Item &base, const QString &fieldA, const QString &fieldB)
+    {
+        const QMap<QString, QString> baseValues = handler.itemFieldValues(base);
+        QVERIFY(!baseValues.isEmpty());
+        QCOMPARE(handler.itemFieldValues(withField(handler, base, fieldA, "changed")).value(fieldA), QString("changed"));
+
+        // Disjoint edits: merged without collisions
+        {
+            //GIVEN
+            const Akonadi::Item local = withField(handler, base, fieldA, "local A");
+            const Akonadi::Item remote = withField(handler, base, fieldB, "remote B");
+            //WHEN
+            const FieldMerge merge(baseValues, handler.itemFieldValues(local), handler.itemFieldValues(remote));
+            //THEN
+            QVERIFY(!merge.hasCollisions());
+            QCOMPARE(merge.localChanges(), QStringList{fieldA});
+            QVERIFY(merge.needsRemoteUpdate(FieldMerge::Local));
+            const QMap<QString, QString> values = handler.itemFieldValues(merged(handler, local, merge, FieldMerge::Local));
+            QCOMPARE(values.value(fieldA), QString("local A"));
+            QCOMPARE(values.value(fieldB), QString("remote B"));
+        }
+
+        // Identical edits: nothing to merge or to send
+        {
+            //GIVEN
+            const Akonadi::Item local = withField(handler, base, fieldA, "same");
+            const Akonadi::Item remote = withField(handler, withField(handler, base, fieldA, "same"), fieldB, "remote B");
+            //WHEN
+            const FieldMerge merge(baseValues, handler.itemFieldValues(local), handler.itemFieldValues(remote));
+            //THEN
+            QVERIFY(!merge.hasCollisions());
+            QVERIFY(!merge.needsRemoteUpdate(FieldMerge::Local));
+            QCOMPARE(merge.merged(FieldMerge::Local), handler.itemFieldValues(remote));
+        }
+
+        // Overlapping edits: a collision on fieldA, the local change to fieldB is kept either way
+        {
+            //GIVEN
+            const Akonadi::Item local = withField(handler, withField(handler, base, fieldA, "local A"), fieldB, "local B");
+            const Akonadi::Item remote = withField(handler, base, fieldA, "remote A");
+            //WHEN
+            const FieldMerge merge(baseValues, handler.itemFieldValues(local), handler.itemFieldValues(remote));
+            //THEN
+            QCOMPARE(merge.collisions(), QStringList{fieldA});
+            QVERIFY(merge.needsRemoteUpdate(FieldMerge::Remote));
+            const QMap<QString, QString> localWins = handler.itemFieldValues(merged(handler, local, merge, FieldMerge::Local));
+            QCOMPARE(localWins.value(fieldA), QString("local A"));
+            QCOMPARE(localWins.value(fieldB), QString("local B"));
+            const QMap<QString, QString> remoteWins = handler.itemFieldValues(merged(handler, local, merge, FieldMerge::Remote));
+            QCOMPARE(remoteWins.value(fieldA), QString("remote A"));
+            QCOMPARE(remoteWins.value(fieldB), QString("local B"));
+        }
+    }
+
+    template <typename T>
+    static Akonadi::Item item(const T &payload)
+    {
+        Akonadi::Item item(1);
+        item.setRemoteId(QStringLiteral("1"));
+        item.setMimeType(T::mimeType());
+        item.setPayload<T>(payload);
+        return item;
+    }
+
+    // A contact modified locally, remembering the version it was based on, like SyncBaseAttribute::storeBase does
+    static Akonadi::Item locallyModified(const ModuleHandler &handler, const Akonadi::Item &base, const QString &field, const QString &value)
+    {
+        Akonadi::Item local(base);
+        SyncBaseAttribute::storeBase(local);
+        return withField(handler, local, field, value);
+    }
+
+    // What ConflictHandler reads back; otherwise start() would open the conflict dialog
+    static bool hasReadableBase(const ModuleHandler &handler, const Akonadi::Item &local)
+    {
+        const auto *attr = local.attribute<SyncBaseAttribute>();
+        if (!attr) {
+            return false;
+        }
+        Akonadi::Item base;
+        base.setMimeType(local.mimeType());
+        base.setPayloadFromData(attr->payloadData());
+        return !handler.itemFieldValues(base).isEmpty();
+    }
+
+    static KContacts::Addressee baseContact()
+    {
+        KContacts::Addressee addressee;
+        addressee.setUid("1");
+        addressee.setGivenName("First");
+        addressee.setFamilyName("Last");
+        return addressee;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        qRegisterMetaType<Akonadi::Item>();
+    }
+
+    void shouldMergeAccounts()
+    {
+        SugarAccount account;
+        account.setId("1");
+        account.setName("Account");
+        account.setDescription("Description");
+        AccountsHandler handler(&mSession);
+        verifyMerges(handler, item(account), KDCRMFields::name(), KDCRMFields::description());
+    }
+
+    void shouldMergeCampaigns()
+    {
+        SugarCampaign campaign;
+        campaign.setId("1");
+        campaign.setName("Campaign");
+        campaign.setContent("Content");
+        CampaignsHandler handler(&mSession);
+        verifyMerges(handler, item(campaign), KDCRMFields::name(), KDCRMFields::content());
+    }
+
+    void shouldMergeLeads()
+    {
+        SugarLead lead;
+        lead.setId("1");
+        lead.setLastName("Lead");
+        lead.setDescription("Description");
+        LeadsHandler handler(&mSession);
+        verifyMerges(handler, item(lead), KDCRMFields::lastName(), KDCRMFields::description());
+    }
+
+    void shouldMergeOpportunities()
+    {
+        SugarOpportunity opportunity;
+        opportunity.setId("1");
+        opportunity.setName("Opportunity");
+        opportunity.setDescription("Description");
+        OpportunitiesHandler handler(&mSession);
+        verifyMerges(handler, item(opportunity), KDCRMFields::name(), KDCRMFields::description());
+    }
+
+    void shouldMergeNotes()
+    {
+        SugarNote note;
+        note.setId("1");
+        note.setName("Note");
+        note.setDescription("Description");
+        NotesHandler handler(&mSession);
+        verifyMerges(handler, item(note), KDCRMFields::name(), KDCRMFields::description());
+    }
+
+    void shouldMergeEmails()
+    {
+        SugarEmail email;
+        email.setId("1");
+        email.setName("Email");
+        email.setDescription("Description");
+        EmailsHandler handler(&mSession);
+        verifyMerges(handler, item(email), KDCRMFields::name(), KDCRMFields::description());
+    }
+
+    void shouldMergeDocuments()
+    {
+        SugarDocument document;
+        document.setId("1");
+        document.setDocumentName("Document");
+        document.setDescription("Description");
+        DocumentsHandler handler(&mSession);
+        verifyMerges(handler, item(document), KDCRMFields::documentName(), KDCRMFields::description());
+    }
+
+    void shouldMergeContacts()
+    {
+        KContacts::Addressee addressee;
+        addressee.setUid("1");
+        addressee.setGivenName("First");
+        addressee.setFamilyName("Last");
+        ContactsHandler handler(&mSession);
+        verifyMerges(handler, item(addressee), KDCRMFields::firstName(), KDCRMFields::lastName());
+    }
+
+    void shouldMergeTasks()
+    {
+        KCalCore::Todo::Ptr todo(new KCalCore::Todo);
+        todo->setUid("1");
+        todo->setSummary("Task");
+        todo->setDescription("Description");
+        Akonadi::Item task(1);
+        task.setRemoteId(QStringLiteral("1"));
+        task.setMimeType(KCalCore::Todo::todoMimeType());
+        task.setPayload<KCalCore::Todo::Ptr>(todo);
+        TasksHandler handler(&mSession);
+        verifyMerges(handler, task, KDCRMFields::name(), KDCRMFields::description());
+    }
+
+    void conflictHandlerShouldSendDisjointChangesMerged()
+    {
+        //GIVEN a contact renamed locally, while the server changed its family name
+        ContactsHandler handler(&mSession);
+        const Akonadi::Item base = item(baseContact());
+        const Akonadi::Item local = locallyModified(handler, base, KDCRMFields::firstName(), "Local");
+        Akonadi::Item remote = withField(handler, base, KDCRMFields::lastName(), "Remote");
+        remote.setRemoteRevision(QStringLiteral("rev2"));
+        QVERIFY(hasReadableBase(handler, local));
+        ConflictHandler conflictHandler(ConflictHandler::BackendConflict);
+        conflictHandler.setConflictingItems(local, remote);
+        conflictHandler.setModuleHandler(&handler);
+        QSignalSpy updateSpy(&conflictHandler, &ConflictHandler::updateOnBackend);
+        QSignalSpy commitSpy(&conflictHandler, &ConflictHandler::commitChange);
+        //WHEN
+        conflictHandler.start();
+        //THEN the merged version is sent, based on the server's revision
+        QCOMPARE(updateSpy.count(), 1);
+        QCOMPARE(commitSpy.count(), 0);
+        const Akonadi::Item sent = updateSpy.at(0).at(0).value<Akonadi::Item>();
+        QCOMPARE(sent.remoteRevision(), QStringLiteral("rev2"));
+        const QMap<QString, QString> values = handler.itemFieldValues(sent);
+        QCOMPARE(values.value(KDCRMFields::firstName()), QStringLiteral("Local"));
+        QCOMPARE(values.value(KDCRMFields::lastName()), QStringLiteral("Remote"));
+    }
+
+    void conflictHandlerShouldCommitTheServerVersionWhenItHasTheLocalChanges()
+    {
+        //GIVEN the same change, locally and on the server, which also changed another field
+        ContactsHandler handler(&mSession);
+        const Akonadi::Item base = item(baseContact());
+        const Akonadi::Item local = locallyModified(handler, base, KDCRMFields::firstName(), "Same");
+        Akonadi::Item remote = withField(handler, withField(handler, base, KDCRMFields::firstName(), "Same"), KDCRMFields::lastName(), "Remote");
+        remote.setId(-1);
+        remote.setRemoteRevision(QStringLiteral("rev2"));
+        QVERIFY(hasReadableBase(handler, local));
+        ConflictHandler conflictHandler(ConflictHandler::BackendConflict);
+        conflictHandler.setConflictingItems(local, remote);
+        conflictHandler.setModuleHandler(&handler);
+        QSignalSpy updateSpy(&conflictHandler, &ConflictHandler::updateOnBackend);
+        QSignalSpy commitSpy(&conflictHandler, &ConflictHandler::commitChange);
+        //WHEN
+        conflictHandler.start();
+        //THEN nothing is sent, the server version replaces the local item
+        QCOMPARE(updateSpy.count(), 0);
+        QCOMPARE(commitSpy.count(), 1);
+        const Akonadi::Item committed = commitSpy.at(0).at(0).value<Akonadi::Item>();
+        QCOMPARE(committed.id(), local.id());
+        QCOMPARE(committed.remoteRevision(), QStringLiteral("rev2"));
+        QVERIFY(!committed.hasAttribute<SyncBaseAttribute>());
+        QCOMPARE(handler.itemFieldValues(committed), handler.itemFieldValues(remote));
+    }
+
+    void shouldKeepFieldsMissingLocally()
+    {
+        //GIVEN a custom field only known to the server
+        const QMap<QString, QString> base{{"name", "Account"}, {"city", "Berlin"}};
+        const QMap<QString, QString> local{{"name", "Local name"}};
+        const QMap<QString, QString> remote{{"name", "Account"}, {"city", "Paris"}, {"custom_c", "x"}};
+        //WHEN
+        const FieldMerge merge(base, local, remote);
+        //THEN
+        QVERIFY(!merge.hasCollisions());
+        const QMap<QString, QString> expected{{"name", "Local name"}, {"city", "Paris"}, {"custom_c", "x"}};
+        QCOMPARE(merge.merged(FieldMerge::Local), expected);
+    }
+};
+
+QTEST_MAIN(TestConflictMerge)
+#include "test_conflictmerge.moc"
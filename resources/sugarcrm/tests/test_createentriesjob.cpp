@@ -0,0 +1,166 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <QTest>
+#include <QSignalSpy>
+#include <AkonadiCore/Item>
+#include "sugaraccount.h"
+#include "sugarsession.h"
+#include "sugarmockprotocol.h"
+#include "accountshandler.h"
+#include "createentriesjob.h"
+
+static Akonadi::Item::List newAccountItems(const QStringList &names)
+{
+    Akonadi::Item::List items;
+    Akonadi::Item::Id id = 1;
+    for (const QString &name : names) {
+        SugarAccount account;
+        account.setName(name);
+        Akonadi::Item item(id++);
+        item.setMimeType(SugarAccount::mimeType());
+        item.setPayload<SugarAccount>(account);
+        items.append(item);
+    }
+    return items;
+}
+
+class TestCreateEntriesJob : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+
+    void initTestCase()
+    {
+        qRegisterMetaType<Akonadi::Item::List>();
+    }
+
+    void shouldCreateAccountsInBatches()
+    {
+        //GIVEN
+        auto *protocol = new SugarMockProtocol;
+        SugarSession session(nullptr);
+        session.setSessionParameters("user", "password", "hosttest");
+        protocol->addAccounts();
+        session.setProtocol(protocol);
+        protocol->setSession(&session);
+        AccountsHandler handler(&session);
+        CreateEntriesJob job(newAccountItems({"a", "b", "c", "d", "e"}), &session);
+        job.setModule(&handler);
+        job.setBatchSize(2);
+        QSignalSpy batchSpy(&job, &CreateEntriesJob::batchCreated);
+        //WHEN
+        QVERIFY(job.exec());
+        //THEN one set_entries and one get_entries per batch
+        QCOMPARE(protocol->setEntriesCallCount(), 3);
+        QCOMPARE(protocol->getEntriesCallCount(), 3);
+        QCOMPARE(protocol->setEntryCallCount(), 0);
+        QCOMPARE(protocol->getEntryCallCount(), 0);
+        QCOMPARE(batchSpy.count(), 3);
+        QCOMPARE(batchSpy.at(2).at(0).value<Akonadi::Item::List>().count(), 1);
+        QCOMPARE(protocol->accounts().size(), 8);
+        const Akonadi::Item::List created = job.createdItems();
+        QCOMPARE(created.count(), 5);
+        QVERIFY(job.failedItems().isEmpty());
+        for (int i = 0; i < created.count(); ++i) {
+            const Akonadi::Item &item = created.at(i);
+            QCOMPARE(item.id(), Akonadi::Item::Id(i + 1));
+            QVERIFY(!item.remoteId().isEmpty());
+            QVERIFY(item.hasPayload<SugarAccount>());
+            // read back from the server
+            QCOMPARE(item.payload<SugarAccount>().id(), item.remoteId());
+            QCOMPARE(item.payload<SugarAccount>().name(), QString(QChar('a' + i)));
+            QVERIFY(!item.remoteRevision().isEmpty());
+        }
+    }
+
+    void shouldReportItemsWhichCouldNotBeCreated()
+    {
+        //GIVEN an item without payload in the middle
+        auto *protocol = new SugarMockProtocol;
+        SugarSession session(nullptr);
+        session.setSessionParameters("user", "password", "hosttest");
+        session.setProtocol(protocol);
+        protocol->setSession(&session);
+        AccountsHandler handler(&session);
+        Akonadi::Item::List items = newAccountItems({"a", "b", "c"});
+        items[1] = Akonadi::Item(items.at(1).id());
+        CreateEntriesJob job(items, &session);
+        job.setModule(&handler);
+        //WHEN
+        QVERIFY(!job.exec());
+        //THEN
+        QCOMPARE(job.error(), int(SugarJob::SoapError));
+        QCOMPARE(protocol->setEntriesCallCount(), 1);
+        QCOMPARE(protocol->getEntriesCallCount(), 1);
+        QCOMPARE(job.createdItems().count(), 2);
+        QCOMPARE(job.createdItems().at(0).id(), Akonadi::Item::Id(1));
+        QCOMPARE(job.createdItems().at(1).id(), Akonadi::Item::Id(3));
+        QCOMPARE(job.failedItems().count(), 1);
+        QCOMPARE(job.failedItems().at(0).id(), Akonadi::Item::Id(2));
+        QCOMPARE(protocol->accounts().size(), 2);
+    }
+
+    void shouldNotCreateAnythingWhenTheRequestFails()
+    {
+        //GIVEN
+        auto *protocol = new SugarMockProtocol;
+        SugarSession session(nullptr);
+        session.setSessionParameters("user", "password", "hosttest");
+        protocol->addAccounts();
+        session.setProtocol(protocol);
+        protocol->setSession(&session);
+        protocol->setNextSoapError(QStringLiteral("Access Denied"));
+        AccountsHandler handler(&session);
+        CreateEntriesJob job(newAccountItems({"a", "b"}), &session);
+        job.setModule(&handler);
+        //WHEN
+        QVERIFY(!job.exec());
+        //THEN
+        QCOMPARE(job.error(), int(SugarJob::SoapError));
+        QCOMPARE(job.errorText(), QStringLiteral("Access Denied"));
+        QVERIFY(job.createdItems().isEmpty());
+        QCOMPARE(protocol->getEntriesCallCount(), 0);
+        QCOMPARE(protocol->accounts().size(), 3);
+    }
+
+    void shouldHandleCouldNotConnectError()
+    {
+        //GIVEN
+        auto *protocol = new SugarMockProtocol;
+        protocol->setServerNotFound(true);
+        SugarSession session(nullptr);
+        session.setSessionParameters("user", "password", "hosttest");
+        session.setProtocol(protocol);
+        protocol->setSession(&session);
+        AccountsHandler handler(&session);
+        CreateEntriesJob job(newAccountItems({"a"}), &session);
+        job.setModule(&handler);
+        //WHEN
+        QVERIFY(!job.exec());
+        //THEN
+        QCOMPARE(job.error(), int(SugarJob::CouldNotConnectError));
+        QCOMPARE(protocol->setEntriesCallCount(), 0);
+        QVERIFY(protocol->accounts().isEmpty());
+    }
+};
+
+QTEST_MAIN(TestCreateEntriesJob)
+#include "test_createentriesjob.moc"
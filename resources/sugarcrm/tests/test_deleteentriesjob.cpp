@@ -0,0 +1,163 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <QTest>
+#include <AkonadiCore/Item>
+#include "sugaraccount.h"
+#include "sugarsession.h"
+#include "sugarmockprotocol.h"
+#include "deleteentriesjob.h"
+
+static Akonadi::Item::List accountItems(const QStringList &remoteIds)
+{
+    Akonadi::Item::List items;
+    for (const QString &remoteId : remoteIds) {
+        SugarAccount account;
+        account.setId(remoteId);
+        Akonadi::Item item;
+        item.setId(0);
+        item.setRemoteId(remoteId);
+        item.setPayload<SugarAccount>(account);
+        items.append(item);
+    }
+    return items;
+}
+
+static QStringList remoteIds(const Akonadi::Item::List &items)
+{
+    QStringList ids;
+    for (const Akonadi::Item &item : items) {
+        ids.append(item.remoteId());
+    }
+    return ids;
+}
+
+static bool isDeleted(SugarMockProtocol *protocol, const QString &id)
+{
+    const QVector<SugarAccount> accounts = protocol->accounts();
+    return std::any_of(accounts.begin(), accounts.end(), [&id](const SugarAccount &account) {
+        return account.id() == id && account.deleted() == QLatin1String("1");
+    });
+}
+
+class TestDeleteEntriesJob : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+
+    void shouldDeleteAllAccountsInBatches()
+    {
+        //GIVEN
+        auto *protocol = new SugarMockProtocol;
+        SugarSession session(nullptr);
+        session.setSessionParameters("user", "password", "hosttest");
+        protocol->addAccounts();
+        for (int i = 3; i < 10; ++i) {
+            protocol->addAccount(QStringLiteral("account%1").arg(i), QString::number(i));
+        }
+        session.setProtocol(protocol);
+        protocol->setSession(&session);
+        const QStringList ids{"0", "1", "2", "3", "4", "5", "6", "7", "8", "9"};
+        DeleteEntriesJob job(accountItems(ids), &session, Module::Accounts);
+        job.setBatchSize(4);
+        //WHEN
+        QVERIFY(job.exec());
+        //THEN
+        QCOMPARE(protocol->setEntriesCallCount(), 3);
+        QCOMPARE(protocol->setEntryCallCount(), 0);
+        QCOMPARE(remoteIds(job.deletedItems()), ids);
+        QVERIFY(job.failedItems().isEmpty());
+        for (const QString &id : ids) {
+            QVERIFY2(isDeleted(protocol, id), qPrintable(id));
+        }
+    }
+
+    void shouldReportUnknownEntriesIndividually()
+    {
+        //GIVEN
+        auto *protocol = new SugarMockProtocol;
+        SugarSession session(nullptr);
+        session.setSessionParameters("user", "password", "hosttest");
+        protocol->addAccounts();
+        session.setProtocol(protocol);
+        protocol->setSession(&session);
+        DeleteEntriesJob job(accountItems({"0", "5", "1", "6", "2"}), &session, Module::Accounts);
+        //WHEN
+        QVERIFY(!job.exec());
+        //THEN
+        QCOMPARE(job.error(), int(SugarJob::SoapError));
+        QCOMPARE(protocol->setEntriesCallCount(), 1);
+        QCOMPARE(protocol->setEntryCallCount(), 0);
+        QCOMPARE(remoteIds(job.deletedItems()), QStringList({"0", "1", "2"}));
+        QCOMPARE(remoteIds(job.failedItems()), QStringList({"5", "6"}));
+        QVERIFY(!job.errorMessage(job.failedItems().at(0)).isEmpty());
+        QVERIFY(job.errorMessage(job.deletedItems().at(0)).isEmpty());
+        QVERIFY(isDeleted(protocol, "0"));
+        QVERIFY(isDeleted(protocol, "1"));
+        QVERIFY(isDeleted(protocol, "2"));
+        QCOMPARE(protocol->accounts().size(), 3);
+    }
+
+    void shouldDeleteOneByOneWhenTheWholeRequestFails()
+    {
+        //GIVEN
+        auto *protocol = new SugarMockProtocol;
+        SugarSession session(nullptr);
+        session.setSessionParameters("user", "password", "hosttest");
+        protocol->addAccounts();
+        session.setProtocol(protocol);
+        protocol->setSession(&session);
+        protocol->setNextSoapError(QStringLiteral("Access Denied"));
+        DeleteEntriesJob job(accountItems({"0", "5", "2"}), &session, Module::Accounts);
+        //WHEN
+        QVERIFY(!job.exec());
+        //THEN
+        QCOMPARE(protocol->setEntriesCallCount(), 1);
+        QCOMPARE(protocol->setEntryCallCount(), 3);
+        QCOMPARE(remoteIds(job.deletedItems()), QStringList({"0", "2"}));
+        QCOMPARE(remoteIds(job.failedItems()), QStringList({"5"}));
+        QVERIFY(isDeleted(protocol, "0"));
+        QVERIFY(!isDeleted(protocol, "1"));
+        QVERIFY(isDeleted(protocol, "2"));
+    }
+
+    void shouldHandleCouldNotConnectError()
+    {
+        //GIVEN
+        auto *protocol = new SugarMockProtocol;
+        protocol->setServerNotFound(true);
+        SugarSession session(nullptr);
+        session.setSessionParameters("user", "password", "hosttest");
+        protocol->addAccounts();
+        session.setProtocol(protocol);
+        protocol->setSession(&session);
+        DeleteEntriesJob job(accountItems({"0", "1"}), &session, Module::Accounts);
+        //WHEN
+        QVERIFY(!job.exec());
+        //THEN
+        QCOMPARE(job.error(), int(SugarJob::CouldNotConnectError));
+        QCOMPARE(protocol->setEntriesCallCount(), 0);
+        QVERIFY(job.deletedItems().isEmpty());
+        QVERIFY(!isDeleted(protocol, "0"));
+    }
+};
+
+QTEST_MAIN(TestDeleteEntriesJob)
+#include "test_deleteentriesjob.moc"
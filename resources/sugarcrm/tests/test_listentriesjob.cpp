@@ -21,11 +21,13 @@
 #include <QTest>
 #include <QDebug>
 #include "sugarmockprotocol.h"
+#include "createentryjob.h"
 #include "listentriesjob.h"
 #include "accountshandler.h"
 #include "opportunitieshandler.h"
 #include "campaignshandler.h"
 #include "sugarsession.h"
+#include "updateentryjob.h"
 #include <QSignalSpy>
 #include <AkonadiCore/Item>
 
@@ -47,6 +49,29 @@ private:
         }
     }
 
+    // Lists the accounts modified since timestamp, returns the ids of the items which would be stored into Akonadi
+    QStringList listAccountIds(SugarSession *session, ModuleHandler *handler, const QString &timestamp, QString *newTimestamp,
+                               Akonadi::Item::List *items = nullptr)
+    {
+        Akonadi::Collection collection;
+        collection.setId(1);
+        auto *job = new ListEntriesJob(collection, session);
+        job->setModule(handler);
+        job->setLatestTimestamp(timestamp);
+        QStringList ids;
+        connect(job, &ListEntriesJob::itemsReceived, this, [&](const Akonadi::Item::List &received) {
+            for (const Akonadi::Item &item : received) {
+                ids.append(item.remoteId());
+                if (items)
+                    items->append(item);
+            }
+        });
+        if (!job->exec())
+            return QStringList() << QStringLiteral("error");
+        *newTimestamp = job->newTimestamp();
+        return ids;
+    }
+
 private Q_SLOTS:
 
     void initTestCase()
@@ -189,6 +214,107 @@ private Q_SLOTS:
         QCOMPARE(job->deletedItems().count(), 0);
     }
 
+    void shouldSkipEntriesWrittenByTheResource()
+    {
+        //GIVEN
+        auto *protocol = new SugarMockProtocol;
+        protocol->addAccounts();
+        SugarSession session(nullptr);
+        protocol->setSession(&session);
+        session.setProtocol(protocol);
+        session.setSessionParameters("user", "password", "hosttest");
+        AccountsHandler handler(&session);
+        QString timestamp;
+        Akonadi::Item::List items;
+        QCOMPARE(listAccountIds(&session, &handler, QString(), &timestamp, &items), QStringList() << "0" << "1" << "2");
+
+        //WHEN the user edits an account
+        Akonadi::Item item = items.at(1);
+        item.setId(1);
+        SugarAccount account = item.payload<SugarAccount>();
+        account.setName("accountOneEdited");
+        item.setPayload(account);
+        UpdateEntryJob updateJob(item, &session);
+        updateJob.setModule(&handler);
+        QVERIFY(updateJob.exec());
+        QCOMPARE(handler.localWriteCount(), 1);
+        QCOMPARE(updateJob.item().payload<SugarAccount>().dateModifiedRaw(), updateJob.item().remoteRevision());
+
+        //THEN the next listing doesn't bring it back into Akonadi
+        // ("2" is the entry with the previous timestamp, always listed again)
+        QString newTimestamp;
+        QCOMPARE(listAccountIds(&session, &handler, timestamp, &newTimestamp), QStringList() << "2");
+        QCOMPARE(newTimestamp, updateJob.item().remoteRevision());
+        QCOMPARE(handler.localWriteCount(), 0);
+
+        //WHEN someone else modifies it afterwards
+        protocol->updateAccount("accountOneRemote", "1");
+        //THEN it's listed again
+        items.clear();
+        QCOMPARE(listAccountIds(&session, &handler, newTimestamp, &timestamp, &items), QStringList() << "1");
+        QCOMPARE(items.at(0).payload<SugarAccount>().name(), QString("accountOneRemote"));
+    }
+
+    void shouldNotSkipEntriesInFullListings()
+    {
+        //GIVEN an account written by the resource
+        auto *protocol = new SugarMockProtocol;
+        protocol->addAccounts();
+        SugarSession session(nullptr);
+        protocol->setSession(&session);
+        session.setProtocol(protocol);
+        session.setSessionParameters("user", "password", "hosttest");
+        AccountsHandler handler(&session);
+        QString timestamp;
+        Akonadi::Item::List items;
+        QCOMPARE(listAccountIds(&session, &handler, QString(), &timestamp, &items).count(), 3);
+        Akonadi::Item item = items.at(1);
+        item.setId(1);
+        UpdateEntryJob updateJob(item, &session);
+        updateJob.setModule(&handler);
+        QVERIFY(updateJob.exec());
+        QCOMPARE(handler.localWriteCount(), 1);
+
+        //WHEN doing a full reload (no timestamp), which is a full sync in Akonadi
+        QString newTimestamp;
+        const QStringList ids = listAccountIds(&session, &handler, QString(), &newTimestamp);
+
+        //THEN the entry is listed, otherwise Akonadi would delete it
+        QCOMPARE(ids, QStringList() << "0" << "1" << "2");
+        QCOMPARE(handler.localWriteCount(), 0);
+    }
+
+    void shouldNotSkipEntriesModifiedAfterTheWrite()
+    {
+        //GIVEN an account created by the resource
+        auto *protocol = new SugarMockProtocol;
+        protocol->addAccounts();
+        SugarSession session(nullptr);
+        protocol->setSession(&session);
+        session.setProtocol(protocol);
+        session.setSessionParameters("user", "password", "hosttest");
+        AccountsHandler handler(&session);
+        QString timestamp;
+        QCOMPARE(listAccountIds(&session, &handler, QString(), &timestamp).count(), 3);
+        SugarAccount account;
+        account.setName("newAccount");
+        Akonadi::Item item;
+        item.setId(0);
+        item.setPayload<SugarAccount>(account);
+        CreateEntryJob createJob(item, &session);
+        createJob.setModule(&handler);
+        QVERIFY(createJob.exec());
+        QCOMPARE(handler.localWriteCount(), 1);
+
+        //WHEN someone else modifies it before the next listing
+        protocol->updateAccount("newAccountRemote", createJob.item().remoteId());
+
+        //THEN it's not skipped
+        QString newTimestamp;
+        QCOMPARE(listAccountIds(&session, &handler, timestamp, &newTimestamp), QStringList() << "2" << createJob.item().remoteId());
+        QCOMPARE(handler.localWriteCount(), 0);
+    }
+
     void shouldReturnSoapError()
     {
         Akonadi::Collection collection;
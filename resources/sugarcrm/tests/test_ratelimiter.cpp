@@ -0,0 +1,328 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "accountshandler.h"
+#include "listentriesjob.h"
+#include "ratelimitedprotocol.h"
+#include "ratelimiter.h"
+#include "sugarjob.h"
+#include "sugarmockprotocol.h"
+#include "sugarsession.h"
+
+#include <AkonadiCore/Item>
+
+#include <QSet>
+#include <QTest>
+
+// Time only moves when something sleeps
+class FakeClock : public RateLimiter::Clock
+{
+public:
+    qint64 currentMSecs() const override { return mNow; }
+    void sleep(int msecs) override { mNow += msecs; ++mSleepCount; }
+
+    qint64 mNow = 0;
+    int mSleepCount = 0;
+};
+
+// Answers some of the listing and writing calls as if the server throttled them
+class ThrottlingMockProtocol : public SugarMockProtocol
+{
+public:
+    int getEntriesCount(const ListEntriesScope &scope, Module moduleName, const QString &query, int &entriesCount, QString &errorMessage) override
+    {
+        if (throttle(errorMessage)) {
+            return mThrottledError;
+        }
+        // the mock lists the entries to count them
+        mNested = true;
+        const int result = SugarMockProtocol::getEntriesCount(scope, moduleName, query, entriesCount, errorMessage);
+        mNested = false;
+        return result;
+    }
+
+    int listEntries(const ListEntriesScope &scope, Module moduleName, const QString &query,
+                    const QString &orderBy, const QStringList &selectedFields, EntriesListResult &entriesListResult,
+                    QString &errorMessage) override
+    {
+        if (!mNested && throttle(errorMessage)) {
+            return mThrottledError;
+        }
+        return SugarMockProtocol::listEntries(scope, moduleName, query, orderBy, selectedFields, entriesListResult, errorMessage);
+    }
+
+    int setEntry(Module moduleName, const KDSoapGenerated::TNS__Name_value_list &nameValueList, QString &id, QString &errorMessage) override
+    {
+        if (throttle(errorMessage)) {
+            return mThrottledError;
+        }
+        return SugarMockProtocol::setEntry(moduleName, nameValueList, id, errorMessage);
+    }
+
+    int retryAfter() const override { return mRetryAfter; }
+
+    QSet<int> mThrottledCalls; // numbers of the calls (from 1) to throttle
+    int mThrottledError = SugarJob::ThrottledError; // HTTP 429, or ServiceUnavailableError for 503
+    int mRetryAfter = -1;
+    int mCallCount = 0;
+
+private:
+    bool throttle(QString &errorMessage)
+    {
+        if (mThrottledCalls.contains(++mCallCount)) {
+            errorMessage = QStringLiteral("Too Many Requests");
+            return true;
+        }
+        return false;
+    }
+
+    bool mNested = false;
+};
+
+class TestRateLimiter : public QObject
+{
+    Q_OBJECT
+
+private:
+    // Lists the accounts through a rate limited protocol, returns their ids
+    QStringList listAccountIds(SugarSession *session, int *error)
+    {
+        AccountsHandler handler(session);
+        Akonadi::Collection collection;
+        collection.setId(1);
+        auto *job = new ListEntriesJob(collection, session);
+        job->setModule(&handler);
+        QStringList ids;
+        connect(job, &ListEntriesJob::itemsReceived, this, [&](const Akonadi::Item::List &items) {
+            for (const Akonadi::Item &item : items) {
+                ids.append(item.remoteId());
+            }
+        });
+        job->exec();
+        *error = job->error();
+        return ids;
+    }
+
+private Q_SLOTS:
+
+    void initTestCase()
+    {
+        qRegisterMetaType<Akonadi::Item::List>("Akonadi::Item::List");
+    }
+
+    void shouldNotWaitWithoutLimit()
+    {
+        // GIVEN
+        auto *clock = new FakeClock;
+        RateLimiter limiter(clock);
+        // WHEN
+        for (int i = 0; i < 100; ++i) {
+            limiter.acquire();
+        }
+        // THEN
+        QCOMPARE(clock->mNow, qint64(0));
+        QCOMPARE(clock->mSleepCount, 0);
+    }
+
+    void shouldCapThroughput()
+    {
+        // GIVEN
+        auto *clock = new FakeClock;
+        RateLimiter limiter(clock);
+        limiter.setRate(10, 5);
+        // WHEN
+        for (int i = 0; i < 105; ++i) {
+            limiter.acquire();
+        }
+        // THEN the burst went through at once, then one request every 100ms
+        QCOMPARE(clock->mNow, qint64(10000));
+        QCOMPARE(limiter.totalWaitTime(), qint64(10000));
+    }
+
+    void shouldRefillWhileIdle()
+    {
+        // GIVEN
+        auto *clock = new FakeClock;
+        RateLimiter limiter(clock);
+        limiter.setRate(10, 5);
+        for (int i = 0; i < 5; ++i) {
+            limiter.acquire();
+        }
+        // WHEN idle for a second
+        clock->mNow += 1000;
+        for (int i = 0; i < 5; ++i) {
+            limiter.acquire();
+        }
+        // THEN the bucket was full again, but not more than full
+        QCOMPARE(clock->mSleepCount, 0);
+        limiter.acquire();
+        QCOMPARE(clock->mNow, qint64(1100));
+    }
+
+    void shouldBackOffExponentiallyWithJitter()
+    {
+        // GIVEN
+        auto *clock = new FakeClock;
+        RateLimiter limiter(clock);
+        limiter.setBackoff(1000, 8000, 5);
+        limiter.setJitterSeed(42);
+        for (int attempt = 0; attempt < 6; ++attempt) {
+            // WHEN
+            const qint64 before = clock->mNow;
+            const int delay = limiter.throttled(attempt, -1);
+            limiter.acquire();
+            // THEN
+            const int fullDelay = qMin(1000 << attempt, 8000);
+            QVERIFY2(delay >= fullDelay / 2 && delay <= fullDelay, qPrintable(QString::number(delay)));
+            QCOMPARE(clock->mNow - before, qint64(delay));
+            QCOMPARE(limiter.recommendedDelay(), delay);
+        }
+        limiter.succeeded();
+        QCOMPARE(limiter.recommendedDelay(), 0);
+    }
+
+    void shouldHonorServerDelay()
+    {
+        // GIVEN
+        auto *clock = new FakeClock;
+        RateLimiter limiter(clock);
+        limiter.setBackoff(1000, 8000, 5);
+        // WHEN the server asks for more than the backoff
+        QCOMPARE(limiter.throttled(0, 30000), 30000);
+        limiter.acquire();
+        // THEN
+        QCOMPARE(clock->mNow, qint64(30000));
+    }
+
+    void shouldRetryThrottledCallsWithoutLosingItems()
+    {
+        // GIVEN a server throttling the count, and the first two listing attempts
+        auto *mock = new ThrottlingMockProtocol;
+        mock->addData();
+        mock->mThrottledCalls = {1, 3, 4};
+        auto *clock = new FakeClock;
+        auto *protocol = new RateLimitedProtocol(mock, clock);
+        protocol->rateLimiter().setRate(2, 1);
+        protocol->rateLimiter().setBackoff(1000, 8000, 5);
+        SugarSession session(nullptr);
+        protocol->setSession(&session);
+        session.setProtocol(protocol);
+        session.setSessionParameters("user", "password", "hosttest");
+        // WHEN
+        int error = 0;
+        QStringList ids = listAccountIds(&session, &error);
+        // THEN
+        QCOMPARE(error, int(KJob::NoError));
+        ids.sort();
+        QCOMPARE(ids, QStringList() << "0" << "1" << "2");
+        QCOMPARE(mock->mCallCount, 5);
+        QCOMPARE(protocol->retryAfter(), -1);
+        // at least half of the 1s, 1s and 2s backoffs, and the rate limit between the 6 calls (with login)
+        QVERIFY2(clock->mNow >= 2000, qPrintable(QString::number(clock->mNow)));
+    }
+
+    void shouldRetryUnavailableReads()
+    {
+        // GIVEN a server answering 503 to the count and the first listing attempt
+        auto *mock = new ThrottlingMockProtocol;
+        mock->addData();
+        mock->mThrottledCalls = {1, 3};
+        mock->mThrottledError = SugarJob::ServiceUnavailableError;
+        auto *protocol = new RateLimitedProtocol(mock, new FakeClock);
+        protocol->rateLimiter().setBackoff(1000, 8000, 5);
+        SugarSession session(nullptr);
+        protocol->setSession(&session);
+        session.setProtocol(protocol);
+        session.setSessionParameters("user", "password", "hosttest");
+        // WHEN
+        int error = 0;
+        const QStringList ids = listAccountIds(&session, &error);
+        // THEN reading again was harmless
+        QCOMPARE(error, int(KJob::NoError));
+        QCOMPARE(ids.count(), 3);
+        QCOMPARE(mock->mCallCount, 4);
+    }
+
+    void shouldRetryThrottledWrites()
+    {
+        // GIVEN a server rejecting the first attempt with 429
+        auto *mock = new ThrottlingMockProtocol;
+        mock->mThrottledCalls = {1};
+        auto *protocol = new RateLimitedProtocol(mock, new FakeClock);
+        protocol->rateLimiter().setBackoff(1000, 8000, 5);
+        // WHEN
+        QString id;
+        QString errorMessage;
+        const int error = protocol->setEntry(Accounts, KDSoapGenerated::TNS__Name_value_list(), id, errorMessage);
+        // THEN
+        QCOMPARE(error, int(KJob::NoError));
+        QCOMPARE(mock->mCallCount, 2);
+        QCOMPARE(mock->setEntryCallCount(), 1);
+        delete protocol;
+    }
+
+    void shouldNotRetryUnavailableWrites()
+    {
+        // GIVEN a server (or proxy) answering 503, after maybe handling the request
+        auto *mock = new ThrottlingMockProtocol;
+        mock->mThrottledCalls = {1};
+        mock->mThrottledError = SugarJob::ServiceUnavailableError;
+        mock->mRetryAfter = 5000;
+        auto *protocol = new RateLimitedProtocol(mock, new FakeClock);
+        protocol->rateLimiter().setBackoff(1000, 8000, 5);
+        // WHEN
+        QString id;
+        QString errorMessage;
+        const int error = protocol->setEntry(Accounts, KDSoapGenerated::TNS__Name_value_list(), id, errorMessage);
+        // THEN the write is not sent again, the resource is told when to come back
+        QCOMPARE(error, int(SugarJob::ServiceUnavailableError));
+        QCOMPARE(mock->mCallCount, 1);
+        QCOMPARE(protocol->retryAfter(), 5000);
+        delete protocol;
+    }
+
+    void shouldGiveUpAndRecommendDelay()
+    {
+        // GIVEN a server throttling everything
+        auto *mock = new ThrottlingMockProtocol;
+        mock->addData();
+        mock->mThrottledCalls = {1, 2, 3, 4, 5};
+        mock->mRetryAfter = 20000;
+        auto *clock = new FakeClock;
+        auto *protocol = new RateLimitedProtocol(mock, clock);
+        protocol->rateLimiter().setBackoff(1000, 8000, 3);
+        SugarSession session(nullptr);
+        protocol->setSession(&session);
+        session.setProtocol(protocol);
+        session.setSessionParameters("user", "password", "hosttest");
+        // WHEN
+        int error = 0;
+        const QStringList ids = listAccountIds(&session, &error);
+        // THEN the job fails, and the resource is told when to come back
+        QCOMPARE(error, int(SugarJob::ThrottledError));
+        QVERIFY(ids.isEmpty());
+        QCOMPARE(mock->mCallCount, 4);
+        QCOMPARE(protocol->retryAfter(), 20000);
+        QCOMPARE(clock->mNow, qint64(3 * 20000));
+    }
+};
+
+QTEST_MAIN(TestRateLimiter)
+#include "test_ratelimiter.moc"
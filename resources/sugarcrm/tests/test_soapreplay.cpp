@@ -0,0 +1,267 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "accountshandler.h"
+#include "campaignshandler.h"
+#include "contactshandler.h"
+#include "documentshandler.h"
+#include "listentriesjob.h"
+#include "listmodulesjob.h"
+#include "loginjob.h"
+#include "modulename.h"
+#include "opportunitieshandler.h"
+#include "soaprecording.h"
+#include "sugarrecordingproxy.h"
+#include "sugarreplayserver.h"
+#include "sugarsession.h"
+#include "sugarsoapprotocol.h"
+#include "sugarstandinserver.h"
+
+#include <AkonadiCore/Item>
+
+#include <QSet>
+#include <QTemporaryDir>
+#include <QTest>
+
+// What the resource does on a first sync: login, list the modules, get their fields, then list their entries
+class FullSync
+{
+public:
+    explicit FullSync(const QString &host, const QString &user = QStringLiteral("user"), const QString &password = QStringLiteral("password"))
+        : mSession(nullptr)
+    {
+        mSession.setSessionParameters(user, password, host);
+        mSession.createSoapInterface();
+        auto *protocol = new SugarSoapProtocol;
+        mSession.setProtocol(protocol);
+        protocol->setSession(&mSession);
+        mHandlers << new AccountsHandler(&mSession)
+                  << new OpportunitiesHandler(&mSession)
+                  << new ContactsHandler(&mSession)
+                  << new CampaignsHandler(&mSession)
+                  << new DocumentsHandler(&mSession);
+    }
+
+    ~FullSync()
+    {
+        qDeleteAll(mHandlers);
+    }
+
+    // Lists the entries modified since the timestamp (all of them if empty), stops at the first error
+    bool run(const QString &timestamp = QString())
+    {
+        LoginJob loginJob(&mSession);
+        if (!loginJob.exec()) {
+            mErrorString = loginJob.errorString();
+            return false;
+        }
+        ListModulesJob modulesJob(&mSession);
+        if (!modulesJob.exec()) {
+            mErrorString = modulesJob.errorString();
+            return false;
+        }
+        for (int i = 0; i < mHandlers.count(); ++i) {
+            ModuleHandler *handler = mHandlers.at(i);
+            const QString moduleName = moduleToName(handler->module());
+            if (!modulesJob.modules().contains(moduleName)) {
+                continue;
+            }
+            Akonadi::Collection collection = handler->collection();
+            collection.setId(i + 1);
+            handler->parseFieldList(collection, ModuleHandler::listAvailableFields(&mSession, moduleName));
+
+            auto *job = new ListEntriesJob(collection, &mSession);
+            job->setModule(handler);
+            job->setLatestTimestamp(timestamp);
+            QObject::connect(job, &ListEntriesJob::itemsReceived, [this, moduleName](const Akonadi::Item::List &items) {
+                mItemCounts[moduleName] += items.count();
+            });
+            if (!job->exec()) {
+                mErrorString = job->errorString();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    QString errorString() const { return mErrorString; }
+    QMap<QString, int> itemCounts() const { return mItemCounts; }
+
+private:
+    SugarSession mSession;
+    QList<ModuleHandler *> mHandlers;
+    QMap<QString, int> mItemCounts;
+    QString mErrorString;
+};
+
+/**
+ * Replays a recorded full sync of several modules through the real SOAP protocol, session and jobs.
+ *
+ * data/fullsync.jsonl is a full sync of accounts (two pages), opportunities (with the currencies
+ * and the linked contacts) and contacts. This fails when the calls made by the resource change
+ * (more or fewer calls, other order, other arguments). If that change is wanted, record a new
+ * full sync through SugarRecordingProxy against a SugarCRM server:
+ *   FATCRM_SOAP_RECORD=<file> FATCRM_SOAP_RECORD_HOST=<url> FATCRM_SOAP_RECORD_USER=<user> FATCRM_SOAP_RECORD_PASSWORD=<password> test_soapreplay
+ * then replace data/fullsync.jsonl with it, after removing any confidential data.
+ */
+class TestSoapReplay : public QObject
+{
+    Q_OBJECT
+
+private:
+    SugarReplayServer mServer;
+    QString mRecordingFile;
+
+    // Records a full sync against the server given in the environment, see the class documentation
+    void recordFullSync(const QString &fileName)
+    {
+        SugarRecordingProxy proxy(qEnvironmentVariable("FATCRM_SOAP_RECORD_HOST"));
+        QVERIFY(proxy.setRecordingFile(fileName));
+        QVERIFY(proxy.start());
+        FullSync sync(proxy.hostUrl(), qEnvironmentVariable("FATCRM_SOAP_RECORD_USER"), qEnvironmentVariable("FATCRM_SOAP_RECORD_PASSWORD"));
+        QVERIFY2(sync.run(), qPrintable(sync.errorString()));
+        qDebug() << "Recorded" << proxy.recordedCount() << "calls into" << fileName << "items:" << sync.itemCounts();
+    }
+
+private Q_SLOTS:
+
+    void initTestCase()
+    {
+        qRegisterMetaType<Akonadi::Item::List>("Akonadi::Item::List");
+        if (qEnvironmentVariableIsSet("FATCRM_SOAP_RECORD")) {
+            mRecordingFile = qEnvironmentVariable("FATCRM_SOAP_RECORD");
+            recordFullSync(mRecordingFile);
+        } else {
+            mRecordingFile = QFINDTESTDATA("data/fullsync.jsonl");
+        }
+        QVERIFY(!mRecordingFile.isEmpty());
+        QVERIFY(mServer.start());
+    }
+
+    // Each test starts from the beginning of the recording, with no mismatches
+    void init()
+    {
+        QString errorMessage;
+        QVERIFY2(mServer.load(mRecordingFile, &errorMessage), qPrintable(errorMessage));
+    }
+
+    void shouldRecordThroughTheProxy()
+    {
+        // GIVEN a stand-in server with a few entries, and a proxy in front of it
+        SugarStandInServer standIn;
+        QStringList accountIds;
+        for (int i = 0; i < 150; ++i) { // two pages
+            accountIds << standIn.addEntry(moduleToName(Accounts), {{QStringLiteral("name"), QStringLiteral("Account %1").arg(i)}});
+        }
+        for (int i = 0; i < 5; ++i) {
+            const QString documentId = standIn.addEntry(moduleToName(Documents), {{QStringLiteral("document_name"), QStringLiteral("Document %1").arg(i)}});
+            standIn.setRelated(moduleToName(Documents), documentId, QStringLiteral("accounts"), {accountIds.at(i)}, false);
+        }
+        QVERIFY(standIn.start());
+        SugarRecordingProxy proxy(standIn.hostUrl());
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString fileName = dir.filePath(QStringLiteral("standin.jsonl"));
+        QVERIFY(proxy.setRecordingFile(fileName));
+        QVERIFY(proxy.start());
+
+        // WHEN
+        FullSync sync(proxy.hostUrl());
+        QVERIFY2(sync.run(), qPrintable(sync.errorString()));
+
+        // THEN every call was forwarded and recorded, without the credentials
+        QCOMPARE(sync.itemCounts().value(moduleToName(Accounts)), 150);
+        QCOMPARE(sync.itemCounts().value(moduleToName(Documents)), 5);
+        const QVector<SoapCall> calls = SoapRecording::load(fileName);
+        QCOMPARE(calls.count(), proxy.recordedCount());
+        QCOMPARE(calls.first().method, QStringLiteral("login"));
+        QVERIFY(!calls.first().request.contains(QStringLiteral("user_auth")));
+        QSet<QString> methods;
+        for (const SoapCall &call : calls) {
+            methods.insert(call.method);
+            QCOMPARE(call.faultCode, 0);
+        }
+        for (const char *method : {"get_available_modules", "get_module_fields", "get_entries_count", "get_entry_list", "get_relationships"}) {
+            QVERIFY2(methods.contains(QLatin1String(method)), method);
+        }
+
+        // AND THEN the recording can be replayed
+        SugarReplayServer replay;
+        QVERIFY(replay.load(fileName));
+        QVERIFY(replay.start());
+        FullSync replayedSync(replay.hostUrl());
+        QVERIFY2(replayedSync.run(), qPrintable(replayedSync.errorString()));
+        QVERIFY2(replay.mismatches().isEmpty(), qPrintable(replay.mismatches().join(QLatin1Char('\n'))));
+        QCOMPARE(replay.replayedCount(), replay.callCount());
+        QCOMPARE(replayedSync.itemCounts(), sync.itemCounts());
+    }
+
+    void shouldReplayFullSync()
+    {
+        // GIVEN
+        FullSync sync(mServer.hostUrl());
+        // WHEN
+        const bool ok = sync.run();
+        // THEN
+        QVERIFY2(mServer.mismatches().isEmpty(), qPrintable(mServer.mismatches().join(QLatin1Char('\n'))));
+        QVERIFY2(ok, qPrintable(sync.errorString()));
+        QCOMPARE(mServer.replayedCount(), mServer.callCount());
+        if (!qEnvironmentVariableIsSet("FATCRM_SOAP_RECORD")) {
+            const QMap<QString, int> expectedCounts = {
+                {moduleToName(Accounts), 120},
+                {moduleToName(Opportunities), 3},
+                {moduleToName(Contacts), 2}
+            };
+            QCOMPARE(sync.itemCounts(), expectedCounts);
+        }
+    }
+
+    void shouldReportUnexpectedCalls()
+    {
+        // GIVEN a recording which was entirely replayed
+        FullSync sync(mServer.hostUrl());
+        QVERIFY2(sync.run(), qPrintable(sync.errorString()));
+        // WHEN
+        QVERIFY(!sync.run());
+        // THEN
+        QCOMPARE(mServer.replayedCount(), mServer.callCount());
+        QCOMPARE(mServer.mismatches().count(), 1);
+        QVERIFY2(mServer.mismatches().first().contains(QLatin1String("after the end of the recording")),
+                 qPrintable(mServer.mismatches().first()));
+    }
+
+    void shouldReportChangedCalls()
+    {
+        // GIVEN
+        FullSync sync(mServer.hostUrl());
+        // WHEN listing only the changes, which is not what was recorded
+        QVERIFY(!sync.run(QStringLiteral("2021-03-01 12:00:00")));
+        // THEN
+        QVERIFY(mServer.replayedCount() < mServer.callCount());
+        QCOMPARE(mServer.mismatches().count(), 1);
+        QVERIFY2(mServer.mismatches().first().contains(QLatin1String("get_entries_count")),
+                 qPrintable(mServer.mismatches().first()));
+        QVERIFY2(mServer.mismatches().first().contains(QLatin1String("2021-03-01 12:00:00")),
+                 qPrintable(mServer.mismatches().first()));
+    }
+};
+
+QTEST_MAIN(TestSoapReplay)
+#include "test_soapreplay.moc"
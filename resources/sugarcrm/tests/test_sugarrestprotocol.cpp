@@ -0,0 +1,456 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "accountshandler.h"
+#include "createentryjob.h"
+#include "fetchentryjob.h"
+#include "listentriesjob.h"
+#include "listmodulesjob.h"
+#include "loginjob.h"
+#include "ratelimitedprotocol.h"
+#include "sugaraccount.h"
+#include "sugarjob.h"
+#include "sugarreststandinserver.h"
+#include "sugarrestprotocol.h"
+#include "sugarsession.h"
+#include "sugarstandinserver.h"
+
+#include <AkonadiCore/Item>
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTest>
+
+/**
+ * Runs SugarRestProtocol, with the real session and jobs, against SugarRestStandInServer.
+ */
+class TestSugarRestProtocol : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestSugarRestProtocol()
+        : mServer(&mDataset),
+          mSession(nullptr)
+    {
+    }
+
+private:
+    SugarStandInServer mDataset; // serves the data, and SOAP for shouldOpenASoapSessionForTheSoapCalls
+    SugarRestStandInServer mServer;
+    SugarSession mSession;
+    SugarRestProtocol *mProtocol = nullptr;
+    QScopedPointer<AccountsHandler> mAccountsHandler;
+    QString mTimestamp;
+
+    QString addAccount(const QString &name)
+    {
+        SugarAccount account;
+        account.setName(name);
+        return mDataset.addEntry(moduleToName(Accounts), AccountsHandler::sugarAccountToNameValueList(account));
+    }
+
+    void listAccounts(QStringList &names, QStringList &deletedIds)
+    {
+        Akonadi::Collection collection;
+        collection.setId(1);
+        auto *job = new ListEntriesJob(collection, &mSession);
+        job->setModule(mAccountsHandler.data());
+        job->setLatestTimestamp(mTimestamp);
+        connect(job, &ListEntriesJob::itemsReceived, this, [&](const Akonadi::Item::List &items) {
+            for (const Akonadi::Item &item : items) {
+                names.append(item.payload<SugarAccount>().name());
+            }
+        });
+        QVERIFY2(job->exec(), qPrintable(job->errorString()));
+        const Akonadi::Item::List deletedItems = job->deletedItems();
+        for (const Akonadi::Item &item : deletedItems) {
+            deletedIds.append(item.remoteId());
+        }
+        mTimestamp = job->newTimestamp();
+    }
+
+private Q_SLOTS:
+
+    void initTestCase()
+    {
+        qRegisterMetaType<Akonadi::Item::List>("Akonadi::Item::List");
+        QVERIFY(mServer.start());
+
+        mSession.setSessionParameters(QStringLiteral("user"), QStringLiteral("password"), mServer.hostUrl());
+        mProtocol = new SugarRestProtocol;
+        mSession.setProtocol(mProtocol);
+        mProtocol->setSession(&mSession);
+        mAccountsHandler.reset(new AccountsHandler(&mSession));
+    }
+
+    void shouldTranslateQueries_data()
+    {
+        QTest::addColumn<QString>("query");
+        QTest::addColumn<QString>("expectedFilter");
+
+        QTest::newRow("empty") << QString() << "[]";
+        QTest::newRow("timestamp") << "accounts.date_modified >= '2021-03-01 10:00:00'"
+                                   << R"([{"date_modified":{"$gte":"2021-03-01T10:00:00+00:00"}}])";
+        QTest::newRow("or_and") << "( notes.parent_type='Accounts' or notes.parent_type='Contacts' ) AND notes.date_modified >= '2021-03-01 10:00:00'"
+                                << R"([{"$or":[{"parent_type":{"$equals":"Accounts"}},{"parent_type":{"$equals":"Contacts"}}]},)"
+                                   R"({"date_modified":{"$gte":"2021-03-01T10:00:00+00:00"}}])";
+        QTest::newRow("precedence") << "a=1 or b<>'x' and c<'2'"
+                                    << R"([{"$or":[{"a":{"$equals":"1"}},{"$and":[{"b":{"$not_equals":"x"}},{"c":{"$lt":"2"}}]}]}])";
+        QTest::newRow("quote") << "name = 'O''Brien'" << R"([{"name":{"$equals":"O'Brien"}}])";
+    }
+
+    void shouldTranslateQueries()
+    {
+        QFETCH(QString, query);
+        QFETCH(QString, expectedFilter);
+        QJsonArray filter;
+        QString errorMessage;
+        QVERIFY2(SugarRestProtocol::queryToFilter(query, filter, errorMessage), qPrintable(errorMessage));
+        QCOMPARE(QString::fromUtf8(QJsonDocument(filter).toJson(QJsonDocument::Compact)), expectedFilter);
+    }
+
+    void shouldRejectUnsupportedQueries_data()
+    {
+        QTest::addColumn<QString>("query");
+
+        QTest::newRow("like") << "name like 'KDAB%'";
+        QTest::newRow("unterminated") << "name = 'KDAB";
+        QTest::newRow("parenthesis") << "( name = 'KDAB'";
+    }
+
+    void shouldRejectUnsupportedQueries()
+    {
+        QFETCH(QString, query);
+        QJsonArray filter;
+        QString errorMessage;
+        QVERIFY(!SugarRestProtocol::queryToFilter(query, filter, errorMessage));
+        QVERIFY(errorMessage.contains(query));
+    }
+
+    void shouldConvertOrderBy()
+    {
+        QCOMPARE(SugarRestProtocol::orderByToRest(QStringLiteral("accounts.name")), QStringLiteral("name:asc"));
+        QCOMPARE(SugarRestProtocol::orderByToRest(QStringLiteral("date_modified DESC")), QStringLiteral("date_modified:desc"));
+        QCOMPARE(SugarRestProtocol::orderByToRest(QString()), QString());
+    }
+
+    void shouldConvertRecords()
+    {
+        // GIVEN
+        const QJsonObject record = QJsonDocument::fromJson(R"({"id":"abc","name":"KDAB","deleted":false,"annual_revenue":null,)"
+                                                           R"("employees":42,"date_modified":"2021-03-01T12:00:00+02:00",)"
+                                                           R"("date_entered":"2021-03-01T10:00:00+00:00","_acl":{"fields":{}},)"
+                                                           R"("email":[{"email_address":"info@kdab.com"}],"_module":"Accounts"})").object();
+        // WHEN
+        const KDSoapGenerated::TNS__Entry_value entry = SugarRestProtocol::recordToEntry(record, QStringLiteral("Accounts"), {});
+        // THEN
+        QCOMPARE(entry.id(), QStringLiteral("abc"));
+        QCOMPARE(entry.module_name(), QStringLiteral("Accounts"));
+        QMap<QString, QString> fields;
+        const auto items = entry.name_value_list().items();
+        for (const KDSoapGenerated::TNS__Name_value &nameValue : items) {
+            fields.insert(nameValue.name(), nameValue.value());
+        }
+        QCOMPARE(fields.keys(), QStringList({"annual_revenue", "date_entered", "date_modified", "deleted", "employees", "id", "name"}));
+        QCOMPARE(fields.value("date_modified"), QStringLiteral("2021-03-01 10:00:00"));
+        QCOMPARE(fields.value("date_entered"), QStringLiteral("2021-03-01 10:00:00"));
+        QCOMPARE(fields.value("deleted"), QStringLiteral("0"));
+        QCOMPARE(fields.value("employees"), QStringLiteral("42"));
+        QCOMPARE(fields.value("annual_revenue"), QString());
+
+        // AND WHEN selecting fields
+        const auto selected = SugarRestProtocol::recordToEntry(record, QStringLiteral("Accounts"), {"name", "id", "missing"}).name_value_list().items();
+        // THEN
+        QCOMPARE(selected.count(), 2);
+        QCOMPARE(selected.at(0).name(), QStringLiteral("name"));
+        QCOMPARE(selected.at(1).name(), QStringLiteral("id"));
+    }
+
+    void shouldRejectWrongPassword()
+    {
+        // GIVEN
+        SugarSession session(nullptr);
+        session.setSessionParameters(QStringLiteral("user"), QStringLiteral("wrong"), mServer.hostUrl());
+        auto *protocol = new SugarRestProtocol;
+        session.setProtocol(protocol);
+        protocol->setSession(&session);
+        // WHEN
+        LoginJob job(&session);
+        // THEN
+        QVERIFY(!job.exec());
+        QCOMPARE(job.error(), int(SugarJob::LoginError));
+        QVERIFY(session.sessionId().isEmpty());
+    }
+
+    void shouldLogin()
+    {
+        LoginJob job(&mSession);
+        QVERIFY2(job.exec(), qPrintable(job.errorString()));
+        QVERIFY(mDataset.isValidSession(mSession.sessionId()));
+    }
+
+    void shouldListModules()
+    {
+        ListModulesJob job(&mSession);
+        QVERIFY2(job.exec(), qPrintable(job.errorString()));
+        QVERIFY(job.modules().contains(moduleToName(Accounts)));
+        QVERIFY(job.modules().contains(moduleToName(Opportunities)));
+    }
+
+    void shouldListAllAccountsInPages()
+    {
+        // GIVEN
+        for (int i = 0; i < 250; ++i) {
+            addAccount(QStringLiteral("Account %1").arg(i));
+        }
+        mServer.resetRequestCounts();
+        // WHEN
+        QStringList names, deletedIds;
+        listAccounts(names, deletedIds);
+        // THEN
+        QCOMPARE(names.count(), 250);
+        QCOMPARE(names.first(), QStringLiteral("Account 0"));
+        QCOMPARE(names.last(), QStringLiteral("Account 249"));
+        QVERIFY(deletedIds.isEmpty());
+        QCOMPARE(mServer.requestCount(QStringLiteral("count")), 1);
+        QCOMPARE(mServer.requestCount(QStringLiteral("filter")), 3);
+        QVERIFY(mServer.connectionCount() <= 1); // kept alive
+        QCOMPARE(mTimestamp, mDataset.lastTimestamp());
+    }
+
+    void shouldListOnlyChangesSinceLastListing()
+    {
+        // GIVEN
+        const QString updatedId = addAccount(QStringLiteral("To be updated"));
+        const QString deletedId = addAccount(QStringLiteral("To be deleted"));
+        QStringList names, deletedIds;
+        listAccounts(names, deletedIds);
+        QMap<QString, QString> fields;
+        fields.insert(QStringLiteral("name"), QStringLiteral("Updated"));
+        QVERIFY(mDataset.updateEntry(moduleToName(Accounts), updatedId, fields));
+        QVERIFY(mDataset.deleteEntry(moduleToName(Accounts), deletedId));
+        // WHEN
+        names.clear();
+        listAccounts(names, deletedIds);
+        // THEN
+        QCOMPARE(names, QStringList() << QStringLiteral("Updated"));
+        QCOMPARE(deletedIds, QStringList() << deletedId);
+    }
+
+    void shouldCreateAndFetchAccount()
+    {
+        // GIVEN
+        SugarAccount account;
+        account.setName(QStringLiteral("Created"));
+        Akonadi::Item item;
+        item.setPayload<SugarAccount>(account);
+        CreateEntryJob createJob(item, &mSession);
+        createJob.setModule(mAccountsHandler.data());
+        // WHEN
+        QVERIFY2(createJob.exec(), qPrintable(createJob.errorString()));
+        // THEN
+        const QString id = createJob.item().remoteId();
+        QVERIFY(!id.isEmpty());
+        QCOMPARE(createJob.item().remoteRevision(), mDataset.lastTimestamp());
+        QCOMPARE(mDataset.entry(moduleToName(Accounts), id).value(QStringLiteral("name")), QStringLiteral("Created"));
+
+        // AND WHEN
+        Akonadi::Item fetchItem;
+        fetchItem.setRemoteId(id);
+        FetchEntryJob fetchJob(fetchItem, &mSession);
+        fetchJob.setModule(mAccountsHandler.data());
+        QVERIFY2(fetchJob.exec(), qPrintable(fetchJob.errorString()));
+        // THEN
+        QCOMPARE(fetchJob.item().payload<SugarAccount>().name(), QStringLiteral("Created"));
+    }
+
+    void shouldLinkAndUnlinkItems()
+    {
+        // GIVEN
+        const QString accountId = addAccount(QStringLiteral("Linked"));
+        const QStringList contactIds = {QStringLiteral("contact1"), QStringLiteral("contact2")};
+        QString errorMessage;
+        // WHEN
+        QCOMPARE(mProtocol->setRelationship(accountId, Accounts, contactIds, Contacts, false, errorMessage), int(KJob::NoError));
+        // THEN
+        SugarProtocolBase::GetRelationShipsResult result = mProtocol->getRelationships(accountId, Accounts, Contacts);
+        QCOMPARE(result.errorCode, int(KJob::NoError));
+        result.ids.sort();
+        QCOMPARE(result.ids, contactIds);
+
+        // AND WHEN
+        QCOMPARE(mProtocol->setRelationship(accountId, Accounts, {QStringLiteral("contact1")}, Contacts, true, errorMessage), int(KJob::NoError));
+        // THEN
+        QCOMPARE(mProtocol->getRelationships(accountId, Accounts, Contacts).ids, QStringList() << QStringLiteral("contact2"));
+    }
+
+    void shouldLoginAgainWhenTheTokenExpired()
+    {
+        // GIVEN
+        const QString oldToken = mSession.sessionId();
+        mDataset.closeSession(oldToken);
+        // WHEN
+        QStringList names, deletedIds;
+        listAccounts(names, deletedIds);
+        // THEN
+        QVERIFY(mSession.sessionId() != oldToken);
+        QVERIFY(mDataset.isValidSession(mSession.sessionId()));
+    }
+
+    void shouldOpenASoapSessionForTheSoapCalls()
+    {
+        // GIVEN a REST session, on a host also serving SOAP
+        QVERIFY(mDataset.start());
+        SugarSession session(nullptr);
+        session.setSessionParameters(QStringLiteral("user"), QStringLiteral("password"), mDataset.hostUrl());
+        session.createSoapInterface();
+        auto *protocol = new RateLimitedProtocol(new SugarRestProtocol);
+        session.setProtocol(protocol);
+        protocol->setSession(&session);
+        session.setSessionId(QStringLiteral("oauth-token"));
+        // WHEN
+        const QString soapSessionId = session.soapSessionId();
+        // THEN a SOAP login happened, and its session is kept
+        QVERIFY(mDataset.isValidSession(soapSessionId));
+        QCOMPARE(session.soapSessionId(), soapSessionId);
+        QCOMPARE(session.sessionId(), QStringLiteral("oauth-token"));
+        // AND forgotten with the REST session
+        session.forgetSession();
+        const QString newSoapSessionId = session.soapSessionId();
+        QVERIFY(mDataset.isValidSession(newSoapSessionId));
+        QVERIFY(newSoapSessionId != soapSessionId);
+    }
+
+    void shouldTimeOutWhenTheServerDoesNotReply()
+    {
+        // GIVEN a server which accepts connections but never replies
+        QTcpServer silentServer;
+        QVERIFY(silentServer.listen(QHostAddress::LocalHost));
+        SugarSession session(nullptr);
+        session.setSessionParameters(QStringLiteral("user"), QStringLiteral("password"),
+                                     QStringLiteral("http://127.0.0.1:%1").arg(silentServer.serverPort()));
+        auto *protocol = new SugarRestProtocol;
+        session.setProtocol(protocol);
+        protocol->setSession(&session);
+        protocol->setTimeout(200);
+        // WHEN
+        QString sessionId, errorMessage;
+        const int result = protocol->login(QStringLiteral("user"), QStringLiteral("password"), sessionId, errorMessage);
+        // THEN
+        QCOMPARE(result, int(SugarJob::CouldNotConnectError));
+        QVERIFY(sessionId.isEmpty());
+        QVERIFY(!errorMessage.isEmpty());
+    }
+
+    void shouldForgetTheRetryAfterOfThePreviousReply()
+    {
+        // GIVEN a server which throttles the first request, then stops replying
+        QTcpServer server;
+        QVERIFY(server.listen(QHostAddress::LocalHost));
+        int requests = 0;
+        connect(&server, &QTcpServer::newConnection, this, [&]() {
+            QTcpSocket *socket = server.nextPendingConnection();
+            connect(socket, &QTcpSocket::readyRead, socket, [&requests, socket]() {
+                socket->readAll();
+                if (++requests == 1) {
+                    socket->write("HTTP/1.1 429 Too Many Requests\r\nRetry-After: 7\r\n"
+                                  "Content-Type: application/json\r\nContent-Length: 2\r\n\r\n{}");
+                }
+            });
+        });
+        SugarSession session(nullptr);
+        session.setSessionParameters(QStringLiteral("user"), QStringLiteral("password"),
+                                     QStringLiteral("http://127.0.0.1:%1").arg(server.serverPort()));
+        auto *protocol = new SugarRestProtocol;
+        session.setProtocol(protocol);
+        protocol->setSession(&session);
+        protocol->setTimeout(200);
+        QString sessionId, errorMessage;
+        QCOMPARE(protocol->login(QStringLiteral("user"), QStringLiteral("password"), sessionId, errorMessage),
+                 int(SugarJob::ThrottledError));
+        QCOMPARE(protocol->retryAfter(), 7000);
+        // WHEN the next request times out
+        const int result = protocol->login(QStringLiteral("user"), QStringLiteral("password"), sessionId, errorMessage);
+        // THEN the delay of the throttled request isn't reported for it
+        QCOMPARE(result, int(SugarJob::CouldNotConnectError));
+        QCOMPARE(protocol->retryAfter(), -1);
+    }
+
+    void shouldUseOneConnectionForAFullSync_data()
+    {
+        QTest::addColumn<bool>("compression");
+
+        QTest::newRow("gzip") << true;
+        QTest::newRow("identity") << false;
+    }
+
+    void shouldUseOneConnectionForAFullSync()
+    {
+        QFETCH(bool, compression);
+        // GIVEN a new session, without any open connection
+        SugarSession session(nullptr);
+        session.setSessionParameters(QStringLiteral("user"), QStringLiteral("password"), mServer.hostUrl());
+        auto *protocol = new SugarRestProtocol;
+        session.setProtocol(protocol);
+        protocol->setSession(&session);
+        AccountsHandler accountsHandler(&session);
+        mServer.setCompressionEnabled(compression);
+        mServer.resetRequestCounts();
+        // WHEN
+        LoginJob loginJob(&session);
+        QVERIFY2(loginJob.exec(), qPrintable(loginJob.errorString()));
+        Akonadi::Collection collection;
+        collection.setId(1);
+        auto *job = new ListEntriesJob(collection, &session);
+        job->setModule(&accountsHandler);
+        QStringList names;
+        connect(job, &ListEntriesJob::itemsReceived, this, [&](const Akonadi::Item::List &items) {
+            for (const Akonadi::Item &item : items) {
+                names.append(item.payload<SugarAccount>().name());
+            }
+        });
+        QVERIFY2(job->exec(), qPrintable(job->errorString()));
+        mServer.setCompressionEnabled(true);
+        // THEN all replies were decoded
+        QVERIFY(names.contains(QStringLiteral("Account 0")));
+        QVERIFY(names.contains(QStringLiteral("Account 249")));
+        QVERIFY(names.contains(QStringLiteral("Updated")));
+        // AND came through the same connection
+        const SugarSession::TrafficStatistics statistics = session.trafficStatistics();
+        QVERIFY(statistics.requests >= 5); // token, count, 3 pages
+        QCOMPARE(mServer.connectionCount(), 1);
+        QCOMPARE(mServer.compressedResponseCount(), compression ? statistics.requests : 0);
+        QCOMPARE(statistics.compressedReplies, compression ? statistics.requests : 0);
+        QVERIFY(statistics.requestBodyBytes > 0);
+        if (compression) {
+            QVERIFY2(mServer.bytesSent() < statistics.decodedReplyBytes,
+                     qPrintable(QStringLiteral("%1 bytes sent for %2 bytes of JSON").arg(mServer.bytesSent()).arg(statistics.decodedReplyBytes)));
+        } else {
+            QVERIFY(mServer.bytesSent() > statistics.decodedReplyBytes); // headers
+        }
+    }
+};
+
+QTEST_MAIN(TestSugarRestProtocol)
+#include "test_sugarrestprotocol.moc"
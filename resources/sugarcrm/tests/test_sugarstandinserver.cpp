@@ -0,0 +1,284 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "accountshandler.h"
+#include "createentryjob.h"
+#include "fetchentryjob.h"
+#include "listentriesjob.h"
+#include "listentriesscope.h"
+#include "listmodulesjob.h"
+#include "loginjob.h"
+#include "sugaraccount.h"
+#include "sugarjob.h"
+#include "sugarsession.h"
+#include "sugarsoapprotocol.h"
+#include "sugarstandinserver.h"
+
+#include <config-kdsoap.h>
+
+#include <AkonadiCore/Item>
+
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <QTest>
+
+/**
+ * Runs the real SOAP protocol, session and jobs against SugarStandInServer.
+ * Unlike test_jobwithsugarsoapprotocol, this needs no SugarCRM installation.
+ */
+class TestSugarStandInServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestSugarStandInServer()
+        : mSession(nullptr)
+    {
+    }
+
+private:
+    SugarStandInServer mServer;
+    SugarSession mSession;
+    SugarSoapProtocol *mProtocol = nullptr;
+    QScopedPointer<AccountsHandler> mAccountsHandler;
+    QString mTimestamp;
+
+    QString addAccount(const QString &name)
+    {
+        SugarAccount account;
+        account.setName(name);
+        return mServer.addEntry(moduleToName(Accounts), AccountsHandler::sugarAccountToNameValueList(account));
+    }
+
+    // Lists the accounts modified since timestamp, returns the names of the received and of the deleted ones
+    void listAccounts(QStringList &names, QStringList &deletedIds)
+    {
+        Akonadi::Collection collection;
+        collection.setId(1);
+        auto *job = new ListEntriesJob(collection, &mSession);
+        job->setModule(mAccountsHandler.data());
+        job->setLatestTimestamp(mTimestamp);
+        connect(job, &ListEntriesJob::itemsReceived, this, [&](const Akonadi::Item::List &items) {
+            for (const Akonadi::Item &item : items) {
+                names.append(item.payload<SugarAccount>().name());
+            }
+        });
+        QVERIFY2(job->exec(), qPrintable(job->errorString()));
+        const Akonadi::Item::List deletedItems = job->deletedItems();
+        for (const Akonadi::Item &item : deletedItems) {
+            deletedIds.append(item.remoteId());
+        }
+        mTimestamp = job->newTimestamp();
+    }
+
+private Q_SLOTS:
+
+    void initTestCase()
+    {
+        qRegisterMetaType<Akonadi::Item::List>("Akonadi::Item::List");
+        QVERIFY(mServer.start());
+
+        mSession.setSessionParameters(QStringLiteral("user"), QStringLiteral("password"), mServer.hostUrl());
+        mSession.createSoapInterface();
+        mProtocol = new SugarSoapProtocol;
+        mSession.setProtocol(mProtocol);
+        mProtocol->setSession(&mSession);
+        mAccountsHandler.reset(new AccountsHandler(&mSession));
+    }
+
+    void shouldRejectWrongPassword()
+    {
+        // GIVEN
+        SugarSession session(nullptr);
+        session.setSessionParameters(QStringLiteral("user"), QStringLiteral("wrong"), mServer.hostUrl());
+        session.createSoapInterface();
+        auto *protocol = new SugarSoapProtocol;
+        session.setProtocol(protocol);
+        protocol->setSession(&session);
+        // WHEN
+        LoginJob job(&session);
+        // THEN
+        QVERIFY(!job.exec());
+        QCOMPARE(job.error(), int(SugarJob::LoginError));
+        QVERIFY(session.sessionId().isEmpty());
+    }
+
+    void shouldLogin()
+    {
+        LoginJob job(&mSession);
+        QVERIFY2(job.exec(), qPrintable(job.errorString()));
+        QVERIFY(!mSession.sessionId().isEmpty());
+    }
+
+    void shouldCountSoapTraffic()
+    {
+#if !KDSOAP_HAS_NETWORK_ACCESS_MANAGER
+        QSKIP("This version of KDSoap cannot use the session's QNetworkAccessManager");
+#endif
+        // GIVEN
+        SugarSession session(nullptr);
+        session.setSessionParameters(QStringLiteral("user"), QStringLiteral("password"), mServer.hostUrl());
+        session.createSoapInterface();
+        auto *protocol = new SugarSoapProtocol;
+        session.setProtocol(protocol);
+        protocol->setSession(&session);
+        // WHEN
+        LoginJob loginJob(&session);
+        QVERIFY2(loginJob.exec(), qPrintable(loginJob.errorString()));
+        ListModulesJob modulesJob(&session);
+        QVERIFY2(modulesJob.exec(), qPrintable(modulesJob.errorString()));
+        // THEN
+        const SugarSession::TrafficStatistics statistics = session.trafficStatistics();
+        QCOMPARE(statistics.requests, 2);
+        QVERIFY(statistics.requestBodyBytes > 0);
+        QVERIFY(statistics.decodedReplyBytes > 0);
+    }
+
+    void shouldListModules()
+    {
+        ListModulesJob job(&mSession);
+        QVERIFY2(job.exec(), qPrintable(job.errorString()));
+        QVERIFY(job.modules().contains(moduleToName(Accounts)));
+        QVERIFY(job.modules().contains(moduleToName(Opportunities)));
+    }
+
+    void shouldListAllAccountsInPages()
+    {
+        // GIVEN
+        for (int i = 0; i < 250; ++i) {
+            addAccount(QStringLiteral("Account %1").arg(i));
+        }
+        mServer.resetRequestCounts();
+        // WHEN
+        QStringList names, deletedIds;
+        listAccounts(names, deletedIds);
+        // THEN
+        QCOMPARE(names.count(), 250);
+        QCOMPARE(names.first(), QStringLiteral("Account 0"));
+        QCOMPARE(names.last(), QStringLiteral("Account 249"));
+        QVERIFY(deletedIds.isEmpty());
+        QCOMPARE(mServer.requestCount(QStringLiteral("get_entries_count")), 1);
+        QCOMPARE(mServer.requestCount(QStringLiteral("get_entry_list")), 3); // SugarSoapProtocol asks for 100 at a time
+        QCOMPARE(mTimestamp, mServer.lastTimestamp());
+    }
+
+    void shouldListOnlyChangesSinceLastListing()
+    {
+        // GIVEN
+        const QString updatedId = addAccount(QStringLiteral("To be updated"));
+        const QString deletedId = addAccount(QStringLiteral("To be deleted"));
+        QStringList names, deletedIds;
+        listAccounts(names, deletedIds);
+        QMap<QString, QString> fields;
+        fields.insert(QStringLiteral("name"), QStringLiteral("Updated"));
+        QVERIFY(mServer.updateEntry(moduleToName(Accounts), updatedId, fields));
+        QVERIFY(mServer.deleteEntry(moduleToName(Accounts), deletedId));
+        // WHEN
+        names.clear();
+        listAccounts(names, deletedIds);
+        // THEN
+        QCOMPARE(names, QStringList() << QStringLiteral("Updated"));
+        QCOMPARE(deletedIds, QStringList() << deletedId);
+        QCOMPARE(mServer.entryCount(moduleToName(Accounts)), 251);
+    }
+
+    void shouldCreateAndFetchAccount()
+    {
+        // GIVEN
+        SugarAccount account;
+        account.setName(QStringLiteral("Created"));
+        Akonadi::Item item;
+        item.setPayload<SugarAccount>(account);
+        CreateEntryJob createJob(item, &mSession);
+        createJob.setModule(mAccountsHandler.data());
+        // WHEN
+        QVERIFY2(createJob.exec(), qPrintable(createJob.errorString()));
+        // THEN
+        const QString id = createJob.item().remoteId();
+        QVERIFY(!id.isEmpty());
+        QCOMPARE(createJob.item().remoteRevision(), mServer.lastTimestamp());
+        QCOMPARE(mServer.entry(moduleToName(Accounts), id).value(QStringLiteral("name")), QStringLiteral("Created"));
+
+        // AND WHEN
+        Akonadi::Item fetchItem;
+        fetchItem.setRemoteId(id);
+        FetchEntryJob fetchJob(fetchItem, &mSession);
+        fetchJob.setModule(mAccountsHandler.data());
+        QVERIFY2(fetchJob.exec(), qPrintable(fetchJob.errorString()));
+        // THEN
+        QCOMPARE(fetchJob.item().payload<SugarAccount>().name(), QStringLiteral("Created"));
+    }
+
+    void shouldLinkAndUnlinkItems()
+    {
+        // GIVEN
+        const QString accountId = addAccount(QStringLiteral("Linked"));
+        const QStringList contactIds = {QStringLiteral("contact1"), QStringLiteral("contact2")};
+        QString errorMessage;
+        // WHEN
+        QCOMPARE(mProtocol->setRelationship(accountId, Accounts, contactIds, Contacts, false, errorMessage), int(KJob::NoError));
+        // THEN
+        SugarProtocolBase::GetRelationShipsResult result = mProtocol->getRelationships(accountId, Accounts, Contacts);
+        QCOMPARE(result.errorCode, int(KJob::NoError));
+        result.ids.sort();
+        QCOMPARE(result.ids, contactIds);
+        QCOMPARE(mProtocol->getRelationships(QStringLiteral("contact2"), Contacts, Accounts).ids, QStringList() << accountId);
+
+        // AND WHEN
+        QCOMPARE(mProtocol->setRelationship(accountId, Accounts, {QStringLiteral("contact1")}, Contacts, true, errorMessage), int(KJob::NoError));
+        // THEN
+        QCOMPARE(mProtocol->getRelationships(accountId, Accounts, Contacts).ids, QStringList() << QStringLiteral("contact2"));
+    }
+
+    void shouldDelayResponses()
+    {
+        // GIVEN
+        mServer.setResponseDelay(100);
+        int count = 0;
+        QString errorMessage;
+        QElapsedTimer timer;
+        timer.start();
+        // WHEN
+        const int result = mProtocol->getEntriesCount(ListEntriesScope(), Accounts, QString(), count, errorMessage);
+        // THEN
+        QVERIFY(timer.elapsed() >= 100);
+        QCOMPARE(result, int(KJob::NoError));
+        QCOMPARE(count, 253);
+        mServer.setResponseDelay(0);
+    }
+
+    void shouldFailWithInvalidSession()
+    {
+        // GIVEN
+        const QString sessionId = mSession.sessionId();
+        mSession.setSessionId(QStringLiteral("unknown"));
+        int count = 0;
+        QString errorMessage;
+        // WHEN
+        const int result = mProtocol->getEntriesCount(ListEntriesScope(), Accounts, QString(), count, errorMessage);
+        // THEN
+        QCOMPARE(result, int(SugarJob::SoapError));
+        QVERIFY2(errorMessage.contains(QLatin1String("Invalid Session ID")), qPrintable(errorMessage));
+        mSession.setSessionId(sessionId);
+    }
+};
+
+QTEST_MAIN(TestSugarStandInServer)
+#include "test_sugarstandinserver.moc"
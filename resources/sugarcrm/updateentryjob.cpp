@@ -194,7 +194,17 @@ void UpdateEntryJob::Private::getRevisionDone(const KDSoapGenerated::TNS__Entry_
     bool deleted = false;
     const Akonadi::Item remoteItem = mHandler->itemFromEntry(entryValue, mItem.parentCollection(), deleted);
 
-    mItem.setRemoteRevision(remoteItem.remoteRevision());
+    if (remoteItem.hasPayload() && !deleted) {
+        // Store what the server has (e.g. the new date_modified in the payload),
+        // so that the next listing doesn't need to download this entry again
+        Item item = remoteItem;
+        item.setId(mItem.id());
+        item.setRevision(mItem.revision());
+        mItem = item;
+        mHandler->addLocalWrite(mItem.remoteId(), mItem.remoteRevision());
+    } else {
+        mItem.setRemoteRevision(remoteItem.remoteRevision());
+    }
     qCDebug(FATCRM_SUGARCRMRESOURCE_LOG) << "Got remote revision" << mItem.remoteRevision();
 
     q->emitResult();
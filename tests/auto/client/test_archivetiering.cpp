@@ -0,0 +1,157 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "archivetiering.h"
+#include "fulltextindex.h"
+
+#include "kdcrmdata/sugaropportunity.h"
+
+#include <QTest>
+
+class TestArchiveTiering : public QObject
+{
+    Q_OBJECT
+
+private:
+    static ArchiveTiering enabledTiering()
+    {
+        ArchiveTiering tiering;
+        tiering.setEnabled(true);
+        tiering.setCutoffMonths(24);
+        tiering.setReferenceDate(QDate(2021, 6, 15));
+        return tiering;
+    }
+
+    static SugarOpportunity opportunity(const QString &salesStage, const QDateTime &modified)
+    {
+        SugarOpportunity opp;
+        opp.setId(QStringLiteral("opp1"));
+        opp.setSalesStage(salesStage);
+        opp.setDateModified(modified);
+        return opp;
+    }
+
+    static Akonadi::Item item(Akonadi::Item::Id id, const QString &revision)
+    {
+        Akonadi::Item item(id);
+        item.setRemoteRevision(revision);
+        return item;
+    }
+
+private Q_SLOTS:
+    void shouldBeDisabledByDefault()
+    {
+        const ArchiveTiering tiering;
+        QVERIFY(!tiering.isEnabled());
+        QCOMPARE(tiering.cutoffMonths(), 24);
+        QVERIFY(!tiering.isColdRevision(QStringLiteral("2001-01-01 10:00:00")));
+        QVERIFY(!tiering.isCold(opportunity(QStringLiteral("Closed Won"), QDateTime(QDate(2001, 1, 1), QTime(10, 0)))));
+    }
+
+    void shouldComputeCutoff()
+    {
+        ArchiveTiering tiering = enabledTiering();
+        QCOMPARE(tiering.cutoff(), QDateTime(QDate(2019, 6, 15), QTime(0, 0), Qt::UTC));
+        tiering.setCutoffMonths(6);
+        QCOMPARE(tiering.cutoff(), QDateTime(QDate(2020, 12, 15), QTime(0, 0), Qt::UTC));
+    }
+
+    void shouldSortHistoryByRevision()
+    {
+        const ArchiveTiering tiering = enabledTiering();
+        QVERIFY(tiering.isColdRevision(QStringLiteral("2019-06-14 23:59:59")));
+        QVERIFY(!tiering.isColdRevision(QStringLiteral("2019-06-15 00:00:00")));
+        QVERIFY(!tiering.isColdRevision(QStringLiteral("2021-01-01 10:00:00")));
+        // No revision yet: just created, so hot
+        QVERIFY(!tiering.isColdRevision(QString()));
+    }
+
+    void shouldOnlyArchiveClosedOpportunities()
+    {
+        const ArchiveTiering tiering = enabledTiering();
+        const QDateTime old(QDate(2015, 3, 1), QTime(12, 0), Qt::UTC);
+        const QDateTime recent(QDate(2021, 3, 1), QTime(12, 0), Qt::UTC);
+        QVERIFY(tiering.isCold(opportunity(QStringLiteral("Closed Won"), old)));
+        QVERIFY(tiering.isCold(opportunity(QStringLiteral("Closed Lost"), old)));
+        QVERIFY(!tiering.isCold(opportunity(QStringLiteral("Negotiation"), old)));
+        QVERIFY(!tiering.isCold(opportunity(QStringLiteral("Closed Won"), recent)));
+        QVERIFY(!tiering.isCold(opportunity(QStringLiteral("Closed Won"), QDateTime())));
+    }
+
+    void shouldTakeColdItems()
+    {
+        // GIVEN
+        const ArchiveTiering tiering = enabledTiering();
+        Akonadi::Item::List items = {
+            item(1, QStringLiteral("2021-05-01 08:00:00")),
+            item(2, QStringLiteral("2012-05-01 08:00:00")),
+            item(3, QString()),
+            item(4, QStringLiteral("2018-01-01 08:00:00")),
+            item(5, QStringLiteral("2020-01-01 08:00:00"))
+        };
+
+        // WHEN
+        const Akonadi::Item::List cold = tiering.takeColdItems(items);
+
+        // THEN the hot items are left, in order
+        QCOMPARE(cold.count(), 2);
+        QCOMPARE(cold.at(0).id(), Akonadi::Item::Id(2));
+        QCOMPARE(cold.at(1).id(), Akonadi::Item::Id(4));
+        QCOMPARE(items.count(), 3);
+        QCOMPARE(items.at(0).id(), Akonadi::Item::Id(1));
+        QCOMPARE(items.at(1).id(), Akonadi::Item::Id(3));
+        QCOMPARE(items.at(2).id(), Akonadi::Item::Id(5));
+    }
+
+    void shouldKeepEverythingWhenDisabled()
+    {
+        ArchiveTiering tiering = enabledTiering();
+        tiering.setEnabled(false);
+        Akonadi::Item::List items = { item(1, QStringLiteral("2012-05-01 08:00:00")) };
+        QVERIFY(tiering.takeColdItems(items).isEmpty());
+        QCOMPARE(items.count(), 1);
+    }
+
+    void shouldKeepArchivedItemsInFullTextIndex()
+    {
+        // GIVEN an index saved by a previous session
+        FullTextIndex index;
+        index.add(FullTextIndex::Note, QStringLiteral("n1"), QStringLiteral("2012-05-01 08:00:00"),
+                  QStringLiteral("Old offer"), QStringLiteral("Accounts"), QStringLiteral("acc1"));
+        index.add(FullTextIndex::Note, QStringLiteral("n2"), QStringLiteral("2012-05-01 08:00:00"),
+                  QStringLiteral("Old meeting"), QStringLiteral("Accounts"), QStringLiteral("acc1"));
+
+        // WHEN loading only the headers of these (cold) notes, one of which was modified since
+        index.markAllUnseen(FullTextIndex::Note);
+        QVERIFY(index.markSeen(FullTextIndex::Note, QStringLiteral("n1"), QStringLiteral("2012-05-01 08:00:00")));
+        QVERIFY(!index.markSeen(FullTextIndex::Note, QStringLiteral("n2"), QStringLiteral("2013-01-01 08:00:00")));
+        QVERIFY(!index.markSeen(FullTextIndex::Note, QStringLiteral("n3"), QStringLiteral("2012-05-01 08:00:00")));
+        QCOMPARE(index.removeUnseen(FullTextIndex::Note), 1);
+
+        // THEN the unchanged one can still be found
+        QVERIFY(index.contains(FullTextIndex::Note, QStringLiteral("n1")));
+        QVERIFY(!index.contains(FullTextIndex::Note, QStringLiteral("n2")));
+        QCOMPARE(index.search(QStringLiteral("offer")).count(), 1);
+    }
+};
+
+QTEST_MAIN(TestArchiveTiering)
+#include "test_archivetiering.moc"
@@ -0,0 +1,142 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "completionvocabulary.h"
+
+#include "kdcrmdata/sugaropportunity.h"
+
+#include <AkonadiCore/EntityTreeModel>
+
+#include <QStandardItemModel>
+#include <QStringListModel>
+#include <QTest>
+
+class TestCompletionVocabulary : public QObject
+{
+    Q_OBJECT
+
+private:
+    static Akonadi::Item makeItem(Akonadi::Item::Id id, const QString &nextStep)
+    {
+        SugarOpportunity opportunity;
+        opportunity.setNextStep(nextStep);
+        Akonadi::Item item(id);
+        item.setPayload(opportunity);
+        return item;
+    }
+
+    static QStandardItem *makeRow(Akonadi::Item::Id id, const QString &nextStep)
+    {
+        auto *row = new QStandardItem(nextStep);
+        row->setData(QVariant::fromValue(makeItem(id, nextStep)), Akonadi::EntityTreeModel::ItemRole);
+        return row;
+    }
+
+    static QString nextStep(const Akonadi::Item &item)
+    {
+        return item.hasPayload<SugarOpportunity>() ? item.payload<SugarOpportunity>().nextStep() : QString();
+    }
+
+    QStandardItemModel mModel;
+    std::unique_ptr<CompletionVocabulary> mVocabulary;
+
+private Q_SLOTS:
+    void init()
+    {
+        mVocabulary.reset();
+        mModel.clear();
+        mModel.appendRow(makeRow(1, QStringLiteral("Send offer")));
+        mModel.appendRow(makeRow(2, QStringLiteral("call back")));
+        mModel.appendRow(makeRow(3, QString()));
+        mModel.appendRow(makeRow(4, QStringLiteral("Send offer")));
+        mVocabulary.reset(new CompletionVocabulary(&mModel, &TestCompletionVocabulary::nextStep));
+    }
+
+    void cleanup()
+    {
+        // What the completers see
+        QCOMPARE(mVocabulary->stringListModel()->stringList(), mVocabulary->values());
+    }
+
+    void shouldBuildSortedUniqueValues()
+    {
+        QCOMPARE(mVocabulary->values(), QStringList() << QStringLiteral("call back") << QStringLiteral("Send offer"));
+        QCOMPARE(mVocabulary->refCount(QStringLiteral("Send offer")), 2);
+        QCOMPARE(mVocabulary->refCount(QStringLiteral("call back")), 1);
+        QCOMPARE(mVocabulary->refCount(QString()), 0);
+    }
+
+    void shouldFollowInserts()
+    {
+        mModel.appendRow(makeRow(5, QStringLiteral("Demo")));
+        mModel.insertRow(0, makeRow(6, QStringLiteral("call back")));
+        mModel.appendRow(makeRow(7, QStringLiteral("Zoom meeting")));
+        QCOMPARE(mVocabulary->values(), QStringList() << QStringLiteral("call back") << QStringLiteral("Demo")
+                                                      << QStringLiteral("Send offer") << QStringLiteral("Zoom meeting"));
+        QCOMPARE(mVocabulary->refCount(QStringLiteral("call back")), 2);
+    }
+
+    void shouldFollowEdits()
+    {
+        // One of the two "Send offer" changes: the value stays
+        mModel.item(0)->setData(QVariant::fromValue(makeItem(1, QStringLiteral("Archive"))), Akonadi::EntityTreeModel::ItemRole);
+        QCOMPARE(mVocabulary->values(), QStringList() << QStringLiteral("Archive") << QStringLiteral("call back") << QStringLiteral("Send offer"));
+        QCOMPARE(mVocabulary->refCount(QStringLiteral("Send offer")), 1);
+
+        // The only "call back" is cleared: the value goes
+        mModel.item(1)->setData(QVariant::fromValue(makeItem(2, QString())), Akonadi::EntityTreeModel::ItemRole);
+        QCOMPARE(mVocabulary->values(), QStringList() << QStringLiteral("Archive") << QStringLiteral("Send offer"));
+
+        // An empty one gets a value
+        mModel.item(2)->setData(QVariant::fromValue(makeItem(3, QStringLiteral("Bill"))), Akonadi::EntityTreeModel::ItemRole);
+        QCOMPARE(mVocabulary->values(), QStringList() << QStringLiteral("Archive") << QStringLiteral("Bill") << QStringLiteral("Send offer"));
+    }
+
+    void shouldFollowRemovals()
+    {
+        mModel.removeRow(0);
+        QCOMPARE(mVocabulary->values(), QStringList() << QStringLiteral("call back") << QStringLiteral("Send offer"));
+        mModel.removeRow(2); // the other "Send offer"
+        QCOMPARE(mVocabulary->values(), QStringList() << QStringLiteral("call back"));
+        QCOMPARE(mVocabulary->refCount(QStringLiteral("Send offer")), 0);
+        mModel.removeRows(0, 2);
+        QVERIFY(mVocabulary->values().isEmpty());
+    }
+
+    void shouldRebuildOnReset()
+    {
+        mModel.clear();
+        QVERIFY(mVocabulary->values().isEmpty());
+        QCOMPARE(mVocabulary->stringListModel()->rowCount(), 0);
+    }
+
+    void shouldBeSharedPerModelAndName()
+    {
+        CompletionVocabulary *first = CompletionVocabulary::forModel(&mModel, QStringLiteral("next_step"), &TestCompletionVocabulary::nextStep);
+        CompletionVocabulary *second = CompletionVocabulary::forModel(&mModel, QStringLiteral("next_step"), &TestCompletionVocabulary::nextStep);
+        CompletionVocabulary *other = CompletionVocabulary::forModel(&mModel, QStringLiteral("other"), &TestCompletionVocabulary::nextStep);
+        QCOMPARE(first, second);
+        QVERIFY(first != other);
+        QCOMPARE(first->parent(), &mModel);
+        QCOMPARE(first->values(), mVocabulary->values());
+    }
+};
+
+QTEST_MAIN(TestCompletionVocabulary)
+#include "test_completionvocabulary.moc"
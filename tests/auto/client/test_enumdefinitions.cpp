@@ -23,6 +23,7 @@
 #include <QTest>
 #include <QDebug>
 #include "enumdefinitions.h"
+#include "enumdefinitionattribute.h"
 #include <QSignalSpy>
 
 class TestEnumDefinitions : public QObject
@@ -69,6 +70,68 @@ private Q_SLOTS:
         if (expectedIndexOfValue > -1) {
             QCOMPARE(reloaded.indexOf(expectedIndexOfString), expectedIndexOfValue);
         }
+
+        const QByteArray binary = enums.toBinary();
+        QVERIFY(EnumDefinitions::isBinary(binary));
+        const EnumDefinitions reloadedBinary = EnumDefinitions::fromBinary(binary);
+        QCOMPARE(reloadedBinary.toString(), str);
+        QCOMPARE(reloadedBinary.count(), enums.count());
+        if (expectedIndexOfValue > -1) {
+            QCOMPARE(reloadedBinary.indexOf(expectedIndexOfString), expectedIndexOfValue);
+        }
+    }
+
+    void testValueLookup()
+    {
+        EnumDefinitions::Enum leadSource(QStringLiteral("lead_source"));
+        QCOMPARE(leadSource.value(QStringLiteral("key")), QString());
+        leadSource.append({QStringLiteral("key"), QStringLiteral("value")});
+        leadSource.append({QStringLiteral("key2"), QStringLiteral("value 2")});
+        QCOMPARE(leadSource.value(QStringLiteral("key2")), QStringLiteral("value 2"));
+        QCOMPARE(leadSource.indexOf(QStringLiteral("key")), 0);
+        QCOMPARE(leadSource.indexOf(QStringLiteral("nope")), -1);
+
+        // values appended directly after a lookup are found too
+        leadSource.mEnumValues.append(EnumDefinitions::KeyValue{QStringLiteral("key3"), QStringLiteral("value 3")});
+        QCOMPARE(leadSource.value(QStringLiteral("key3")), QStringLiteral("value 3"));
+
+        // duplicate keys: the first one wins
+        leadSource.append({QStringLiteral("key"), QStringLiteral("other")});
+        QCOMPARE(leadSource.value(QStringLiteral("key")), QStringLiteral("value"));
+
+        const EnumDefinitions enums = EnumDefinitions() << leadSource << EnumDefinitions::Enum(QStringLiteral("lead_source"));
+        QCOMPARE(enums.indexOf(QStringLiteral("lead_source")), 0);
+        QCOMPARE(enums.indexOf(QStringLiteral("salutation")), -1);
+    }
+
+    void testCorruptBinary()
+    {
+        EnumDefinitions::Enum leadSource(QStringLiteral("lead_source"));
+        leadSource.append({QStringLiteral("key"), QStringLiteral("value")});
+        const QByteArray binary = (EnumDefinitions() << leadSource).toBinary();
+        QCOMPARE(EnumDefinitions::fromBinary(binary.left(binary.size() - 3)).count(), 0);
+        QCOMPARE(EnumDefinitions::fromBinary(QByteArrayLiteral("lead_source|key:value|")).count(), 0);
+    }
+
+    void testAttribute()
+    {
+        EnumDefinitions::Enum leadSource(QStringLiteral("lead_source"));
+        leadSource.append({QStringLiteral("key"), QStringLiteral("value")});
+        const EnumDefinitions enums = EnumDefinitions() << leadSource;
+
+        EnumDefinitionAttribute attr;
+        attr.setEnumDefinitions(enums);
+        QVERIFY(EnumDefinitions::isBinary(attr.serialized()));
+        QCOMPARE(attr.value(), enums.toString());
+
+        // text format written by older versions of the resource
+        EnumDefinitionAttribute oldAttr;
+        oldAttr.deserialize(enums.toString().toUtf8());
+        QCOMPARE(oldAttr.enumDefinitions().toString(), enums.toString());
+        QCOMPARE(oldAttr.enumDefinitions().at(0).value(QStringLiteral("key")), QStringLiteral("value"));
+
+        QScopedPointer<Akonadi::Attribute> clone(oldAttr.clone());
+        QCOMPARE(clone->serialized(), oldAttr.serialized());
     }
 
 };
@@ -0,0 +1,319 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "fulltextindex.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+class TestFullTextIndex : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QStringList ids(const QVector<FullTextIndex::Hit> &hits)
+    {
+        QStringList result;
+        for (const FullTextIndex::Hit &hit : hits) {
+            result.append(hit.id);
+        }
+        return result;
+    }
+
+    static void fill(FullTextIndex &index)
+    {
+        index.add(FullTextIndex::Note, QStringLiteral("n1"), QStringLiteral("rev1"),
+                  QStringLiteral("Meeting about the offer with the customer"),
+                  QStringLiteral("Accounts"), QStringLiteral("acc1"));
+        index.add(FullTextIndex::Note, QStringLiteral("n2"), QStringLiteral("rev1"),
+                  QStringLiteral("Offer offer offer"),
+                  QStringLiteral("Opportunities"), QStringLiteral("opp1"));
+        index.add(FullTextIndex::Email, QStringLiteral("e1"), QStringLiteral("rev1"),
+                  QStringLiteral("Kickoff meeting next week"),
+                  QStringLiteral("Contacts"), QStringLiteral("contact1"));
+        index.add(FullTextIndex::Document, QStringLiteral("d1"), QStringLiteral("rev1"),
+                  QStringLiteral("Signed offer.pdf\nThe offer, signed by the customer"),
+                  QStringLiteral("Accounts"), QStringLiteral("acc1"));
+    }
+
+private Q_SLOTS:
+    void shouldTokenize()
+    {
+        QCOMPARE(FullTextIndex::tokenize(QStringLiteral("Re: Offer #42, état-major a b")),
+                 QStringList({ "re", "offer", "42", "état", "major" }));
+        QVERIFY(FullTextIndex::tokenize(QStringLiteral(" - ! ")).isEmpty());
+    }
+
+    void shouldFindMatchingItems()
+    {
+        // GIVEN
+        FullTextIndex index;
+        fill(index);
+        QCOMPARE(index.documentCount(), 4);
+
+        // WHEN
+        const QVector<FullTextIndex::Hit> hits = index.search(QStringLiteral("KICKOFF"));
+
+        // THEN
+        QCOMPARE(hits.count(), 1);
+        QCOMPARE(hits.at(0).kind, FullTextIndex::Email);
+        QCOMPARE(hits.at(0).id, QStringLiteral("e1"));
+        QCOMPARE(hits.at(0).parentType, QStringLiteral("Contacts"));
+        QCOMPARE(hits.at(0).parentId, QStringLiteral("contact1"));
+        QVERIFY(hits.at(0).score > 0);
+        QVERIFY(index.search(QStringLiteral("unknown")).isEmpty());
+        QVERIFY(index.search(QString()).isEmpty());
+    }
+
+    void shouldRankByTermFrequency()
+    {
+        // GIVEN
+        FullTextIndex index;
+        fill(index);
+
+        // WHEN
+        const QVector<FullTextIndex::Hit> hits = index.search(QStringLiteral("offer"));
+
+        // THEN the item repeating the term comes first, then the document mentioning it twice
+        QCOMPARE(ids(hits), QStringList({ "n2", "d1", "n1" }));
+        QVERIFY(hits.at(0).score > hits.at(1).score);
+        QVERIFY(hits.at(1).score > hits.at(2).score);
+    }
+
+    void shouldRankRareTermsHigher()
+    {
+        // GIVEN
+        FullTextIndex index;
+        fill(index);
+
+        // WHEN searching for a term present in one item and one present in three
+        const QVector<FullTextIndex::Hit> hits = index.search(QStringLiteral("kickoff offer"));
+
+        // THEN the rare term weighs more
+        QCOMPARE(hits.count(), 4);
+        QCOMPARE(hits.at(0).id, QStringLiteral("e1"));
+    }
+
+    void shouldAddUpQueryTerms()
+    {
+        // GIVEN
+        FullTextIndex index;
+        fill(index);
+
+        // WHEN
+        const QVector<FullTextIndex::Hit> hits = index.search(QStringLiteral("meeting customer"));
+
+        // THEN the only item with both terms comes first
+        QCOMPARE(ids(hits).first(), QStringLiteral("n1"));
+        QCOMPARE(hits.count(), 3);
+    }
+
+    void shouldLimitHits()
+    {
+        FullTextIndex index;
+        fill(index);
+        QCOMPARE(ids(index.search(QStringLiteral("offer"), 2)), QStringList({ "n2", "d1" }));
+        QVERIFY(index.search(QStringLiteral("offer"), 0).isEmpty());
+    }
+
+    void shouldSkipUnchangedRevisions()
+    {
+        // GIVEN
+        FullTextIndex index;
+        fill(index);
+
+        // WHEN adding an item again with the same revision
+        const bool added = index.add(FullTextIndex::Email, QStringLiteral("e1"), QStringLiteral("rev1"),
+                                     QStringLiteral("different text"),
+                                     QStringLiteral("Contacts"), QStringLiteral("contact1"));
+
+        // THEN it isn't reindexed
+        QVERIFY(!added);
+        QCOMPARE(ids(index.search(QStringLiteral("kickoff"))), QStringList({ "e1" }));
+        QVERIFY(index.search(QStringLiteral("different")).isEmpty());
+    }
+
+    void shouldReplaceModifiedItems()
+    {
+        // GIVEN
+        FullTextIndex index;
+        fill(index);
+
+        // WHEN the email changes on the server
+        const bool added = index.add(FullTextIndex::Email, QStringLiteral("e1"), QStringLiteral("rev2"),
+                                     QStringLiteral("Postponed to next month"),
+                                     QStringLiteral("Accounts"), QStringLiteral("acc2"));
+
+        // THEN
+        QVERIFY(added);
+        QCOMPARE(index.documentCount(), 4);
+        QVERIFY(index.search(QStringLiteral("kickoff")).isEmpty());
+        const QVector<FullTextIndex::Hit> hits = index.search(QStringLiteral("postponed"));
+        QCOMPARE(ids(hits), QStringList({ "e1" }));
+        QCOMPARE(hits.at(0).parentId, QStringLiteral("acc2"));
+        // the document frequency of "meeting" went down, only the note is left
+        QCOMPARE(ids(index.search(QStringLiteral("meeting"))), QStringList({ "n1" }));
+    }
+
+    void shouldRemoveItems()
+    {
+        // GIVEN
+        FullTextIndex index;
+        fill(index);
+
+        // WHEN
+        index.remove(FullTextIndex::Note, QStringLiteral("n2"));
+        index.remove(FullTextIndex::Note, QStringLiteral("unknown"));
+        index.remove(FullTextIndex::Email, QStringLiteral("n1")); // wrong kind
+
+        // THEN
+        QCOMPARE(index.documentCount(), 3);
+        QVERIFY(!index.contains(FullTextIndex::Note, QStringLiteral("n2")));
+        QVERIFY(index.contains(FullTextIndex::Note, QStringLiteral("n1")));
+        QCOMPARE(ids(index.search(QStringLiteral("offer"))), QStringList({ "d1", "n1" }));
+    }
+
+    void shouldKnowTheParents()
+    {
+        // GIVEN
+        FullTextIndex index;
+        fill(index);
+
+        // WHEN
+        index.remove(FullTextIndex::Note, QStringLiteral("n1"));
+
+        // THEN
+        QCOMPARE(index.parentId(FullTextIndex::Note, QStringLiteral("n2")), QStringLiteral("opp1"));
+        QCOMPARE(index.parentId(FullTextIndex::Email, QStringLiteral("e1")), QStringLiteral("contact1"));
+        QCOMPARE(index.parentId(FullTextIndex::Note, QStringLiteral("n1")), QString());
+        QCOMPARE(index.parentId(FullTextIndex::Note, QStringLiteral("e1")), QString()); // wrong kind
+    }
+
+    void shouldStayCorrectAfterCompaction()
+    {
+        // GIVEN many items
+        FullTextIndex index;
+        const int count = 5000;
+        for (int i = 0; i < count; ++i) {
+            index.add(FullTextIndex::Email, QString::number(i), QStringLiteral("rev"),
+                      QStringLiteral("offer %1 %2").arg(i % 2 ? QLatin1String("odd") : QLatin1String("even")).arg(i),
+                      QStringLiteral("Opportunities"), QStringLiteral("opp%1").arg(i % 10));
+        }
+
+        // WHEN removing most of them, which compacts the postings
+        for (int i = 0; i < count - 10; ++i) {
+            index.remove(FullTextIndex::Email, QString::number(i));
+        }
+
+        // THEN
+        QCOMPARE(index.documentCount(), 10);
+        QCOMPARE(index.search(QStringLiteral("offer"), 100).count(), 10);
+        QCOMPARE(index.search(QStringLiteral("odd"), 100).count(), 5);
+        QCOMPARE(ids(index.search(QStringLiteral("4995"))), QStringList({ "4995" }));
+        QVERIFY(index.search(QStringLiteral("42")).isEmpty());
+
+        // and new items can still be added and removed
+        index.add(FullTextIndex::Email, QStringLiteral("new"), QStringLiteral("rev"), QStringLiteral("odd one"),
+                  QStringLiteral("Accounts"), QStringLiteral("acc"));
+        QCOMPARE(index.search(QStringLiteral("odd"), 100).count(), 6);
+        index.remove(FullTextIndex::Email, QStringLiteral("4999"));
+        QCOMPARE(index.search(QStringLiteral("odd"), 100).count(), 5);
+    }
+
+    void shouldSweepUnseenItems()
+    {
+        // GIVEN an index loaded from disk
+        FullTextIndex index;
+        fill(index);
+
+        // WHEN reloading the notes, only n1 still exists
+        index.markAllUnseen(FullTextIndex::Note);
+        index.add(FullTextIndex::Note, QStringLiteral("n1"), QStringLiteral("rev1"),
+                  QStringLiteral("Meeting about the offer with the customer"),
+                  QStringLiteral("Accounts"), QStringLiteral("acc1"));
+        const int removed = index.removeUnseen(FullTextIndex::Note);
+
+        // THEN n2 is gone, the other kinds are untouched
+        QCOMPARE(removed, 1);
+        QCOMPARE(index.documentCount(), 3);
+        QVERIFY(!index.contains(FullTextIndex::Note, QStringLiteral("n2")));
+        QVERIFY(index.contains(FullTextIndex::Email, QStringLiteral("e1")));
+        QVERIFY(index.contains(FullTextIndex::Document, QStringLiteral("d1")));
+    }
+
+    void shouldSaveAndLoad()
+    {
+        // GIVEN an index with a removed item
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString fileName = dir.path() + QStringLiteral("/sub/index");
+        FullTextIndex index;
+        fill(index);
+        index.remove(FullTextIndex::Note, QStringLiteral("n1"));
+        const QVector<FullTextIndex::Hit> expected = index.search(QStringLiteral("offer customer"));
+
+        // WHEN
+        QVERIFY(index.save(fileName));
+        FullTextIndex loaded;
+        QVERIFY(loaded.load(fileName));
+
+        // THEN
+        QCOMPARE(loaded.documentCount(), 3);
+        const QVector<FullTextIndex::Hit> hits = loaded.search(QStringLiteral("offer customer"));
+        QCOMPARE(ids(hits), ids(expected));
+        for (int i = 0; i < hits.count(); ++i) {
+            QCOMPARE(hits.at(i).kind, expected.at(i).kind);
+            QCOMPARE(hits.at(i).parentType, expected.at(i).parentType);
+            QCOMPARE(hits.at(i).parentId, expected.at(i).parentId);
+            QCOMPARE(hits.at(i).score, expected.at(i).score);
+        }
+        // revisions are kept, so unchanged items are skipped after a restart
+        QVERIFY(!loaded.add(FullTextIndex::Note, QStringLiteral("n2"), QStringLiteral("rev1"),
+                            QStringLiteral("Offer offer offer"),
+                            QStringLiteral("Opportunities"), QStringLiteral("opp1")));
+        QVERIFY(loaded.add(FullTextIndex::Note, QStringLiteral("n1"), QStringLiteral("rev1"),
+                           QStringLiteral("Meeting about the offer with the customer"),
+                           QStringLiteral("Accounts"), QStringLiteral("acc1")));
+    }
+
+    void shouldIgnoreInvalidFiles()
+    {
+        // GIVEN
+        QTemporaryDir dir;
+        const QString fileName = dir.path() + QStringLiteral("/index");
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("not an index");
+        file.close();
+        FullTextIndex index;
+        fill(index);
+
+        // WHEN
+        const bool loaded = index.load(fileName);
+
+        // THEN
+        QVERIFY(!loaded);
+        QCOMPARE(index.documentCount(), 0);
+        QVERIFY(!index.load(dir.path() + QStringLiteral("/missing")));
+    }
+};
+
+QTEST_MAIN(TestFullTextIndex)
+#include "test_fulltextindex.moc"
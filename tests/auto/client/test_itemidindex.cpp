@@ -0,0 +1,137 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "itemidindex.h"
+#include "itemdataextractor.h"
+
+#include "kdcrmdata/sugaraccount.h"
+
+#include <AkonadiCore/EntityTreeModel>
+
+#include <QStandardItemModel>
+#include <QTest>
+
+class TestItemIdIndex : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QStandardItem *makeRow(const QString &id, const QString &name)
+    {
+        SugarAccount account;
+        account.setId(id);
+        account.setName(name);
+        Akonadi::Item item;
+        item.setPayload(account);
+        auto *row = new QStandardItem(name);
+        row->setData(QVariant::fromValue(item), Akonadi::EntityTreeModel::ItemRole);
+        return row;
+    }
+
+    static QString nameAt(const QModelIndex &index)
+    {
+        return index.data().toString();
+    }
+
+    QStandardItemModel mModel;
+    std::unique_ptr<ItemIdIndex> mIdIndex;
+
+private Q_SLOTS:
+    void init()
+    {
+        mModel.clear();
+        mModel.appendRow(makeRow(QStringLiteral("id-c"), QStringLiteral("C")));
+        mModel.appendRow(makeRow(QStringLiteral("id-a"), QStringLiteral("A")));
+        mIdIndex.reset(new ItemIdIndex(ItemDataExtractor::createDataExtractor(DetailsType::Account)));
+        mIdIndex->setModel(&mModel);
+    }
+
+    void shouldIndexExistingRows()
+    {
+        QCOMPARE(mIdIndex->count(), 2);
+        QCOMPARE(nameAt(mIdIndex->index(QStringLiteral("id-a"))), QStringLiteral("A"));
+        QCOMPARE(nameAt(mIdIndex->index(QStringLiteral("id-c"))), QStringLiteral("C"));
+        QVERIFY(!mIdIndex->index(QStringLiteral("id-unknown")).isValid());
+        QVERIFY(!mIdIndex->index(QString()).isValid());
+    }
+
+    void shouldFollowInserts()
+    {
+        mModel.insertRow(0, makeRow(QStringLiteral("id-b"), QStringLiteral("B")));
+        mModel.appendRow(makeRow(QStringLiteral("id-d"), QStringLiteral("D")));
+        QCOMPARE(mIdIndex->count(), 4);
+        QCOMPARE(mIdIndex->index(QStringLiteral("id-b")).row(), 0);
+        QCOMPARE(mIdIndex->index(QStringLiteral("id-c")).row(), 1);
+        QCOMPARE(mIdIndex->index(QStringLiteral("id-a")).row(), 2);
+        QCOMPARE(mIdIndex->index(QStringLiteral("id-d")).row(), 3);
+    }
+
+    void shouldFollowRemovals()
+    {
+        mModel.appendRow(makeRow(QStringLiteral("id-b"), QStringLiteral("B")));
+        mModel.removeRow(0);
+        QCOMPARE(mIdIndex->count(), 2);
+        QVERIFY(!mIdIndex->index(QStringLiteral("id-c")).isValid());
+        QCOMPARE(mIdIndex->index(QStringLiteral("id-a")).row(), 0);
+        QCOMPARE(mIdIndex->index(QStringLiteral("id-b")).row(), 1);
+    }
+
+    void shouldFollowMoves()
+    {
+        mModel.appendRow(makeRow(QStringLiteral("id-b"), QStringLiteral("B")));
+        mModel.sort(0); // layoutChanged: A B C
+        QCOMPARE(mIdIndex->index(QStringLiteral("id-a")).row(), 0);
+        QCOMPARE(mIdIndex->index(QStringLiteral("id-b")).row(), 1);
+        QCOMPARE(mIdIndex->index(QStringLiteral("id-c")).row(), 2);
+
+        // take + insert elsewhere
+        const QList<QStandardItem *> taken = mModel.takeRow(0);
+        mModel.appendRow(taken);
+        QCOMPARE(mIdIndex->index(QStringLiteral("id-b")).row(), 0);
+        QCOMPARE(mIdIndex->index(QStringLiteral("id-c")).row(), 1);
+        QCOMPARE(nameAt(mIdIndex->index(QStringLiteral("id-a"))), QStringLiteral("A"));
+        QCOMPARE(mIdIndex->index(QStringLiteral("id-a")).row(), 2);
+    }
+
+    void shouldFollowIdChanges()
+    {
+        // e.g. an item created locally gets its id from the server
+        QStandardItem *row = mModel.item(1);
+        SugarAccount account;
+        account.setId(QStringLiteral("id-new"));
+        account.setName(QStringLiteral("A"));
+        Akonadi::Item item;
+        item.setPayload(account);
+        row->setData(QVariant::fromValue(item), Akonadi::EntityTreeModel::ItemRole);
+
+        QCOMPARE(mIdIndex->index(QStringLiteral("id-new")).row(), 1);
+        QVERIFY(!mIdIndex->index(QStringLiteral("id-a")).isValid());
+    }
+
+    void shouldRebuildOnReset()
+    {
+        mModel.clear();
+        QCOMPARE(mIdIndex->count(), 0);
+        QVERIFY(!mIdIndex->index(QStringLiteral("id-a")).isValid());
+    }
+};
+
+QTEST_MAIN(TestItemIdIndex)
+#include "test_itemidindex.moc"
@@ -0,0 +1,241 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "collectionmanager.h"
+#include "linkeditemsrepository.h"
+#include "memoryreport.h"
+
+#include "kdcrmdata/sugaremail.h"
+#include "kdcrmdata/sugarnote.h"
+
+#include <QTest>
+
+#include <algorithm>
+
+class TestMemoryBudget : public QObject
+{
+    Q_OBJECT
+
+private:
+    // One note per day, the oldest first, spread over three accounts
+    static Akonadi::Item::List notes(int count, int bodyLength)
+    {
+        Akonadi::Item::List items;
+        for (int i = 0; i < count; ++i) {
+            SugarNote note;
+            note.setId(QStringLiteral("note%1").arg(i));
+            note.setName(QStringLiteral("Note %1").arg(i));
+            note.setParentType(QStringLiteral("Accounts"));
+            note.setParentId(QStringLiteral("acc%1").arg(i % 3));
+            note.setDateModified(QDateTime(QDate(2020, 1, 1).addDays(i), QTime(12, 0), Qt::UTC));
+            note.setDescription(QString(bodyLength, QLatin1Char('n')));
+            Akonadi::Item item(i + 1);
+            item.setRemoteId(note.id());
+            item.setPayload(note);
+            items.append(item);
+        }
+        return items;
+    }
+
+    static Akonadi::Item::List emails(int count, int bodyLength)
+    {
+        Akonadi::Item::List items;
+        for (int i = 0; i < count; ++i) {
+            SugarEmail email;
+            email.setId(QStringLiteral("email%1").arg(i));
+            email.setName(QStringLiteral("Email %1").arg(i));
+            email.setParentType(QStringLiteral("Accounts"));
+            email.setParentId(QStringLiteral("acc%1").arg(i % 3));
+            email.setDateModified(QDateTime(QDate(2020, 1, 1).addDays(i), QTime(13, 0), Qt::UTC));
+            email.setDescriptionHtml(QString(bodyLength, QLatin1Char('e')));
+            Akonadi::Item item(1000 + i);
+            item.setRemoteId(email.id());
+            item.setPayload(email);
+            items.append(item);
+        }
+        return items;
+    }
+
+    template <typename T>
+    static qint64 estimatedSize(const Akonadi::Item::List &items)
+    {
+        qint64 size = 0;
+        for (const Akonadi::Item &item : items) {
+            size += item.payload<T>().estimatedMemoryUsage();
+        }
+        return size;
+    }
+
+    static MemoryReport::Entry reportEntry(const LinkedItemsRepository &repository, const QString &name)
+    {
+        MemoryReport report;
+        repository.addToMemoryReport(report);
+        const QVector<MemoryReport::Entry> entries = report.entries();
+        for (const MemoryReport::Entry &entry : entries) {
+            if (entry.name == name) {
+                return entry;
+            }
+        }
+        return MemoryReport::Entry{QString(), 0, 0};
+    }
+
+    static void addInBatches(LinkedItemsRepository &repository, const Akonadi::Item::List &noteItems,
+                             const Akonadi::Item::List &emailItems, qint64 budget)
+    {
+        const int batchSize = 25;
+        for (int i = 0; i < noteItems.count(); i += batchSize) {
+            repository.addNotes(noteItems.mid(i, batchSize));
+            QVERIFY2(repository.historyMemoryUsage() <= budget, qPrintable(QString::number(repository.historyMemoryUsage())));
+        }
+        for (int i = 0; i < emailItems.count(); i += batchSize) {
+            repository.addEmails(emailItems.mid(i, batchSize));
+            QVERIFY2(repository.historyMemoryUsage() <= budget, qPrintable(QString::number(repository.historyMemoryUsage())));
+        }
+    }
+
+private Q_SLOTS:
+    void shouldSumEntriesInReport()
+    {
+        // GIVEN
+        MemoryReport report;
+        // WHEN
+        report.add(QStringLiteral("Notes"), 2, 1000);
+        report.add(QStringLiteral("Emails"), 3, 3 * 1024 * 1024);
+        // THEN
+        QCOMPARE(report.entries().count(), 2);
+        QCOMPARE(report.totalBytes(), qint64(1000 + 3 * 1024 * 1024));
+        QVERIFY(report.toString().contains(QLatin1String("3.0 MiB")));
+        QCOMPARE(MemoryReport::formatBytes(512), QStringLiteral("512 B"));
+        QCOMPARE(MemoryReport::formatBytes(1536), QStringLiteral("1.5 KiB"));
+    }
+
+    void shouldReportSizeOfStoredHistory()
+    {
+        // GIVEN
+        LinkedItemsRepository repository(&m_collectionManager);
+        const Akonadi::Item::List noteItems = notes(300, 1000);
+        const Akonadi::Item::List emailItems = emails(200, 2000);
+        // WHEN
+        repository.addNotes(noteItems);
+        repository.addEmails(emailItems);
+        // THEN
+        const qint64 notesSize = estimatedSize<SugarNote>(noteItems);
+        const qint64 emailsSize = estimatedSize<SugarEmail>(emailItems);
+        QVERIFY(notesSize > 300 * 2000);
+        const MemoryReport::Entry notesEntry = reportEntry(repository, QStringLiteral("Notes"));
+        QCOMPARE(notesEntry.count, 300);
+        QCOMPARE(notesEntry.bytes, notesSize);
+        const MemoryReport::Entry emailsEntry = reportEntry(repository, QStringLiteral("Emails"));
+        QCOMPARE(emailsEntry.count, 200);
+        QCOMPARE(emailsEntry.bytes, emailsSize);
+        QCOMPARE(repository.historyMemoryUsage(), notesSize + emailsSize);
+        QCOMPARE(repository.evictedHistoryCount(), 0);
+
+        // WHEN
+        repository.clear();
+        // THEN
+        QCOMPARE(repository.historyMemoryUsage(), qint64(0));
+    }
+
+    void shouldStayUnderBudget()
+    {
+        // GIVEN
+        LinkedItemsRepository repository(&m_collectionManager);
+        const Akonadi::Item::List noteItems = notes(300, 1000);
+        const Akonadi::Item::List emailItems = emails(200, 2000);
+        const qint64 fullSize = estimatedSize<SugarNote>(noteItems) + estimatedSize<SugarEmail>(emailItems);
+        const qint64 budget = fullSize / 3;
+        repository.setHistoryMemoryBudget(budget);
+        // WHEN
+        addInBatches(repository, noteItems, emailItems, budget);
+        // THEN the reported size follows the evictions
+        QVERIFY(repository.evictedHistoryCount() > 0);
+        const qint64 reported = reportEntry(repository, QStringLiteral("Notes")).bytes
+                + reportEntry(repository, QStringLiteral("Emails")).bytes;
+        QCOMPARE(reported, repository.historyMemoryUsage());
+        QVERIFY(reported <= budget);
+        // All the notes and emails are still there, the oldest ones without their body
+        const QVector<SugarNote> acc0Notes = repository.notesForAccount(QStringLiteral("acc0"));
+        QCOMPARE(acc0Notes.count(), 100);
+        const auto findNote = [&acc0Notes](const QString &id) {
+            return *std::find_if(acc0Notes.begin(), acc0Notes.end(), [&id](const SugarNote &note) { return note.id() == id; });
+        };
+        QVERIFY(findNote(QStringLiteral("note0")).description().isEmpty());
+        QVERIFY(findNote(QStringLiteral("note0")).name() == QLatin1String("Note 0"));
+        QVERIFY(repository.isHistoryBodyEvicted(QStringLiteral("note0")));
+        const QVector<SugarNote> acc2Notes = repository.notesForAccount(QStringLiteral("acc2"));
+        const auto newestNote = std::find_if(acc2Notes.begin(), acc2Notes.end(), [](const SugarNote &note) {
+            return note.id() == QLatin1String("note299");
+        });
+        QVERIFY(newestNote != acc2Notes.end());
+        QVERIFY(!newestNote->description().isEmpty());
+        QVERIFY(!repository.isHistoryBodyEvicted(QStringLiteral("note299")));
+
+        // WHEN lowering the budget
+        repository.setHistoryMemoryBudget(budget / 2);
+        // THEN
+        QVERIFY(repository.historyMemoryUsage() <= budget / 2);
+
+        // WHEN a body is fetched again, like loadHistoryBodies() does for a shown account
+        repository.pinHistory(QStringLiteral("acc0"));
+        repository.addNotes(noteItems.mid(0, 1));
+        // THEN
+        QVERIFY(!repository.isHistoryBodyEvicted(QStringLiteral("note0")));
+    }
+
+    void shouldKeepPinnedHistory()
+    {
+        // GIVEN
+        LinkedItemsRepository repository(&m_collectionManager);
+        const Akonadi::Item::List noteItems = notes(300, 1000);
+        const Akonadi::Item::List emailItems = emails(200, 2000);
+        const qint64 fullSize = estimatedSize<SugarNote>(noteItems) + estimatedSize<SugarEmail>(emailItems);
+        const qint64 budget = fullSize / 2;
+        repository.setHistoryMemoryBudget(budget);
+        repository.pinHistory(QStringLiteral("acc1"));
+        // WHEN
+        addInBatches(repository, noteItems, emailItems, budget);
+        // THEN
+        QVERIFY(repository.evictedHistoryCount() > 0);
+        const QVector<SugarNote> pinnedNotes = repository.notesForAccount(QStringLiteral("acc1"));
+        QCOMPARE(pinnedNotes.count(), 100);
+        for (const SugarNote &note : pinnedNotes) {
+            QVERIFY(!note.description().isEmpty());
+            QVERIFY(!repository.isHistoryBodyEvicted(note.id()));
+        }
+        QVERIFY(!repository.loadHistoryBodies(QStringLiteral("acc1"))); // nothing was dropped
+
+        // WHEN unpinning
+        repository.unpinHistory(QStringLiteral("acc1"));
+        repository.setHistoryMemoryBudget(budget / 2);
+        // THEN
+        QVERIFY(repository.historyMemoryUsage() <= budget / 2);
+        const QVector<SugarNote> unpinnedNotes = repository.notesForAccount(QStringLiteral("acc1"));
+        QVERIFY(std::any_of(unpinnedNotes.begin(), unpinnedNotes.end(), [&repository](const SugarNote &note) {
+            return note.description().isEmpty() && repository.isHistoryBodyEvicted(note.id());
+        }));
+    }
+
+private:
+    CollectionManager m_collectionManager;
+};
+
+QTEST_MAIN(TestMemoryBudget)
+#include "test_memorybudget.moc"
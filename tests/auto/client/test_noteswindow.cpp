@@ -0,0 +1,163 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "noteswindow.h"
+#include "timelinedelegate.h"
+#include "timelinemodel.h"
+
+#include "kdcrmdata/kdcrmutils.h"
+#include "kdcrmdata/sugaremail.h"
+#include "kdcrmdata/sugarnote.h"
+
+#include <QLineEdit>
+#include <QListView>
+#include <QScrollBar>
+#include <QStandardPaths>
+#include <QTest>
+
+class TestNotesWindow : public QObject
+{
+    Q_OBJECT
+
+private:
+    static const int s_historySize = 10000;
+
+    // Half notes, half emails (plain text or HTML), one every hour, with bodies of a few dozen lines
+    static void fillHistory(NotesWindow &window)
+    {
+        const QDateTime start(QDate(2020, 1, 1), QTime(8, 0));
+        for (int i = 0; i < s_historySize; ++i) {
+            const QDateTime date = start.addSecs(3600 * i);
+            QString body;
+            for (int line = 0; line < 20 + i % 30; ++line) {
+                body += QStringLiteral("Line %1 of the message about subject %2, with enough words to wrap in a narrow window.\n").arg(line).arg(i);
+            }
+            if (i % 2 == 0) {
+                SugarNote note;
+                note.setName(QStringLiteral("Subject %1").arg(i));
+                note.setCreatedByName(QStringLiteral("User %1").arg(i % 7));
+                note.setDateModified(date);
+                note.setDescription(body);
+                window.addNote(note);
+            } else {
+                SugarEmail email;
+                email.setName(QStringLiteral("Subject %1").arg(i));
+                email.setFromAddrName(QStringLiteral("sender%1@example.com").arg(i % 13));
+                email.setToAddrNames(QStringLiteral("recipient@example.com"));
+                email.setDateSent(KDCRMUtils::dateTimeToString(date));
+                if (i % 4 == 1)
+                    email.setDescription(body);
+                else
+                    email.setDescriptionHtml(QStringLiteral("<html><body><p>") + body.toHtmlEscaped().replace('\n', QLatin1String("<br/>")) + QStringLiteral("</p></body></html>"));
+                window.addEmail(email);
+            }
+        }
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+    }
+
+    // The time it takes is measured by bench_noteswindow
+    void shouldOnlyLayOutVisibleEntries()
+    {
+        NotesWindow window;
+        fillHistory(window);
+        window.resize(600, 800);
+        auto *view = window.findChild<QListView *>(QStringLiteral("timelineView"));
+        QVERIFY(view);
+        auto *delegate = qobject_cast<TimelineDelegate *>(view->itemDelegate());
+        QVERIFY(delegate);
+
+        window.show();
+        QVERIFY(QTest::qWaitForWindowExposed(&window));
+        view->viewport()->repaint();
+
+        QCOMPARE(view->model()->rowCount(), s_historySize);
+        // Most recent first
+        QCOMPARE(view->model()->index(0, 0).data(TimelineModel::DateRole).toDateTime(),
+                 QDateTime(QDate(2020, 1, 1), QTime(8, 0)).addSecs(3600 * (s_historySize - 1)));
+
+        // Only the visible rows were laid out
+        QVERIFY(delegate->measuredCount() > 0);
+        QVERIFY2(delegate->measuredCount() < 100, qPrintable(QString::number(delegate->measuredCount())));
+        QVERIFY(delegate->cachedLayoutCount() <= delegate->measuredCount());
+    }
+
+    void shouldKeepLayoutCacheBounded()
+    {
+        NotesWindow window;
+        fillHistory(window);
+        window.resize(600, 800);
+        auto *view = window.findChild<QListView *>(QStringLiteral("timelineView"));
+        auto *delegate = qobject_cast<TimelineDelegate *>(view->itemDelegate());
+        delegate->setMaximumCachedLayouts(50);
+        window.show();
+        QVERIFY(QTest::qWaitForWindowExposed(&window));
+
+        // Scroll through a good part of the history, a page at a time
+        QScrollBar *scrollBar = view->verticalScrollBar();
+        for (int page = 0; page < 100; ++page) {
+            scrollBar->setValue(scrollBar->value() + view->viewport()->height());
+            view->viewport()->repaint();
+        }
+        QVERIFY(delegate->measuredCount() > 50);
+        QVERIFY(delegate->cachedLayoutCount() <= 50);
+    }
+
+    void shouldFilterEntries()
+    {
+        NotesWindow window;
+        fillHistory(window);
+        window.show();
+        QVERIFY(QTest::qWaitForWindowExposed(&window));
+        auto *view = window.findChild<QListView *>(QStringLiteral("timelineView"));
+        auto *searchLineEdit = window.findChild<QLineEdit *>(QStringLiteral("searchLineEdit"));
+        QVERIFY(searchLineEdit);
+
+        // In the header and the body of a note
+        searchLineEdit->setText(QStringLiteral("subject 1234"));
+        QCOMPARE(view->model()->rowCount(), 1);
+        QCOMPARE(view->model()->index(0, 0).data(TimelineModel::DateRole).toDateTime(),
+                 QDateTime(QDate(2020, 1, 1), QTime(8, 0)).addSecs(3600 * 1234));
+        // In the body of an HTML email
+        searchLineEdit->setText(QStringLiteral("line 3 of the message about subject 1235,"));
+        QCOMPARE(view->model()->rowCount(), 1);
+        // In the sender, which is only in the header
+        int sentBy12 = 0;
+        for (int i = 1; i < s_historySize; i += 2) {
+            if (i % 13 == 12)
+                ++sentBy12;
+        }
+        searchLineEdit->setText(QStringLiteral("sender12@example.com"));
+        QCOMPARE(view->model()->rowCount(), sentBy12);
+        // Not in the markup
+        searchLineEdit->setText(QStringLiteral("</h2>"));
+        QCOMPARE(view->model()->rowCount(), 0);
+        searchLineEdit->setText(QStringLiteral("<br/>"));
+        QCOMPARE(view->model()->rowCount(), 0);
+        searchLineEdit->clear();
+        QCOMPARE(view->model()->rowCount(), s_historySize);
+    }
+};
+
+QTEST_MAIN(TestNotesWindow)
+#include "test_noteswindow.moc"
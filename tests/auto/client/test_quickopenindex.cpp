@@ -0,0 +1,257 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "quickopenindex.h"
+
+#include "kdcrmdata/kdcrmutils.h"
+#include "kdcrmdata/sugaraccount.h"
+#include "kdcrmdata/sugaropportunity.h"
+#include "kdcrmdata/sugarcontactwrapper.h"
+
+#include <KContacts/Addressee>
+#include <AkonadiCore/EntityTreeModel>
+
+#include <QStandardItemModel>
+#include <QTest>
+
+class TestQuickOpenIndex : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QDateTime modified(int day)
+    {
+        return QDateTime(QDate(2020, 1, day), QTime(12, 0));
+    }
+
+    static QStandardItem *makeRow(const Akonadi::Item &item, const QString &name)
+    {
+        auto *row = new QStandardItem(name);
+        row->setData(QVariant::fromValue(item), Akonadi::EntityTreeModel::ItemRole);
+        return row;
+    }
+
+    static Akonadi::Item accountItem(Akonadi::Item::Id itemId, const QString &id, const QString &name, int day)
+    {
+        SugarAccount account;
+        account.setId(id);
+        account.setName(name);
+        account.setDateModified(modified(day));
+        Akonadi::Item item(itemId);
+        item.setPayload(account);
+        return item;
+    }
+
+    static QStandardItem *accountRow(Akonadi::Item::Id itemId, const QString &id, const QString &name, int day)
+    {
+        return makeRow(accountItem(itemId, id, name, day), name);
+    }
+
+    static Akonadi::Item opportunityItem(Akonadi::Item::Id itemId, const QString &id, const QString &name, int day)
+    {
+        SugarOpportunity opportunity;
+        opportunity.setId(id);
+        opportunity.setName(name);
+        opportunity.setDateModified(modified(day));
+        Akonadi::Item item(itemId);
+        item.setPayload(opportunity);
+        return item;
+    }
+
+    static QStandardItem *opportunityRow(Akonadi::Item::Id itemId, const QString &id, const QString &name, int day)
+    {
+        return makeRow(opportunityItem(itemId, id, name, day), name);
+    }
+
+    static void setItem(QStandardItemModel &model, int row, const Akonadi::Item &item)
+    {
+        model.item(row)->setData(QVariant::fromValue(item), Akonadi::EntityTreeModel::ItemRole);
+    }
+
+    static QStandardItem *contactRow(Akonadi::Item::Id itemId, const QString &id, const QString &givenName, const QString &familyName, int day)
+    {
+        KContacts::Addressee addressee;
+        addressee.setGivenName(givenName);
+        addressee.setFamilyName(familyName);
+        SugarContactWrapper wrapper(addressee);
+        wrapper.setId(id);
+        wrapper.setDateModified(KDCRMUtils::dateTimeToString(modified(day)));
+        Akonadi::Item item(itemId);
+        item.setPayload(addressee);
+        return makeRow(item, addressee.assembledName());
+    }
+
+    static QStringList ids(const QVector<QuickOpenIndex::Match> &matches)
+    {
+        QStringList result;
+        for (const QuickOpenIndex::Match &match : matches) {
+            result.append(match.id);
+        }
+        return result;
+    }
+
+    QStandardItemModel mAccounts;
+    QStandardItemModel mOpportunities;
+    QStandardItemModel mContacts;
+    std::unique_ptr<QuickOpenIndex> mIndex;
+
+private Q_SLOTS:
+    void init()
+    {
+        mAccounts.clear();
+        mAccounts.appendRow(accountRow(1, QStringLiteral("acc-acme"), QStringLiteral("Acme GmbH"), 1));
+        mAccounts.appendRow(accountRow(2, QStringLiteral("acc-globex"), QStringLiteral("Globex Corporation"), 2));
+        mOpportunities.clear();
+        mOpportunities.appendRow(opportunityRow(10, QStringLiteral("opp-old"), QStringLiteral("Acme support contract"), 3));
+        mOpportunities.appendRow(opportunityRow(11, QStringLiteral("opp-new"), QStringLiteral("Acme training"), 5));
+        mContacts.clear();
+        mContacts.appendRow(contactRow(20, QStringLiteral("contact-anna"), QStringLiteral("Anna"), QStringLiteral("Acmeson"), 4));
+        mIndex.reset(new QuickOpenIndex);
+        mIndex->addModel(DetailsType::Account, &mAccounts);
+        mIndex->addModel(DetailsType::Opportunity, &mOpportunities);
+        mIndex->addModel(DetailsType::Contact, &mContacts);
+    }
+
+    void shouldIndexExistingRows()
+    {
+        QCOMPARE(mIndex->count(), 5);
+        const QVector<QuickOpenIndex::Match> matches = mIndex->search(QStringLiteral("globex"));
+        QCOMPARE(matches.count(), 1);
+        QCOMPARE(matches.at(0).type, DetailsType::Account);
+        QCOMPARE(matches.at(0).id, QStringLiteral("acc-globex"));
+        QCOMPARE(matches.at(0).name, QStringLiteral("Globex Corporation"));
+        QCOMPARE(matches.at(0).lastModified, modified(2));
+        QVERIFY(mIndex->search(QStringLiteral("initech")).isEmpty());
+        QVERIFY(mIndex->search(QStringLiteral(" ")).isEmpty());
+    }
+
+    void shouldMatchWordPrefixesAndSubstrings()
+    {
+        // one or two letters: start of a word only
+        QCOMPARE(ids(mIndex->search(QStringLiteral("co"))), QStringList({ "acc-globex", "opp-old" }));
+        QCOMPARE(ids(mIndex->search(QStringLiteral("bex"))), QStringList({ "acc-globex" })); // three letters: anywhere in a word
+        QVERIFY(mIndex->search(QStringLiteral("ex")).isEmpty());
+        // all words must match, case-insensitively, punctuation ignored
+        QCOMPARE(ids(mIndex->search(QStringLiteral("ACME, tr"))), QStringList({ "opp-new" }));
+        QCOMPARE(ids(mIndex->search(QStringLiteral("anna acm"))), QStringList({ "contact-anna" }));
+    }
+
+    void shouldRankByMatchTypeAndRecency()
+    {
+        // WHEN
+        const QVector<QuickOpenIndex::Match> matches = mIndex->search(QStringLiteral("acme"));
+
+        // THEN names starting with the query come first (account before opportunities, newest opportunity first),
+        // then the contact, which only matches in the middle of a word
+        QCOMPARE(ids(matches), QStringList({ "acc-acme", "opp-new", "opp-old", "contact-anna" }));
+        QCOMPARE(ids(mIndex->search(QStringLiteral("acme gmbh"))), QStringList({ "acc-acme" }));
+        QCOMPARE(ids(mIndex->search(QStringLiteral("acme"), 2)), QStringList({ "acc-acme", "opp-new" }));
+    }
+
+    void shouldFollowInsertsAndRemovals()
+    {
+        // WHEN
+        mAccounts.appendRow(accountRow(3, QStringLiteral("acc-initech"), QStringLiteral("Initech"), 6));
+        mOpportunities.removeRow(0);
+
+        // THEN
+        QCOMPARE(mIndex->count(), 5);
+        QCOMPARE(ids(mIndex->search(QStringLiteral("init"))), QStringList({ "acc-initech" }));
+        QCOMPARE(ids(mIndex->search(QStringLiteral("support"))), QStringList());
+        QCOMPARE(ids(mIndex->search(QStringLiteral("acme"))), QStringList({ "acc-acme", "opp-new", "contact-anna" }));
+    }
+
+    void shouldFollowRemovalsOfSeveralRows()
+    {
+        // GIVEN
+        mAccounts.appendRow(accountRow(3, QStringLiteral("acc-acme-berlin"), QStringLiteral("Acme Berlin"), 6));
+
+        // WHEN
+        mAccounts.removeRows(0, 2);
+
+        // THEN
+        QCOMPARE(mIndex->count(), 4);
+        QVERIFY(mIndex->search(QStringLiteral("globex")).isEmpty());
+        QCOMPARE(ids(mIndex->search(QStringLiteral("acme"))), QStringList({ "acc-acme-berlin", "opp-new", "opp-old", "contact-anna" }));
+
+        // and slots get reused
+        mAccounts.appendRow(accountRow(4, QStringLiteral("acc-initech"), QStringLiteral("Initech"), 7));
+        mAccounts.appendRow(accountRow(5, QStringLiteral("acc-hooli"), QStringLiteral("Hooli"), 8));
+        QCOMPARE(mIndex->count(), 6);
+        QCOMPARE(ids(mIndex->search(QStringLiteral("in"))), QStringList({ "acc-initech" }));
+    }
+
+    void shouldFollowEdits()
+    {
+        // WHEN an account is renamed
+        setItem(mAccounts, 0, accountItem(1, QStringLiteral("acc-acme"), QStringLiteral("Wayne Enterprises"), 7));
+
+        // THEN the old name doesn't match anymore
+        QCOMPARE(mIndex->count(), 5);
+        QCOMPARE(ids(mIndex->search(QStringLiteral("wayne"))), QStringList({ "acc-acme" }));
+        QCOMPARE(ids(mIndex->search(QStringLiteral("gmbh"))), QStringList());
+        QCOMPARE(mIndex->search(QStringLiteral("wayne")).at(0).lastModified, modified(7));
+
+        // WHEN an opportunity is modified more recently than the other
+        setItem(mOpportunities, 0, opportunityItem(10, QStringLiteral("opp-old"), QStringLiteral("Acme support contract"), 8));
+
+        // THEN it comes first
+        QCOMPARE(ids(mIndex->search(QStringLiteral("acme"))), QStringList({ "opp-old", "opp-new", "contact-anna" }));
+    }
+
+    void shouldIndexItemsOnceTheyHaveAnId()
+    {
+        // GIVEN an item created locally, not synchronized yet
+        mAccounts.appendRow(accountRow(4, QString(), QStringLiteral("Hooli"), 9));
+        QVERIFY(mIndex->search(QStringLiteral("hooli")).isEmpty());
+
+        // WHEN the server assigns an id
+        setItem(mAccounts, 2, accountItem(4, QStringLiteral("acc-hooli"), QStringLiteral("Hooli"), 9));
+
+        // THEN
+        QCOMPARE(ids(mIndex->search(QStringLiteral("hooli"))), QStringList({ "acc-hooli" }));
+    }
+
+    void shouldRebuildOnReset()
+    {
+        // WHEN
+        mOpportunities.clear();
+
+        // THEN
+        QCOMPARE(mIndex->count(), 3);
+        QCOMPARE(ids(mIndex->search(QStringLiteral("acme"))), QStringList({ "acc-acme", "contact-anna" }));
+
+        // and slots get reused
+        mOpportunities.appendRow(opportunityRow(12, QStringLiteral("opp-x"), QStringLiteral("Acme renewal"), 9));
+        QCOMPARE(ids(mIndex->search(QStringLiteral("acme re"))), QStringList({ "opp-x" }));
+    }
+
+    void shouldForgetRemovedModels()
+    {
+        mIndex->removeModel(&mAccounts);
+        QCOMPARE(mIndex->count(), 3);
+        QVERIFY(mIndex->search(QStringLiteral("globex")).isEmpty());
+        mAccounts.appendRow(accountRow(3, QStringLiteral("acc-initech"), QStringLiteral("Initech"), 6));
+        QCOMPARE(mIndex->count(), 3);
+    }
+};
+
+QTEST_MAIN(TestQuickOpenIndex)
+#include "test_quickopenindex.moc"
@@ -0,0 +1,269 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "savedsearchindex.h"
+#include "opportunityfilterproxymodel.h"
+#include "opportunityfiltersettings.h"
+
+#include "kdcrmdata/kdcrmfields.h"
+#include "kdcrmdata/sugaropportunity.h"
+
+#include <AkonadiCore/EntityTreeModel>
+
+#include <QDebug>
+#include <QSignalSpy>
+#include <QStandardItemModel>
+#include <QTest>
+
+#include <random>
+
+class TestSavedSearchIndex : public QObject
+{
+    Q_OBJECT
+
+private:
+    // Random but reproducible opportunities, with a small set of values so that every search matches some
+    SugarOpportunity randomOpportunity(Akonadi::Item::Id id)
+    {
+        static const QStringList users = { "Alice", "Bob", "Carol" };
+        static const QStringList stages = { "Prospecting", "Proposal", "Closed Won", "Closed Lost" };
+        static const QStringList priorities = { "A", "B", "" };
+        static const QStringList words = { "deal", "renewal", "upsell", "pilot" };
+        const QDate baseDate(2020, 1, 1);
+        SugarOpportunity opportunity;
+        opportunity.setId(QStringLiteral("opp-%1").arg(id));
+        opportunity.setName(QStringLiteral("Opportunity %1 %2").arg(id).arg(words.at(random(words.count()))));
+        opportunity.setAssignedUserName(users.at(random(users.count())));
+        opportunity.setSalesStage(stages.at(random(stages.count())));
+        opportunity.setCustomField(KDCRMFields::opportunityPriority(), priorities.at(random(priorities.count())));
+        if (random(4) != 0)
+            opportunity.setNextCallDate(baseDate.addDays(random(365)));
+        opportunity.setDateModified(QDateTime(baseDate.addDays(random(365)), QTime(12, 0)));
+        return opportunity;
+    }
+
+    void setOpportunity(QStandardItem *row, Akonadi::Item::Id id)
+    {
+        Akonadi::Item item(id);
+        item.setMimeType(SugarOpportunity::mimeType());
+        item.setPayload(randomOpportunity(id));
+        row->setData(QVariant::fromValue(item), Akonadi::EntityTreeModel::ItemRole);
+    }
+
+    QStandardItem *makeRow()
+    {
+        auto *row = new QStandardItem;
+        setOpportunity(row, ++mLastId);
+        return row;
+    }
+
+    int random(int bound)
+    {
+        return std::uniform_int_distribution<int>(0, bound - 1)(mRandom);
+    }
+
+    void fillModel(int rows)
+    {
+        for (int i = 0; i < rows; ++i) {
+            mModel.appendRow(makeRow());
+        }
+    }
+
+    // One random change: insert, remove, modify, and sometimes a reset
+    void randomEdit()
+    {
+        const int action = random(100);
+        const int rowCount = mModel.rowCount();
+        if (action < 2) {
+            mModel.clear();
+            fillModel(random(50));
+        } else if (action < 35 || rowCount == 0) {
+            mModel.insertRow(random(rowCount + 1), makeRow());
+        } else if (action < 60) {
+            mModel.removeRows(random(rowCount), 1);
+        } else {
+            QStandardItem *row = mModel.item(random(rowCount));
+            const Akonadi::Item item = row->data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>();
+            setOpportunity(row, item.id());
+        }
+    }
+
+    // The reference: filter all rows from scratch
+    QSet<Akonadi::Item::Id> refilter(const OpportunityFilterSettings &settings) const
+    {
+        QSet<Akonadi::Item::Id> result;
+        for (int row = 0; row < mModel.rowCount(); ++row) {
+            const Akonadi::Item item = mModel.index(row, 0).data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>();
+            const SugarOpportunity opportunity = item.payload<SugarOpportunity>();
+            if (settings.matches(opportunity) &&
+                    (settings.searchText().isEmpty() || OpportunityFilterSettings::matchesSearchText(opportunity, settings.searchText()))) {
+                result.insert(item.id());
+            }
+        }
+        return result;
+    }
+
+    static QVector<OpportunityFilterSettings> searches()
+    {
+        QVector<OpportunityFilterSettings> result;
+        OpportunityFilterSettings mine;
+        mine.setSearchName(QStringLiteral("Alice's open"));
+        mine.setAssignees({QStringLiteral("Alice")}, QStringLiteral("Me"));
+        mine.setShownPriority(QStringLiteral("-"));
+        result.append(mine);
+
+        OpportunityFilterSettings priorityA;
+        priorityA.setSearchName(QStringLiteral("All A"));
+        priorityA.setShowOpenClosed(true, true, true);
+        priorityA.setShownPriority(QStringLiteral("A"));
+        result.append(priorityA);
+
+        OpportunityFilterSettings wonEarly;
+        wonEarly.setSearchName(QStringLiteral("Won, next step before June"));
+        wonEarly.setShowOpenClosed(false, true, false);
+        wonEarly.setMaxDate(QDate(2020, 6, 1), CustomDate);
+        wonEarly.setShownPriority(QStringLiteral("-"));
+        result.append(wonEarly);
+
+        OpportunityFilterSettings modified;
+        modified.setSearchName(QStringLiteral("Modified in spring"));
+        modified.setShowOpenClosed(true, false, true);
+        modified.setModifiedAfter(QDate(2020, 3, 1));
+        modified.setModifiedBefore(QDate(2020, 5, 31));
+        modified.setShownPriority(QStringLiteral("Not set"));
+        result.append(modified);
+
+        OpportunityFilterSettings deals;
+        deals.setSearchName(QStringLiteral("Deals"));
+        deals.setShowOpenClosed(true, true, true);
+        deals.setShownPriority(QStringLiteral("-"));
+        deals.setSearchText(QStringLiteral("deal"));
+        result.append(deals);
+        return result;
+    }
+
+    void compareWithRefilter()
+    {
+        const QVector<OpportunityFilterSettings> settingsList = searches();
+        for (const OpportunityFilterSettings &settings : settingsList) {
+            const QSet<Akonadi::Item::Id> expected = refilter(settings);
+            const QSet<Akonadi::Item::Id> *items = mIndex->matchingItems(settings, settings.searchText());
+            QVERIFY(items);
+            QCOMPARE(*items, expected);
+            QCOMPARE(mIndex->count(settings.searchName()), expected.count());
+        }
+    }
+
+    std::mt19937 mRandom;
+    Akonadi::Item::Id mLastId = 0;
+    QStandardItemModel mModel;
+    std::unique_ptr<SavedSearchIndex> mIndex;
+
+private Q_SLOTS:
+    void init()
+    {
+        mRandom.seed(42);
+        mLastId = 0;
+        mModel.clear();
+        fillModel(100);
+        mIndex.reset(new SavedSearchIndex);
+        mIndex->setModel(&mModel);
+        mIndex->setSearches(searches());
+    }
+
+    void shouldMaterializeExistingRows()
+    {
+        QCOMPARE(mIndex->searchNames().count(), searches().count());
+        QCOMPARE(mIndex->count(QStringLiteral("unknown")), -1);
+        compareWithRefilter();
+        QVERIFY(mIndex->count(QStringLiteral("Deals")) > 0);
+    }
+
+    void shouldMatchRefilterAfterRandomEdits()
+    {
+        for (int step = 0; step < 1000; ++step) {
+            randomEdit();
+            compareWithRefilter();
+            if (QTest::currentTestFailed()) {
+                qWarning() << "Failed after edit" << step;
+                return;
+            }
+        }
+    }
+
+    void shouldOnlyReturnResultSetsForTheSameFilter()
+    {
+        // GIVEN a filter equivalent to a saved search, but with other group and search names
+        OpportunityFilterSettings settings = searches().at(0);
+        settings.setAssignees(settings.assignees(), QStringLiteral("Someone"));
+        settings.setSearchName(QString());
+
+        // WHEN/THEN
+        QVERIFY(mIndex->matchingItems(settings, QString()));
+        QVERIFY(!mIndex->matchingItems(settings, QStringLiteral("deal")));
+        settings.setShowOpenClosed(true, true, false);
+        QVERIFY(!mIndex->matchingItems(settings, QString()));
+    }
+
+    void shouldFilterProxyLikeARefilter()
+    {
+        // GIVEN a proxy whose filter is one of the saved searches
+        OpportunityFilterProxyModel proxy;
+        proxy.setSourceModel(&mModel);
+        proxy.savedSearchIndex()->setSearches(searches());
+        const OpportunityFilterSettings settings = searches().at(4);
+
+        // WHEN switching to it and editing the source model
+        proxy.setFilter(settings, settings.searchText());
+        QVERIFY(proxy.savedSearchIndex()->matchingItems(settings, proxy.filterString()));
+        for (int step = 0; step < 300; ++step) {
+            randomEdit();
+
+            // THEN the proxy shows the same rows as a full refilter
+            QSet<Akonadi::Item::Id> shown;
+            for (int row = 0; row < proxy.rowCount(); ++row) {
+                shown.insert(proxy.index(row, 0).data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>().id());
+            }
+            QCOMPARE(shown, refilter(settings));
+        }
+    }
+
+    void shouldKeepResultSetsWhenSearchesAreUnchanged()
+    {
+        // GIVEN
+        QSignalSpy spy(mIndex.get(), &SavedSearchIndex::searchesChanged);
+
+        // WHEN setting the same searches again (e.g. the recently used list changed)
+        mIndex->setSearches(searches());
+
+        // THEN
+        QCOMPARE(spy.count(), 0);
+
+        // WHEN removing one
+        mIndex->setSearches(searches().mid(1));
+
+        // THEN
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(mIndex->count(QStringLiteral("Alice's open")), -1);
+    }
+};
+
+QTEST_MAIN(TestSavedSearchIndex)
+#include "test_savedsearchindex.moc"
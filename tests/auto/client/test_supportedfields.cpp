@@ -0,0 +1,117 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "supportedfields.h"
+
+#include <QTest>
+
+class TestSupportedFields : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void shouldBeEmptyByDefault()
+    {
+        // GIVEN
+        const SupportedFields fields;
+
+        // THEN
+        QVERIFY(fields.isEmpty());
+        QCOMPARE(fields.count(), 0);
+        QVERIFY(!fields.contains(QStringLiteral("id")));
+        QVERIFY(fields.toStringList().isEmpty());
+    }
+
+    void shouldContainListedFields()
+    {
+        // GIVEN
+        const QStringList list{QStringLiteral("id"), QStringLiteral("name"), QStringLiteral("amount")};
+
+        // WHEN
+        const SupportedFields fields(list);
+
+        // THEN
+        QCOMPARE(fields.count(), 3);
+        QVERIFY(fields.contains(QStringLiteral("id")));
+        QVERIFY(fields.contains(QStringLiteral("name")));
+        QVERIFY(fields.contains(QStringLiteral("amount")));
+        QVERIFY(!fields.contains(QStringLiteral("sales_stage")));
+        QVERIFY(fields.contains(SupportedFields::fieldNumber(QStringLiteral("name"))));
+        QCOMPARE(fields.toStringList(), list);
+    }
+
+    void shouldNotNumberUnknownFields()
+    {
+        // GIVEN
+        const SupportedFields fields(QStringList{QStringLiteral("id")});
+
+        // WHEN
+        const bool found = fields.contains(QStringLiteral("never_seen_field"));
+
+        // THEN
+        QVERIFY(!found);
+        QCOMPARE(SupportedFields::fieldNumber(QStringLiteral("never_seen_field")), -1);
+        QVERIFY(!fields.contains(-1));
+    }
+
+    void shouldIgnoreDuplicates()
+    {
+        // GIVEN
+        const SupportedFields fields(QStringList{QStringLiteral("id"), QStringLiteral("name"), QStringLiteral("id")});
+
+        // THEN
+        QCOMPARE(fields.count(), 2);
+        QCOMPARE(fields, SupportedFields(QStringList{QStringLiteral("name"), QStringLiteral("id")}));
+    }
+
+    void shouldCompareAcrossNewFields()
+    {
+        // GIVEN a set created before more fields were numbered (so with a smaller bitset)
+        const SupportedFields before(QStringList{QStringLiteral("id"), QStringLiteral("description")});
+
+        // WHEN
+        const SupportedFields larger(QStringList{QStringLiteral("id"), QStringLiteral("description"), QStringLiteral("added_field_1")});
+        const SupportedFields after(QStringList{QStringLiteral("description"), QStringLiteral("id")});
+
+        // THEN
+        QVERIFY(before == after);
+        QVERIFY(after == before);
+        QVERIFY(before != larger);
+        QVERIFY(larger != before);
+        QVERIFY(!before.contains(QStringLiteral("added_field_1")));
+        QVERIFY(larger.contains(QStringLiteral("added_field_1")));
+    }
+
+    void shouldDifferWithSameCount()
+    {
+        // GIVEN
+        const SupportedFields fields1(QStringList{QStringLiteral("id"), QStringLiteral("name")});
+
+        // WHEN
+        const SupportedFields fields2(QStringList{QStringLiteral("id"), QStringLiteral("amount")});
+
+        // THEN
+        QVERIFY(fields1 != fields2);
+        QVERIFY(SupportedFields() != fields1);
+        QVERIFY(SupportedFields() == SupportedFields(QStringList()));
+    }
+};
+
+QTEST_MAIN(TestSupportedFields)
+#include "test_supportedfields.moc"
@@ -0,0 +1,187 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "collectionmanager.h"
+
+#include "enumdefinitionattribute.h"
+#include "sugaropportunity.h"
+
+#include <AkonadiCore/AgentInstance>
+#include <AkonadiCore/AgentManager>
+#include <AkonadiCore/AttributeFactory>
+#include <AkonadiCore/Collection>
+#include <AkonadiCore/CollectionFetchJob>
+#include <AkonadiCore/CollectionFetchScope>
+#include <AkonadiCore/EntityAnnotationsAttribute>
+#include <AkonadiCore/qtest_akonadi.h>
+
+#include <QSignalSpy>
+
+#include <QTest>
+
+#include <algorithm>
+
+using namespace Akonadi;
+
+static const char s_resource[] = "akonadi_sugarcrm_resource_0";
+static const char s_supportedFieldsKey[] = "supportedFields"; // duplicated in collectionmanager.cpp
+
+/**
+ * Tests how CollectionManager keeps the supported fields of the main collections up to date,
+ * when the resource changes the collection attributes.
+ */
+class TestCollectionManager : public QObject
+{
+    Q_OBJECT
+
+private:
+    Collection mOpportunitiesCollection;
+
+    // Waits until the resource has stored the supported fields and enum definitions of every collection,
+    // otherwise CollectionManager would show message boxes about them.
+    static bool waitForCollectionAttributes()
+    {
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            auto *job = new CollectionFetchJob(Collection::root(), CollectionFetchJob::Recursive);
+            job->fetchScope().setResource(s_resource);
+            if (!job->exec()) {
+                return false;
+            }
+            const Collection::List collections = job->collections();
+            const bool complete = std::all_of(collections.begin(), collections.end(), [](const Collection &collection) {
+                if (collection.contentMimeTypes().at(0) == QLatin1String("inode/directory"))
+                    return true;
+                const auto *annotations = collection.attribute<EntityAnnotationsAttribute>();
+                return annotations && !annotations->value(s_supportedFieldsKey).isEmpty()
+                        && collection.hasAttribute<EnumDefinitionAttribute>();
+            });
+            if (complete)
+                return true;
+            QTest::qWait(100);
+        }
+        return false;
+    }
+
+    static Collection withSupportedFields(const Collection &collection, const QStringList &fields)
+    {
+        Collection changed = collection;
+        changed.attribute<EntityAnnotationsAttribute>(Collection::AddIfMissing)->insert(s_supportedFieldsKey, fields.join(QLatin1Char(',')));
+        return changed;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        AkonadiTest::checkTestIsIsolated();
+        AttributeFactory::registerAttribute<EnumDefinitionAttribute>();
+
+        AgentManager::self()->instance(s_resource).synchronize();
+        QVERIFY(waitForCollectionAttributes());
+
+        auto *fetchJob = new CollectionFetchJob(Collection::root(), CollectionFetchJob::Recursive);
+        fetchJob->fetchScope().setResource(s_resource);
+        AKVERIFYEXEC(fetchJob);
+        const Collection::List collections = fetchJob->collections();
+        for (const Collection &collection : collections) {
+            if (collection.name() == QLatin1String("Opportunities")) {
+                mOpportunitiesCollection = collection;
+            }
+        }
+        QVERIFY(mOpportunitiesCollection.isValid());
+    }
+
+    void shouldReadSupportedFieldsInitially()
+    {
+        // GIVEN
+        CollectionManager collectionManager;
+        QSignalSpy listedSpy(&collectionManager, &CollectionManager::collectionsListed);
+
+        // WHEN
+        collectionManager.setResource(s_resource);
+        QVERIFY(listedSpy.wait());
+
+        // THEN
+        const Collection::Id collectionId = collectionManager.collectionIdForType(DetailsType::Opportunity);
+        QCOMPARE(collectionId, mOpportunitiesCollection.id());
+        const QStringList expectedFields = mOpportunitiesCollection.attribute<EntityAnnotationsAttribute>()->value(s_supportedFieldsKey).split(QLatin1Char(','));
+        QCOMPARE(collectionManager.supportedFields(collectionId), SupportedFields(expectedFields));
+        QVERIFY(collectionManager.hasField(collectionId, QStringLiteral("id")));
+        QVERIFY(collectionManager.hasField(collectionId, QStringLiteral("sales_stage")));
+        QVERIFY(!collectionManager.hasField(collectionId, QStringLiteral("no_such_field")));
+        QVERIFY(!collectionManager.hasField(-1, QStringLiteral("id")));
+    }
+
+    void shouldNotifyAttributeUpdates()
+    {
+        // GIVEN
+        CollectionManager collectionManager;
+        QSignalSpy listedSpy(&collectionManager, &CollectionManager::collectionsListed);
+        collectionManager.setResource(s_resource);
+        QVERIFY(listedSpy.wait());
+        const Collection::Id collectionId = mOpportunitiesCollection.id();
+        QSignalSpy changedSpy(&collectionManager, &CollectionManager::supportedFieldsChanged);
+        const QStringList newFields{QStringLiteral("id"), QStringLiteral("name"), QStringLiteral("new_custom_field_c")};
+
+        // WHEN
+        collectionManager.slotCollectionChanged(withSupportedFields(mOpportunitiesCollection, newFields), {"entityannotations"});
+
+        // THEN
+        QCOMPARE(changedSpy.count(), 1);
+        QCOMPARE(changedSpy.at(0).at(0).value<Collection::Id>(), collectionId);
+        QVERIFY(collectionManager.hasField(collectionId, QStringLiteral("new_custom_field_c")));
+        QVERIFY(!collectionManager.hasField(collectionId, QStringLiteral("sales_stage")));
+        QCOMPARE(collectionManager.supportedFields(collectionId).toStringList().count(), 3);
+
+        // WHEN the same fields come again, in another order
+        changedSpy.clear();
+        collectionManager.slotCollectionChanged(withSupportedFields(mOpportunitiesCollection, {newFields.at(2), newFields.at(1), newFields.at(0)}), {"entityannotations"});
+
+        // THEN
+        QCOMPARE(changedSpy.count(), 0);
+
+        // WHEN only the enum definitions changed
+        collectionManager.slotCollectionChanged(mOpportunitiesCollection, {"CRM-enumdefinitions"});
+
+        // THEN
+        QCOMPARE(changedSpy.count(), 0);
+        QVERIFY(collectionManager.hasField(collectionId, QStringLiteral("new_custom_field_c")));
+    }
+
+    void shouldIgnoreOtherCollections()
+    {
+        // GIVEN
+        CollectionManager collectionManager;
+        QSignalSpy listedSpy(&collectionManager, &CollectionManager::collectionsListed);
+        collectionManager.setResource(s_resource);
+        QVERIFY(listedSpy.wait());
+        QSignalSpy changedSpy(&collectionManager, &CollectionManager::supportedFieldsChanged);
+        Collection unknownCollection(mOpportunitiesCollection.id() + 1000);
+        unknownCollection.setContentMimeTypes({SugarOpportunity::mimeType()});
+
+        // WHEN
+        collectionManager.slotCollectionChanged(withSupportedFields(unknownCollection, {QStringLiteral("id")}), {"entityannotations"});
+
+        // THEN
+        QCOMPARE(changedSpy.count(), 0);
+        QVERIFY(!collectionManager.hasField(unknownCollection.id(), QStringLiteral("id")));
+    }
+};
+
+QTEST_AKONADIMAIN(TestCollectionManager)
+#include "test_collectionmanager.moc"
@@ -0,0 +1,400 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "accountrepository.h"
+#include "itemexporter.h"
+#include "itemstreemodel.h"
+#include "opportunityfilterproxymodel.h"
+#include "opportunityfiltersettings.h"
+#include "rearrangecolumnsproxymodel.h"
+#include "referenceddata.h"
+
+#include "kdcrmfields.h"
+#include "sugaraccount.h"
+#include "sugarcontactwrapper.h"
+#include "sugaropportunity.h"
+
+#include <AkonadiCore/AgentManager>
+#include <AkonadiCore/ChangeRecorder>
+#include <AkonadiCore/Collection>
+#include <AkonadiCore/CollectionFetchJob>
+#include <AkonadiCore/CollectionFetchScope>
+#include <AkonadiCore/Item>
+#include <AkonadiCore/ItemCreateJob>
+#include <AkonadiCore/ItemFetchJob>
+#include <AkonadiCore/ItemFetchScope>
+#include <AkonadiCore/qtest_akonadi.h>
+
+#include <KContacts/Addressee>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+
+#include <QTest>
+
+Q_DECLARE_METATYPE(OpportunityFilterSettings)
+
+using namespace Akonadi;
+
+static const char s_resource[] = "akonadi_sugarcrm_resource_0";
+
+/**
+ * Runs fatcrm-export against the SugarCRM resource (with the Mock protocol behind it),
+ * and compares its output with what the opportunities page exports
+ * (ItemsTreeModel + OpportunityFilterProxyModel + Page::exportToCSV).
+ */
+class TestFatCRMExport : public QObject
+{
+    Q_OBJECT
+
+private:
+    Collection mAccountsCollection;
+    Collection mOpportunitiesCollection;
+    Collection mContactsCollection;
+
+    // Waits until the resource has written back the ids assigned by the server
+    template<typename T>
+    static QVector<T> waitForCommittedPayloads(const Collection &collection, int expectedCount)
+    {
+        QVector<T> payloads;
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            auto *job = new ItemFetchJob(collection);
+            job->fetchScope().fetchFullPayload(true);
+            if (!job->exec()) {
+                return {};
+            }
+            payloads.clear();
+            const Item::List items = job->items();
+            for (const Item &item : items) {
+                if (item.hasPayload<T>() && !item.payload<T>().id().isEmpty())
+                    payloads.append(item.payload<T>());
+            }
+            if (payloads.count() == expectedCount)
+                return payloads;
+            QTest::qWait(100);
+        }
+        return {};
+    }
+
+    static QStringList runExporter(const QStringList &arguments)
+    {
+        QProcess process;
+        process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        process.start(QStringLiteral(FATCRM_EXPORT_EXECUTABLE), QStringList{"--resource", s_resource} + arguments);
+        if (!process.waitForFinished(30000) || process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+            qWarning() << "fatcrm-export failed:" << process.exitCode() << process.errorString();
+            return {QStringLiteral("ERROR")};
+        }
+        const QString output = QString::fromUtf8(process.readAllStandardOutput());
+        return output.split('\n', QString::SkipEmptyParts);
+    }
+
+    // What Page::exportToCSV writes for the opportunities page with the default columns
+    QStringList guiExport(const OpportunityFilterSettings &settings, const QString &searchText)
+    {
+        ChangeRecorder changeRecorder;
+        changeRecorder.setCollectionMonitored(mOpportunitiesCollection, true);
+        changeRecorder.itemFetchScope().fetchFullPayload(true);
+        ItemsTreeModel model(DetailsType::Opportunity, &changeRecorder);
+        OpportunityFilterProxyModel filterModel;
+        filterModel.setSourceModel(&model);
+        filterModel.setFilter(settings);
+        filterModel.setFilterString(searchText);
+        for (int attempt = 0; attempt < 100 && !model.isCollectionPopulated(mOpportunitiesCollection.id()); ++attempt) {
+            QTest::qWait(100);
+        }
+        if (!model.isCollectionPopulated(mOpportunitiesCollection.id()))
+            return {QStringLiteral("ERROR")};
+
+        const ItemsTreeModel::ColumnTypes allColumns = model.columnTypes();
+        QVector<int> sourceColumns;
+        const ItemsTreeModel::ColumnTypes visibleColumns = model.defaultVisibleColumns();
+        for (ItemsTreeModel::ColumnType column : visibleColumns) {
+            sourceColumns.append(allColumns.indexOf(column));
+        }
+        RearrangeColumnsProxyModel rearrangeColumnsProxy;
+        rearrangeColumnsProxy.setSourceColumns(sourceColumns);
+        rearrangeColumnsProxy.setSourceModel(&filterModel);
+
+        QStringList lines;
+        for (int row = 0; row < rearrangeColumnsProxy.rowCount(); ++row) {
+            QStringList cells;
+            for (int column = 0; column < rearrangeColumnsProxy.columnCount(); ++column) {
+                cells.append(rearrangeColumnsProxy.index(row, column).data().toString());
+            }
+            QString line = ItemExporter::csvLine(cells);
+            line.chop(1); // '\n'
+            lines.append(line);
+        }
+        return lines;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        AkonadiTest::checkTestIsIsolated();
+        qRegisterMetaType<Akonadi::Item>();
+        qRegisterMetaType<Akonadi::Collection>();
+
+        auto *fetchJob = new CollectionFetchJob(Collection::root(), CollectionFetchJob::Recursive);
+        fetchJob->fetchScope().setResource(s_resource);
+        AKVERIFYEXEC(fetchJob);
+        const Collection::List collections = fetchJob->collections();
+        for (const Collection &collection : collections) {
+            if (collection.name() == QLatin1String("Accounts")) {
+                mAccountsCollection = collection;
+            } else if (collection.name() == QLatin1String("Opportunities")) {
+                mOpportunitiesCollection = collection;
+            } else if (collection.name() == QLatin1String("Contacts")) {
+                mContactsCollection = collection;
+            }
+        }
+        QVERIFY(mAccountsCollection.isValid());
+        QVERIFY(mOpportunitiesCollection.isValid());
+        QVERIFY(mContactsCollection.isValid());
+
+        // Seed the database: the mock has 3 accounts and 2 opportunities initially
+        const QVector<QPair<QString, QString>> accounts = {
+            { "exportFrance", "France" },
+            { "exportGermany", "Germany" }
+        };
+        for (const auto &accountData : accounts) {
+            SugarAccount account;
+            account.setName(accountData.first);
+            account.setBillingAddressCountry(accountData.second);
+            Item item;
+            item.setMimeType(SugarAccount::mimeType());
+            item.setPayload(account);
+            AKVERIFYEXEC(new ItemCreateJob(item, mAccountsCollection));
+        }
+        const QVector<SugarAccount> committedAccounts = waitForCommittedPayloads<SugarAccount>(mAccountsCollection, 5);
+        QCOMPARE(committedAccounts.count(), 5);
+        auto accountId = [&committedAccounts](const QString &name) {
+            const auto it = std::find_if(committedAccounts.begin(), committedAccounts.end(),
+                                         [&name](const SugarAccount &account) { return account.name() == name; });
+            return it == committedAccounts.end() ? QString() : it->id();
+        };
+
+        struct OpportunityData {
+            QString name;
+            QString account;
+            QString salesStage;
+            QString assignee;
+            QString priority;
+            QDate nextCallDate;
+        };
+        const QVector<OpportunityData> opportunities = {
+            { "openFrance", "exportFrance", "Prospecting", "alice", "A", QDate(2021, 3, 1) },
+            { "wonGermany", "exportGermany", "Closed Won", "bob", "", QDate() },
+            { "lostGermany", "exportGermany", "Closed Lost", "alice", "B", QDate() },
+            { "with, comma", "exportFrance", "Negotiation", "bob", "", QDate(2022, 1, 1) }
+        };
+        for (const OpportunityData &data : opportunities) {
+            SugarOpportunity opportunity;
+            opportunity.setName(data.name);
+            opportunity.setAccountId(accountId(data.account));
+            opportunity.setSalesStage(data.salesStage);
+            opportunity.setAssignedUserName(data.assignee);
+            opportunity.setCustomField(KDCRMFields::opportunityPriority(), data.priority);
+            if (data.nextCallDate.isValid())
+                opportunity.setNextCallDate(data.nextCallDate);
+            Item item;
+            item.setMimeType(SugarOpportunity::mimeType());
+            item.setPayload(opportunity);
+            AKVERIFYEXEC(new ItemCreateJob(item, mOpportunitiesCollection));
+        }
+        QCOMPARE(waitForCommittedPayloads<SugarOpportunity>(mOpportunitiesCollection, 6).count(), 6);
+
+        KContacts::Addressee contact;
+        contact.setGivenName("Jane");
+        contact.setFamilyName("Export");
+        contact.insertEmail("jane@example.com", true);
+        contact.insertPhoneNumber(KContacts::PhoneNumber("+33 1 23 45 67 89", KContacts::PhoneNumber::Work));
+        KContacts::Address address(KContacts::Address::Work | KContacts::Address::Pref);
+        address.setCountry("France");
+        contact.insertAddress(address);
+        SugarContactWrapper(contact).setAccountId(accountId("exportFrance"));
+        Item contactItem;
+        contactItem.setMimeType(KContacts::Addressee::mimeType());
+        contactItem.setPayload(contact);
+        AKVERIFYEXEC(new ItemCreateJob(contactItem, mContactsCollection));
+
+        // The GUI side needs the accounts, like AccountsPage provides them
+        QMap<QString, QString> accountRefMap;
+        for (const SugarAccount &account : committedAccounts) {
+            accountRefMap.insert(account.id(), account.name());
+            AccountRepository::instance()->addAccount(account, 0);
+        }
+        ReferencedData::instance(AccountRef)->addMap(accountRefMap, false);
+    }
+
+    void shouldExportLikeTheOpportunitiesPage_data()
+    {
+        QTest::addColumn<QStringList>("arguments");
+        QTest::addColumn<OpportunityFilterSettings>("settings");
+        QTest::addColumn<QString>("searchText");
+        QTest::addColumn<int>("expectedCount");
+
+        OpportunityFilterSettings defaults;
+        defaults.setShownPriority("-");
+        OpportunityFilterSettings all = defaults;
+        all.setShowOpenClosed(true, true, true);
+
+        // The two opportunities of the mock have no sales stage, so they are open
+        QTest::newRow("default") << QStringList() << defaults << QString() << 4;
+        QTest::newRow("all") << QStringList{"--status", "open,won,lost"} << all << QString() << 6;
+
+        OpportunityFilterSettings won = defaults;
+        won.setShowOpenClosed(false, true, false);
+        QTest::newRow("won") << QStringList{"--status", "won"} << won << QString() << 1;
+
+        OpportunityFilterSettings alice = all;
+        alice.setAssignees({"alice"}, QString());
+        QTest::newRow("assignee") << QStringList{"--status", "open,won,lost", "--assignee", "alice"} << alice << QString() << 2;
+
+        OpportunityFilterSettings germany = all;
+        germany.setCountries({"Germany"}, QString());
+        QTest::newRow("country") << QStringList{"--status", "open,won,lost", "--country", "Germany"} << germany << QString() << 2;
+
+        OpportunityFilterSettings priorityA = defaults;
+        priorityA.setShownPriority("A");
+        QTest::newRow("priority") << QStringList{"--priority", "A"} << priorityA << QString() << 1;
+
+        OpportunityFilterSettings nextStep = defaults;
+        nextStep.setMaxDate(QDate(2021, 6, 30), CustomDate);
+        QTest::newRow("nextStepDate") << QStringList{"--max-next-step-date", "2021-06-30"} << nextStep << QString() << 1;
+
+        QTest::newRow("search") << QStringList{"--search", "comma"} << defaults << QStringLiteral("comma") << 1;
+    }
+
+    void shouldExportLikeTheOpportunitiesPage()
+    {
+        QFETCH(QStringList, arguments);
+        QFETCH(OpportunityFilterSettings, settings);
+        QFETCH(QString, searchText);
+        QFETCH(int, expectedCount);
+
+        // WHEN
+        QStringList exported = runExporter(arguments);
+        QStringList shown = guiExport(settings, searchText);
+
+        // THEN
+        // the page is sorted by the user, the tool writes in Akonadi order
+        exported.sort();
+        shown.sort();
+        QCOMPARE(exported, shown);
+        QCOMPARE(exported.count(), expectedCount);
+    }
+
+    void shouldQuoteCellsWithCommas()
+    {
+        // WHEN
+        const QStringList exported = runExporter({"--search", "comma", "--columns", "OpportunityName,OpportunityAccountName"});
+
+        // THEN
+        QCOMPARE(exported, QStringList{"\"with, comma\",exportFrance,"});
+    }
+
+    void shouldExportJson()
+    {
+        // WHEN
+        const QStringList lines = runExporter({"--format", "json", "--status", "open,won,lost",
+                                               "--columns", "OpportunityName,SalesStage,Country"});
+
+        // THEN
+        QJsonParseError error;
+        const QJsonDocument doc = QJsonDocument::fromJson(lines.join('\n').toUtf8(), &error);
+        QCOMPARE(error.error, QJsonParseError::NoError);
+        const QJsonArray array = doc.array();
+        QCOMPARE(array.count(), 6);
+        bool found = false;
+        for (const QJsonValue &value : array) {
+            const QJsonObject object = value.toObject();
+            QCOMPARE(object.keys().count(), 3);
+            if (object.value("OpportunityName").toString() == QLatin1String("wonGermany")) {
+                QCOMPARE(object.value("SalesStage").toString(), QStringLiteral("Closed Won"));
+                QCOMPARE(object.value("Country").toString(), QStringLiteral("Germany"));
+                found = true;
+            }
+        }
+        QVERIFY(found);
+    }
+
+    void shouldExportAccounts()
+    {
+        // WHEN
+        QStringList exported = runExporter({"--type", "Accounts", "--columns", "Name,Country"});
+
+        // THEN
+        exported.sort();
+        const QStringList expected = {
+            "accountOne,,",
+            "accountTwo,,",
+            "accountZero,,",
+            "exportFrance,France,",
+            "exportGermany,Germany,"
+        };
+        QCOMPARE(exported, expected);
+    }
+
+    void shouldExportContactsWithoutLinkedItemsColumns()
+    {
+        // WHEN exporting the default columns, which include NumberOfDocumentsNotesEmails in the view
+        const QStringList exported = runExporter({"--type", "Contacts"});
+
+        // THEN the linked items column is left out, and the account comes from the accounts
+        QVERIFY(ItemsTreeModel::defaultVisibleColumns(DetailsType::Contact).contains(ItemsTreeModel::NumberOfDocumentsNotesEmails));
+        QCOMPARE(ItemExporter::defaultColumns(DetailsType::Contact),
+                 (ItemsTreeModel::ColumnTypes{ItemsTreeModel::FullName, ItemsTreeModel::Account, ItemsTreeModel::Country,
+                                              ItemsTreeModel::PreferredEmail, ItemsTreeModel::PhoneWork, ItemsTreeModel::PhoneMobile}));
+        const QStringList lines = exported.filter(QStringLiteral("Jane Export"));
+        QCOMPARE(lines, QStringList{"Jane Export,exportFrance,France,jane@example.com,+33 1 23 45 67 89,,"});
+    }
+
+    void shouldFailOnLinkedItemsColumns()
+    {
+        // WHEN
+        QProcess process;
+        process.start(QStringLiteral(FATCRM_EXPORT_EXECUTABLE), {"--resource", s_resource, "--type", "Contacts",
+                                                                  "--columns", "FullName,NumberOfDocumentsNotesEmails"});
+
+        // THEN
+        QVERIFY(process.waitForFinished(30000));
+        QCOMPARE(process.exitCode(), 1);
+        QVERIFY(process.readAllStandardOutput().isEmpty());
+        QVERIFY(process.readAllStandardError().contains("NumberOfDocumentsNotesEmails cannot be exported"));
+    }
+
+    void shouldFailOnUnknownColumns()
+    {
+        // WHEN
+        QProcess process;
+        process.start(QStringLiteral(FATCRM_EXPORT_EXECUTABLE), {"--resource", s_resource, "--columns", "NoSuchColumn"});
+
+        // THEN
+        QVERIFY(process.waitForFinished(30000));
+        QCOMPARE(process.exitCode(), 1);
+        QVERIFY(process.readAllStandardOutput().isEmpty());
+    }
+};
+
+QTEST_AKONADIMAIN(TestFatCRMExport)
+#include "test_fatcrmexport.moc"
@@ -0,0 +1,331 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "syntheticdata.h"
+
+#include "archivetiering.h"
+#include "collectionmanager.h"
+#include "linkeditemsrepository.h"
+#include "referenceddata.h"
+
+#include <QFile>
+#include <QTest>
+
+#include <memory>
+#include <vector>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+// Startup with and without archive tiering, on ten years of history: with the default two-year
+// cutoff, 80% of the notes and emails are cold, as are the opportunities closed before the cutoff.
+// Payloads are generated when "fetched", as the serializer would deserialize them.
+// Defaults to 200k notes and 200k emails, capped by $FATCRM_BENCHMARK_MAX_ITEMS.
+class BenchArchiveTiering : public QObject
+{
+    Q_OBJECT
+
+private:
+    static const int s_years = 10;
+    static const int s_batchSize = 1000; // similar to the ItemFetchJob batches
+
+    // What stays in memory after startup: the repository, and the opportunities held by the ItemsTreeModel
+    struct Session
+    {
+        explicit Session(CollectionManager *collectionManager)
+            : repository(collectionManager)
+        {
+        }
+        LinkedItemsRepository repository;
+        QVector<SugarOpportunity> opportunities;
+    };
+
+    static int historyCount()
+    {
+        const int defaultCount = 200000;
+        return qEnvironmentVariableIsSet("FATCRM_BENCHMARK_MAX_ITEMS")
+                ? qMin(defaultCount, qEnvironmentVariableIntValue("FATCRM_BENCHMARK_MAX_ITEMS")) : defaultCount;
+    }
+
+    static QDateTime now()
+    {
+        return QDateTime(QDate(2021, 1, 1), QTime(12, 0), Qt::UTC);
+    }
+
+    // Evenly spread over the last ten years, oldest first
+    static QDateTime modifiedAt(int index, int count)
+    {
+        const qint64 span = qint64(s_years) * 365 * 24 * 3600;
+        return now().addSecs(-span * (count - 1 - index) / count);
+    }
+
+    static ArchiveTiering archiveTiering(bool enabled)
+    {
+        ArchiveTiering tiering;
+        tiering.setEnabled(enabled);
+        tiering.setCutoffMonths(24);
+        tiering.setReferenceDate(now().date());
+        return tiering;
+    }
+
+    static qint64 residentBytes()
+    {
+#ifdef Q_OS_LINUX
+        QFile statm(QStringLiteral("/proc/self/statm"));
+        if (statm.open(QIODevice::ReadOnly)) {
+            const QList<QByteArray> fields = statm.readAll().split(' ');
+            if (fields.count() > 1)
+                return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+        }
+#endif
+        return -1;
+    }
+
+    int opportunityCount() const
+    {
+        return qMax(1, mCount / 4);
+    }
+
+    SugarNote note(int i) const
+    {
+        SugarNote note;
+        note.setId(QStringLiteral("note-%1").arg(i));
+        note.setName(QStringLiteral("Phone call %1").arg(i));
+        note.setDateModified(modifiedAt(i, mCount));
+        note.setParentType(QStringLiteral("Opportunities"));
+        note.setParentId(QStringLiteral("opp-%1").arg(i % opportunityCount()));
+        note.setDescription(QStringLiteral("Discussed the offer, customer wants a discount of %1%.\n"
+                                           "Follow up next week. Reference %2.").arg(i % 30).arg(i));
+        return note;
+    }
+
+    SugarEmail email(int i) const
+    {
+        SugarEmail email;
+        email.setId(QStringLiteral("email-%1").arg(i));
+        email.setName(QStringLiteral("Re: offer %1").arg(i));
+        email.setDateModified(modifiedAt(i, mCount));
+        email.setDateSent(KDCRMUtils::dateTimeToString(modifiedAt(i, mCount)));
+        email.setParentType(QStringLiteral("Opportunities"));
+        email.setParentId(QStringLiteral("opp-%1").arg(i % opportunityCount()));
+        email.setFromAddrName(QStringLiteral("sales%1@example.com").arg(i % 25));
+        email.setToAddrNames(QStringLiteral("customer%1@example.org").arg(i));
+        email.setDescription(QStringLiteral("Dear customer,\n\nplease find attached our offer number %1.\n\n"
+                                            "Best regards,\nThe sales team").arg(i).repeated(1 + i % 4));
+        return email;
+    }
+
+    // Opportunities modified in the last six months are open, older ones are closed
+    SugarOpportunity opportunity(int i) const
+    {
+        static const QStringList openStages = { "Prospecting", "Qualification", "Proposal", "Negotiation" };
+        static const QStringList closedStages = { "Closed Won", "Closed Lost" };
+        const QDateTime modified = modifiedAt(i, opportunityCount());
+        SugarOpportunity opp;
+        opp.setId(QStringLiteral("opp-%1").arg(i));
+        opp.setName(QStringLiteral("Opportunity %1").arg(i));
+        opp.setAccountId(QStringLiteral("acc-%1").arg(i % 1000));
+        opp.setSalesStage(modified.daysTo(now()) < 183 ? SyntheticData::pick(openStages, i) : SyntheticData::pick(closedStages, i));
+        opp.setDateModified(modified);
+        opp.setAssignedUserId(QStringLiteral("user-%1").arg(i % 100));
+        opp.setAssignedUserName(QStringLiteral("User %1").arg(i % 100));
+        opp.setDescription(QStringLiteral("Opportunity number %1.\nSecond paragraph of the description.").arg(i));
+        return opp;
+    }
+
+    // What the startup fetch without payload delivers: remote id and revision (the modification date)
+    Akonadi::Item::List headers(const QString &prefix, const QString &mimeType) const
+    {
+        Akonadi::Item::List result;
+        result.reserve(mCount);
+        for (int i = 0; i < mCount; ++i) {
+            Akonadi::Item item(i + 1);
+            item.setMimeType(mimeType);
+            item.setRemoteId(prefix + QString::number(i));
+            item.setRemoteRevision(KDCRMUtils::dateTimeToString(modifiedAt(i, mCount)));
+            result.append(item);
+        }
+        return result;
+    }
+
+    void fetchNotes(LinkedItemsRepository &repository, const Akonadi::Item::List &headers) const
+    {
+        for (int start = 0; start < headers.count(); start += s_batchSize) {
+            Akonadi::Item::List batch = headers.mid(start, s_batchSize);
+            for (Akonadi::Item &item : batch) {
+                item.setPayload(note(int(item.id() - 1)));
+            }
+            repository.addNotes(batch);
+        }
+    }
+
+    void fetchEmails(LinkedItemsRepository &repository, const Akonadi::Item::List &headers) const
+    {
+        for (int start = 0; start < headers.count(); start += s_batchSize) {
+            Akonadi::Item::List batch = headers.mid(start, s_batchSize);
+            for (Akonadi::Item &item : batch) {
+                item.setPayload(email(int(item.id() - 1)));
+            }
+            repository.addEmails(batch);
+        }
+    }
+
+    // LinkedItemsRepository::loadNotes/loadEmails and OpportunitiesPage::handleNewRows equivalents.
+    // The full-text index starts empty, as on a first start.
+    void startup(Session &session, const ArchiveTiering &tiering) const
+    {
+        LinkedItemsRepository &repository = session.repository;
+        repository.setArchiveTiering(tiering);
+
+        Akonadi::Item::List notes = mNoteHeaders;
+        tiering.takeColdItems(notes);
+        fetchNotes(repository, notes);
+
+        Akonadi::Item::List emails = mEmailHeaders;
+        tiering.takeColdItems(emails);
+        fetchEmails(repository, emails);
+
+        const int count = opportunityCount();
+        session.opportunities.reserve(count);
+        for (int start = 0; start < count; start += s_batchSize) {
+            QMap<QString, QString> assignedToRefMap;
+            for (int i = start; i < qMin(count, start + s_batchSize); ++i) {
+                const SugarOpportunity opp = opportunity(i);
+                session.opportunities.append(opp);
+                if (!tiering.isCold(opp)) {
+                    assignedToRefMap.insert(opp.assignedUserId(), opp.assignedUserName());
+                    repository.addOpportunity(opp);
+                }
+            }
+            ReferencedData::instance(AssignedToRef)->addMap(assignedToRefMap, false);
+        }
+    }
+
+    int loadedHistoryCount(const LinkedItemsRepository &repository) const
+    {
+        int result = 0;
+        for (int i = 0; i < opportunityCount(); ++i) {
+            const QString oppId = QStringLiteral("opp-%1").arg(i);
+            result += repository.notesForOpportunity(oppId).count() + repository.emailsForOpportunity(oppId).count();
+        }
+        return result;
+    }
+
+    static void addTieringRows()
+    {
+        QTest::addColumn<bool>("tiering");
+        QTest::newRow("tiering off") << false;
+        QTest::newRow("tiering on") << true;
+    }
+
+    int mCount = 0;
+    Akonadi::Item::List mNoteHeaders;
+    Akonadi::Item::List mEmailHeaders;
+    CollectionManager mCollectionManager;
+    std::vector<std::unique_ptr<Session>> mSessions;
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        mCount = historyCount();
+        mNoteHeaders = headers(QStringLiteral("note-"), SugarNote::mimeType());
+        mEmailHeaders = headers(QStringLiteral("email-"), SugarEmail::mimeType());
+
+        Akonadi::Item::List hot = mNoteHeaders;
+        const int coldCount = archiveTiering(true).takeColdItems(hot).count();
+        qDebug() << mCount << "notes and emails each, of which" << coldCount << "are older than the cutoff";
+        QVERIFY(hot.count() < mCount / 4);
+    }
+
+    void cleanup()
+    {
+        ReferencedData::clearAll();
+    }
+
+    void cleanupTestCase()
+    {
+        mSessions.clear();
+    }
+
+    void residentMemory_data()
+    {
+        addTieringRows();
+    }
+
+    // Runs first, before the other benchmarks free memory that could be reused here
+    void residentMemory()
+    {
+        QFETCH(bool, tiering);
+        const qint64 before = residentBytes();
+        if (before < 0)
+            QSKIP("Resident memory is only measured on Linux");
+
+        std::unique_ptr<Session> session(new Session(&mCollectionManager));
+        startup(*session, archiveTiering(tiering));
+        const qint64 after = residentBytes();
+        // Keep it alive, so that the next row doesn't reuse its memory
+        mSessions.push_back(std::move(session));
+
+        qDebug() << "resident memory grew by" << (after - before) / (1024 * 1024) << "MB";
+        QTest::setBenchmarkResult(after - before, QTest::BytesAllocated);
+    }
+
+    void startupTime_data()
+    {
+        addTieringRows();
+    }
+
+    void startupTime()
+    {
+        QFETCH(bool, tiering);
+        int loaded = 0;
+        QBENCHMARK {
+            Session session(&mCollectionManager);
+            startup(session, archiveTiering(tiering));
+            loaded = loadedHistoryCount(session.repository);
+        }
+        if (tiering)
+            QVERIFY(loaded < mCount / 2);
+        else
+            QCOMPARE(loaded, 2 * mCount);
+    }
+
+    // What the first history view scrolled past the cutoff costs, once per session
+    void loadArchive()
+    {
+        const ArchiveTiering tiering = archiveTiering(true);
+        Session session(&mCollectionManager);
+        startup(session, tiering);
+        Akonadi::Item::List notes = mNoteHeaders;
+        const Akonadi::Item::List coldNotes = tiering.takeColdItems(notes);
+        Akonadi::Item::List emails = mEmailHeaders;
+        const Akonadi::Item::List coldEmails = tiering.takeColdItems(emails);
+
+        QBENCHMARK_ONCE {
+            fetchNotes(session.repository, coldNotes);
+            fetchEmails(session.repository, coldEmails);
+        }
+        QCOMPARE(loadedHistoryCount(session.repository), 2 * mCount);
+    }
+};
+
+QTEST_MAIN(BenchArchiveTiering)
+#include "bench_archivetiering.moc"
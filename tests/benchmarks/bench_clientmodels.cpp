@@ -0,0 +1,402 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "syntheticdata.h"
+#include "syntheticitemsmodel.h"
+
+#include "accountrepository.h"
+#include "collectionmanager.h"
+#include "completionvocabulary.h"
+#include "filterproxymodel.h"
+#include "itemdataextractor.h"
+#include "itemidindex.h"
+#include "linkeditemsrepository.h"
+#include "opportunityfilterproxymodel.h"
+#include "opportunityfiltersettings.h"
+#include "referenceddata.h"
+
+#include <QCompleter>
+#include <QTest>
+
+// Benchmarks for the client-side models, fed with generated items instead of an Akonadi server.
+// The data-driven tests run with 10k, 50k and 200k items, see SyntheticData::addSizeRows().
+class BenchClientModels : public QObject
+{
+    Q_OBJECT
+
+private:
+    static const int s_batchSize = 1000; // similar to the ETM's item fetch batches
+
+    static void appendInBatches(SyntheticItemsModel &model, const Akonadi::Item::List &items)
+    {
+        for (int start = 0; start < items.count(); start += s_batchSize) {
+            model.appendItems(items.mid(start, s_batchSize));
+        }
+    }
+
+    void loadAccounts(int count)
+    {
+        const QVector<SugarAccount> accounts = SyntheticData::accounts(count);
+        QMap<QString, QString> accountNames;
+        Akonadi::Item::Id id = 1;
+        for (const SugarAccount &account : accounts) {
+            AccountRepository::instance()->addAccount(account, id++);
+            accountNames.insert(account.id(), account.name());
+        }
+        ReferencedData::instance(AccountRef)->addMap(accountNames, false);
+    }
+
+    static OpportunityFilterSettings showAllSettings()
+    {
+        OpportunityFilterSettings settings;
+        settings.setShowOpenClosed(true, true, true);
+        settings.setShownPriority(QStringLiteral("-"));
+        return settings;
+    }
+
+    static int accountCountFor(int opportunityCount) { return qMax(1, opportunityCount / 4); }
+
+    int columnOf(ItemsTreeModel::ColumnType type) const
+    {
+        return ItemsTreeModel::columnTypes(DetailsType::Opportunity).indexOf(type);
+    }
+
+private Q_SLOTS:
+    void init()
+    {
+        ReferencedData::clearAll();
+        AccountRepository::instance()->clear();
+    }
+
+    void cleanup()
+    {
+        init();
+    }
+
+    void loadAccountsBenchmark_data()
+    {
+        SyntheticData::addSizeRows();
+    }
+
+    // AccountsPage::handleNewRows equivalent, plus inserting into a sorted filter proxy
+    void loadAccountsBenchmark()
+    {
+        QFETCH(int, count);
+        const QVector<SugarAccount> accounts = SyntheticData::accounts(count);
+        const Akonadi::Item::List items = SyntheticData::items(accounts, SugarAccount::mimeType());
+
+        QBENCHMARK {
+            init();
+            LinkedItemsRepository repo(&mCollectionManager);
+            SyntheticItemsModel model(DetailsType::Account, &repo);
+            FilterProxyModel proxy(DetailsType::Account);
+            proxy.setSourceModel(&model);
+            proxy.sort(0);
+            for (int start = 0; start < items.count(); start += s_batchSize) {
+                const Akonadi::Item::List batch = items.mid(start, s_batchSize);
+                model.appendItems(batch);
+                QMap<QString, QString> accountNames;
+                for (const Akonadi::Item &item : batch) {
+                    const SugarAccount account = item.payload<SugarAccount>();
+                    AccountRepository::instance()->addAccount(account, item.id());
+                    accountNames.insert(account.id(), account.name());
+                }
+                ReferencedData::instance(AccountRef)->addMap(accountNames, false);
+            }
+            QCOMPARE(proxy.rowCount(), count);
+        }
+    }
+
+    void loadOpportunities_data()
+    {
+        SyntheticData::addSizeRows();
+    }
+
+    // OpportunitiesPage::handleNewRows equivalent, plus inserting into a sorted filter proxy
+    void loadOpportunities()
+    {
+        QFETCH(int, count);
+        loadAccounts(accountCountFor(count));
+        const Akonadi::Item::List items = SyntheticData::items(SyntheticData::opportunities(count, accountCountFor(count)),
+                                                               SugarOpportunity::mimeType());
+
+        QBENCHMARK {
+            LinkedItemsRepository repo(&mCollectionManager);
+            SyntheticItemsModel model(DetailsType::Opportunity, &repo);
+            OpportunityFilterProxyModel proxy;
+            proxy.setFilter(showAllSettings());
+            proxy.setSourceModel(&model);
+            proxy.sort(columnOf(ItemsTreeModel::NextStepDate));
+            for (int start = 0; start < items.count(); start += s_batchSize) {
+                const Akonadi::Item::List batch = items.mid(start, s_batchSize);
+                model.appendItems(batch);
+                for (const Akonadi::Item &item : batch) {
+                    repo.addOpportunity(item.payload<SugarOpportunity>());
+                }
+            }
+            QCOMPARE(proxy.rowCount(), count);
+        }
+    }
+
+    void dataAllCells_data()
+    {
+        SyntheticData::addSizeRows();
+    }
+
+    // What a view or a CSV export does: read the display data of every cell, through the proxy
+    void dataAllCells()
+    {
+        QFETCH(int, count);
+        loadAccounts(accountCountFor(count));
+        LinkedItemsRepository repo(&mCollectionManager);
+        SyntheticItemsModel model(DetailsType::Opportunity, &repo);
+        appendInBatches(model, SyntheticData::items(SyntheticData::opportunities(count, accountCountFor(count)),
+                                                    SugarOpportunity::mimeType()));
+        OpportunityFilterProxyModel proxy;
+        proxy.setFilter(showAllSettings());
+        proxy.setSourceModel(&model);
+
+        const int rows = proxy.rowCount();
+        const int columns = proxy.columnCount();
+        QBENCHMARK {
+            int totalLength = 0;
+            for (int row = 0; row < rows; ++row) {
+                for (int column = 0; column < columns; ++column) {
+                    totalLength += proxy.index(row, column).data().toString().length();
+                }
+            }
+            QVERIFY(totalLength > 0);
+        }
+    }
+
+    void filterKeystrokes_data()
+    {
+        SyntheticData::addSizeRows();
+    }
+
+    // Typing a search string, one character at a time, then clearing it
+    void filterKeystrokes()
+    {
+        QFETCH(int, count);
+        loadAccounts(accountCountFor(count));
+        LinkedItemsRepository repo(&mCollectionManager);
+        SyntheticItemsModel model(DetailsType::Opportunity, &repo);
+        appendInBatches(model, SyntheticData::items(SyntheticData::opportunities(count, accountCountFor(count)),
+                                                    SugarOpportunity::mimeType()));
+        OpportunityFilterProxyModel proxy;
+        proxy.setFilter(showAllSettings());
+        proxy.setSourceModel(&model);
+        proxy.sort(columnOf(ItemsTreeModel::OpportunityAccountName));
+
+        const QString typed = QStringLiteral("globex 12");
+        QBENCHMARK {
+            for (int length = 1; length <= typed.length(); ++length) {
+                proxy.setFilterString(typed.left(length));
+            }
+            proxy.setFilterString(QString());
+            QCOMPARE(proxy.rowCount(), count);
+        }
+    }
+
+    void sort_data()
+    {
+        QTest::addColumn<int>("count");
+        QTest::addColumn<int>("columnType");
+        const QVector<ItemsTreeModel::ColumnType> columns = {
+            ItemsTreeModel::OpportunityAccountName, ItemsTreeModel::NextStepDate, ItemsTreeModel::Amount
+        };
+        for (int count : SyntheticData::sizes()) {
+            for (ItemsTreeModel::ColumnType column : columns) {
+                const QString name = SyntheticData::sizeName(count) + QLatin1Char('-') + ItemsTreeModel::columnNameFromType(column);
+                QTest::newRow(qPrintable(name)) << count << int(column);
+            }
+        }
+    }
+
+    // Clicking on a column header, ascending then descending
+    void sort()
+    {
+        QFETCH(int, count);
+        QFETCH(int, columnType);
+        loadAccounts(accountCountFor(count));
+        LinkedItemsRepository repo(&mCollectionManager);
+        SyntheticItemsModel model(DetailsType::Opportunity, &repo);
+        appendInBatches(model, SyntheticData::items(SyntheticData::opportunities(count, accountCountFor(count)),
+                                                    SugarOpportunity::mimeType()));
+        OpportunityFilterProxyModel proxy;
+        proxy.setFilter(showAllSettings());
+        proxy.setSourceModel(&model);
+        proxy.setSortRole(Qt::EditRole);
+        const int column = columnOf(static_cast<ItemsTreeModel::ColumnType>(columnType));
+
+        QBENCHMARK {
+            proxy.sort(column, Qt::AscendingOrder);
+            proxy.sort(column, Qt::DescendingOrder);
+        }
+    }
+
+    void updateStorm_data()
+    {
+        SyntheticData::addSizeRows();
+    }
+
+    // Many single-item modifications (e.g. after a sync) hitting a sorted, filtered proxy
+    void updateStorm()
+    {
+        QFETCH(int, count);
+        loadAccounts(accountCountFor(count));
+        LinkedItemsRepository repo(&mCollectionManager);
+        SyntheticItemsModel model(DetailsType::Opportunity, &repo);
+        appendInBatches(model, SyntheticData::items(SyntheticData::opportunities(count, accountCountFor(count)),
+                                                    SugarOpportunity::mimeType()));
+        OpportunityFilterProxyModel proxy;
+        OpportunityFilterSettings settings = showAllSettings();
+        settings.setShowOpenClosed(true, false, false);
+        proxy.setFilter(settings);
+        proxy.setSourceModel(&model);
+        proxy.setSortRole(Qt::EditRole);
+        proxy.sort(columnOf(ItemsTreeModel::NextStepDate));
+
+        const int updates = 1000;
+        int round = 0;
+        QBENCHMARK {
+            ++round;
+            for (int i = 0; i < updates; ++i) {
+                const int row = (i * 7919) % count;
+                Akonadi::Item item = model.item(row);
+                SugarOpportunity opp = item.payload<SugarOpportunity>();
+                opp.setNextCallDate(opp.nextCallDate().addDays(round));
+                opp.setSalesStage(i % 3 == 0 ? QStringLiteral("Closed Won") : QStringLiteral("Proposal"));
+                repo.updateOpportunity(opp);
+                item.setPayload(opp);
+                model.updateItem(row, item);
+            }
+        }
+    }
+
+    void openById_data()
+    {
+        QTest::addColumn<int>("count");
+        QTest::addColumn<bool>("useIndex");
+        for (int count : SyntheticData::sizes()) {
+            QTest::newRow(qPrintable(SyntheticData::sizeName(count) + QStringLiteral("-scan"))) << count << false;
+            QTest::newRow(qPrintable(SyntheticData::sizeName(count) + QStringLiteral("-index"))) << count << true;
+        }
+    }
+
+    // 10k Page::openWidget(id) lookups: walking all rows (as it used to) versus the id index
+    void openById()
+    {
+        QFETCH(int, count);
+        QFETCH(bool, useIndex);
+        const Akonadi::Item::List items = SyntheticData::items(SyntheticData::accounts(count), SugarAccount::mimeType());
+        LinkedItemsRepository repo(&mCollectionManager);
+        SyntheticItemsModel model(DetailsType::Account, &repo);
+        ItemIdIndex idIndex(ItemDataExtractor::createDataExtractor(DetailsType::Account));
+        idIndex.setModel(&model);
+        appendInBatches(model, items);
+        QCOMPARE(idIndex.count(), count);
+
+        const auto dataExtractor = ItemDataExtractor::createDataExtractor(DetailsType::Account);
+        // The scan is O(rows) per lookup, keep its total run time reasonable:
+        // scale its result by 10000/opens to compare with the index rows
+        const int opens = useIndex ? 10000 : qMax(1, 10000 * 10000 / count);
+        if (opens != 10000)
+            qDebug() << "scan: measuring" << opens << "opens instead of 10000";
+        int found = 0;
+        QBENCHMARK {
+            found = 0;
+            for (int i = 0; i < opens; ++i) {
+                const QString id = items.at((i * 7919) % count).remoteId();
+                if (useIndex) {
+                    if (idIndex.index(id).isValid())
+                        ++found;
+                } else {
+                    for (int row = 0; row < model.rowCount(); ++row) {
+                        const Akonadi::Item item = model.index(row, 0).data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>();
+                        if (dataExtractor->idForItem(item) == id) {
+                            ++found;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        QCOMPARE(found, opens);
+    }
+
+    void openDialogs_data()
+    {
+        QTest::addColumn<bool>("useVocabulary");
+        QTest::newRow("scan") << false;
+        QTest::newRow("vocabulary") << true;
+    }
+
+    // Setting up the title completer of 100 contact dialogs over 20k contacts:
+    // one scan with QStringList::contains per dialog (as it used to) versus one shared vocabulary.
+    // This measures the completer setup only, not the creation of the widgets around it.
+    void openDialogs()
+    {
+        QFETCH(bool, useVocabulary);
+        const int count = 20000;
+        QVector<KContacts::Addressee> contacts = SyntheticData::contacts(count, count / 10);
+        for (int i = 0; i < count; ++i) {
+            contacts[i].setTitle(QStringLiteral("Title %1").arg(i % 1500));
+        }
+        LinkedItemsRepository repo(&mCollectionManager);
+        SyntheticItemsModel model(DetailsType::Contact, &repo);
+        appendInBatches(model, SyntheticData::items(contacts, KContacts::Addressee::mimeType()));
+
+        const auto title = [](const Akonadi::Item &item) {
+            return item.payload<KContacts::Addressee>().title();
+        };
+        const int dialogs = 100;
+        int completions = 0;
+        QBENCHMARK {
+            QObject dialogsParent;
+            QScopedPointer<CompletionVocabulary> vocabulary;
+            if (useVocabulary)
+                vocabulary.reset(new CompletionVocabulary(&model, title));
+            for (int i = 0; i < dialogs; ++i) {
+                QCompleter *completer;
+                if (useVocabulary) {
+                    completer = vocabulary->createCompleter(&dialogsParent);
+                } else {
+                    QStringList titleList;
+                    for (int row = 0; row < model.rowCount(); ++row) {
+                        const QString t = title(model.index(row, 0).data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>());
+                        if (!t.isEmpty() && !titleList.contains(t))
+                            titleList.append(t);
+                    }
+                    completer = new QCompleter(titleList, &dialogsParent);
+                    completer->setCaseSensitivity(Qt::CaseInsensitive);
+                }
+                completions = completer->model()->rowCount();
+            }
+        }
+        QCOMPARE(completions, 1500);
+    }
+
+private:
+    CollectionManager mCollectionManager;
+};
+
+QTEST_MAIN(BenchClientModels)
+
+#include "bench_clientmodels.moc"
@@ -0,0 +1,134 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "syntheticdata.h"
+
+#include "contactshandler.h"
+#include "createentriesjob.h"
+#include "createentryjob.h"
+#include "loginjob.h"
+#include "sugarsession.h"
+#include "sugarsoapprotocol.h"
+#include "sugarstandinserver.h"
+
+#include <QTest>
+
+// Benchmarks creating imported contacts on SugarStandInServer, through SugarSoapProtocol:
+// CreateEntriesJob (set_entries and get_entries per batch) against one CreateEntryJob per contact
+// (set_entry and get_entry per contact), which is what the resource did for every imported contact.
+class BenchContactImport : public QObject
+{
+    Q_OBJECT
+
+public:
+    BenchContactImport()
+        : mSession(nullptr)
+    {
+    }
+
+private:
+    enum Mode { Batched, PerItem };
+
+    SugarStandInServer mServer;
+    SugarSession mSession;
+    QScopedPointer<ContactsHandler> mHandler;
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        qRegisterMetaType<Akonadi::Item::List>("Akonadi::Item::List");
+        QVERIFY(mServer.start());
+        mSession.setSessionParameters(QStringLiteral("user"), QStringLiteral("password"), mServer.hostUrl());
+        mSession.createSoapInterface();
+        auto *protocol = new SugarSoapProtocol;
+        mSession.setProtocol(protocol);
+        protocol->setSession(&mSession);
+        mHandler.reset(new ContactsHandler(&mSession));
+
+        LoginJob job(&mSession);
+        QVERIFY2(job.exec(), qPrintable(job.errorString()));
+    }
+
+    void importContacts_data()
+    {
+        QTest::addColumn<int>("mode");
+        QTest::addColumn<int>("count");
+        QTest::addColumn<int>("batchSize");
+        const int maxItems = qEnvironmentVariableIsSet("FATCRM_BENCHMARK_MAX_ITEMS")
+                ? qEnvironmentVariableIntValue("FATCRM_BENCHMARK_MAX_ITEMS") : 100000;
+        const int count = qMin(5000, maxItems);
+        QTest::newRow("set_entries-100") << int(Batched) << count << 100;
+        QTest::newRow("set_entries-500") << int(Batched) << count << 500;
+        QTest::newRow("set_entry") << int(PerItem) << count << 1;
+    }
+
+    void importContacts()
+    {
+        QFETCH(int, mode);
+        QFETCH(int, count);
+        QFETCH(int, batchSize);
+        // New contacts, as ContactsImportWizard creates them
+        QVector<KContacts::Addressee> contacts = SyntheticData::contacts(count, 100);
+        for (KContacts::Addressee &contact : contacts) {
+            SugarContactWrapper(contact).setId(QString());
+        }
+        Akonadi::Item::List items = SyntheticData::items(contacts, KContacts::Addressee::mimeType());
+        for (Akonadi::Item &item : items) {
+            item.setRemoteId(QString());
+        }
+
+        int created = 0;
+        QBENCHMARK {
+            mServer.clear();
+            mServer.resetRequestCounts();
+            created = 0;
+            if (mode == Batched) {
+                CreateEntriesJob job(items, &mSession);
+                job.setModule(mHandler.data());
+                job.setBatchSize(batchSize);
+                QVERIFY2(job.exec(), qPrintable(job.errorString()));
+                created = job.createdItems().count();
+            } else {
+                for (const Akonadi::Item &item : qAsConst(items)) {
+                    CreateEntryJob job(item, &mSession);
+                    job.setModule(mHandler.data());
+                    QVERIFY2(job.exec(), qPrintable(job.errorString()));
+                    ++created;
+                }
+            }
+        }
+        QCOMPARE(created, count);
+        QCOMPARE(mServer.entryCount(moduleToName(Contacts)), count);
+        // The round trips grow with the number of batches, not with the number of contacts
+        const int batches = (count + batchSize - 1) / batchSize;
+        if (mode == Batched) {
+            QCOMPARE(mServer.requestCount(QStringLiteral("set_entries")), batches);
+            QCOMPARE(mServer.requestCount(QStringLiteral("get_entries")), batches);
+            QCOMPARE(mServer.requestCount(QStringLiteral("set_entry")), 0);
+            QCOMPARE(mServer.requestCount(QStringLiteral("get_entry")), 0);
+        } else {
+            QCOMPARE(mServer.requestCount(QStringLiteral("set_entry")), count);
+            QCOMPARE(mServer.requestCount(QStringLiteral("get_entry")), count);
+        }
+    }
+};
+
+QTEST_MAIN(BenchContactImport)
+#include "bench_contactimport.moc"
@@ -0,0 +1,130 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "syntheticdata.h"
+
+#include "accountshandler.h"
+#include "deleteentriesjob.h"
+#include "deleteentryjob.h"
+#include "loginjob.h"
+#include "sugarsession.h"
+#include "sugarsoapprotocol.h"
+#include "sugarstandinserver.h"
+
+#include <QTest>
+
+// Benchmarks deleting many accounts on SugarStandInServer, through SugarSoapProtocol:
+// DeleteEntriesJob (one set_entries request per batch) against one DeleteEntryJob per item,
+// which is what the resource did for every removed item before.
+class BenchDeleteEntries : public QObject
+{
+    Q_OBJECT
+
+public:
+    BenchDeleteEntries()
+        : mSession(nullptr)
+    {
+    }
+
+private:
+    enum Mode { Batched, PerItem };
+
+    SugarStandInServer mServer;
+    SugarSession mSession;
+    Akonadi::Item::List mItems;
+
+    void populate(int count)
+    {
+        mServer.clear();
+        mItems.clear();
+        const QVector<SugarAccount> accounts = SyntheticData::accounts(count);
+        for (const SugarAccount &account : accounts) {
+            const QString id = mServer.addEntry(moduleToName(Accounts), AccountsHandler::sugarAccountToNameValueList(account));
+            Akonadi::Item item(mItems.count() + 1);
+            item.setRemoteId(id);
+            mItems.append(item);
+        }
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QVERIFY(mServer.start());
+        mSession.setSessionParameters(QStringLiteral("user"), QStringLiteral("password"), mServer.hostUrl());
+        mSession.createSoapInterface();
+        auto *protocol = new SugarSoapProtocol;
+        mSession.setProtocol(protocol);
+        protocol->setSession(&mSession);
+
+        LoginJob job(&mSession);
+        QVERIFY2(job.exec(), qPrintable(job.errorString()));
+    }
+
+    void deleteAccounts_data()
+    {
+        QTest::addColumn<int>("mode");
+        QTest::addColumn<int>("count");
+        QTest::addColumn<int>("batchSize");
+        const int maxItems = qEnvironmentVariableIsSet("FATCRM_BENCHMARK_MAX_ITEMS")
+                ? qEnvironmentVariableIntValue("FATCRM_BENCHMARK_MAX_ITEMS") : 100000;
+        const int count = qMin(5000, maxItems);
+        QTest::newRow("set_entries-100") << int(Batched) << count << 100;
+        QTest::newRow("set_entries-500") << int(Batched) << count << 500;
+        QTest::newRow("set_entry") << int(PerItem) << count << 1;
+    }
+
+    void deleteAccounts()
+    {
+        QFETCH(int, mode);
+        QFETCH(int, count);
+        QFETCH(int, batchSize);
+        populate(count);
+        int deleted = 0;
+        QBENCHMARK {
+            // Deleting again is fine, the entries are still there with deleted=1
+            mServer.resetRequestCounts();
+            deleted = 0;
+            if (mode == Batched) {
+                DeleteEntriesJob job(mItems, &mSession, Accounts);
+                job.setBatchSize(batchSize);
+                QVERIFY2(job.exec(), qPrintable(job.errorString()));
+                deleted = job.deletedItems().count();
+            } else {
+                for (const Akonadi::Item &item : qAsConst(mItems)) {
+                    DeleteEntryJob job(item, &mSession, Accounts);
+                    QVERIFY2(job.exec(), qPrintable(job.errorString()));
+                    ++deleted;
+                }
+            }
+        }
+        QCOMPARE(deleted, count);
+        QCOMPARE(mServer.entryCount(moduleToName(Accounts)), 0);
+        if (mode == Batched) {
+            QCOMPARE(mServer.requestCount(QStringLiteral("set_entries")), (count + batchSize - 1) / batchSize);
+            QCOMPARE(mServer.requestCount(QStringLiteral("set_entry")), 0);
+        } else {
+            QCOMPARE(mServer.requestCount(QStringLiteral("set_entries")), 0);
+            QCOMPARE(mServer.requestCount(QStringLiteral("set_entry")), count);
+        }
+    }
+};
+
+QTEST_MAIN(BenchDeleteEntries)
+#include "bench_deleteentries.moc"
@@ -0,0 +1,149 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "syntheticdata.h"
+
+#include "collectionmanager.h"
+#include "linkeditemsrepository.h"
+#include "opportunitydetails.h"
+#include "supportedfields.h"
+
+#include <QTest>
+
+// The details widgets look up every input widget's field name in the supported fields,
+// in setData() (to hide unsupported widgets) and in getData() (to skip them).
+// These benchmarks measure the setup of the opportunity details widget and a setData()/getData() round trip,
+// and compare the lookups with QStringList, as Details used to store the supported fields, to SupportedFields.
+class BenchDetails : public QObject
+{
+    Q_OBJECT
+
+private:
+    enum Implementation { StringList, BitSet };
+    static const int s_dialogCount = 100;
+
+    static QVector<QMap<QString, QString>> opportunityData(int count)
+    {
+        QVector<SugarOpportunity> opportunities = SyntheticData::opportunities(count, qMax(1, count / 4));
+        QVector<QMap<QString, QString>> result;
+        result.reserve(count);
+        for (SugarOpportunity &opportunity : opportunities) {
+            result.append(opportunity.data());
+        }
+        return result;
+    }
+
+    // The names of the widgets that Details::setData() and getData() look up
+    static QStringList widgetFieldNames(const Details &details)
+    {
+        QStringList names;
+        const auto widgets = details.findChildren<QWidget *>();
+        for (const QWidget *widget : widgets) {
+            if (!widget->objectName().isEmpty() && !widget->objectName().startsWith(QLatin1String("qt_")))
+                names.append(widget->objectName());
+        }
+        return names;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        mFields = opportunityData(1).first().keys();
+        QVERIFY(mFields.contains(QStringLiteral("id")));
+    }
+
+    // Creating the widget and giving it the supported fields, as the details dialog does when opened
+    void setupDetails()
+    {
+        LinkedItemsRepository repo(&mCollectionManager);
+        QBENCHMARK {
+            OpportunityDetails details;
+            details.setLinkedItemsRepository(&repo);
+            details.setSupportedFields(SupportedFields(mFields));
+        }
+    }
+
+    // Showing 100 opportunities in the widget, and reading back what the user would save
+    void setDataGetData()
+    {
+        LinkedItemsRepository repo(&mCollectionManager);
+        OpportunityDetails details;
+        details.setLinkedItemsRepository(&repo);
+        details.setSupportedFields(SupportedFields(mFields));
+        QWidget createdModifiedContainer;
+        const QVector<QMap<QString, QString>> data = opportunityData(s_dialogCount);
+        int fieldCount = 0;
+        QBENCHMARK {
+            fieldCount = 0;
+            for (const QMap<QString, QString> &opportunityData : data) {
+                details.setData(opportunityData, &createdModifiedContainer);
+                fieldCount += details.getData().count();
+            }
+        }
+        QVERIFY(fieldCount > 0);
+    }
+
+    void fieldLookups_data()
+    {
+        QTest::addColumn<int>("implementation");
+        QTest::newRow("QStringList") << int(StringList);
+        QTest::newRow("SupportedFields") << int(BitSet);
+    }
+
+    // What 100 setData()/getData() round trips do with the supported fields: one copy per widget setup,
+    // then two lookups per input widget (hiding it in setData, skipping it in getData)
+    void fieldLookups()
+    {
+        QFETCH(int, implementation);
+        OpportunityDetails details;
+        const QStringList names = widgetFieldNames(details);
+        const SupportedFields supportedFields(mFields);
+        int found = 0;
+        QBENCHMARK {
+            found = 0;
+            for (int dialog = 0; dialog < s_dialogCount; ++dialog) {
+                if (implementation == StringList) {
+                    const QStringList keys = mFields;
+                    for (int pass = 0; pass < 2; ++pass) {
+                        for (const QString &name : names) {
+                            if (keys.contains(name))
+                                ++found;
+                        }
+                    }
+                } else {
+                    const SupportedFields keys = supportedFields;
+                    for (int pass = 0; pass < 2; ++pass) {
+                        for (const QString &name : names) {
+                            if (keys.contains(name))
+                                ++found;
+                        }
+                    }
+                }
+            }
+        }
+        QVERIFY(found > 0);
+    }
+
+private:
+    CollectionManager mCollectionManager;
+    QStringList mFields;
+};
+
+QTEST_MAIN(BenchDetails)
+#include "bench_details.moc"
@@ -0,0 +1,281 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "enumdefinitions.h"
+
+#include <QStringList>
+#include <QTest>
+
+#include <algorithm>
+#include <vector>
+
+// The implementation EnumDefinitions had before the hashed lookups and the binary format,
+// kept here as the baseline: linear searches, and fromString() splitting the whole string.
+namespace Legacy {
+
+struct Enum
+{
+    explicit Enum(const QString &name) : mEnumName(name) {}
+
+    QString toString() const
+    {
+        QString ret = mEnumName;
+        ret += '|';
+        for (auto it = mEnumValues.constBegin(); it != mEnumValues.constEnd(); ++it) {
+            ret += it->key + ':' + it->value + '|';
+        }
+        return ret;
+    }
+
+    QString value(const QString &key) const
+    {
+        const auto it = std::find_if(mEnumValues.constBegin(), mEnumValues.constEnd(), [key](const EnumDefinitions::KeyValue &keyVal) {
+            return keyVal.key == key;
+        });
+        return it != mEnumValues.constEnd() ? it->value : QString();
+    }
+
+    static Enum fromString(const QString &str)
+    {
+        const int nameSep = str.indexOf('|');
+        Enum ret(str.left(nameSep));
+        int pos = nameSep + 1;
+        while (pos < str.length()) {
+            const int sep = str.indexOf(':', pos);
+            const int end = str.indexOf('|', sep + 1);
+            ret.mEnumValues.append(EnumDefinitions::KeyValue{str.mid(pos, sep - pos), str.mid(sep + 1, end - sep - 1)});
+            pos = end + 1;
+        }
+        return ret;
+    }
+
+    QString mEnumName;
+    QVector<EnumDefinitions::KeyValue> mEnumValues;
+};
+
+struct Definitions
+{
+    int indexOf(const QString &enumName) const
+    {
+        for (size_t i = 0; i < mDefinitions.size(); ++i) {
+            if (mDefinitions.at(i).mEnumName == enumName) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    QString toString() const
+    {
+        QString ret;
+        for (size_t i = 0; i < mDefinitions.size(); ++i) {
+            ret += mDefinitions.at(i).toString();
+            if (i + 1 < mDefinitions.size()) {
+                ret += '%';
+            }
+        }
+        return ret;
+    }
+
+    static Definitions fromString(const QString &str)
+    {
+        Definitions ret;
+        foreach (const QString &s, str.split('%', QString::SkipEmptyParts)) {
+            ret.mDefinitions.push_back(Enum::fromString(s));
+        }
+        return ret;
+    }
+
+    std::vector<Enum> mDefinitions;
+};
+
+}
+
+// Benchmarks EnumDefinitions, old implementation versus current one,
+// on an enum set similar to what the resource stores for the Opportunities folder
+// (plus a few custom enums, one of them as long as a country list).
+class BenchEnumDefinitions : public QObject
+{
+    Q_OBJECT
+
+private:
+    enum Implementation { Old, NewText, NewBinary };
+
+    static const int s_lookupCount = 1000000;
+
+    static EnumDefinitions::Enum makeEnum(const QString &name, const QStringList &keys)
+    {
+        EnumDefinitions::Enum e(name);
+        for (const QString &key : keys) {
+            e.append(EnumDefinitions::KeyValue{key, key + QStringLiteral(" (display)")});
+        }
+        return e;
+    }
+
+    static QStringList numbered(const QString &prefix, int count)
+    {
+        QStringList ret;
+        ret.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            ret.append(prefix + QString::number(i));
+        }
+        return ret;
+    }
+
+    static void addImplementationRows()
+    {
+        QTest::addColumn<int>("implementation");
+        QTest::newRow("old") << int(Old);
+        QTest::newRow("new-text") << int(NewText);
+        QTest::newRow("new-binary") << int(NewBinary);
+    }
+
+    EnumDefinitions mDefinitions;
+    QString mText;
+    QByteArray mBinary;
+    QVector<QPair<QString, QString>> mLookups; // enum name, key
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        mDefinitions << makeEnum(QStringLiteral("opportunity_type"), {QStringLiteral("Existing Business"), QStringLiteral("New Business")})
+                     << makeEnum(QStringLiteral("lead_source"), {QStringLiteral("Cold Call"), QStringLiteral("Existing Customer"), QStringLiteral("Self Generated"),
+                                                                 QStringLiteral("Employee"), QStringLiteral("Partner"), QStringLiteral("Public Relations"),
+                                                                 QStringLiteral("Direct Mail"), QStringLiteral("Conference"), QStringLiteral("Trade Show"),
+                                                                 QStringLiteral("Web Site"), QStringLiteral("Word of mouth"), QStringLiteral("Email"),
+                                                                 QStringLiteral("Campaign"), QStringLiteral("Other")})
+                     << makeEnum(QStringLiteral("sales_stage"), {QStringLiteral("Prospecting"), QStringLiteral("Qualification"), QStringLiteral("Needs Analysis"),
+                                                                 QStringLiteral("Value Proposition"), QStringLiteral("Id. Decision Makers"),
+                                                                 QStringLiteral("Perception Analysis"), QStringLiteral("Proposal/Price Quote"),
+                                                                 QStringLiteral("Negotiation/Review"), QStringLiteral("Closed Won"), QStringLiteral("Closed Lost")})
+                     << makeEnum(QStringLiteral("industry"), numbered(QStringLiteral("Industry"), 30))
+                     << makeEnum(QStringLiteral("country_c"), numbered(QStringLiteral("Country"), 250))
+                     << makeEnum(QStringLiteral("product_c"), numbered(QStringLiteral("Product"), 80))
+                     << makeEnum(QStringLiteral("currency_id"), {QStringLiteral("-99"), QStringLiteral("a1"), QStringLiteral("a2")});
+        mText = mDefinitions.toString();
+        mBinary = mDefinitions.toBinary();
+        qDebug() << "text:" << mText.toUtf8().size() << "bytes, binary:" << mBinary.size() << "bytes";
+
+        // Lookups spread over all enums and keys, plus some misses
+        for (int i = 0; i < mDefinitions.count(); ++i) {
+            const EnumDefinitions::Enum &e = mDefinitions.at(i);
+            for (const EnumDefinitions::KeyValue &keyValue : e.mEnumValues) {
+                mLookups.append(qMakePair(e.mEnumName, keyValue.key));
+            }
+            mLookups.append(qMakePair(e.mEnumName, QStringLiteral("unknown")));
+        }
+        mLookups.append(qMakePair(QStringLiteral("portal_user_type"), QStringLiteral("Single")));
+    }
+
+    void decode_data()
+    {
+        addImplementationRows();
+    }
+
+    void decode()
+    {
+        QFETCH(int, implementation);
+        int count = 0;
+        switch (implementation) {
+        case Old:
+            QBENCHMARK {
+                count = int(Legacy::Definitions::fromString(mText).mDefinitions.size());
+            }
+            break;
+        case NewText:
+            QBENCHMARK {
+                count = EnumDefinitions::fromString(mText).count();
+            }
+            break;
+        case NewBinary:
+            QBENCHMARK {
+                count = EnumDefinitions::fromBinary(mBinary).count();
+            }
+            break;
+        }
+        QCOMPARE(count, mDefinitions.count());
+    }
+
+    void encode_data()
+    {
+        addImplementationRows();
+    }
+
+    void encode()
+    {
+        QFETCH(int, implementation);
+        const Legacy::Definitions legacy = Legacy::Definitions::fromString(mText);
+        int size = 0;
+        switch (implementation) {
+        case Old:
+            QBENCHMARK {
+                size = legacy.toString().size();
+            }
+            break;
+        case NewText:
+            QBENCHMARK {
+                size = mDefinitions.toString().size();
+            }
+            break;
+        case NewBinary:
+            QBENCHMARK {
+                size = mDefinitions.toBinary().size();
+            }
+            break;
+        }
+        QVERIFY(size > 0);
+    }
+
+    void lookups_data()
+    {
+        QTest::addColumn<int>("implementation");
+        QTest::newRow("old") << int(Old);
+        QTest::newRow("new") << int(NewText);
+    }
+
+    // What ItemsTreeModel and the details widgets do: find the enum, then the display string for a key
+    void lookups()
+    {
+        QFETCH(int, implementation);
+        const Legacy::Definitions legacy = Legacy::Definitions::fromString(mText);
+        const EnumDefinitions current = EnumDefinitions::fromString(mText);
+        int found = 0;
+        QBENCHMARK {
+            found = 0;
+            for (int i = 0; i < s_lookupCount; ++i) {
+                const auto &lookup = mLookups.at(i % mLookups.count());
+                if (implementation == Old) {
+                    const int pos = legacy.indexOf(lookup.first);
+                    if (pos > -1 && !legacy.mDefinitions.at(pos).value(lookup.second).isEmpty()) {
+                        ++found;
+                    }
+                } else {
+                    const int pos = current.indexOf(lookup.first);
+                    if (pos > -1 && !current.at(pos).value(lookup.second).isEmpty()) {
+                        ++found;
+                    }
+                }
+            }
+        }
+        QVERIFY(found > 0);
+    }
+};
+
+QTEST_GUILESS_MAIN(BenchEnumDefinitions)
+#include "bench_enumdefinitions.moc"
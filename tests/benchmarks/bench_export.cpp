@@ -0,0 +1,180 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "syntheticdata.h"
+#include "syntheticitemsmodel.h"
+
+#include "accountrepository.h"
+#include "collectionmanager.h"
+#include "itemexporter.h"
+#include "linkeditemsrepository.h"
+#include "opportunityfilterproxymodel.h"
+#include "opportunityfiltersettings.h"
+#include "rearrangecolumnsproxymodel.h"
+#include "referenceddata.h"
+
+#include <QBuffer>
+#include <QTest>
+
+// Exporting opportunities: what fatcrm-export does with each batch of items fetched from Akonadi
+// (ItemExporter::writeItems, to CSV and to JSON), and for comparison what Page::exportToCSV does
+// once the page's models are loaded (reading every cell through the filter and column proxies).
+// The Akonadi fetch itself isn't included, see bench_serializers for the payload parsing.
+class BenchExport : public QObject
+{
+    Q_OBJECT
+
+private:
+    static int accountCountFor(int opportunityCount) { return qMax(1, opportunityCount / 4); }
+
+    static OpportunityFilterSettings showAllSettings()
+    {
+        OpportunityFilterSettings settings;
+        settings.setShowOpenClosed(true, true, true);
+        settings.setShownPriority(QStringLiteral("-"));
+        return settings;
+    }
+
+    static void loadAccounts(int count)
+    {
+        const QVector<SugarAccount> accounts = SyntheticData::accounts(count);
+        QMap<QString, QString> accountNames;
+        Akonadi::Item::Id id = 1;
+        for (const SugarAccount &account : accounts) {
+            AccountRepository::instance()->addAccount(account, id++);
+            accountNames.insert(account.id(), account.name());
+        }
+        ReferencedData::instance(AccountRef)->addMap(accountNames, false);
+    }
+
+    static Akonadi::Item::List opportunityItems(int count)
+    {
+        return SyntheticData::items(SyntheticData::opportunities(count, accountCountFor(count)), SugarOpportunity::mimeType());
+    }
+
+    static qint64 exportItems(const Akonadi::Item::List &items, ItemExporter::Format format)
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        ItemExporter exporter;
+        exporter.setType(DetailsType::Opportunity);
+        exporter.setColumns(ItemsTreeModel::defaultVisibleColumns(DetailsType::Opportunity));
+        exporter.setFormat(format);
+        exporter.setOpportunityFilter(showAllSettings());
+        exporter.setDevice(&buffer);
+        const int batchSize = 1000; // similar to Akonadi's item fetch batches
+        for (int start = 0; start < items.count(); start += batchSize) {
+            exporter.writeItems(items.mid(start, batchSize));
+        }
+        exporter.writeEnd();
+        if (exporter.exportedCount() != items.count())
+            return -1;
+        return buffer.size();
+    }
+
+private Q_SLOTS:
+    void init()
+    {
+        ReferencedData::clearAll();
+        AccountRepository::instance()->clear();
+    }
+
+    void cleanup()
+    {
+        init();
+    }
+
+    void exportCsv_data()
+    {
+        SyntheticData::addSizeRows();
+    }
+
+    void exportCsv()
+    {
+        QFETCH(int, count);
+        loadAccounts(accountCountFor(count));
+        const Akonadi::Item::List items = opportunityItems(count);
+        QBENCHMARK {
+            QVERIFY(exportItems(items, ItemExporter::Csv) > 0);
+        }
+    }
+
+    void exportJson_data()
+    {
+        SyntheticData::addSizeRows();
+    }
+
+    void exportJson()
+    {
+        QFETCH(int, count);
+        loadAccounts(accountCountFor(count));
+        const Akonadi::Item::List items = opportunityItems(count);
+        QBENCHMARK {
+            QVERIFY(exportItems(items, ItemExporter::Json) > 0);
+        }
+    }
+
+    void exportFromModels_data()
+    {
+        SyntheticData::addSizeRows();
+    }
+
+    // The GUI way, not counting the time to load the models
+    void exportFromModels()
+    {
+        QFETCH(int, count);
+        loadAccounts(accountCountFor(count));
+        CollectionManager collectionManager;
+        LinkedItemsRepository repo(&collectionManager);
+        SyntheticItemsModel model(DetailsType::Opportunity, &repo);
+        model.setItems(opportunityItems(count));
+        OpportunityFilterProxyModel proxy;
+        proxy.setFilter(showAllSettings());
+        proxy.setSourceModel(&model);
+
+        const ItemsTreeModel::ColumnTypes allColumns = ItemsTreeModel::columnTypes(DetailsType::Opportunity);
+        QVector<int> sourceColumns;
+        const ItemsTreeModel::ColumnTypes visibleColumns = ItemsTreeModel::defaultVisibleColumns(DetailsType::Opportunity);
+        for (ItemsTreeModel::ColumnType column : visibleColumns) {
+            sourceColumns.append(allColumns.indexOf(column));
+        }
+        RearrangeColumnsProxyModel rearrangeColumnsProxy;
+        rearrangeColumnsProxy.setSourceColumns(sourceColumns);
+        rearrangeColumnsProxy.setSourceModel(&proxy);
+
+        QBENCHMARK {
+            QBuffer buffer;
+            buffer.open(QIODevice::WriteOnly);
+            const int rows = rearrangeColumnsProxy.rowCount();
+            const int columns = rearrangeColumnsProxy.columnCount();
+            for (int row = 0; row < rows; ++row) {
+                QStringList cells;
+                cells.reserve(columns);
+                for (int column = 0; column < columns; ++column) {
+                    cells.append(rearrangeColumnsProxy.index(row, column).data().toString());
+                }
+                buffer.write(ItemExporter::csvLine(cells).toUtf8());
+            }
+            QCOMPARE(rows, count);
+        }
+    }
+};
+
+QTEST_MAIN(BenchExport)
+#include "bench_export.moc"
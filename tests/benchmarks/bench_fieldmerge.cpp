@@ -0,0 +1,97 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "syntheticdata.h"
+
+#include "fieldmerge.h"
+
+#include <QTest>
+
+// Three-way merges of 10k accounts (capped by $FATCRM_BENCHMARK_MAX_ITEMS), as ConflictHandler
+// does for each conflicting item: from the field maps only, and including the conversion
+// from and to the payloads (data() and setData()), which is what the module handlers do.
+class BenchFieldMerge : public QObject
+{
+    Q_OBJECT
+
+private:
+    QVector<SugarAccount> mBase;
+    QVector<SugarAccount> mLocal;
+    QVector<SugarAccount> mRemote;
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        const int defaultCount = 10000;
+        const int count = qEnvironmentVariableIsSet("FATCRM_BENCHMARK_MAX_ITEMS")
+                ? qMin(defaultCount, qEnvironmentVariableIntValue("FATCRM_BENCHMARK_MAX_ITEMS")) : defaultCount;
+        mBase = SyntheticData::accounts(count);
+        mLocal = mBase;
+        mRemote = mBase;
+        for (int i = 0; i < count; ++i) {
+            // a local change to the description, a remote one to the phone number,
+            // and every tenth item changed on both sides
+            mLocal[i].setDescription(QStringLiteral("Local description %1").arg(i));
+            mRemote[i].setPhoneOffice(QStringLiteral("+49 555 %1").arg(i));
+            if (i % 10 == 0) {
+                mRemote[i].setDescription(QStringLiteral("Remote description %1").arg(i));
+            }
+        }
+    }
+
+    void mergeFieldMaps()
+    {
+        QVector<QMap<QString, QString>> base, local, remote;
+        for (int i = 0; i < mBase.count(); ++i) {
+            base.append(mBase.at(i).data());
+            local.append(mLocal.at(i).data());
+            remote.append(mRemote.at(i).data());
+        }
+        int collisions = 0;
+        QBENCHMARK {
+            collisions = 0;
+            for (int i = 0; i < base.count(); ++i) {
+                const FieldMerge merge(base.at(i), local.at(i), remote.at(i));
+                collisions += merge.collisions().count();
+            }
+        }
+        QCOMPARE(collisions, (mBase.count() + 9) / 10);
+    }
+
+    void mergePayloads()
+    {
+        int merged = 0;
+        QBENCHMARK {
+            merged = 0;
+            for (int i = 0; i < mBase.count(); ++i) {
+                const FieldMerge merge(mBase.at(i).data(), mLocal.at(i).data(), mRemote.at(i).data());
+                if (!merge.hasCollisions()) {
+                    SugarAccount account = mLocal.at(i);
+                    account.setData(merge.merged(FieldMerge::Local));
+                    merged += account.phoneOffice() == mRemote.at(i).phoneOffice() ? 1 : 0;
+                }
+            }
+        }
+        QCOMPARE(merged, mBase.count() - (mBase.count() + 9) / 10);
+    }
+};
+
+QTEST_MAIN(BenchFieldMerge)
+#include "bench_fieldmerge.moc"
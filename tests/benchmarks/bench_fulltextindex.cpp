@@ -0,0 +1,145 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "syntheticdata.h"
+
+#include "fulltextindex.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+// Full-text index over a large mailbox: indexing, 1000 queries, and the restart case
+// where the saved index is loaded and all items come in again with unchanged revisions.
+// Defaults to 500k emails, capped by $FATCRM_BENCHMARK_MAX_ITEMS.
+class BenchFullTextIndex : public QObject
+{
+    Q_OBJECT
+
+private:
+    static const int s_queryCount = 1000;
+
+    static int emailCount()
+    {
+        const int defaultCount = 500000;
+        return qEnvironmentVariableIsSet("FATCRM_BENCHMARK_MAX_ITEMS")
+                ? qMin(defaultCount, qEnvironmentVariableIntValue("FATCRM_BENCHMARK_MAX_ITEMS")) : defaultCount;
+    }
+
+    // Same text as LinkedItemsRepository::storeEmail indexes
+    static QString textOf(const SugarEmail &email)
+    {
+        return email.name() + QLatin1Char('\n') + email.description();
+    }
+
+    static QString revisionOf(const SugarEmail &email)
+    {
+        return email.dateSent();
+    }
+
+    void indexAll(FullTextIndex &index) const
+    {
+        for (const SugarEmail &email : mEmails) {
+            index.add(FullTextIndex::Email, email.id(), revisionOf(email), textOf(email),
+                      email.parentType(), email.parentId());
+        }
+    }
+
+    QVector<SugarEmail> mEmails;
+    QStringList mQueries;
+    FullTextIndex mIndex;
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        const int count = emailCount();
+        mEmails = SyntheticData::emails(count, qMax(1, count / 10));
+        // Mix of selective queries (an offer number) and common terms matching every email
+        mQueries.reserve(s_queryCount);
+        for (int i = 0; i < s_queryCount; ++i) {
+            const int number = int((qint64(i) * 7919) % count);
+            switch (i % 4) {
+            case 0:
+                mQueries.append(QString::number(number));
+                break;
+            case 1:
+                mQueries.append(QStringLiteral("offer %1").arg(number));
+                break;
+            case 2:
+                mQueries.append(QStringLiteral("customer attached %1").arg(number));
+                break;
+            default:
+                mQueries.append(QStringLiteral("regards"));
+                break;
+            }
+        }
+        indexAll(mIndex);
+        qDebug() << "Indexed" << mIndex.documentCount() << "emails";
+    }
+
+    void indexEmails()
+    {
+        QBENCHMARK_ONCE {
+            FullTextIndex index;
+            indexAll(index);
+            QCOMPARE(index.documentCount(), mEmails.count());
+        }
+    }
+
+    void searchQueries()
+    {
+        int hits = 0;
+        QBENCHMARK {
+            hits = 0;
+            for (const QString &query : qAsConst(mQueries)) {
+                hits += mIndex.search(query, 20).count();
+            }
+        }
+        QVERIFY(hits > 0);
+    }
+
+    void selectiveQueryRanking()
+    {
+        // An offer number only appears in one email, which must come first
+        const QString id = mEmails.at(mEmails.count() / 2).id();
+        const QVector<FullTextIndex::Hit> hits = mIndex.search(QString::number(mEmails.count() / 2), 5);
+        QVERIFY(!hits.isEmpty());
+        QCOMPARE(hits.at(0).id, id);
+    }
+
+    void reloadUnchanged()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString fileName = dir.path() + QStringLiteral("/index");
+        QVERIFY(mIndex.save(fileName));
+
+        QBENCHMARK_ONCE {
+            FullTextIndex index;
+            QVERIFY(index.load(fileName));
+            index.markAllUnseen(FullTextIndex::Email);
+            indexAll(index); // nothing changed, so nothing gets tokenized again
+            QCOMPARE(index.removeUnseen(FullTextIndex::Email), 0);
+            QCOMPARE(index.documentCount(), mEmails.count());
+        }
+    }
+};
+
+QTEST_MAIN(BenchFullTextIndex)
+#include "bench_fulltextindex.moc"
@@ -0,0 +1,96 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "syntheticdata.h"
+
+#include "noteswindow.h"
+#include "timelinemodel.h"
+
+#include <QLineEdit>
+#include <QListView>
+#include <QStandardPaths>
+#include <QTest>
+
+// Opening the notes window on a long history (10k notes and emails), and searching in it.
+// Laying out the whole history into one document, as the window used to, took seconds.
+class BenchNotesWindow : public QObject
+{
+    Q_OBJECT
+
+private:
+    static const int s_historySize = 10000;
+
+    static void fillHistory(NotesWindow &window)
+    {
+        const QVector<SugarNote> notes = SyntheticData::notes(s_historySize / 2, 1);
+        for (const SugarNote &note : notes) {
+            window.addNote(note);
+        }
+        QVector<SugarEmail> emails = SyntheticData::emails(s_historySize / 2, 1);
+        for (int i = 0; i < emails.count(); ++i) {
+            // Half of them only have an HTML body
+            if (i % 2 == 1) {
+                emails[i].setDescriptionHtml(QStringLiteral("<html><body><p>") + emails.at(i).description().toHtmlEscaped().replace('\n', QLatin1String("<br/>")) + QStringLiteral("</p></body></html>"));
+                emails[i].setDescription(QString());
+            }
+            window.addEmail(emails.at(i));
+        }
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+    }
+
+    void openWindow()
+    {
+        QBENCHMARK {
+            NotesWindow window;
+            fillHistory(window);
+            window.resize(600, 800);
+            window.show();
+            QVERIFY(QTest::qWaitForWindowExposed(&window));
+            auto *view = window.findChild<QListView *>(QStringLiteral("timelineView"));
+            view->viewport()->repaint();
+            QCOMPARE(view->model()->rowCount(), s_historySize);
+        }
+    }
+
+    // The first search converts the entries to plain text, the following ones reuse that
+    void search()
+    {
+        NotesWindow window;
+        fillHistory(window);
+        window.show();
+        QVERIFY(QTest::qWaitForWindowExposed(&window));
+        auto *view = window.findChild<QListView *>(QStringLiteral("timelineView"));
+        auto *searchLineEdit = window.findChild<QLineEdit *>(QStringLiteral("searchLineEdit"));
+        int found = 0;
+        QBENCHMARK {
+            searchLineEdit->setText(QStringLiteral("offer number 1234."));
+            found = view->model()->rowCount();
+            searchLineEdit->clear();
+        }
+        QCOMPARE(found, 1);
+    }
+};
+
+QTEST_MAIN(BenchNotesWindow)
+#include "bench_noteswindow.moc"
@@ -0,0 +1,176 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "syntheticdata.h"
+#include "syntheticitemsmodel.h"
+
+#include "collectionmanager.h"
+#include "linkeditemsrepository.h"
+#include "quickopenindex.h"
+
+#include <QElapsedTimer>
+#include <QTest>
+
+#include <limits>
+#include <memory>
+
+// The quick-open palette over 200k records of all types (capped by $FATCRM_BENCHMARK_MAX_ITEMS):
+// building the index from the models, following edits, and the latency of typical queries,
+// which must stay under 5 ms each so that the palette updates while typing.
+class BenchQuickOpen : public QObject
+{
+    Q_OBJECT
+
+private:
+    static const qint64 s_maxQueryNSecs = 5 * 1000 * 1000;
+
+    static int totalCount()
+    {
+        const int defaultCount = 200000;
+        return qEnvironmentVariableIsSet("FATCRM_BENCHMARK_MAX_ITEMS")
+                ? qMin(defaultCount, qEnvironmentVariableIntValue("FATCRM_BENCHMARK_MAX_ITEMS")) : defaultCount;
+    }
+
+    // Akonadi item ids are unique across collections, SyntheticData::items() starts at 1 for each type
+    Akonadi::Item::List withUniqueIds(Akonadi::Item::List items)
+    {
+        for (Akonadi::Item &item : items) {
+            item.setId(mNextItemId++);
+        }
+        return items;
+    }
+
+    std::unique_ptr<SyntheticItemsModel> createModel(DetailsType type, const Akonadi::Item::List &items)
+    {
+        std::unique_ptr<SyntheticItemsModel> model(new SyntheticItemsModel(type, &mRepo));
+        model->setItems(withUniqueIds(items));
+        return model;
+    }
+
+    void addModels(QuickOpenIndex &index)
+    {
+        index.addModel(DetailsType::Account, mAccounts.get());
+        index.addModel(DetailsType::Contact, mContacts.get());
+        index.addModel(DetailsType::Opportunity, mOpportunities.get());
+        index.addModel(DetailsType::Lead, mLeads.get());
+        index.addModel(DetailsType::Campaign, mCampaigns.get());
+    }
+
+    CollectionManager mCollectionManager;
+    LinkedItemsRepository mRepo{&mCollectionManager};
+    Akonadi::Item::Id mNextItemId = 1;
+    std::unique_ptr<SyntheticItemsModel> mAccounts;
+    std::unique_ptr<SyntheticItemsModel> mContacts;
+    std::unique_ptr<SyntheticItemsModel> mOpportunities;
+    std::unique_ptr<SyntheticItemsModel> mLeads;
+    std::unique_ptr<SyntheticItemsModel> mCampaigns;
+    QuickOpenIndex mIndex;
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // 25% accounts, 30% contacts, 30% opportunities, 7.5% leads and campaigns
+        const int count = totalCount();
+        const int accountCount = qMax(1, count / 4);
+        const int contactCount = count * 3 / 10;
+        const int opportunityCount = count * 3 / 10;
+        const int leadCount = (count - accountCount - contactCount - opportunityCount) / 2;
+        const int campaignCount = count - accountCount - contactCount - opportunityCount - leadCount;
+        mAccounts = createModel(DetailsType::Account,
+                                SyntheticData::items(SyntheticData::accounts(accountCount), SugarAccount::mimeType()));
+        mContacts = createModel(DetailsType::Contact,
+                                SyntheticData::items(SyntheticData::contacts(contactCount, accountCount), KContacts::Addressee::mimeType()));
+        mOpportunities = createModel(DetailsType::Opportunity,
+                                     SyntheticData::items(SyntheticData::opportunities(opportunityCount, accountCount), SugarOpportunity::mimeType()));
+        mLeads = createModel(DetailsType::Lead,
+                             SyntheticData::items(SyntheticData::leads(leadCount), SugarLead::mimeType()));
+        mCampaigns = createModel(DetailsType::Campaign,
+                                 SyntheticData::items(SyntheticData::campaigns(campaignCount), SugarCampaign::mimeType()));
+        addModels(mIndex);
+        qDebug() << "Indexed" << mIndex.count() << "records";
+    }
+
+    void buildIndex()
+    {
+        QBENCHMARK_ONCE {
+            QuickOpenIndex index;
+            addModels(index);
+            QCOMPARE(index.count(), mIndex.count());
+        }
+    }
+
+    void search_data()
+    {
+        QTest::addColumn<QString>("query");
+        QTest::newRow("one letter") << QStringLiteral("a");
+        QTest::newRow("two letters") << QStringLiteral("st");
+        QTest::newRow("company") << QStringLiteral("acme");
+        QTest::newRow("company and number") << QStringLiteral("acme 1234");
+        QTest::newRow("common word") << QStringLiteral("opportunity");
+        QTest::newRow("opportunity number") << QStringLiteral("opportunity 4711");
+        QTest::newRow("contact") << QStringLiteral("anna family12");
+        QTest::newRow("middle of a word") << QStringLiteral("mily101");
+        QTest::newRow("lead") << QStringLiteral("first12 last");
+        QTest::newRow("campaign") << QStringLiteral("campaign 77");
+        QTest::newRow("no match") << QStringLiteral("xyzzy");
+    }
+
+    void search()
+    {
+        QFETCH(QString, query);
+
+        // The palette is refreshed on every keystroke, each prefix of the query must be fast too
+        qint64 worstNSecs = 0;
+        for (int length = 1; length <= query.size(); ++length) {
+            const QString prefix = query.left(length);
+            qint64 bestNSecs = std::numeric_limits<qint64>::max();
+            for (int run = 0; run < 3; ++run) {
+                QElapsedTimer timer;
+                timer.start();
+                mIndex.search(prefix, 20);
+                bestNSecs = qMin(bestNSecs, timer.nsecsElapsed());
+            }
+            worstNSecs = qMax(worstNSecs, bestNSecs);
+        }
+        QVERIFY2(worstNSecs < s_maxQueryNSecs, qPrintable(QStringLiteral("%1 ms").arg(worstNSecs / 1e6)));
+
+        QBENCHMARK {
+            mIndex.search(query, 20);
+        }
+    }
+
+    void followEdits()
+    {
+        const int edits = qMin(1000, mAccounts->rowCount());
+        QBENCHMARK_ONCE {
+            for (int row = 0; row < edits; ++row) {
+                Akonadi::Item item = mAccounts->item(row);
+                SugarAccount account = item.payload<SugarAccount>();
+                account.setName(account.name() + QStringLiteral(" (renamed)"));
+                item.setPayload(account);
+                mAccounts->updateItem(row, item);
+            }
+        }
+        QVERIFY(!mIndex.search(QStringLiteral("renamed"), 20).isEmpty());
+    }
+};
+
+QTEST_MAIN(BenchQuickOpen)
+#include "bench_quickopen.moc"
@@ -0,0 +1,186 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "syntheticdata.h"
+#include "syntheticitemsmodel.h"
+
+#include "accountrepository.h"
+#include "collectionmanager.h"
+#include "linkeditemsrepository.h"
+#include "opportunityfilterproxymodel.h"
+#include "opportunityfiltersettings.h"
+#include "referenceddata.h"
+#include "savedsearchindex.h"
+
+#include <QTest>
+
+// Saved searches on 50k opportunities (fewer if $FATCRM_BENCHMARK_MAX_ITEMS is lower):
+// switching between 20 of them with and without their materialized result sets (SavedSearchIndex),
+// the cost of materializing them, and of keeping them up to date when opportunities change.
+class BenchSavedSearches : public QObject
+{
+    Q_OBJECT
+
+private:
+    static int opportunityCount() { return qMin(50000, SyntheticData::sizes().last()); }
+    static int accountCountFor(int opportunityCount) { return qMax(1, opportunityCount / 4); }
+
+    static void loadAccounts(int count)
+    {
+        const QVector<SugarAccount> accounts = SyntheticData::accounts(count);
+        QMap<QString, QString> accountNames;
+        Akonadi::Item::Id id = 1;
+        for (const SugarAccount &account : accounts) {
+            AccountRepository::instance()->addAccount(account, id++);
+            accountNames.insert(account.id(), account.name());
+        }
+        ReferencedData::instance(AccountRef)->addMap(accountNames, false);
+    }
+
+    // 20 searches of the kinds users save: by assignee, priority, country, next step date and search text
+    static QVector<OpportunityFilterSettings> savedSearches()
+    {
+        static const QStringList priorities = { "A", "B", "C" };
+        static const QStringList countries = { "Germany", "Sweden", "France", "Norway" };
+        static const QStringList texts = { "Call back", "Meeting", "Globex", "Send offer" };
+        QVector<OpportunityFilterSettings> result;
+        for (int i = 0; i < 20; ++i) {
+            OpportunityFilterSettings settings;
+            settings.setSearchName(QStringLiteral("Search %1").arg(i));
+            settings.setShownPriority(QStringLiteral("-"));
+            switch (i % 5) {
+            case 0:
+                settings.setAssignees({QStringLiteral("user%1").arg(i)}, QStringLiteral("Me"));
+                break;
+            case 1:
+                settings.setShowOpenClosed(true, true, true);
+                settings.setShownPriority(SyntheticData::pick(priorities, i / 5));
+                break;
+            case 2:
+                settings.setCountries({SyntheticData::pick(countries, i / 5)}, SyntheticData::pick(countries, i / 5));
+                settings.setShowOpenClosed(true, true, false);
+                break;
+            case 3:
+                settings.setMaxDate(QDate(2020, 1, 1).addDays(30 * i), CustomDate);
+                break;
+            case 4:
+                settings.setShowOpenClosed(true, true, true);
+                settings.setSearchText(SyntheticData::pick(texts, i / 5));
+                break;
+            }
+            result.append(settings);
+        }
+        return result;
+    }
+
+    CollectionManager mCollectionManager;
+
+private Q_SLOTS:
+    void init()
+    {
+        ReferencedData::clearAll();
+        AccountRepository::instance()->clear();
+    }
+
+    void cleanup()
+    {
+        init();
+    }
+
+    void switchSearches_data()
+    {
+        QTest::addColumn<bool>("materialized");
+        QTest::newRow("refilter") << false;
+        QTest::newRow("materialized") << true;
+    }
+
+    // Loading each of the saved searches in turn, until the proxy knows its rows
+    void switchSearches()
+    {
+        QFETCH(bool, materialized);
+        const int count = opportunityCount();
+        loadAccounts(accountCountFor(count));
+        LinkedItemsRepository repo(&mCollectionManager);
+        SyntheticItemsModel model(DetailsType::Opportunity, &repo);
+        model.setItems(SyntheticData::items(SyntheticData::opportunities(count, accountCountFor(count)), SugarOpportunity::mimeType()));
+        OpportunityFilterProxyModel proxy;
+        proxy.setSourceModel(&model);
+        const QVector<OpportunityFilterSettings> searches = savedSearches();
+        if (materialized) {
+            proxy.savedSearchIndex()->setSearches(searches);
+        }
+
+        QBENCHMARK {
+            int totalRows = 0;
+            for (const OpportunityFilterSettings &settings : searches) {
+                proxy.setFilter(settings, settings.searchText());
+                totalRows += proxy.rowCount();
+            }
+            QVERIFY(totalRows > 0);
+        }
+    }
+
+    // What loading (or changing) the saved searches costs
+    void materializeSearches()
+    {
+        const int count = opportunityCount();
+        loadAccounts(accountCountFor(count));
+        LinkedItemsRepository repo(&mCollectionManager);
+        SyntheticItemsModel model(DetailsType::Opportunity, &repo);
+        model.setItems(SyntheticData::items(SyntheticData::opportunities(count, accountCountFor(count)), SugarOpportunity::mimeType()));
+        SavedSearchIndex index;
+        index.setModel(&model);
+        const QVector<OpportunityFilterSettings> searches = savedSearches();
+
+        QBENCHMARK {
+            index.setSearches({});
+            index.setSearches(searches);
+        }
+        QVERIFY(index.count(QStringLiteral("Search 4")) > 0);
+    }
+
+    // 1000 opportunities modified (e.g. by a sync), with the 20 result sets to update
+    void updateOpportunities()
+    {
+        const int count = opportunityCount();
+        loadAccounts(accountCountFor(count));
+        LinkedItemsRepository repo(&mCollectionManager);
+        SyntheticItemsModel model(DetailsType::Opportunity, &repo);
+        const Akonadi::Item::List items = SyntheticData::items(SyntheticData::opportunities(count, accountCountFor(count)), SugarOpportunity::mimeType());
+        model.setItems(items);
+        SavedSearchIndex index;
+        index.setModel(&model);
+        index.setSearches(savedSearches());
+
+        const int changes = qMin(1000, count);
+        QBENCHMARK {
+            for (int i = 0; i < changes; ++i) {
+                const int row = (i * 47) % count;
+                Akonadi::Item item = model.item(row);
+                SugarOpportunity opportunity = item.payload<SugarOpportunity>();
+                opportunity.setSalesStage(opportunity.salesStage() == QLatin1String("Closed Won") ? QStringLiteral("Proposal") : QStringLiteral("Closed Won"));
+                item.setPayload(opportunity);
+                model.updateItem(row, item);
+            }
+        }
+    }
+};
+
+QTEST_MAIN(BenchSavedSearches)
+#include "bench_savedsearches.moc"
@@ -0,0 +1,368 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "syntheticdata.h"
+
+#include "serializerpluginsugaraccount.h"
+#include "serializerpluginsugarcampaign.h"
+#include "serializerpluginsugardocument.h"
+#include "serializerpluginsugaremail.h"
+#include "serializerpluginsugarlead.h"
+#include "serializerpluginsugarnote.h"
+#include "serializerpluginsugaropportunity.h"
+
+#include <KContacts/VCardConverter>
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTest>
+
+#include <atomic>
+#include <memory>
+
+// Count heap allocations, including those made by Qt containers (which use malloc directly).
+// Only possible with glibc, elsewhere allocations are reported as -1.
+static std::atomic<qint64> s_allocations{0};
+#if defined(__GLIBC__)
+#define FATCRM_COUNT_ALLOCATIONS 1
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *malloc(size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+void *calloc(size_t count, size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+void *realloc(void *ptr, size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+}
+#else
+#define FATCRM_COUNT_ALLOCATIONS 0
+#endif
+
+/**
+ * One way of turning an item's payload into bytes and back.
+ * To validate a faster or binary format, add a Codec for it in initTestCase():
+ * it is then benchmarked and checked for lossless round-trips on the same corpus.
+ */
+class Codec
+{
+public:
+    virtual ~Codec() = default;
+    virtual QByteArray serialize(const Akonadi::Item &item) = 0;
+    virtual bool deserialize(Akonadi::Item &item, const QByteArray &data) = 0;
+};
+
+// Goes through one of our Akonadi serializer plugins, like the Akonadi client library does
+class PluginCodec : public Codec
+{
+public:
+    explicit PluginCodec(Akonadi::ItemSerializerPlugin *plugin)
+        : mPlugin(plugin)
+    {
+    }
+
+    QByteArray serialize(const Akonadi::Item &item) override
+    {
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        int version = 0;
+        mPlugin->serialize(item, Akonadi::Item::FullPayload, buffer, version);
+        return data;
+    }
+
+    bool deserialize(Akonadi::Item &item, const QByteArray &data) override
+    {
+        QByteArray copy(data);
+        QBuffer buffer(&copy);
+        buffer.open(QIODevice::ReadOnly);
+        return mPlugin->deserialize(item, Akonadi::Item::FullPayload, buffer, 0);
+    }
+
+private:
+    std::unique_ptr<Akonadi::ItemSerializerPlugin> mPlugin;
+};
+
+// What the addressee serializer from akonadi-contacts does for contacts
+class VCardCodec : public Codec
+{
+public:
+    QByteArray serialize(const Akonadi::Item &item) override
+    {
+        return mConverter.createVCard(item.payload<KContacts::Addressee>(), KContacts::VCardConverter::v3_0);
+    }
+
+    bool deserialize(Akonadi::Item &item, const QByteArray &data) override
+    {
+        const KContacts::Addressee addressee = mConverter.parseVCard(data);
+        if (addressee.isEmpty())
+            return false;
+        item.setPayload<KContacts::Addressee>(addressee);
+        return true;
+    }
+
+private:
+    KContacts::VCardConverter mConverter;
+};
+
+struct CorpusEntry
+{
+    QString name;
+    QString mimeType;
+    std::shared_ptr<Codec> codec;
+    Akonadi::Item::List items;
+    QVector<QByteArray> serialized;
+};
+Q_DECLARE_METATYPE(CorpusEntry *)
+
+// Benchmarks the serializer plugins on a corpus of generated items.
+// Set FATCRM_BENCHMARK_CORPUS_DIR to keep the corpus on disk: it is written on the first run
+// and read back on the following runs, so that results stay comparable when the generator changes.
+// Set FATCRM_BENCHMARK_RESULTS to a file name to get a JSON summary (MB/s, items/s, allocations, sizes).
+class BenchSerializers : public QObject
+{
+    Q_OBJECT
+
+private:
+    enum Direction { Serialize, Deserialize };
+
+    template <typename T>
+    void addEntry(const QString &name, Codec *codec, const QVector<T> &objects, const QString &mimeType)
+    {
+        CorpusEntry entry;
+        entry.name = name;
+        entry.mimeType = mimeType;
+        entry.codec.reset(codec);
+        if (!loadCorpus(entry)) {
+            entry.items = SyntheticData::items(objects, mimeType);
+            entry.serialized.reserve(entry.items.count());
+            for (const Akonadi::Item &item : qAsConst(entry.items)) {
+                entry.serialized.append(codec->serialize(item));
+            }
+            saveCorpus(entry);
+        }
+        mCorpus.append(entry);
+    }
+
+    static QString corpusFileName(const CorpusEntry &entry)
+    {
+        const QString dir = qEnvironmentVariable("FATCRM_BENCHMARK_CORPUS_DIR");
+        return dir.isEmpty() ? QString() : dir + QLatin1Char('/') + entry.name + QStringLiteral(".corpus");
+    }
+
+    bool loadCorpus(CorpusEntry &entry)
+    {
+        QFile file(corpusFileName(entry));
+        if (file.fileName().isEmpty() || !file.open(QIODevice::ReadOnly))
+            return false;
+        QDataStream stream(&file);
+        stream >> entry.serialized;
+        Akonadi::Item::Id id = 1;
+        for (const QByteArray &data : qAsConst(entry.serialized)) {
+            Akonadi::Item item(id++);
+            item.setMimeType(entry.mimeType);
+            if (!entry.codec->deserialize(item, data)) {
+                qWarning() << "Cannot read corpus" << file.fileName();
+                entry.items.clear();
+                entry.serialized.clear();
+                return false;
+            }
+            entry.items.append(item);
+        }
+        qDebug() << "Loaded" << entry.items.count() << "items from" << file.fileName();
+        return true;
+    }
+
+    void saveCorpus(const CorpusEntry &entry)
+    {
+        const QString fileName = corpusFileName(entry);
+        if (fileName.isEmpty())
+            return;
+        QDir().mkpath(QFileInfo(fileName).absolutePath());
+        QFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly)) {
+            qWarning() << "Cannot write" << fileName << file.errorString();
+            return;
+        }
+        QDataStream stream(&file);
+        stream << entry.serialized;
+    }
+
+    static qint64 totalSize(const QVector<QByteArray> &data)
+    {
+        qint64 size = 0;
+        for (const QByteArray &ba : data) {
+            size += ba.size();
+        }
+        return size;
+    }
+
+    static void runPass(CorpusEntry &entry, Direction direction)
+    {
+        if (direction == Serialize) {
+            for (const Akonadi::Item &item : qAsConst(entry.items)) {
+                const QByteArray data = entry.codec->serialize(item);
+                Q_UNUSED(data);
+            }
+        } else {
+            for (const QByteArray &data : qAsConst(entry.serialized)) {
+                Akonadi::Item item;
+                item.setMimeType(entry.mimeType);
+                entry.codec->deserialize(item, data);
+            }
+        }
+    }
+
+    void addRows()
+    {
+        QTest::addColumn<CorpusEntry *>("entry");
+        QTest::addColumn<int>("direction");
+        for (CorpusEntry &entry : mCorpus) {
+            QTest::newRow(qPrintable(entry.name + QStringLiteral("-serialize"))) << &entry << int(Serialize);
+            QTest::newRow(qPrintable(entry.name + QStringLiteral("-deserialize"))) << &entry << int(Deserialize);
+        }
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        const int count = qMin(10000, SyntheticData::sizes().first());
+        const int accountCount = qMax(1, count / 4);
+        addEntry(QStringLiteral("account"), new PluginCodec(new Akonadi::SerializerPluginSugarAccount),
+                 SyntheticData::accounts(count), SugarAccount::mimeType());
+        addEntry(QStringLiteral("opportunity"), new PluginCodec(new Akonadi::SerializerPluginSugarOpportunity),
+                 SyntheticData::opportunities(count, accountCount), SugarOpportunity::mimeType());
+        addEntry(QStringLiteral("lead"), new PluginCodec(new Akonadi::SerializerPluginSugarLead),
+                 SyntheticData::leads(count), SugarLead::mimeType());
+        addEntry(QStringLiteral("campaign"), new PluginCodec(new Akonadi::SerializerPluginSugarCampaign),
+                 SyntheticData::campaigns(count), SugarCampaign::mimeType());
+        addEntry(QStringLiteral("note"), new PluginCodec(new Akonadi::SerializerPluginSugarNote),
+                 SyntheticData::notes(count, count), SugarNote::mimeType());
+        addEntry(QStringLiteral("email"), new PluginCodec(new Akonadi::SerializerPluginSugarEmail),
+                 SyntheticData::emails(count, count), SugarEmail::mimeType());
+        addEntry(QStringLiteral("document"), new PluginCodec(new Akonadi::SerializerPluginSugarDocument),
+                 SyntheticData::documents(count, accountCount, count), SugarDocument::mimeType());
+        addEntry(QStringLiteral("contact-vcard"), new VCardCodec,
+                 SyntheticData::contacts(count, accountCount), KContacts::Addressee::mimeType());
+    }
+
+    void cleanupTestCase()
+    {
+        const QString resultsFile = qEnvironmentVariable("FATCRM_BENCHMARK_RESULTS");
+        if (resultsFile.isEmpty())
+            return;
+        QFile file(resultsFile);
+        QVERIFY2(file.open(QIODevice::WriteOnly), qPrintable(file.errorString()));
+        file.write(QJsonDocument(mResults).toJson());
+    }
+
+    void roundTrip_data()
+    {
+        QTest::addColumn<CorpusEntry *>("entry");
+        for (CorpusEntry &entry : mCorpus) {
+            QTest::newRow(qPrintable(entry.name)) << &entry;
+        }
+    }
+
+    // Format-independent check that nothing is lost: deserialize, serialize, deserialize again
+    // and the second serialization gives the same bytes as the first one.
+    // (Not compared with the corpus itself, which could come from a run with a different QHash seed.)
+    void roundTrip()
+    {
+        QFETCH(CorpusEntry *, entry);
+        for (const QByteArray &data : qAsConst(entry->serialized)) {
+            Akonadi::Item item;
+            item.setMimeType(entry->mimeType);
+            QVERIFY(entry->codec->deserialize(item, data));
+            const QByteArray first = entry->codec->serialize(item);
+            Akonadi::Item copy;
+            copy.setMimeType(entry->mimeType);
+            QVERIFY(entry->codec->deserialize(copy, first));
+            QCOMPARE(entry->codec->serialize(copy), first);
+        }
+    }
+
+    void benchmark_data()
+    {
+        addRows();
+    }
+
+    void benchmark()
+    {
+        QFETCH(CorpusEntry *, entry);
+        QFETCH(int, direction);
+
+        // Our own measurements, for the throughput and allocation figures
+        const qint64 allocationsBefore = s_allocations.load();
+        runPass(*entry, Direction(direction));
+        const qint64 allocations = s_allocations.load() - allocationsBefore;
+
+        QElapsedTimer timer;
+        timer.start();
+        int passes = 0;
+        do {
+            runPass(*entry, Direction(direction));
+            ++passes;
+        } while (timer.elapsed() < 500);
+        const double seconds = timer.nsecsElapsed() / 1e9 / passes;
+
+        const int items = entry->items.count();
+        const qint64 bytes = totalSize(entry->serialized);
+        QJsonObject result;
+        result.insert(QStringLiteral("name"), QString::fromLatin1(QTest::currentDataTag()));
+        result.insert(QStringLiteral("items"), items);
+        result.insert(QStringLiteral("bytes"), double(bytes));
+        result.insert(QStringLiteral("bytesPerItem"), double(bytes) / items);
+        result.insert(QStringLiteral("MBPerSecond"), bytes / seconds / (1024 * 1024));
+        result.insert(QStringLiteral("itemsPerSecond"), items / seconds);
+        result.insert(QStringLiteral("allocationsPerItem"), FATCRM_COUNT_ALLOCATIONS ? double(allocations) / items : -1.0);
+        mResults.append(result);
+        qDebug().noquote() << QString::fromUtf8(QJsonDocument(result).toJson(QJsonDocument::Compact));
+
+        // And the standard QtTest measurement, for the usual -xml/-csv outputs
+        QBENCHMARK {
+            runPass(*entry, Direction(direction));
+        }
+    }
+
+private:
+    QVector<CorpusEntry> mCorpus;
+    QJsonArray mResults;
+};
+
+QTEST_MAIN(BenchSerializers)
+
+#include "bench_serializers.moc"
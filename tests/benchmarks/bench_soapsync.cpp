@@ -0,0 +1,199 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "syntheticdata.h"
+
+#include "accountshandler.h"
+#include "listentriesjob.h"
+#include "loginjob.h"
+#include "sugarreststandinserver.h"
+#include "sugarrestprotocol.h"
+#include "sugarsession.h"
+#include "sugarsoapprotocol.h"
+#include "sugarstandinserver.h"
+
+#include <QDebug>
+#include <QTest>
+
+// Benchmarks syncing accounts from SugarStandInServer, with the resource's real code:
+// SugarSoapProtocol or SugarRestProtocol (through SugarRestStandInServer, on the same dataset),
+// SugarSession, ListEntriesJob and AccountsHandler, over HTTP on localhost.
+class BenchSoapSync : public QObject
+{
+    Q_OBJECT
+
+public:
+    BenchSoapSync()
+        : mRestServer(&mServer),
+          mSoapSession(nullptr),
+          mRestSession(nullptr)
+    {
+    }
+
+private:
+    enum Protocol { Soap, Rest };
+
+    SugarStandInServer mServer;
+    SugarRestStandInServer mRestServer;
+    SugarSession mSoapSession;
+    SugarSession mRestSession;
+    QScopedPointer<AccountsHandler> mSoapAccountsHandler;
+    QScopedPointer<AccountsHandler> mRestAccountsHandler;
+    int mPopulatedCount = 0;
+
+    static void addSizeRows(bool withDelay)
+    {
+        QTest::addColumn<int>("protocol");
+        QTest::addColumn<int>("count");
+        QTest::addColumn<int>("delay");
+        const int maxItems = qEnvironmentVariableIsSet("FATCRM_BENCHMARK_MAX_ITEMS")
+                ? qEnvironmentVariableIntValue("FATCRM_BENCHMARK_MAX_ITEMS") : 100000;
+        for (int protocol : {Soap, Rest}) {
+            const QString prefix = protocol == Soap ? QStringLiteral("soap-") : QStringLiteral("rest-");
+            for (int count : {10000, 100000}) {
+                if (count <= maxItems) {
+                    QTest::newRow(qPrintable(prefix + SyntheticData::sizeName(count))) << protocol << count << 0;
+                }
+            }
+            if (withDelay) {
+                // As if the server was a few milliseconds away
+                QTest::newRow(qPrintable(prefix + QLatin1String("10k-5ms"))) << protocol << 10000 << 5;
+            }
+        }
+    }
+
+    static void setUpSession(SugarSession &session, const QString &host, SugarProtocolBase *protocol)
+    {
+        session.setSessionParameters(QStringLiteral("user"), QStringLiteral("password"), host);
+        session.createSoapInterface();
+        session.setProtocol(protocol);
+        protocol->setSession(&session);
+    }
+
+    void populate(int count)
+    {
+        if (mPopulatedCount == count) {
+            return;
+        }
+        mServer.clear();
+        const QVector<SugarAccount> accounts = SyntheticData::accounts(count);
+        for (const SugarAccount &account : accounts) {
+            mServer.addEntry(moduleToName(Accounts), AccountsHandler::sugarAccountToNameValueList(account));
+        }
+        mPopulatedCount = count;
+    }
+
+    // Returns the number of items received
+    int sync(int protocol, const QString &timestamp, QString *newTimestamp = nullptr)
+    {
+        Akonadi::Collection collection;
+        collection.setId(1);
+        auto *job = new ListEntriesJob(collection, protocol == Soap ? &mSoapSession : &mRestSession);
+        job->setModule(protocol == Soap ? mSoapAccountsHandler.data() : mRestAccountsHandler.data());
+        job->setLatestTimestamp(timestamp);
+        int received = 0;
+        connect(job, &ListEntriesJob::itemsReceived, this, [&received](const Akonadi::Item::List &items) {
+            received += items.count();
+        });
+        if (!job->exec()) {
+            qWarning() << job->errorString();
+            return -1;
+        }
+        if (newTimestamp) {
+            *newTimestamp = job->newTimestamp();
+        }
+        return received;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        qRegisterMetaType<Akonadi::Item::List>("Akonadi::Item::List");
+        QVERIFY(mServer.start());
+        QVERIFY(mRestServer.start());
+        setUpSession(mSoapSession, mServer.hostUrl(), new SugarSoapProtocol);
+        setUpSession(mRestSession, mRestServer.hostUrl(), new SugarRestProtocol);
+        mSoapAccountsHandler.reset(new AccountsHandler(&mSoapSession));
+        mRestAccountsHandler.reset(new AccountsHandler(&mRestSession));
+
+        LoginJob soapJob(&mSoapSession);
+        QVERIFY2(soapJob.exec(), qPrintable(soapJob.errorString()));
+        LoginJob restJob(&mRestSession);
+        QVERIFY2(restJob.exec(), qPrintable(restJob.errorString()));
+    }
+
+    void fullSync_data()
+    {
+        addSizeRows(true);
+    }
+
+    // What the resource does for the first sync of a folder
+    void fullSync()
+    {
+        QFETCH(int, protocol);
+        QFETCH(int, count);
+        QFETCH(int, delay);
+        populate(count);
+        mServer.setResponseDelay(delay);
+        mServer.resetRequestCounts();
+        mRestServer.resetRequestCounts();
+        int received = 0;
+        QBENCHMARK {
+            received = sync(protocol, QString());
+        }
+        mServer.setResponseDelay(0);
+        QCOMPARE(received, count);
+        if (protocol == Soap) {
+            qDebug() << "get_entry_list calls:" << mServer.requestCount(QStringLiteral("get_entry_list"));
+        } else {
+            qDebug() << "filter calls:" << mRestServer.requestCount(QStringLiteral("filter"));
+        }
+    }
+
+    void incrementalSync_data()
+    {
+        addSizeRows(false);
+    }
+
+    // What the resource does on every later sync: 100 accounts were changed since the last one
+    void incrementalSync()
+    {
+        QFETCH(int, protocol);
+        QFETCH(int, count);
+        populate(count);
+        QString timestamp;
+        QCOMPARE(sync(protocol, QString(), &timestamp), count);
+        const int step = count / 100;
+        for (int i = 0; i < 100; ++i) {
+            QMap<QString, QString> fields;
+            fields.insert(QStringLiteral("name"), QStringLiteral("Renamed %1").arg(i));
+            QVERIFY(mServer.updateEntry(moduleToName(Accounts), QStringLiteral("acc-%1").arg(i * step), fields));
+        }
+        int received = 0;
+        QBENCHMARK {
+            received = sync(protocol, timestamp);
+        }
+        // Plus the last account of the previous sync, which ListEntriesJob always gets again
+        QVERIFY2(received >= 100 && received <= 101, qPrintable(QString::number(received)));
+    }
+};
+
+QTEST_MAIN(BenchSoapSync)
+#include "bench_soapsync.moc"
@@ -0,0 +1,303 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SYNTHETICDATA_H
+#define SYNTHETICDATA_H
+
+#include "sugaraccount.h"
+#include "sugarcampaign.h"
+#include "sugarcontactwrapper.h"
+#include "sugardocument.h"
+#include "sugaremail.h"
+#include "sugarlead.h"
+#include "sugarnote.h"
+#include "sugaropportunity.h"
+#include "kdcrmfields.h"
+#include "kdcrmutils.h"
+
+#include <AkonadiCore/Item>
+
+#include <KContacts/Addressee>
+
+#include <QDateTime>
+#include <QStringList>
+#include <QVector>
+#include <QTest>
+
+/**
+ * Deterministic generation of CRM objects for the benchmarks:
+ * the same count always produces the same data, so results can be compared across commits.
+ */
+namespace SyntheticData
+{
+
+// Numbers of items for the data-driven benchmarks, capped by $FATCRM_BENCHMARK_MAX_ITEMS
+inline QVector<int> sizes()
+{
+    const int maxItems = qEnvironmentVariableIsSet("FATCRM_BENCHMARK_MAX_ITEMS")
+            ? qEnvironmentVariableIntValue("FATCRM_BENCHMARK_MAX_ITEMS") : 200000;
+    QVector<int> result;
+    for (int count : {10000, 50000, 200000}) {
+        if (count <= maxItems)
+            result.append(count);
+    }
+    if (result.isEmpty())
+        result.append(maxItems);
+    return result;
+}
+
+inline QString sizeName(int count)
+{
+    return count % 1000 == 0 ? QStringLiteral("%1k").arg(count / 1000) : QString::number(count);
+}
+
+inline void addSizeRows()
+{
+    QTest::addColumn<int>("count");
+    for (int count : sizes()) {
+        QTest::newRow(qPrintable(sizeName(count))) << count;
+    }
+}
+
+inline QString pick(const QStringList &values, int index)
+{
+    return values.at(index % values.count());
+}
+
+inline QVector<SugarAccount> accounts(int count)
+{
+    static const QStringList companies = { "Acme", "Globex", "Initech", "Umbrella", "Hooli", "Stark", "Wayne", "Tyrell", "Cyberdyne", "Soylent" };
+    static const QStringList suffixes = { "GmbH", "AB", "Inc.", "Ltd", "SARL", "AS" };
+    static const QStringList cities = { "Berlin", "Stockholm", "Paris", "London", "Oslo", "Hagfors", "Lyon", "New York" };
+    static const QStringList countries = { "Germany", "Sweden", "France", "United Kingdom", "Norway", "United States" };
+    QVector<SugarAccount> result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        SugarAccount account;
+        account.setId(QStringLiteral("acc-%1").arg(i));
+        account.setName(QStringLiteral("%1 %2 %3").arg(pick(companies, i), QString::number(i), pick(suffixes, i / 7)));
+        account.setBillingAddressCity(pick(cities, i / 3));
+        account.setBillingAddressCountry(pick(countries, i / 5));
+        account.setBillingAddressPostalcode(QString::number(10000 + (i * 37) % 89999));
+        account.setBillingAddressStreet(QStringLiteral("%1 Main Street").arg(i % 500));
+        account.setPhoneOffice(QStringLiteral("+46 555 %1").arg(i, 6, 10, QLatin1Char('0')));
+        account.setEmail1(QStringLiteral("info@account%1.example.com").arg(i));
+        account.setAssignedUserName(QStringLiteral("user%1").arg(i % 25));
+        account.setDescription(QStringLiteral("Account number %1.\nSecond paragraph of the description.").arg(i));
+        result.append(account);
+    }
+    return result;
+}
+
+inline QVector<SugarOpportunity> opportunities(int count, int accountCount)
+{
+    static const QStringList stages = { "Prospecting", "Qualification", "Needs Analysis", "Proposal", "Negotiation", "Closed Won", "Closed Lost" };
+    static const QStringList sizes = { "S", "M", "L", "XL" };
+    static const QStringList priorities = { "A", "B", "C", "" };
+    static const QStringList nextSteps = { "Call back", "Send offer", "Meeting", "Wait for PO", "" };
+    const QDate baseDate(2020, 1, 1);
+    const QDateTime baseDateTime(baseDate, QTime(12, 0));
+    QVector<SugarOpportunity> result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        SugarOpportunity opp;
+        opp.setId(QStringLiteral("opp-%1").arg(i));
+        opp.setName(QStringLiteral("Opportunity %1 %2").arg(i).arg(pick(nextSteps, i / 11)));
+        opp.setAccountId(QStringLiteral("acc-%1").arg((i * 7) % accountCount));
+        opp.setSalesStage(pick(stages, i));
+        opp.setProbability(QString::number((i * 10) % 100));
+        opp.setAmount(QString::number(1000 + (i * 131) % 100000));
+        opp.setCustomField(KDCRMFields::opportunitySize(), pick(sizes, i / 2));
+        opp.setCustomField(KDCRMFields::opportunityPriority(), pick(priorities, i / 3));
+        opp.setDateClosed(KDCRMUtils::dateToString(baseDate.addDays(i % 700)));
+        opp.setDateEntered(KDCRMUtils::dateTimeToString(baseDateTime.addDays(-(i % 900))));
+        opp.setDateModified(baseDateTime.addSecs(-(i * 97) % (3600 * 24 * 365)));
+        if (i % 4 != 0)
+            opp.setNextCallDate(baseDate.addDays((i * 13) % 400));
+        opp.setNextStep(pick(nextSteps, i));
+        opp.setAssignedUserName(QStringLiteral("user%1").arg(i % 25));
+        opp.setDescription(QStringLiteral("Opportunity number %1.\nSecond paragraph of the description.").arg(i));
+        result.append(opp);
+    }
+    return result;
+}
+
+inline QVector<SugarLead> leads(int count)
+{
+    static const QStringList statuses = { "New", "Assigned", "In Process", "Converted", "Dead" };
+    QVector<SugarLead> result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        SugarLead lead;
+        lead.setId(QStringLiteral("lead-%1").arg(i));
+        lead.setFirstName(QStringLiteral("First%1").arg(i));
+        lead.setLastName(QStringLiteral("Last%1").arg(i % 977));
+        lead.setTitle(QStringLiteral("Manager"));
+        lead.setEmail1(QStringLiteral("lead%1@example.com").arg(i));
+        lead.setPhoneWork(QStringLiteral("+33 1 %1").arg(i, 8, 10, QLatin1Char('0')));
+        lead.setPrimaryAddressCity(QStringLiteral("Paris"));
+        lead.setPrimaryAddressCountry(QStringLiteral("France"));
+        lead.setStatus(pick(statuses, i));
+        lead.setAccountName(QStringLiteral("Lead company %1").arg(i / 3));
+        lead.setAssignedUserName(QStringLiteral("user%1").arg(i % 25));
+        lead.setDescription(QStringLiteral("Met at trade fair %1").arg(2015 + i % 6));
+        result.append(lead);
+    }
+    return result;
+}
+
+inline QVector<SugarCampaign> campaigns(int count)
+{
+    QVector<SugarCampaign> result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        SugarCampaign campaign;
+        campaign.setId(QStringLiteral("campaign-%1").arg(i));
+        campaign.setName(QStringLiteral("Campaign %1").arg(i));
+        campaign.setStatus(i % 2 ? QStringLiteral("Active") : QStringLiteral("Inactive"));
+        campaign.setCampaignType(QStringLiteral("Email"));
+        campaign.setStartDate(KDCRMUtils::dateToString(QDate(2020, 1, 1).addDays(i % 365)));
+        campaign.setEndDate(KDCRMUtils::dateToString(QDate(2020, 3, 1).addDays(i % 365)));
+        campaign.setBudget(QString::number(1000 * (i % 50)));
+        campaign.setObjective(QStringLiteral("Generate leads for product line %1").arg(i % 7));
+        campaign.setAssignedUserName(QStringLiteral("user%1").arg(i % 25));
+        result.append(campaign);
+    }
+    return result;
+}
+
+// Notes, emails and documents are linked to the opportunities/accounts generated above
+inline QVector<SugarNote> notes(int count, int opportunityCount)
+{
+    QVector<SugarNote> result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        SugarNote note;
+        note.setId(QStringLiteral("note-%1").arg(i));
+        note.setName(QStringLiteral("Phone call %1").arg(i));
+        note.setDateEntered(KDCRMUtils::dateTimeToString(QDateTime(QDate(2020, 1, 1), QTime(9, 0)).addSecs(i * 60)));
+        note.setParentType(QStringLiteral("Opportunities"));
+        note.setParentId(QStringLiteral("opp-%1").arg(i % qMax(1, opportunityCount)));
+        note.setDescription(QStringLiteral("Discussed the offer, customer wants a discount of %1%.\n"
+                                           "Follow up next week. Reference %2.").arg(i % 30).arg(i));
+        result.append(note);
+    }
+    return result;
+}
+
+inline QVector<SugarEmail> emails(int count, int opportunityCount)
+{
+    QVector<SugarEmail> result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        SugarEmail email;
+        email.setId(QStringLiteral("email-%1").arg(i));
+        email.setName(QStringLiteral("Re: offer %1").arg(i));
+        email.setDateSent(KDCRMUtils::dateTimeToString(QDateTime(QDate(2020, 1, 1), QTime(9, 0)).addSecs(i * 90)));
+        email.setMessageId(QStringLiteral("<%1@mail.example.com>").arg(i));
+        email.setParentType(QStringLiteral("Opportunities"));
+        email.setParentId(QStringLiteral("opp-%1").arg(i % qMax(1, opportunityCount)));
+        email.setFromAddrName(QStringLiteral("sales%1@example.com").arg(i % 25));
+        email.setToAddrNames(QStringLiteral("customer%1@example.org").arg(i));
+        email.setDescription(QStringLiteral("Dear customer,\n\nplease find attached our offer number %1.\n\n"
+                                            "Best regards,\nThe sales team").arg(i).repeated(1 + i % 4));
+        result.append(email);
+    }
+    return result;
+}
+
+inline QVector<SugarDocument> documents(int count, int accountCount, int opportunityCount)
+{
+    QVector<SugarDocument> result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        SugarDocument document;
+        document.setId(QStringLiteral("doc-%1").arg(i));
+        document.setDocumentName(QStringLiteral("Offer %1.pdf").arg(i));
+        document.setDocumentRevisionId(QStringLiteral("rev-%1").arg(i));
+        document.setActiveDate(KDCRMUtils::dateToString(QDate(2020, 1, 1).addDays(i % 365)));
+        document.setStatusId(QStringLiteral("Active"));
+        document.setDescription(QStringLiteral("Signed offer"));
+        document.setLinkedAccountIds({ QStringLiteral("acc-%1").arg(i % qMax(1, accountCount)) });
+        document.setLinkedOpportunityIds({ QStringLiteral("opp-%1").arg(i % qMax(1, opportunityCount)) });
+        result.append(document);
+    }
+    return result;
+}
+
+inline QVector<KContacts::Addressee> contacts(int count, int accountCount)
+{
+    static const QStringList givenNames = { "Anna", "Bertil", "Claire", "David", "Eva", "Frank", "Greta", "Hans" };
+    QVector<KContacts::Addressee> result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        KContacts::Addressee addressee;
+        addressee.setGivenName(pick(givenNames, i));
+        addressee.setFamilyName(QStringLiteral("Family%1").arg(i % 1013));
+        addressee.setTitle(QStringLiteral("Engineer"));
+        addressee.setOrganization(QStringLiteral("Company %1").arg(i % qMax(1, accountCount)));
+        addressee.insertEmail(QStringLiteral("contact%1@example.com").arg(i), true);
+        addressee.insertPhoneNumber(KContacts::PhoneNumber(QStringLiteral("+49 30 %1").arg(i, 7, 10, QLatin1Char('0')), KContacts::PhoneNumber::Work));
+        KContacts::Address address(KContacts::Address::Work | KContacts::Address::Pref);
+        address.setStreet(QStringLiteral("%1 Hauptstrasse").arg(i % 200));
+        address.setLocality(QStringLiteral("Berlin"));
+        address.setCountry(QStringLiteral("Germany"));
+        addressee.insertAddress(address);
+        addressee.setNote(QStringLiteral("Met in %1").arg(2015 + i % 6));
+        SugarContactWrapper wrapper(addressee);
+        wrapper.setId(QStringLiteral("contact-%1").arg(i));
+        wrapper.setAccountId(QStringLiteral("acc-%1").arg(i % qMax(1, accountCount)));
+        wrapper.setAssignedUserName(QStringLiteral("user%1").arg(i % 25));
+        wrapper.setDateCreated(KDCRMUtils::dateTimeToString(QDateTime(QDate(2019, 1, 1), QTime(9, 0)).addDays(i % 700)));
+        result.append(addressee);
+    }
+    return result;
+}
+
+template <typename T>
+QString idOf(const T &object)
+{
+    return object.id();
+}
+
+template <>
+inline QString idOf<KContacts::Addressee>(const KContacts::Addressee &addressee)
+{
+    return SugarContactWrapper(addressee).id();
+}
+
+template <typename T>
+Akonadi::Item::List items(const QVector<T> &objects, const QString &mimeType)
+{
+    Akonadi::Item::List result;
+    result.reserve(objects.count());
+    Akonadi::Item::Id id = 1;
+    for (const T &object : objects) {
+        Akonadi::Item item(id++);
+        item.setMimeType(mimeType);
+        item.setRemoteId(idOf(object));
+        item.setPayload<T>(object);
+        result.append(item);
+    }
+    return result;
+}
+
+}
+
+#endif // SYNTHETICDATA_H
@@ -0,0 +1,214 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2021 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SYNTHETICITEMSMODEL_H
+#define SYNTHETICITEMSMODEL_H
+
+#include "accountrepository.h"
+#include "itemstreemodel.h"
+#include "linkeditemsrepository.h"
+#include "referenceddata.h"
+
+#include "kdcrmutils.h"
+#include "sugaraccount.h"
+#include "sugaropportunity.h"
+
+#include <AkonadiCore/EntityTreeModel>
+
+#include <QAbstractTableModel>
+#include <QLocale>
+
+/**
+ * A flat model standing in for ItemsTreeModel, without needing an Akonadi server.
+ *
+ * It has the same columns as ItemsTreeModel::columnTypes(type), provides the items
+ * through EntityTreeModel::ItemRole (which is what the filter proxies use), and
+ * computes the display and sort data for accounts and opportunities the way
+ * ItemsTreeModel does.
+ */
+class SyntheticItemsModel : public QAbstractTableModel
+{
+public:
+    SyntheticItemsModel(DetailsType type, LinkedItemsRepository *repo, QObject *parent = nullptr)
+        : QAbstractTableModel(parent),
+          mType(type),
+          mColumns(ItemsTreeModel::columnTypes(type)),
+          mLinkedItemsRepository(repo)
+    {
+    }
+
+    void setItems(const Akonadi::Item::List &items)
+    {
+        beginResetModel();
+        mItems = items;
+        endResetModel();
+    }
+
+    void appendItems(const Akonadi::Item::List &items)
+    {
+        if (items.isEmpty())
+            return;
+        beginInsertRows(QModelIndex(), mItems.count(), mItems.count() + items.count() - 1);
+        mItems += items;
+        endInsertRows();
+    }
+
+    void updateItem(int row, const Akonadi::Item &item)
+    {
+        mItems[row] = item;
+        emit dataChanged(index(row, 0), index(row, mColumns.count() - 1));
+    }
+
+    Akonadi::Item item(int row) const { return mItems.at(row); }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override
+    {
+        return parent.isValid() ? 0 : mItems.count();
+    }
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override
+    {
+        return parent.isValid() ? 0 : mColumns.count();
+    }
+
+    QVariant data(const QModelIndex &index, int role) const override
+    {
+        const Akonadi::Item &item = mItems.at(index.row());
+        if (role == Akonadi::EntityTreeModel::ItemRole)
+            return QVariant::fromValue(item);
+        if (role == Akonadi::EntityTreeModel::ItemIdRole)
+            return item.id();
+        if (role != Qt::DisplayRole && role != Qt::EditRole)
+            return QVariant();
+        const ItemsTreeModel::ColumnType column = mColumns.at(index.column());
+        if (mType == DetailsType::Opportunity)
+            return opportunityData(item.payload<SugarOpportunity>(), column, role);
+        if (mType == DetailsType::Account)
+            return accountData(item.payload<SugarAccount>(), column);
+        return QVariant();
+    }
+
+private:
+    QVariant accountData(const SugarAccount &account, ItemsTreeModel::ColumnType column) const
+    {
+        switch (column) {
+        case ItemsTreeModel::Name:
+            return account.name();
+        case ItemsTreeModel::City:
+            return account.shippingAddressCity().isEmpty() ? account.billingAddressCity() : account.shippingAddressCity();
+        case ItemsTreeModel::Country:
+            return account.shippingAddressCountry().isEmpty() ? account.billingAddressCountry() : account.shippingAddressCountry();
+        case ItemsTreeModel::Street:
+            return account.shippingAddressStreet().isEmpty() ? account.billingAddressStreet() : account.shippingAddressStreet();
+        case ItemsTreeModel::Phone:
+            return account.phoneOffice();
+        case ItemsTreeModel::Email:
+            return account.email1();
+        case ItemsTreeModel::CreatedBy:
+            return account.createdByName();
+        case ItemsTreeModel::PostalCode:
+            return account.postalCodeForGui();
+        case ItemsTreeModel::NumberOfOpportunities:
+            return mLinkedItemsRepository->opportunitiesForAccount(account.id()).count();
+        case ItemsTreeModel::NumberOfContacts:
+            return mLinkedItemsRepository->contactsForAccount(account.id()).count();
+        case ItemsTreeModel::NumberOfDocumentsNotesEmails:
+            return mLinkedItemsRepository->documentsForAccount(account.id()).count() +
+                    mLinkedItemsRepository->notesForAccount(account.id()).count() +
+                    mLinkedItemsRepository->emailsForAccount(account.id()).count();
+        default:
+            return QVariant();
+        }
+    }
+
+    QVariant opportunityData(const SugarOpportunity &opportunity, ItemsTreeModel::ColumnType column, int role) const
+    {
+        switch (column) {
+        case ItemsTreeModel::OpportunityName:
+            return opportunity.name();
+        case ItemsTreeModel::OpportunityAccountName:
+            return ReferencedData::instance(AccountRef)->referencedData(opportunity.accountId());
+        case ItemsTreeModel::SalesStage:
+            return opportunity.salesStage();
+        case ItemsTreeModel::Probability: {
+            const int probability = opportunity.probability().toInt();
+            if (role == Qt::DisplayRole)
+                return QStringLiteral("%1 %").arg(probability);
+            return probability;
+        }
+        case ItemsTreeModel::Amount: {
+            const double amount = QLocale::c().toDouble(opportunity.amount());
+            if (role == Qt::DisplayRole)
+                return QLocale().toCurrencyString(amount, QStringLiteral("€"));
+            return amount;
+        }
+        case ItemsTreeModel::OpportunitySize:
+            return opportunity.opportunitySize();
+        case ItemsTreeModel::OpportunityPriority: {
+            const QString priority = opportunity.opportunityPriority().toUpper();
+            if (role == Qt::DisplayRole)
+                return priority;
+            return priority.isEmpty() ? QString::fromLatin1("Z") : priority;
+        }
+        case ItemsTreeModel::Description:
+            return opportunity.limitedDescription(1);
+        case ItemsTreeModel::CloseDate: {
+            const QDate date = KDCRMUtils::dateFromString(opportunity.dateClosed());
+            if (role == Qt::DisplayRole)
+                return KDCRMUtils::formatDate(date);
+            return date;
+        }
+        case ItemsTreeModel::CreationDate: {
+            const QDateTime dt = KDCRMUtils::dateTimeFromString(opportunity.dateEntered());
+            if (role == Qt::DisplayRole)
+                return KDCRMUtils::formatDate(dt.date());
+            return dt;
+        }
+        case ItemsTreeModel::NextStepDate:
+            if (role == Qt::DisplayRole)
+                return KDCRMUtils::formatDate(opportunity.nextCallDate());
+            return opportunity.nextCallDate();
+        case ItemsTreeModel::NextStep:
+            return opportunity.nextStep();
+        case ItemsTreeModel::LastModifiedDate: {
+            const QDateTime dt = opportunity.dateModified();
+            if (role == Qt::DisplayRole)
+                return KDCRMUtils::formatDate(dt.date());
+            return dt;
+        }
+        case ItemsTreeModel::AssignedTo:
+            return opportunity.assignedUserName();
+        case ItemsTreeModel::PostalCode:
+            return AccountRepository::instance()->accountById(opportunity.accountId()).postalCodeForGui();
+        case ItemsTreeModel::City:
+            return AccountRepository::instance()->accountById(opportunity.accountId()).cityForGui();
+        case ItemsTreeModel::Country:
+            return AccountRepository::instance()->accountById(opportunity.accountId()).countryForGui();
+        default:
+            return QVariant();
+        }
+    }
+
+    DetailsType mType;
+    ItemsTreeModel::ColumnTypes mColumns;
+    LinkedItemsRepository *mLinkedItemsRepository;
+    Akonadi::Item::List mItems;
+};
+
+#endif // SYNTHETICITEMSMODEL_H